@@ -3,26 +3,156 @@
 #include "Application.hpp"
 
 #include "Core/Logging.hpp"
+#include "Core/StartupTrace.hpp"
+
+#include "Backend/CommandCapture.hpp"
+
+#include <SDL3/SDL_stdinc.h>
 
 #include <optick.h>
 
+namespace /* anonymous */
+{
+	// The time we have from the process start till the first frame is done.
+	constexpr auto g_StartupBudget = std::chrono::milliseconds(1000);
+
+	// How often the frame statistics are written to the statistics file.
+	constexpr auto g_StatisticsDumpInterval = std::chrono::milliseconds(1000);
+
+	/**
+	 * Create the logger which writes the binary trace.
+	 * This is only done when the GRAPHITE_BINARY_TRACE build flag is set.
+	 *
+	 * @return The logger. nullptr if the trace is disabled.
+	 */
+	[[nodiscard]] std::unique_ptr<BinaryLogger> CreateTraceLogger()
+	{
+#ifdef GRAPHITE_BINARY_TRACE
+		return std::make_unique<BinaryLogger>("GraphiteTrace.glog");
+
+#else
+		return nullptr;
+
+#endif
+	}
+
+	// The initial size of the frame arena. It grows on it's own if a frame needs more.
+	constexpr size_t g_FrameArenaCapacity = 1024 * 1024;
+
+	/**
+	 * Get the file to capture the submitted work to.
+	 * This is set using the GRAPHITE_CAPTURE environment variable.
+	 *
+	 * @return The capture file path. Empty if the work should not be captured.
+	 */
+	[[nodiscard]] std::filesystem::path GetCapturePath()
+	{
+		const auto pPath = SDL_getenv("GRAPHITE_CAPTURE");
+		return pPath ? std::filesystem::path(pPath) : std::filesystem::path();
+	}
+}
+
 Application::Application()
-	: m_Window(m_Instance, "Graphite Engine")
+	: m_pBinaryLogger(CreateTraceLogger())
+	, m_Instance(QueueSharingPolicy::PreferSeparateQueues, "PipelineCache.bin", GetCapturePath())
+	, m_Window(m_Instance, "Graphite Engine")
+	, m_FramePacer(m_Window)
+	, m_SubmissionQueue(m_Instance)
+	, m_SwapchainPresenter(m_Instance, m_Window, m_SubmissionQueue)
+	, m_TextureStreamer(m_Instance, m_SubmissionQueue)
+	, m_PipelineManager(m_Instance)
+	, m_GPUFrameTimer(m_Instance, m_SubmissionQueue)
+	, m_FrameArena(g_FrameArenaCapacity)
+	, m_AllocationReporter(m_FrameStatistics, "AllocationReport.json", g_StatisticsDumpInterval)
 {
+	m_EventDispatcher.subscribe<&Application::onQuit>(EventType::Quit, this);
+	m_Window.addEventQueue(&m_EventQueue);
+	m_Window.addEventQueue(&m_Simulation.getEventQueue());
+
+#ifdef GRAPHITE_FRAME_STATISTICS_DUMP
+	m_FrameStatistics.startDumping("FrameStatistics.json", g_StatisticsDumpInterval);
+
+#endif
 }
 
 Application::~Application()
 {
+	m_Window.removeEventQueue(&m_Simulation.getEventQueue());
+	m_Window.removeEventQueue(&m_EventQueue);
 }
 
 int Application::execute()
 {
-	// Main iteration loop.
+	// Main iteration loop. The simulation runs on it's own thread, so this only samples the input and renders.
 	while (m_bShoudRun)
 	{
 		OPTICK_FRAME("Main loop");
-		m_Window.update();
+
+		// Everything the previous frame allocated from the frame arena is freed here.
+		m_FrameStatistics.recordArenaSize(m_FrameArena.getUsedSize());
+		m_FrameArena.reset();
+
+		const auto frameIndex = m_FrameStatistics.beginFrame();
+		m_GPUFrameTimer.collect(m_FrameStatistics);
+
+		// Wait till it's time to sample the input so the CPU does not run ahead of the display.
+		{
+			const auto phase = FrameStatistics::Phase(m_FrameStatistics, FramePhase::Pacing);
+			m_FramePacer.waitForInputSampling();
+		}
+
+		{
+			const auto phase = FrameStatistics::Phase(m_FrameStatistics, FramePhase::Input);
+			const auto tag = AllocationTracker::Scope(AllocationTag::Input);
+			m_Window.update();
+			m_EventDispatcher.dispatch(m_EventQueue);
+		}
+
+		m_GPUFrameTimer.beginFrame(frameIndex);
+
+		// Get the state to render, interpolated between the last two simulation steps.
+		{
+			const auto phase = FrameStatistics::Phase(m_FrameStatistics, FramePhase::Simulation);
+			const auto tag = AllocationTracker::Scope(AllocationTag::Simulation);
+			m_RenderState = m_Simulation.getInterpolatedState(std::chrono::steady_clock::now());
+		}
+
+		// Stream the textures the frame needs.
+		{
+			const auto phase = FrameStatistics::Phase(m_FrameStatistics, FramePhase::Streaming);
+			const auto tag = AllocationTracker::Scope(AllocationTag::Streaming);
+			m_TextureStreamer.update(m_FrameArena);
+		}
+
+		// Submit everything the systems enqueued this frame, along with the work which prepares the swapchain image.
+		uint32_t imageIndex = 0;
+		bool bShouldPresent = false;
+		{
+			const auto phase = FrameStatistics::Phase(m_FrameStatistics, FramePhase::Submission);
+			const auto tag = AllocationTracker::Scope(AllocationTag::Submission);
+			bShouldPresent = m_SwapchainPresenter.enqueueFrame(imageIndex);
+			m_GPUFrameTimer.endFrame();
+			m_SubmissionQueue.flush();
+			m_FramePacer.markSubmitted();
+		}
+
+		// Present the frame. The present waits on the submitted work, so it can only be done after the flush.
+		if (bShouldPresent)
+		{
+			m_Window.present(m_SwapchainPresenter.getPresentSemaphore(imageIndex), imageIndex);
+			m_FramePacer.markPresented();
+		}
+
+		if (const auto pCapture = m_Instance.getCapture())
+			pCapture->markFrame();
+
+		StartupTrace::MarkFirstFrame(g_StartupBudget);
 	}
 
 	return m_ExitCode;
 }
+
+void Application::onQuit([[maybe_unused]] const Event& event)
+{
+	m_bShoudRun = false;
+}
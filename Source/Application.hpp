@@ -2,8 +2,23 @@
 
 #pragma once
 
+#include "Core/BinaryLogging.hpp"
+#include "Core/EventDispatcher.hpp"
+#include "Core/AllocationTracker.hpp"
+#include "Core/FrameStatistics.hpp"
+#include "Core/MemoryArena.hpp"
+
+#include "Simulation.hpp"
+
+#include "Backend/Platform.hpp"
 #include "Backend/Instance.hpp"
 #include "Backend/Window.hpp"
+#include "Backend/FramePacer.hpp"
+#include "Backend/CommandSubmissionQueue.hpp"
+#include "Backend/SwapchainPresenter.hpp"
+#include "Backend/TextureStreamer.hpp"
+#include "Backend/PipelineManager.hpp"
+#include "Backend/GPUFrameTimer.hpp"
 
 /**
  * Application class.
@@ -31,8 +46,40 @@ public:
 	int execute();
 
 private:
+	/**
+	 * Handle the quit event.
+	 *
+	 * @param event The event.
+	 */
+	void onQuit(const Event& event);
+
+public:
+	GRAPHITE_SETUP_GETTERS(FrameStatistics, FrameStatistics, m_FrameStatistics);
+	GRAPHITE_SETUP_GETTERS(PipelineManager, PipelineManager, m_PipelineManager);
+	GRAPHITE_SETUP_GETTERS(MemoryArena, FrameArena, m_FrameArena);
+
+private:
+	std::unique_ptr<BinaryLogger> m_pBinaryLogger = nullptr;
+
+	Platform m_Platform;
 	Instance m_Instance;
 	Window m_Window;
+	FramePacer m_FramePacer;
+	CommandSubmissionQueue m_SubmissionQueue;
+	SwapchainPresenter m_SwapchainPresenter;
+	TextureStreamer m_TextureStreamer;
+	PipelineManager m_PipelineManager;
+
+	FrameStatistics m_FrameStatistics;
+	GPUFrameTimer m_GPUFrameTimer;
+	MemoryArena m_FrameArena;
+	AllocationReporter m_AllocationReporter;
+
+	EventQueue m_EventQueue;
+	EventDispatcher m_EventDispatcher;
+
+	Simulation m_Simulation;
+	SimulationState m_RenderState;
 
 	int m_ExitCode = 0;
 	bool m_bShoudRun = true;
@@ -4,13 +4,32 @@
 #include "Instance.hpp"
 #include "VulkanMacros.hpp"
 
-Buffer::Buffer(Instance& instance, uint64_t size, VkBufferUsageFlags usage)
-	: InstanceBoundObject(instance), m_Size(size)
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+Buffer::Buffer(Instance& instance, uint64_t size, VkBufferUsageFlags usage, std::span<const uint32_t> queueFamilies /*= {}*/)
+	: InstanceBoundObject(instance), m_Data(Allocate(instance, size, usage, queueFamilies))
+{
+}
+
+Buffer::~Buffer()
 {
+	// The GPU might still be using the buffer, so it's destroyed once the current frame is done.
+	m_Instance.getDeletionQueue().retire(m_Data.m_Buffer, m_Data.m_Allocation);
+}
+
+BufferData Buffer::Allocate(Instance& instance, uint64_t size, VkBufferUsageFlags usage, std::span<const uint32_t> queueFamilies /*= {}*/)
+{
+	BufferData data;
+	data.m_Size = size;
+	data.m_Usage = usage;
+
 	VmaAllocationCreateFlags vmaFlags = 0;
 	VmaMemoryUsage memoryUsage = VMA_MEMORY_USAGE_AUTO;
 
-	if (usage & VK_BUFFER_USAGE_INDEX_BUFFER_BIT || usage & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT)
+	// Buffers the GPU reads or writes every frame are kept in device local memory, and are filled through staging buffers.
+	if (usage & (VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT))
 	{
 		memoryUsage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
 	}
@@ -20,6 +39,11 @@ Buffer::Buffer(Instance& instance, uint64_t size, VkBufferUsageFlags usage)
 		memoryUsage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
 	}
 
+	// The same family can be listed more than once when the queue types share it, which is still exclusive.
+	std::vector<uint32_t> uniqueFamilies(queueFamilies.begin(), queueFamilies.end());
+	GRAPHITE_RANGES(sort, uniqueFamilies, std::less<uint32_t>());
+	uniqueFamilies.erase(std::unique(uniqueFamilies.begin(), uniqueFamilies.end()), uniqueFamilies.end());
+
 	VkBufferCreateInfo createInfo = {};
 	createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 	createInfo.pNext = nullptr;
@@ -30,22 +54,22 @@ Buffer::Buffer(Instance& instance, uint64_t size, VkBufferUsageFlags usage)
 	createInfo.queueFamilyIndexCount = 0;
 	createInfo.pQueueFamilyIndices = nullptr;
 
+	if (uniqueFamilies.size() > 1)
+	{
+		createInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		createInfo.queueFamilyIndexCount = static_cast<uint32_t>(uniqueFamilies.size());
+		createInfo.pQueueFamilyIndices = uniqueFamilies.data();
+	}
+
 	VmaAllocationCreateInfo allocationCreateInfo = {};
 	allocationCreateInfo.flags = vmaFlags;
 	allocationCreateInfo.usage = memoryUsage;
 
-	m_Instance.getAllocator().access([this, &createInfo, &allocationCreateInfo](VmaAllocator allocator)
+	instance.getAllocator().access([&data, &createInfo, &allocationCreateInfo](VmaAllocator allocator)
 		{
-			GRAPHITE_VK_ASSERT(vmaCreateBuffer(allocator, &createInfo, &allocationCreateInfo, &m_Buffer, &m_BufferMemory, nullptr), "Failed to create the buffer!");
+			GRAPHITE_VK_ASSERT(vmaCreateBuffer(allocator, &createInfo, &allocationCreateInfo, &data.m_Buffer, &data.m_Allocation, nullptr), "Failed to create the buffer!");
 		}
 	);
-}
 
-Buffer::~Buffer()
-{
-	m_Instance.getAllocator().access([this](VmaAllocator allocator)
-		{
-			vmaDestroyBuffer(allocator, m_Buffer, m_BufferMemory);
-		}
-	);
+	return data;
 }
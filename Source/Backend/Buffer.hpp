@@ -4,6 +4,21 @@
 
 #include "InstanceBoundObject.hpp"
 
+#include <span>
+
+/**
+ * Buffer data structure.
+ * This contains the Vulkan handles and the information of a single buffer, without any ownership.
+ */
+struct BufferData final
+{
+	VkBuffer m_Buffer = VK_NULL_HANDLE;
+	VmaAllocation m_Allocation = nullptr;
+
+	uint64_t m_Size = 0;
+	VkBufferUsageFlags m_Usage = 0;
+};
+
 /**
  * Buffer class.
  * This class contains a single Vulkan buffer object.
@@ -17,22 +32,33 @@ public:
 	 * @param instance The instance reference.
 	 * @param size The size of the buffer.
 	 * @param usage The buffer usage.
+	 * @param queueFamilies The queue families which access the buffer. If there are more than one, the buffer is shared between them concurrently,
+	 * so it can be used on different queues without ownership transfers. Default is none, which is exclusive.
 	 */
-	explicit Buffer(Instance& instance, uint64_t size, VkBufferUsageFlags usage);
+	explicit Buffer(Instance& instance, uint64_t size, VkBufferUsageFlags usage, std::span<const uint32_t> queueFamilies = {});
 
 	/**
 	 * Destructor.
 	 */
 	~Buffer() override;
 
+	/**
+	 * Create a Vulkan buffer and allocate it's memory.
+	 * The caller owns the created buffer and should retire it to the deletion queue when it's no longer needed.
+	 *
+	 * @param instance The instance reference.
+	 * @param size The size of the buffer.
+	 * @param usage The buffer usage.
+	 * @param queueFamilies The queue families which access the buffer. Default is none, which is exclusive.
+	 * @return The buffer data.
+	 */
+	[[nodiscard]] static BufferData Allocate(Instance& instance, uint64_t size, VkBufferUsageFlags usage, std::span<const uint32_t> queueFamilies = {});
+
 public:
-	GRAPHITE_SETUP_SIMPLE_GETTER(uint64_t, Size, m_Size);
-	GRAPHITE_SETUP_SIMPLE_GETTER(VkBuffer, Buffer, m_Buffer);
-	GRAPHITE_SETUP_SIMPLE_GETTER(VmaAllocation, BufferMemory, m_BufferMemory);
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint64_t, Size, m_Data.m_Size);
+	GRAPHITE_SETUP_SIMPLE_GETTER(VkBuffer, Buffer, m_Data.m_Buffer);
+	GRAPHITE_SETUP_SIMPLE_GETTER(VmaAllocation, BufferMemory, m_Data.m_Allocation);
 
 private:
-	uint64_t m_Size = 0;
-
-	VkBuffer m_Buffer = VK_NULL_HANDLE;
-	VmaAllocation m_BufferMemory = nullptr;
-};
\ No newline at end of file
+	BufferData m_Data;
+};
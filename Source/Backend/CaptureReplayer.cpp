@@ -0,0 +1,1201 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "CaptureReplayer.hpp"
+#include "Instance.hpp"
+#include "VulkanMacros.hpp"
+
+#include <optick.h>
+
+#include <cstring>
+#include <fstream>
+
+namespace /* anonymous */
+{
+	constexpr char g_Magic[4] = { 'G', 'C', 'A', 'P' };
+	constexpr uint32_t g_Version = 1;
+
+	// The size of a record's command and payload size.
+	constexpr size_t g_RecordHeaderSize = sizeof(uint32_t) * 2;
+
+	// The smallest sizes of the elements of the variable length records, which their counts are checked against before anything is allocated.
+	constexpr size_t g_SetLayoutBindingSize = sizeof(uint32_t) + sizeof(VkDescriptorType) + sizeof(uint32_t) + sizeof(VkShaderStageFlags);
+	constexpr size_t g_DescriptorWriteSize = sizeof(uint64_t) + sizeof(uint32_t) * 2 + sizeof(VkDescriptorType) + sizeof(uint32_t);
+	constexpr size_t g_SubmitSize = sizeof(uint32_t) * 3;
+	constexpr size_t g_SemaphoreSubmitSize = sizeof(uint64_t) * 2 + sizeof(VkPipelineStageFlags2KHR);
+	constexpr size_t g_CommandBufferSubmitSize = sizeof(uint64_t);
+	constexpr size_t g_MemoryBarrierSize = sizeof(VkPipelineStageFlags2KHR) * 2 + sizeof(VkAccessFlags2KHR) * 2;
+	constexpr size_t g_BufferBarrierSize = g_MemoryBarrierSize + sizeof(uint8_t) * 2 + sizeof(uint64_t) + sizeof(VkDeviceSize) * 2;
+	constexpr size_t g_ImageBarrierSize = g_MemoryBarrierSize + sizeof(VkImageLayout) * 2 + sizeof(uint8_t) * 2 + sizeof(uint64_t) + sizeof(VkImageSubresourceRange);
+
+	/**
+	 * Map a captured handle to the replayed handle.
+	 *
+	 * @tparam Handle The handle type.
+	 * @param handles The handle map.
+	 * @param id The captured handle.
+	 * @param handle The replayed handle.
+	 * @return False if the handle is not known. Null handles are always known.
+	 */
+	template<class Handle>
+	[[nodiscard]] bool Resolve(const std::unordered_map<uint64_t, Handle>& handles, uint64_t id, Handle& handle)
+	{
+		if (id == 0)
+		{
+			handle = VK_NULL_HANDLE;
+			return true;
+		}
+
+		const auto iterator = handles.find(id);
+		if (iterator == handles.end())
+			return false;
+
+		handle = iterator->second;
+		return true;
+	}
+
+	/**
+	 * Map an array of captured handles to the replayed handles.
+	 *
+	 * @tparam Handle The handle type.
+	 * @param handles The handle map.
+	 * @param ids The captured handles.
+	 * @return The replayed handles. Empty if any of them is not known.
+	 */
+	template<class Handle>
+	[[nodiscard]] std::vector<Handle> ResolveArray(const std::unordered_map<uint64_t, Handle>& handles, const std::vector<uint64_t>& ids)
+	{
+		std::vector<Handle> resolved(ids.size());
+		for (size_t i = 0; i < ids.size(); i++)
+		{
+			if (!Resolve(handles, ids[i], resolved[i]))
+				return {};
+		}
+
+		return resolved;
+	}
+}
+
+CaptureReplayer::CaptureReplayer(Instance& instance, const std::filesystem::path& path)
+	: InstanceBoundObject(instance)
+{
+	auto file = std::ifstream(path, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+	{
+		GRAPHITE_LOG_ERROR("Failed to open the capture file {}!", path.string());
+		return;
+	}
+
+	std::vector<std::byte> data(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+	char magic[4] = {};
+	uint32_t version = 0;
+	if (data.size() >= sizeof(magic) + sizeof(version))
+	{
+		std::memcpy(magic, data.data(), sizeof(magic));
+		std::memcpy(&version, data.data() + sizeof(magic), sizeof(version));
+	}
+
+	if (std::memcmp(magic, g_Magic, sizeof(magic)) != 0 || version != g_Version)
+	{
+		GRAPHITE_LOG_ERROR("The file {} is not a capture of version {}!", path.string(), g_Version);
+		return;
+	}
+
+	m_Data = std::move(data);
+}
+
+CaptureReplayer::~CaptureReplayer()
+{
+	if (isValid())
+		destroyAll();
+}
+
+bool CaptureReplayer::replay(FrameStatistics& statistics)
+{
+	OPTICK_EVENT();
+
+	if (!isValid())
+		return false;
+
+	auto offset = sizeof(g_Magic) + sizeof(g_Version);
+	while (offset < m_Data.size())
+	{
+		uint32_t command = 0;
+		uint32_t size = 0;
+		if (m_Data.size() - offset < g_RecordHeaderSize)
+			break;
+
+		std::memcpy(&command, m_Data.data() + offset, sizeof(command));
+		std::memcpy(&size, m_Data.data() + offset + sizeof(command), sizeof(size));
+		offset += g_RecordHeaderSize;
+
+		if (m_Data.size() - offset < size)
+			break;
+
+		auto reader = CaptureReader(std::span<const std::byte>(m_Data.data() + offset, size));
+		offset += size;
+		m_RecordCount++;
+
+		// The frame markers end the measured frames.
+		if (static_cast<CaptureCommand>(command) == CaptureCommand::Frame)
+		{
+			waitForSubmissions();
+			statistics.beginFrame();
+			continue;
+		}
+
+		if (!execute(static_cast<CaptureCommand>(command), reader) || reader.hasOverflowed())
+			m_SkippedCount++;
+	}
+
+	waitForSubmissions();
+
+	if (offset != m_Data.size())
+	{
+		GRAPHITE_LOG_ERROR("The capture is truncated! Stopped after {} records.", m_RecordCount);
+		return false;
+	}
+
+	return true;
+}
+
+bool CaptureReplayer::execute(CaptureCommand command, CaptureReader& reader)
+{
+	// The replayer is the only user of the device, so it's not locked for each call.
+	const auto& table = m_Instance.getDeviceTable();
+	const auto logicalDevice = m_Instance.getLogicalDevice().getUnsafe();
+
+	switch (command)
+	{
+	case CaptureCommand::CreateBuffer:
+	{
+		const auto id = reader.read<uint64_t>();
+
+		ReplayBuffer buffer;
+		buffer.m_CreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		buffer.m_CreateInfo.pNext = nullptr;
+		buffer.m_CreateInfo.flags = reader.read<VkBufferCreateFlags>();
+		buffer.m_CreateInfo.size = reader.read<VkDeviceSize>();
+		buffer.m_CreateInfo.usage = reader.read<VkBufferUsageFlags>();
+		buffer.m_CreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		buffer.m_CreateInfo.queueFamilyIndexCount = 0;
+		buffer.m_CreateInfo.pQueueFamilyIndices = nullptr;
+
+		m_Buffers[id] = buffer;
+		return true;
+	}
+
+	case CaptureCommand::DestroyBuffer:
+	{
+		const auto buffer = m_Buffers.find(reader.read<uint64_t>());
+		if (buffer == m_Buffers.end())
+			return false;
+
+		waitForSubmissions();
+		if (buffer->second.m_Buffer != VK_NULL_HANDLE)
+			m_Instance.getAllocator().access([&buffer](VmaAllocator allocator) { vmaDestroyBuffer(allocator, buffer->second.m_Buffer, buffer->second.m_Allocation); });
+
+		m_Buffers.erase(buffer);
+		return true;
+	}
+
+	case CaptureCommand::BindBufferMemory:
+	{
+		const auto buffer = m_Buffers.find(reader.read<uint64_t>());
+		const auto propertyFlags = reader.read<VkMemoryPropertyFlags>();
+		if (buffer == m_Buffers.end() || buffer->second.m_Buffer != VK_NULL_HANDLE)
+			return false;
+
+		createBuffer(buffer->second, propertyFlags);
+		return true;
+	}
+
+	case CaptureCommand::UpdateBuffer:
+	{
+		const auto buffer = m_Buffers.find(reader.read<uint64_t>());
+		const auto offset = reader.read<uint64_t>();
+		const auto size = reader.read<uint32_t>();
+		const auto bytes = reader.readSpan(size);
+		if (buffer == m_Buffers.end() || !buffer->second.m_pData || offset + size > buffer->second.m_CreateInfo.size)
+			return false;
+
+		waitForSubmissions();
+		std::memcpy(buffer->second.m_pData + offset, bytes.data(), bytes.size());
+		m_Instance.getAllocator().access([&buffer, offset, size](VmaAllocator allocator) { vmaFlushAllocation(allocator, buffer->second.m_Allocation, offset, size); });
+
+		return true;
+	}
+
+	case CaptureCommand::CreateImage:
+	{
+		const auto id = reader.read<uint64_t>();
+
+		ReplayImage image;
+		image.m_CreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		image.m_CreateInfo.pNext = nullptr;
+		image.m_CreateInfo.flags = reader.read<VkImageCreateFlags>();
+		image.m_CreateInfo.imageType = reader.read<VkImageType>();
+		image.m_CreateInfo.format = reader.read<VkFormat>();
+		image.m_CreateInfo.extent = reader.read<VkExtent3D>();
+		image.m_CreateInfo.mipLevels = reader.read<uint32_t>();
+		image.m_CreateInfo.arrayLayers = reader.read<uint32_t>();
+		image.m_CreateInfo.samples = reader.read<VkSampleCountFlagBits>();
+		image.m_CreateInfo.tiling = reader.read<VkImageTiling>();
+		image.m_CreateInfo.usage = reader.read<VkImageUsageFlags>();
+		image.m_CreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		image.m_CreateInfo.queueFamilyIndexCount = 0;
+		image.m_CreateInfo.pQueueFamilyIndices = nullptr;
+		image.m_CreateInfo.initialLayout = reader.read<VkImageLayout>();
+
+		m_Images[id] = image;
+		return true;
+	}
+
+	case CaptureCommand::DestroyImage:
+	{
+		const auto image = m_Images.find(reader.read<uint64_t>());
+		if (image == m_Images.end())
+			return false;
+
+		waitForSubmissions();
+		if (image->second.m_Image != VK_NULL_HANDLE)
+			m_Instance.getAllocator().access([&image](VmaAllocator allocator) { vmaDestroyImage(allocator, image->second.m_Image, image->second.m_Allocation); });
+
+		m_Images.erase(image);
+		return true;
+	}
+
+	case CaptureCommand::BindImageMemory:
+	{
+		const auto image = m_Images.find(reader.read<uint64_t>());
+		const auto propertyFlags = reader.read<VkMemoryPropertyFlags>();
+		if (image == m_Images.end() || image->second.m_Image != VK_NULL_HANDLE)
+			return false;
+
+		createImage(image->second, propertyFlags);
+		return true;
+	}
+
+	case CaptureCommand::CreateImageView:
+	{
+		const auto id = reader.read<uint64_t>();
+		const auto image = m_Images.find(reader.read<uint64_t>());
+
+		VkImageViewCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		createInfo.pNext = nullptr;
+		createInfo.flags = 0;
+		createInfo.viewType = reader.read<VkImageViewType>();
+		createInfo.format = reader.read<VkFormat>();
+		createInfo.components = reader.read<VkComponentMapping>();
+		createInfo.subresourceRange = reader.read<VkImageSubresourceRange>();
+
+		if (image == m_Images.end() || image->second.m_Image == VK_NULL_HANDLE)
+			return false;
+
+		createInfo.image = image->second.m_Image;
+
+		VkImageView imageView = VK_NULL_HANDLE;
+		GRAPHITE_VK_ASSERT(table.vkCreateImageView(logicalDevice, &createInfo, nullptr, &imageView), "Failed to create the replayed image view!");
+
+		m_ImageViews[id] = imageView;
+		return true;
+	}
+
+	case CaptureCommand::DestroyImageView:
+	{
+		const auto imageView = m_ImageViews.find(reader.read<uint64_t>());
+		if (imageView == m_ImageViews.end())
+			return false;
+
+		waitForSubmissions();
+		table.vkDestroyImageView(logicalDevice, imageView->second, nullptr);
+		m_ImageViews.erase(imageView);
+		return true;
+	}
+
+	case CaptureCommand::CreateShaderModule:
+	{
+		const auto id = reader.read<uint64_t>();
+		const auto code = reader.readArray<uint32_t>();
+
+		VkShaderModuleCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		createInfo.pNext = nullptr;
+		createInfo.flags = 0;
+		createInfo.codeSize = code.size() * sizeof(uint32_t);
+		createInfo.pCode = code.data();
+
+		VkShaderModule shaderModule = VK_NULL_HANDLE;
+		GRAPHITE_VK_ASSERT(table.vkCreateShaderModule(logicalDevice, &createInfo, nullptr, &shaderModule), "Failed to create the replayed shader module!");
+
+		m_ShaderModules[id] = shaderModule;
+		return true;
+	}
+
+	case CaptureCommand::DestroyShaderModule:
+	{
+		const auto shaderModule = m_ShaderModules.find(reader.read<uint64_t>());
+		if (shaderModule == m_ShaderModules.end())
+			return false;
+
+		table.vkDestroyShaderModule(logicalDevice, shaderModule->second, nullptr);
+		m_ShaderModules.erase(shaderModule);
+		return true;
+	}
+
+	case CaptureCommand::CreateDescriptorSetLayout:
+	{
+		const auto id = reader.read<uint64_t>();
+		const auto flags = reader.read<VkDescriptorSetLayoutCreateFlags>();
+
+		std::vector<VkDescriptorSetLayoutBinding> bindings(reader.readCount(g_SetLayoutBindingSize));
+		for (auto& binding : bindings)
+		{
+			binding.binding = reader.read<uint32_t>();
+			binding.descriptorType = reader.read<VkDescriptorType>();
+			binding.descriptorCount = reader.read<uint32_t>();
+			binding.stageFlags = reader.read<VkShaderStageFlags>();
+			binding.pImmutableSamplers = nullptr;
+		}
+
+		VkDescriptorSetLayoutCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		createInfo.pNext = nullptr;
+		createInfo.flags = flags;
+		createInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+		createInfo.pBindings = bindings.data();
+
+		VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+		GRAPHITE_VK_ASSERT(table.vkCreateDescriptorSetLayout(logicalDevice, &createInfo, nullptr, &setLayout), "Failed to create the replayed descriptor set layout!");
+
+		m_SetLayouts[id] = setLayout;
+		return true;
+	}
+
+	case CaptureCommand::DestroyDescriptorSetLayout:
+	{
+		const auto setLayout = m_SetLayouts.find(reader.read<uint64_t>());
+		if (setLayout == m_SetLayouts.end())
+			return false;
+
+		table.vkDestroyDescriptorSetLayout(logicalDevice, setLayout->second, nullptr);
+		m_SetLayouts.erase(setLayout);
+		return true;
+	}
+
+	case CaptureCommand::CreatePipelineLayout:
+	{
+		const auto id = reader.read<uint64_t>();
+		const auto setLayoutIds = reader.readArray<uint64_t>();
+		const auto pushConstantRanges = reader.readArray<VkPushConstantRange>();
+
+		const auto setLayouts = ResolveArray(m_SetLayouts, setLayoutIds);
+		if (setLayouts.size() != setLayoutIds.size())
+			return false;
+
+		VkPipelineLayoutCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		createInfo.pNext = nullptr;
+		createInfo.flags = 0;
+		createInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+		createInfo.pSetLayouts = setLayouts.data();
+		createInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size());
+		createInfo.pPushConstantRanges = pushConstantRanges.data();
+
+		VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+		GRAPHITE_VK_ASSERT(table.vkCreatePipelineLayout(logicalDevice, &createInfo, nullptr, &pipelineLayout), "Failed to create the replayed pipeline layout!");
+
+		m_PipelineLayouts[id] = pipelineLayout;
+		return true;
+	}
+
+	case CaptureCommand::DestroyPipelineLayout:
+	{
+		const auto pipelineLayout = m_PipelineLayouts.find(reader.read<uint64_t>());
+		if (pipelineLayout == m_PipelineLayouts.end())
+			return false;
+
+		waitForSubmissions();
+		table.vkDestroyPipelineLayout(logicalDevice, pipelineLayout->second, nullptr);
+		m_PipelineLayouts.erase(pipelineLayout);
+		return true;
+	}
+
+	case CaptureCommand::CreateComputePipeline:
+	{
+		const auto id = reader.read<uint64_t>();
+		const auto flags = reader.read<VkPipelineCreateFlags>();
+		const auto layoutId = reader.read<uint64_t>();
+		const auto moduleId = reader.read<uint64_t>();
+		const auto entryPoint = reader.readString();
+		const auto mapEntries = reader.readArray<VkSpecializationMapEntry>();
+		const auto specializationData = reader.readArray<std::byte>();
+
+		VkPipelineLayout layout = VK_NULL_HANDLE;
+		VkShaderModule shaderModule = VK_NULL_HANDLE;
+		if (!Resolve(m_PipelineLayouts, layoutId, layout) || !Resolve(m_ShaderModules, moduleId, shaderModule))
+			return false;
+
+		VkSpecializationInfo specializationInfo = {};
+		specializationInfo.mapEntryCount = static_cast<uint32_t>(mapEntries.size());
+		specializationInfo.pMapEntries = mapEntries.data();
+		specializationInfo.dataSize = specializationData.size();
+		specializationInfo.pData = specializationData.data();
+
+		VkComputePipelineCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		createInfo.pNext = nullptr;
+		createInfo.flags = flags;
+		createInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		createInfo.stage.pNext = nullptr;
+		createInfo.stage.flags = 0;
+		createInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		createInfo.stage.module = shaderModule;
+		createInfo.stage.pName = entryPoint.c_str();
+		createInfo.stage.pSpecializationInfo = mapEntries.empty() ? nullptr : &specializationInfo;
+		createInfo.layout = layout;
+		createInfo.basePipelineHandle = VK_NULL_HANDLE;
+		createInfo.basePipelineIndex = -1;
+
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		GRAPHITE_VK_ASSERT(table.vkCreateComputePipelines(logicalDevice, m_Instance.getPipelineCache(), 1, &createInfo, nullptr, &pipeline), "Failed to create the replayed compute pipeline!");
+
+		m_Pipelines[id] = pipeline;
+		return true;
+	}
+
+	case CaptureCommand::DestroyPipeline:
+	{
+		const auto pipeline = m_Pipelines.find(reader.read<uint64_t>());
+		if (pipeline == m_Pipelines.end())
+			return false;
+
+		waitForSubmissions();
+		table.vkDestroyPipeline(logicalDevice, pipeline->second, nullptr);
+		m_Pipelines.erase(pipeline);
+		return true;
+	}
+
+	case CaptureCommand::CreateDescriptorPool:
+	{
+		const auto id = reader.read<uint64_t>();
+		const auto flags = reader.read<VkDescriptorPoolCreateFlags>();
+		const auto maxSets = reader.read<uint32_t>();
+		const auto poolSizes = reader.readArray<VkDescriptorPoolSize>();
+
+		VkDescriptorPoolCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		createInfo.pNext = nullptr;
+		createInfo.flags = flags;
+		createInfo.maxSets = maxSets;
+		createInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+		createInfo.pPoolSizes = poolSizes.data();
+
+		VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+		GRAPHITE_VK_ASSERT(table.vkCreateDescriptorPool(logicalDevice, &createInfo, nullptr, &descriptorPool), "Failed to create the replayed descriptor pool!");
+
+		m_DescriptorPools[id] = descriptorPool;
+		return true;
+	}
+
+	case CaptureCommand::DestroyDescriptorPool:
+	{
+		const auto descriptorPool = m_DescriptorPools.find(reader.read<uint64_t>());
+		if (descriptorPool == m_DescriptorPools.end())
+			return false;
+
+		// The sets are freed with the pool. Their ids are overwritten if the driver hands them out again.
+		waitForSubmissions();
+		table.vkDestroyDescriptorPool(logicalDevice, descriptorPool->second, nullptr);
+		m_DescriptorPools.erase(descriptorPool);
+		return true;
+	}
+
+	case CaptureCommand::AllocateDescriptorSets:
+	{
+		const auto poolId = reader.read<uint64_t>();
+		const auto setLayoutIds = reader.readArray<uint64_t>();
+		const auto setIds = reader.readArray<uint64_t>();
+
+		VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+		const auto setLayouts = ResolveArray(m_SetLayouts, setLayoutIds);
+		if (!Resolve(m_DescriptorPools, poolId, descriptorPool) || setLayouts.size() != setLayoutIds.size() || setIds.size() != setLayoutIds.size())
+			return false;
+
+		VkDescriptorSetAllocateInfo allocateInfo = {};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocateInfo.pNext = nullptr;
+		allocateInfo.descriptorPool = descriptorPool;
+		allocateInfo.descriptorSetCount = static_cast<uint32_t>(setLayouts.size());
+		allocateInfo.pSetLayouts = setLayouts.data();
+
+		std::vector<VkDescriptorSet> descriptorSets(setLayouts.size());
+		GRAPHITE_VK_ASSERT(table.vkAllocateDescriptorSets(logicalDevice, &allocateInfo, descriptorSets.data()), "Failed to allocate the replayed descriptor sets!");
+
+		for (size_t i = 0; i < setIds.size(); i++)
+			m_DescriptorSets[setIds[i]] = descriptorSets[i];
+
+		return true;
+	}
+
+	case CaptureCommand::UpdateDescriptorSets:
+	{
+		std::vector<VkWriteDescriptorSet> writes(reader.readCount(g_DescriptorWriteSize));
+		std::vector<std::vector<VkDescriptorImageInfo>> imageInfos(writes.size());
+		std::vector<std::vector<VkDescriptorBufferInfo>> bufferInfos(writes.size());
+
+		bool bIsComplete = true;
+		for (size_t i = 0; i < writes.size(); i++)
+		{
+			auto& write = writes[i];
+			write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write.pNext = nullptr;
+			bIsComplete &= Resolve(m_DescriptorSets, reader.read<uint64_t>(), write.dstSet);
+			write.dstBinding = reader.read<uint32_t>();
+			write.dstArrayElement = reader.read<uint32_t>();
+			write.descriptorType = reader.read<VkDescriptorType>();
+			write.descriptorCount = reader.read<uint32_t>();
+
+			for (uint32_t j = 0; j < write.descriptorCount && !reader.hasOverflowed(); j++)
+			{
+				switch (write.descriptorType)
+				{
+				case VK_DESCRIPTOR_TYPE_SAMPLER:
+				case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+				case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+				case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+				case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+				{
+					// The samplers are not captured, so only the writes without one can be replayed.
+					auto& imageInfo = imageInfos[i].emplace_back();
+					bIsComplete &= reader.read<uint64_t>() == 0;
+					bIsComplete &= Resolve(m_ImageViews, reader.read<uint64_t>(), imageInfo.imageView);
+					imageInfo.imageLayout = reader.read<VkImageLayout>();
+					break;
+				}
+
+				default:
+				{
+					auto& bufferInfo = bufferInfos[i].emplace_back();
+					const auto buffer = m_Buffers.find(reader.read<uint64_t>());
+					bIsComplete &= buffer != m_Buffers.end() && buffer->second.m_Buffer != VK_NULL_HANDLE;
+					bufferInfo.buffer = bIsComplete ? buffer->second.m_Buffer : VK_NULL_HANDLE;
+					bufferInfo.offset = reader.read<VkDeviceSize>();
+					bufferInfo.range = reader.read<VkDeviceSize>();
+					break;
+				}
+				}
+			}
+
+			write.pImageInfo = imageInfos[i].empty() ? nullptr : imageInfos[i].data();
+			write.pBufferInfo = bufferInfos[i].empty() ? nullptr : bufferInfos[i].data();
+			write.pTexelBufferView = nullptr;
+		}
+
+		if (!bIsComplete || reader.hasOverflowed())
+			return false;
+
+		waitForSubmissions();
+		table.vkUpdateDescriptorSets(logicalDevice, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+		return true;
+	}
+
+	case CaptureCommand::CreateCommandPool:
+	{
+		const auto id = reader.read<uint64_t>();
+		const auto flags = reader.read<VkCommandPoolCreateFlags>();
+		const auto queueType = reader.read<uint8_t>();
+
+		// The replayer re-records the command buffers without resetting the pool, so the buffers must be resettable on their own.
+		VkCommandPoolCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		createInfo.pNext = nullptr;
+		createInfo.flags = flags | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		createInfo.queueFamilyIndex = queueType < 3 ? getQueueFamily(queueType) : getQueueFamily(static_cast<uint8_t>(QueueType::Graphics));
+
+		VkCommandPool commandPool = VK_NULL_HANDLE;
+		GRAPHITE_VK_ASSERT(table.vkCreateCommandPool(logicalDevice, &createInfo, nullptr, &commandPool), "Failed to create the replayed command pool!");
+
+		m_CommandPools[id] = commandPool;
+		return true;
+	}
+
+	case CaptureCommand::DestroyCommandPool:
+	{
+		const auto commandPool = m_CommandPools.find(reader.read<uint64_t>());
+		if (commandPool == m_CommandPools.end())
+			return false;
+
+		// The command buffers are freed with the pool. Their ids are overwritten if the driver hands them out again.
+		waitForSubmissions();
+		table.vkDestroyCommandPool(logicalDevice, commandPool->second, nullptr);
+		m_CommandPools.erase(commandPool);
+		return true;
+	}
+
+	case CaptureCommand::AllocateCommandBuffers:
+	{
+		const auto poolId = reader.read<uint64_t>();
+		const auto level = reader.read<VkCommandBufferLevel>();
+		const auto commandBufferIds = reader.readArray<uint64_t>();
+
+		VkCommandPool commandPool = VK_NULL_HANDLE;
+		if (!Resolve(m_CommandPools, poolId, commandPool) || commandBufferIds.empty())
+			return false;
+
+		VkCommandBufferAllocateInfo allocateInfo = {};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocateInfo.pNext = nullptr;
+		allocateInfo.commandPool = commandPool;
+		allocateInfo.level = level;
+		allocateInfo.commandBufferCount = static_cast<uint32_t>(commandBufferIds.size());
+
+		std::vector<VkCommandBuffer> commandBuffers(commandBufferIds.size());
+		GRAPHITE_VK_ASSERT(table.vkAllocateCommandBuffers(logicalDevice, &allocateInfo, commandBuffers.data()), "Failed to allocate the replayed command buffers!");
+
+		for (size_t i = 0; i < commandBufferIds.size(); i++)
+			m_CommandBuffers[commandBufferIds[i]] = commandBuffers[i];
+
+		return true;
+	}
+
+	case CaptureCommand::BeginCommandBuffer:
+	{
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		if (!Resolve(m_CommandBuffers, reader.read<uint64_t>(), commandBuffer))
+			return false;
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.pNext = nullptr;
+		beginInfo.flags = reader.read<VkCommandBufferUsageFlags>();
+		beginInfo.pInheritanceInfo = nullptr;
+
+		// The engine waited for the previous submission of the command buffer before recording it again.
+		waitForSubmissions();
+		GRAPHITE_VK_ASSERT(table.vkBeginCommandBuffer(commandBuffer, &beginInfo), "Failed to begin the replayed command buffer!");
+		return true;
+	}
+
+	case CaptureCommand::EndCommandBuffer:
+	{
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		if (!Resolve(m_CommandBuffers, reader.read<uint64_t>(), commandBuffer))
+			return false;
+
+		GRAPHITE_VK_ASSERT(table.vkEndCommandBuffer(commandBuffer), "Failed to end the replayed command buffer!");
+		return true;
+	}
+
+	case CaptureCommand::ResetCommandBuffer:
+	{
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		if (!Resolve(m_CommandBuffers, reader.read<uint64_t>(), commandBuffer))
+			return false;
+
+		waitForSubmissions();
+		GRAPHITE_VK_ASSERT(table.vkResetCommandBuffer(commandBuffer, reader.read<VkCommandBufferResetFlags>()), "Failed to reset the replayed command buffer!");
+		return true;
+	}
+
+	case CaptureCommand::CreateQueryPool:
+	{
+		const auto id = reader.read<uint64_t>();
+
+		VkQueryPoolCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		createInfo.pNext = nullptr;
+		createInfo.flags = 0;
+		createInfo.queryType = reader.read<VkQueryType>();
+		createInfo.queryCount = reader.read<uint32_t>();
+		createInfo.pipelineStatistics = reader.read<VkQueryPipelineStatisticFlags>();
+
+		VkQueryPool queryPool = VK_NULL_HANDLE;
+		GRAPHITE_VK_ASSERT(table.vkCreateQueryPool(logicalDevice, &createInfo, nullptr, &queryPool), "Failed to create the replayed query pool!");
+
+		m_QueryPools[id] = queryPool;
+		return true;
+	}
+
+	case CaptureCommand::DestroyQueryPool:
+	{
+		const auto queryPool = m_QueryPools.find(reader.read<uint64_t>());
+		if (queryPool == m_QueryPools.end())
+			return false;
+
+		waitForSubmissions();
+		table.vkDestroyQueryPool(logicalDevice, queryPool->second, nullptr);
+		m_QueryPools.erase(queryPool);
+		return true;
+	}
+
+	case CaptureCommand::CreateSemaphore:
+	{
+		const auto id = reader.read<uint64_t>();
+
+		VkSemaphoreTypeCreateInfoKHR typeCreateInfo = {};
+		typeCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+		typeCreateInfo.pNext = nullptr;
+		typeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+		typeCreateInfo.initialValue = reader.read<uint64_t>();
+
+		VkSemaphoreCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		createInfo.pNext = &typeCreateInfo;
+		createInfo.flags = 0;
+
+		VkSemaphore semaphore = VK_NULL_HANDLE;
+		GRAPHITE_VK_ASSERT(table.vkCreateSemaphore(logicalDevice, &createInfo, nullptr, &semaphore), "Failed to create the replayed semaphore!");
+
+		m_Semaphores[id] = semaphore;
+		return true;
+	}
+
+	case CaptureCommand::DestroySemaphore:
+	{
+		const auto semaphore = m_Semaphores.find(reader.read<uint64_t>());
+		if (semaphore == m_Semaphores.end())
+			return false;
+
+		waitForSubmissions();
+		table.vkDestroySemaphore(logicalDevice, semaphore->second, nullptr);
+		m_Semaphores.erase(semaphore);
+		return true;
+	}
+
+	case CaptureCommand::QueueSubmit:
+	{
+		const auto queueType = reader.read<uint8_t>();
+		const auto submitCount = reader.readCount(g_SubmitSize);
+		if (queueType >= 3)
+			return false;
+
+		// The infos are stored in flat vectors which are sized up front, so the pointers to them stay valid.
+		std::vector<VkSubmitInfo2KHR> submits(submitCount);
+		std::vector<std::vector<VkSemaphoreSubmitInfoKHR>> waits(submitCount);
+		std::vector<std::vector<VkCommandBufferSubmitInfoKHR>> commandBuffers(submitCount);
+		std::vector<std::vector<VkSemaphoreSubmitInfoKHR>> signals(submitCount);
+
+		bool bIsComplete = true;
+		const auto readSemaphores = [this, &reader, &bIsComplete](std::vector<VkSemaphoreSubmitInfoKHR>& infos)
+		{
+			infos.resize(reader.readCount(g_SemaphoreSubmitSize));
+			for (auto& info : infos)
+			{
+				info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO_KHR;
+				info.pNext = nullptr;
+				bIsComplete &= Resolve(m_Semaphores, reader.read<uint64_t>(), info.semaphore);
+				info.value = reader.read<uint64_t>();
+				info.stageMask = reader.read<VkPipelineStageFlags2KHR>();
+				info.deviceIndex = 0;
+			}
+		};
+
+		for (uint32_t i = 0; i < submitCount && !reader.hasOverflowed(); i++)
+		{
+			readSemaphores(waits[i]);
+
+			commandBuffers[i].resize(reader.readCount(g_CommandBufferSubmitSize));
+			for (auto& info : commandBuffers[i])
+			{
+				info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO_KHR;
+				info.pNext = nullptr;
+				bIsComplete &= Resolve(m_CommandBuffers, reader.read<uint64_t>(), info.commandBuffer);
+				info.deviceMask = 0;
+			}
+
+			readSemaphores(signals[i]);
+
+			auto& submit = submits[i];
+			submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2_KHR;
+			submit.pNext = nullptr;
+			submit.flags = 0;
+			submit.waitSemaphoreInfoCount = static_cast<uint32_t>(waits[i].size());
+			submit.pWaitSemaphoreInfos = waits[i].data();
+			submit.commandBufferInfoCount = static_cast<uint32_t>(commandBuffers[i].size());
+			submit.pCommandBufferInfos = commandBuffers[i].data();
+			submit.signalSemaphoreInfoCount = static_cast<uint32_t>(signals[i].size());
+			submit.pSignalSemaphoreInfos = signals[i].data();
+		}
+
+		if (!bIsComplete || reader.hasOverflowed())
+			return false;
+
+		m_Instance.getQueue(static_cast<QueueType>(queueType)).access([&table, &submits](const VulkanQueue& queue)
+			{
+				GRAPHITE_VK_ASSERT(table.vkQueueSubmit2KHR(queue.m_Queue, static_cast<uint32_t>(submits.size()), submits.data(), VK_NULL_HANDLE), "Failed to submit the replayed work!");
+			}
+		);
+
+		m_bHasSubmissions = true;
+		return true;
+	}
+
+	case CaptureCommand::CmdBindPipeline:
+	{
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		const auto bCommandBuffer = Resolve(m_CommandBuffers, reader.read<uint64_t>(), commandBuffer);
+		const auto bindPoint = reader.read<VkPipelineBindPoint>();
+		if (!bCommandBuffer || !Resolve(m_Pipelines, reader.read<uint64_t>(), pipeline))
+			return false;
+
+		table.vkCmdBindPipeline(commandBuffer, bindPoint, pipeline);
+		return true;
+	}
+
+	case CaptureCommand::CmdBindDescriptorSets:
+	{
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		VkPipelineLayout layout = VK_NULL_HANDLE;
+		const auto bCommandBuffer = Resolve(m_CommandBuffers, reader.read<uint64_t>(), commandBuffer);
+		const auto bindPoint = reader.read<VkPipelineBindPoint>();
+		const auto bLayout = Resolve(m_PipelineLayouts, reader.read<uint64_t>(), layout);
+		const auto firstSet = reader.read<uint32_t>();
+		const auto setIds = reader.readArray<uint64_t>();
+		const auto dynamicOffsets = reader.readArray<uint32_t>();
+
+		const auto descriptorSets = ResolveArray(m_DescriptorSets, setIds);
+		if (!bCommandBuffer || !bLayout || descriptorSets.size() != setIds.size())
+			return false;
+
+		table.vkCmdBindDescriptorSets(commandBuffer, bindPoint, layout, firstSet, static_cast<uint32_t>(descriptorSets.size()), descriptorSets.data(), static_cast<uint32_t>(dynamicOffsets.size()), dynamicOffsets.data());
+		return true;
+	}
+
+	case CaptureCommand::CmdPushConstants:
+	{
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		VkPipelineLayout layout = VK_NULL_HANDLE;
+		const auto bCommandBuffer = Resolve(m_CommandBuffers, reader.read<uint64_t>(), commandBuffer);
+		const auto bLayout = Resolve(m_PipelineLayouts, reader.read<uint64_t>(), layout);
+		const auto stageFlags = reader.read<VkShaderStageFlags>();
+		const auto offset = reader.read<uint32_t>();
+		const auto size = reader.read<uint32_t>();
+		const auto values = reader.readSpan(size);
+		if (!bCommandBuffer || !bLayout || values.size() != size)
+			return false;
+
+		table.vkCmdPushConstants(commandBuffer, layout, stageFlags, offset, size, values.data());
+		return true;
+	}
+
+	case CaptureCommand::CmdDispatch:
+	{
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		if (!Resolve(m_CommandBuffers, reader.read<uint64_t>(), commandBuffer))
+			return false;
+
+		const auto x = reader.read<uint32_t>();
+		const auto y = reader.read<uint32_t>();
+		const auto z = reader.read<uint32_t>();
+		table.vkCmdDispatch(commandBuffer, x, y, z);
+		return true;
+	}
+
+	case CaptureCommand::CmdDispatchIndirect:
+	{
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		const auto bCommandBuffer = Resolve(m_CommandBuffers, reader.read<uint64_t>(), commandBuffer);
+		const auto buffer = m_Buffers.find(reader.read<uint64_t>());
+		const auto offset = reader.read<VkDeviceSize>();
+		if (!bCommandBuffer || buffer == m_Buffers.end() || buffer->second.m_Buffer == VK_NULL_HANDLE)
+			return false;
+
+		table.vkCmdDispatchIndirect(commandBuffer, buffer->second.m_Buffer, offset);
+		return true;
+	}
+
+	case CaptureCommand::CmdFillBuffer:
+	{
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		const auto bCommandBuffer = Resolve(m_CommandBuffers, reader.read<uint64_t>(), commandBuffer);
+		const auto buffer = m_Buffers.find(reader.read<uint64_t>());
+		const auto offset = reader.read<VkDeviceSize>();
+		const auto size = reader.read<VkDeviceSize>();
+		const auto data = reader.read<uint32_t>();
+		if (!bCommandBuffer || buffer == m_Buffers.end() || buffer->second.m_Buffer == VK_NULL_HANDLE)
+			return false;
+
+		table.vkCmdFillBuffer(commandBuffer, buffer->second.m_Buffer, offset, size, data);
+		return true;
+	}
+
+	case CaptureCommand::CmdCopyBuffer:
+	{
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		const auto bCommandBuffer = Resolve(m_CommandBuffers, reader.read<uint64_t>(), commandBuffer);
+		const auto source = m_Buffers.find(reader.read<uint64_t>());
+		const auto destination = m_Buffers.find(reader.read<uint64_t>());
+		const auto regions = reader.readArray<VkBufferCopy>();
+		if (!bCommandBuffer || source == m_Buffers.end() || destination == m_Buffers.end() || source->second.m_Buffer == VK_NULL_HANDLE || destination->second.m_Buffer == VK_NULL_HANDLE)
+			return false;
+
+		table.vkCmdCopyBuffer(commandBuffer, source->second.m_Buffer, destination->second.m_Buffer, static_cast<uint32_t>(regions.size()), regions.data());
+		return true;
+	}
+
+	case CaptureCommand::CmdCopyBufferToImage:
+	{
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		const auto bCommandBuffer = Resolve(m_CommandBuffers, reader.read<uint64_t>(), commandBuffer);
+		const auto source = m_Buffers.find(reader.read<uint64_t>());
+		const auto destination = m_Images.find(reader.read<uint64_t>());
+		const auto layout = reader.read<VkImageLayout>();
+		const auto regions = reader.readArray<VkBufferImageCopy>();
+		if (!bCommandBuffer || source == m_Buffers.end() || destination == m_Images.end() || source->second.m_Buffer == VK_NULL_HANDLE || destination->second.m_Image == VK_NULL_HANDLE)
+			return false;
+
+		table.vkCmdCopyBufferToImage(commandBuffer, source->second.m_Buffer, destination->second.m_Image, layout, static_cast<uint32_t>(regions.size()), regions.data());
+		return true;
+	}
+
+	case CaptureCommand::CmdCopyImage:
+	{
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		const auto bCommandBuffer = Resolve(m_CommandBuffers, reader.read<uint64_t>(), commandBuffer);
+		const auto source = m_Images.find(reader.read<uint64_t>());
+		const auto sourceLayout = reader.read<VkImageLayout>();
+		const auto destination = m_Images.find(reader.read<uint64_t>());
+		const auto destinationLayout = reader.read<VkImageLayout>();
+		const auto regions = reader.readArray<VkImageCopy>();
+		if (!bCommandBuffer || source == m_Images.end() || destination == m_Images.end() || source->second.m_Image == VK_NULL_HANDLE || destination->second.m_Image == VK_NULL_HANDLE)
+			return false;
+
+		table.vkCmdCopyImage(commandBuffer, source->second.m_Image, sourceLayout, destination->second.m_Image, destinationLayout, static_cast<uint32_t>(regions.size()), regions.data());
+		return true;
+	}
+
+	case CaptureCommand::CmdBlitImage:
+	{
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		const auto bCommandBuffer = Resolve(m_CommandBuffers, reader.read<uint64_t>(), commandBuffer);
+		const auto source = m_Images.find(reader.read<uint64_t>());
+		const auto sourceLayout = reader.read<VkImageLayout>();
+		const auto destination = m_Images.find(reader.read<uint64_t>());
+		const auto destinationLayout = reader.read<VkImageLayout>();
+		const auto regions = reader.readArray<VkImageBlit>();
+		const auto filter = reader.read<VkFilter>();
+		if (!bCommandBuffer || source == m_Images.end() || destination == m_Images.end() || source->second.m_Image == VK_NULL_HANDLE || destination->second.m_Image == VK_NULL_HANDLE)
+			return false;
+
+		table.vkCmdBlitImage(commandBuffer, source->second.m_Image, sourceLayout, destination->second.m_Image, destinationLayout, static_cast<uint32_t>(regions.size()), regions.data(), filter);
+		return true;
+	}
+
+	case CaptureCommand::CmdPipelineBarrier:
+	{
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		const auto bCommandBuffer = Resolve(m_CommandBuffers, reader.read<uint64_t>(), commandBuffer);
+
+		VkDependencyInfoKHR dependencyInfo = {};
+		dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+		dependencyInfo.pNext = nullptr;
+		dependencyInfo.dependencyFlags = reader.read<VkDependencyFlags>();
+
+		bool bIsComplete = bCommandBuffer;
+		std::vector<VkMemoryBarrier2KHR> memoryBarriers(reader.readCount(g_MemoryBarrierSize));
+		for (auto& barrier : memoryBarriers)
+		{
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2_KHR;
+			barrier.pNext = nullptr;
+			barrier.srcStageMask = reader.read<VkPipelineStageFlags2KHR>();
+			barrier.srcAccessMask = reader.read<VkAccessFlags2KHR>();
+			barrier.dstStageMask = reader.read<VkPipelineStageFlags2KHR>();
+			barrier.dstAccessMask = reader.read<VkAccessFlags2KHR>();
+		}
+
+		std::vector<VkBufferMemoryBarrier2KHR> bufferBarriers(reader.readCount(g_BufferBarrierSize));
+		for (auto& barrier : bufferBarriers)
+		{
+			barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR;
+			barrier.pNext = nullptr;
+			barrier.srcStageMask = reader.read<VkPipelineStageFlags2KHR>();
+			barrier.srcAccessMask = reader.read<VkAccessFlags2KHR>();
+			barrier.dstStageMask = reader.read<VkPipelineStageFlags2KHR>();
+			barrier.dstAccessMask = reader.read<VkAccessFlags2KHR>();
+			barrier.srcQueueFamilyIndex = getQueueFamily(reader.read<uint8_t>());
+			barrier.dstQueueFamilyIndex = getQueueFamily(reader.read<uint8_t>());
+
+			const auto buffer = m_Buffers.find(reader.read<uint64_t>());
+			bIsComplete &= buffer != m_Buffers.end() && buffer->second.m_Buffer != VK_NULL_HANDLE;
+			barrier.buffer = bIsComplete ? buffer->second.m_Buffer : VK_NULL_HANDLE;
+			barrier.offset = reader.read<VkDeviceSize>();
+			barrier.size = reader.read<VkDeviceSize>();
+		}
+
+		std::vector<VkImageMemoryBarrier2KHR> imageBarriers(reader.readCount(g_ImageBarrierSize));
+		for (auto& barrier : imageBarriers)
+		{
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+			barrier.pNext = nullptr;
+			barrier.srcStageMask = reader.read<VkPipelineStageFlags2KHR>();
+			barrier.srcAccessMask = reader.read<VkAccessFlags2KHR>();
+			barrier.dstStageMask = reader.read<VkPipelineStageFlags2KHR>();
+			barrier.dstAccessMask = reader.read<VkAccessFlags2KHR>();
+			barrier.oldLayout = reader.read<VkImageLayout>();
+			barrier.newLayout = reader.read<VkImageLayout>();
+			barrier.srcQueueFamilyIndex = getQueueFamily(reader.read<uint8_t>());
+			barrier.dstQueueFamilyIndex = getQueueFamily(reader.read<uint8_t>());
+
+			const auto image = m_Images.find(reader.read<uint64_t>());
+			bIsComplete &= image != m_Images.end() && image->second.m_Image != VK_NULL_HANDLE;
+			barrier.image = bIsComplete ? image->second.m_Image : VK_NULL_HANDLE;
+			barrier.subresourceRange = reader.read<VkImageSubresourceRange>();
+		}
+
+		if (!bIsComplete || reader.hasOverflowed())
+			return false;
+
+		dependencyInfo.memoryBarrierCount = static_cast<uint32_t>(memoryBarriers.size());
+		dependencyInfo.pMemoryBarriers = memoryBarriers.data();
+		dependencyInfo.bufferMemoryBarrierCount = static_cast<uint32_t>(bufferBarriers.size());
+		dependencyInfo.pBufferMemoryBarriers = bufferBarriers.data();
+		dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(imageBarriers.size());
+		dependencyInfo.pImageMemoryBarriers = imageBarriers.data();
+
+		table.vkCmdPipelineBarrier2KHR(commandBuffer, &dependencyInfo);
+		return true;
+	}
+
+	case CaptureCommand::CmdResetQueryPool:
+	{
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		VkQueryPool queryPool = VK_NULL_HANDLE;
+		const auto bCommandBuffer = Resolve(m_CommandBuffers, reader.read<uint64_t>(), commandBuffer);
+		if (!bCommandBuffer || !Resolve(m_QueryPools, reader.read<uint64_t>(), queryPool))
+			return false;
+
+		const auto firstQuery = reader.read<uint32_t>();
+		const auto queryCount = reader.read<uint32_t>();
+		table.vkCmdResetQueryPool(commandBuffer, queryPool, firstQuery, queryCount);
+		return true;
+	}
+
+	case CaptureCommand::CmdWriteTimestamp:
+	{
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		VkQueryPool queryPool = VK_NULL_HANDLE;
+		const auto bCommandBuffer = Resolve(m_CommandBuffers, reader.read<uint64_t>(), commandBuffer);
+		const auto stage = reader.read<VkPipelineStageFlagBits>();
+		if (!bCommandBuffer || !Resolve(m_QueryPools, reader.read<uint64_t>(), queryPool))
+			return false;
+
+		table.vkCmdWriteTimestamp(commandBuffer, stage, queryPool, reader.read<uint32_t>());
+		return true;
+	}
+
+	default:
+		return false;
+	}
+}
+
+void CaptureReplayer::createBuffer(ReplayBuffer& buffer, VkMemoryPropertyFlags propertyFlags)
+{
+	// Only the host access has to match, the device locality is just a preference since the device might not have such memory.
+	VmaAllocationCreateInfo allocationCreateInfo = {};
+	allocationCreateInfo.usage = VMA_MEMORY_USAGE_UNKNOWN;
+	allocationCreateInfo.requiredFlags = propertyFlags & (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	allocationCreateInfo.preferredFlags = propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+	if (propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+		allocationCreateInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+	VmaAllocationInfo allocationInfo = {};
+	m_Instance.getAllocator().access([&buffer, &allocationCreateInfo, &allocationInfo](VmaAllocator allocator)
+		{
+			GRAPHITE_VK_ASSERT(vmaCreateBuffer(allocator, &buffer.m_CreateInfo, &allocationCreateInfo, &buffer.m_Buffer, &buffer.m_Allocation, &allocationInfo), "Failed to create the replayed buffer!");
+		}
+	);
+
+	// The capture compares the first host writes against zeros.
+	buffer.m_pData = static_cast<std::byte*>(allocationInfo.pMappedData);
+	if (buffer.m_pData)
+		std::memset(buffer.m_pData, 0, static_cast<size_t>(buffer.m_CreateInfo.size));
+}
+
+void CaptureReplayer::createImage(ReplayImage& image, VkMemoryPropertyFlags propertyFlags)
+{
+	VmaAllocationCreateInfo allocationCreateInfo = {};
+	allocationCreateInfo.usage = VMA_MEMORY_USAGE_UNKNOWN;
+	allocationCreateInfo.requiredFlags = propertyFlags & (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	allocationCreateInfo.preferredFlags = propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+	m_Instance.getAllocator().access([&image, &allocationCreateInfo](VmaAllocator allocator)
+		{
+			GRAPHITE_VK_ASSERT(vmaCreateImage(allocator, &image.m_CreateInfo, &allocationCreateInfo, &image.m_Image, &image.m_Allocation, nullptr), "Failed to create the replayed image!");
+		}
+	);
+}
+
+void CaptureReplayer::waitForSubmissions()
+{
+	if (!m_bHasSubmissions)
+		return;
+
+	m_Instance.waitIdle();
+	m_bHasSubmissions = false;
+}
+
+void CaptureReplayer::destroyAll()
+{
+	m_Instance.waitIdle();
+
+	const auto& table = m_Instance.getDeviceTable();
+	const auto logicalDevice = m_Instance.getLogicalDevice().getUnsafe();
+
+	// The descriptor sets and the command buffers are freed with their pools.
+	for (const auto& [id, pipeline] : m_Pipelines)
+		table.vkDestroyPipeline(logicalDevice, pipeline, nullptr);
+
+	for (const auto& [id, pipelineLayout] : m_PipelineLayouts)
+		table.vkDestroyPipelineLayout(logicalDevice, pipelineLayout, nullptr);
+
+	for (const auto& [id, setLayout] : m_SetLayouts)
+		table.vkDestroyDescriptorSetLayout(logicalDevice, setLayout, nullptr);
+
+	for (const auto& [id, shaderModule] : m_ShaderModules)
+		table.vkDestroyShaderModule(logicalDevice, shaderModule, nullptr);
+
+	for (const auto& [id, descriptorPool] : m_DescriptorPools)
+		table.vkDestroyDescriptorPool(logicalDevice, descriptorPool, nullptr);
+
+	for (const auto& [id, commandPool] : m_CommandPools)
+		table.vkDestroyCommandPool(logicalDevice, commandPool, nullptr);
+
+	for (const auto& [id, queryPool] : m_QueryPools)
+		table.vkDestroyQueryPool(logicalDevice, queryPool, nullptr);
+
+	for (const auto& [id, semaphore] : m_Semaphores)
+		table.vkDestroySemaphore(logicalDevice, semaphore, nullptr);
+
+	for (const auto& [id, imageView] : m_ImageViews)
+		table.vkDestroyImageView(logicalDevice, imageView, nullptr);
+
+	m_Instance.getAllocator().access([this](VmaAllocator allocator)
+		{
+			for (const auto& [id, image] : m_Images)
+			{
+				if (image.m_Image != VK_NULL_HANDLE)
+					vmaDestroyImage(allocator, image.m_Image, image.m_Allocation);
+			}
+
+			for (const auto& [id, buffer] : m_Buffers)
+			{
+				if (buffer.m_Buffer != VK_NULL_HANDLE)
+					vmaDestroyBuffer(allocator, buffer.m_Buffer, buffer.m_Allocation);
+			}
+		}
+	);
+}
+
+uint32_t CaptureReplayer::getQueueFamily(uint8_t queueType) const
+{
+	if (queueType >= 3)
+		return VK_QUEUE_FAMILY_IGNORED;
+
+	return m_Instance.getQueue(static_cast<QueueType>(queueType)).getUnsafe().m_Family;
+}
@@ -0,0 +1,156 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "InstanceBoundObject.hpp"
+#include "CommandCapture.hpp"
+
+#include "Core/FrameStatistics.hpp"
+
+#include <volk.h>
+
+#include <filesystem>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Capture replayer class.
+ * This executes a capture file recorded by the command capture on the instance's device, without the engine.
+ *
+ * The captured handles are mapped to the handles the replayer creates. Buffers and images are created when their memory binding is replayed, using
+ * memory with the recorded properties. The host waits of the engine are not recorded, so the replayer waits for the device before it touches
+ * anything the submitted work might use. Records which reference unknown handles are skipped and counted.
+ *
+ * The work before the first frame marker contains the loading and is not measured. Each frame after that is measured from the previous marker
+ * till the device is idle at it's own marker.
+ */
+class CaptureReplayer final : public InstanceBoundObject
+{
+	/**
+	 * Replay buffer structure.
+	 * The buffer is created when it's bound, since the memory properties are only known then.
+	 */
+	struct ReplayBuffer final
+	{
+		VkBufferCreateInfo m_CreateInfo = {};
+
+		VkBuffer m_Buffer = VK_NULL_HANDLE;
+		VmaAllocation m_Allocation = nullptr;
+		std::byte* m_pData = nullptr;
+	};
+
+	/**
+	 * Replay image structure.
+	 * The image is created when it's bound, since the memory properties are only known then.
+	 */
+	struct ReplayImage final
+	{
+		VkImageCreateInfo m_CreateInfo = {};
+
+		VkImage m_Image = VK_NULL_HANDLE;
+		VmaAllocation m_Allocation = nullptr;
+	};
+
+	template<class Type>
+	using HandleMap = std::unordered_map<uint64_t, Type>;
+
+public:
+	/**
+	 * Explicit constructor.
+	 *
+	 * @param instance The instance reference. The device must be created.
+	 * @param path The capture file path.
+	 */
+	explicit CaptureReplayer(Instance& instance, const std::filesystem::path& path);
+
+	/**
+	 * Destructor.
+	 * This destroys everything the capture did not destroy itself.
+	 */
+	~CaptureReplayer() override;
+
+	/**
+	 * Check if the capture file was loaded.
+	 *
+	 * @return True if the capture can be replayed.
+	 */
+	[[nodiscard]] bool isValid() const { return !m_Data.empty(); }
+
+	/**
+	 * Replay the capture.
+	 *
+	 * @param statistics The statistics to record the frame times to.
+	 * @return True if the whole capture was replayed. False if the file is truncated.
+	 */
+	bool replay(FrameStatistics& statistics);
+
+public:
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint64_t, RecordCount, m_RecordCount);
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint64_t, SkippedCount, m_SkippedCount);
+
+private:
+	/**
+	 * Execute a single record.
+	 *
+	 * @param command The record command.
+	 * @param reader The payload reader.
+	 * @return False if the record was skipped.
+	 */
+	bool execute(CaptureCommand command, CaptureReader& reader);
+
+	/**
+	 * Create a buffer with memory of the recorded properties.
+	 *
+	 * @param buffer The replay buffer.
+	 * @param propertyFlags The memory properties the buffer was bound to.
+	 */
+	void createBuffer(ReplayBuffer& buffer, VkMemoryPropertyFlags propertyFlags);
+
+	/**
+	 * Create an image with memory of the recorded properties.
+	 *
+	 * @param image The replay image.
+	 * @param propertyFlags The memory properties the image was bound to.
+	 */
+	void createImage(ReplayImage& image, VkMemoryPropertyFlags propertyFlags);
+
+	/**
+	 * Wait till the submitted work is done, if there's any.
+	 */
+	void waitForSubmissions();
+
+	/**
+	 * Destroy all the remaining objects.
+	 */
+	void destroyAll();
+
+	/**
+	 * Get the queue family of a recorded queue type.
+	 *
+	 * @param queueType The recorded queue type.
+	 * @return The queue family. VK_QUEUE_FAMILY_IGNORED if the type is not a queue type.
+	 */
+	[[nodiscard]] uint32_t getQueueFamily(uint8_t queueType) const;
+
+private:
+	std::vector<std::byte> m_Data;
+
+	HandleMap<ReplayBuffer> m_Buffers;
+	HandleMap<ReplayImage> m_Images;
+	HandleMap<VkImageView> m_ImageViews;
+	HandleMap<VkShaderModule> m_ShaderModules;
+	HandleMap<VkDescriptorSetLayout> m_SetLayouts;
+	HandleMap<VkPipelineLayout> m_PipelineLayouts;
+	HandleMap<VkPipeline> m_Pipelines;
+	HandleMap<VkDescriptorPool> m_DescriptorPools;
+	HandleMap<VkDescriptorSet> m_DescriptorSets;
+	HandleMap<VkCommandPool> m_CommandPools;
+	HandleMap<VkCommandBuffer> m_CommandBuffers;
+	HandleMap<VkQueryPool> m_QueryPools;
+	HandleMap<VkSemaphore> m_Semaphores;
+
+	uint64_t m_RecordCount = 0;
+	uint64_t m_SkippedCount = 0;
+
+	bool m_bHasSubmissions = false;
+};
@@ -0,0 +1,1003 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "CommandCapture.hpp"
+#include "Instance.hpp"
+
+#include "Core/Logging.hpp"
+
+#include <algorithm>
+
+namespace /* anonymous */
+{
+	constexpr char g_Magic[4] = { 'G', 'C', 'A', 'P' };
+	constexpr uint32_t g_Version = 1;
+
+	// The queue type written for the ignored queue families and the queues the engine does not use.
+	constexpr uint8_t g_NoQueueType = 0xFF;
+
+	// The capture the hooks record to.
+	CommandCapture* g_pCapture = nullptr;
+
+	/**
+	 * Find a structure in a pNext chain.
+	 *
+	 * @tparam Type The structure type.
+	 * @param pNext The chain to search.
+	 * @param structureType The structure type enum value.
+	 * @return The structure pointer. nullptr if it's not in the chain.
+	 */
+	template<class Type>
+	[[nodiscard]] const Type* FindInChain(const void* pNext, VkStructureType structureType)
+	{
+		for (auto pStructure = static_cast<const VkBaseInStructure*>(pNext); pStructure; pStructure = pStructure->pNext)
+		{
+			if (pStructure->sType == structureType)
+				return reinterpret_cast<const Type*>(pStructure);
+		}
+
+		return nullptr;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL CaptureAllocateMemory(VkDevice device, const VkMemoryAllocateInfo* pAllocateInfo, const VkAllocationCallbacks* pAllocator, VkDeviceMemory* pMemory)
+	{
+		const auto result = g_pCapture->getTable().vkAllocateMemory(device, pAllocateInfo, pAllocator, pMemory);
+		if (result == VK_SUCCESS)
+			g_pCapture->trackMemory(*pMemory, pAllocateInfo->memoryTypeIndex);
+
+		return result;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CaptureFreeMemory(VkDevice device, VkDeviceMemory memory, const VkAllocationCallbacks* pAllocator)
+	{
+		g_pCapture->untrackMemory(memory);
+		g_pCapture->getTable().vkFreeMemory(device, memory, pAllocator);
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL CaptureMapMemory(VkDevice device, VkDeviceMemory memory, VkDeviceSize offset, VkDeviceSize size, VkMemoryMapFlags flags, void** ppData)
+	{
+		const auto result = g_pCapture->getTable().vkMapMemory(device, memory, offset, size, flags, ppData);
+		if (result == VK_SUCCESS)
+			g_pCapture->trackMapping(memory, offset, *ppData);
+
+		return result;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CaptureUnmapMemory(VkDevice device, VkDeviceMemory memory)
+	{
+		g_pCapture->untrackMapping(memory);
+		g_pCapture->getTable().vkUnmapMemory(device, memory);
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL CaptureCreateBuffer(VkDevice device, const VkBufferCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkBuffer* pBuffer)
+	{
+		const auto result = g_pCapture->getTable().vkCreateBuffer(device, pCreateInfo, pAllocator, pBuffer);
+		if (result == VK_SUCCESS)
+		{
+			g_pCapture->trackBuffer(*pBuffer, *pCreateInfo);
+			g_pCapture->write(CaptureRecord(CaptureCommand::CreateBuffer).write(*pBuffer).write(pCreateInfo->flags).write(pCreateInfo->size).write(pCreateInfo->usage));
+		}
+
+		return result;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CaptureDestroyBuffer(VkDevice device, VkBuffer buffer, const VkAllocationCallbacks* pAllocator)
+	{
+		if (buffer != VK_NULL_HANDLE)
+		{
+			g_pCapture->untrackBuffer(buffer);
+			g_pCapture->write(CaptureRecord(CaptureCommand::DestroyBuffer).write(buffer));
+		}
+
+		g_pCapture->getTable().vkDestroyBuffer(device, buffer, pAllocator);
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL CaptureBindBufferMemory(VkDevice device, VkBuffer buffer, VkDeviceMemory memory, VkDeviceSize offset)
+	{
+		const auto result = g_pCapture->getTable().vkBindBufferMemory(device, buffer, memory, offset);
+		if (result == VK_SUCCESS)
+			g_pCapture->bindBuffer(buffer, memory, offset);
+
+		return result;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL CaptureBindBufferMemory2KHR(VkDevice device, uint32_t bindInfoCount, const VkBindBufferMemoryInfo* pBindInfos)
+	{
+		const auto result = g_pCapture->getTable().vkBindBufferMemory2KHR(device, bindInfoCount, pBindInfos);
+		if (result == VK_SUCCESS)
+		{
+			for (uint32_t i = 0; i < bindInfoCount; i++)
+				g_pCapture->bindBuffer(pBindInfos[i].buffer, pBindInfos[i].memory, pBindInfos[i].memoryOffset);
+		}
+
+		return result;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL CaptureCreateImage(VkDevice device, const VkImageCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkImage* pImage)
+	{
+		const auto result = g_pCapture->getTable().vkCreateImage(device, pCreateInfo, pAllocator, pImage);
+		if (result == VK_SUCCESS)
+		{
+			g_pCapture->write(CaptureRecord(CaptureCommand::CreateImage)
+				.write(*pImage)
+				.write(pCreateInfo->flags)
+				.write(pCreateInfo->imageType)
+				.write(pCreateInfo->format)
+				.write(pCreateInfo->extent)
+				.write(pCreateInfo->mipLevels)
+				.write(pCreateInfo->arrayLayers)
+				.write(pCreateInfo->samples)
+				.write(pCreateInfo->tiling)
+				.write(pCreateInfo->usage)
+				.write(pCreateInfo->initialLayout));
+		}
+
+		return result;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CaptureDestroyImage(VkDevice device, VkImage image, const VkAllocationCallbacks* pAllocator)
+	{
+		if (image != VK_NULL_HANDLE)
+			g_pCapture->write(CaptureRecord(CaptureCommand::DestroyImage).write(image));
+
+		g_pCapture->getTable().vkDestroyImage(device, image, pAllocator);
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL CaptureBindImageMemory(VkDevice device, VkImage image, VkDeviceMemory memory, VkDeviceSize offset)
+	{
+		const auto result = g_pCapture->getTable().vkBindImageMemory(device, image, memory, offset);
+		if (result == VK_SUCCESS)
+			g_pCapture->bindImage(image, memory);
+
+		return result;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL CaptureBindImageMemory2KHR(VkDevice device, uint32_t bindInfoCount, const VkBindImageMemoryInfo* pBindInfos)
+	{
+		const auto result = g_pCapture->getTable().vkBindImageMemory2KHR(device, bindInfoCount, pBindInfos);
+		if (result == VK_SUCCESS)
+		{
+			for (uint32_t i = 0; i < bindInfoCount; i++)
+				g_pCapture->bindImage(pBindInfos[i].image, pBindInfos[i].memory);
+		}
+
+		return result;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL CaptureCreateImageView(VkDevice device, const VkImageViewCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkImageView* pView)
+	{
+		const auto result = g_pCapture->getTable().vkCreateImageView(device, pCreateInfo, pAllocator, pView);
+		if (result == VK_SUCCESS)
+		{
+			g_pCapture->write(CaptureRecord(CaptureCommand::CreateImageView)
+				.write(*pView)
+				.write(pCreateInfo->image)
+				.write(pCreateInfo->viewType)
+				.write(pCreateInfo->format)
+				.write(pCreateInfo->components)
+				.write(pCreateInfo->subresourceRange));
+		}
+
+		return result;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CaptureDestroyImageView(VkDevice device, VkImageView imageView, const VkAllocationCallbacks* pAllocator)
+	{
+		if (imageView != VK_NULL_HANDLE)
+			g_pCapture->write(CaptureRecord(CaptureCommand::DestroyImageView).write(imageView));
+
+		g_pCapture->getTable().vkDestroyImageView(device, imageView, pAllocator);
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL CaptureCreateShaderModule(VkDevice device, const VkShaderModuleCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkShaderModule* pShaderModule)
+	{
+		const auto result = g_pCapture->getTable().vkCreateShaderModule(device, pCreateInfo, pAllocator, pShaderModule);
+		if (result == VK_SUCCESS)
+		{
+			g_pCapture->write(CaptureRecord(CaptureCommand::CreateShaderModule)
+				.write(*pShaderModule)
+				.writeArray(std::span<const uint32_t>(pCreateInfo->pCode, pCreateInfo->codeSize / sizeof(uint32_t))));
+		}
+
+		return result;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CaptureDestroyShaderModule(VkDevice device, VkShaderModule shaderModule, const VkAllocationCallbacks* pAllocator)
+	{
+		if (shaderModule != VK_NULL_HANDLE)
+			g_pCapture->write(CaptureRecord(CaptureCommand::DestroyShaderModule).write(shaderModule));
+
+		g_pCapture->getTable().vkDestroyShaderModule(device, shaderModule, pAllocator);
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL CaptureCreateDescriptorSetLayout(VkDevice device, const VkDescriptorSetLayoutCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkDescriptorSetLayout* pSetLayout)
+	{
+		const auto result = g_pCapture->getTable().vkCreateDescriptorSetLayout(device, pCreateInfo, pAllocator, pSetLayout);
+		if (result == VK_SUCCESS)
+		{
+			// The immutable samplers are not recorded, the engine does not use any.
+			auto record = CaptureRecord(CaptureCommand::CreateDescriptorSetLayout);
+			record.write(*pSetLayout).write(pCreateInfo->flags).write(pCreateInfo->bindingCount);
+
+			for (uint32_t i = 0; i < pCreateInfo->bindingCount; i++)
+			{
+				const auto& binding = pCreateInfo->pBindings[i];
+				record.write(binding.binding).write(binding.descriptorType).write(binding.descriptorCount).write(binding.stageFlags);
+			}
+
+			g_pCapture->write(record);
+		}
+
+		return result;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CaptureDestroyDescriptorSetLayout(VkDevice device, VkDescriptorSetLayout setLayout, const VkAllocationCallbacks* pAllocator)
+	{
+		if (setLayout != VK_NULL_HANDLE)
+			g_pCapture->write(CaptureRecord(CaptureCommand::DestroyDescriptorSetLayout).write(setLayout));
+
+		g_pCapture->getTable().vkDestroyDescriptorSetLayout(device, setLayout, pAllocator);
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL CaptureCreatePipelineLayout(VkDevice device, const VkPipelineLayoutCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkPipelineLayout* pPipelineLayout)
+	{
+		const auto result = g_pCapture->getTable().vkCreatePipelineLayout(device, pCreateInfo, pAllocator, pPipelineLayout);
+		if (result == VK_SUCCESS)
+		{
+			g_pCapture->write(CaptureRecord(CaptureCommand::CreatePipelineLayout)
+				.write(*pPipelineLayout)
+				.writeArray(std::span<const VkDescriptorSetLayout>(pCreateInfo->pSetLayouts, pCreateInfo->setLayoutCount))
+				.writeArray(std::span<const VkPushConstantRange>(pCreateInfo->pPushConstantRanges, pCreateInfo->pushConstantRangeCount)));
+		}
+
+		return result;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CaptureDestroyPipelineLayout(VkDevice device, VkPipelineLayout pipelineLayout, const VkAllocationCallbacks* pAllocator)
+	{
+		if (pipelineLayout != VK_NULL_HANDLE)
+			g_pCapture->write(CaptureRecord(CaptureCommand::DestroyPipelineLayout).write(pipelineLayout));
+
+		g_pCapture->getTable().vkDestroyPipelineLayout(device, pipelineLayout, pAllocator);
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL CaptureCreateComputePipelines(VkDevice device, VkPipelineCache pipelineCache, uint32_t createInfoCount, const VkComputePipelineCreateInfo* pCreateInfos, const VkAllocationCallbacks* pAllocator, VkPipeline* pPipelines)
+	{
+		const auto result = g_pCapture->getTable().vkCreateComputePipelines(device, pipelineCache, createInfoCount, pCreateInfos, pAllocator, pPipelines);
+		if (result != VK_SUCCESS)
+			return result;
+
+		// The pipeline cache is not recorded, the replayer compiles the pipelines from scratch.
+		for (uint32_t i = 0; i < createInfoCount; i++)
+		{
+			const auto& createInfo = pCreateInfos[i];
+			const auto pSpecialization = createInfo.stage.pSpecializationInfo;
+
+			auto record = CaptureRecord(CaptureCommand::CreateComputePipeline);
+			record.write(pPipelines[i]).write(createInfo.flags).write(createInfo.layout).write(createInfo.stage.module).writeString(createInfo.stage.pName);
+
+			if (pSpecialization)
+			{
+				record.writeArray(std::span<const VkSpecializationMapEntry>(pSpecialization->pMapEntries, pSpecialization->mapEntryCount));
+				record.writeArray(std::span<const std::byte>(static_cast<const std::byte*>(pSpecialization->pData), pSpecialization->dataSize));
+			}
+			else
+			{
+				record.write(0u).write(0u);
+			}
+
+			g_pCapture->write(record);
+		}
+
+		return result;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL CaptureCreateGraphicsPipelines(VkDevice device, VkPipelineCache pipelineCache, uint32_t createInfoCount, const VkGraphicsPipelineCreateInfo* pCreateInfos, const VkAllocationCallbacks* pAllocator, VkPipeline* pPipelines)
+	{
+		const auto result = g_pCapture->getTable().vkCreateGraphicsPipelines(device, pipelineCache, createInfoCount, pCreateInfos, pAllocator, pPipelines);
+		if (result != VK_SUCCESS)
+			return result;
+
+		// The draws can't be replayed headless, so the pipelines are only tracked to drop their binds.
+		for (uint32_t i = 0; i < createInfoCount; i++)
+			g_pCapture->setPipelineRecorded(pPipelines[i], false);
+
+		return result;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CaptureDestroyPipeline(VkDevice device, VkPipeline pipeline, const VkAllocationCallbacks* pAllocator)
+	{
+		if (!g_pCapture->isPipelineRecorded(pipeline))
+			g_pCapture->setPipelineRecorded(pipeline, true);
+
+		else if (pipeline != VK_NULL_HANDLE)
+			g_pCapture->write(CaptureRecord(CaptureCommand::DestroyPipeline).write(pipeline));
+
+		g_pCapture->getTable().vkDestroyPipeline(device, pipeline, pAllocator);
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL CaptureCreateDescriptorPool(VkDevice device, const VkDescriptorPoolCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkDescriptorPool* pDescriptorPool)
+	{
+		const auto result = g_pCapture->getTable().vkCreateDescriptorPool(device, pCreateInfo, pAllocator, pDescriptorPool);
+		if (result == VK_SUCCESS)
+		{
+			g_pCapture->write(CaptureRecord(CaptureCommand::CreateDescriptorPool)
+				.write(*pDescriptorPool)
+				.write(pCreateInfo->flags)
+				.write(pCreateInfo->maxSets)
+				.writeArray(std::span<const VkDescriptorPoolSize>(pCreateInfo->pPoolSizes, pCreateInfo->poolSizeCount)));
+		}
+
+		return result;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CaptureDestroyDescriptorPool(VkDevice device, VkDescriptorPool descriptorPool, const VkAllocationCallbacks* pAllocator)
+	{
+		if (descriptorPool != VK_NULL_HANDLE)
+			g_pCapture->write(CaptureRecord(CaptureCommand::DestroyDescriptorPool).write(descriptorPool));
+
+		g_pCapture->getTable().vkDestroyDescriptorPool(device, descriptorPool, pAllocator);
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL CaptureAllocateDescriptorSets(VkDevice device, const VkDescriptorSetAllocateInfo* pAllocateInfo, VkDescriptorSet* pDescriptorSets)
+	{
+		const auto result = g_pCapture->getTable().vkAllocateDescriptorSets(device, pAllocateInfo, pDescriptorSets);
+		if (result == VK_SUCCESS)
+		{
+			g_pCapture->write(CaptureRecord(CaptureCommand::AllocateDescriptorSets)
+				.write(pAllocateInfo->descriptorPool)
+				.writeArray(std::span<const VkDescriptorSetLayout>(pAllocateInfo->pSetLayouts, pAllocateInfo->descriptorSetCount))
+				.writeArray(std::span<const VkDescriptorSet>(pDescriptorSets, pAllocateInfo->descriptorSetCount)));
+		}
+
+		return result;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CaptureUpdateDescriptorSets(VkDevice device, uint32_t descriptorWriteCount, const VkWriteDescriptorSet* pDescriptorWrites, uint32_t descriptorCopyCount, const VkCopyDescriptorSet* pDescriptorCopies)
+	{
+		// The descriptor copies are not recorded, the engine does not use any.
+		auto record = CaptureRecord(CaptureCommand::UpdateDescriptorSets);
+		record.write(descriptorWriteCount);
+
+		for (uint32_t i = 0; i < descriptorWriteCount; i++)
+		{
+			const auto& write = pDescriptorWrites[i];
+			record.write(write.dstSet).write(write.dstBinding).write(write.dstArrayElement).write(write.descriptorType).write(write.descriptorCount);
+
+			for (uint32_t j = 0; j < write.descriptorCount; j++)
+			{
+				switch (write.descriptorType)
+				{
+				case VK_DESCRIPTOR_TYPE_SAMPLER:
+				case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+				case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+				case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+				case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+					record.write(write.pImageInfo[j].sampler).write(write.pImageInfo[j].imageView).write(write.pImageInfo[j].imageLayout);
+					break;
+
+				default:
+					record.write(write.pBufferInfo[j].buffer).write(write.pBufferInfo[j].offset).write(write.pBufferInfo[j].range);
+					break;
+				}
+			}
+		}
+
+		g_pCapture->write(record);
+		g_pCapture->getTable().vkUpdateDescriptorSets(device, descriptorWriteCount, pDescriptorWrites, descriptorCopyCount, pDescriptorCopies);
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL CaptureCreateCommandPool(VkDevice device, const VkCommandPoolCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkCommandPool* pCommandPool)
+	{
+		const auto result = g_pCapture->getTable().vkCreateCommandPool(device, pCreateInfo, pAllocator, pCommandPool);
+		if (result == VK_SUCCESS)
+			g_pCapture->write(CaptureRecord(CaptureCommand::CreateCommandPool).write(*pCommandPool).write(pCreateInfo->flags).write(g_pCapture->getQueueType(pCreateInfo->queueFamilyIndex)));
+
+		return result;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CaptureDestroyCommandPool(VkDevice device, VkCommandPool commandPool, const VkAllocationCallbacks* pAllocator)
+	{
+		if (commandPool != VK_NULL_HANDLE)
+			g_pCapture->write(CaptureRecord(CaptureCommand::DestroyCommandPool).write(commandPool));
+
+		g_pCapture->getTable().vkDestroyCommandPool(device, commandPool, pAllocator);
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL CaptureAllocateCommandBuffers(VkDevice device, const VkCommandBufferAllocateInfo* pAllocateInfo, VkCommandBuffer* pCommandBuffers)
+	{
+		const auto result = g_pCapture->getTable().vkAllocateCommandBuffers(device, pAllocateInfo, pCommandBuffers);
+		if (result == VK_SUCCESS)
+		{
+			g_pCapture->write(CaptureRecord(CaptureCommand::AllocateCommandBuffers)
+				.write(pAllocateInfo->commandPool)
+				.write(pAllocateInfo->level)
+				.writeArray(std::span<const VkCommandBuffer>(pCommandBuffers, pAllocateInfo->commandBufferCount)));
+		}
+
+		return result;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL CaptureBeginCommandBuffer(VkCommandBuffer commandBuffer, const VkCommandBufferBeginInfo* pBeginInfo)
+	{
+		g_pCapture->write(CaptureRecord(CaptureCommand::BeginCommandBuffer).write(commandBuffer).write(pBeginInfo->flags));
+		return g_pCapture->getTable().vkBeginCommandBuffer(commandBuffer, pBeginInfo);
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL CaptureEndCommandBuffer(VkCommandBuffer commandBuffer)
+	{
+		g_pCapture->write(CaptureRecord(CaptureCommand::EndCommandBuffer).write(commandBuffer));
+		return g_pCapture->getTable().vkEndCommandBuffer(commandBuffer);
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL CaptureResetCommandBuffer(VkCommandBuffer commandBuffer, VkCommandBufferResetFlags flags)
+	{
+		g_pCapture->write(CaptureRecord(CaptureCommand::ResetCommandBuffer).write(commandBuffer).write(flags));
+		return g_pCapture->getTable().vkResetCommandBuffer(commandBuffer, flags);
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL CaptureCreateQueryPool(VkDevice device, const VkQueryPoolCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkQueryPool* pQueryPool)
+	{
+		const auto result = g_pCapture->getTable().vkCreateQueryPool(device, pCreateInfo, pAllocator, pQueryPool);
+		if (result == VK_SUCCESS)
+			g_pCapture->write(CaptureRecord(CaptureCommand::CreateQueryPool).write(*pQueryPool).write(pCreateInfo->queryType).write(pCreateInfo->queryCount).write(pCreateInfo->pipelineStatistics));
+
+		return result;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CaptureDestroyQueryPool(VkDevice device, VkQueryPool queryPool, const VkAllocationCallbacks* pAllocator)
+	{
+		if (queryPool != VK_NULL_HANDLE)
+			g_pCapture->write(CaptureRecord(CaptureCommand::DestroyQueryPool).write(queryPool));
+
+		g_pCapture->getTable().vkDestroyQueryPool(device, queryPool, pAllocator);
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL CaptureCreateSemaphore(VkDevice device, const VkSemaphoreCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkSemaphore* pSemaphore)
+	{
+		const auto result = g_pCapture->getTable().vkCreateSemaphore(device, pCreateInfo, pAllocator, pSemaphore);
+		if (result != VK_SUCCESS)
+			return result;
+
+		// Only the timeline semaphores are recorded. The binary semaphores are only used with the swapchain, which the replay does not have.
+		const auto pTypeCreateInfo = FindInChain<VkSemaphoreTypeCreateInfoKHR>(pCreateInfo->pNext, VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR);
+		if (pTypeCreateInfo && pTypeCreateInfo->semaphoreType == VK_SEMAPHORE_TYPE_TIMELINE_KHR)
+		{
+			g_pCapture->setSemaphoreRecorded(*pSemaphore, true);
+			g_pCapture->write(CaptureRecord(CaptureCommand::CreateSemaphore).write(*pSemaphore).write(pTypeCreateInfo->initialValue));
+		}
+
+		return result;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CaptureDestroySemaphore(VkDevice device, VkSemaphore semaphore, const VkAllocationCallbacks* pAllocator)
+	{
+		if (g_pCapture->isSemaphoreRecorded(semaphore))
+		{
+			g_pCapture->setSemaphoreRecorded(semaphore, false);
+			g_pCapture->write(CaptureRecord(CaptureCommand::DestroySemaphore).write(semaphore));
+		}
+
+		g_pCapture->getTable().vkDestroySemaphore(device, semaphore, pAllocator);
+	}
+
+	/**
+	 * Write the recorded semaphores of a submit.
+	 *
+	 * @param record The record to write to.
+	 * @param semaphores The semaphore submit infos.
+	 */
+	void WriteSubmitSemaphores(CaptureRecord& record, std::span<const VkSemaphoreSubmitInfoKHR> semaphores)
+	{
+		const auto count = GRAPHITE_RANGES(count_if, semaphores, [](const VkSemaphoreSubmitInfoKHR& info) { return g_pCapture->isSemaphoreRecorded(info.semaphore); });
+		record.write(static_cast<uint32_t>(count));
+
+		for (const auto& info : semaphores)
+		{
+			if (g_pCapture->isSemaphoreRecorded(info.semaphore))
+				record.write(info.semaphore).write(info.value).write(info.stageMask);
+		}
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL CaptureQueueSubmit2KHR(VkQueue queue, uint32_t submitCount, const VkSubmitInfo2KHR* pSubmits, VkFence fence)
+	{
+		// The host writes have to be in the file before the work which reads them.
+		g_pCapture->recordHostWrites();
+
+		auto record = CaptureRecord(CaptureCommand::QueueSubmit);
+		record.write(g_pCapture->getQueueType(queue)).write(submitCount);
+
+		for (uint32_t i = 0; i < submitCount; i++)
+		{
+			const auto& submit = pSubmits[i];
+			WriteSubmitSemaphores(record, std::span(submit.pWaitSemaphoreInfos, submit.waitSemaphoreInfoCount));
+
+			record.write(submit.commandBufferInfoCount);
+			for (uint32_t j = 0; j < submit.commandBufferInfoCount; j++)
+				record.write(submit.pCommandBufferInfos[j].commandBuffer);
+
+			WriteSubmitSemaphores(record, std::span(submit.pSignalSemaphoreInfos, submit.signalSemaphoreInfoCount));
+		}
+
+		g_pCapture->write(record);
+		return g_pCapture->getTable().vkQueueSubmit2KHR(queue, submitCount, pSubmits, fence);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CaptureCmdBindPipeline(VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint, VkPipeline pipeline)
+	{
+		if (g_pCapture->isPipelineRecorded(pipeline))
+			g_pCapture->write(CaptureRecord(CaptureCommand::CmdBindPipeline).write(commandBuffer).write(pipelineBindPoint).write(pipeline));
+
+		g_pCapture->getTable().vkCmdBindPipeline(commandBuffer, pipelineBindPoint, pipeline);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CaptureCmdBindDescriptorSets(
+		VkCommandBuffer commandBuffer,
+		VkPipelineBindPoint pipelineBindPoint,
+		VkPipelineLayout layout,
+		uint32_t firstSet,
+		uint32_t descriptorSetCount,
+		const VkDescriptorSet* pDescriptorSets,
+		uint32_t dynamicOffsetCount,
+		const uint32_t* pDynamicOffsets)
+	{
+		g_pCapture->write(CaptureRecord(CaptureCommand::CmdBindDescriptorSets)
+			.write(commandBuffer)
+			.write(pipelineBindPoint)
+			.write(layout)
+			.write(firstSet)
+			.writeArray(std::span<const VkDescriptorSet>(pDescriptorSets, descriptorSetCount))
+			.writeArray(std::span<const uint32_t>(pDynamicOffsets, dynamicOffsetCount)));
+
+		g_pCapture->getTable().vkCmdBindDescriptorSets(commandBuffer, pipelineBindPoint, layout, firstSet, descriptorSetCount, pDescriptorSets, dynamicOffsetCount, pDynamicOffsets);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CaptureCmdPushConstants(VkCommandBuffer commandBuffer, VkPipelineLayout layout, VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size, const void* pValues)
+	{
+		g_pCapture->write(CaptureRecord(CaptureCommand::CmdPushConstants)
+			.write(commandBuffer)
+			.write(layout)
+			.write(stageFlags)
+			.write(offset)
+			.writeArray(std::span<const std::byte>(static_cast<const std::byte*>(pValues), size)));
+
+		g_pCapture->getTable().vkCmdPushConstants(commandBuffer, layout, stageFlags, offset, size, pValues);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CaptureCmdDispatch(VkCommandBuffer commandBuffer, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+	{
+		g_pCapture->write(CaptureRecord(CaptureCommand::CmdDispatch).write(commandBuffer).write(groupCountX).write(groupCountY).write(groupCountZ));
+		g_pCapture->getTable().vkCmdDispatch(commandBuffer, groupCountX, groupCountY, groupCountZ);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CaptureCmdDispatchIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset)
+	{
+		g_pCapture->write(CaptureRecord(CaptureCommand::CmdDispatchIndirect).write(commandBuffer).write(buffer).write(offset));
+		g_pCapture->getTable().vkCmdDispatchIndirect(commandBuffer, buffer, offset);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CaptureCmdFillBuffer(VkCommandBuffer commandBuffer, VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize size, uint32_t data)
+	{
+		g_pCapture->write(CaptureRecord(CaptureCommand::CmdFillBuffer).write(commandBuffer).write(dstBuffer).write(dstOffset).write(size).write(data));
+		g_pCapture->getTable().vkCmdFillBuffer(commandBuffer, dstBuffer, dstOffset, size, data);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CaptureCmdCopyBuffer(VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkBuffer dstBuffer, uint32_t regionCount, const VkBufferCopy* pRegions)
+	{
+		g_pCapture->write(CaptureRecord(CaptureCommand::CmdCopyBuffer)
+			.write(commandBuffer)
+			.write(srcBuffer)
+			.write(dstBuffer)
+			.writeArray(std::span<const VkBufferCopy>(pRegions, regionCount)));
+
+		g_pCapture->getTable().vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, regionCount, pRegions);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CaptureCmdCopyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkImage dstImage, VkImageLayout dstImageLayout, uint32_t regionCount, const VkBufferImageCopy* pRegions)
+	{
+		g_pCapture->write(CaptureRecord(CaptureCommand::CmdCopyBufferToImage)
+			.write(commandBuffer)
+			.write(srcBuffer)
+			.write(dstImage)
+			.write(dstImageLayout)
+			.writeArray(std::span<const VkBufferImageCopy>(pRegions, regionCount)));
+
+		g_pCapture->getTable().vkCmdCopyBufferToImage(commandBuffer, srcBuffer, dstImage, dstImageLayout, regionCount, pRegions);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CaptureCmdCopyImage(
+		VkCommandBuffer commandBuffer,
+		VkImage srcImage,
+		VkImageLayout srcImageLayout,
+		VkImage dstImage,
+		VkImageLayout dstImageLayout,
+		uint32_t regionCount,
+		const VkImageCopy* pRegions)
+	{
+		g_pCapture->write(CaptureRecord(CaptureCommand::CmdCopyImage)
+			.write(commandBuffer)
+			.write(srcImage)
+			.write(srcImageLayout)
+			.write(dstImage)
+			.write(dstImageLayout)
+			.writeArray(std::span<const VkImageCopy>(pRegions, regionCount)));
+
+		g_pCapture->getTable().vkCmdCopyImage(commandBuffer, srcImage, srcImageLayout, dstImage, dstImageLayout, regionCount, pRegions);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CaptureCmdBlitImage(
+		VkCommandBuffer commandBuffer,
+		VkImage srcImage,
+		VkImageLayout srcImageLayout,
+		VkImage dstImage,
+		VkImageLayout dstImageLayout,
+		uint32_t regionCount,
+		const VkImageBlit* pRegions,
+		VkFilter filter)
+	{
+		g_pCapture->write(CaptureRecord(CaptureCommand::CmdBlitImage)
+			.write(commandBuffer)
+			.write(srcImage)
+			.write(srcImageLayout)
+			.write(dstImage)
+			.write(dstImageLayout)
+			.writeArray(std::span<const VkImageBlit>(pRegions, regionCount))
+			.write(filter));
+
+		g_pCapture->getTable().vkCmdBlitImage(commandBuffer, srcImage, srcImageLayout, dstImage, dstImageLayout, regionCount, pRegions, filter);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CaptureCmdPipelineBarrier2KHR(VkCommandBuffer commandBuffer, const VkDependencyInfoKHR* pDependencyInfo)
+	{
+		auto record = CaptureRecord(CaptureCommand::CmdPipelineBarrier);
+		record.write(commandBuffer).write(pDependencyInfo->dependencyFlags);
+
+		record.write(pDependencyInfo->memoryBarrierCount);
+		for (uint32_t i = 0; i < pDependencyInfo->memoryBarrierCount; i++)
+		{
+			const auto& barrier = pDependencyInfo->pMemoryBarriers[i];
+			record.write(barrier.srcStageMask).write(barrier.srcAccessMask).write(barrier.dstStageMask).write(barrier.dstAccessMask);
+		}
+
+		// The queue families are written as queue types, since the families differ between devices.
+		record.write(pDependencyInfo->bufferMemoryBarrierCount);
+		for (uint32_t i = 0; i < pDependencyInfo->bufferMemoryBarrierCount; i++)
+		{
+			const auto& barrier = pDependencyInfo->pBufferMemoryBarriers[i];
+			record.write(barrier.srcStageMask).write(barrier.srcAccessMask).write(barrier.dstStageMask).write(barrier.dstAccessMask)
+				.write(g_pCapture->getQueueType(barrier.srcQueueFamilyIndex))
+				.write(g_pCapture->getQueueType(barrier.dstQueueFamilyIndex))
+				.write(barrier.buffer)
+				.write(barrier.offset)
+				.write(barrier.size);
+		}
+
+		record.write(pDependencyInfo->imageMemoryBarrierCount);
+		for (uint32_t i = 0; i < pDependencyInfo->imageMemoryBarrierCount; i++)
+		{
+			const auto& barrier = pDependencyInfo->pImageMemoryBarriers[i];
+			record.write(barrier.srcStageMask).write(barrier.srcAccessMask).write(barrier.dstStageMask).write(barrier.dstAccessMask)
+				.write(barrier.oldLayout)
+				.write(barrier.newLayout)
+				.write(g_pCapture->getQueueType(barrier.srcQueueFamilyIndex))
+				.write(g_pCapture->getQueueType(barrier.dstQueueFamilyIndex))
+				.write(barrier.image)
+				.write(barrier.subresourceRange);
+		}
+
+		g_pCapture->write(record);
+		g_pCapture->getTable().vkCmdPipelineBarrier2KHR(commandBuffer, pDependencyInfo);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CaptureCmdResetQueryPool(VkCommandBuffer commandBuffer, VkQueryPool queryPool, uint32_t firstQuery, uint32_t queryCount)
+	{
+		g_pCapture->write(CaptureRecord(CaptureCommand::CmdResetQueryPool).write(commandBuffer).write(queryPool).write(firstQuery).write(queryCount));
+		g_pCapture->getTable().vkCmdResetQueryPool(commandBuffer, queryPool, firstQuery, queryCount);
+	}
+
+	VKAPI_ATTR void VKAPI_CALL CaptureCmdWriteTimestamp(VkCommandBuffer commandBuffer, VkPipelineStageFlagBits pipelineStage, VkQueryPool queryPool, uint32_t query)
+	{
+		g_pCapture->write(CaptureRecord(CaptureCommand::CmdWriteTimestamp).write(commandBuffer).write(pipelineStage).write(queryPool).write(query));
+		g_pCapture->getTable().vkCmdWriteTimestamp(commandBuffer, pipelineStage, queryPool, query);
+	}
+}
+
+CommandCapture::CommandCapture(Instance& instance, const std::filesystem::path& path)
+	: m_File(path, std::ios::binary | std::ios::trunc)
+	, m_Instance(instance)
+{
+	if (!m_File.is_open())
+	{
+		GRAPHITE_LOG_ERROR("Failed to open the capture file {}!", path.string());
+		return;
+	}
+
+	m_File.write(g_Magic, sizeof(g_Magic));
+	m_File.write(reinterpret_cast<const char*>(&g_Version), sizeof(g_Version));
+
+	vkGetPhysicalDeviceMemoryProperties(instance.getPhysicalDevice().getUnsafe(), &m_MemoryProperties);
+	GRAPHITE_LOG_INFORMATION("Capturing the submitted work to {}.", path.string());
+}
+
+CommandCapture::~CommandCapture()
+{
+	if (g_pCapture == this)
+		g_pCapture = nullptr;
+}
+
+void CommandCapture::install(VolkDeviceTable& deviceTable)
+{
+	if (!isValid())
+		return;
+
+	if (g_pCapture)
+	{
+		GRAPHITE_LOG_ERROR("Another capture is already active!");
+		return;
+	}
+
+	g_pCapture = this;
+	m_Table = deviceTable;
+
+	deviceTable.vkAllocateMemory = CaptureAllocateMemory;
+	deviceTable.vkFreeMemory = CaptureFreeMemory;
+	deviceTable.vkMapMemory = CaptureMapMemory;
+	deviceTable.vkUnmapMemory = CaptureUnmapMemory;
+	deviceTable.vkCreateBuffer = CaptureCreateBuffer;
+	deviceTable.vkDestroyBuffer = CaptureDestroyBuffer;
+	deviceTable.vkBindBufferMemory = CaptureBindBufferMemory;
+	deviceTable.vkCreateImage = CaptureCreateImage;
+	deviceTable.vkDestroyImage = CaptureDestroyImage;
+	deviceTable.vkBindImageMemory = CaptureBindImageMemory;
+	deviceTable.vkCreateImageView = CaptureCreateImageView;
+	deviceTable.vkDestroyImageView = CaptureDestroyImageView;
+	deviceTable.vkCreateShaderModule = CaptureCreateShaderModule;
+	deviceTable.vkDestroyShaderModule = CaptureDestroyShaderModule;
+	deviceTable.vkCreateDescriptorSetLayout = CaptureCreateDescriptorSetLayout;
+	deviceTable.vkDestroyDescriptorSetLayout = CaptureDestroyDescriptorSetLayout;
+	deviceTable.vkCreatePipelineLayout = CaptureCreatePipelineLayout;
+	deviceTable.vkDestroyPipelineLayout = CaptureDestroyPipelineLayout;
+	deviceTable.vkCreateComputePipelines = CaptureCreateComputePipelines;
+	deviceTable.vkCreateGraphicsPipelines = CaptureCreateGraphicsPipelines;
+	deviceTable.vkDestroyPipeline = CaptureDestroyPipeline;
+	deviceTable.vkCreateDescriptorPool = CaptureCreateDescriptorPool;
+	deviceTable.vkDestroyDescriptorPool = CaptureDestroyDescriptorPool;
+	deviceTable.vkAllocateDescriptorSets = CaptureAllocateDescriptorSets;
+	deviceTable.vkUpdateDescriptorSets = CaptureUpdateDescriptorSets;
+	deviceTable.vkCreateCommandPool = CaptureCreateCommandPool;
+	deviceTable.vkDestroyCommandPool = CaptureDestroyCommandPool;
+	deviceTable.vkAllocateCommandBuffers = CaptureAllocateCommandBuffers;
+	deviceTable.vkBeginCommandBuffer = CaptureBeginCommandBuffer;
+	deviceTable.vkEndCommandBuffer = CaptureEndCommandBuffer;
+	deviceTable.vkResetCommandBuffer = CaptureResetCommandBuffer;
+	deviceTable.vkCreateQueryPool = CaptureCreateQueryPool;
+	deviceTable.vkDestroyQueryPool = CaptureDestroyQueryPool;
+	deviceTable.vkCreateSemaphore = CaptureCreateSemaphore;
+	deviceTable.vkDestroySemaphore = CaptureDestroySemaphore;
+	deviceTable.vkCmdBindPipeline = CaptureCmdBindPipeline;
+	deviceTable.vkCmdBindDescriptorSets = CaptureCmdBindDescriptorSets;
+	deviceTable.vkCmdPushConstants = CaptureCmdPushConstants;
+	deviceTable.vkCmdDispatch = CaptureCmdDispatch;
+	deviceTable.vkCmdDispatchIndirect = CaptureCmdDispatchIndirect;
+	deviceTable.vkCmdFillBuffer = CaptureCmdFillBuffer;
+	deviceTable.vkCmdCopyBuffer = CaptureCmdCopyBuffer;
+	deviceTable.vkCmdCopyBufferToImage = CaptureCmdCopyBufferToImage;
+	deviceTable.vkCmdCopyImage = CaptureCmdCopyImage;
+	deviceTable.vkCmdBlitImage = CaptureCmdBlitImage;
+	deviceTable.vkCmdResetQueryPool = CaptureCmdResetQueryPool;
+	deviceTable.vkCmdWriteTimestamp = CaptureCmdWriteTimestamp;
+
+	// The extension functions are only hooked if they were loaded.
+	if (m_Table.vkBindBufferMemory2KHR)
+		deviceTable.vkBindBufferMemory2KHR = CaptureBindBufferMemory2KHR;
+
+	if (m_Table.vkBindImageMemory2KHR)
+		deviceTable.vkBindImageMemory2KHR = CaptureBindImageMemory2KHR;
+
+	if (m_Table.vkQueueSubmit2KHR)
+		deviceTable.vkQueueSubmit2KHR = CaptureQueueSubmit2KHR;
+
+	if (m_Table.vkCmdPipelineBarrier2KHR)
+		deviceTable.vkCmdPipelineBarrier2KHR = CaptureCmdPipelineBarrier2KHR;
+}
+
+void CommandCapture::markFrame()
+{
+	const auto lock = std::scoped_lock(m_Mutex);
+	writeLocked(CaptureRecord(CaptureCommand::Frame).write(m_FrameIndex++));
+}
+
+void CommandCapture::write(const CaptureRecord& record)
+{
+	const auto lock = std::scoped_lock(m_Mutex);
+	writeLocked(record);
+}
+
+uint8_t CommandCapture::getQueueType(uint32_t family) const
+{
+	for (uint8_t i = 0; i < 3; i++)
+	{
+		if (m_Instance.getQueue(static_cast<QueueType>(i)).getUnsafe().m_Family == family)
+			return i;
+	}
+
+	return g_NoQueueType;
+}
+
+uint8_t CommandCapture::getQueueType(VkQueue queue) const
+{
+	for (uint8_t i = 0; i < 3; i++)
+	{
+		if (m_Instance.getQueue(static_cast<QueueType>(i)).getUnsafe().m_Queue == queue)
+			return i;
+	}
+
+	return g_NoQueueType;
+}
+
+void CommandCapture::trackMemory(VkDeviceMemory memory, uint32_t memoryTypeIndex)
+{
+	const auto lock = std::scoped_lock(m_Mutex);
+	m_MemoryTypes[memory] = memoryTypeIndex;
+}
+
+void CommandCapture::untrackMemory(VkDeviceMemory memory)
+{
+	const auto lock = std::scoped_lock(m_Mutex);
+	m_MemoryTypes.erase(memory);
+	m_Mappings.erase(memory);
+}
+
+void CommandCapture::trackMapping(VkDeviceMemory memory, VkDeviceSize offset, void* pData)
+{
+	// Store the pointer to the start of the memory, so the buffer offsets can be used directly.
+	const auto lock = std::scoped_lock(m_Mutex);
+	m_Mappings[memory] = static_cast<std::byte*>(pData) - offset;
+}
+
+void CommandCapture::untrackMapping(VkDeviceMemory memory)
+{
+	const auto lock = std::scoped_lock(m_Mutex);
+	for (auto& [buffer, tracked] : m_Buffers)
+	{
+		if (tracked.m_Memory == memory)
+			recordHostWrites(buffer, tracked);
+	}
+
+	m_Mappings.erase(memory);
+}
+
+void CommandCapture::trackBuffer(VkBuffer buffer, const VkBufferCreateInfo& createInfo)
+{
+	// The GPU can write to storage buffers and transfer destinations, so those are not compared, otherwise the GPU's writes would be recorded
+	// as host writes.
+	TrackedBuffer tracked;
+	tracked.m_Size = createInfo.size;
+	tracked.m_bIsHostWritable = (createInfo.usage & (VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT)) == 0;
+
+	const auto lock = std::scoped_lock(m_Mutex);
+	m_Buffers[buffer] = std::move(tracked);
+}
+
+void CommandCapture::untrackBuffer(VkBuffer buffer)
+{
+	const auto lock = std::scoped_lock(m_Mutex);
+	m_Buffers.erase(buffer);
+}
+
+void CommandCapture::bindBuffer(VkBuffer buffer, VkDeviceMemory memory, VkDeviceSize offset)
+{
+	const auto lock = std::scoped_lock(m_Mutex);
+
+	const auto memoryType = m_MemoryTypes.find(memory);
+	const auto propertyFlags = memoryType != m_MemoryTypes.end() ? m_MemoryProperties.memoryTypes[memoryType->second].propertyFlags : 0;
+
+	if (const auto tracked = m_Buffers.find(buffer); tracked != m_Buffers.end())
+	{
+		tracked->second.m_Memory = memory;
+		tracked->second.m_Offset = offset;
+		tracked->second.m_bIsHostWritable &= (propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+	}
+
+	writeLocked(CaptureRecord(CaptureCommand::BindBufferMemory).write(buffer).write(propertyFlags));
+}
+
+void CommandCapture::bindImage(VkImage image, VkDeviceMemory memory)
+{
+	const auto lock = std::scoped_lock(m_Mutex);
+
+	const auto memoryType = m_MemoryTypes.find(memory);
+	const auto propertyFlags = memoryType != m_MemoryTypes.end() ? m_MemoryProperties.memoryTypes[memoryType->second].propertyFlags : 0;
+
+	writeLocked(CaptureRecord(CaptureCommand::BindImageMemory).write(image).write(propertyFlags));
+}
+
+void CommandCapture::recordHostWrites()
+{
+	const auto lock = std::scoped_lock(m_Mutex);
+	for (auto& [buffer, tracked] : m_Buffers)
+		recordHostWrites(buffer, tracked);
+}
+
+bool CommandCapture::isSemaphoreRecorded(VkSemaphore semaphore) const
+{
+	const auto lock = std::scoped_lock(m_Mutex);
+	return m_TimelineSemaphores.contains(semaphore);
+}
+
+void CommandCapture::setSemaphoreRecorded(VkSemaphore semaphore, bool bIsRecorded)
+{
+	const auto lock = std::scoped_lock(m_Mutex);
+	if (bIsRecorded)
+		m_TimelineSemaphores.insert(semaphore);
+
+	else
+		m_TimelineSemaphores.erase(semaphore);
+}
+
+bool CommandCapture::isPipelineRecorded(VkPipeline pipeline) const
+{
+	const auto lock = std::scoped_lock(m_Mutex);
+	return !m_UnrecordedPipelines.contains(pipeline);
+}
+
+void CommandCapture::setPipelineRecorded(VkPipeline pipeline, bool bIsRecorded)
+{
+	const auto lock = std::scoped_lock(m_Mutex);
+	if (bIsRecorded)
+	{
+		m_UnrecordedPipelines.erase(pipeline);
+		return;
+	}
+
+	m_UnrecordedPipelines.insert(pipeline);
+	if (!m_bHasUnrecordedPipelines)
+	{
+		GRAPHITE_LOG_WARNING("The graphics pipelines are not supported by the capture, the draws will be left out of it.");
+		m_bHasUnrecordedPipelines = true;
+	}
+}
+
+void CommandCapture::recordHostWrites(VkBuffer buffer, TrackedBuffer& tracked)
+{
+	if (!tracked.m_bIsHostWritable)
+		return;
+
+	const auto mapping = m_Mappings.find(tracked.m_Memory);
+	if (mapping == m_Mappings.end())
+		return;
+
+	// The replayed buffer starts zeroed, so the first comparison is against zeros.
+	if (tracked.m_Contents.empty())
+		tracked.m_Contents.resize(tracked.m_Size);
+
+	const auto pContents = mapping->second + tracked.m_Offset;
+	const auto size = static_cast<size_t>(tracked.m_Size);
+
+	// Find the changed range.
+	size_t first = 0;
+	while (first < size && pContents[first] == tracked.m_Contents[first])
+		first++;
+
+	if (first == size)
+		return;
+
+	size_t last = size;
+	while (last > first && pContents[last - 1] == tracked.m_Contents[last - 1])
+		last--;
+
+	std::copy(pContents + first, pContents + last, tracked.m_Contents.begin() + first);
+	writeLocked(CaptureRecord(CaptureCommand::UpdateBuffer)
+		.write(buffer)
+		.write(static_cast<uint64_t>(first))
+		.writeArray(std::span<const std::byte>(pContents + first, last - first)));
+}
+
+void CommandCapture::writeLocked(const CaptureRecord& record)
+{
+	const auto command = static_cast<uint32_t>(record.getCommand());
+	const auto size = static_cast<uint32_t>(record.getPayload().size());
+
+	m_File.write(reinterpret_cast<const char*>(&command), sizeof(command));
+	m_File.write(reinterpret_cast<const char*>(&size), sizeof(size));
+	m_File.write(reinterpret_cast<const char*>(record.getPayload().data()), size);
+}
@@ -0,0 +1,526 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "Core/Common.hpp"
+
+#include <volk.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class Instance;
+
+/**
+ * Capture command enum.
+ * This specifies the type of a record in a capture file.
+ */
+enum class CaptureCommand : uint32_t
+{
+	Frame,
+
+	CreateBuffer,
+	DestroyBuffer,
+	BindBufferMemory,
+	UpdateBuffer,
+
+	CreateImage,
+	DestroyImage,
+	BindImageMemory,
+
+	CreateImageView,
+	DestroyImageView,
+
+	CreateShaderModule,
+	DestroyShaderModule,
+
+	CreateDescriptorSetLayout,
+	DestroyDescriptorSetLayout,
+
+	CreatePipelineLayout,
+	DestroyPipelineLayout,
+
+	CreateComputePipeline,
+	DestroyPipeline,
+
+	CreateDescriptorPool,
+	DestroyDescriptorPool,
+	AllocateDescriptorSets,
+	UpdateDescriptorSets,
+
+	CreateCommandPool,
+	DestroyCommandPool,
+	AllocateCommandBuffers,
+	BeginCommandBuffer,
+	EndCommandBuffer,
+	ResetCommandBuffer,
+
+	CreateQueryPool,
+	DestroyQueryPool,
+
+	CreateSemaphore,
+	DestroySemaphore,
+
+	QueueSubmit,
+
+	CmdBindPipeline,
+	CmdBindDescriptorSets,
+	CmdPushConstants,
+	CmdDispatch,
+	CmdFillBuffer,
+	CmdCopyBuffer,
+	CmdCopyBufferToImage,
+	CmdCopyImage,
+	CmdPipelineBarrier,
+	CmdResetQueryPool,
+	CmdWriteTimestamp,
+	CmdDispatchIndirect,
+	CmdBlitImage
+};
+
+/**
+ * Capture record class.
+ * This builds the payload of a single record. Handles are written as their 64-bit values, which the replayer maps to the handles it creates.
+ */
+class CaptureRecord final
+{
+public:
+	/**
+	 * Explicit constructor.
+	 *
+	 * @param command The record command.
+	 */
+	explicit CaptureRecord(CaptureCommand command) : m_Command(command) {}
+
+	/**
+	 * Write a trivially copyable value.
+	 *
+	 * @tparam Type The value type.
+	 * @param value The value to write.
+	 * @return The record reference.
+	 */
+	template<class Type>
+	CaptureRecord& write(const Type& value)
+	{
+		static_assert(std::is_trivially_copyable_v<Type>, "Only trivially copyable types can be written to a capture!");
+
+		if constexpr (std::is_pointer_v<Type>)
+			return write(static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value)));
+
+		else
+			return writeBytes(&value, sizeof(Type));
+	}
+
+	/**
+	 * Write a count followed by the values.
+	 *
+	 * @tparam Type The value type.
+	 * @param values The values to write.
+	 * @return The record reference.
+	 */
+	template<class Type>
+	CaptureRecord& writeArray(std::span<const Type> values)
+	{
+		write(static_cast<uint32_t>(values.size()));
+		for (const auto& value : values)
+			write(value);
+
+		return *this;
+	}
+
+	/**
+	 * Write a string.
+	 *
+	 * @param string The string to write.
+	 * @return The record reference.
+	 */
+	CaptureRecord& writeString(std::string_view string) { return writeArray(std::span<const char>(string.data(), string.size())); }
+
+	/**
+	 * Write raw bytes.
+	 *
+	 * @param pData The data to write.
+	 * @param size The number of bytes.
+	 * @return The record reference.
+	 */
+	CaptureRecord& writeBytes(const void* pData, size_t size)
+	{
+		const auto offset = m_Payload.size();
+		m_Payload.resize(offset + size);
+		std::memcpy(m_Payload.data() + offset, pData, size);
+
+		return *this;
+	}
+
+public:
+	GRAPHITE_SETUP_SIMPLE_GETTER(CaptureCommand, Command, m_Command);
+	GRAPHITE_SETUP_GETTERS(std::vector<std::byte>, Payload, m_Payload);
+
+private:
+	std::vector<std::byte> m_Payload;
+	CaptureCommand m_Command;
+};
+
+/**
+ * Capture reader class.
+ * This reads the payload of a single record. Reading past the end returns zeros and marks the reader as overflowed, so a truncated record is
+ * detected once instead of checking every read.
+ */
+class CaptureReader final
+{
+public:
+	/**
+	 * Explicit constructor.
+	 *
+	 * @param payload The record payload.
+	 */
+	explicit CaptureReader(std::span<const std::byte> payload) : m_Payload(payload) {}
+
+	/**
+	 * Read a trivially copyable value.
+	 *
+	 * @tparam Type The value type.
+	 * @return The value.
+	 */
+	template<class Type>
+	[[nodiscard]] Type read()
+	{
+		static_assert(std::is_trivially_copyable_v<Type>, "Only trivially copyable types can be read from a capture!");
+
+		Type value = {};
+		readBytes(&value, sizeof(Type));
+		return value;
+	}
+
+	/**
+	 * Read a count followed by the values.
+	 *
+	 * @tparam Type The value type.
+	 * @return The values.
+	 */
+	template<class Type>
+	[[nodiscard]] std::vector<Type> readArray()
+	{
+		std::vector<Type> values(readCount(sizeof(Type)));
+		readBytes(values.data(), values.size() * sizeof(Type));
+		return values;
+	}
+
+	/**
+	 * Read the number of elements which follow.
+	 * The count is checked against the rest of the payload before anything is allocated for the elements, so a corrupt count can't cause a huge
+	 * allocation.
+	 *
+	 * @param elementSize The smallest number of bytes an element takes in the payload.
+	 * @return The count. 0 if that many elements can't fit in the rest of the payload, in which case the reader is marked as overflowed.
+	 */
+	[[nodiscard]] uint32_t readCount(size_t elementSize)
+	{
+		const auto count = read<uint32_t>();
+		if (static_cast<uint64_t>(count) * elementSize > m_Payload.size() - m_Offset)
+		{
+			m_bHasOverflowed = true;
+			return 0;
+		}
+
+		return count;
+	}
+
+	/**
+	 * Read a string.
+	 *
+	 * @return The string.
+	 */
+	[[nodiscard]] std::string readString()
+	{
+		const auto characters = readArray<char>();
+		return std::string(characters.begin(), characters.end());
+	}
+
+	/**
+	 * Read raw bytes.
+	 *
+	 * @param pData The memory to read to.
+	 * @param size The number of bytes.
+	 */
+	void readBytes(void* pData, size_t size)
+	{
+		if (size > m_Payload.size() - m_Offset)
+		{
+			m_bHasOverflowed = true;
+			std::memset(pData, 0, size);
+			return;
+		}
+
+		std::memcpy(pData, m_Payload.data() + m_Offset, size);
+		m_Offset += size;
+	}
+
+	/**
+	 * Read raw bytes without copying them.
+	 *
+	 * @param size The number of bytes.
+	 * @return The bytes. Empty if the record is too short.
+	 */
+	[[nodiscard]] std::span<const std::byte> readSpan(size_t size)
+	{
+		if (size > m_Payload.size() - m_Offset)
+		{
+			m_bHasOverflowed = true;
+			return {};
+		}
+
+		const auto bytes = m_Payload.subspan(m_Offset, size);
+		m_Offset += size;
+		return bytes;
+	}
+
+public:
+	[[nodiscard]] bool hasOverflowed() const { return m_bHasOverflowed; }
+
+private:
+	std::span<const std::byte> m_Payload;
+	size_t m_Offset = 0;
+	bool m_bHasOverflowed = false;
+};
+
+/**
+ * Command capture class.
+ * This records the work the engine submits to the GPU into a compact binary file, which the replay tool can execute again without the engine.
+ *
+ * The capture replaces the functions of the instance's device table with hooks which write a record and forward the call, so it must be installed
+ * right after the device table is loaded, before the allocator copies the functions. Buffers and images are recorded with the memory properties
+ * they were bound to instead of the memory allocations, so the replayer can allocate them on a different device. The contents of the host
+ * visible buffers the GPU can't write to are compared with their last recorded contents on every submit and unmap, and the changed ranges are
+ * recorded as updates.
+ *
+ * Only one capture can be active at a time. The swapchain and the binary semaphores are not recorded, since the replay runs headless. The
+ * graphics pipelines are created through a hook but not recorded either, since the draws render to the swapchain and the render targets, and
+ * their binds are dropped so the replay only contains the compute and transfer work. The file uses the layout of the Vulkan structures
+ * directly, so it can only be replayed on the same architecture.
+ */
+class CommandCapture final
+{
+	/**
+	 * Tracked buffer structure.
+	 * This contains what the capture needs to know to record the host writes of a buffer.
+	 */
+	struct TrackedBuffer final
+	{
+		std::vector<std::byte> m_Contents;
+
+		VkDeviceMemory m_Memory = VK_NULL_HANDLE;
+		VkDeviceSize m_Offset = 0;
+		VkDeviceSize m_Size = 0;
+
+		bool m_bIsHostWritable = false;
+	};
+
+public:
+	/**
+	 * Explicit constructor.
+	 *
+	 * @param instance The instance to capture. The queues are resolved through it when the work is submitted.
+	 * @param path The capture file path.
+	 */
+	explicit CommandCapture(Instance& instance, const std::filesystem::path& path);
+
+	/**
+	 * Destructor.
+	 */
+	~CommandCapture();
+
+	GRAPHITE_DISABLE_COPY_AND_MOVE(CommandCapture);
+
+	/**
+	 * Mark the end of a frame.
+	 * The replayer waits for the GPU at every frame marker and reports the time each frame took.
+	 */
+	void markFrame();
+
+	/**
+	 * Write a record to the file.
+	 * This is thread safe.
+	 *
+	 * @param record The record to write.
+	 */
+	void write(const CaptureRecord& record);
+
+	/**
+	 * Get the queue type of a queue family.
+	 *
+	 * @param family The queue family index.
+	 * @return The queue type index. 0xFF if the family is ignored or not used by the engine.
+	 */
+	[[nodiscard]] uint8_t getQueueType(uint32_t family) const;
+
+	/**
+	 * Get the queue type of a queue.
+	 *
+	 * @param queue The queue handle.
+	 * @return The queue type index. 0xFF if the queue is not used by the engine.
+	 */
+	[[nodiscard]] uint8_t getQueueType(VkQueue queue) const;
+
+	/**
+	 * Track a memory allocation.
+	 *
+	 * @param memory The memory handle.
+	 * @param memoryTypeIndex The memory type the memory was allocated from.
+	 */
+	void trackMemory(VkDeviceMemory memory, uint32_t memoryTypeIndex);
+
+	/**
+	 * Stop tracking a memory allocation.
+	 *
+	 * @param memory The memory handle.
+	 */
+	void untrackMemory(VkDeviceMemory memory);
+
+	/**
+	 * Track the mapping of a memory allocation.
+	 *
+	 * @param memory The memory handle.
+	 * @param offset The mapped offset.
+	 * @param pData The mapped pointer.
+	 */
+	void trackMapping(VkDeviceMemory memory, VkDeviceSize offset, void* pData);
+
+	/**
+	 * Record the host writes to the buffers of a memory allocation and stop tracking it's mapping.
+	 *
+	 * @param memory The memory handle.
+	 */
+	void untrackMapping(VkDeviceMemory memory);
+
+	/**
+	 * Track a created buffer.
+	 *
+	 * @param buffer The buffer handle.
+	 * @param createInfo The buffer create info.
+	 */
+	void trackBuffer(VkBuffer buffer, const VkBufferCreateInfo& createInfo);
+
+	/**
+	 * Stop tracking a buffer.
+	 *
+	 * @param buffer The buffer handle.
+	 */
+	void untrackBuffer(VkBuffer buffer);
+
+	/**
+	 * Record a buffer's memory binding.
+	 *
+	 * @param buffer The buffer handle.
+	 * @param memory The memory handle.
+	 * @param offset The offset within the memory.
+	 */
+	void bindBuffer(VkBuffer buffer, VkDeviceMemory memory, VkDeviceSize offset);
+
+	/**
+	 * Record an image's memory binding.
+	 *
+	 * @param image The image handle.
+	 * @param memory The memory handle.
+	 */
+	void bindImage(VkImage image, VkDeviceMemory memory);
+
+	/**
+	 * Record the host writes to all the mapped buffers.
+	 * This is called before every submit.
+	 */
+	void recordHostWrites();
+
+	/**
+	 * Check if a semaphore is recorded.
+	 * Only the timeline semaphores are, so the binary semaphores the swapchain uses are dropped from the submits.
+	 *
+	 * @param semaphore The semaphore handle.
+	 * @return True if the semaphore is recorded.
+	 */
+	[[nodiscard]] bool isSemaphoreRecorded(VkSemaphore semaphore) const;
+
+	/**
+	 * Set whether a semaphore is recorded.
+	 *
+	 * @param semaphore The semaphore handle.
+	 * @param bIsRecorded True if the semaphore is recorded.
+	 */
+	void setSemaphoreRecorded(VkSemaphore semaphore, bool bIsRecorded);
+
+	/**
+	 * Check if a pipeline is recorded.
+	 * All of them are except the graphics pipelines, whose binds are dropped from the command buffers.
+	 *
+	 * @param pipeline The pipeline handle.
+	 * @return True if the pipeline is recorded.
+	 */
+	[[nodiscard]] bool isPipelineRecorded(VkPipeline pipeline) const;
+
+	/**
+	 * Set whether a pipeline is recorded.
+	 * A warning is logged the first time a pipeline is left out of the capture.
+	 *
+	 * @param pipeline The pipeline handle.
+	 * @param bIsRecorded True if the pipeline is recorded.
+	 */
+	void setPipelineRecorded(VkPipeline pipeline, bool bIsRecorded);
+
+	/**
+	 * Install the hooks to a device table.
+	 * The original functions are kept, and all the hooks forward to them.
+	 *
+	 * @param deviceTable The device table to hook.
+	 */
+	void install(VolkDeviceTable& deviceTable);
+
+public:
+	[[nodiscard]] bool isValid() const { return m_File.is_open(); }
+	[[nodiscard]] const VolkDeviceTable& getTable() const { return m_Table; }
+
+private:
+	/**
+	 * Record the host writes to a buffer.
+	 * The capture mutex must be locked.
+	 *
+	 * @param buffer The buffer handle.
+	 * @param tracked The tracked buffer.
+	 */
+	void recordHostWrites(VkBuffer buffer, TrackedBuffer& tracked);
+
+	/**
+	 * Write a record to the file.
+	 * The capture mutex must be locked.
+	 *
+	 * @param record The record to write.
+	 */
+	void writeLocked(const CaptureRecord& record);
+
+private:
+	VolkDeviceTable m_Table = {};
+	VkPhysicalDeviceMemoryProperties m_MemoryProperties = {};
+
+	std::ofstream m_File;
+	mutable std::mutex m_Mutex;
+
+	std::unordered_map<VkDeviceMemory, uint32_t> m_MemoryTypes;
+	std::unordered_map<VkDeviceMemory, std::byte*> m_Mappings;
+	std::unordered_map<VkBuffer, TrackedBuffer> m_Buffers;
+	std::unordered_set<VkSemaphore> m_TimelineSemaphores;
+	std::unordered_set<VkPipeline> m_UnrecordedPipelines;
+
+	Instance& m_Instance;
+
+	uint64_t m_FrameIndex = 0;
+
+	bool m_bHasUnrecordedPipelines = false;
+};
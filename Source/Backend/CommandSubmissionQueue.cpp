@@ -0,0 +1,252 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "CommandSubmissionQueue.hpp"
+#include "VulkanMacros.hpp"
+
+#include <optick.h>
+
+#include <algorithm>
+
+void CommandSubmissionQueue::PendingSubmissions::clear()
+{
+	m_Batches.clear();
+	m_CommandBuffers.clear();
+	m_WaitSemaphores.clear();
+	m_SignalSemaphores.clear();
+}
+
+CommandSubmissionQueue::CommandSubmissionQueue(Instance& instance)
+	: InstanceBoundObject(instance)
+{
+	VkSemaphoreTypeCreateInfoKHR typeCreateInfo = {};
+	typeCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+	typeCreateInfo.pNext = nullptr;
+	typeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+	typeCreateInfo.initialValue = 0;
+
+	VkSemaphoreCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	createInfo.pNext = &typeCreateInfo;
+	createInfo.flags = 0;
+
+	m_Instance.getLogicalDevice().access([this, &createInfo](VkDevice logicalDevice)
+		{
+			for (auto& semaphore : m_Semaphores)
+				GRAPHITE_VK_ASSERT(m_Instance.getDeviceTable().vkCreateSemaphore(logicalDevice, &createInfo, nullptr, &semaphore), "Failed to create the timeline semaphore!");
+		}
+	);
+}
+
+CommandSubmissionQueue::~CommandSubmissionQueue()
+{
+	flush();
+
+	// Wait till all the submitted work is done before destroying the semaphores.
+	VkSemaphoreWaitInfoKHR waitInfo = {};
+	waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+	waitInfo.pNext = nullptr;
+	waitInfo.flags = 0;
+	waitInfo.semaphoreCount = QueueTypeCount;
+	waitInfo.pSemaphores = m_Semaphores.data();
+	waitInfo.pValues = m_FlushedValues.data();
+
+	m_Instance.getLogicalDevice().access([this, &waitInfo](VkDevice logicalDevice)
+		{
+			GRAPHITE_VK_ASSERT(m_Instance.getDeviceTable().vkWaitSemaphoresKHR(logicalDevice, &waitInfo, std::numeric_limits<uint64_t>::max()), "Failed to wait for the timeline semaphores!");
+
+			for (const auto semaphore : m_Semaphores)
+				m_Instance.getDeviceTable().vkDestroySemaphore(logicalDevice, semaphore, nullptr);
+		}
+	);
+}
+
+uint64_t CommandSubmissionQueue::enqueue(
+	QueueType type,
+	std::span<const VkCommandBuffer> commandBuffers,
+	std::span<const SubmissionWait> waits /*= {}*/,
+	std::span<const VkSemaphoreSubmitInfoKHR> binaryWaits /*= {}*/,
+	std::span<const VkSemaphoreSubmitInfoKHR> binarySignals /*= {}*/)
+{
+	OPTICK_EVENT();
+
+	const auto index = static_cast<uint8_t>(type);
+	const auto lock = std::scoped_lock(m_PendingMutexes[index]);
+	auto& submissions = m_PendingSubmissions[index];
+
+	const auto value = ++m_NextValues[index];
+	const auto sequence = m_Sequence.fetch_add(1, std::memory_order_relaxed);
+
+	// Append the command buffers. They always go to the end, so the last batch's command buffers are contiguous with these.
+	const auto firstCommandBuffer = static_cast<uint32_t>(submissions.m_CommandBuffers.size());
+	for (const auto commandBuffer : commandBuffers)
+	{
+		auto& submitInfo = submissions.m_CommandBuffers.emplace_back();
+		submitInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO_KHR;
+		submitInfo.pNext = nullptr;
+		submitInfo.commandBuffer = commandBuffer;
+		submitInfo.deviceMask = 0;
+	}
+
+	// If the submission does not wait for anything and the last batch only signals the timeline, we can merge the two.
+	// Submissions with waits are never merged, since the earlier command buffers would then wait on values which might depend on them.
+	if (waits.empty() && binaryWaits.empty() && binarySignals.empty() && !submissions.m_Batches.empty() && submissions.m_Batches.back().m_SignalCount == 1)
+	{
+		auto& batch = submissions.m_Batches.back();
+		batch.m_CommandBufferCount += static_cast<uint32_t>(commandBuffers.size());
+		submissions.m_SignalSemaphores[batch.m_FirstSignal].value = value;
+
+		return value;
+	}
+
+	auto& batch = submissions.m_Batches.emplace_back();
+	batch.m_Sequence = sequence;
+	batch.m_FirstCommandBuffer = firstCommandBuffer;
+	batch.m_CommandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+
+	// Setup the waits.
+	batch.m_FirstWait = static_cast<uint32_t>(submissions.m_WaitSemaphores.size());
+	batch.m_WaitCount = static_cast<uint32_t>(waits.size() + binaryWaits.size());
+
+	for (const auto& wait : waits)
+	{
+		auto& submitInfo = submissions.m_WaitSemaphores.emplace_back();
+		submitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO_KHR;
+		submitInfo.pNext = nullptr;
+		submitInfo.semaphore = getSemaphore(wait.m_Queue);
+		submitInfo.value = wait.m_Value;
+		submitInfo.stageMask = wait.m_StageMask;
+		submitInfo.deviceIndex = 0;
+	}
+
+	submissions.m_WaitSemaphores.insert(submissions.m_WaitSemaphores.end(), binaryWaits.begin(), binaryWaits.end());
+
+	// Setup the signals. The timeline signal is always the first so merging can update it's value.
+	batch.m_FirstSignal = static_cast<uint32_t>(submissions.m_SignalSemaphores.size());
+	batch.m_SignalCount = static_cast<uint32_t>(binarySignals.size() + 1);
+
+	auto& signalInfo = submissions.m_SignalSemaphores.emplace_back();
+	signalInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO_KHR;
+	signalInfo.pNext = nullptr;
+	signalInfo.semaphore = m_Semaphores[index];
+	signalInfo.value = value;
+	signalInfo.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT_KHR;
+	signalInfo.deviceIndex = 0;
+
+	submissions.m_SignalSemaphores.insert(submissions.m_SignalSemaphores.end(), binarySignals.begin(), binarySignals.end());
+
+	return value;
+}
+
+void CommandSubmissionQueue::flush()
+{
+	OPTICK_EVENT();
+
+	const auto lock = std::scoped_lock(m_FlushMutex);
+
+	// Take the pending submissions so the other threads can keep enqueuing while we submit.
+	for (uint8_t i = 0; i < QueueTypeCount; i++)
+	{
+		const auto pendingLock = std::scoped_lock(m_PendingMutexes[i]);
+		std::swap(m_PendingSubmissions[i], m_FlushingSubmissions[i]);
+		m_FlushedValues[i] = m_NextValues[i];
+	}
+
+	// Submit the producers first, so most of the waits are already signaled when the consumers are submitted.
+	constexpr std::array<QueueType, QueueTypeCount> submitOrder = { QueueType::Transfer, QueueType::Compute, QueueType::Graphics };
+	for (uint8_t i = 0; i < QueueTypeCount; i++)
+	{
+		auto& queue = m_Instance.getQueue(submitOrder[i]);
+
+		// Skip if the queue was already submitted to by a type which shares it.
+		const auto isSubmitted = std::any_of(submitOrder.begin(), submitOrder.begin() + i, [this, &queue](QueueType type) { return &m_Instance.getQueue(type) == &queue; });
+		if (isSubmitted)
+			continue;
+
+		// Collect the batches of all the types which share the queue.
+		m_OrderedBatches.clear();
+		uint8_t typeCount = 0;
+		for (uint8_t j = i; j < QueueTypeCount; j++)
+		{
+			if (&m_Instance.getQueue(submitOrder[j]) != &queue)
+				continue;
+
+			const auto& submissions = m_FlushingSubmissions[static_cast<uint8_t>(submitOrder[j])];
+			for (const auto& batch : submissions.m_Batches)
+				m_OrderedBatches.emplace_back(&submissions, &batch);
+
+			typeCount++;
+		}
+
+		if (m_OrderedBatches.empty())
+			continue;
+
+		// Batches of different types in the same queue must be submitted in the order they were enqueued, otherwise a batch could wait on one which
+		// is behind it in the same queue.
+		if (typeCount > 1)
+			std::sort(m_OrderedBatches.begin(), m_OrderedBatches.end(), [](const auto& lhs, const auto& rhs) { return lhs.second->m_Sequence < rhs.second->m_Sequence; });
+
+		m_SubmitInfos.clear();
+		for (const auto& [pSubmissions, pBatch] : m_OrderedBatches)
+			appendSubmitInfo(*pSubmissions, *pBatch);
+
+		queue.access([this](const VulkanQueue& vulkanQueue)
+			{
+				GRAPHITE_VK_ASSERT(m_Instance.getDeviceTable().vkQueueSubmit2KHR(vulkanQueue.m_Queue, static_cast<uint32_t>(m_SubmitInfos.size()), m_SubmitInfos.data(), VK_NULL_HANDLE), "Failed to submit to the queue!");
+			}
+		);
+
+		m_SubmitCount++;
+	}
+
+	for (auto& submissions : m_FlushingSubmissions)
+		submissions.clear();
+
+	// Resources retired till now might be used by anything we just submitted, so they are released once all of it is done.
+	auto& deletionQueue = m_Instance.getDeletionQueue();
+	deletionQueue.closeFrame(m_FlushedValues);
+	deletionQueue.collect({ getCompletedValue(QueueType::Graphics), getCompletedValue(QueueType::Compute), getCompletedValue(QueueType::Transfer) });
+}
+
+uint64_t CommandSubmissionQueue::getCompletedValue(QueueType type) const
+{
+	uint64_t value = 0;
+	GRAPHITE_VK_ASSERT(m_Instance.getDeviceTable().vkGetSemaphoreCounterValueKHR(m_Instance.getLogicalDevice().getUnsafe(), getSemaphore(type), &value), "Failed to get the timeline semaphore value!");
+
+	return value;
+}
+
+bool CommandSubmissionQueue::wait(QueueType type, uint64_t value, uint64_t timeout /*= std::numeric_limits<uint64_t>::max()*/) const
+{
+	OPTICK_EVENT();
+
+	const auto semaphore = getSemaphore(type);
+
+	VkSemaphoreWaitInfoKHR waitInfo = {};
+	waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+	waitInfo.pNext = nullptr;
+	waitInfo.flags = 0;
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores = &semaphore;
+	waitInfo.pValues = &value;
+
+	// The device handle never changes after creation and the wait is thread safe, so we don't lock the device while waiting.
+	const auto result = m_Instance.getDeviceTable().vkWaitSemaphoresKHR(m_Instance.getLogicalDevice().getUnsafe(), &waitInfo, timeout);
+	if (result != VK_SUCCESS && result != VK_TIMEOUT)
+		GRAPHITE_LOG_ERROR("Failed to wait for the timeline semaphore!");
+
+	return result == VK_SUCCESS;
+}
+
+void CommandSubmissionQueue::appendSubmitInfo(const PendingSubmissions& submissions, const PendingBatch& batch)
+{
+	auto& submitInfo = m_SubmitInfos.emplace_back();
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2_KHR;
+	submitInfo.pNext = nullptr;
+	submitInfo.flags = 0;
+	submitInfo.waitSemaphoreInfoCount = batch.m_WaitCount;
+	submitInfo.pWaitSemaphoreInfos = submissions.m_WaitSemaphores.data() + batch.m_FirstWait;
+	submitInfo.commandBufferInfoCount = batch.m_CommandBufferCount;
+	submitInfo.pCommandBufferInfos = submissions.m_CommandBuffers.data() + batch.m_FirstCommandBuffer;
+	submitInfo.signalSemaphoreInfoCount = batch.m_SignalCount;
+	submitInfo.pSignalSemaphoreInfos = submissions.m_SignalSemaphores.data() + batch.m_FirstSignal;
+}
@@ -0,0 +1,165 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "InstanceBoundObject.hpp"
+#include "Instance.hpp"
+
+#include <span>
+#include <atomic>
+#include <limits>
+
+/**
+ * Submission wait structure.
+ * This specifies a timeline value of a queue type which has to be reached before a submission can execute.
+ */
+struct SubmissionWait final
+{
+	QueueType m_Queue = QueueType::Graphics;
+	uint64_t m_Value = 0;
+	VkPipelineStageFlags2KHR m_StageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT_KHR;
+};
+
+/**
+ * Command submission queue class.
+ * Instead of every system calling vkQueueSubmit while holding the queue lock, systems enqueue their command buffers here and the queue submits
+ * everything at once when flushed, using a single vkQueueSubmit2 call per Vulkan queue.
+ *
+ * Every queue type has a timeline semaphore and every enqueued submission signals the next value of it's type's semaphore. That value is used to
+ * wait for the submission on the CPU or from a submission to another queue type. Consecutive submissions without any waits are coalesced into a
+ * single batch which signals the last value.
+ */
+class CommandSubmissionQueue final : public InstanceBoundObject
+{
+	static constexpr uint8_t QueueTypeCount = 3;
+
+	/**
+	 * Pending batch structure.
+	 * This contains the ranges of a single VkSubmitInfo2 within the pending arrays.
+	 */
+	struct PendingBatch final
+	{
+		uint64_t m_Sequence = 0;
+
+		uint32_t m_FirstCommandBuffer = 0;
+		uint32_t m_CommandBufferCount = 0;
+
+		uint32_t m_FirstWait = 0;
+		uint32_t m_WaitCount = 0;
+
+		uint32_t m_FirstSignal = 0;
+		uint32_t m_SignalCount = 0;
+	};
+
+	/**
+	 * Pending submissions structure.
+	 * This contains all the submissions of a queue type which were enqueued after the last flush.
+	 */
+	struct PendingSubmissions final
+	{
+		std::vector<PendingBatch> m_Batches;
+		std::vector<VkCommandBufferSubmitInfoKHR> m_CommandBuffers;
+		std::vector<VkSemaphoreSubmitInfoKHR> m_WaitSemaphores;
+		std::vector<VkSemaphoreSubmitInfoKHR> m_SignalSemaphores;
+
+		/**
+		 * Clear all the pending data.
+		 * The vectors keep their memory so the next frame does not allocate.
+		 */
+		void clear();
+	};
+
+public:
+	/**
+	 * Explicit constructor.
+	 *
+	 * @param instance The instance reference.
+	 */
+	explicit CommandSubmissionQueue(Instance& instance);
+
+	/**
+	 * Destructor.
+	 * This flushes the pending submissions and waits till all the submitted work is done.
+	 */
+	~CommandSubmissionQueue() override;
+
+	/**
+	 * Enqueue command buffers to be submitted on the next flush.
+	 * This is thread safe.
+	 *
+	 * @param type The queue type to submit to.
+	 * @param commandBuffers The command buffers to submit.
+	 * @param waits The timeline values to wait for. These must be values returned by previous enqueue calls. Default is none.
+	 * @param binaryWaits The binary semaphores to wait for, like the swapchain image acquire semaphore. Default is none.
+	 * @param binarySignals The binary semaphores to signal, like the present semaphore. Default is none.
+	 * @return The timeline value which will be signaled once the command buffers are executed.
+	 */
+	uint64_t enqueue(
+		QueueType type,
+		std::span<const VkCommandBuffer> commandBuffers,
+		std::span<const SubmissionWait> waits = {},
+		std::span<const VkSemaphoreSubmitInfoKHR> binaryWaits = {},
+		std::span<const VkSemaphoreSubmitInfoKHR> binarySignals = {});
+
+	/**
+	 * Submit all the pending submissions.
+	 * This should be called once per frame, after all the systems have enqueued their work. This also closes the instance's deletion queue frame
+	 * and releases the resources the GPU is done with.
+	 */
+	void flush();
+
+	/**
+	 * Get the last timeline value of a queue type which was executed by the GPU.
+	 *
+	 * @param type The queue type.
+	 * @return The completed value.
+	 */
+	[[nodiscard]] uint64_t getCompletedValue(QueueType type) const;
+
+	/**
+	 * Wait on the CPU till a timeline value of a queue type is reached.
+	 * Make sure that the value was flushed before waiting, otherwise this will wait till the timeout.
+	 *
+	 * @param type The queue type.
+	 * @param value The value to wait for.
+	 * @param timeout The timeout in nanoseconds. Default is no timeout.
+	 * @return True if the value was reached, false if it timed out.
+	 */
+	bool wait(QueueType type, uint64_t value, uint64_t timeout = std::numeric_limits<uint64_t>::max()) const;
+
+	/**
+	 * Get the timeline semaphore of a queue type.
+	 *
+	 * @param type The queue type.
+	 * @return The semaphore handle.
+	 */
+	[[nodiscard]] VkSemaphore getSemaphore(QueueType type) const { return m_Semaphores[static_cast<uint8_t>(type)]; }
+
+public:
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint64_t, SubmitCount, m_SubmitCount);
+
+private:
+	/**
+	 * Build the submit info of a batch and append it to the submit list.
+	 *
+	 * @param submissions The submissions which contain the batch.
+	 * @param batch The batch to build.
+	 */
+	void appendSubmitInfo(const PendingSubmissions& submissions, const PendingBatch& batch);
+
+private:
+	std::array<PendingSubmissions, QueueTypeCount> m_PendingSubmissions;
+	std::array<std::mutex, QueueTypeCount> m_PendingMutexes;
+
+	std::array<PendingSubmissions, QueueTypeCount> m_FlushingSubmissions;
+	std::vector<std::pair<const PendingSubmissions*, const PendingBatch*>> m_OrderedBatches;
+	std::vector<VkSubmitInfo2KHR> m_SubmitInfos;
+	std::mutex m_FlushMutex;
+
+	std::array<VkSemaphore, QueueTypeCount> m_Semaphores = {};
+	std::array<uint64_t, QueueTypeCount> m_NextValues = {};
+	std::array<uint64_t, QueueTypeCount> m_FlushedValues = {};
+	std::atomic_uint64_t m_Sequence = 0;
+
+	uint64_t m_SubmitCount = 0;
+};
@@ -0,0 +1,259 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "ComputePipeline.hpp"
+#include "Instance.hpp"
+#include "VulkanMacros.hpp"
+
+#include <fstream>
+#include <unordered_map>
+
+ComputePipeline::ComputePipeline(Instance& instance, const std::filesystem::path& shaderPath, const std::vector<SetBindings>& setBindings, uint32_t pushConstantSize, uint32_t maximumSetsPerLayout)
+	: InstanceBoundObject(instance)
+{
+	const auto code = ReadShaderCode(shaderPath);
+	if (code.empty())
+	{
+		GRAPHITE_LOG_ERROR("Failed to read the compute shader {}!", shaderPath.string());
+		return;
+	}
+
+	// Count the descriptors the pool needs.
+	std::unordered_map<VkDescriptorType, uint32_t> descriptorCounts;
+	for (const auto& bindings : setBindings)
+	{
+		for (const auto& binding : bindings)
+			descriptorCounts[binding.descriptorType] += binding.descriptorCount * maximumSetsPerLayout;
+	}
+
+	std::vector<VkDescriptorPoolSize> poolSizes;
+	poolSizes.reserve(descriptorCounts.size());
+	for (const auto [type, count] : descriptorCounts)
+		poolSizes.emplace_back(VkDescriptorPoolSize{ type, count });
+
+	VkPushConstantRange pushConstantRange = {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = pushConstantSize;
+
+	m_Instance.getLogicalDevice().access([this, &code, &setBindings, &poolSizes, &pushConstantRange, maximumSetsPerLayout](VkDevice logicalDevice)
+		{
+			const auto& deviceTable = m_Instance.getDeviceTable();
+
+			// Create the descriptor set layouts.
+			m_DescriptorSetLayouts.resize(setBindings.size());
+			for (size_t i = 0; i < setBindings.size(); i++)
+			{
+				VkDescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+				layoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+				layoutCreateInfo.pNext = nullptr;
+				layoutCreateInfo.flags = 0;
+				layoutCreateInfo.bindingCount = static_cast<uint32_t>(setBindings[i].size());
+				layoutCreateInfo.pBindings = setBindings[i].data();
+				GRAPHITE_VK_ASSERT(deviceTable.vkCreateDescriptorSetLayout(logicalDevice, &layoutCreateInfo, nullptr, &m_DescriptorSetLayouts[i]), "Failed to create the compute descriptor set layout!");
+			}
+
+			// Create the descriptor pool.
+			if (!poolSizes.empty())
+			{
+				VkDescriptorPoolCreateInfo poolCreateInfo = {};
+				poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+				poolCreateInfo.pNext = nullptr;
+				poolCreateInfo.flags = 0;
+				poolCreateInfo.maxSets = static_cast<uint32_t>(setBindings.size()) * maximumSetsPerLayout;
+				poolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+				poolCreateInfo.pPoolSizes = poolSizes.data();
+				GRAPHITE_VK_ASSERT(deviceTable.vkCreateDescriptorPool(logicalDevice, &poolCreateInfo, nullptr, &m_DescriptorPool), "Failed to create the compute descriptor pool!");
+			}
+
+			// Create the pipeline layout.
+			VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+			pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+			pipelineLayoutCreateInfo.pNext = nullptr;
+			pipelineLayoutCreateInfo.flags = 0;
+			pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(m_DescriptorSetLayouts.size());
+			pipelineLayoutCreateInfo.pSetLayouts = m_DescriptorSetLayouts.data();
+			pipelineLayoutCreateInfo.pushConstantRangeCount = pushConstantRange.size > 0 ? 1 : 0;
+			pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+			GRAPHITE_VK_ASSERT(deviceTable.vkCreatePipelineLayout(logicalDevice, &pipelineLayoutCreateInfo, nullptr, &m_PipelineLayout), "Failed to create the compute pipeline layout!");
+
+			// Create the shader module and the pipeline. The module is not needed once the pipeline is created.
+			VkShaderModuleCreateInfo shaderCreateInfo = {};
+			shaderCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+			shaderCreateInfo.pNext = nullptr;
+			shaderCreateInfo.flags = 0;
+			shaderCreateInfo.codeSize = code.size() * sizeof(uint32_t);
+			shaderCreateInfo.pCode = code.data();
+
+			VkShaderModule shaderModule = VK_NULL_HANDLE;
+			GRAPHITE_VK_ASSERT(deviceTable.vkCreateShaderModule(logicalDevice, &shaderCreateInfo, nullptr, &shaderModule), "Failed to create the compute shader module!");
+
+			VkComputePipelineCreateInfo pipelineCreateInfo = {};
+			pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+			pipelineCreateInfo.pNext = nullptr;
+			pipelineCreateInfo.flags = 0;
+			pipelineCreateInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			pipelineCreateInfo.stage.pNext = nullptr;
+			pipelineCreateInfo.stage.flags = 0;
+			pipelineCreateInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+			pipelineCreateInfo.stage.module = shaderModule;
+			pipelineCreateInfo.stage.pName = "main";
+			pipelineCreateInfo.stage.pSpecializationInfo = nullptr;
+			pipelineCreateInfo.layout = m_PipelineLayout;
+			pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
+			pipelineCreateInfo.basePipelineIndex = -1;
+			GRAPHITE_VK_ASSERT(deviceTable.vkCreateComputePipelines(logicalDevice, m_Instance.getPipelineCache(), 1, &pipelineCreateInfo, nullptr, &m_Pipeline), "Failed to create the compute pipeline!");
+
+			deviceTable.vkDestroyShaderModule(logicalDevice, shaderModule, nullptr);
+		}
+	);
+}
+
+ComputePipeline::~ComputePipeline()
+{
+	// The last frames might still be using the pipeline, so everything is destroyed once they are done.
+	m_Instance.getDeletionQueue().retire([&deviceTable = m_Instance.getDeviceTable(), pipeline = m_Pipeline, pipelineLayout = m_PipelineLayout, descriptorPool = m_DescriptorPool, descriptorSetLayouts = m_DescriptorSetLayouts](VkDevice logicalDevice)
+		{
+			deviceTable.vkDestroyPipeline(logicalDevice, pipeline, nullptr);
+			deviceTable.vkDestroyPipelineLayout(logicalDevice, pipelineLayout, nullptr);
+			deviceTable.vkDestroyDescriptorPool(logicalDevice, descriptorPool, nullptr);
+
+			for (const auto layout : descriptorSetLayouts)
+				deviceTable.vkDestroyDescriptorSetLayout(logicalDevice, layout, nullptr);
+		}
+	);
+}
+
+VkDescriptorSet ComputePipeline::allocateDescriptorSet(uint32_t set)
+{
+	if (set >= m_DescriptorSetLayouts.size())
+		return VK_NULL_HANDLE;
+
+	VkDescriptorSetAllocateInfo allocateInfo = {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocateInfo.pNext = nullptr;
+	allocateInfo.descriptorPool = m_DescriptorPool;
+	allocateInfo.descriptorSetCount = 1;
+	allocateInfo.pSetLayouts = &m_DescriptorSetLayouts[set];
+
+	VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+	m_Instance.getLogicalDevice().access([this, &allocateInfo, &descriptorSet](VkDevice logicalDevice)
+		{
+			GRAPHITE_VK_ASSERT(m_Instance.getDeviceTable().vkAllocateDescriptorSets(logicalDevice, &allocateInfo, &descriptorSet), "Failed to allocate the compute descriptor set!");
+		}
+	);
+
+	return descriptorSet;
+}
+
+void ComputePipeline::writeBuffer(VkDescriptorSet descriptorSet, uint32_t binding, VkDescriptorType type, VkBuffer buffer)
+{
+	if (descriptorSet == VK_NULL_HANDLE)
+		return;
+
+	const VkDescriptorBufferInfo bufferInfo = { buffer, 0, VK_WHOLE_SIZE };
+
+	VkWriteDescriptorSet write = {};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.pNext = nullptr;
+	write.dstSet = descriptorSet;
+	write.dstBinding = binding;
+	write.dstArrayElement = 0;
+	write.descriptorCount = 1;
+	write.descriptorType = type;
+	write.pImageInfo = nullptr;
+	write.pBufferInfo = &bufferInfo;
+	write.pTexelBufferView = nullptr;
+
+	m_Instance.getLogicalDevice().access([this, &write](VkDevice logicalDevice)
+		{
+			m_Instance.getDeviceTable().vkUpdateDescriptorSets(logicalDevice, 1, &write, 0, nullptr);
+		}
+	);
+}
+
+void ComputePipeline::writeImage(VkDescriptorSet descriptorSet, uint32_t binding, VkDescriptorType type, VkImageView imageView, VkImageLayout layout)
+{
+	if (descriptorSet == VK_NULL_HANDLE)
+		return;
+
+	const VkDescriptorImageInfo imageInfo = { VK_NULL_HANDLE, imageView, layout };
+
+	VkWriteDescriptorSet write = {};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.pNext = nullptr;
+	write.dstSet = descriptorSet;
+	write.dstBinding = binding;
+	write.dstArrayElement = 0;
+	write.descriptorCount = 1;
+	write.descriptorType = type;
+	write.pImageInfo = &imageInfo;
+	write.pBufferInfo = nullptr;
+	write.pTexelBufferView = nullptr;
+
+	m_Instance.getLogicalDevice().access([this, &write](VkDevice logicalDevice)
+		{
+			m_Instance.getDeviceTable().vkUpdateDescriptorSets(logicalDevice, 1, &write, 0, nullptr);
+		}
+	);
+}
+
+void ComputePipeline::bind(VkCommandBuffer commandBuffer, std::initializer_list<VkDescriptorSet> descriptorSets) const
+{
+	const auto& deviceTable = m_Instance.getDeviceTable();
+	deviceTable.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipeline);
+
+	if (descriptorSets.size() > 0)
+		deviceTable.vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout, 0, static_cast<uint32_t>(descriptorSets.size()), descriptorSets.begin(), 0, nullptr);
+}
+
+void ComputePipeline::pushConstants(VkCommandBuffer commandBuffer, const void* pData, uint32_t size) const
+{
+	m_Instance.getDeviceTable().vkCmdPushConstants(commandBuffer, m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, size, pData);
+}
+
+void ComputePipeline::RecordMemoryBarrier(
+	const VolkDeviceTable& deviceTable,
+	VkCommandBuffer commandBuffer,
+	VkPipelineStageFlags2KHR srcStageMask,
+	VkAccessFlags2KHR srcAccessMask,
+	VkPipelineStageFlags2KHR dstStageMask,
+	VkAccessFlags2KHR dstAccessMask)
+{
+	VkMemoryBarrier2KHR barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2_KHR;
+	barrier.pNext = nullptr;
+	barrier.srcStageMask = srcStageMask;
+	barrier.srcAccessMask = srcAccessMask;
+	barrier.dstStageMask = dstStageMask;
+	barrier.dstAccessMask = dstAccessMask;
+
+	VkDependencyInfoKHR dependencyInfo = {};
+	dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+	dependencyInfo.pNext = nullptr;
+	dependencyInfo.dependencyFlags = 0;
+	dependencyInfo.memoryBarrierCount = 1;
+	dependencyInfo.pMemoryBarriers = &barrier;
+	dependencyInfo.bufferMemoryBarrierCount = 0;
+	dependencyInfo.pBufferMemoryBarriers = nullptr;
+	dependencyInfo.imageMemoryBarrierCount = 0;
+	dependencyInfo.pImageMemoryBarriers = nullptr;
+
+	deviceTable.vkCmdPipelineBarrier2KHR(commandBuffer, &dependencyInfo);
+}
+
+std::vector<uint32_t> ComputePipeline::ReadShaderCode(const std::filesystem::path& path)
+{
+	auto file = std::ifstream(path, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		return {};
+
+	const auto size = static_cast<uint64_t>(file.tellg());
+	if (size == 0 || size % sizeof(uint32_t) != 0)
+		return {};
+
+	std::vector<uint32_t> code(size / sizeof(uint32_t));
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(code.data()), static_cast<std::streamsize>(size));
+
+	return code;
+}
@@ -0,0 +1,142 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "InstanceBoundObject.hpp"
+
+#include <volk.h>
+
+#include <filesystem>
+#include <initializer_list>
+#include <vector>
+
+/**
+ * Compute pipeline class.
+ * This loads a compiled SPIR-V compute shader and creates the pipeline, it's layout and a descriptor pool for it's sets. The descriptor set layouts
+ * are described by their bindings, and sets with identical bindings are compatible between pipelines, so a set can be shared by multiple pipelines.
+ *
+ * All the objects are retired to the deletion queue when the pipeline is destroyed.
+ */
+class ComputePipeline final : public InstanceBoundObject
+{
+public:
+	using SetBindings = std::vector<VkDescriptorSetLayoutBinding>;
+
+public:
+	/**
+	 * Explicit constructor.
+	 *
+	 * @param instance The instance reference.
+	 * @param shaderPath The compiled shader's path.
+	 * @param setBindings The bindings of each descriptor set.
+	 * @param pushConstantSize The size of the push constants. 0 if the shader has none.
+	 * @param maximumSetsPerLayout The maximum number of descriptor sets which can be allocated for each layout.
+	 */
+	explicit ComputePipeline(Instance& instance, const std::filesystem::path& shaderPath, const std::vector<SetBindings>& setBindings, uint32_t pushConstantSize, uint32_t maximumSetsPerLayout);
+
+	/**
+	 * Destructor.
+	 */
+	~ComputePipeline() override;
+
+	/**
+	 * Check if the pipeline was created.
+	 * This fails if the shader could not be read.
+	 *
+	 * @return True if the pipeline can be used.
+	 */
+	[[nodiscard]] bool isValid() const { return m_Pipeline != VK_NULL_HANDLE; }
+
+	/**
+	 * Allocate a descriptor set.
+	 *
+	 * @param set The set index.
+	 * @return The descriptor set.
+	 */
+	[[nodiscard]] VkDescriptorSet allocateDescriptorSet(uint32_t set);
+
+	/**
+	 * Write a buffer to a descriptor set.
+	 *
+	 * @param descriptorSet The descriptor set.
+	 * @param binding The binding index.
+	 * @param type The descriptor type.
+	 * @param buffer The buffer. The whole buffer is bound.
+	 */
+	void writeBuffer(VkDescriptorSet descriptorSet, uint32_t binding, VkDescriptorType type, VkBuffer buffer);
+
+	/**
+	 * Write an image to a descriptor set.
+	 *
+	 * @param descriptorSet The descriptor set.
+	 * @param binding The binding index.
+	 * @param type The descriptor type.
+	 * @param imageView The image view.
+	 * @param layout The layout the image is in when the pipeline accesses it.
+	 */
+	void writeImage(VkDescriptorSet descriptorSet, uint32_t binding, VkDescriptorType type, VkImageView imageView, VkImageLayout layout);
+
+	/**
+	 * Bind the pipeline and it's descriptor sets.
+	 *
+	 * @param commandBuffer The command buffer to record to.
+	 * @param descriptorSets The descriptor sets, starting from set 0.
+	 */
+	void bind(VkCommandBuffer commandBuffer, std::initializer_list<VkDescriptorSet> descriptorSets) const;
+
+	/**
+	 * Push the constants.
+	 *
+	 * @tparam Type The constants type.
+	 * @param commandBuffer The command buffer to record to.
+	 * @param constants The constants.
+	 */
+	template<class Type>
+	void pushConstants(VkCommandBuffer commandBuffer, const Type& constants) const { pushConstants(commandBuffer, &constants, sizeof(Type)); }
+
+	/**
+	 * Push the constants.
+	 *
+	 * @param commandBuffer The command buffer to record to.
+	 * @param pData The constant data.
+	 * @param size The size of the data.
+	 */
+	void pushConstants(VkCommandBuffer commandBuffer, const void* pData, uint32_t size) const;
+
+	/**
+	 * Record a global memory barrier.
+	 * Compute passes mostly synchronize with whole passes, so this is simpler than listing every buffer and image.
+	 *
+	 * @param deviceTable The device table.
+	 * @param commandBuffer The command buffer to record to.
+	 * @param srcStageMask The source stage mask.
+	 * @param srcAccessMask The source access mask.
+	 * @param dstStageMask The destination stage mask.
+	 * @param dstAccessMask The destination access mask.
+	 */
+	static void RecordMemoryBarrier(
+		const VolkDeviceTable& deviceTable,
+		VkCommandBuffer commandBuffer,
+		VkPipelineStageFlags2KHR srcStageMask,
+		VkAccessFlags2KHR srcAccessMask,
+		VkPipelineStageFlags2KHR dstStageMask,
+		VkAccessFlags2KHR dstAccessMask);
+
+	/**
+	 * Read a compiled SPIR-V shader.
+	 *
+	 * @param path The shader path.
+	 * @return The shader code. This is empty if the file could not be read.
+	 */
+	[[nodiscard]] static std::vector<uint32_t> ReadShaderCode(const std::filesystem::path& path);
+
+public:
+	GRAPHITE_SETUP_SIMPLE_GETTER(VkPipeline, Pipeline, m_Pipeline);
+	GRAPHITE_SETUP_SIMPLE_GETTER(VkPipelineLayout, PipelineLayout, m_PipelineLayout);
+
+private:
+	std::vector<VkDescriptorSetLayout> m_DescriptorSetLayouts;
+	VkDescriptorPool m_DescriptorPool = VK_NULL_HANDLE;
+	VkPipelineLayout m_PipelineLayout = VK_NULL_HANDLE;
+	VkPipeline m_Pipeline = VK_NULL_HANDLE;
+};
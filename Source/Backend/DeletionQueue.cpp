@@ -0,0 +1,123 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "DeletionQueue.hpp"
+#include "Instance.hpp"
+
+#include <optick.h>
+
+DeletionQueue::~DeletionQueue()
+{
+	releaseAll();
+}
+
+void DeletionQueue::retire(VkBuffer buffer, VmaAllocation allocation)
+{
+	const auto lock = std::scoped_lock(m_Mutex);
+	m_CurrentFrame.m_Buffers.emplace_back(buffer, allocation);
+}
+
+void DeletionQueue::retire(VkImage image, VmaAllocation allocation)
+{
+	const auto lock = std::scoped_lock(m_Mutex);
+	m_CurrentFrame.m_Images.emplace_back(image, allocation);
+}
+
+void DeletionQueue::retire(VkImageView imageView)
+{
+	const auto lock = std::scoped_lock(m_Mutex);
+	m_CurrentFrame.m_ImageViews.emplace_back(imageView);
+}
+
+void DeletionQueue::retire(std::function<void(VkDevice)> destructor)
+{
+	const auto lock = std::scoped_lock(m_Mutex);
+	m_CurrentFrame.m_Destructors.emplace_back(std::move(destructor));
+}
+
+void DeletionQueue::closeFrame(const TimelineValues& timelineValues)
+{
+	const auto lock = std::scoped_lock(m_Mutex);
+	if (m_CurrentFrame.isEmpty())
+		return;
+
+	m_CurrentFrame.m_TimelineValues = timelineValues;
+	m_ClosedFrames.emplace_back(std::move(m_CurrentFrame));
+
+	// Reuse a released frame so retiring does not allocate in the steady state.
+	if (m_FreeFrames.empty())
+	{
+		m_CurrentFrame = RetiredFrame();
+	}
+	else
+	{
+		m_CurrentFrame = std::move(m_FreeFrames.back());
+		m_FreeFrames.pop_back();
+	}
+}
+
+void DeletionQueue::collect(const TimelineValues& completedValues)
+{
+	OPTICK_EVENT();
+
+	const auto lock = std::scoped_lock(m_Mutex);
+
+	// Frames are closed in submission order, so we can stop at the first one the GPU is not done with.
+	while (!m_ClosedFrames.empty())
+	{
+		auto& frame = m_ClosedFrames.front();
+		for (uint8_t i = 0; i < completedValues.size(); i++)
+		{
+			if (completedValues[i] < frame.m_TimelineValues[i])
+				return;
+		}
+
+		release(frame);
+		m_FreeFrames.emplace_back(std::move(frame));
+		m_ClosedFrames.pop_front();
+	}
+}
+
+void DeletionQueue::releaseAll()
+{
+	const auto lock = std::scoped_lock(m_Mutex);
+
+	for (auto& frame : m_ClosedFrames)
+		release(frame);
+
+	release(m_CurrentFrame);
+	m_ClosedFrames.clear();
+}
+
+void DeletionQueue::release(RetiredFrame& frame)
+{
+	if (!frame.m_ImageViews.empty() || !frame.m_Destructors.empty())
+	{
+		m_Instance.getLogicalDevice().access([this, &frame](VkDevice logicalDevice)
+			{
+				for (const auto imageView : frame.m_ImageViews)
+					m_Instance.getDeviceTable().vkDestroyImageView(logicalDevice, imageView, nullptr);
+
+				for (const auto& destructor : frame.m_Destructors)
+					destructor(logicalDevice);
+			}
+		);
+	}
+
+	if (!frame.m_Buffers.empty() || !frame.m_Images.empty())
+	{
+		m_Instance.getAllocator().access([&frame](VmaAllocator allocator)
+			{
+				for (const auto [buffer, allocation] : frame.m_Buffers)
+					vmaDestroyBuffer(allocator, buffer, allocation);
+
+				for (const auto [image, allocation] : frame.m_Images)
+					vmaDestroyImage(allocator, image, allocation);
+			}
+		);
+	}
+
+	frame.m_Buffers.clear();
+	frame.m_Images.clear();
+	frame.m_ImageViews.clear();
+	frame.m_Destructors.clear();
+}
@@ -0,0 +1,130 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "InstanceBoundObject.hpp"
+
+#include <array>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+/**
+ * Deletion queue class.
+ * Resources can't be destroyed while the GPU might still be using them, and waiting for the device to be idle stalls the whole frame. So instead,
+ * destroyed resources are retired to the current frame, and the frame is closed with the timeline values submitted till then. Once the GPU passes
+ * all those values, the whole frame's resources are released in one go.
+ */
+class DeletionQueue final : public InstanceBoundObject
+{
+public:
+	using TimelineValues = std::array<uint64_t, 3>;
+
+private:
+	/**
+	 * Retired frame structure.
+	 * This contains all the resources retired in a single frame.
+	 */
+	struct RetiredFrame final
+	{
+		TimelineValues m_TimelineValues = {};
+
+		std::vector<std::pair<VkBuffer, VmaAllocation>> m_Buffers;
+		std::vector<std::pair<VkImage, VmaAllocation>> m_Images;
+		std::vector<VkImageView> m_ImageViews;
+		std::vector<std::function<void(VkDevice)>> m_Destructors;
+
+		/**
+		 * Check if the frame has any resources.
+		 *
+		 * @return True if there is nothing to release.
+		 */
+		[[nodiscard]] bool isEmpty() const { return m_Buffers.empty() && m_Images.empty() && m_ImageViews.empty() && m_Destructors.empty(); }
+	};
+
+public:
+	/**
+	 * Explicit constructor.
+	 *
+	 * @param instance The instance reference.
+	 */
+	explicit DeletionQueue(Instance& instance) : InstanceBoundObject(instance) {}
+
+	/**
+	 * Destructor.
+	 */
+	~DeletionQueue() override;
+
+	/**
+	 * Retire a buffer.
+	 * This is thread safe.
+	 *
+	 * @param buffer The buffer handle.
+	 * @param allocation The buffer's allocation.
+	 */
+	void retire(VkBuffer buffer, VmaAllocation allocation);
+
+	/**
+	 * Retire an image.
+	 * This is thread safe.
+	 *
+	 * @param image The image handle.
+	 * @param allocation The image's allocation.
+	 */
+	void retire(VkImage image, VmaAllocation allocation);
+
+	/**
+	 * Retire an image view.
+	 * This is thread safe.
+	 *
+	 * @param imageView The image view handle.
+	 */
+	void retire(VkImageView imageView);
+
+	/**
+	 * Retire any other device object.
+	 * This is meant for objects which are rarely destroyed, like pipelines and descriptor pools, so they don't need a list of their own.
+	 * This is thread safe.
+	 *
+	 * @param destructor The function to destroy the object with. This is called with the device locked.
+	 */
+	void retire(std::function<void(VkDevice)> destructor);
+
+	/**
+	 * Close the current frame.
+	 * The resources retired so far are released once every queue type reaches the given timeline value.
+	 *
+	 * @param timelineValues The last submitted timeline value of each queue type.
+	 */
+	void closeFrame(const TimelineValues& timelineValues);
+
+	/**
+	 * Release the resources of all the closed frames which the GPU is done with.
+	 *
+	 * @param completedValues The completed timeline value of each queue type.
+	 */
+	void collect(const TimelineValues& completedValues);
+
+	/**
+	 * Release everything, including the resources of the current frame.
+	 * Make sure that the device is idle before calling this.
+	 */
+	void releaseAll();
+
+private:
+	/**
+	 * Release the resources of a frame.
+	 * The frame is cleared but keeps it's memory so it can be reused.
+	 *
+	 * @param frame The frame to release.
+	 */
+	void release(RetiredFrame& frame);
+
+private:
+	RetiredFrame m_CurrentFrame;
+	std::deque<RetiredFrame> m_ClosedFrames;
+	std::vector<RetiredFrame> m_FreeFrames;
+
+	std::mutex m_Mutex;
+};
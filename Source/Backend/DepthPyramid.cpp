@@ -0,0 +1,238 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "DepthPyramid.hpp"
+#include "Instance.hpp"
+#include "VulkanMacros.hpp"
+
+#include <optick.h>
+
+#include <algorithm>
+
+namespace /* anonymous */
+{
+	// The reduction shader's thread group size in each dimension.
+	constexpr uint32_t g_ReductionGroupSize = 8;
+
+	/**
+	 * Create the image builder of the pyramid.
+	 *
+	 * @param width The depth buffer's width.
+	 * @param height The depth buffer's height.
+	 * @return The image builder.
+	 */
+	[[nodiscard]] ImageBuilder CreatePyramidBuilder(uint32_t width, uint32_t height)
+	{
+		return ImageBuilder()
+			.setWidth(std::max((width + 1) / 2, 1u))
+			.setHeight(std::max((height + 1) / 2, 1u))
+			.setUsage(VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+	}
+}
+
+DepthPyramid::DepthPyramid(
+	Instance& instance,
+	VkImageView depthView,
+	uint32_t width,
+	uint32_t height,
+	VkImageLayout depthLayout /*= VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL*/,
+	const std::filesystem::path& shaderPath /*= "Shaders/DepthPyramid.spv"*/)
+	: InstanceBoundObject(instance)
+	, m_Image(instance, CreatePyramidBuilder(width, height), VK_FORMAT_R32_SFLOAT)
+	, m_Pipeline(instance, shaderPath,
+		{ {
+			VkDescriptorSetLayoutBinding{ 0, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+			VkDescriptorSetLayoutBinding{ 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr }
+		} },
+		sizeof(ReductionConstants), m_Image.getMipLevels())
+	, m_DepthWidth(width)
+	, m_DepthHeight(height)
+{
+	// Each mip is written through it's own view, and read through it by the next mip.
+	m_MipViews.reserve(m_Image.getMipLevels());
+	m_MipDescriptorSets.reserve(m_Image.getMipLevels());
+
+	for (uint32_t mip = 0; mip < m_Image.getMipLevels(); mip++)
+	{
+		m_MipViews.emplace_back(createView(mip, 1));
+
+		const auto descriptorSet = m_MipDescriptorSets.emplace_back(m_Pipeline.allocateDescriptorSet(0));
+		if (mip == 0)
+			m_Pipeline.writeImage(descriptorSet, 0, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, depthView, depthLayout);
+		else
+			m_Pipeline.writeImage(descriptorSet, 0, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, m_MipViews[mip - 1], VK_IMAGE_LAYOUT_GENERAL);
+
+		m_Pipeline.writeImage(descriptorSet, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, m_MipViews[mip], VK_IMAGE_LAYOUT_GENERAL);
+	}
+
+	m_View = createView(0, m_Image.getMipLevels());
+	createSamplingDescriptorSet();
+}
+
+DepthPyramid::~DepthPyramid()
+{
+	auto& deletionQueue = m_Instance.getDeletionQueue();
+	for (const auto view : m_MipViews)
+		deletionQueue.retire(view);
+
+	deletionQueue.retire(m_View);
+	deletionQueue.retire([&deviceTable = m_Instance.getDeviceTable(), descriptorPool = m_SamplingDescriptorPool, setLayout = m_SamplingSetLayout](VkDevice logicalDevice)
+		{
+			deviceTable.vkDestroyDescriptorPool(logicalDevice, descriptorPool, nullptr);
+			deviceTable.vkDestroyDescriptorSetLayout(logicalDevice, setLayout, nullptr);
+		}
+	);
+}
+
+void DepthPyramid::build(VkCommandBuffer commandBuffer)
+{
+	OPTICK_EVENT();
+
+	if (!m_Pipeline.isValid())
+		return;
+
+	const auto& deviceTable = m_Instance.getDeviceTable();
+
+	// The image is only transitioned once, it stays in the general layout after that.
+	if (!m_bIsInitialized)
+	{
+		VkImageMemoryBarrier2KHR barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+		barrier.pNext = nullptr;
+		barrier.srcStageMask = VK_PIPELINE_STAGE_2_NONE_KHR;
+		barrier.srcAccessMask = VK_ACCESS_2_NONE_KHR;
+		barrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR;
+		barrier.dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = m_Image.getImage();
+		barrier.subresourceRange = VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, m_Image.getMipLevels(), 0, 1 };
+
+		VkDependencyInfoKHR dependencyInfo = {};
+		dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+		dependencyInfo.pNext = nullptr;
+		dependencyInfo.dependencyFlags = 0;
+		dependencyInfo.memoryBarrierCount = 0;
+		dependencyInfo.pMemoryBarriers = nullptr;
+		dependencyInfo.bufferMemoryBarrierCount = 0;
+		dependencyInfo.pBufferMemoryBarriers = nullptr;
+		dependencyInfo.imageMemoryBarrierCount = 1;
+		dependencyInfo.pImageMemoryBarriers = &barrier;
+
+		deviceTable.vkCmdPipelineBarrier2KHR(commandBuffer, &dependencyInfo);
+		m_bIsInitialized = true;
+	}
+
+	// Wait for the depth writes, and for the culling passes of the last frame to be done reading the pyramid.
+	ComputePipeline::RecordMemoryBarrier(deviceTable, commandBuffer,
+		VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR,
+		VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT_KHR | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR);
+
+	auto sourceWidth = m_DepthWidth;
+	auto sourceHeight = m_DepthHeight;
+
+	for (uint32_t mip = 0; mip < m_Image.getMipLevels(); mip++)
+	{
+		ReductionConstants constants;
+		constants.m_SourceWidth = sourceWidth;
+		constants.m_SourceHeight = sourceHeight;
+		constants.m_DestinationWidth = std::max(m_Image.getWidth() >> mip, 1u);
+		constants.m_DestinationHeight = std::max(m_Image.getHeight() >> mip, 1u);
+
+		m_Pipeline.bind(commandBuffer, { m_MipDescriptorSets[mip] });
+		m_Pipeline.pushConstants(commandBuffer, constants);
+		deviceTable.vkCmdDispatch(commandBuffer,
+			(constants.m_DestinationWidth + g_ReductionGroupSize - 1) / g_ReductionGroupSize,
+			(constants.m_DestinationHeight + g_ReductionGroupSize - 1) / g_ReductionGroupSize, 1);
+
+		// The next mip reads this one, and the culling passes read all of them.
+		ComputePipeline::RecordMemoryBarrier(deviceTable, commandBuffer,
+			VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR,
+			VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT_KHR);
+
+		sourceWidth = constants.m_DestinationWidth;
+		sourceHeight = constants.m_DestinationHeight;
+	}
+}
+
+VkDescriptorSetLayoutBinding DepthPyramid::GetSamplingBinding(uint32_t binding /*= 0*/)
+{
+	return VkDescriptorSetLayoutBinding{ binding, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr };
+}
+
+VkImageView DepthPyramid::createView(uint32_t firstMip, uint32_t mipCount)
+{
+	VkImageViewCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	createInfo.pNext = nullptr;
+	createInfo.flags = 0;
+	createInfo.image = m_Image.getImage();
+	createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	createInfo.format = m_Image.getFormat();
+	createInfo.components = { VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY };
+	createInfo.subresourceRange = VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, firstMip, mipCount, 0, 1 };
+
+	VkImageView view = VK_NULL_HANDLE;
+	m_Instance.getLogicalDevice().access([this, &createInfo, &view](VkDevice logicalDevice)
+		{
+			GRAPHITE_VK_ASSERT(m_Instance.getDeviceTable().vkCreateImageView(logicalDevice, &createInfo, nullptr, &view), "Failed to create the depth pyramid view!");
+		}
+	);
+
+	return view;
+}
+
+void DepthPyramid::createSamplingDescriptorSet()
+{
+	const auto binding = GetSamplingBinding();
+
+	VkDescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+	layoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutCreateInfo.pNext = nullptr;
+	layoutCreateInfo.flags = 0;
+	layoutCreateInfo.bindingCount = 1;
+	layoutCreateInfo.pBindings = &binding;
+
+	const VkDescriptorPoolSize poolSize = { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1 };
+
+	VkDescriptorPoolCreateInfo poolCreateInfo = {};
+	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolCreateInfo.pNext = nullptr;
+	poolCreateInfo.flags = 0;
+	poolCreateInfo.maxSets = 1;
+	poolCreateInfo.poolSizeCount = 1;
+	poolCreateInfo.pPoolSizes = &poolSize;
+
+	m_Instance.getLogicalDevice().access([this, &layoutCreateInfo, &poolCreateInfo](VkDevice logicalDevice)
+		{
+			const auto& deviceTable = m_Instance.getDeviceTable();
+			GRAPHITE_VK_ASSERT(deviceTable.vkCreateDescriptorSetLayout(logicalDevice, &layoutCreateInfo, nullptr, &m_SamplingSetLayout), "Failed to create the depth pyramid sampling layout!");
+			GRAPHITE_VK_ASSERT(deviceTable.vkCreateDescriptorPool(logicalDevice, &poolCreateInfo, nullptr, &m_SamplingDescriptorPool), "Failed to create the depth pyramid descriptor pool!");
+
+			VkDescriptorSetAllocateInfo allocateInfo = {};
+			allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+			allocateInfo.pNext = nullptr;
+			allocateInfo.descriptorPool = m_SamplingDescriptorPool;
+			allocateInfo.descriptorSetCount = 1;
+			allocateInfo.pSetLayouts = &m_SamplingSetLayout;
+			GRAPHITE_VK_ASSERT(deviceTable.vkAllocateDescriptorSets(logicalDevice, &allocateInfo, &m_SamplingDescriptorSet), "Failed to allocate the depth pyramid sampling set!");
+
+			const VkDescriptorImageInfo imageInfo = { VK_NULL_HANDLE, m_View, VK_IMAGE_LAYOUT_GENERAL };
+
+			VkWriteDescriptorSet write = {};
+			write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write.pNext = nullptr;
+			write.dstSet = m_SamplingDescriptorSet;
+			write.dstBinding = 0;
+			write.dstArrayElement = 0;
+			write.descriptorCount = 1;
+			write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+			write.pImageInfo = &imageInfo;
+			write.pBufferInfo = nullptr;
+			write.pTexelBufferView = nullptr;
+
+			deviceTable.vkUpdateDescriptorSets(logicalDevice, 1, &write, 0, nullptr);
+		}
+	);
+}
@@ -0,0 +1,118 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "ComputePipeline.hpp"
+#include "Image.hpp"
+
+/**
+ * Depth pyramid class.
+ * This is a hierarchical depth buffer used for occlusion culling. Each mip stores the farthest depth of the texels it covers in the mip above, so
+ * a single lookup in the right mip tells if anything behind a given depth can be visible in an area. The first mip is half the size of the depth
+ * buffer, and the depth is expected to be in the [0, 1] range with 0 being the nearest.
+ *
+ * The pyramid is built from a depth buffer every frame. If the depth buffer is resized, the pyramid should be recreated.
+ */
+class DepthPyramid final : public InstanceBoundObject
+{
+	/**
+	 * Reduction constants structure.
+	 * This is pushed to the reduction shader.
+	 */
+	struct ReductionConstants final
+	{
+		uint32_t m_SourceWidth = 0;
+		uint32_t m_SourceHeight = 0;
+		uint32_t m_DestinationWidth = 0;
+		uint32_t m_DestinationHeight = 0;
+	};
+
+public:
+	/**
+	 * Explicit constructor.
+	 *
+	 * @param instance The instance reference.
+	 * @param depthView The depth buffer's view. This must only contain the depth aspect.
+	 * @param width The depth buffer's width.
+	 * @param height The depth buffer's height.
+	 * @param depthLayout The layout the depth buffer is in when the pyramid is built. Default is the depth read only layout.
+	 * @param shaderPath The compiled reduction shader's path. Default is Shaders/DepthPyramid.spv.
+	 */
+	explicit DepthPyramid(
+		Instance& instance,
+		VkImageView depthView,
+		uint32_t width,
+		uint32_t height,
+		VkImageLayout depthLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+		const std::filesystem::path& shaderPath = "Shaders/DepthPyramid.spv");
+
+	/**
+	 * Destructor.
+	 */
+	~DepthPyramid() override;
+
+	/**
+	 * Record the pyramid build.
+	 * The depth buffer must be in the depth layout given to the constructor. The pyramid is left in the general layout, and the reads of the
+	 * following compute passes are synchronized.
+	 *
+	 * @param commandBuffer The command buffer to record to.
+	 */
+	void build(VkCommandBuffer commandBuffer);
+
+	/**
+	 * Get the binding the occlusion culling shaders use to sample the pyramid.
+	 * The sampling descriptor set has only this binding at index 0, so it's compatible with any set layout made of it.
+	 *
+	 * @param binding The binding index.
+	 * @return The descriptor set layout binding.
+	 */
+	[[nodiscard]] static VkDescriptorSetLayoutBinding GetSamplingBinding(uint32_t binding = 0);
+
+	/**
+	 * Check if the pyramid can be built.
+	 *
+	 * @return True if the reduction shader was loaded.
+	 */
+	[[nodiscard]] bool isValid() const { return m_Pipeline.isValid(); }
+
+public:
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, Width, m_Image.getWidth());
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, Height, m_Image.getHeight());
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, MipLevels, m_Image.getMipLevels());
+	GRAPHITE_SETUP_SIMPLE_GETTER(VkImageView, View, m_View);
+	GRAPHITE_SETUP_SIMPLE_GETTER(VkDescriptorSet, SamplingDescriptorSet, m_SamplingDescriptorSet);
+
+private:
+	/**
+	 * Create an image view.
+	 *
+	 * @param firstMip The first mip of the view.
+	 * @param mipCount The number of mips in the view.
+	 * @return The image view.
+	 */
+	[[nodiscard]] VkImageView createView(uint32_t firstMip, uint32_t mipCount);
+
+	/**
+	 * Create the descriptor set the culling shaders sample the pyramid with.
+	 */
+	void createSamplingDescriptorSet();
+
+private:
+	Image m_Image;
+	ComputePipeline m_Pipeline;
+
+	std::vector<VkImageView> m_MipViews;
+	std::vector<VkDescriptorSet> m_MipDescriptorSets;
+
+	VkImageView m_View = VK_NULL_HANDLE;
+
+	VkDescriptorSetLayout m_SamplingSetLayout = VK_NULL_HANDLE;
+	VkDescriptorPool m_SamplingDescriptorPool = VK_NULL_HANDLE;
+	VkDescriptorSet m_SamplingDescriptorSet = VK_NULL_HANDLE;
+
+	uint32_t m_DepthWidth = 0;
+	uint32_t m_DepthHeight = 0;
+
+	bool m_bIsInitialized = false;
+};
@@ -0,0 +1,390 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "DynamicResolution.hpp"
+#include "Instance.hpp"
+#include "VulkanMacros.hpp"
+
+#include <optick.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace /* anonymous */
+{
+	// The upscale shader's thread group size in each dimension.
+	constexpr uint32_t g_UpscaleGroupSize = 8;
+
+	// The scene colors are stored as half floats so the upscale does not add banding.
+	constexpr VkFormat g_ColorFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+	/**
+	 * Get the bindings of the upscale descriptor set.
+	 *
+	 * @return The bindings.
+	 */
+	[[nodiscard]] ComputePipeline::SetBindings GetUpscaleBindings()
+	{
+		return {
+			VkDescriptorSetLayoutBinding{ 0, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+			VkDescriptorSetLayoutBinding{ 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr }
+		};
+	}
+
+	/**
+	 * Create an image barrier for the whole image.
+	 *
+	 * @param image The image.
+	 * @param aspect The image aspect.
+	 * @param srcStageMask The stages which must be done.
+	 * @param srcAccessMask The accesses which must be made available.
+	 * @param dstStageMask The stages which wait.
+	 * @param dstAccessMask The accesses which wait.
+	 * @param oldLayout The current layout.
+	 * @param newLayout The new layout.
+	 * @return The barrier.
+	 */
+	[[nodiscard]] VkImageMemoryBarrier2KHR CreateImageBarrier(
+		VkImage image,
+		VkImageAspectFlags aspect,
+		VkPipelineStageFlags2KHR srcStageMask,
+		VkAccessFlags2KHR srcAccessMask,
+		VkPipelineStageFlags2KHR dstStageMask,
+		VkAccessFlags2KHR dstAccessMask,
+		VkImageLayout oldLayout,
+		VkImageLayout newLayout)
+	{
+		VkImageMemoryBarrier2KHR barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+		barrier.pNext = nullptr;
+		barrier.srcStageMask = srcStageMask;
+		barrier.srcAccessMask = srcAccessMask;
+		barrier.dstStageMask = dstStageMask;
+		barrier.dstAccessMask = dstAccessMask;
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = newLayout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange = VkImageSubresourceRange{ aspect, 0, 1, 0, 1 };
+
+		return barrier;
+	}
+
+	/**
+	 * Record image barriers.
+	 *
+	 * @param deviceTable The device table.
+	 * @param commandBuffer The command buffer to record to.
+	 * @param barriers The barriers.
+	 */
+	void RecordImageBarriers(const VolkDeviceTable& deviceTable, VkCommandBuffer commandBuffer, std::span<const VkImageMemoryBarrier2KHR> barriers)
+	{
+		VkDependencyInfoKHR dependencyInfo = {};
+		dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+		dependencyInfo.pNext = nullptr;
+		dependencyInfo.dependencyFlags = 0;
+		dependencyInfo.memoryBarrierCount = 0;
+		dependencyInfo.pMemoryBarriers = nullptr;
+		dependencyInfo.bufferMemoryBarrierCount = 0;
+		dependencyInfo.pBufferMemoryBarriers = nullptr;
+		dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(barriers.size());
+		dependencyInfo.pImageMemoryBarriers = barriers.data();
+
+		deviceTable.vkCmdPipelineBarrier2KHR(commandBuffer, &dependencyInfo);
+	}
+}
+
+DynamicResolution::Target::Target(Instance& instance, const ImageBuilder& builder, VkFormat format, VkImageAspectFlags aspect)
+	: InstanceBoundObject(instance)
+	, m_Image(instance, builder, format)
+{
+	VkImageViewCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	createInfo.pNext = nullptr;
+	createInfo.flags = 0;
+	createInfo.image = m_Image.getImage();
+	createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	createInfo.format = format;
+	createInfo.components = { VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY };
+	createInfo.subresourceRange = VkImageSubresourceRange{ aspect, 0, 1, 0, 1 };
+
+	m_Instance.getLogicalDevice().access([this, &createInfo](VkDevice logicalDevice)
+		{
+			GRAPHITE_VK_ASSERT(m_Instance.getDeviceTable().vkCreateImageView(logicalDevice, &createInfo, nullptr, &m_View), "Failed to create the dynamic resolution target view!");
+		}
+	);
+}
+
+DynamicResolution::Target::~Target()
+{
+	m_Instance.getDeletionQueue().retire(m_View);
+}
+
+DynamicResolution::DynamicResolution(
+	Instance& instance,
+	uint32_t displayWidth,
+	uint32_t displayHeight,
+	const DynamicResolutionSettings& settings /*= DynamicResolutionSettings()*/,
+	const std::filesystem::path& shaderPath /*= "Shaders/Upscale.spv"*/)
+	: InstanceBoundObject(instance)
+	, m_Settings(settings)
+	, m_Controller(settings.m_Controller)
+	, m_Pipeline(instance, shaderPath, { GetUpscaleBindings() }, sizeof(UpscaleConstants), 1)
+{
+	m_Settings.m_BucketStep = std::clamp(m_Settings.m_BucketStep, 0.01f, 1.0f);
+
+	const auto depthBuilder = ImageBuilder()
+		.setWidth(1)
+		.setHeight(1)
+		.setEnableMipMaps(false)
+		.setUsage(VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+
+	m_DepthFormat = Image::ResolveFormat(instance, depthBuilder, { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT });
+	if (m_DepthFormat == VK_FORMAT_UNDEFINED)
+		GRAPHITE_LOG_FATAL("None of the depth formats can be used for the dynamic resolution targets!");
+
+	// The set layout of the upscale pass is created here so the sets can be given their own pools, which are retired with the targets.
+	const auto bindings = GetUpscaleBindings();
+
+	VkDescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+	layoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutCreateInfo.pNext = nullptr;
+	layoutCreateInfo.flags = 0;
+	layoutCreateInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	layoutCreateInfo.pBindings = bindings.data();
+
+	m_Instance.getLogicalDevice().access([this, &layoutCreateInfo](VkDevice logicalDevice)
+		{
+			GRAPHITE_VK_ASSERT(m_Instance.getDeviceTable().vkCreateDescriptorSetLayout(logicalDevice, &layoutCreateInfo, nullptr, &m_SetLayout), "Failed to create the upscale set layout!");
+		}
+	);
+
+	resize(displayWidth, displayHeight);
+}
+
+DynamicResolution::~DynamicResolution()
+{
+	m_Instance.getDeletionQueue().retire([&deviceTable = m_Instance.getDeviceTable(), descriptorPool = m_DescriptorPool, setLayout = m_SetLayout](VkDevice logicalDevice)
+		{
+			deviceTable.vkDestroyDescriptorPool(logicalDevice, descriptorPool, nullptr);
+			deviceTable.vkDestroyDescriptorSetLayout(logicalDevice, setLayout, nullptr);
+		}
+	);
+}
+
+bool DynamicResolution::update(std::optional<std::chrono::nanoseconds> frameTime)
+{
+	OPTICK_EVENT();
+
+	if (frameTime)
+		m_Controller.addFrameTime(*frameTime);
+
+	// The targets already have the right size, and a pending shrink is cancelled.
+	const auto bucketScale = getBucketScale(m_Controller.getScale());
+	if (bucketScale == m_BucketScale)
+	{
+		m_ShrinkFrames = 0;
+		return false;
+	}
+
+	// Grow right away, since the scene would not fit otherwise.
+	if (bucketScale > m_BucketScale)
+	{
+		createTargets(bucketScale);
+		return true;
+	}
+
+	// Only shrink once the scale stayed low for a while, so a short spike does not cost two reallocations.
+	if (++m_ShrinkFrames < m_Settings.m_ShrinkDelay)
+		return false;
+
+	createTargets(bucketScale);
+	return true;
+}
+
+void DynamicResolution::resize(uint32_t displayWidth, uint32_t displayHeight)
+{
+	m_DisplayWidth = std::max(displayWidth, 1u);
+	m_DisplayHeight = std::max(displayHeight, 1u);
+
+	const auto outputBuilder = ImageBuilder()
+		.setWidth(m_DisplayWidth)
+		.setHeight(m_DisplayHeight)
+		.setEnableMipMaps(false)
+		.setUsage(VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+
+	m_pOutput = std::make_unique<Target>(m_Instance, outputBuilder, g_ColorFormat, VK_IMAGE_ASPECT_COLOR_BIT);
+
+	// The frame times of the old size don't apply to the new one.
+	m_Controller.reset();
+	createTargets(getBucketScale(m_Controller.getScale()));
+}
+
+void DynamicResolution::upscale(VkCommandBuffer commandBuffer, VkImage swapchainImage)
+{
+	OPTICK_EVENT();
+
+	if (!m_Pipeline.isValid())
+		return;
+
+	const auto& deviceTable = m_Instance.getDeviceTable();
+
+	// Wait for the scene, and for the last frame's copy to be done with the output. The output is written completely, so it's contents are discarded.
+	const std::array<VkImageMemoryBarrier2KHR, 2> upscaleBarriers = {
+		CreateImageBarrier(m_pColor->m_Image.getImage(), VK_IMAGE_ASPECT_COLOR_BIT,
+			VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR,
+			VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT_KHR,
+			VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
+		CreateImageBarrier(m_pOutput->m_Image.getImage(), VK_IMAGE_ASPECT_COLOR_BIT,
+			VK_PIPELINE_STAGE_2_BLIT_BIT_KHR, VK_ACCESS_2_NONE_KHR,
+			VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR,
+			VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL)
+	};
+
+	RecordImageBarriers(deviceTable, commandBuffer, upscaleBarriers);
+
+	const auto renderWidth = std::min(getRenderWidth(), getTargetWidth());
+	const auto renderHeight = std::min(getRenderHeight(), getTargetHeight());
+
+	UpscaleConstants constants;
+	constants.m_SourceScale = { static_cast<float>(renderWidth) / static_cast<float>(m_DisplayWidth), static_cast<float>(renderHeight) / static_cast<float>(m_DisplayHeight) };
+	constants.m_SourceWidth = renderWidth;
+	constants.m_SourceHeight = renderHeight;
+	constants.m_OutputWidth = m_DisplayWidth;
+	constants.m_OutputHeight = m_DisplayHeight;
+	constants.m_Sharpness = m_Settings.m_Sharpness;
+
+	m_Pipeline.bind(commandBuffer, { m_DescriptorSet });
+	m_Pipeline.pushConstants(commandBuffer, constants);
+	deviceTable.vkCmdDispatch(commandBuffer, (m_DisplayWidth + g_UpscaleGroupSize - 1) / g_UpscaleGroupSize, (m_DisplayHeight + g_UpscaleGroupSize - 1) / g_UpscaleGroupSize, 1);
+
+	// The swapchain images cannot be written by compute shaders, so the result is copied. The blit converts to the swapchain format.
+	const std::array<VkImageMemoryBarrier2KHR, 2> copyBarriers = {
+		CreateImageBarrier(m_pOutput->m_Image.getImage(), VK_IMAGE_ASPECT_COLOR_BIT,
+			VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR,
+			VK_PIPELINE_STAGE_2_BLIT_BIT_KHR, VK_ACCESS_2_TRANSFER_READ_BIT_KHR,
+			VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL),
+		// The acquire semaphore is waited at the blit stage, so using it as the source stage orders the layout change after the wait.
+		CreateImageBarrier(swapchainImage, VK_IMAGE_ASPECT_COLOR_BIT,
+			VK_PIPELINE_STAGE_2_BLIT_BIT_KHR, VK_ACCESS_2_NONE_KHR,
+			VK_PIPELINE_STAGE_2_BLIT_BIT_KHR, VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR,
+			VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
+	};
+
+	RecordImageBarriers(deviceTable, commandBuffer, copyBarriers);
+
+	VkImageBlit blit = {};
+	blit.srcSubresource = VkImageSubresourceLayers{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	blit.srcOffsets[1] = VkOffset3D{ static_cast<int32_t>(m_DisplayWidth), static_cast<int32_t>(m_DisplayHeight), 1 };
+	blit.dstSubresource = VkImageSubresourceLayers{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	blit.dstOffsets[1] = blit.srcOffsets[1];
+
+	deviceTable.vkCmdBlitImage(commandBuffer,
+		m_pOutput->m_Image.getImage(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		swapchainImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		1, &blit, VK_FILTER_NEAREST);
+
+	const auto presentBarrier = CreateImageBarrier(swapchainImage, VK_IMAGE_ASPECT_COLOR_BIT,
+		VK_PIPELINE_STAGE_2_BLIT_BIT_KHR, VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR,
+		VK_PIPELINE_STAGE_2_NONE_KHR, VK_ACCESS_2_NONE_KHR,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+
+	RecordImageBarriers(deviceTable, commandBuffer, std::span(&presentBarrier, 1));
+}
+
+float DynamicResolution::getBucketScale(float scale) const
+{
+	// The small bias keeps a scale which is a multiple of the step in it's own bucket despite the rounding.
+	const auto bucket = std::ceil(scale / m_Settings.m_BucketStep - 1e-4f);
+	return std::clamp(bucket * m_Settings.m_BucketStep, m_Settings.m_BucketStep, 1.0f);
+}
+
+void DynamicResolution::createTargets(float bucketScale)
+{
+	OPTICK_EVENT();
+
+	m_BucketScale = bucketScale;
+	m_ShrinkFrames = 0;
+
+	const auto width = std::max(static_cast<uint32_t>(std::ceil(static_cast<float>(m_DisplayWidth) * bucketScale)), 1u);
+	const auto height = std::max(static_cast<uint32_t>(std::ceil(static_cast<float>(m_DisplayHeight) * bucketScale)), 1u);
+
+	const auto colorBuilder = ImageBuilder()
+		.setWidth(width)
+		.setHeight(height)
+		.setEnableMipMaps(false)
+		.setUsage(VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+
+	const auto depthBuilder = ImageBuilder()
+		.setWidth(width)
+		.setHeight(height)
+		.setEnableMipMaps(false)
+		.setUsage(VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+
+	// The old targets are retired, so the frames in flight can still use them.
+	m_pColor = std::make_unique<Target>(m_Instance, colorBuilder, g_ColorFormat, VK_IMAGE_ASPECT_COLOR_BIT);
+	m_pDepth = std::make_unique<Target>(m_Instance, depthBuilder, m_DepthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
+
+	GRAPHITE_LOG_INFORMATION("Allocated the dynamic resolution targets at {}x{} for a {}x{} display.", width, height, m_DisplayWidth, m_DisplayHeight);
+	createDescriptorSet();
+}
+
+void DynamicResolution::createDescriptorSet()
+{
+	if (m_DescriptorPool != VK_NULL_HANDLE)
+	{
+		m_Instance.getDeletionQueue().retire([&deviceTable = m_Instance.getDeviceTable(), descriptorPool = m_DescriptorPool](VkDevice logicalDevice)
+			{
+				deviceTable.vkDestroyDescriptorPool(logicalDevice, descriptorPool, nullptr);
+			}
+		);
+	}
+
+	const std::array<VkDescriptorPoolSize, 2> poolSizes = {
+		VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1 },
+		VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1 }
+	};
+
+	VkDescriptorPoolCreateInfo poolCreateInfo = {};
+	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolCreateInfo.pNext = nullptr;
+	poolCreateInfo.flags = 0;
+	poolCreateInfo.maxSets = 1;
+	poolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	poolCreateInfo.pPoolSizes = poolSizes.data();
+
+	m_Instance.getLogicalDevice().access([this, &poolCreateInfo](VkDevice logicalDevice)
+		{
+			const auto& deviceTable = m_Instance.getDeviceTable();
+			GRAPHITE_VK_ASSERT(deviceTable.vkCreateDescriptorPool(logicalDevice, &poolCreateInfo, nullptr, &m_DescriptorPool), "Failed to create the upscale descriptor pool!");
+
+			VkDescriptorSetAllocateInfo allocateInfo = {};
+			allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+			allocateInfo.pNext = nullptr;
+			allocateInfo.descriptorPool = m_DescriptorPool;
+			allocateInfo.descriptorSetCount = 1;
+			allocateInfo.pSetLayouts = &m_SetLayout;
+			GRAPHITE_VK_ASSERT(deviceTable.vkAllocateDescriptorSets(logicalDevice, &allocateInfo, &m_DescriptorSet), "Failed to allocate the upscale descriptor set!");
+
+			const VkDescriptorImageInfo sourceInfo = { VK_NULL_HANDLE, m_pColor->m_View, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+			const VkDescriptorImageInfo outputInfo = { VK_NULL_HANDLE, m_pOutput->m_View, VK_IMAGE_LAYOUT_GENERAL };
+
+			std::array<VkWriteDescriptorSet, 2> writes = {};
+			for (uint32_t i = 0; i < writes.size(); i++)
+			{
+				writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				writes[i].pNext = nullptr;
+				writes[i].dstSet = m_DescriptorSet;
+				writes[i].dstBinding = i;
+				writes[i].dstArrayElement = 0;
+				writes[i].descriptorCount = 1;
+				writes[i].descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+				writes[i].pImageInfo = i == 0 ? &sourceInfo : &outputInfo;
+				writes[i].pBufferInfo = nullptr;
+				writes[i].pTexelBufferView = nullptr;
+			}
+
+			deviceTable.vkUpdateDescriptorSets(logicalDevice, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+		}
+	);
+}
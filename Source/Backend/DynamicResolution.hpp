@@ -0,0 +1,204 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "ComputePipeline.hpp"
+#include "Image.hpp"
+
+#include "Core/ResolutionController.hpp"
+
+#include <memory>
+#include <optional>
+
+/**
+ * Dynamic resolution settings structure.
+ */
+struct DynamicResolutionSettings final
+{
+	ResolutionControllerSettings m_Controller;
+
+	// The render targets are allocated at multiples of this scale, so they're only reallocated when the scale crosses a bucket.
+	float m_BucketStep = 0.125f;
+
+	// The number of frames the scale must stay at least a bucket below the targets before they're shrunk. Growing is immediate.
+	uint32_t m_ShrinkDelay = 300;
+
+	// The strength of the sharpening applied when upscaling, from 0 to 1. 0 disables it.
+	float m_Sharpness = 0.5f;
+};
+
+/**
+ * Dynamic resolution class.
+ * This owns the color and the depth targets the scene is rendered to, at a scale of the display size which the resolution controller adjusts from
+ * the GPU frame times. The result is upscaled to the display size with a sharpening filter and copied to the swapchain image.
+ *
+ * The targets are sized in buckets of the scale, and the scene is rendered to the top left part of them given by the render size, so changing the
+ * scale does not reallocate anything most of the time. Since the upscale reads only the rendered part, nothing outside it has to be cleared.
+ *
+ * The colors are expected to be in the display range, after tone mapping, since the sharpening works in the [0, 1] range.
+ */
+class DynamicResolution final : public InstanceBoundObject
+{
+	/**
+	 * Upscale constants structure.
+	 * This is pushed to the upscale shader.
+	 */
+	struct UpscaleConstants final
+	{
+		std::array<float, 2> m_SourceScale = {};
+		uint32_t m_SourceWidth = 0;
+		uint32_t m_SourceHeight = 0;
+		uint32_t m_OutputWidth = 0;
+		uint32_t m_OutputHeight = 0;
+		float m_Sharpness = 0.0f;
+		uint32_t m_Padding = 0;
+	};
+
+	/**
+	 * Target structure.
+	 * This contains a single image and it's view. Both are retired when the target is destroyed.
+	 */
+	struct Target final : public InstanceBoundObject
+	{
+		/**
+		 * Explicit constructor.
+		 *
+		 * @param instance The instance reference.
+		 * @param builder The image builder.
+		 * @param format The image format.
+		 * @param aspect The aspect of the view.
+		 */
+		explicit Target(Instance& instance, const ImageBuilder& builder, VkFormat format, VkImageAspectFlags aspect);
+
+		/**
+		 * Destructor.
+		 */
+		~Target() override;
+
+		Image m_Image;
+		VkImageView m_View = VK_NULL_HANDLE;
+	};
+
+public:
+	/**
+	 * Explicit constructor.
+	 *
+	 * @param instance The instance reference.
+	 * @param displayWidth The display width, usually the swapchain width.
+	 * @param displayHeight The display height, usually the swapchain height.
+	 * @param settings The settings. Default is a 60 FPS target with a scale between 0.5 and 1.
+	 * @param shaderPath The compiled upscale shader's path. Default is Shaders/Upscale.spv.
+	 */
+	explicit DynamicResolution(
+		Instance& instance,
+		uint32_t displayWidth,
+		uint32_t displayHeight,
+		const DynamicResolutionSettings& settings = DynamicResolutionSettings(),
+		const std::filesystem::path& shaderPath = "Shaders/Upscale.spv");
+
+	/**
+	 * Destructor.
+	 */
+	~DynamicResolution() override;
+
+	/**
+	 * Update the scale from the GPU time of a frame, and reallocate the targets if needed.
+	 * This should be called once per frame, before recording the scene.
+	 *
+	 * @param frameTime The GPU time of the newest frame which was measured, if any.
+	 * @return True if the targets were reallocated, in which case anything which refers to the old views must be recreated.
+	 */
+	bool update(std::optional<std::chrono::nanoseconds> frameTime);
+
+	/**
+	 * Resize the display.
+	 * This should be called when the swapchain is recreated. The targets are always reallocated.
+	 *
+	 * @param displayWidth The display width.
+	 * @param displayHeight The display height.
+	 */
+	void resize(uint32_t displayWidth, uint32_t displayHeight);
+
+	/**
+	 * Record the upscale to a swapchain image.
+	 * The scene must be rendered to the color target, which must be in the color attachment layout. The color target is left in the shader read
+	 * only layout, so the next frame's scene pass should transition it from the undefined layout. The swapchain image is left in the present
+	 * layout.
+	 *
+	 * The submit must wait for the swapchain image's acquire semaphore at VK_PIPELINE_STAGE_2_BLIT_BIT_KHR (or an earlier stage). The swapchain
+	 * image's layout change is ordered after that stage, so it cannot happen while the presentation engine still reads the image.
+	 *
+	 * @param commandBuffer The command buffer to record to. It must belong to the graphics queue.
+	 * @param swapchainImage The swapchain image to copy the result to. It must be the display size.
+	 */
+	void upscale(VkCommandBuffer commandBuffer, VkImage swapchainImage);
+
+	/**
+	 * Set the sharpness.
+	 *
+	 * @param sharpness The sharpness from 0 to 1. 0 disables the sharpening.
+	 */
+	void setSharpness(float sharpness) { m_Settings.m_Sharpness = sharpness; }
+
+public:
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, DisplayWidth, m_DisplayWidth);
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, DisplayHeight, m_DisplayHeight);
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, RenderWidth, m_Controller.scaleSize(m_DisplayWidth));
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, RenderHeight, m_Controller.scaleSize(m_DisplayHeight));
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, TargetWidth, m_pColor->m_Image.getWidth());
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, TargetHeight, m_pColor->m_Image.getHeight());
+	GRAPHITE_SETUP_SIMPLE_GETTER(float, Scale, m_Controller.getScale());
+
+	GRAPHITE_SETUP_SIMPLE_GETTER(VkImage, ColorImage, m_pColor->m_Image.getImage());
+	GRAPHITE_SETUP_SIMPLE_GETTER(VkImageView, ColorView, m_pColor->m_View);
+	GRAPHITE_SETUP_SIMPLE_GETTER(VkFormat, ColorFormat, m_pColor->m_Image.getFormat());
+	GRAPHITE_SETUP_SIMPLE_GETTER(VkImage, DepthImage, m_pDepth->m_Image.getImage());
+	GRAPHITE_SETUP_SIMPLE_GETTER(VkImageView, DepthView, m_pDepth->m_View);
+	GRAPHITE_SETUP_SIMPLE_GETTER(VkFormat, DepthFormat, m_DepthFormat);
+
+	GRAPHITE_SETUP_GETTERS(ResolutionController, Controller, m_Controller);
+
+private:
+	/**
+	 * Get the bucket a scale falls in.
+	 *
+	 * @param scale The scale.
+	 * @return The scale of the bucket, which is the smallest multiple of the bucket step not below the scale.
+	 */
+	[[nodiscard]] float getBucketScale(float scale) const;
+
+	/**
+	 * Allocate the color and the depth targets at a bucket scale.
+	 *
+	 * @param bucketScale The scale of the bucket.
+	 */
+	void createTargets(float bucketScale);
+
+	/**
+	 * Create the descriptor set of the upscale pass.
+	 * The old set's pool is retired, since the frames in flight might still be using it.
+	 */
+	void createDescriptorSet();
+
+private:
+	DynamicResolutionSettings m_Settings;
+	ResolutionController m_Controller;
+
+	ComputePipeline m_Pipeline;
+
+	std::unique_ptr<Target> m_pColor;
+	std::unique_ptr<Target> m_pDepth;
+	std::unique_ptr<Target> m_pOutput;
+
+	VkDescriptorSetLayout m_SetLayout = VK_NULL_HANDLE;
+	VkDescriptorPool m_DescriptorPool = VK_NULL_HANDLE;
+	VkDescriptorSet m_DescriptorSet = VK_NULL_HANDLE;
+
+	VkFormat m_DepthFormat = VK_FORMAT_UNDEFINED;
+
+	float m_BucketScale = 1.0f;
+
+	uint32_t m_DisplayWidth = 0;
+	uint32_t m_DisplayHeight = 0;
+	uint32_t m_ShrinkFrames = 0;
+};
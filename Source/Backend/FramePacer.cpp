@@ -0,0 +1,129 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "FramePacer.hpp"
+
+#include "Core/Logging.hpp"
+
+#include <optick.h>
+
+#include <algorithm>
+#include <thread>
+
+namespace /* anonymous */
+{
+	/**
+	 * Update an exponential moving average.
+	 *
+	 * @param average The current average.
+	 * @param sample The new sample.
+	 * @param weight The weight of the current average, out of 16.
+	 * @return The new average.
+	 */
+	[[nodiscard]] std::chrono::nanoseconds UpdateAverage(std::chrono::nanoseconds average, std::chrono::nanoseconds sample, int64_t weight)
+	{
+		return (average * weight + sample * (16 - weight)) / 16;
+	}
+}
+
+FramePacer::FramePacer(Window& window, uint32_t maxQueuedFrames)
+	: m_Window(window), m_MaxQueuedFrames(std::max(maxQueuedFrames, 1u))
+{
+	if (!m_Window.getSupportsPresentWait())
+		GRAPHITE_LOG_INFORMATION("Present wait is not available. The frame pacer will use the CPU clock.");
+}
+
+void FramePacer::waitForInputSampling()
+{
+	OPTICK_EVENT();
+
+	const auto lastInputSampled = getTiming(m_FrameIndex).m_InputSampled;
+	auto& timing = getTiming(++m_FrameIndex);
+	timing = FrameTiming();
+
+	const auto presentID = m_Window.getPresentID();
+	if (m_Window.getSupportsPresentWait() && presentID >= m_MaxQueuedFrames)
+	{
+		// Wait till the oldest frame we allow to be queued is displayed.
+		const auto waitID = presentID + 1 - m_MaxQueuedFrames;
+		if (m_Window.waitForPresent(waitID, std::chrono::nanoseconds(std::chrono::milliseconds(100)).count()))
+		{
+			const auto displayed = std::chrono::steady_clock::now();
+
+			// Update the refresh interval. Outliers (like after a hitch or while minimized) are ignored.
+			const auto interval = displayed - m_LastDisplayed;
+			if (m_LastDisplayed.time_since_epoch().count() > 0 && interval > std::chrono::nanoseconds(0) && interval < m_RefreshInterval * 4)
+				m_RefreshInterval = UpdateAverage(m_RefreshInterval, interval, 12);
+
+			m_LastDisplayed = displayed;
+
+			// Record the display time of the frame.
+			for (uint32_t i = 0; i < TimingHistory; i++)
+			{
+				auto& entry = m_Timings[i];
+				if (entry.m_PresentID == waitID && !entry.m_bIsDisplayed)
+				{
+					entry.m_Displayed = displayed;
+					entry.m_bIsDisplayed = true;
+					m_LastDisplayedIndex = i;
+					break;
+				}
+			}
+
+			// Sleep till there is just enough time left to produce the next frame before the next refresh.
+			const auto wakeTime = displayed + m_RefreshInterval - m_FrameWorkTime - m_SafetyMargin;
+			if (wakeTime > std::chrono::steady_clock::now())
+			{
+				OPTICK_EVENT("Frame Pacing Sleep");
+				std::this_thread::sleep_until(wakeTime);
+			}
+		}
+	}
+	else if (m_TargetFrameTime.count() > 0 && lastInputSampled.time_since_epoch().count() > 0)
+	{
+		OPTICK_EVENT("Frame Limiter Sleep");
+		std::this_thread::sleep_until(lastInputSampled + m_TargetFrameTime);
+	}
+
+	timing.m_InputSampled = std::chrono::steady_clock::now();
+}
+
+void FramePacer::markSubmitted()
+{
+	getTiming(m_FrameIndex).m_Submitted = std::chrono::steady_clock::now();
+}
+
+void FramePacer::markPresented()
+{
+	auto& timing = getTiming(m_FrameIndex);
+	timing.m_Presented = std::chrono::steady_clock::now();
+	timing.m_PresentID = m_Window.getPresentID();
+
+	// Without present wait we can't know when the frame is displayed, so the present time is the best we have.
+	if (!m_Window.getSupportsPresentWait())
+	{
+		timing.m_Displayed = timing.m_Presented;
+		timing.m_bIsDisplayed = true;
+		m_LastDisplayedIndex = static_cast<uint32_t>(m_FrameIndex % TimingHistory);
+	}
+
+	// Update the predicted frame work. Spikes are taken right away so the next frames don't miss the refresh.
+	const auto workTime = std::chrono::duration_cast<std::chrono::nanoseconds>(timing.m_Presented - timing.m_InputSampled);
+	m_FrameWorkTime = workTime > m_FrameWorkTime ? workTime : UpdateAverage(m_FrameWorkTime, workTime, 15);
+}
+
+double FramePacer::getAverageLatency() const
+{
+	double total = 0.0;
+	uint32_t count = 0;
+
+	for (const auto& timing : m_Timings)
+	{
+		if (!timing.m_bIsDisplayed)
+			continue;
+
+		total += std::chrono::duration<double, std::milli>(timing.m_Displayed - timing.m_InputSampled).count();
+		count++;
+	}
+
+	return count > 0 ? total / count : 0.0;
+}
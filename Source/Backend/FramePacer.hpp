@@ -0,0 +1,115 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "Window.hpp"
+
+#include <array>
+#include <chrono>
+
+/**
+ * Frame timing structure.
+ * This contains the timestamps of a single frame, from input sampling till the image was displayed.
+ */
+struct FrameTiming final
+{
+	using TimePoint = std::chrono::steady_clock::time_point;
+
+	TimePoint m_InputSampled;
+	TimePoint m_Submitted;
+	TimePoint m_Presented;
+	TimePoint m_Displayed;
+
+	uint64_t m_PresentID = 0;
+	bool m_bIsDisplayed = false;
+};
+
+/**
+ * Frame pacer class.
+ * This delays the CPU right before input sampling so the CPU never runs ahead of the display, which keeps the input latency low.
+ *
+ * If VK_KHR_present_wait is supported, the pacer waits till the previous frame is displayed and then sleeps till it's just enough time to
+ * produce the next frame before the next refresh. Otherwise it falls back to limiting the frame rate using the CPU clock.
+ */
+class FramePacer final
+{
+	static constexpr uint32_t TimingHistory = 64;
+
+public:
+	/**
+	 * Explicit constructor.
+	 *
+	 * @param window The window to pace.
+	 * @param maxQueuedFrames The maximum number of frames the CPU can be ahead of the display. Default is 1.
+	 */
+	explicit FramePacer(Window& window, uint32_t maxQueuedFrames = 1);
+
+	/**
+	 * Wait till it's time to sample the input for the next frame.
+	 * This should be called right before polling the window events.
+	 */
+	void waitForInputSampling();
+
+	/**
+	 * Mark the frame's work as submitted to the GPU.
+	 */
+	void markSubmitted();
+
+	/**
+	 * Mark the frame as presented.
+	 * This should be called right after Window::present.
+	 */
+	void markPresented();
+
+	/**
+	 * Get the average input to display latency over the last frames.
+	 *
+	 * @return The latency in milliseconds. 0 if no frame was displayed yet.
+	 */
+	[[nodiscard]] double getAverageLatency() const;
+
+	/**
+	 * Get the timing information of the last displayed frame.
+	 *
+	 * @return The frame timing.
+	 */
+	[[nodiscard]] const FrameTiming& getLastDisplayedFrame() const { return m_Timings[m_LastDisplayedIndex]; }
+
+	/**
+	 * Set the target frame time used when present wait is not supported.
+	 *
+	 * @param frameTime The target frame time. 0 disables the CPU limiter.
+	 */
+	void setTargetFrameTime(std::chrono::nanoseconds frameTime) { m_TargetFrameTime = frameTime; }
+
+public:
+	GRAPHITE_SETUP_SIMPLE_GETTER(std::chrono::nanoseconds, RefreshInterval, m_RefreshInterval);
+	GRAPHITE_SETUP_SIMPLE_GETTER(std::chrono::nanoseconds, FrameWorkTime, m_FrameWorkTime);
+
+private:
+	/**
+	 * Get the timing entry of a frame.
+	 *
+	 * @param frameIndex The frame index.
+	 * @return The timing reference.
+	 */
+	[[nodiscard]] FrameTiming& getTiming(uint64_t frameIndex) { return m_Timings[frameIndex % TimingHistory]; }
+
+private:
+	std::array<FrameTiming, TimingHistory> m_Timings = {};
+
+	Window& m_Window;
+
+	std::chrono::nanoseconds m_RefreshInterval = std::chrono::microseconds(16667);
+	std::chrono::nanoseconds m_FrameWorkTime = std::chrono::nanoseconds(0);
+	std::chrono::nanoseconds m_TargetFrameTime = std::chrono::nanoseconds(0);
+
+	// The time added to the predicted frame work so small spikes don't miss the refresh.
+	std::chrono::nanoseconds m_SafetyMargin = std::chrono::microseconds(1000);
+
+	std::chrono::steady_clock::time_point m_LastDisplayed;
+
+	uint64_t m_FrameIndex = 0;
+	uint32_t m_LastDisplayedIndex = 0;
+	uint32_t m_MaxQueuedFrames = 1;
+};
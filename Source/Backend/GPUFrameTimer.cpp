@@ -0,0 +1,186 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "GPUFrameTimer.hpp"
+#include "VulkanMacros.hpp"
+
+#include <optick.h>
+
+GPUFrameTimer::GPUFrameTimer(Instance& instance, CommandSubmissionQueue& submissionQueue, uint32_t framesInFlight /*= 4*/)
+	: InstanceBoundObject(instance)
+	, m_Slots(framesInFlight)
+	, m_SubmissionQueue(submissionQueue)
+{
+	const auto family = m_Instance.getGraphicsQueue().getUnsafe().m_Family;
+	const auto validBits = m_Instance.getQueueFamilyProperties()[family].timestampValidBits;
+	if (validBits == 0)
+	{
+		GRAPHITE_LOG_WARNING("The graphics queue does not support timestamps, the GPU frame times will not be measured.");
+		return;
+	}
+
+	m_TimestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+	m_TimestampPeriod = m_Instance.getPhysicalDeviceProperties().limits.timestampPeriod;
+
+	// Create the query pool, two queries for each slot.
+	VkQueryPoolCreateInfo queryPoolCreateInfo = {};
+	queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	queryPoolCreateInfo.pNext = nullptr;
+	queryPoolCreateInfo.flags = 0;
+	queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	queryPoolCreateInfo.queryCount = framesInFlight * 2;
+	queryPoolCreateInfo.pipelineStatistics = 0;
+
+	// Create the command pool for the graphics queue.
+	VkCommandPoolCreateInfo commandPoolCreateInfo = {};
+	commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	commandPoolCreateInfo.pNext = nullptr;
+	commandPoolCreateInfo.flags = 0;
+	commandPoolCreateInfo.queueFamilyIndex = family;
+
+	std::vector<VkCommandBuffer> commandBuffers(framesInFlight * 2);
+
+	m_Instance.getLogicalDevice().access([this, &queryPoolCreateInfo, &commandPoolCreateInfo, &commandBuffers](VkDevice logicalDevice)
+		{
+			const auto& deviceTable = m_Instance.getDeviceTable();
+			GRAPHITE_VK_ASSERT(deviceTable.vkCreateQueryPool(logicalDevice, &queryPoolCreateInfo, nullptr, &m_QueryPool), "Failed to create the GPU frame timer query pool!");
+			GRAPHITE_VK_ASSERT(deviceTable.vkCreateCommandPool(logicalDevice, &commandPoolCreateInfo, nullptr, &m_CommandPool), "Failed to create the GPU frame timer command pool!");
+
+			VkCommandBufferAllocateInfo allocateInfo = {};
+			allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocateInfo.pNext = nullptr;
+			allocateInfo.commandPool = m_CommandPool;
+			allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocateInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+
+			GRAPHITE_VK_ASSERT(deviceTable.vkAllocateCommandBuffers(logicalDevice, &allocateInfo, commandBuffers.data()), "Failed to allocate the GPU frame timer command buffers!");
+		}
+	);
+
+	// Record the command buffers once. They're only resubmitted after the previous submission is done.
+	for (uint32_t i = 0; i < framesInFlight; i++)
+	{
+		auto& slot = m_Slots[i];
+		slot.m_BeginCommandBuffer = commandBuffers[i * 2];
+		slot.m_EndCommandBuffer = commandBuffers[i * 2 + 1];
+
+		recordSlot(slot, i * 2);
+	}
+}
+
+GPUFrameTimer::~GPUFrameTimer()
+{
+	if (!isSupported())
+		return;
+
+	// Make sure the timestamps in flight are written before destroying the pools.
+	m_SubmissionQueue.flush();
+	for (const auto& slot : m_Slots)
+	{
+		if (slot.m_bIsPending)
+			m_SubmissionQueue.wait(QueueType::Graphics, slot.m_TimelineValue);
+	}
+
+	m_Instance.getLogicalDevice().access([this](VkDevice logicalDevice)
+		{
+			m_Instance.getDeviceTable().vkDestroyCommandPool(logicalDevice, m_CommandPool, nullptr);
+			m_Instance.getDeviceTable().vkDestroyQueryPool(logicalDevice, m_QueryPool, nullptr);
+		}
+	);
+}
+
+void GPUFrameTimer::beginFrame(uint64_t frameIndex)
+{
+	OPTICK_EVENT();
+
+	m_bIsTiming = false;
+	if (!isSupported())
+		return;
+
+	// The slots are used in order, so if the next one is still in flight, the GPU is too far behind.
+	auto& slot = m_Slots[m_NextSlot];
+	if (slot.m_bIsPending)
+		return;
+
+	slot.m_FrameIndex = frameIndex;
+	m_SubmissionQueue.enqueue(QueueType::Graphics, std::span<const VkCommandBuffer>(&slot.m_BeginCommandBuffer, 1));
+
+	m_ActiveSlot = m_NextSlot;
+	m_NextSlot = (m_NextSlot + 1) % static_cast<uint32_t>(m_Slots.size());
+	m_bIsTiming = true;
+}
+
+void GPUFrameTimer::endFrame()
+{
+	if (!m_bIsTiming)
+		return;
+
+	auto& slot = m_Slots[m_ActiveSlot];
+	slot.m_TimelineValue = m_SubmissionQueue.enqueue(QueueType::Graphics, std::span<const VkCommandBuffer>(&slot.m_EndCommandBuffer, 1));
+	slot.m_bIsPending = true;
+
+	m_bIsTiming = false;
+}
+
+std::optional<std::chrono::nanoseconds> GPUFrameTimer::collect(FrameStatistics& statistics)
+{
+	OPTICK_EVENT();
+
+	if (!isSupported())
+		return std::nullopt;
+
+	std::optional<std::chrono::nanoseconds> newestTime;
+	uint64_t newestFrame = 0;
+
+	const auto completedValue = m_SubmissionQueue.getCompletedValue(QueueType::Graphics);
+	for (uint32_t i = 0; i < m_Slots.size(); i++)
+	{
+		auto& slot = m_Slots[i];
+		if (!slot.m_bIsPending || slot.m_TimelineValue > completedValue)
+			continue;
+
+		// The submission is done, so the results are available without waiting.
+		std::array<uint64_t, 2> timestamps = {};
+		const auto result = m_Instance.getLogicalDevice().access([this, i, &timestamps](VkDevice logicalDevice)
+			{
+				return m_Instance.getDeviceTable().vkGetQueryPoolResults(logicalDevice, m_QueryPool, i * 2, 2, sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+			}
+		);
+
+		slot.m_bIsPending = false;
+		if (result != VK_SUCCESS)
+			continue;
+
+		const auto ticks = (timestamps[1] - timestamps[0]) & m_TimestampMask;
+		const auto duration = std::chrono::nanoseconds(static_cast<int64_t>(static_cast<double>(ticks) * m_TimestampPeriod));
+		statistics.recordGPUTime(slot.m_FrameIndex, duration);
+
+		if (!newestTime || slot.m_FrameIndex > newestFrame)
+		{
+			newestTime = duration;
+			newestFrame = slot.m_FrameIndex;
+		}
+	}
+
+	return newestTime;
+}
+
+void GPUFrameTimer::recordSlot(const FrameSlot& slot, uint32_t firstQuery) const
+{
+	const auto& deviceTable = m_Instance.getDeviceTable();
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.pNext = nullptr;
+	beginInfo.flags = 0;
+	beginInfo.pInheritanceInfo = nullptr;
+
+	// The queries are reset right before they're written again, which is after the previous results were read.
+	GRAPHITE_VK_ASSERT(deviceTable.vkBeginCommandBuffer(slot.m_BeginCommandBuffer, &beginInfo), "Failed to begin the GPU frame timer command buffer!");
+	deviceTable.vkCmdResetQueryPool(slot.m_BeginCommandBuffer, m_QueryPool, firstQuery, 2);
+	deviceTable.vkCmdWriteTimestamp(slot.m_BeginCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_QueryPool, firstQuery);
+	GRAPHITE_VK_ASSERT(deviceTable.vkEndCommandBuffer(slot.m_BeginCommandBuffer), "Failed to end the GPU frame timer command buffer!");
+
+	GRAPHITE_VK_ASSERT(deviceTable.vkBeginCommandBuffer(slot.m_EndCommandBuffer, &beginInfo), "Failed to begin the GPU frame timer command buffer!");
+	deviceTable.vkCmdWriteTimestamp(slot.m_EndCommandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_QueryPool, firstQuery + 1);
+	GRAPHITE_VK_ASSERT(deviceTable.vkEndCommandBuffer(slot.m_EndCommandBuffer), "Failed to end the GPU frame timer command buffer!");
+}
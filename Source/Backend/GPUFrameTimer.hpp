@@ -0,0 +1,102 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "CommandSubmissionQueue.hpp"
+
+#include "Core/FrameStatistics.hpp"
+
+#include <optional>
+
+/**
+ * GPU frame timer class.
+ * This measures how long the graphics queue takes to execute each frame using timestamp queries. A timestamp is enqueued before the frame's
+ * graphics work and another one after it, so the time includes everything the frame submitted to the graphics queue, including the time spent
+ * waiting for the other queues.
+ *
+ * The command buffers which write the timestamps are recorded once, so timing a frame does not record anything. The results are read without
+ * waiting, a few frames later, and reported to the frame statistics.
+ */
+class GPUFrameTimer final : public InstanceBoundObject
+{
+	/**
+	 * Frame slot structure.
+	 * This contains the queries and the command buffers of a single frame in flight.
+	 */
+	struct FrameSlot final
+	{
+		VkCommandBuffer m_BeginCommandBuffer = VK_NULL_HANDLE;
+		VkCommandBuffer m_EndCommandBuffer = VK_NULL_HANDLE;
+
+		uint64_t m_FrameIndex = 0;
+		uint64_t m_TimelineValue = 0;
+
+		bool m_bIsPending = false;
+	};
+
+public:
+	/**
+	 * Explicit constructor.
+	 *
+	 * @param instance The instance reference.
+	 * @param submissionQueue The submission queue to enqueue the timestamps to.
+	 * @param framesInFlight The number of frames which can be timed at once. Default is 4.
+	 */
+	explicit GPUFrameTimer(Instance& instance, CommandSubmissionQueue& submissionQueue, uint32_t framesInFlight = 4);
+
+	/**
+	 * Destructor.
+	 * This waits till the timed frames are done.
+	 */
+	~GPUFrameTimer() override;
+
+	/**
+	 * Begin timing a frame.
+	 * This should be called before anything else enqueues the frame's graphics work. If the GPU is too far behind to have a free slot, the frame
+	 * is not timed.
+	 *
+	 * @param frameIndex The frame index from the frame statistics.
+	 */
+	void beginFrame(uint64_t frameIndex);
+
+	/**
+	 * End timing the frame.
+	 * This should be called right before flushing the submission queue.
+	 */
+	void endFrame();
+
+	/**
+	 * Report the GPU times of the frames which are done.
+	 *
+	 * @param statistics The frame statistics to report to.
+	 * @return The GPU time of the newest frame which was collected, if any, which can drive the dynamic resolution.
+	 */
+	std::optional<std::chrono::nanoseconds> collect(FrameStatistics& statistics);
+
+public:
+	[[nodiscard]] bool isSupported() const { return m_QueryPool != VK_NULL_HANDLE; }
+
+private:
+	/**
+	 * Record the command buffers of a slot.
+	 *
+	 * @param slot The slot.
+	 * @param firstQuery The slot's first query.
+	 */
+	void recordSlot(const FrameSlot& slot, uint32_t firstQuery) const;
+
+private:
+	std::vector<FrameSlot> m_Slots;
+
+	CommandSubmissionQueue& m_SubmissionQueue;
+
+	VkQueryPool m_QueryPool = VK_NULL_HANDLE;
+	VkCommandPool m_CommandPool = VK_NULL_HANDLE;
+
+	uint64_t m_TimestampMask = 0;
+	double m_TimestampPeriod = 1.0;
+
+	uint32_t m_NextSlot = 0;
+	uint32_t m_ActiveSlot = 0;
+	bool m_bIsTiming = false;
+};
@@ -4,20 +4,106 @@
 #include "Instance.hpp"
 #include "VulkanMacros.hpp"
 
+#include <cmath>
+#include <algorithm>
+
+namespace /* anonymous */
+{
+	/**
+	 * Get the image create flags of a builder.
+	 *
+	 * @param builder The image builder structure.
+	 * @return The image create flags.
+	 */
+	[[nodiscard]] VkImageCreateFlags GetImageCreateFlags(const ImageBuilder& builder)
+	{
+		return builder.m_IsCubeMap ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0;
+	}
+
+	/**
+	 * Get the number of mip levels of a builder.
+	 *
+	 * @param builder The image builder structure.
+	 * @return The mip level count.
+	 */
+	[[nodiscard]] uint32_t GetMipLevels(const ImageBuilder& builder)
+	{
+		if (!builder.m_EnableMipMaps)
+			return 1;
+
+		const auto fullChain = static_cast<uint32_t>(std::floor(std::log2(std::max(builder.m_Width, builder.m_Height)))) + 1;
+		return builder.m_MipLevels > 0 ? std::min(builder.m_MipLevels, fullChain) : fullChain;
+	}
+
+	/**
+	 * Get the distinct queue families of the instance.
+	 *
+	 * @param instance The instance reference.
+	 * @return The queue family indices.
+	 */
+	[[nodiscard]] std::vector<uint32_t> GetQueueFamilies(const Instance& instance)
+	{
+		std::vector<uint32_t> families;
+		for (const auto type : { QueueType::Graphics, QueueType::Compute, QueueType::Transfer })
+		{
+			const auto family = instance.getQueue(type).getUnsafe().m_Family;
+			if (GRAPHITE_RANGES(find, families, family) == families.end())
+				families.emplace_back(family);
+		}
+
+		return families;
+	}
+}
+
 Image::Image(Instance& instance, const ImageBuilder& builder, VkFormat format)
-	: InstanceBoundObject(instance), m_Width(builder.m_Width), m_Height(builder.m_Height), m_Depth(builder.m_Depth), m_Format(format)
+	: InstanceBoundObject(instance), m_Data(Allocate(instance, builder, format))
 {
+}
+
+Image::Image(Instance& instance, const ImageBuilder& builder, std::vector<VkFormat> formats)
+	: InstanceBoundObject(instance)
+{
+	// Resolve the image format.
+	const auto format = ResolveFormat(instance, builder, formats);
+
+	// Check if we found a format.
+	if (format == VK_FORMAT_UNDEFINED)
+	{
+		GRAPHITE_LOG_FATAL("The provided format (with or without candidates) cannot be used to create the image!");
+		return;
+	}
+
+	m_Data = Allocate(instance, builder, format);
+}
+
+Image::~Image()
+{
+	// The GPU might still be using the image, so it's destroyed once the current frame is done.
+	if (m_Data.m_Image != VK_NULL_HANDLE)
+		m_Instance.getDeletionQueue().retire(m_Data.m_Image, m_Data.m_Allocation);
+}
+
+ImageData Image::Allocate(Instance& instance, const ImageBuilder& builder, VkFormat format)
+{
+	ImageData data;
+	data.m_Width = builder.m_Width;
+	data.m_Height = builder.m_Height;
+	data.m_Depth = builder.m_Depth;
+	data.m_MipLevels = GetMipLevels(builder);
+	data.m_Layers = builder.m_Layers;
+	data.m_Format = format;
+
 	// Create the image.
 	VkImageCreateInfo imageCreateInfo = {};
 	imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
 	imageCreateInfo.pNext = nullptr;
-	imageCreateInfo.flags = builder.m_IsCubeMap ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0;
+	imageCreateInfo.flags = GetImageCreateFlags(builder);
 	imageCreateInfo.imageType = builder.m_Type;
-	imageCreateInfo.extent.width = m_Width;
-	imageCreateInfo.extent.height = m_Height;
-	imageCreateInfo.extent.depth = m_Depth;
-	imageCreateInfo.mipLevels = builder.m_EnableMipMaps ? static_cast<uint32_t>(std::floor(std::log2(std::max(m_Width, m_Height)))) + 1 : 1;
-	imageCreateInfo.arrayLayers = builder.m_Layers;
+	imageCreateInfo.extent.width = data.m_Width;
+	imageCreateInfo.extent.height = data.m_Height;
+	imageCreateInfo.extent.depth = data.m_Depth;
+	imageCreateInfo.mipLevels = data.m_MipLevels;
+	imageCreateInfo.arrayLayers = data.m_Layers;
 	imageCreateInfo.samples = builder.m_Samples;
 	imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
 	imageCreateInfo.usage = builder.m_Usage;
@@ -27,83 +113,50 @@ Image::Image(Instance& instance, const ImageBuilder& builder, VkFormat format)
 	imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 	imageCreateInfo.format = format;
 
+	// Concurrent sharing is only needed if there is more than one queue family.
+	const auto queueFamilies = builder.m_IsShared ? GetQueueFamilies(instance) : std::vector<uint32_t>();
+	if (queueFamilies.size() > 1)
+	{
+		imageCreateInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		imageCreateInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+		imageCreateInfo.pQueueFamilyIndices = queueFamilies.data();
+	}
+
 	VmaAllocationCreateInfo allocationCreateInfo = {};
 	allocationCreateInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
 
-	instance.getAllocator().access([this, imageCreateInfo, allocationCreateInfo](VmaAllocator allocator)
+	instance.getAllocator().access([&data, &imageCreateInfo, &allocationCreateInfo](VmaAllocator allocator)
 		{
-			GRAPHITE_VK_ASSERT(vmaCreateImage(allocator, &imageCreateInfo, &allocationCreateInfo, &m_Image, &m_ImageMemory, nullptr), "Failed to create the image!");
+			GRAPHITE_VK_ASSERT(vmaCreateImage(allocator, &imageCreateInfo, &allocationCreateInfo, &data.m_Image, &data.m_Allocation, nullptr), "Failed to create the image!");
 		}
 	);
+
+	return data;
 }
 
-Image::Image(Instance& instance, const ImageBuilder& builder, std::vector<VkFormat> formats)
-	: InstanceBoundObject(instance), m_Width(builder.m_Width), m_Height(builder.m_Height), m_Depth(builder.m_Depth)
+VkFormat Image::ResolveFormat(Instance& instance, const ImageBuilder& builder, const std::vector<VkFormat>& formats)
 {
-	// Create the image.
-	VkImageCreateInfo imageCreateInfo = {};
-	imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-	imageCreateInfo.pNext = nullptr;
-	imageCreateInfo.flags = builder.m_IsCubeMap ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0;
-	imageCreateInfo.imageType = builder.m_Type;
-	imageCreateInfo.extent.width = m_Width;
-	imageCreateInfo.extent.height = m_Height;
-	imageCreateInfo.extent.depth = m_Depth;
-	imageCreateInfo.mipLevels = builder.m_EnableMipMaps ? static_cast<uint32_t>(std::floor(std::log2(std::max(m_Width, m_Height)))) + 1 : 1;
-	imageCreateInfo.arrayLayers = builder.m_Layers;
-	imageCreateInfo.samples = builder.m_Samples;
-	imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-	imageCreateInfo.usage = builder.m_Usage;
-	imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-	imageCreateInfo.queueFamilyIndexCount = 0;
-	imageCreateInfo.pQueueFamilyIndices = nullptr;
-	imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-
-	// Resolve the image format.
-	bool formatFound = false;
 	for (const auto candidate : formats)
 	{
-		imageCreateInfo.format = candidate;
-
 		// Get the format properties.
 		VkImageFormatProperties formatProperties = {};
-		VkResult result = VK_ERROR_UNKNOWN;
-		instance.getPhysicalDevice().access([&formatProperties, &imageCreateInfo, &result](VkPhysicalDevice physicalDevice)
+		const auto result = instance.getPhysicalDevice().access([&formatProperties, &builder, candidate](VkPhysicalDevice physicalDevice)
 			{
-				result = vkGetPhysicalDeviceImageFormatProperties(
+				return vkGetPhysicalDeviceImageFormatProperties(
 					physicalDevice,
-					imageCreateInfo.format,
-					imageCreateInfo.imageType,
-					imageCreateInfo.tiling,
-					imageCreateInfo.usage,
-					imageCreateInfo.flags,
+					candidate,
+					builder.m_Type,
+					VK_IMAGE_TILING_OPTIMAL,
+					builder.m_Usage,
+					GetImageCreateFlags(builder),
 					&formatProperties
 				);
 			});
 
 		// If the format is supported, we can go with it.
 		if (result == VK_SUCCESS)
-		{
-			m_Format = candidate;
-			formatFound = true;
-			break;
-		}
+			return candidate;
 	}
 
-	// Check if we found a format.
-	if (!formatFound)
-	{
-		GRAPHITE_LOG_FATAL("The provided format (with or without candidates) cannot be used to create the image!");
-		return;
-	}
-
-	VmaAllocationCreateInfo allocationCreateInfo = {};
-	allocationCreateInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
-
-	instance.getAllocator().access([this, imageCreateInfo, allocationCreateInfo](VmaAllocator allocator)
-		{
-			GRAPHITE_VK_ASSERT(vmaCreateImage(allocator, &imageCreateInfo, &allocationCreateInfo, &m_Image, &m_ImageMemory, nullptr), "Failed to create the image!");
-		}
-	);
-
+	return VK_FORMAT_UNDEFINED;
 }
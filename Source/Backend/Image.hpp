@@ -19,7 +19,27 @@ struct ImageBuilder final
 	GRAPHITE_SETUP_CHAIN_ENTRY(ImageBuilder, VkSampleCountFlagBits, Samples) = VK_SAMPLE_COUNT_1_BIT;
 	GRAPHITE_SETUP_CHAIN_ENTRY(ImageBuilder, uint32_t, Layers) = 1;
 	GRAPHITE_SETUP_CHAIN_ENTRY(ImageBuilder, bool, EnableMipMaps) = true;
+	GRAPHITE_SETUP_CHAIN_ENTRY(ImageBuilder, uint32_t, MipLevels) = 0;	// The number of mip levels if mip maps are enabled. 0 creates the full chain.
 	GRAPHITE_SETUP_CHAIN_ENTRY(ImageBuilder, bool, IsCubeMap) = false;
+	GRAPHITE_SETUP_CHAIN_ENTRY(ImageBuilder, bool, IsShared) = false;	// Share the image between all the queue families without ownership transfers.
+};
+
+/**
+ * Image data structure.
+ * This contains the Vulkan handles and the information of a single image, without any ownership.
+ */
+struct ImageData final
+{
+	VkImage m_Image = VK_NULL_HANDLE;
+	VmaAllocation m_Allocation = nullptr;
+
+	uint32_t m_Width = 0;
+	uint32_t m_Height = 0;
+	uint32_t m_Depth = 0;
+	uint32_t m_MipLevels = 1;
+	uint32_t m_Layers = 1;
+
+	VkFormat m_Format = VK_FORMAT_UNDEFINED;
 };
 
 /**
@@ -47,21 +67,41 @@ public:
 	 */
 	explicit Image(Instance& instance, const ImageBuilder& builder, std::vector<VkFormat> formats);
 
-public:
-	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, Width, m_Width);
-	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, Height, m_Height);
-	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, Depth, m_Depth);
-	GRAPHITE_SETUP_SIMPLE_GETTER(VkFormat, Format, m_Format);
-	GRAPHITE_SETUP_SIMPLE_GETTER(VkImage, Image, m_Image);
-	GRAPHITE_SETUP_SIMPLE_GETTER(VmaAllocation, ImageMemory, m_ImageMemory);
+	/**
+	 * Destructor.
+	 */
+	~Image() override;
 
-private:
-	uint32_t m_Width = 0;
-	uint32_t m_Height = 0;
-	uint32_t m_Depth = 0;
+	/**
+	 * Create a Vulkan image and allocate it's memory.
+	 * The caller owns the created image and should retire it to the deletion queue when it's no longer needed.
+	 *
+	 * @param instance The instance reference.
+	 * @param builder The image builder structure.
+	 * @param format The image format to use.
+	 * @return The image data.
+	 */
+	[[nodiscard]] static ImageData Allocate(Instance& instance, const ImageBuilder& builder, VkFormat format);
 
-	VkFormat m_Format = VK_FORMAT_UNDEFINED;
+	/**
+	 * Find the first format from a list of candidates which can be used to create an image.
+	 *
+	 * @param instance The instance reference.
+	 * @param builder The image builder structure.
+	 * @param formats The candidate formats, in the best to worst order.
+	 * @return The format. VK_FORMAT_UNDEFINED if none of the formats can be used.
+	 */
+	[[nodiscard]] static VkFormat ResolveFormat(Instance& instance, const ImageBuilder& builder, const std::vector<VkFormat>& formats);
 
-	VkImage m_Image = VK_NULL_HANDLE;
-	VmaAllocation m_ImageMemory = nullptr;
-};
\ No newline at end of file
+public:
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, Width, m_Data.m_Width);
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, Height, m_Data.m_Height);
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, Depth, m_Data.m_Depth);
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, MipLevels, m_Data.m_MipLevels);
+	GRAPHITE_SETUP_SIMPLE_GETTER(VkFormat, Format, m_Data.m_Format);
+	GRAPHITE_SETUP_SIMPLE_GETTER(VkImage, Image, m_Data.m_Image);
+	GRAPHITE_SETUP_SIMPLE_GETTER(VmaAllocation, ImageMemory, m_Data.m_Allocation);
+
+private:
+	ImageData m_Data;
+};
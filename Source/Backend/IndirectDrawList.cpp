@@ -0,0 +1,249 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "IndirectDrawList.hpp"
+#include "Instance.hpp"
+#include "VulkanMacros.hpp"
+
+#include <optick.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace /* anonymous */
+{
+	// The culling shader's thread group size.
+	constexpr uint32_t g_CullingGroupSize = 64;
+
+	// The buffers of a culling pass are bound in this order.
+	enum CullingBinding : uint32_t
+	{
+		Instances,
+		Commands,
+		DrawCount,
+		Visibility,
+
+		Count
+	};
+
+	/**
+	 * Get the bindings of the culling pass descriptor set.
+	 *
+	 * @return The bindings.
+	 */
+	[[nodiscard]] ComputePipeline::SetBindings GetCullingBindings()
+	{
+		ComputePipeline::SetBindings bindings;
+		for (uint32_t i = 0; i < CullingBinding::Count; i++)
+			bindings.emplace_back(VkDescriptorSetLayoutBinding{ i, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr });
+
+		return bindings;
+	}
+}
+
+IndirectDrawList::DrawCommands::DrawCommands(Instance& instance, uint32_t maximumInstances)
+	: m_Commands(instance, sizeof(VkDrawIndexedIndirectCommand) * std::max(maximumInstances, 1u), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
+	, m_Count(instance, sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+{
+}
+
+IndirectDrawList::IndirectDrawList(Instance& instance, uint32_t maximumInstances, const std::filesystem::path& shaderDirectory /*= "Shaders"*/)
+	: InstanceBoundObject(instance)
+	, m_InstanceBuffer(instance, sizeof(DrawInstance) * std::max(maximumInstances, 1u), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+	, m_VisibilityBuffer(instance, sizeof(uint32_t) * std::max(maximumInstances, 1u), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+	, m_FrustumCommands(instance, maximumInstances)
+	, m_OcclusionCommands(instance, maximumInstances)
+	, m_FrustumPipeline(instance, shaderDirectory / "Culling.spv", { GetCullingBindings() }, sizeof(FrustumConstants), 2)
+	, m_OcclusionPipeline(instance, shaderDirectory / "CullingOcclusion.spv", { GetCullingBindings(), { DepthPyramid::GetSamplingBinding() } }, sizeof(OcclusionConstants), 1)
+	, m_MaximumInstances(maximumInstances)
+	, m_bUseDrawCount(instance.isDeviceExtensionEnabled(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME))
+	, m_bUseMultiDraw(instance.getEnabledFeatures().multiDrawIndirect == VK_TRUE)
+{
+	if (instance.getEnabledFeatures().drawIndirectFirstInstance == VK_FALSE)
+		GRAPHITE_LOG_WARNING("The device does not support the first instance in indirect draws. The vertex shaders won't be able to find the instance data!");
+
+	if (!m_bUseDrawCount)
+		GRAPHITE_LOG_INFORMATION("Indirect draw count is not supported. The culled draws will not be compacted.");
+
+	// Both pipelines use the same layout for the first set, so the sets can be allocated from the frustum pipeline.
+	writeDescriptorSet(m_FrustumCommands);
+	writeDescriptorSet(m_OcclusionCommands);
+}
+
+IndirectDrawList::~IndirectDrawList()
+{
+	if (m_StagingBuffer.m_Buffer != VK_NULL_HANDLE)
+		m_Instance.getDeletionQueue().retire(m_StagingBuffer.m_Buffer, m_StagingBuffer.m_Allocation);
+}
+
+void IndirectDrawList::setInstances(std::span<const DrawInstance> instances)
+{
+	OPTICK_EVENT();
+
+	if (instances.size() > m_MaximumInstances)
+	{
+		GRAPHITE_LOG_WARNING("Cannot draw {} instances, only the first {} will be drawn!", instances.size(), m_MaximumInstances);
+		instances = instances.first(m_MaximumInstances);
+	}
+
+	// Drop the previous instances if they were never uploaded.
+	if (m_StagingBuffer.m_Buffer != VK_NULL_HANDLE)
+	{
+		m_Instance.getDeletionQueue().retire(m_StagingBuffer.m_Buffer, m_StagingBuffer.m_Allocation);
+		m_StagingBuffer = BufferData();
+	}
+
+	// The visibility of the old instances means nothing for the new ones.
+	m_InstanceCount = static_cast<uint32_t>(instances.size());
+	m_bClearVisibility = true;
+
+	if (instances.empty())
+		return;
+
+	m_StagingBuffer = Buffer::Allocate(m_Instance, instances.size_bytes(), VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+	m_Instance.getAllocator().access([this, instances](VmaAllocator allocator)
+		{
+			void* pStagingMemory = nullptr;
+			GRAPHITE_VK_ASSERT(vmaMapMemory(allocator, m_StagingBuffer.m_Allocation, &pStagingMemory), "Failed to map the instance staging buffer!");
+
+			std::memcpy(pStagingMemory, instances.data(), instances.size_bytes());
+
+			GRAPHITE_VK_ASSERT(vmaFlushAllocation(allocator, m_StagingBuffer.m_Allocation, 0, VK_WHOLE_SIZE), "Failed to flush the instance staging buffer!");
+			vmaUnmapMemory(allocator, m_StagingBuffer.m_Allocation);
+		}
+	);
+}
+
+void IndirectDrawList::cull(VkCommandBuffer commandBuffer, const Frustum& frustum)
+{
+	OPTICK_EVENT();
+
+	if (!m_FrustumPipeline.isValid())
+		return;
+
+	recordPassBegin(commandBuffer, m_FrustumCommands);
+
+	// Cull the instances and write the draw commands.
+	if (m_InstanceCount > 0)
+	{
+		FrustumConstants constants;
+		constants.m_Frustum = frustum;
+		constants.m_InstanceCount = m_InstanceCount;
+		constants.m_Compact = m_bUseDrawCount ? 1 : 0;
+		constants.m_OnlyVisible = m_bOcclusionCulling ? 1 : 0;
+
+		m_FrustumPipeline.bind(commandBuffer, { m_FrustumCommands.m_DescriptorSet });
+		m_FrustumPipeline.pushConstants(commandBuffer, constants);
+		m_Instance.getDeviceTable().vkCmdDispatch(commandBuffer, (m_InstanceCount + g_CullingGroupSize - 1) / g_CullingGroupSize, 1, 1);
+	}
+
+	recordPassEnd(commandBuffer);
+}
+
+void IndirectDrawList::cullOcclusion(VkCommandBuffer commandBuffer, const std::array<float, 16>& viewProjection, const DepthPyramid& pyramid)
+{
+	OPTICK_EVENT();
+
+	if (!m_bOcclusionCulling)
+		return;
+
+	recordPassBegin(commandBuffer, m_OcclusionCommands);
+
+	if (m_InstanceCount > 0)
+	{
+		OcclusionConstants constants;
+		constants.m_ViewProjection = viewProjection;
+		constants.m_PyramidSize = { static_cast<float>(pyramid.getWidth()), static_cast<float>(pyramid.getHeight()) };
+		constants.m_InstanceCount = m_InstanceCount;
+		constants.m_Compact = m_bUseDrawCount ? 1 : 0;
+
+		m_OcclusionPipeline.bind(commandBuffer, { m_OcclusionCommands.m_DescriptorSet, pyramid.getSamplingDescriptorSet() });
+		m_OcclusionPipeline.pushConstants(commandBuffer, constants);
+		m_Instance.getDeviceTable().vkCmdDispatch(commandBuffer, (m_InstanceCount + g_CullingGroupSize - 1) / g_CullingGroupSize, 1, 1);
+	}
+
+	recordPassEnd(commandBuffer);
+}
+
+void IndirectDrawList::writeDescriptorSet(DrawCommands& commands)
+{
+	commands.m_DescriptorSet = m_FrustumPipeline.allocateDescriptorSet(0);
+	m_FrustumPipeline.writeBuffer(commands.m_DescriptorSet, CullingBinding::Instances, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_InstanceBuffer.getBuffer());
+	m_FrustumPipeline.writeBuffer(commands.m_DescriptorSet, CullingBinding::Commands, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, commands.m_Commands.getBuffer());
+	m_FrustumPipeline.writeBuffer(commands.m_DescriptorSet, CullingBinding::DrawCount, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, commands.m_Count.getBuffer());
+	m_FrustumPipeline.writeBuffer(commands.m_DescriptorSet, CullingBinding::Visibility, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_VisibilityBuffer.getBuffer());
+}
+
+void IndirectDrawList::recordPassBegin(VkCommandBuffer commandBuffer, const DrawCommands& commands)
+{
+	const auto& deviceTable = m_Instance.getDeviceTable();
+
+	// The previous passes must be done with the buffers before we write to them again.
+	ComputePipeline::RecordMemoryBarrier(deviceTable, commandBuffer,
+		VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT_KHR | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT_KHR | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR,
+		VK_PIPELINE_STAGE_2_COPY_BIT_KHR | VK_PIPELINE_STAGE_2_CLEAR_BIT_KHR | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR,
+		VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR | VK_ACCESS_2_SHADER_STORAGE_READ_BIT_KHR | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR);
+
+	recordUpload(commandBuffer);
+
+	if (m_bClearVisibility)
+	{
+		deviceTable.vkCmdFillBuffer(commandBuffer, m_VisibilityBuffer.getBuffer(), 0, VK_WHOLE_SIZE, 0);
+		m_bClearVisibility = false;
+	}
+
+	if (m_bUseDrawCount)
+		deviceTable.vkCmdFillBuffer(commandBuffer, commands.m_Count.getBuffer(), 0, sizeof(uint32_t), 0);
+
+	ComputePipeline::RecordMemoryBarrier(deviceTable, commandBuffer,
+		VK_PIPELINE_STAGE_2_COPY_BIT_KHR | VK_PIPELINE_STAGE_2_CLEAR_BIT_KHR, VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR,
+		VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_STORAGE_READ_BIT_KHR | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR);
+}
+
+void IndirectDrawList::recordPassEnd(VkCommandBuffer commandBuffer) const
+{
+	// Make the draw commands visible to the indirect draw, and the visibility to the next pass.
+	ComputePipeline::RecordMemoryBarrier(m_Instance.getDeviceTable(), commandBuffer,
+		VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR,
+		VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT_KHR | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT_KHR | VK_ACCESS_2_SHADER_STORAGE_READ_BIT_KHR);
+}
+
+void IndirectDrawList::recordDraw(VkCommandBuffer commandBuffer, const DrawCommands& commands) const
+{
+	OPTICK_EVENT();
+
+	if (!m_FrustumPipeline.isValid() || m_InstanceCount == 0)
+		return;
+
+	const auto& deviceTable = m_Instance.getDeviceTable();
+	constexpr auto stride = static_cast<uint32_t>(sizeof(VkDrawIndexedIndirectCommand));
+
+	if (m_bUseDrawCount)
+	{
+		deviceTable.vkCmdDrawIndexedIndirectCountKHR(commandBuffer, commands.m_Commands.getBuffer(), 0, commands.m_Count.getBuffer(), 0, m_InstanceCount, stride);
+	}
+	else if (m_bUseMultiDraw)
+	{
+		deviceTable.vkCmdDrawIndexedIndirect(commandBuffer, commands.m_Commands.getBuffer(), 0, m_InstanceCount, stride);
+	}
+	else
+	{
+		for (uint32_t i = 0; i < m_InstanceCount; i++)
+			deviceTable.vkCmdDrawIndexedIndirect(commandBuffer, commands.m_Commands.getBuffer(), static_cast<VkDeviceSize>(i) * stride, 1, stride);
+	}
+}
+
+void IndirectDrawList::recordUpload(VkCommandBuffer commandBuffer)
+{
+	if (m_StagingBuffer.m_Buffer == VK_NULL_HANDLE)
+		return;
+
+	VkBufferCopy copy = {};
+	copy.srcOffset = 0;
+	copy.dstOffset = 0;
+	copy.size = m_StagingBuffer.m_Size;
+	m_Instance.getDeviceTable().vkCmdCopyBuffer(commandBuffer, m_StagingBuffer.m_Buffer, m_InstanceBuffer.getBuffer(), 1, &copy);
+
+	// The staging buffer is destroyed once the frame which copies it is done.
+	m_Instance.getDeletionQueue().retire(m_StagingBuffer.m_Buffer, m_StagingBuffer.m_Allocation);
+	m_StagingBuffer = BufferData();
+}
@@ -0,0 +1,232 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "Buffer.hpp"
+#include "DepthPyramid.hpp"
+
+#include "Core/Frustum.hpp"
+
+#include <span>
+
+/**
+ * Draw instance structure.
+ * This contains everything the culling shader needs to know about a single instance. It's mirrored in Shaders/Culling.hlsl.
+ */
+struct DrawInstance final
+{
+	std::array<float, 4> m_BoundingSphere = {};	// World space center and radius.
+
+	uint32_t m_IndexCount = 0;
+	uint32_t m_FirstIndex = 0;
+	int32_t m_VertexOffset = 0;
+	uint32_t m_Padding = 0;
+};
+
+static_assert(sizeof(DrawInstance) == 32, "The draw instance must match the culling shader's layout!");
+
+/**
+ * Indirect draw list class.
+ * This keeps the instances of a scene on the GPU and turns them into indirect draw commands with a compute pass, so the CPU cost of a frame does
+ * not depend on the number of instances. The instances are uploaded once, and each frame the culling pass tests them against the view frustum
+ * and appends the visible ones to the command buffer with a draw count, which is drawn with a single indexed indirect count call.
+ *
+ * With occlusion culling enabled, the culling runs in two phases:
+ * 1. cull() only takes the instances which were visible in the last frame, and draw() renders them. This fills most of the depth buffer.
+ * 2. The depth pyramid is built from that depth, and cullOcclusion() tests every instance against it. The visible instances which were not drawn in
+ *    the first phase are drawn by drawOcclusion(), and the visibility is stored for the next frame.
+ * So objects which become visible are drawn in the same frame they appear in, instead of popping in a frame late.
+ *
+ * The first instance of each command is the instance's index, so the vertex shader can fetch the per-instance data with the base instance.
+ * If the device does not support the draw count, the commands are not compacted and the culled ones draw zero instances instead.
+ */
+class IndirectDrawList final : public InstanceBoundObject
+{
+	/**
+	 * Frustum constants structure.
+	 * This is pushed to the frustum culling shader.
+	 */
+	struct FrustumConstants final
+	{
+		Frustum m_Frustum;
+		uint32_t m_InstanceCount = 0;
+		uint32_t m_Compact = 0;
+		uint32_t m_OnlyVisible = 0;
+	};
+
+	/**
+	 * Occlusion constants structure.
+	 * This is pushed to the occlusion culling shader.
+	 */
+	struct OcclusionConstants final
+	{
+		std::array<float, 16> m_ViewProjection = {};
+		std::array<float, 2> m_PyramidSize = {};
+		uint32_t m_InstanceCount = 0;
+		uint32_t m_Compact = 0;
+	};
+
+	/**
+	 * Draw commands structure.
+	 * This contains the output of a single culling pass.
+	 */
+	struct DrawCommands final
+	{
+		/**
+		 * Explicit constructor.
+		 *
+		 * @param instance The instance reference.
+		 * @param maximumInstances The maximum number of instances.
+		 */
+		explicit DrawCommands(Instance& instance, uint32_t maximumInstances);
+
+		Buffer m_Commands;
+		Buffer m_Count;
+
+		VkDescriptorSet m_DescriptorSet = VK_NULL_HANDLE;
+	};
+
+public:
+	/**
+	 * Explicit constructor.
+	 *
+	 * @param instance The instance reference.
+	 * @param maximumInstances The maximum number of instances the list can hold.
+	 * @param shaderDirectory The directory containing the compiled culling shaders. Default is Shaders.
+	 */
+	explicit IndirectDrawList(Instance& instance, uint32_t maximumInstances, const std::filesystem::path& shaderDirectory = "Shaders");
+
+	/**
+	 * Destructor.
+	 */
+	~IndirectDrawList() override;
+
+	/**
+	 * Set the instances to draw.
+	 * The instances are copied to a staging buffer, and uploaded to the GPU by the next culling pass.
+	 *
+	 * @param instances The instances. Anything past the maximum instance count is ignored.
+	 */
+	void setInstances(std::span<const DrawInstance> instances);
+
+	/**
+	 * Check if the list can cull.
+	 * Occlusion culling has it's own shader, which is checked by setOcclusionCulling().
+	 *
+	 * @return True if the frustum culling shader was loaded.
+	 */
+	[[nodiscard]] bool isValid() const { return m_FrustumPipeline.isValid(); }
+
+	/**
+	 * Enable or disable occlusion culling.
+	 * When enabled, cull() only takes the instances which were visible in the last frame, and cullOcclusion() must be called every frame.
+	 *
+	 * @param enable Whether to enable occlusion culling.
+	 */
+	void setOcclusionCulling(bool enable) { m_bOcclusionCulling = enable && m_OcclusionPipeline.isValid(); }
+
+	/**
+	 * Record the frustum culling pass.
+	 * This is the first phase if occlusion culling is enabled. It must be recorded on the graphics queue before the render pass which draws the list.
+	 *
+	 * @param commandBuffer The command buffer to record to.
+	 * @param frustum The view frustum to cull against.
+	 */
+	void cull(VkCommandBuffer commandBuffer, const Frustum& frustum);
+
+	/**
+	 * Record the occlusion culling pass.
+	 * This is the second phase, and must be recorded after the depth pyramid is built from the first phase's depth.
+	 *
+	 * @param commandBuffer The command buffer to record to.
+	 * @param viewProjection The column major view projection matrix.
+	 * @param pyramid The depth pyramid.
+	 */
+	void cullOcclusion(VkCommandBuffer commandBuffer, const std::array<float, 16>& viewProjection, const DepthPyramid& pyramid);
+
+	/**
+	 * Record the draw call of the frustum culling pass.
+	 * The graphics pipeline and the vertex and index buffers must be bound before this.
+	 *
+	 * @param commandBuffer The command buffer to record to.
+	 */
+	void draw(VkCommandBuffer commandBuffer) const { recordDraw(commandBuffer, m_FrustumCommands); }
+
+	/**
+	 * Record the draw call of the occlusion culling pass.
+	 * This only draws the instances which became visible in this frame.
+	 *
+	 * @param commandBuffer The command buffer to record to.
+	 */
+	void drawOcclusion(VkCommandBuffer commandBuffer) const { recordDraw(commandBuffer, m_OcclusionCommands); }
+
+public:
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, InstanceCount, m_InstanceCount);
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, MaximumInstances, m_MaximumInstances);
+	GRAPHITE_SETUP_SIMPLE_GETTER(VkBuffer, InstanceBuffer, m_InstanceBuffer.getBuffer());
+	GRAPHITE_SETUP_SIMPLE_GETTER(VkBuffer, VisibilityBuffer, m_VisibilityBuffer.getBuffer());
+	GRAPHITE_SETUP_SIMPLE_GETTER(VkBuffer, FrustumDrawBuffer, m_FrustumCommands.m_Commands.getBuffer());
+	GRAPHITE_SETUP_SIMPLE_GETTER(VkBuffer, FrustumCountBuffer, m_FrustumCommands.m_Count.getBuffer());
+	GRAPHITE_SETUP_SIMPLE_GETTER(VkBuffer, OcclusionDrawBuffer, m_OcclusionCommands.m_Commands.getBuffer());
+	GRAPHITE_SETUP_SIMPLE_GETTER(VkBuffer, OcclusionCountBuffer, m_OcclusionCommands.m_Count.getBuffer());
+	GRAPHITE_SETUP_SIMPLE_GETTER(bool, IsCompacting, m_bUseDrawCount);
+	GRAPHITE_SETUP_SIMPLE_GETTER(bool, IsOcclusionCulling, m_bOcclusionCulling);
+
+private:
+	/**
+	 * Allocate and write the descriptor set of a culling pass.
+	 *
+	 * @param commands The draw commands of the pass.
+	 */
+	void writeDescriptorSet(DrawCommands& commands);
+
+	/**
+	 * Record the barriers and the clears before a culling pass.
+	 *
+	 * @param commandBuffer The command buffer to record to.
+	 * @param commands The draw commands of the pass.
+	 */
+	void recordPassBegin(VkCommandBuffer commandBuffer, const DrawCommands& commands);
+
+	/**
+	 * Record the barrier which makes the draw commands of a culling pass visible to the draw.
+	 *
+	 * @param commandBuffer The command buffer to record to.
+	 */
+	void recordPassEnd(VkCommandBuffer commandBuffer) const;
+
+	/**
+	 * Record the draw call of a culling pass.
+	 *
+	 * @param commandBuffer The command buffer to record to.
+	 * @param commands The draw commands to draw.
+	 */
+	void recordDraw(VkCommandBuffer commandBuffer, const DrawCommands& commands) const;
+
+	/**
+	 * Record the upload of the pending instances.
+	 *
+	 * @param commandBuffer The command buffer to record to.
+	 */
+	void recordUpload(VkCommandBuffer commandBuffer);
+
+private:
+	Buffer m_InstanceBuffer;
+	Buffer m_VisibilityBuffer;
+
+	DrawCommands m_FrustumCommands;
+	DrawCommands m_OcclusionCommands;
+
+	ComputePipeline m_FrustumPipeline;
+	ComputePipeline m_OcclusionPipeline;
+
+	BufferData m_StagingBuffer;
+
+	uint32_t m_MaximumInstances = 0;
+	uint32_t m_InstanceCount = 0;
+
+	bool m_bUseDrawCount = false;
+	bool m_bUseMultiDraw = false;
+	bool m_bOcclusionCulling = false;
+	bool m_bClearVisibility = true;
+};
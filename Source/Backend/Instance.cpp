@@ -2,16 +2,23 @@
 
 #include "Instance.hpp"
 #include "VulkanMacros.hpp"
+#include "CommandCapture.hpp"
 
 #include "Core/Common.hpp"
+#include "Core/MemoryArena.hpp"
+#include "Core/StartupTrace.hpp"
 
 #include <SDL3/SDL_vulkan.h>
 
 #include <optick.h>
 
+#include <algorithm>
 #include <set>
 #include <string_view>
 #include <bit>
+#include <limits>
+#include <fstream>
+#include <cstring>
 
 namespace /* anonymous */
 {
@@ -42,6 +49,23 @@ namespace /* anonymous */
 
 #endif
 
+		// Surface maintenance is needed for the swapchain's present fences. It's optional, so it's only enabled if the loader has it.
+		uint32_t availableCount = 0;
+		GRAPHITE_VK_ASSERT(vkEnumerateInstanceExtensionProperties(nullptr, &availableCount, nullptr), "Failed to enumerate the instance extension property count!");
+
+		std::vector<VkExtensionProperties> availableExtensions(availableCount);
+		GRAPHITE_VK_ASSERT(vkEnumerateInstanceExtensionProperties(nullptr, &availableCount, availableExtensions.data()), "Failed to enumerate the instance extension properties!");
+
+		for (const auto pExtension : { VK_KHR_GET_SURFACE_CAPABILITIES_2_EXTENSION_NAME, VK_EXT_SURFACE_MAINTENANCE_1_EXTENSION_NAME })
+		{
+			const auto isAvailable = std::any_of(availableExtensions.begin(), availableExtensions.end(), [pExtension](const VkExtensionProperties& properties) { return std::string_view(pExtension) == properties.extensionName; });
+			if (!isAvailable)
+				break;
+
+			if (GRAPHITE_RANGES(find, extensions, std::string_view(pExtension)) == extensions.end())
+				extensions.emplace_back(pExtension);
+		}
+
 		return extensions;
 	}
 
@@ -120,7 +144,8 @@ namespace /* anonymous */
 		}
 
 		// Get the queue family properties.
-		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		const auto scratch = ScratchScope();
+		auto queueFamilies = scratch.makeVector<VkQueueFamilyProperties>(queueFamilyCount);
 		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
 
 		// Iterate over those queue family properties and check if we have a family with the required flag.
@@ -156,10 +181,11 @@ namespace /* anonymous */
 		GRAPHITE_VK_ASSERT(vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr), "Failed to enumerate physical device extension property count!");
 
 		// Load the extensions.
-		std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+		const auto scratch = ScratchScope();
+		auto availableExtensions = scratch.makeVector<VkExtensionProperties>(extensionCount);
 		GRAPHITE_VK_ASSERT(vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data()), "Failed to enumerate physical device extension properties!");
 
-		std::set<std::string_view> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
+		std::pmr::set<std::string_view> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end(), {}, scratch.getResource());
 
 		// Iterate and check if it contains the extensions we need. If it does, remove them from the set so we can later check if 
 		// all the required extensions exist.
@@ -199,7 +225,8 @@ namespace /* anonymous */
 		GRAPHITE_VK_ASSERT(vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr), "Failed to enumerate physical device extension property count!");
 
 		// Load the extensions.
-		std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+		const auto scratch = ScratchScope();
+		auto availableExtensions = scratch.makeVector<VkExtensionProperties>(extensionCount);
 		GRAPHITE_VK_ASSERT(vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data()), "Failed to enumerate physical device extension properties!");
 
 		std::set<std::string_view> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
@@ -218,69 +245,182 @@ namespace /* anonymous */
 
 	/**
 	 * Find the physical device queue family with the required flag.
+	 * Families with fewer capabilities are preferred, so a compute-only or a transfer-only family is selected over the graphics family if the device
+	 * has one. This is what allows compute and transfer work to run asynchronously to the graphics work.
 	 *
-	 * @param physicalDevice The Vulkan physical device.
+	 * @param queueFamilyProperties The queue family properties of the physical device.
 	 * @param flag The flag to check and get.
 	 * @return The family index. -1 is returned if not found.
 	 */
-	[[nodiscard]] uint32_t FindPhysialDeviceQueueFamily(const VkPhysicalDevice& physicalDevice, VkQueueFlagBits flag)
+	[[nodiscard]] uint32_t FindPhysialDeviceQueueFamily(const std::vector<VkQueueFamilyProperties>& queueFamilyProperties, VkQueueFlagBits flag)
 	{
-		// Get the queue family count.
-		uint32_t queueFamilyCount = 0;
-		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+		constexpr VkQueueFlags capabilityMask = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT;
 
-		// Validate if we have queue families.
-		if (queueFamilyCount == 0)
+		uint32_t bestFamily = -1;
+		int bestCapabilityCount = std::numeric_limits<int>::max();
+		for (uint32_t i = 0; i < queueFamilyProperties.size(); i++)
 		{
-			GRAPHITE_LOG_FATAL("Failed to get the queue family property count!");
-			return false;
+			const auto& properties = queueFamilyProperties[i];
+			if (properties.queueCount == 0 || (properties.queueFlags & flag) == 0)
+				continue;
+
+			const auto capabilityCount = std::popcount(properties.queueFlags & capabilityMask);
+			if (capabilityCount < bestCapabilityCount)
+			{
+				bestFamily = i;
+				bestCapabilityCount = capabilityCount;
+			}
 		}
 
-		// Get the queue family properties.
-		std::vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamilyCount);
-		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilyProperties.data());
+		return bestFamily;
+	}
 
-		for (uint32_t i = 0; i < queueFamilyProperties.size(); i++)
+	/**
+	 * Get the name of a queue type.
+	 *
+	 * @param type The queue type.
+	 * @return The name.
+	 */
+	[[nodiscard]] std::string_view GetQueueTypeName(QueueType type)
+	{
+		switch (type)
 		{
-			if (queueFamilyProperties[i].queueFlags & flag)
-				return i;
+		case QueueType::Graphics:
+			return "graphics";
+
+		case QueueType::Compute:
+			return "compute";
+
+		default:
+			return "transfer";
 		}
+	}
+
+	/**
+	 * Read the pipeline cache file.
+	 * This runs on a worker thread while the instance and the device are created.
+	 *
+	 * @param path The cache file path.
+	 * @return The file contents. Empty if the file does not exist.
+	 */
+	[[nodiscard]] std::vector<std::byte> ReadPipelineCacheFile(const std::filesystem::path& path)
+	{
+		OPTICK_THREAD("Pipeline Cache Loader");
+		GRAPHITE_STARTUP_PHASE("Pipeline cache file read");
+
+		auto file = std::ifstream(path, std::ios::binary | std::ios::ate);
+		if (!file.is_open())
+			return {};
+
+		std::vector<std::byte> data(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+		return data;
+	}
+
+	/**
+	 * Check if the pipeline cache data was created by the same device and driver.
+	 * Drivers are supposed to reject incompatible data, but not all of them do it properly.
+	 *
+	 * @param data The pipeline cache data.
+	 * @param properties The physical device properties.
+	 * @return True if the data can be used.
+	 */
+	[[nodiscard]] bool IsPipelineCacheCompatible(const std::vector<std::byte>& data, const VkPhysicalDeviceProperties& properties)
+	{
+		VkPipelineCacheHeaderVersionOne header = {};
+		if (data.size() < sizeof(header))
+			return false;
 
-		return -1;
+		std::memcpy(&header, data.data(), sizeof(header));
+		return header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+			header.vendorID == properties.vendorID &&
+			header.deviceID == properties.deviceID &&
+			std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
 	}
 }
 
-Instance::Instance()
+Instance::Instance(QueueSharingPolicy sharingPolicy, std::filesystem::path pipelineCachePath, std::filesystem::path capturePath)
+	: m_PipelineCachePath(std::move(pipelineCachePath)), m_CapturePath(std::move(capturePath)), m_DeletionQueue(*this), m_ResourceStore(*this), m_QueueSharingPolicy(sharingPolicy)
 {
+	OPTICK_EVENT();
+
+	// Start reading the pipeline cache file. It's only needed after the device is created.
+	m_PipelineCacheData = std::async(std::launch::async, ReadPipelineCacheFile, m_PipelineCachePath);
+
 	// Load the Vulkan library to SDL.
-	if (SDL_Vulkan_LoadLibrary(nullptr) != 0)
 	{
-		GRAPHITE_LOG_FATAL("Failed to load the Vulkan library in SDL! {}", SDL_GetError());
-		return;
+		GRAPHITE_STARTUP_PHASE("Vulkan loader");
+		if (SDL_Vulkan_LoadLibrary(nullptr) != 0)
+		{
+			GRAPHITE_LOG_FATAL("Failed to load the Vulkan library in SDL! {}", SDL_GetError());
+			return;
+		}
+
+		// Initialize Volk.
+		volkInitializeCustom(GRAPHITE_BIT_CAST(PFN_vkGetInstanceProcAddr, SDL_Vulkan_GetVkGetInstanceProcAddr()));
 	}
 
 	// Set up the device extensions.
 	m_DeviceExtensions.emplace_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
 	m_DeviceExtensions.emplace_back(VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME);
-
-	// Initialize Volk.
-	volkInitializeCustom(GRAPHITE_BIT_CAST(PFN_vkGetInstanceProcAddr, SDL_Vulkan_GetVkGetInstanceProcAddr()));
+	m_DeviceExtensions.emplace_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+	m_DeviceExtensions.emplace_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+	m_DeviceExtensions.emplace_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+	m_DeviceExtensions.emplace_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+	m_DeviceExtensions.emplace_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	m_DeviceExtensions.emplace_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+	m_DeviceExtensions.emplace_back(VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME);
+	m_DeviceExtensions.emplace_back(VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME);
+	m_DeviceExtensions.emplace_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+	m_DeviceExtensions.emplace_back(VK_EXT_SWAPCHAIN_MAINTENANCE_1_EXTENSION_NAME);
 
 	// Create the instance.
-	createInstance();
+	{
+		GRAPHITE_STARTUP_PHASE("Vulkan instance creation");
+		createInstance();
+	}
+
+	// Select the best physical device and the queues to use.
+	{
+		GRAPHITE_STARTUP_PHASE("Physical device selection");
+		selectPhysicalDevice();
+		selectQueues();
+	}
 
-	// Select the best physical device.
-	selectPhysicalDevice();
+	// Create the logical device, the memory allocator and the pipeline cache in the background.
+	// These don't touch SDL, so the caller can create the windows on this thread in the meantime.
+	m_DeviceCreation = std::async(std::launch::async, [this]
+		{
+			OPTICK_THREAD("Device Creation");
 
-	// Create the logical device.
-	createLogicalDevice();
+			{
+				GRAPHITE_STARTUP_PHASE("Logical device creation");
+				createLogicalDevice();
+			}
 
-	// Create the memory allocator.
-	createMemoryAllocator();
+			{
+				GRAPHITE_STARTUP_PHASE("Memory allocator creation");
+				createMemoryAllocator();
+			}
+
+			GRAPHITE_STARTUP_PHASE("Pipeline cache creation");
+			createPipelineCache();
+		}
+	);
 }
 
 Instance::~Instance()
 {
+	waitForDevice();
+	savePipelineCache();
+
+	// Everything using the device is destroyed by now, so the remaining and the retired resources can be released.
+	m_ResourceStore.clear();
+	m_DeletionQueue.releaseAll();
+
+	m_DeviceTable.vkDestroyPipelineCache(m_LogicalDevice.getUnsafe(), m_PipelineCache, nullptr);
 	m_DeviceTable.vkDestroyDevice(m_LogicalDevice.getUnsafe(), nullptr);
 
 #ifdef GRAPHITE_DEBUG
@@ -303,6 +443,26 @@ void Instance::waitIdle()
 	);
 }
 
+void Instance::waitForDevice()
+{
+	if (!m_DeviceCreation.valid())
+		return;
+
+	OPTICK_EVENT();
+	m_DeviceCreation.get();
+}
+
+bool Instance::isQueueShared(QueueType type) const
+{
+	const auto mapping = m_QueueMapping[static_cast<uint8_t>(type)];
+	return GRAPHITE_RANGES(count, m_QueueMapping, mapping) > 1;
+}
+
+bool Instance::isDeviceExtensionEnabled(std::string_view extension) const
+{
+	return GRAPHITE_RANGES(find, m_DeviceExtensions, extension) != m_DeviceExtensions.end();
+}
+
 void Instance::createInstance()
 {
 	VkApplicationInfo applicationInfo = {};
@@ -325,6 +485,10 @@ void Instance::createInstance()
 	createInfo.enabledExtensionCount = static_cast<uint32_t>(requiredExtensions.size());
 	createInfo.ppEnabledExtensionNames = requiredExtensions.data();
 
+	// Swapchain maintenance can't be used without surface maintenance on the instance.
+	if (GRAPHITE_RANGES(find, requiredExtensions, std::string_view(VK_EXT_SURFACE_MAINTENANCE_1_EXTENSION_NAME)) == requiredExtensions.end())
+		removeDeviceExtension(VK_EXT_SWAPCHAIN_MAINTENANCE_1_EXTENSION_NAME);
+
 #ifdef GRAPHITE_DEBUG
 	// Emplace the required validation layer(s).
 	m_ValidationLayers.emplace_back("VK_LAYER_KHRONOS_validation");
@@ -376,7 +540,8 @@ void Instance::selectPhysicalDevice()
 		return;
 	}
 
-	std::vector<VkPhysicalDevice> candidates(deviceCount);
+	const auto scratch = ScratchScope();
+	auto candidates = scratch.makeVector<VkPhysicalDevice>(deviceCount);
 	GRAPHITE_VK_ASSERT(vkEnumeratePhysicalDevices(m_Instance, &deviceCount, candidates.data()), "Failed to enumerate physical devices.");
 
 	struct Candidate { VkPhysicalDeviceProperties m_Properties; VkPhysicalDevice m_Candidate; };
@@ -467,37 +632,83 @@ void Instance::selectPhysicalDevice()
 
 #endif
 	}
+}
+
+void Instance::selectQueues()
+{
+	// Get the queue family properties.
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(m_PhysicalDevice.getUnsafe(), &queueFamilyCount, nullptr);
+
+	m_QueueFamilyProperties.resize(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(m_PhysicalDevice.getUnsafe(), &queueFamilyCount, m_QueueFamilyProperties.data());
+
+	// Setup the queue families. Graphics work gets the highest priority since it's the one on the critical path.
+	constexpr std::array<VkQueueFlagBits, 3> queueFlags = { VK_QUEUE_GRAPHICS_BIT, VK_QUEUE_COMPUTE_BIT, VK_QUEUE_TRANSFER_BIT };
+	constexpr std::array<float, 3> queuePriorities = { 1.0f, 0.75f, 0.5f };
+
+	// The number of queues used from each family so far.
+	std::vector<uint32_t> usedQueueCounts(queueFamilyCount, 0);
 
-	// Setup the queue families.
-	getGraphicsQueue().getUnsafe().m_Family = FindPhysialDeviceQueueFamily(m_PhysicalDevice.getUnsafe(), VK_QUEUE_GRAPHICS_BIT);
-	getComputeQueue().getUnsafe().m_Family = FindPhysialDeviceQueueFamily(m_PhysicalDevice.getUnsafe(), VK_QUEUE_COMPUTE_BIT);
-	getTransferQueue().getUnsafe().m_Family = FindPhysialDeviceQueueFamily(m_PhysicalDevice.getUnsafe(), VK_QUEUE_TRANSFER_BIT);
+	for (uint8_t i = 0; i < m_Queues.size(); i++)
+	{
+		auto& queue = m_Queues[i].getUnsafe();
+		queue.m_Family = FindPhysialDeviceQueueFamily(m_QueueFamilyProperties, queueFlags[i]);
+		queue.m_Priority = queuePriorities[i];
+
+		// Check if we can create a separate queue for this type.
+		auto& usedQueueCount = usedQueueCounts[queue.m_Family];
+		const bool canUseSeparateQueue = usedQueueCount < m_QueueFamilyProperties[queue.m_Family].queueCount;
+
+		if (usedQueueCount == 0 || (m_QueueSharingPolicy == QueueSharingPolicy::PreferSeparateQueues && canUseSeparateQueue))
+		{
+			queue.m_Index = usedQueueCount++;
+			m_QueueMapping[i] = i;
+		}
+
+		// Else share the queue of the first type which is in the same family.
+		else
+		{
+			for (uint8_t j = 0; j < i; j++)
+			{
+				if (m_Queues[j].getUnsafe().m_Family == queue.m_Family && m_QueueMapping[j] == j)
+				{
+					m_QueueMapping[i] = j;
+					break;
+				}
+			}
+		}
+
+		const auto& mappedQueue = m_Queues[m_QueueMapping[i]].getUnsafe();
+		GRAPHITE_LOG_INFORMATION("Using queue {} of family {} for {} work{}.", mappedQueue.m_Index, mappedQueue.m_Family, GetQueueTypeName(static_cast<QueueType>(i)), isQueueShared(static_cast<QueueType>(i)) ? " (shared)" : "");
+	}
 }
 
 void Instance::createLogicalDevice()
 {
-	// Setup device queues.
-	constexpr float priority = 1.0f;
-
-	VkDeviceQueueCreateInfo queueCreateInfo = {};
-	queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-	queueCreateInfo.pNext = nullptr;
-	queueCreateInfo.flags = 0;
-	queueCreateInfo.queueFamilyIndex = 0;
-	queueCreateInfo.queueCount = 1;
-	queueCreateInfo.pQueuePriorities = &priority;
-	queueCreateInfo.queueFamilyIndex = getGraphicsQueue().getUnsafe().m_Family;
-
-	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos = { queueCreateInfo };
-	if (getComputeQueue().getUnsafe().m_Family != getGraphicsQueue().getUnsafe().m_Family)
+	// Collect the priorities of the queues we need from each family. The queue indices were assigned in order, so the priorities are too.
+	std::vector<std::vector<float>> familyPriorities(m_QueueFamilyProperties.size());
+	for (uint8_t i = 0; i < m_Queues.size(); i++)
 	{
-		queueCreateInfo.queueFamilyIndex = getComputeQueue().getUnsafe().m_Family;
-		queueCreateInfos.emplace_back(queueCreateInfo);
+		if (m_QueueMapping[i] == i)
+			familyPriorities[m_Queues[i].getUnsafe().m_Family].emplace_back(m_Queues[i].getUnsafe().m_Priority);
 	}
 
-	if (getTransferQueue().getUnsafe().m_Family != getComputeQueue().getUnsafe().m_Family)
+	// Setup device queues.
+	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
+	for (uint32_t family = 0; family < familyPriorities.size(); family++)
 	{
-		queueCreateInfo.queueFamilyIndex = getTransferQueue().getUnsafe().m_Family;
+		if (familyPriorities[family].empty())
+			continue;
+
+		VkDeviceQueueCreateInfo queueCreateInfo = {};
+		queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+		queueCreateInfo.pNext = nullptr;
+		queueCreateInfo.flags = 0;
+		queueCreateInfo.queueFamilyIndex = family;
+		queueCreateInfo.queueCount = static_cast<uint32_t>(familyPriorities[family].size());
+		queueCreateInfo.pQueuePriorities = familyPriorities[family].data();
+
 		queueCreateInfos.emplace_back(queueCreateInfo);
 	}
 
@@ -510,10 +721,109 @@ void Instance::createLogicalDevice()
 	features.fragmentStoresAndAtomics = VK_TRUE;
 	features.fillModeNonSolid = VK_TRUE;
 
+	// Query the extension features.
+	VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2Features = {};
+	synchronization2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+	synchronization2Features.pNext = nullptr;
+
+	VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineSemaphoreFeatures = {};
+	timelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+	timelineSemaphoreFeatures.pNext = &synchronization2Features;
+
+	VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures = {};
+	presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+	presentWaitFeatures.pNext = &timelineSemaphoreFeatures;
+
+	VkPhysicalDevicePresentIdFeaturesKHR presentIDFeatures = {};
+	presentIDFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+	presentIDFeatures.pNext = &presentWaitFeatures;
+
+	VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures = {};
+	dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+	dynamicRenderingFeatures.pNext = &presentIDFeatures;
+
+	VkPhysicalDeviceSwapchainMaintenance1FeaturesEXT swapchainMaintenanceFeatures = {};
+	swapchainMaintenanceFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SWAPCHAIN_MAINTENANCE_1_FEATURES_EXT;
+	swapchainMaintenanceFeatures.pNext = &dynamicRenderingFeatures;
+
+	VkPhysicalDeviceFeatures2 supportedFeatures = {};
+	supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	supportedFeatures.pNext = &swapchainMaintenanceFeatures;
+	vkGetPhysicalDeviceFeatures2(m_PhysicalDevice.getUnsafe(), &supportedFeatures);
+
+	// Timeline semaphores and synchronization 2 are required by the command submission queue.
+	if (!isDeviceExtensionEnabled(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME) || timelineSemaphoreFeatures.timelineSemaphore == VK_FALSE)
+		GRAPHITE_LOG_FATAL("The physical device does not support timeline semaphores!");
+
+	if (!isDeviceExtensionEnabled(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME) || synchronization2Features.synchronization2 == VK_FALSE)
+		GRAPHITE_LOG_FATAL("The physical device does not support synchronization 2!");
+
+	// Present wait requires present ID, so we disable both if either of them can't be used.
+	const bool supportsPresentWait = isDeviceExtensionEnabled(VK_KHR_PRESENT_ID_EXTENSION_NAME) && isDeviceExtensionEnabled(VK_KHR_PRESENT_WAIT_EXTENSION_NAME) &&
+		presentIDFeatures.presentId == VK_TRUE && presentWaitFeatures.presentWait == VK_TRUE;
+
+	if (!supportsPresentWait)
+	{
+		GRAPHITE_LOG_INFORMATION("Present wait is not supported. Frame pacing will fall back to CPU timing.");
+
+		removeDeviceExtension(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+		removeDeviceExtension(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+	}
+
+	// The graphics pipelines are created against attachment formats instead of render passes, so they can't be created without dynamic rendering.
+	const bool supportsDynamicRendering = isDeviceExtensionEnabled(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME) && dynamicRenderingFeatures.dynamicRendering == VK_TRUE;
+	if (!supportsDynamicRendering)
+	{
+		GRAPHITE_LOG_WARNING("Dynamic rendering is not supported. Graphics pipelines can't be created.");
+		removeDeviceExtension(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+	}
+
+	// Swapchain maintenance lets the window know when the presentation engine is done with a swapchain, so it can be destroyed right away.
+	const bool supportsSwapchainMaintenance = isDeviceExtensionEnabled(VK_EXT_SWAPCHAIN_MAINTENANCE_1_EXTENSION_NAME) && swapchainMaintenanceFeatures.swapchainMaintenance1 == VK_TRUE;
+	if (!supportsSwapchainMaintenance)
+		removeDeviceExtension(VK_EXT_SWAPCHAIN_MAINTENANCE_1_EXTENSION_NAME);
+
+	// Enable the block compressed texture formats the device supports. The texture loaders check the format support before using them.
+	features.textureCompressionBC = supportedFeatures.features.textureCompressionBC;
+	features.textureCompressionASTC_LDR = supportedFeatures.features.textureCompressionASTC_LDR;
+	features.textureCompressionETC2 = supportedFeatures.features.textureCompressionETC2;
+
+	// GPU driven rendering needs multiple draws per indirect call, and the first instance to find the instance data.
+	features.multiDrawIndirect = supportedFeatures.features.multiDrawIndirect;
+	features.drawIndirectFirstInstance = supportedFeatures.features.drawIndirectFirstInstance;
+	m_EnabledFeatures = features;
+
+	// Setup the features to enable. Only the structures of the enabled extensions can be chained.
+	VkPhysicalDeviceFeatures2 enabledFeatures = {};
+	enabledFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	enabledFeatures.pNext = nullptr;
+	enabledFeatures.features = features;
+
+	const auto chainFeatures = [&enabledFeatures](auto& extensionFeatures)
+	{
+		extensionFeatures.pNext = enabledFeatures.pNext;
+		enabledFeatures.pNext = &extensionFeatures;
+	};
+
+	chainFeatures(timelineSemaphoreFeatures);
+	chainFeatures(synchronization2Features);
+
+	if (supportsPresentWait)
+	{
+		chainFeatures(presentIDFeatures);
+		chainFeatures(presentWaitFeatures);
+	}
+
+	if (supportsDynamicRendering)
+		chainFeatures(dynamicRenderingFeatures);
+
+	if (supportsSwapchainMaintenance)
+		chainFeatures(swapchainMaintenanceFeatures);
+
 	// Setup the device create info.
 	VkDeviceCreateInfo deviceCreateInfo = {};
 	deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-	deviceCreateInfo.pNext = nullptr;
+	deviceCreateInfo.pNext = &enabledFeatures;
 	deviceCreateInfo.flags = 0;
 	deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 	deviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();
@@ -521,7 +831,7 @@ void Instance::createLogicalDevice()
 	deviceCreateInfo.ppEnabledLayerNames = nullptr;
 	deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(m_DeviceExtensions.size());
 	deviceCreateInfo.ppEnabledExtensionNames = m_DeviceExtensions.data();
-	deviceCreateInfo.pEnabledFeatures = &features;
+	deviceCreateInfo.pEnabledFeatures = nullptr;
 
 #ifdef GRAPHITE_DEBUG
 	// Get the validation layers and initialize it.
@@ -536,9 +846,20 @@ void Instance::createLogicalDevice()
 	// Load the device table.
 	volkLoadDeviceTable(&m_DeviceTable, m_LogicalDevice.getUnsafe());
 
-	// Get the queues.
-	for (auto& queue : m_Queues)
-		m_DeviceTable.vkGetDeviceQueue(m_LogicalDevice.getUnsafe(), queue.getUnsafe().m_Family, 0, &queue.getUnsafe().m_Queue);
+	// Get the queues. Shared queue types don't own a queue, they are mapped to the owner.
+	for (uint8_t i = 0; i < m_Queues.size(); i++)
+	{
+		auto& queue = m_Queues[i].getUnsafe();
+		if (m_QueueMapping[i] == i)
+			m_DeviceTable.vkGetDeviceQueue(m_LogicalDevice.getUnsafe(), queue.m_Family, queue.m_Index, &queue.m_Queue);
+	}
+
+	// Hook the device table before the allocator copies the functions, so it's allocations are captured too.
+	if (!m_CapturePath.empty())
+	{
+		m_pCapture = std::make_unique<CommandCapture>(*this, m_CapturePath);
+		m_pCapture->install(m_DeviceTable);
+	}
 }
 
 void Instance::createMemoryAllocator()
@@ -581,6 +902,55 @@ void Instance::createMemoryAllocator()
 	createInfo.instance = m_Instance;
 	createInfo.vulkanApiVersion = volkGetInstanceVersion();
 
+	// Let VMA query the real heap budgets if we can, so the streaming systems can react to the memory pressure of the whole system.
+	if (isDeviceExtensionEnabled(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME))
+		createInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+
 	// Create the allocator.
 	GRAPHITE_VK_ASSERT(vmaCreateAllocator(&createInfo, &m_Allocator.getUnsafe()), "Failed to create the allocator!");
 }
+
+void Instance::createPipelineCache()
+{
+	auto data = m_PipelineCacheData.get();
+	if (!data.empty() && !IsPipelineCacheCompatible(data, m_PhysicalDeviceProperties))
+	{
+		GRAPHITE_LOG_INFORMATION("The pipeline cache was created by a different device or driver. Starting with an empty cache.");
+		data.clear();
+	}
+
+	VkPipelineCacheCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	createInfo.pNext = nullptr;
+	createInfo.flags = 0;
+	createInfo.initialDataSize = data.size();
+	createInfo.pInitialData = data.data();
+
+	GRAPHITE_VK_ASSERT(m_DeviceTable.vkCreatePipelineCache(m_LogicalDevice.getUnsafe(), &createInfo, nullptr, &m_PipelineCache), "Failed to create the pipeline cache!");
+}
+
+void Instance::savePipelineCache()
+{
+	if (m_PipelineCache == VK_NULL_HANDLE)
+		return;
+
+	size_t size = 0;
+	GRAPHITE_VK_ASSERT(m_DeviceTable.vkGetPipelineCacheData(m_LogicalDevice.getUnsafe(), m_PipelineCache, &size, nullptr), "Failed to get the pipeline cache size!");
+
+	std::vector<std::byte> data(size);
+	GRAPHITE_VK_ASSERT(m_DeviceTable.vkGetPipelineCacheData(m_LogicalDevice.getUnsafe(), m_PipelineCache, &size, data.data()), "Failed to get the pipeline cache data!");
+
+	auto file = std::ofstream(m_PipelineCachePath, std::ios::binary);
+	if (!file.is_open())
+	{
+		GRAPHITE_LOG_ERROR("Failed to open the pipeline cache file {}!", m_PipelineCachePath.string());
+		return;
+	}
+
+	file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(size));
+}
+
+void Instance::removeDeviceExtension(std::string_view extension)
+{
+	std::erase_if(m_DeviceExtensions, [extension](const char* pExtension) { return extension == pExtension; });
+}
@@ -5,55 +5,149 @@
 #include "Core/Common.hpp"
 #include "Core/Guarded.hpp"
 
+#include "DeletionQueue.hpp"
+#include "ResourceStore.hpp"
+
 #include <volk.h>
 #include <vk_mem_alloc.h>
 
 #include <vector>
 #include <array>
 #include <fstream>
+#include <string_view>
+#include <filesystem>
+#include <future>
+#include <memory>
+
+class CommandCapture;
 
 /**
  * Vulkan queue structure.
- * This contains the Vulkan queue handle and it's family.
+ * This contains the Vulkan queue handle, it's family and the index within that family.
  */
 struct VulkanQueue final
 {
 	VkQueue m_Queue = VK_NULL_HANDLE;
 	uint32_t m_Family = 0;
+	uint32_t m_Index = 0;
+	float m_Priority = 1.0f;
+};
+
+/**
+ * Queue type enum.
+ * This specifies the role of a queue.
+ */
+enum class QueueType : uint8_t
+{
+	Graphics,
+	Compute,
+	Transfer
+};
+
+/**
+ * Queue sharing policy enum.
+ * This specifies what to do when multiple queue types end up in the same queue family.
+ */
+enum class QueueSharingPolicy : uint8_t
+{
+	PreferSeparateQueues,	// Create a separate queue in the family for each type if the family has enough queues, otherwise share.
+	AlwaysShare				// Use a single queue for all the types in the family.
 };
 
 /**
  * Instance class.
  * This contains the main Vulkan instance which is used by the engine.
+ *
+ * The instance and the physical device are created in the constructor, but the logical device, the allocator and the pipeline cache are created on
+ * a worker thread so the caller can create the windows in the meantime. Call waitForDevice() before using any of them.
  */
 class Instance final
 {
 public:
 	/**
-	 * Default constructor.
+	 * Explicit constructor.
+	 *
+	 * @param sharingPolicy The queue sharing policy to use when queue families coincide. Default is to prefer separate queues.
+	 * @param pipelineCachePath The file to load the pipeline cache from and to store it to. Default is PipelineCache.bin.
+	 * @param capturePath The file to capture the submitted work to. Default is empty, which disables the capture.
 	 */
-	Instance();
+	explicit Instance(QueueSharingPolicy sharingPolicy = QueueSharingPolicy::PreferSeparateQueues, std::filesystem::path pipelineCachePath = "PipelineCache.bin", std::filesystem::path capturePath = {});
 
 	/**
 	 * Destructor.
+	 * This stores the pipeline cache to the cache file.
 	 */
 	~Instance();
 
+	/**
+	 * Wait till the logical device, the allocator and the pipeline cache are created.
+	 * This only blocks the first time it's called.
+	 */
+	void waitForDevice();
+
 	/**
 	 * Wait idle till all the commands are done.
 	 */
 	void waitIdle();
 
+	/**
+	 * Check if a device extension is enabled.
+	 * Optional extensions are removed from the enabled list if the physical device does not support them.
+	 *
+	 * @param extension The extension name.
+	 * @return True if the extension is enabled.
+	 */
+	[[nodiscard]] bool isDeviceExtensionEnabled(std::string_view extension) const;
+
+	/**
+	 * Get a queue by it's type.
+	 * If the queue type is shared with another type, the same guarded queue is returned for both so they are synchronized together.
+	 *
+	 * @param type The queue type.
+	 * @return The guarded queue reference.
+	 */
+	[[nodiscard]] Guarded<VulkanQueue>& getQueue(QueueType type) { return m_Queues[m_QueueMapping[static_cast<uint8_t>(type)]]; }
+
+	/**
+	 * Get a queue by it's type.
+	 * If the queue type is shared with another type, the same guarded queue is returned for both so they are synchronized together.
+	 *
+	 * @param type The queue type.
+	 * @return The guarded queue reference.
+	 */
+	[[nodiscard]] const Guarded<VulkanQueue>& getQueue(QueueType type) const { return m_Queues[m_QueueMapping[static_cast<uint8_t>(type)]]; }
+
+	/**
+	 * Check if a queue type shares it's queue with another type.
+	 *
+	 * @param type The queue type.
+	 * @return True if the queue is shared.
+	 */
+	[[nodiscard]] bool isQueueShared(QueueType type) const;
+
+	/**
+	 * Get the command capture.
+	 *
+	 * @return The capture pointer. nullptr if the work is not captured.
+	 */
+	[[nodiscard]] CommandCapture* getCapture() const { return m_pCapture.get(); }
+
 public:
 	GRAPHITE_SETUP_GETTERS(std::ofstream, LogFile, m_LogFile);
 	GRAPHITE_SETUP_SIMPLE_GETTER(VkInstance, Instance, m_Instance);
 	GRAPHITE_SETUP_GETTERS(VolkDeviceTable, DeviceTable, m_DeviceTable);
 	GRAPHITE_SETUP_GETTERS(Guarded<VkPhysicalDevice>, PhysicalDevice, m_PhysicalDevice);
+	GRAPHITE_SETUP_GETTERS(VkPhysicalDeviceProperties, PhysicalDeviceProperties, m_PhysicalDeviceProperties);
+	GRAPHITE_SETUP_GETTERS(std::vector<VkQueueFamilyProperties>, QueueFamilyProperties, m_QueueFamilyProperties);
 	GRAPHITE_SETUP_GETTERS(Guarded<VkDevice>, LogicalDevice, m_LogicalDevice);
 	GRAPHITE_SETUP_GETTERS(Guarded<VmaAllocator>, Allocator, m_Allocator);
-	GRAPHITE_SETUP_GETTERS(Guarded<VulkanQueue>, GraphicsQueue, m_Queues[0]);
-	GRAPHITE_SETUP_GETTERS(Guarded<VulkanQueue>, ComputeQueue, m_Queues[1]);
-	GRAPHITE_SETUP_GETTERS(Guarded<VulkanQueue>, TransferQueue, m_Queues[2]);
+	GRAPHITE_SETUP_SIMPLE_GETTER(VkPipelineCache, PipelineCache, m_PipelineCache);
+	GRAPHITE_SETUP_GETTERS(VkPhysicalDeviceFeatures, EnabledFeatures, m_EnabledFeatures);
+	GRAPHITE_SETUP_GETTERS(DeletionQueue, DeletionQueue, m_DeletionQueue);
+	GRAPHITE_SETUP_GETTERS(ResourceStore, ResourceStore, m_ResourceStore);
+	GRAPHITE_SETUP_GETTERS(Guarded<VulkanQueue>, GraphicsQueue, getQueue(QueueType::Graphics));
+	GRAPHITE_SETUP_GETTERS(Guarded<VulkanQueue>, ComputeQueue, getQueue(QueueType::Compute));
+	GRAPHITE_SETUP_GETTERS(Guarded<VulkanQueue>, TransferQueue, getQueue(QueueType::Transfer));
 
 private:
 	/**
@@ -66,6 +160,11 @@ private:
 	 */
 	void selectPhysicalDevice();
 
+	/**
+	 * Select the queue families and the queue indices for each queue type.
+	 */
+	void selectQueues();
+
 	/**
 	 * Create the logical device.
 	 */
@@ -76,12 +175,31 @@ private:
 	 */
 	void createMemoryAllocator();
 
+	/**
+	 * Create the pipeline cache using the data loaded from the cache file.
+	 */
+	void createPipelineCache();
+
+	/**
+	 * Store the pipeline cache data to the cache file.
+	 */
+	void savePipelineCache();
+
+	/**
+	 * Remove a device extension from the enabled list.
+	 *
+	 * @param extension The extension to remove.
+	 */
+	void removeDeviceExtension(std::string_view extension);
+
 private:
 	VkPhysicalDeviceProperties m_PhysicalDeviceProperties;
 
 	std::ofstream m_LogFile;
 
 	std::array<Guarded<VulkanQueue>, 3> m_Queues;
+	std::array<uint8_t, 3> m_QueueMapping = { 0, 1, 2 };
+	std::vector<VkQueueFamilyProperties> m_QueueFamilyProperties;
 
 	VolkDeviceTable m_DeviceTable;
 
@@ -93,6 +211,20 @@ private:
 
 	Guarded<VmaAllocator> m_Allocator = nullptr;
 
+	std::filesystem::path m_PipelineCachePath;
+	std::filesystem::path m_CapturePath;
+	std::unique_ptr<CommandCapture> m_pCapture;
+
+	std::future<std::vector<std::byte>> m_PipelineCacheData;
+	std::future<void> m_DeviceCreation;
+	VkPipelineCache m_PipelineCache = VK_NULL_HANDLE;
+	VkPhysicalDeviceFeatures m_EnabledFeatures = {};
+
+	DeletionQueue m_DeletionQueue;
+	ResourceStore m_ResourceStore;
+
 	std::vector<const char*> m_ValidationLayers;
 	std::vector<const char*> m_DeviceExtensions;
+
+	QueueSharingPolicy m_QueueSharingPolicy = QueueSharingPolicy::PreferSeparateQueues;
 };
\ No newline at end of file
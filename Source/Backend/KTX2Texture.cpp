@@ -0,0 +1,402 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "KTX2Texture.hpp"
+
+#include "Core/Logging.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <fstream>
+
+namespace /* anonymous */
+{
+	constexpr std::array<uint8_t, 12> g_KTX2Identifier = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+	/**
+	 * KTX2 header structure.
+	 * This is the header and the index of the file, exactly as they are stored.
+	 */
+	struct KTX2Header final
+	{
+		std::array<uint8_t, 12> m_Identifier;
+		uint32_t m_VkFormat;
+		uint32_t m_TypeSize;
+		uint32_t m_PixelWidth;
+		uint32_t m_PixelHeight;
+		uint32_t m_PixelDepth;
+		uint32_t m_LayerCount;
+		uint32_t m_FaceCount;
+		uint32_t m_LevelCount;
+		uint32_t m_SupercompressionScheme;
+
+		uint32_t m_DFDByteOffset;
+		uint32_t m_DFDByteLength;
+		uint32_t m_KVDByteOffset;
+		uint32_t m_KVDByteLength;
+		uint64_t m_SGDByteOffset;
+		uint64_t m_SGDByteLength;
+	};
+
+	static_assert(sizeof(KTX2Header) == 80, "The KTX2 header must be tightly packed!");
+
+	/**
+	 * Get the name of a supercompression scheme.
+	 *
+	 * @param scheme The supercompression scheme.
+	 * @return The name.
+	 */
+	[[nodiscard]] std::string_view GetSupercompressionName(KTX2Supercompression scheme)
+	{
+		switch (scheme)
+		{
+		case KTX2Supercompression::None:
+			return "none";
+
+		case KTX2Supercompression::BasisLZ:
+			return "BasisLZ";
+
+		case KTX2Supercompression::Zstandard:
+			return "Zstandard";
+
+		case KTX2Supercompression::ZLIB:
+			return "ZLIB";
+
+		default:
+			return "unknown";
+		}
+	}
+
+	/**
+	 * Get the size of a format's texel block.
+	 * Only the block compressed formats the engine enables and the common uncompressed color formats are known.
+	 *
+	 * @param format The format.
+	 * @param blockWidth The width of a block.
+	 * @param blockHeight The height of a block.
+	 * @return The size of a block in bytes. 0 if the format is not known.
+	 */
+	[[nodiscard]] uint32_t GetFormatBlockSize(VkFormat format, uint32_t& blockWidth, uint32_t& blockHeight)
+	{
+		blockWidth = 1;
+		blockHeight = 1;
+		switch (format)
+		{
+		case VK_FORMAT_R8_UNORM:
+		case VK_FORMAT_R8_SNORM:
+		case VK_FORMAT_R8_SRGB:
+			return 1;
+
+		case VK_FORMAT_R8G8_UNORM:
+		case VK_FORMAT_R8G8_SNORM:
+		case VK_FORMAT_R8G8_SRGB:
+		case VK_FORMAT_R16_UNORM:
+		case VK_FORMAT_R16_SFLOAT:
+			return 2;
+
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SNORM:
+		case VK_FORMAT_R8G8B8A8_SRGB:
+		case VK_FORMAT_B8G8R8A8_UNORM:
+		case VK_FORMAT_B8G8R8A8_SRGB:
+		case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+		case VK_FORMAT_R16G16_UNORM:
+		case VK_FORMAT_R16G16_SFLOAT:
+		case VK_FORMAT_R32_SFLOAT:
+		case VK_FORMAT_B10G11R11_UFLOAT_PACK32:
+		case VK_FORMAT_E5B9G9R9_UFLOAT_PACK32:
+			return 4;
+
+		case VK_FORMAT_R16G16B16A16_UNORM:
+		case VK_FORMAT_R16G16B16A16_SFLOAT:
+		case VK_FORMAT_R32G32_SFLOAT:
+			return 8;
+
+		case VK_FORMAT_R32G32B32_SFLOAT:
+			return 12;
+
+		case VK_FORMAT_R32G32B32A32_SFLOAT:
+			return 16;
+
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+		case VK_FORMAT_BC4_SNORM_BLOCK:
+		case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+		case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+		case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK:
+		case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
+		case VK_FORMAT_EAC_R11_UNORM_BLOCK:
+		case VK_FORMAT_EAC_R11_SNORM_BLOCK:
+			blockWidth = 4;
+			blockHeight = 4;
+			return 8;
+
+		case VK_FORMAT_BC2_UNORM_BLOCK:
+		case VK_FORMAT_BC2_SRGB_BLOCK:
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+		case VK_FORMAT_BC5_SNORM_BLOCK:
+		case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+		case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+		case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+		case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+		case VK_FORMAT_EAC_R11G11_UNORM_BLOCK:
+		case VK_FORMAT_EAC_R11G11_SNORM_BLOCK:
+			blockWidth = 4;
+			blockHeight = 4;
+			return 16;
+
+		case VK_FORMAT_ASTC_4x4_UNORM_BLOCK:
+		case VK_FORMAT_ASTC_4x4_SRGB_BLOCK:
+			blockWidth = 4;
+			blockHeight = 4;
+			return 16;
+
+		case VK_FORMAT_ASTC_5x4_UNORM_BLOCK:
+		case VK_FORMAT_ASTC_5x4_SRGB_BLOCK:
+			blockWidth = 5;
+			blockHeight = 4;
+			return 16;
+
+		case VK_FORMAT_ASTC_5x5_UNORM_BLOCK:
+		case VK_FORMAT_ASTC_5x5_SRGB_BLOCK:
+			blockWidth = 5;
+			blockHeight = 5;
+			return 16;
+
+		case VK_FORMAT_ASTC_6x5_UNORM_BLOCK:
+		case VK_FORMAT_ASTC_6x5_SRGB_BLOCK:
+			blockWidth = 6;
+			blockHeight = 5;
+			return 16;
+
+		case VK_FORMAT_ASTC_6x6_UNORM_BLOCK:
+		case VK_FORMAT_ASTC_6x6_SRGB_BLOCK:
+			blockWidth = 6;
+			blockHeight = 6;
+			return 16;
+
+		case VK_FORMAT_ASTC_8x5_UNORM_BLOCK:
+		case VK_FORMAT_ASTC_8x5_SRGB_BLOCK:
+			blockWidth = 8;
+			blockHeight = 5;
+			return 16;
+
+		case VK_FORMAT_ASTC_8x6_UNORM_BLOCK:
+		case VK_FORMAT_ASTC_8x6_SRGB_BLOCK:
+			blockWidth = 8;
+			blockHeight = 6;
+			return 16;
+
+		case VK_FORMAT_ASTC_8x8_UNORM_BLOCK:
+		case VK_FORMAT_ASTC_8x8_SRGB_BLOCK:
+			blockWidth = 8;
+			blockHeight = 8;
+			return 16;
+
+		case VK_FORMAT_ASTC_10x5_UNORM_BLOCK:
+		case VK_FORMAT_ASTC_10x5_SRGB_BLOCK:
+			blockWidth = 10;
+			blockHeight = 5;
+			return 16;
+
+		case VK_FORMAT_ASTC_10x6_UNORM_BLOCK:
+		case VK_FORMAT_ASTC_10x6_SRGB_BLOCK:
+			blockWidth = 10;
+			blockHeight = 6;
+			return 16;
+
+		case VK_FORMAT_ASTC_10x8_UNORM_BLOCK:
+		case VK_FORMAT_ASTC_10x8_SRGB_BLOCK:
+			blockWidth = 10;
+			blockHeight = 8;
+			return 16;
+
+		case VK_FORMAT_ASTC_10x10_UNORM_BLOCK:
+		case VK_FORMAT_ASTC_10x10_SRGB_BLOCK:
+			blockWidth = 10;
+			blockHeight = 10;
+			return 16;
+
+		case VK_FORMAT_ASTC_12x10_UNORM_BLOCK:
+		case VK_FORMAT_ASTC_12x10_SRGB_BLOCK:
+			blockWidth = 12;
+			blockHeight = 10;
+			return 16;
+
+		case VK_FORMAT_ASTC_12x12_UNORM_BLOCK:
+		case VK_FORMAT_ASTC_12x12_SRGB_BLOCK:
+			blockWidth = 12;
+			blockHeight = 12;
+			return 16;
+
+		default:
+			return 0;
+		}
+	}
+}
+
+KTX2Texture::KTX2Texture(std::filesystem::path path)
+	: m_Path(std::move(path))
+{
+	auto file = std::ifstream(m_Path, std::ios::binary);
+	if (!file.is_open())
+	{
+		GRAPHITE_LOG_ERROR("Failed to open the KTX2 file {}!", m_Path.string());
+		return;
+	}
+
+	// Everything in the header is checked against the file size before it's used, so a corrupted file can't make us read past it.
+	file.seekg(0, std::ios::end);
+	const auto fileSize = static_cast<uint64_t>(file.tellg());
+	file.seekg(0);
+
+	// Read and validate the header.
+	KTX2Header header = {};
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(KTX2Header)) || header.m_Identifier != g_KTX2Identifier)
+	{
+		GRAPHITE_LOG_ERROR("The file {} is not a KTX2 file!", m_Path.string());
+		return;
+	}
+
+	// The faces can only be 1 or 6, and a texture can't have more mips than it takes to get to a single texel.
+	const auto largestDimension = std::max({ header.m_PixelWidth, header.m_PixelHeight, header.m_PixelDepth });
+	const auto maximumLevels = static_cast<uint32_t>(std::bit_width(largestDimension));
+	if (header.m_PixelWidth == 0 || (header.m_FaceCount != 1 && header.m_FaceCount != 6) || header.m_LevelCount > maximumLevels)
+	{
+		GRAPHITE_LOG_ERROR("The KTX2 file {} has invalid dimensions!", m_Path.string());
+		return;
+	}
+
+	m_Width = header.m_PixelWidth;
+	m_Height = std::max(header.m_PixelHeight, 1u);
+	m_Depth = std::max(header.m_PixelDepth, 1u);
+	m_Layers = std::max(header.m_LayerCount, 1u);
+	m_Faces = header.m_FaceCount;
+	m_Format = static_cast<VkFormat>(header.m_VkFormat);
+	m_Supercompression = static_cast<KTX2Supercompression>(header.m_SupercompressionScheme);
+
+	// A level count of 0 asks the loader to generate the mips, which we don't do.
+	const auto levelCount = std::max(header.m_LevelCount, 1u);
+	if (sizeof(KTX2Header) + sizeof(uint64_t) * 3 * levelCount > fileSize)
+	{
+		GRAPHITE_LOG_ERROR("The KTX2 file {} has a truncated level index!", m_Path.string());
+		return;
+	}
+
+	m_Levels.resize(levelCount);
+
+	// Read the level index. It's stored as three 64-bit values per level.
+	for (auto& level : m_Levels)
+	{
+		std::array<uint64_t, 3> entry = {};
+		if (!file.read(reinterpret_cast<char*>(entry.data()), sizeof(entry)))
+		{
+			GRAPHITE_LOG_ERROR("The KTX2 file {} has a truncated level index!", m_Path.string());
+			return;
+		}
+
+		level.m_Offset = entry[0];
+		level.m_Size = entry[1];
+		level.m_UncompressedSize = entry[2];
+
+		if (level.m_Size == 0 || level.m_Offset > fileSize || level.m_Size > fileSize - level.m_Offset)
+		{
+			GRAPHITE_LOG_ERROR("The KTX2 file {} has a level outside of the file!", m_Path.string());
+			return;
+		}
+	}
+
+	// BasisLZ and UASTC textures don't have a Vulkan format, they have to be transcoded first.
+	if (m_Format == VK_FORMAT_UNDEFINED || m_Supercompression == KTX2Supercompression::BasisLZ)
+	{
+		GRAPHITE_LOG_ERROR("The KTX2 file {} contains Basis Universal data, which needs to be transcoded and is not supported!", m_Path.string());
+		return;
+	}
+
+	if (m_Supercompression != KTX2Supercompression::None)
+	{
+		GRAPHITE_LOG_ERROR("The KTX2 file {} uses {} supercompression, which is not supported!", m_Path.string(), GetSupercompressionName(m_Supercompression));
+		return;
+	}
+
+	// The copies to the image read as many bytes as the level's extent needs, so the levels must not be smaller than that. A format whose block
+	// size is not known can't be checked, so it's rejected.
+	uint32_t blockWidth = 1;
+	uint32_t blockHeight = 1;
+	const auto blockSize = GetFormatBlockSize(m_Format, blockWidth, blockHeight);
+	if (blockSize == 0)
+	{
+		GRAPHITE_LOG_ERROR("The KTX2 file {} uses the format {}, which is not supported!", m_Path.string(), static_cast<uint32_t>(m_Format));
+		return;
+	}
+
+	for (uint32_t i = 0; i < levelCount; i++)
+	{
+		const uint64_t blocksX = (std::max(m_Width >> i, 1u) + blockWidth - 1) / blockWidth;
+		const uint64_t blocksY = (std::max(m_Height >> i, 1u) + blockHeight - 1) / blockHeight;
+		const uint64_t depth = std::max(m_Depth >> i, 1u);
+
+		if (m_Levels[i].m_Size < blocksX * blocksY * depth * blockSize * m_Layers * m_Faces)
+		{
+			GRAPHITE_LOG_ERROR("The KTX2 file {} has a level {} which is smaller than it's dimensions need!", m_Path.string(), i);
+			return;
+		}
+	}
+
+	m_bIsValid = true;
+}
+
+bool KTX2Texture::isFormatSupported(Instance& instance) const
+{
+	const auto builder = ImageBuilder()
+		.setWidth(m_Width)
+		.setHeight(m_Height)
+		.setDepth(m_Depth)
+		.setType(m_Depth > 1 ? VK_IMAGE_TYPE_3D : VK_IMAGE_TYPE_2D)
+		.setUsage(VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT)
+		.setIsCubeMap(m_Faces == 6);
+
+	return Image::ResolveFormat(instance, builder, { m_Format }) != VK_FORMAT_UNDEFINED;
+}
+
+bool KTX2Texture::loadLevel(uint32_t level, std::span<std::byte> destination) const
+{
+	if (!m_bIsValid || level >= m_Levels.size() || destination.size() != m_Levels[level].m_Size)
+		return false;
+
+	auto file = std::ifstream(m_Path, std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	file.seekg(static_cast<std::streamoff>(m_Levels[level].m_Offset));
+	return static_cast<bool>(file.read(reinterpret_cast<char*>(destination.data()), static_cast<std::streamsize>(destination.size())));
+}
+
+TextureSource KTX2Texture::createSource() const
+{
+	TextureSource source;
+	source.m_Width = m_Width;
+	source.m_Height = m_Height;
+	source.m_Format = m_Format;
+
+	if (!m_bIsValid || m_Depth > 1 || m_Layers > 1 || m_Faces > 1)
+	{
+		GRAPHITE_LOG_ERROR("Only 2D KTX2 textures with a single layer and face can be streamed!");
+		return source;
+	}
+
+	source.m_MipSizes.reserve(m_Levels.size());
+	for (const auto& level : m_Levels)
+		source.m_MipSizes.emplace_back(level.m_Size);
+
+	source.m_LoadMip = [texture = *this](uint32_t mip, std::span<std::byte> destination) { return texture.loadLevel(mip, destination); };
+	return source;
+}
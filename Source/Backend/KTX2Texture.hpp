@@ -0,0 +1,106 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "TextureStreamer.hpp"
+
+#include <filesystem>
+
+/**
+ * KTX2 supercompression scheme enum.
+ */
+enum class KTX2Supercompression : uint32_t
+{
+	None = 0,
+	BasisLZ = 1,
+	Zstandard = 2,
+	ZLIB = 3
+};
+
+/**
+ * KTX2 level structure.
+ * This contains where a single mip level is stored in the file.
+ */
+struct KTX2Level final
+{
+	uint64_t m_Offset = 0;
+	uint64_t m_Size = 0;
+	uint64_t m_UncompressedSize = 0;
+};
+
+/**
+ * KTX2 texture class.
+ * This reads the header and the level index of a KTX2 container. The level data itself is read on demand, so the texture streamer can load only
+ * the mips it needs. KTX2 stores the Vulkan format directly, so block compressed (BCn, ASTC, ETC2) textures can be uploaded as they are.
+ *
+ * Supercompressed containers (BasisLZ, UASTC, Zstandard and ZLIB) need a decoder or a transcoder which is not available, so they are rejected.
+ */
+class KTX2Texture final
+{
+public:
+	/**
+	 * Explicit constructor.
+	 *
+	 * @param path The KTX2 file path.
+	 */
+	explicit KTX2Texture(std::filesystem::path path);
+
+	/**
+	 * Check if the texture was loaded and can be used.
+	 *
+	 * @return True if the texture is valid.
+	 */
+	[[nodiscard]] bool isValid() const { return m_bIsValid; }
+
+	/**
+	 * Check if the device can sample the texture's format.
+	 * This uses the image format candidate mechanism, so the check matches what the image creation does.
+	 *
+	 * @param instance The instance reference.
+	 * @return True if the format is supported.
+	 */
+	[[nodiscard]] bool isFormatSupported(Instance& instance) const;
+
+	/**
+	 * Load a mip level.
+	 * This opens the file on each call, so levels can be loaded from multiple threads at once.
+	 *
+	 * @param level The mip level.
+	 * @param destination The destination memory. This must be exactly the size of the level.
+	 * @return True if the level was loaded.
+	 */
+	bool loadLevel(uint32_t level, std::span<std::byte> destination) const;
+
+	/**
+	 * Create a texture source for the texture streamer.
+	 * Only 2D textures with a single layer and face can be streamed.
+	 *
+	 * @return The texture source. This has no mips if the texture can't be streamed.
+	 */
+	[[nodiscard]] TextureSource createSource() const;
+
+public:
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, Width, m_Width);
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, Height, m_Height);
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, Depth, m_Depth);
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, Layers, m_Layers);
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, Faces, m_Faces);
+	GRAPHITE_SETUP_SIMPLE_GETTER(VkFormat, Format, m_Format);
+	GRAPHITE_SETUP_SIMPLE_GETTER(KTX2Supercompression, Supercompression, m_Supercompression);
+	GRAPHITE_SETUP_GETTERS(std::vector<KTX2Level>, Levels, m_Levels);
+
+private:
+	std::filesystem::path m_Path;
+	std::vector<KTX2Level> m_Levels;
+
+	uint32_t m_Width = 0;
+	uint32_t m_Height = 0;
+	uint32_t m_Depth = 0;
+	uint32_t m_Layers = 0;
+	uint32_t m_Faces = 0;
+
+	VkFormat m_Format = VK_FORMAT_UNDEFINED;
+	KTX2Supercompression m_Supercompression = KTX2Supercompression::None;
+
+	bool m_bIsValid = false;
+};
@@ -0,0 +1,531 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "ParticleSystem.hpp"
+#include "Instance.hpp"
+#include "VulkanMacros.hpp"
+
+#include <optick.h>
+
+#include <algorithm>
+#include <bit>
+
+namespace /* anonymous */
+{
+	// The thread group size of the passes which run a thread per particle.
+	constexpr uint32_t g_ParticleGroupSize = 64;
+
+	// The number of sort entries a group sorts in it's shared memory. The sort list is always a multiple of this.
+	constexpr uint32_t g_SortBlockSize = 1024;
+
+	// The largest maximum particle count, so the sort capacity can be rounded up to a power of two without overflowing.
+	constexpr uint32_t g_MaximumParticleLimit = 1u << 31;
+
+	// The size of a particle and a render particle. These must match Shaders/Particles.hlsl.
+	constexpr uint64_t g_ParticleSize = 48;
+	constexpr uint64_t g_RenderParticleSize = 32;
+
+	// The layout of the state buffer. The counters come first and the indirect dispatch arguments after them.
+	constexpr VkDeviceSize g_SimulateArgumentsOffset = 16;
+	constexpr VkDeviceSize g_SortArgumentsOffset = 32;
+	constexpr VkDeviceSize g_MergeArgumentsOffset = 48;
+	constexpr VkDeviceSize g_WriteArgumentsOffset = 64;
+	constexpr VkDeviceSize g_StateSize = 80;
+
+	// The buffers of the simulation passes are bound in this order.
+	enum ParticleBinding : uint32_t
+	{
+		Particles,
+		DeadList,
+		AliveLists,
+		SortList,
+		State,
+		RenderParticles,
+		DrawArguments,
+
+		Count
+	};
+
+	/**
+	 * Get the bindings of the simulation descriptor set.
+	 *
+	 * @return The bindings.
+	 */
+	[[nodiscard]] ComputePipeline::SetBindings GetParticleBindings()
+	{
+		ComputePipeline::SetBindings bindings;
+		for (uint32_t i = 0; i < ParticleBinding::Count; i++)
+			bindings.emplace_back(VkDescriptorSetLayoutBinding{ i, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr });
+
+		return bindings;
+	}
+
+	/**
+	 * Get the binding of the render descriptor set.
+	 *
+	 * @return The binding.
+	 */
+	[[nodiscard]] VkDescriptorSetLayoutBinding GetRenderBinding()
+	{
+		return VkDescriptorSetLayoutBinding{ 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT, nullptr };
+	}
+
+	/**
+	 * Get the queue families which access the render buffers.
+	 *
+	 * @param instance The instance reference.
+	 * @return The queue families.
+	 */
+	[[nodiscard]] std::array<uint32_t, 2> GetRenderQueueFamilies(Instance& instance)
+	{
+		return { instance.getComputeQueue().getUnsafe().m_Family, instance.getGraphicsQueue().getUnsafe().m_Family };
+	}
+
+	/**
+	 * Clamp the maximum number of particles to what a single dispatch of the particle passes can cover on the device, and to what the sort
+	 * capacity can be rounded up from.
+	 *
+	 * @param instance The instance reference.
+	 * @param maximumParticles The requested maximum number of particles.
+	 * @return The maximum number of particles.
+	 */
+	[[nodiscard]] uint32_t ClampMaximumParticles(const Instance& instance, uint32_t maximumParticles)
+	{
+		const auto groupCount = static_cast<uint64_t>(instance.getPhysicalDeviceProperties().limits.maxComputeWorkGroupCount[0]);
+		const auto limit = static_cast<uint32_t>(std::min<uint64_t>(groupCount * g_ParticleGroupSize, g_MaximumParticleLimit));
+		if (maximumParticles <= limit)
+			return maximumParticles;
+
+		GRAPHITE_LOG_WARNING("The maximum particle count is clamped from {} to {}, since the particle passes cannot dispatch or sort more on this device.", maximumParticles, limit);
+		return limit;
+	}
+
+	/**
+	 * Turn a 3 component vector into 4 components.
+	 *
+	 * @param vector The vector.
+	 * @param w The fourth component.
+	 * @return The vector.
+	 */
+	[[nodiscard]] std::array<float, 4> ToVector4(const std::array<float, 3>& vector, float w)
+	{
+		return { vector[0], vector[1], vector[2], w };
+	}
+}
+
+ParticleSystem::RenderSlot::RenderSlot(Instance& instance, uint32_t maximumParticles, std::span<const uint32_t> queueFamilies)
+	: m_RenderParticles(instance, g_RenderParticleSize * maximumParticles, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, queueFamilies)
+	, m_DrawArguments(instance, sizeof(VkDrawIndirectCommand), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, queueFamilies)
+{
+}
+
+ParticleSystem::ParticleSystem(Instance& instance, CommandSubmissionQueue& submissionQueue, uint32_t maximumParticles, const std::filesystem::path& shaderDirectory /*= "Shaders"*/)
+	: ParticleSystem(instance, submissionQueue, shaderDirectory, ClampMaximumParticles(instance, maximumParticles))
+{
+}
+
+ParticleSystem::ParticleSystem(Instance& instance, CommandSubmissionQueue& submissionQueue, const std::filesystem::path& shaderDirectory, uint32_t maximumParticles)
+	: InstanceBoundObject(instance)
+	, m_SubmissionQueue(submissionQueue)
+	, m_Particles(instance, g_ParticleSize * std::max(maximumParticles, 1u), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+	, m_DeadList(instance, sizeof(uint32_t) * std::max(maximumParticles, 1u), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+	, m_AliveLists(instance, sizeof(uint32_t) * 2 * std::max(maximumParticles, 1u), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+	, m_SortList(instance, sizeof(uint32_t) * 2 * std::max(std::bit_ceil(maximumParticles), g_SortBlockSize), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+	, m_State(instance, g_StateSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT)
+	, m_RenderSlots{ {
+		RenderSlot(instance, std::max(maximumParticles, 1u), GetRenderQueueFamilies(instance)),
+		RenderSlot(instance, std::max(maximumParticles, 1u), GetRenderQueueFamilies(instance))
+	} }
+	, m_InitializePipeline(instance, shaderDirectory / "ParticleInitialize.spv", { GetParticleBindings() }, sizeof(FrameConstants), 2)
+	, m_EmitPipeline(instance, shaderDirectory / "ParticleEmit.spv", { GetParticleBindings() }, sizeof(EmitConstants), 1)
+	, m_PreparePipeline(instance, shaderDirectory / "ParticlePrepare.spv", { GetParticleBindings() }, sizeof(FrameConstants), 1)
+	, m_SimulatePipeline(instance, shaderDirectory / "ParticleSimulate.spv", { GetParticleBindings() }, sizeof(FrameConstants), 1)
+	, m_FinishPipeline(instance, shaderDirectory / "ParticleFinish.spv", { GetParticleBindings() }, sizeof(FrameConstants), 1)
+	, m_SortLocalPipeline(instance, shaderDirectory / "ParticleSortLocal.spv", { GetParticleBindings() }, sizeof(FrameConstants), 1)
+	, m_MergeGlobalPipeline(instance, shaderDirectory / "ParticleMergeGlobal.spv", { GetParticleBindings() }, sizeof(SortConstants), 1)
+	, m_MergeLocalPipeline(instance, shaderDirectory / "ParticleMergeLocal.spv", { GetParticleBindings() }, sizeof(SortConstants), 1)
+	, m_WritePipeline(instance, shaderDirectory / "ParticleWrite.spv", { GetParticleBindings() }, sizeof(FrameConstants), 1)
+	, m_MaximumParticles(maximumParticles)
+	, m_SortCapacity(std::max(std::bit_ceil(maximumParticles), g_SortBlockSize))
+{
+	m_bIsValid = maximumParticles > 0
+		&& m_InitializePipeline.isValid() && m_EmitPipeline.isValid() && m_PreparePipeline.isValid()
+		&& m_SimulatePipeline.isValid() && m_FinishPipeline.isValid() && m_SortLocalPipeline.isValid()
+		&& m_MergeGlobalPipeline.isValid() && m_MergeLocalPipeline.isValid() && m_WritePipeline.isValid();
+
+	if (!m_bIsValid)
+		GRAPHITE_LOG_ERROR("Failed to create the particle system pipelines. The particles will not be simulated!");
+
+	// Every pass uses the same layout for the first set, so the sets can be allocated from the initialize pipeline.
+	for (auto& slot : m_RenderSlots)
+		writeComputeDescriptorSet(slot);
+
+	createRenderDescriptorSets();
+
+	// Create the command pool for the compute queue.
+	VkCommandPoolCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	createInfo.pNext = nullptr;
+	createInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	createInfo.queueFamilyIndex = m_Instance.getComputeQueue().getUnsafe().m_Family;
+
+	m_Instance.getLogicalDevice().access([this, &createInfo](VkDevice logicalDevice)
+		{
+			GRAPHITE_VK_ASSERT(m_Instance.getDeviceTable().vkCreateCommandPool(logicalDevice, &createInfo, nullptr, &m_CommandPool), "Failed to create the particle system command pool!");
+		}
+	);
+}
+
+ParticleSystem::~ParticleSystem()
+{
+	// Make sure the updates in flight are done before destroying the command pool.
+	if (m_LastValue > 0)
+	{
+		m_SubmissionQueue.flush();
+		m_SubmissionQueue.wait(QueueType::Compute, m_LastValue);
+	}
+
+	m_Instance.getLogicalDevice().access([this](VkDevice logicalDevice)
+		{
+			m_Instance.getDeviceTable().vkDestroyCommandPool(logicalDevice, m_CommandPool, nullptr);
+		}
+	);
+
+	m_Instance.getDeletionQueue().retire([&deviceTable = m_Instance.getDeviceTable(), descriptorPool = m_RenderDescriptorPool, setLayout = m_RenderSetLayout](VkDevice logicalDevice)
+		{
+			deviceTable.vkDestroyDescriptorPool(logicalDevice, descriptorPool, nullptr);
+			deviceTable.vkDestroyDescriptorSetLayout(logicalDevice, setLayout, nullptr);
+		}
+	);
+}
+
+ParticleEmitter* ParticleSystem::getEmitter(ParticleEmitterHandle handle)
+{
+	const auto pState = m_Emitters.get(handle);
+	return pState != nullptr ? &pState->m_Emitter : nullptr;
+}
+
+void ParticleSystem::emit(ParticleEmitterHandle handle, uint32_t count)
+{
+	if (const auto pState = m_Emitters.get(handle))
+		pState->m_BurstCount = std::min(pState->m_BurstCount + count, m_MaximumParticles);
+}
+
+uint64_t ParticleSystem::update(float deltaTime, const ParticleCamera& camera)
+{
+	OPTICK_EVENT();
+
+	if (!m_bIsValid)
+		return 0;
+
+	// Reuse the command buffers of the completed updates.
+	const auto completedValue = m_SubmissionQueue.getCompletedValue(QueueType::Compute);
+	while (!m_PendingCommandBuffers.empty() && m_PendingCommandBuffers.front().second <= completedValue)
+	{
+		m_FreeCommandBuffers.emplace_back(m_PendingCommandBuffers.front().first);
+		m_PendingCommandBuffers.pop_front();
+	}
+
+	// Write to the slot which is not drawn right now.
+	const auto slotIndex = m_LastValue > 0 ? 1 - m_DrawSlot : m_DrawSlot;
+	const auto& slot = m_RenderSlots[slotIndex];
+
+	const auto& deviceTable = m_Instance.getDeviceTable();
+	const auto commandBuffer = getCommandBuffer();
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.pNext = nullptr;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	beginInfo.pInheritanceInfo = nullptr;
+	GRAPHITE_VK_ASSERT(deviceTable.vkBeginCommandBuffer(commandBuffer, &beginInfo), "Failed to begin the particle update command buffer!");
+
+	FrameConstants constants;
+	constants.m_CameraPosition = ToVector4(camera.m_Position, 1.0f);
+	constants.m_CameraForward = ToVector4(camera.m_Forward, 0.0f);
+	constants.m_Gravity = m_Gravity;
+	constants.m_Drag = m_Drag;
+	constants.m_DeltaTime = deltaTime;
+	constants.m_AliveIndex = m_AliveIndex;
+	constants.m_MaximumParticles = m_MaximumParticles;
+
+	// The last update must be done with the buffers before we touch them again.
+	recordPassBarrier(commandBuffer);
+
+	if (!m_bIsInitialized)
+	{
+		m_InitializePipeline.bind(commandBuffer, { slot.m_ComputeDescriptorSet });
+		m_InitializePipeline.pushConstants(commandBuffer, constants);
+		deviceTable.vkCmdDispatch(commandBuffer, (m_MaximumParticles + g_ParticleGroupSize - 1) / g_ParticleGroupSize, 1, 1);
+		recordPassBarrier(commandBuffer);
+
+		m_bIsInitialized = true;
+	}
+
+	recordEmit(commandBuffer, slot, deltaTime);
+
+	m_PreparePipeline.bind(commandBuffer, { slot.m_ComputeDescriptorSet });
+	m_PreparePipeline.pushConstants(commandBuffer, constants);
+	deviceTable.vkCmdDispatch(commandBuffer, 1, 1, 1);
+	recordPassBarrier(commandBuffer);
+
+	m_SimulatePipeline.bind(commandBuffer, { slot.m_ComputeDescriptorSet });
+	m_SimulatePipeline.pushConstants(commandBuffer, constants);
+	deviceTable.vkCmdDispatchIndirect(commandBuffer, m_State.getBuffer(), g_SimulateArgumentsOffset);
+	recordPassBarrier(commandBuffer);
+
+	m_FinishPipeline.bind(commandBuffer, { slot.m_ComputeDescriptorSet });
+	m_FinishPipeline.pushConstants(commandBuffer, constants);
+	deviceTable.vkCmdDispatch(commandBuffer, 1, 1, 1);
+	recordPassBarrier(commandBuffer);
+
+	if (m_bSorting)
+		recordSort(commandBuffer, slot, constants);
+
+	m_WritePipeline.bind(commandBuffer, { slot.m_ComputeDescriptorSet });
+	m_WritePipeline.pushConstants(commandBuffer, constants);
+	deviceTable.vkCmdDispatchIndirect(commandBuffer, m_State.getBuffer(), g_WriteArgumentsOffset);
+
+	GRAPHITE_VK_ASSERT(deviceTable.vkEndCommandBuffer(commandBuffer), "Failed to end the particle update command buffer!");
+
+	// The render buffer of the slot can only be written once the graphics queue is done drawing it.
+	const auto wait = SubmissionWait{ QueueType::Graphics, slot.m_DrawValue, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR };
+	const auto waits = slot.m_DrawValue > 0 ? std::span<const SubmissionWait>(&wait, 1) : std::span<const SubmissionWait>();
+
+	m_LastValue = m_SubmissionQueue.enqueue(QueueType::Compute, std::span<const VkCommandBuffer>(&commandBuffer, 1), waits);
+	m_PendingCommandBuffers.emplace_back(commandBuffer, m_LastValue);
+
+	// The survivors are in the other alive list now.
+	m_AliveIndex = 1 - m_AliveIndex;
+	m_DrawSlot = slotIndex;
+
+	m_RenderConstants.m_ViewProjection = camera.m_ViewProjection;
+	m_RenderConstants.m_CameraRight = ToVector4(camera.m_Right, 0.0f);
+	m_RenderConstants.m_CameraUp = ToVector4(camera.m_Up, 0.0f);
+
+	return m_LastValue;
+}
+
+SubmissionWait ParticleSystem::getDrawWait() const
+{
+	return SubmissionWait{ QueueType::Compute, m_LastValue, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT_KHR | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT_KHR };
+}
+
+void ParticleSystem::draw(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout) const
+{
+	OPTICK_EVENT();
+
+	if (m_LastValue == 0)
+		return;
+
+	const auto& deviceTable = m_Instance.getDeviceTable();
+	const auto& slot = m_RenderSlots[m_DrawSlot];
+
+	deviceTable.vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &slot.m_RenderDescriptorSet, 0, nullptr);
+	deviceTable.vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(RenderConstants), &m_RenderConstants);
+	deviceTable.vkCmdDrawIndirect(commandBuffer, slot.m_DrawArguments.getBuffer(), 0, 1, sizeof(VkDrawIndirectCommand));
+}
+
+PipelineDescription ParticleSystem::GetRenderPipelineDescription(VkFormat colorFormat, VkFormat depthFormat, const std::filesystem::path& shaderDirectory /*= "Shaders"*/)
+{
+	PipelineDescription description;
+	description.m_Type = PipelineType::Graphics;
+	description.m_VertexShader = (shaderDirectory / "ParticleVertex.spv").string();
+	description.m_FragmentShader = (shaderDirectory / "ParticleFragment.spv").string();
+	description.m_SetBindings = { { GetRenderBinding() } };
+	description.m_PushConstantSize = sizeof(RenderConstants);
+	description.m_ColorFormats = { colorFormat };
+	description.m_DepthFormat = depthFormat;
+	description.m_CullMode = VK_CULL_MODE_NONE;
+	description.m_bDepthTest = depthFormat != VK_FORMAT_UNDEFINED;
+	description.m_bDepthWrite = false;
+	description.m_bBlend = true;
+
+	return description;
+}
+
+void ParticleSystem::createRenderDescriptorSets()
+{
+	const auto binding = GetRenderBinding();
+
+	VkDescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+	layoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutCreateInfo.pNext = nullptr;
+	layoutCreateInfo.flags = 0;
+	layoutCreateInfo.bindingCount = 1;
+	layoutCreateInfo.pBindings = &binding;
+
+	const VkDescriptorPoolSize poolSize = { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, static_cast<uint32_t>(m_RenderSlots.size()) };
+
+	VkDescriptorPoolCreateInfo poolCreateInfo = {};
+	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolCreateInfo.pNext = nullptr;
+	poolCreateInfo.flags = 0;
+	poolCreateInfo.maxSets = static_cast<uint32_t>(m_RenderSlots.size());
+	poolCreateInfo.poolSizeCount = 1;
+	poolCreateInfo.pPoolSizes = &poolSize;
+
+	m_Instance.getLogicalDevice().access([this, &layoutCreateInfo, &poolCreateInfo](VkDevice logicalDevice)
+		{
+			const auto& deviceTable = m_Instance.getDeviceTable();
+			GRAPHITE_VK_ASSERT(deviceTable.vkCreateDescriptorSetLayout(logicalDevice, &layoutCreateInfo, nullptr, &m_RenderSetLayout), "Failed to create the particle render set layout!");
+			GRAPHITE_VK_ASSERT(deviceTable.vkCreateDescriptorPool(logicalDevice, &poolCreateInfo, nullptr, &m_RenderDescriptorPool), "Failed to create the particle render descriptor pool!");
+
+			for (auto& slot : m_RenderSlots)
+			{
+				VkDescriptorSetAllocateInfo allocateInfo = {};
+				allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+				allocateInfo.pNext = nullptr;
+				allocateInfo.descriptorPool = m_RenderDescriptorPool;
+				allocateInfo.descriptorSetCount = 1;
+				allocateInfo.pSetLayouts = &m_RenderSetLayout;
+				GRAPHITE_VK_ASSERT(deviceTable.vkAllocateDescriptorSets(logicalDevice, &allocateInfo, &slot.m_RenderDescriptorSet), "Failed to allocate the particle render set!");
+
+				const VkDescriptorBufferInfo bufferInfo = { slot.m_RenderParticles.getBuffer(), 0, VK_WHOLE_SIZE };
+
+				VkWriteDescriptorSet write = {};
+				write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				write.pNext = nullptr;
+				write.dstSet = slot.m_RenderDescriptorSet;
+				write.dstBinding = 0;
+				write.dstArrayElement = 0;
+				write.descriptorCount = 1;
+				write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+				write.pImageInfo = nullptr;
+				write.pBufferInfo = &bufferInfo;
+				write.pTexelBufferView = nullptr;
+
+				deviceTable.vkUpdateDescriptorSets(logicalDevice, 1, &write, 0, nullptr);
+			}
+		}
+	);
+}
+
+void ParticleSystem::writeComputeDescriptorSet(RenderSlot& slot)
+{
+	if (!m_InitializePipeline.isValid())
+		return;
+
+	slot.m_ComputeDescriptorSet = m_InitializePipeline.allocateDescriptorSet(0);
+	m_InitializePipeline.writeBuffer(slot.m_ComputeDescriptorSet, ParticleBinding::Particles, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_Particles.getBuffer());
+	m_InitializePipeline.writeBuffer(slot.m_ComputeDescriptorSet, ParticleBinding::DeadList, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_DeadList.getBuffer());
+	m_InitializePipeline.writeBuffer(slot.m_ComputeDescriptorSet, ParticleBinding::AliveLists, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_AliveLists.getBuffer());
+	m_InitializePipeline.writeBuffer(slot.m_ComputeDescriptorSet, ParticleBinding::SortList, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_SortList.getBuffer());
+	m_InitializePipeline.writeBuffer(slot.m_ComputeDescriptorSet, ParticleBinding::State, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_State.getBuffer());
+	m_InitializePipeline.writeBuffer(slot.m_ComputeDescriptorSet, ParticleBinding::RenderParticles, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, slot.m_RenderParticles.getBuffer());
+	m_InitializePipeline.writeBuffer(slot.m_ComputeDescriptorSet, ParticleBinding::DrawArguments, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, slot.m_DrawArguments.getBuffer());
+}
+
+void ParticleSystem::recordEmit(VkCommandBuffer commandBuffer, const RenderSlot& slot, float deltaTime)
+{
+	OPTICK_EVENT();
+
+	const auto& deviceTable = m_Instance.getDeviceTable();
+	bool bIsBound = false;
+
+	for (auto& state : m_Emitters)
+	{
+		const auto& emitter = state.m_Emitter;
+
+		// Carry the fraction over to the next update, so low rates still emit.
+		state.m_Accumulator += std::max(emitter.m_Rate, 0.0f) * deltaTime;
+		const auto rateCount = static_cast<uint32_t>(std::min(state.m_Accumulator, static_cast<float>(m_MaximumParticles)));
+		state.m_Accumulator = std::min(state.m_Accumulator - static_cast<float>(rateCount), 1.0f);
+
+		const auto emitCount = std::min(rateCount + state.m_BurstCount, m_MaximumParticles);
+		state.m_BurstCount = 0;
+
+		if (emitCount == 0)
+			continue;
+
+		EmitConstants constants;
+		constants.m_PositionRadius = ToVector4(emitter.m_Position, emitter.m_Radius);
+		constants.m_VelocitySpread = ToVector4(emitter.m_Velocity, emitter.m_VelocitySpread);
+		constants.m_StartColor = emitter.m_StartColor;
+		constants.m_EndColor = emitter.m_EndColor;
+		constants.m_Lifetime = { emitter.m_MinimumLifetime, std::max(emitter.m_MaximumLifetime, emitter.m_MinimumLifetime) };
+		constants.m_Size = { emitter.m_StartSize, emitter.m_EndSize };
+		constants.m_EmitCount = emitCount;
+		constants.m_Seed = m_Seed++;
+		constants.m_AliveIndex = m_AliveIndex;
+		constants.m_MaximumParticles = m_MaximumParticles;
+
+		if (!bIsBound)
+		{
+			m_EmitPipeline.bind(commandBuffer, { slot.m_ComputeDescriptorSet });
+			bIsBound = true;
+		}
+
+		// The emitters share the counters, so each one has to see the last one's atomics.
+		m_EmitPipeline.pushConstants(commandBuffer, constants);
+		deviceTable.vkCmdDispatch(commandBuffer, (emitCount + g_ParticleGroupSize - 1) / g_ParticleGroupSize, 1, 1);
+		recordPassBarrier(commandBuffer);
+	}
+}
+
+void ParticleSystem::recordSort(VkCommandBuffer commandBuffer, const RenderSlot& slot, const FrameConstants& constants) const
+{
+	OPTICK_EVENT();
+
+	const auto& deviceTable = m_Instance.getDeviceTable();
+	const auto stateBuffer = m_State.getBuffer();
+
+	// Sort every block in the shared memory. The rest of the sort merges the blocks, one bitonic stage per block size.
+	m_SortLocalPipeline.bind(commandBuffer, { slot.m_ComputeDescriptorSet });
+	m_SortLocalPipeline.pushConstants(commandBuffer, constants);
+	deviceTable.vkCmdDispatchIndirect(commandBuffer, stateBuffer, g_SortArgumentsOffset);
+	recordPassBarrier(commandBuffer);
+
+	// The stages are recorded for the largest sort count, since the CPU does not know the alive count. The stages of the block sizes which are larger
+	// than this update's sort count find the list already sorted, and the global merges skip them entirely.
+	for (uint32_t blockSize = g_SortBlockSize * 2; blockSize <= m_SortCapacity; blockSize *= 2)
+	{
+		m_MergeGlobalPipeline.bind(commandBuffer, { slot.m_ComputeDescriptorSet });
+		for (uint32_t distance = blockSize / 2; distance >= g_SortBlockSize; distance /= 2)
+		{
+			m_MergeGlobalPipeline.pushConstants(commandBuffer, SortConstants{ blockSize, distance });
+			deviceTable.vkCmdDispatchIndirect(commandBuffer, stateBuffer, g_MergeArgumentsOffset);
+			recordPassBarrier(commandBuffer);
+		}
+
+		m_MergeLocalPipeline.bind(commandBuffer, { slot.m_ComputeDescriptorSet });
+		m_MergeLocalPipeline.pushConstants(commandBuffer, SortConstants{ blockSize, 0 });
+		deviceTable.vkCmdDispatchIndirect(commandBuffer, stateBuffer, g_SortArgumentsOffset);
+		recordPassBarrier(commandBuffer);
+	}
+}
+
+void ParticleSystem::recordPassBarrier(VkCommandBuffer commandBuffer) const
+{
+	ComputePipeline::RecordMemoryBarrier(m_Instance.getDeviceTable(), commandBuffer,
+		VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR,
+		VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT_KHR | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR,
+		VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT_KHR | VK_ACCESS_2_SHADER_STORAGE_READ_BIT_KHR | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR);
+}
+
+VkCommandBuffer ParticleSystem::getCommandBuffer()
+{
+	if (!m_FreeCommandBuffers.empty())
+	{
+		const auto commandBuffer = m_FreeCommandBuffers.back();
+		m_FreeCommandBuffers.pop_back();
+
+		GRAPHITE_VK_ASSERT(m_Instance.getDeviceTable().vkResetCommandBuffer(commandBuffer, 0), "Failed to reset the particle update command buffer!");
+		return commandBuffer;
+	}
+
+	VkCommandBufferAllocateInfo allocateInfo = {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocateInfo.pNext = nullptr;
+	allocateInfo.commandPool = m_CommandPool;
+	allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocateInfo.commandBufferCount = 1;
+
+	VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+	m_Instance.getLogicalDevice().access([this, &allocateInfo, &commandBuffer](VkDevice logicalDevice)
+		{
+			GRAPHITE_VK_ASSERT(m_Instance.getDeviceTable().vkAllocateCommandBuffers(logicalDevice, &allocateInfo, &commandBuffer), "Failed to allocate the particle update command buffer!");
+		}
+	);
+
+	return commandBuffer;
+}
@@ -0,0 +1,391 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "Buffer.hpp"
+#include "CommandSubmissionQueue.hpp"
+#include "ComputePipeline.hpp"
+#include "PipelineManager.hpp"
+
+#include "Core/ResourcePool.hpp"
+
+#include <deque>
+
+/**
+ * Particle emitter structure.
+ * This describes how an emitter spawns particles. Every value with a range is picked randomly per particle.
+ */
+struct ParticleEmitter final
+{
+	std::array<float, 3> m_Position = {};
+	float m_Radius = 0.0f;	// The particles spawn in a sphere of this radius.
+
+	std::array<float, 3> m_Velocity = {};
+	float m_VelocitySpread = 0.0f;	// A random vector in a sphere of this radius is added to the velocity.
+
+	std::array<float, 4> m_StartColor = { 1.0f, 1.0f, 1.0f, 1.0f };
+	std::array<float, 4> m_EndColor = { 1.0f, 1.0f, 1.0f, 0.0f };
+
+	float m_MinimumLifetime = 1.0f;
+	float m_MaximumLifetime = 1.0f;
+
+	float m_StartSize = 0.1f;
+	float m_EndSize = 0.1f;
+
+	float m_Rate = 0.0f;	// The particles spawned per second.
+};
+
+/**
+ * Particle emitter state structure.
+ */
+struct ParticleEmitterState final
+{
+	ParticleEmitter m_Emitter;
+
+	float m_Accumulator = 0.0f;	// The fraction of a particle left over from the last update.
+	uint32_t m_BurstCount = 0;
+};
+
+using ParticleEmitterHandle = ResourceHandle<ParticleEmitterState>;
+
+/**
+ * Particle camera structure.
+ * The simulation sorts the particles with the camera, and the draw uses it to face the particles towards it.
+ */
+struct ParticleCamera final
+{
+	std::array<float, 16> m_ViewProjection = {};	// Column major.
+	std::array<float, 3> m_Position = {};
+	std::array<float, 3> m_Forward = { 0.0f, 0.0f, -1.0f };
+	std::array<float, 3> m_Right = { 1.0f, 0.0f, 0.0f };
+	std::array<float, 3> m_Up = { 0.0f, 1.0f, 0.0f };
+};
+
+/**
+ * Particle system class.
+ * This simulates particles entirely on the GPU, on the compute queue, so the CPU cost of a frame only depends on the number of emitters. Each update
+ * is a single submission of compute passes:
+ * 1. The emitters take particles from the dead list and append them to the alive list.
+ * 2. The alive particles are simulated. The dead ones go back to the dead list and the rest are compacted into the other alive list, so the work
+ *    of the next passes only depends on the alive count. The dispatch sizes are written by the GPU and the passes are dispatched indirectly.
+ * 3. The alive particles are sorted back to front with a bitonic sort, so they can be alpha blended.
+ * 4. The sorted particles are written to a render buffer along with the draw command, which is drawn with a single indirect draw.
+ *
+ * There are two render buffers, so the graphics queue can draw one while the next update writes the other, and the simulation overlaps the
+ * graphics work of the previous frame. They're shared concurrently between the compute and the graphics queue families, so no ownership transfers
+ * are needed. The graphics submission which draws the particles must wait for getDrawWait(), and its timeline value must be given back with
+ * setDrawValue() so the update which writes the same buffer again waits for it.
+ *
+ * The system is not thread safe and should be used from the render thread.
+ */
+class ParticleSystem final : public InstanceBoundObject
+{
+	/**
+	 * Emit constants structure.
+	 * This is pushed to the emit shader.
+	 */
+	struct EmitConstants final
+	{
+		std::array<float, 4> m_PositionRadius = {};
+		std::array<float, 4> m_VelocitySpread = {};
+		std::array<float, 4> m_StartColor = {};
+		std::array<float, 4> m_EndColor = {};
+		std::array<float, 2> m_Lifetime = {};
+		std::array<float, 2> m_Size = {};
+		uint32_t m_EmitCount = 0;
+		uint32_t m_Seed = 0;
+		uint32_t m_AliveIndex = 0;
+		uint32_t m_MaximumParticles = 0;
+	};
+
+	/**
+	 * Frame constants structure.
+	 * This is pushed to the rest of the simulation shaders.
+	 */
+	struct FrameConstants final
+	{
+		std::array<float, 4> m_CameraPosition = {};
+		std::array<float, 4> m_CameraForward = {};
+		std::array<float, 3> m_Gravity = {};
+		float m_Drag = 0.0f;
+		float m_DeltaTime = 0.0f;
+		uint32_t m_AliveIndex = 0;
+		uint32_t m_MaximumParticles = 0;
+		uint32_t m_Padding = 0;
+	};
+
+	/**
+	 * Sort constants structure.
+	 * This is pushed to the bitonic merge shaders.
+	 */
+	struct SortConstants final
+	{
+		uint32_t m_BlockSize = 0;
+		uint32_t m_Distance = 0;
+	};
+
+	/**
+	 * Render constants structure.
+	 * This is pushed to the particle vertex shader.
+	 */
+	struct RenderConstants final
+	{
+		std::array<float, 16> m_ViewProjection = {};
+		std::array<float, 4> m_CameraRight = {};
+		std::array<float, 4> m_CameraUp = {};
+	};
+
+	/**
+	 * Render slot structure.
+	 * This contains the output of an update, which is drawn by the graphics queue.
+	 */
+	struct RenderSlot final
+	{
+		/**
+		 * Explicit constructor.
+		 *
+		 * @param instance The instance reference.
+		 * @param maximumParticles The maximum number of particles.
+		 * @param queueFamilies The queue families which access the buffers.
+		 */
+		explicit RenderSlot(Instance& instance, uint32_t maximumParticles, std::span<const uint32_t> queueFamilies);
+
+		Buffer m_RenderParticles;
+		Buffer m_DrawArguments;
+
+		VkDescriptorSet m_ComputeDescriptorSet = VK_NULL_HANDLE;
+		VkDescriptorSet m_RenderDescriptorSet = VK_NULL_HANDLE;
+
+		uint64_t m_DrawValue = 0;	// The graphics timeline value which draws this slot.
+	};
+
+public:
+	/**
+	 * Explicit constructor.
+	 *
+	 * @param instance The instance reference.
+	 * @param submissionQueue The submission queue to submit the updates to.
+	 * @param maximumParticles The maximum number of particles alive at once. This is clamped to what a single dispatch can cover on the device.
+	 * @param shaderDirectory The directory containing the compiled particle shaders. Default is Shaders.
+	 */
+	explicit ParticleSystem(Instance& instance, CommandSubmissionQueue& submissionQueue, uint32_t maximumParticles, const std::filesystem::path& shaderDirectory = "Shaders");
+
+	/**
+	 * Destructor.
+	 * This waits till the submitted updates are done.
+	 */
+	~ParticleSystem() override;
+
+	/**
+	 * Add an emitter.
+	 *
+	 * @param emitter The emitter description.
+	 * @return The emitter handle.
+	 */
+	[[nodiscard]] ParticleEmitterHandle addEmitter(const ParticleEmitter& emitter) { return m_Emitters.create(ParticleEmitterState{ emitter }); }
+
+	/**
+	 * Remove an emitter.
+	 * The particles it spawned live out their lifetime.
+	 *
+	 * @param handle The emitter handle.
+	 */
+	void removeEmitter(ParticleEmitterHandle handle) { m_Emitters.destroy(handle); }
+
+	/**
+	 * Get an emitter to change it.
+	 *
+	 * @param handle The emitter handle.
+	 * @return The emitter pointer. This is null if the handle is invalid.
+	 */
+	[[nodiscard]] ParticleEmitter* getEmitter(ParticleEmitterHandle handle);
+
+	/**
+	 * Spawn a number of particles from an emitter in the next update, on top of it's rate.
+	 *
+	 * @param handle The emitter handle.
+	 * @param count The number of particles.
+	 */
+	void emit(ParticleEmitterHandle handle, uint32_t count);
+
+	/**
+	 * Enqueue the simulation of a frame to the compute queue.
+	 * The submission is sent by the next flush of the submission queue.
+	 *
+	 * @param deltaTime The time since the last update in seconds.
+	 * @param camera The camera to sort the particles for.
+	 * @return The compute timeline value of the update. This is 0 if the particle shaders could not be loaded.
+	 */
+	uint64_t update(float deltaTime, const ParticleCamera& camera);
+
+	/**
+	 * Get the wait the graphics submission which draws the particles needs.
+	 *
+	 * @return The submission wait.
+	 */
+	[[nodiscard]] SubmissionWait getDrawWait() const;
+
+	/**
+	 * Set the graphics timeline value of the submission which draws the last update.
+	 *
+	 * @param graphicsValue The timeline value.
+	 */
+	void setDrawValue(uint64_t graphicsValue) { m_RenderSlots[m_DrawSlot].m_DrawValue = graphicsValue; }
+
+	/**
+	 * Record the draw call of the last update.
+	 * The particle render pipeline must be bound before this, and blending is expected to be enabled.
+	 *
+	 * @param commandBuffer The command buffer to record to.
+	 * @param pipelineLayout The layout of the bound pipeline.
+	 */
+	void draw(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout) const;
+
+	/**
+	 * Get the description of the particle render pipeline.
+	 * The pipeline can be requested from the pipeline manager and bound before draw().
+	 *
+	 * @param colorFormat The color attachment format.
+	 * @param depthFormat The depth attachment format. The particles are depth tested but do not write depth.
+	 * @param shaderDirectory The directory containing the compiled particle shaders. Default is Shaders.
+	 * @return The pipeline description.
+	 */
+	[[nodiscard]] static PipelineDescription GetRenderPipelineDescription(VkFormat colorFormat, VkFormat depthFormat, const std::filesystem::path& shaderDirectory = "Shaders");
+
+	/**
+	 * Set the gravity.
+	 *
+	 * @param gravity The acceleration applied to every particle.
+	 */
+	void setGravity(const std::array<float, 3>& gravity) { m_Gravity = gravity; }
+
+	/**
+	 * Set the drag.
+	 *
+	 * @param drag The fraction of the velocity lost per second.
+	 */
+	void setDrag(float drag) { m_Drag = drag; }
+
+	/**
+	 * Enable or disable sorting.
+	 * Particles which are blended additively do not need to be sorted.
+	 *
+	 * @param enable Whether to sort the particles.
+	 */
+	void setSorting(bool enable) { m_bSorting = enable; }
+
+	/**
+	 * Check if the particle shaders were loaded.
+	 *
+	 * @return True if the system can be updated.
+	 */
+	[[nodiscard]] bool isValid() const { return m_bIsValid; }
+
+public:
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, MaximumParticles, m_MaximumParticles);
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, EmitterCount, m_Emitters.getSize());
+	GRAPHITE_SETUP_SIMPLE_GETTER(bool, IsSorting, m_bSorting);
+
+private:
+	/**
+	 * Explicit constructor.
+	 * The public constructor delegates to this once the maximum number of particles is clamped, since the buffers are sized from it.
+	 *
+	 * @param instance The instance reference.
+	 * @param submissionQueue The submission queue to submit the updates to.
+	 * @param shaderDirectory The directory containing the compiled particle shaders.
+	 * @param maximumParticles The clamped maximum number of particles.
+	 */
+	explicit ParticleSystem(Instance& instance, CommandSubmissionQueue& submissionQueue, const std::filesystem::path& shaderDirectory, uint32_t maximumParticles);
+
+	/**
+	 * Create the render descriptor sets.
+	 */
+	void createRenderDescriptorSets();
+
+	/**
+	 * Write the compute descriptor set of a render slot.
+	 *
+	 * @param slot The render slot.
+	 */
+	void writeComputeDescriptorSet(RenderSlot& slot);
+
+	/**
+	 * Record the emit passes.
+	 *
+	 * @param commandBuffer The command buffer to record to.
+	 * @param slot The render slot.
+	 * @param deltaTime The time since the last update in seconds.
+	 */
+	void recordEmit(VkCommandBuffer commandBuffer, const RenderSlot& slot, float deltaTime);
+
+	/**
+	 * Record the sorting passes.
+	 *
+	 * @param commandBuffer The command buffer to record to.
+	 * @param slot The render slot.
+	 * @param constants The frame constants.
+	 */
+	void recordSort(VkCommandBuffer commandBuffer, const RenderSlot& slot, const FrameConstants& constants) const;
+
+	/**
+	 * Record a barrier between two simulation passes.
+	 *
+	 * @param commandBuffer The command buffer to record to.
+	 */
+	void recordPassBarrier(VkCommandBuffer commandBuffer) const;
+
+	/**
+	 * Get a command buffer to record an update to.
+	 * The command buffers of the completed updates are reused.
+	 *
+	 * @return The command buffer.
+	 */
+	[[nodiscard]] VkCommandBuffer getCommandBuffer();
+
+private:
+	CommandSubmissionQueue& m_SubmissionQueue;
+
+	ResourcePool<ParticleEmitterState> m_Emitters;
+
+	Buffer m_Particles;
+	Buffer m_DeadList;
+	Buffer m_AliveLists;
+	Buffer m_SortList;
+	Buffer m_State;
+
+	std::array<RenderSlot, 2> m_RenderSlots;
+
+	ComputePipeline m_InitializePipeline;
+	ComputePipeline m_EmitPipeline;
+	ComputePipeline m_PreparePipeline;
+	ComputePipeline m_SimulatePipeline;
+	ComputePipeline m_FinishPipeline;
+	ComputePipeline m_SortLocalPipeline;
+	ComputePipeline m_MergeGlobalPipeline;
+	ComputePipeline m_MergeLocalPipeline;
+	ComputePipeline m_WritePipeline;
+
+	VkDescriptorSetLayout m_RenderSetLayout = VK_NULL_HANDLE;
+	VkDescriptorPool m_RenderDescriptorPool = VK_NULL_HANDLE;
+
+	VkCommandPool m_CommandPool = VK_NULL_HANDLE;
+	std::deque<std::pair<VkCommandBuffer, uint64_t>> m_PendingCommandBuffers;
+	std::vector<VkCommandBuffer> m_FreeCommandBuffers;
+
+	RenderConstants m_RenderConstants;
+	std::array<float, 3> m_Gravity = { 0.0f, -9.81f, 0.0f };
+	float m_Drag = 0.0f;
+
+	uint64_t m_LastValue = 0;
+
+	uint32_t m_MaximumParticles = 0;
+	uint32_t m_SortCapacity = 0;
+	uint32_t m_Seed = 0;
+	uint32_t m_AliveIndex = 0;
+	uint32_t m_DrawSlot = 0;
+
+	bool m_bIsValid = false;
+	bool m_bIsInitialized = false;
+	bool m_bSorting = true;
+};
@@ -0,0 +1,850 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "PipelineManager.hpp"
+#include "ComputePipeline.hpp"
+#include "Instance.hpp"
+#include "VulkanMacros.hpp"
+
+#include "Core/AllocationTracker.hpp"
+
+#include <optick.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+
+namespace /* anonymous */
+{
+	constexpr std::array<char, 4> g_ListMagic = { 'G', 'P', 'L', 'L' };
+	constexpr uint32_t g_ListVersion = 1;
+
+	// Keys longer than this are treated as a corrupted list file.
+	constexpr uint32_t g_MaximumKeySize = 1024 * 1024;
+
+	/**
+	 * Key writer class.
+	 * This serializes a pipeline description field by field, so the padding of the structures never ends up in the key.
+	 */
+	class KeyWriter final
+	{
+	public:
+		/**
+		 * Write a value.
+		 *
+		 * @tparam Type The value type. This must not contain padding.
+		 * @param value The value to write.
+		 */
+		template<class Type>
+		void write(const Type& value)
+		{
+			m_Key.append(reinterpret_cast<const char*>(&value), sizeof(Type));
+		}
+
+		/**
+		 * Write a string.
+		 *
+		 * @param string The string to write.
+		 */
+		void writeString(const std::string& string)
+		{
+			write(static_cast<uint32_t>(string.size()));
+			m_Key.append(string);
+		}
+
+		/**
+		 * Write an array of values.
+		 *
+		 * @tparam Type The value type. This must not contain padding.
+		 * @param values The values to write.
+		 */
+		template<class Type>
+		void writeArray(const std::vector<Type>& values)
+		{
+			write(static_cast<uint32_t>(values.size()));
+			m_Key.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(Type));
+		}
+
+	public:
+		GRAPHITE_SETUP_SIMPLE_GETTER(const std::string&, Key, m_Key);
+
+	private:
+		std::string m_Key;
+	};
+
+	/**
+	 * Key reader class.
+	 * This reads the values written by the key writer. Reading past the end returns zeroes and marks the reader as overflowed.
+	 */
+	class KeyReader final
+	{
+	public:
+		/**
+		 * Explicit constructor.
+		 *
+		 * @param key The key to read.
+		 */
+		explicit KeyReader(std::string_view key) : m_Key(key) {}
+
+		/**
+		 * Read a value.
+		 *
+		 * @tparam Type The value type.
+		 * @return The value.
+		 */
+		template<class Type>
+		[[nodiscard]] Type read()
+		{
+			Type value = {};
+			if (m_Offset + sizeof(Type) > m_Key.size())
+			{
+				m_bHasOverflowed = true;
+				return value;
+			}
+
+			std::memcpy(&value, m_Key.data() + m_Offset, sizeof(Type));
+			m_Offset += sizeof(Type);
+			return value;
+		}
+
+		/**
+		 * Read a string.
+		 *
+		 * @return The string.
+		 */
+		[[nodiscard]] std::string readString()
+		{
+			const auto size = read<uint32_t>();
+			if (m_Offset + size > m_Key.size())
+			{
+				m_bHasOverflowed = true;
+				return {};
+			}
+
+			auto string = std::string(m_Key.substr(m_Offset, size));
+			m_Offset += size;
+			return string;
+		}
+
+		/**
+		 * Read an array of values.
+		 *
+		 * @tparam Type The value type.
+		 * @return The values.
+		 */
+		template<class Type>
+		[[nodiscard]] std::vector<Type> readArray()
+		{
+			const auto count = read<uint32_t>();
+			if (m_Offset + static_cast<uint64_t>(count) * sizeof(Type) > m_Key.size())
+			{
+				m_bHasOverflowed = true;
+				return {};
+			}
+
+			std::vector<Type> values(count);
+			std::memcpy(values.data(), m_Key.data() + m_Offset, count * sizeof(Type));
+			m_Offset += count * sizeof(Type);
+			return values;
+		}
+
+		/**
+		 * Check if the whole key was read without overflowing.
+		 *
+		 * @return True if the key was valid.
+		 */
+		[[nodiscard]] bool isComplete() const { return !m_bHasOverflowed && m_Offset == m_Key.size(); }
+
+	private:
+		std::string_view m_Key;
+		size_t m_Offset = 0;
+
+		bool m_bHasOverflowed = false;
+	};
+
+	/**
+	 * Serialize a pipeline description.
+	 * The result is both the key used to share identical pipelines and the record in the list file.
+	 *
+	 * @param description The pipeline description.
+	 * @return The serialized description.
+	 */
+	[[nodiscard]] std::string SerializeDescription(const PipelineDescription& description)
+	{
+		auto writer = KeyWriter();
+		writer.write(description.m_Type);
+		writer.writeString(description.m_ComputeShader);
+		writer.writeString(description.m_VertexShader);
+		writer.writeString(description.m_FragmentShader);
+
+		writer.write(static_cast<uint32_t>(description.m_SetBindings.size()));
+		for (const auto& bindings : description.m_SetBindings)
+		{
+			writer.write(static_cast<uint32_t>(bindings.size()));
+			for (const auto& binding : bindings)
+			{
+				writer.write(binding.binding);
+				writer.write(binding.descriptorType);
+				writer.write(binding.descriptorCount);
+				writer.write(binding.stageFlags);
+			}
+		}
+
+		writer.write(description.m_PushConstantSize);
+		writer.writeArray(description.m_VertexBindings);
+		writer.writeArray(description.m_VertexAttributes);
+		writer.writeArray(description.m_ColorFormats);
+		writer.write(description.m_DepthFormat);
+		writer.write(description.m_Topology);
+		writer.write(description.m_CullMode);
+		writer.write(description.m_FrontFace);
+		writer.write(description.m_DepthCompareOp);
+		writer.write(static_cast<uint8_t>(description.m_bDepthTest));
+		writer.write(static_cast<uint8_t>(description.m_bDepthWrite));
+		writer.write(static_cast<uint8_t>(description.m_bBlend));
+
+		return writer.getKey();
+	}
+
+	/**
+	 * Deserialize a pipeline description.
+	 *
+	 * @param key The serialized description.
+	 * @param description The description to read to.
+	 * @return False if the key is invalid.
+	 */
+	[[nodiscard]] bool DeserializeDescription(std::string_view key, PipelineDescription& description)
+	{
+		auto reader = KeyReader(key);
+		description.m_Type = reader.read<PipelineType>();
+		description.m_ComputeShader = reader.readString();
+		description.m_VertexShader = reader.readString();
+		description.m_FragmentShader = reader.readString();
+
+		const auto setCount = reader.read<uint32_t>();
+		if (setCount > key.size())
+			return false;
+
+		description.m_SetBindings.resize(setCount);
+		for (auto& bindings : description.m_SetBindings)
+		{
+			const auto bindingCount = reader.read<uint32_t>();
+			if (bindingCount > key.size())
+				return false;
+
+			bindings.resize(bindingCount);
+			for (auto& binding : bindings)
+			{
+				binding.binding = reader.read<uint32_t>();
+				binding.descriptorType = reader.read<VkDescriptorType>();
+				binding.descriptorCount = reader.read<uint32_t>();
+				binding.stageFlags = reader.read<VkShaderStageFlags>();
+				binding.pImmutableSamplers = nullptr;
+			}
+		}
+
+		description.m_PushConstantSize = reader.read<uint32_t>();
+		description.m_VertexBindings = reader.readArray<VkVertexInputBindingDescription>();
+		description.m_VertexAttributes = reader.readArray<VkVertexInputAttributeDescription>();
+		description.m_ColorFormats = reader.readArray<VkFormat>();
+		description.m_DepthFormat = reader.read<VkFormat>();
+		description.m_Topology = reader.read<VkPrimitiveTopology>();
+		description.m_CullMode = reader.read<VkCullModeFlags>();
+		description.m_FrontFace = reader.read<VkFrontFace>();
+		description.m_DepthCompareOp = reader.read<VkCompareOp>();
+		description.m_bDepthTest = reader.read<uint8_t>() != 0;
+		description.m_bDepthWrite = reader.read<uint8_t>() != 0;
+		description.m_bBlend = reader.read<uint8_t>() != 0;
+
+		return reader.isComplete() && description.m_Type <= PipelineType::Graphics;
+	}
+
+	/**
+	 * Create a shader module from a compiled SPIR-V shader.
+	 *
+	 * @param deviceTable The device table.
+	 * @param logicalDevice The logical device.
+	 * @param path The shader path.
+	 * @return The shader module. This is null if the shader could not be read or created.
+	 */
+	[[nodiscard]] VkShaderModule CreateShaderModule(const VolkDeviceTable& deviceTable, VkDevice logicalDevice, const std::string& path)
+	{
+		const auto code = ComputePipeline::ReadShaderCode(path);
+		if (code.empty())
+		{
+			GRAPHITE_LOG_ERROR("Failed to read the shader {}!", path);
+			return VK_NULL_HANDLE;
+		}
+
+		VkShaderModuleCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		createInfo.pNext = nullptr;
+		createInfo.flags = 0;
+		createInfo.codeSize = code.size() * sizeof(uint32_t);
+		createInfo.pCode = code.data();
+
+		VkShaderModule shaderModule = VK_NULL_HANDLE;
+		if (deviceTable.vkCreateShaderModule(logicalDevice, &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
+		{
+			GRAPHITE_LOG_ERROR("Failed to create the shader module of {}!", path);
+			return VK_NULL_HANDLE;
+		}
+
+		return shaderModule;
+	}
+
+	/**
+	 * Check if a depth format has a stencil component.
+	 *
+	 * @param format The format.
+	 * @return True if the format has a stencil component.
+	 */
+	[[nodiscard]] constexpr bool HasStencil(VkFormat format)
+	{
+		return format == VK_FORMAT_S8_UINT || format == VK_FORMAT_D16_UNORM_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT || format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+	}
+}
+
+PipelineManager::PipelineManager(Instance& instance, std::filesystem::path listPath, uint32_t workerCount)
+	: InstanceBoundObject(instance)
+	, m_ListPath(std::move(listPath))
+{
+	loadList();
+
+	if (workerCount == 0)
+		workerCount = std::max(std::thread::hardware_concurrency() / 2, 1u);
+
+	m_Workers.reserve(workerCount);
+	for (uint32_t i = 0; i < workerCount; i++)
+		m_Workers.emplace_back([this](std::stop_token stopToken) { worker(stopToken); });
+}
+
+PipelineManager::~PipelineManager()
+{
+	for (auto& worker : m_Workers)
+		worker.request_stop();
+
+	// Joins the workers. The ones which are compiling finish their current pipeline first.
+	m_Workers.clear();
+
+	saveList();
+
+	std::vector<VkPipeline> pipelines;
+	std::vector<VkPipelineLayout> pipelineLayouts;
+	std::vector<VkDescriptorSetLayout> descriptorSetLayouts;
+	for (const auto& pPipeline : m_Pipelines)
+	{
+		if (pPipeline->m_Pipeline != VK_NULL_HANDLE)
+			pipelines.emplace_back(pPipeline->m_Pipeline);
+
+		pipelineLayouts.emplace_back(pPipeline->m_PipelineLayout);
+		descriptorSetLayouts.insert(descriptorSetLayouts.end(), pPipeline->m_DescriptorSetLayouts.begin(), pPipeline->m_DescriptorSetLayouts.end());
+	}
+
+	// The last frames might still be using the pipelines, so everything is destroyed once they are done.
+	m_Instance.getDeletionQueue().retire([&deviceTable = m_Instance.getDeviceTable(), pipelines = std::move(pipelines), pipelineLayouts = std::move(pipelineLayouts), descriptorSetLayouts = std::move(descriptorSetLayouts)](VkDevice logicalDevice)
+		{
+			for (const auto pipeline : pipelines)
+				deviceTable.vkDestroyPipeline(logicalDevice, pipeline, nullptr);
+
+			for (const auto layout : pipelineLayouts)
+				deviceTable.vkDestroyPipelineLayout(logicalDevice, layout, nullptr);
+
+			for (const auto layout : descriptorSetLayouts)
+				deviceTable.vkDestroyDescriptorSetLayout(logicalDevice, layout, nullptr);
+		}
+	);
+}
+
+PipelineHandle PipelineManager::request(const PipelineDescription& description, PipelineHandle fallback)
+{
+	const auto handle = getOrCreate(SerializeDescription(description), description, false);
+	const auto pPipeline = get(handle);
+	if (pPipeline == nullptr)
+		return {};
+
+	// The first fallback stays, so a pipeline never falls back to one that falls back to it.
+	if (fallback && fallback != handle && !pPipeline->m_Fallback)
+		pPipeline->m_Fallback = fallback;
+
+	// Pre-warmed pipelines which are still in the queue are needed now.
+	prioritize(*pPipeline);
+	return handle;
+}
+
+const ManagedPipeline* PipelineManager::resolve(PipelineHandle handle) const
+{
+	const auto pPipeline = get(handle);
+	if (pPipeline == nullptr)
+		return nullptr;
+
+	if (pPipeline->m_State.load(std::memory_order_acquire) == PipelineState::Ready)
+		return pPipeline;
+
+	const auto pFallback = get(pPipeline->m_Fallback);
+	if (pFallback != nullptr && pFallback->m_State.load(std::memory_order_acquire) == PipelineState::Ready)
+		return pFallback;
+
+	return nullptr;
+}
+
+bool PipelineManager::bind(VkCommandBuffer commandBuffer, PipelineHandle handle) const
+{
+	const auto pPipeline = resolve(handle);
+	if (pPipeline == nullptr)
+		return false;
+
+	const auto bindPoint = pPipeline->m_Description.m_Type == PipelineType::Compute ? VK_PIPELINE_BIND_POINT_COMPUTE : VK_PIPELINE_BIND_POINT_GRAPHICS;
+	m_Instance.getDeviceTable().vkCmdBindPipeline(commandBuffer, bindPoint, pPipeline->m_Pipeline);
+	return true;
+}
+
+PipelineState PipelineManager::getState(PipelineHandle handle) const
+{
+	const auto pPipeline = get(handle);
+	if (pPipeline == nullptr)
+		return PipelineState::Failed;
+
+	return pPipeline->m_State.load(std::memory_order_acquire);
+}
+
+bool PipelineManager::wait(PipelineHandle handle)
+{
+	OPTICK_EVENT();
+
+	const auto pPipeline = get(handle);
+	if (pPipeline == nullptr)
+		return false;
+
+	prioritize(*pPipeline);
+
+	auto lock = std::unique_lock(m_WaitMutex);
+	m_WaitCondition.wait(lock, [pPipeline] { return pPipeline->m_State.load(std::memory_order_acquire) != PipelineState::Pending; });
+
+	return pPipeline->m_State.load(std::memory_order_acquire) == PipelineState::Ready;
+}
+
+void PipelineManager::saveList() const
+{
+	auto file = std::ofstream(m_ListPath, std::ios::binary);
+	if (!file.is_open())
+	{
+		GRAPHITE_LOG_ERROR("Failed to open the pipeline list file {}!", m_ListPath.string());
+		return;
+	}
+
+	// Failed pipelines are dropped, so missing or broken shaders don't stay in the list forever.
+	std::vector<std::string> keys;
+	keys.reserve(m_Pipelines.size());
+	for (const auto& pPipeline : m_Pipelines)
+	{
+		if (pPipeline->m_State.load(std::memory_order_acquire) != PipelineState::Failed)
+			keys.emplace_back(SerializeDescription(pPipeline->m_Description));
+	}
+
+	const auto count = static_cast<uint32_t>(keys.size());
+	file.write(g_ListMagic.data(), g_ListMagic.size());
+	file.write(reinterpret_cast<const char*>(&g_ListVersion), sizeof(g_ListVersion));
+	file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+
+	for (const auto& key : keys)
+	{
+		const auto size = static_cast<uint32_t>(key.size());
+		file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+		file.write(key.data(), static_cast<std::streamsize>(key.size()));
+	}
+}
+
+ManagedPipeline* PipelineManager::get(PipelineHandle handle) const
+{
+	if (!handle || handle.getIndex() >= m_Pipelines.size())
+		return nullptr;
+
+	return m_Pipelines[handle.getIndex()].get();
+}
+
+PipelineHandle PipelineManager::getOrCreate(std::string key, const PipelineDescription& description, bool bIsPrewarm)
+{
+	if (const auto itr = m_PipelineMap.find(key); itr != m_PipelineMap.end())
+		return itr->second;
+
+	auto pPipeline = std::make_unique<ManagedPipeline>();
+	pPipeline->m_Description = description;
+
+	if (!createLayout(*pPipeline))
+		return {};
+
+	// Pipelines are only destroyed with the manager, so the generation never changes.
+	const auto handle = PipelineHandle::Create(static_cast<uint32_t>(m_Pipelines.size()), 1);
+	const auto pRawPipeline = m_Pipelines.emplace_back(std::move(pPipeline)).get();
+	m_PipelineMap.emplace(std::move(key), handle);
+	m_PendingCount.fetch_add(1, std::memory_order_relaxed);
+
+	{
+		const auto lock = std::scoped_lock(m_QueueMutex);
+		(bIsPrewarm ? m_PrewarmQueue : m_RequestQueue).emplace_back(pRawPipeline);
+	}
+
+	m_QueueCondition.notify_one();
+	return handle;
+}
+
+void PipelineManager::prioritize(ManagedPipeline& pipeline)
+{
+	if (pipeline.m_bIsClaimed.load(std::memory_order_relaxed))
+		return;
+
+	{
+		const auto lock = std::scoped_lock(m_QueueMutex);
+		if (std::find(m_RequestQueue.begin(), m_RequestQueue.end(), &pipeline) != m_RequestQueue.end())
+			return;
+
+		m_RequestQueue.emplace_back(&pipeline);
+	}
+
+	m_QueueCondition.notify_one();
+}
+
+void PipelineManager::loadList()
+{
+	auto file = std::ifstream(m_ListPath, std::ios::binary);
+	if (!file.is_open())
+		return;
+
+	std::array<char, 4> magic = {};
+	uint32_t version = 0;
+	uint32_t count = 0;
+	file.read(magic.data(), magic.size());
+	file.read(reinterpret_cast<char*>(&version), sizeof(version));
+	file.read(reinterpret_cast<char*>(&count), sizeof(count));
+
+	if (!file || magic != g_ListMagic || version != g_ListVersion)
+	{
+		GRAPHITE_LOG_WARNING("The pipeline list file {} is invalid or outdated, nothing is pre-warmed.", m_ListPath.string());
+		return;
+	}
+
+	uint32_t prewarmCount = 0;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint32_t size = 0;
+		file.read(reinterpret_cast<char*>(&size), sizeof(size));
+		if (!file || size > g_MaximumKeySize)
+			break;
+
+		auto key = std::string(size, '\0');
+		file.read(key.data(), size);
+		if (!file)
+			break;
+
+		PipelineDescription description;
+		if (!DeserializeDescription(key, description))
+			continue;
+
+		if (getOrCreate(std::move(key), description, true))
+			prewarmCount++;
+	}
+
+	GRAPHITE_LOG_INFORMATION("Pre-warming {} pipelines from {}.", prewarmCount, m_ListPath.string());
+}
+
+bool PipelineManager::createLayout(ManagedPipeline& pipeline)
+{
+	const auto& description = pipeline.m_Description;
+
+	VkPushConstantRange pushConstantRange = {};
+	pushConstantRange.stageFlags = description.m_Type == PipelineType::Compute ? VK_SHADER_STAGE_COMPUTE_BIT : VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = description.m_PushConstantSize;
+
+	m_Instance.getLogicalDevice().access([this, &pipeline, &description, &pushConstantRange](VkDevice logicalDevice)
+		{
+			const auto& deviceTable = m_Instance.getDeviceTable();
+
+			// Create the descriptor set layouts.
+			pipeline.m_DescriptorSetLayouts.resize(description.m_SetBindings.size());
+			for (size_t i = 0; i < description.m_SetBindings.size(); i++)
+			{
+				VkDescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+				layoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+				layoutCreateInfo.pNext = nullptr;
+				layoutCreateInfo.flags = 0;
+				layoutCreateInfo.bindingCount = static_cast<uint32_t>(description.m_SetBindings[i].size());
+				layoutCreateInfo.pBindings = description.m_SetBindings[i].data();
+				GRAPHITE_VK_ASSERT(deviceTable.vkCreateDescriptorSetLayout(logicalDevice, &layoutCreateInfo, nullptr, &pipeline.m_DescriptorSetLayouts[i]), "Failed to create the descriptor set layout!");
+			}
+
+			// Create the pipeline layout.
+			VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+			pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+			pipelineLayoutCreateInfo.pNext = nullptr;
+			pipelineLayoutCreateInfo.flags = 0;
+			pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(pipeline.m_DescriptorSetLayouts.size());
+			pipelineLayoutCreateInfo.pSetLayouts = pipeline.m_DescriptorSetLayouts.data();
+			pipelineLayoutCreateInfo.pushConstantRangeCount = pushConstantRange.size > 0 ? 1 : 0;
+			pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+			GRAPHITE_VK_ASSERT(deviceTable.vkCreatePipelineLayout(logicalDevice, &pipelineLayoutCreateInfo, nullptr, &pipeline.m_PipelineLayout), "Failed to create the pipeline layout!");
+		}
+	);
+
+	return pipeline.m_PipelineLayout != VK_NULL_HANDLE;
+}
+
+bool PipelineManager::compile(ManagedPipeline& pipeline) const
+{
+	switch (pipeline.m_Description.m_Type)
+	{
+	case PipelineType::Compute:
+		return compileCompute(pipeline);
+
+	case PipelineType::Graphics:
+		return compileGraphics(pipeline);
+
+	default:
+		return false;
+	}
+}
+
+bool PipelineManager::compileCompute(ManagedPipeline& pipeline) const
+{
+	const auto& deviceTable = m_Instance.getDeviceTable();
+
+	// Pipeline creation is thread safe, so the device is not locked, otherwise the workers would compile one at a time.
+	const auto logicalDevice = m_Instance.getLogicalDevice().getUnsafe();
+
+	const auto shaderModule = CreateShaderModule(deviceTable, logicalDevice, pipeline.m_Description.m_ComputeShader);
+	if (shaderModule == VK_NULL_HANDLE)
+		return false;
+
+	VkComputePipelineCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	createInfo.pNext = nullptr;
+	createInfo.flags = 0;
+	createInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	createInfo.stage.pNext = nullptr;
+	createInfo.stage.flags = 0;
+	createInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	createInfo.stage.module = shaderModule;
+	createInfo.stage.pName = "main";
+	createInfo.stage.pSpecializationInfo = nullptr;
+	createInfo.layout = pipeline.m_PipelineLayout;
+	createInfo.basePipelineHandle = VK_NULL_HANDLE;
+	createInfo.basePipelineIndex = -1;
+
+	const auto result = deviceTable.vkCreateComputePipelines(logicalDevice, m_Instance.getPipelineCache(), 1, &createInfo, nullptr, &pipeline.m_Pipeline);
+	deviceTable.vkDestroyShaderModule(logicalDevice, shaderModule, nullptr);
+
+	if (result != VK_SUCCESS)
+	{
+		GRAPHITE_LOG_ERROR("Failed to create the compute pipeline of {}!", pipeline.m_Description.m_ComputeShader);
+		return false;
+	}
+
+	return true;
+}
+
+bool PipelineManager::compileGraphics(ManagedPipeline& pipeline) const
+{
+	const auto& description = pipeline.m_Description;
+	if (!m_Instance.isDeviceExtensionEnabled(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME))
+	{
+		GRAPHITE_LOG_ERROR("Cannot create the graphics pipeline of {}, dynamic rendering is not supported!", description.m_VertexShader);
+		return false;
+	}
+
+	const auto& deviceTable = m_Instance.getDeviceTable();
+
+	// Pipeline creation is thread safe, so the device is not locked, otherwise the workers would compile one at a time.
+	const auto logicalDevice = m_Instance.getLogicalDevice().getUnsafe();
+
+	// Create the shader modules. Depth only pipelines don't have a fragment shader.
+	const auto vertexModule = CreateShaderModule(deviceTable, logicalDevice, description.m_VertexShader);
+	const auto fragmentModule = description.m_FragmentShader.empty() ? VK_NULL_HANDLE : CreateShaderModule(deviceTable, logicalDevice, description.m_FragmentShader);
+	if (vertexModule == VK_NULL_HANDLE || (!description.m_FragmentShader.empty() && fragmentModule == VK_NULL_HANDLE))
+	{
+		deviceTable.vkDestroyShaderModule(logicalDevice, vertexModule, nullptr);
+		deviceTable.vkDestroyShaderModule(logicalDevice, fragmentModule, nullptr);
+		return false;
+	}
+
+	std::array<VkPipelineShaderStageCreateInfo, 2> stages = {};
+	stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	stages[0].pNext = nullptr;
+	stages[0].flags = 0;
+	stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+	stages[0].module = vertexModule;
+	stages[0].pName = "main";
+	stages[0].pSpecializationInfo = nullptr;
+
+	stages[1] = stages[0];
+	stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	stages[1].module = fragmentModule;
+
+	VkPipelineVertexInputStateCreateInfo vertexInputState = {};
+	vertexInputState.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertexInputState.pNext = nullptr;
+	vertexInputState.flags = 0;
+	vertexInputState.vertexBindingDescriptionCount = static_cast<uint32_t>(description.m_VertexBindings.size());
+	vertexInputState.pVertexBindingDescriptions = description.m_VertexBindings.data();
+	vertexInputState.vertexAttributeDescriptionCount = static_cast<uint32_t>(description.m_VertexAttributes.size());
+	vertexInputState.pVertexAttributeDescriptions = description.m_VertexAttributes.data();
+
+	VkPipelineInputAssemblyStateCreateInfo inputAssemblyState = {};
+	inputAssemblyState.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	inputAssemblyState.pNext = nullptr;
+	inputAssemblyState.flags = 0;
+	inputAssemblyState.topology = description.m_Topology;
+	inputAssemblyState.primitiveRestartEnable = VK_FALSE;
+
+	// The viewport and the scissor are dynamic, so only the counts are set.
+	VkPipelineViewportStateCreateInfo viewportState = {};
+	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewportState.pNext = nullptr;
+	viewportState.flags = 0;
+	viewportState.viewportCount = 1;
+	viewportState.pViewports = nullptr;
+	viewportState.scissorCount = 1;
+	viewportState.pScissors = nullptr;
+
+	VkPipelineRasterizationStateCreateInfo rasterizationState = {};
+	rasterizationState.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterizationState.pNext = nullptr;
+	rasterizationState.flags = 0;
+	rasterizationState.depthClampEnable = VK_FALSE;
+	rasterizationState.rasterizerDiscardEnable = VK_FALSE;
+	rasterizationState.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterizationState.cullMode = description.m_CullMode;
+	rasterizationState.frontFace = description.m_FrontFace;
+	rasterizationState.depthBiasEnable = VK_FALSE;
+	rasterizationState.lineWidth = 1.0f;
+
+	VkPipelineMultisampleStateCreateInfo multisampleState = {};
+	multisampleState.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisampleState.pNext = nullptr;
+	multisampleState.flags = 0;
+	multisampleState.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+	multisampleState.sampleShadingEnable = VK_FALSE;
+
+	VkPipelineDepthStencilStateCreateInfo depthStencilState = {};
+	depthStencilState.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	depthStencilState.pNext = nullptr;
+	depthStencilState.flags = 0;
+	depthStencilState.depthTestEnable = description.m_bDepthTest ? VK_TRUE : VK_FALSE;
+	depthStencilState.depthWriteEnable = description.m_bDepthWrite ? VK_TRUE : VK_FALSE;
+	depthStencilState.depthCompareOp = description.m_DepthCompareOp;
+	depthStencilState.depthBoundsTestEnable = VK_FALSE;
+	depthStencilState.stencilTestEnable = VK_FALSE;
+	depthStencilState.minDepthBounds = 0.0f;
+	depthStencilState.maxDepthBounds = 1.0f;
+
+	// Blending is the standard alpha blending.
+	VkPipelineColorBlendAttachmentState blendAttachment = {};
+	blendAttachment.blendEnable = description.m_bBlend ? VK_TRUE : VK_FALSE;
+	blendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+	blendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	blendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+	blendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	blendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	blendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+	blendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+	const auto blendAttachments = std::vector<VkPipelineColorBlendAttachmentState>(description.m_ColorFormats.size(), blendAttachment);
+
+	VkPipelineColorBlendStateCreateInfo colorBlendState = {};
+	colorBlendState.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	colorBlendState.pNext = nullptr;
+	colorBlendState.flags = 0;
+	colorBlendState.logicOpEnable = VK_FALSE;
+	colorBlendState.attachmentCount = static_cast<uint32_t>(blendAttachments.size());
+	colorBlendState.pAttachments = blendAttachments.data();
+
+	constexpr std::array<VkDynamicState, 2> dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+	VkPipelineDynamicStateCreateInfo dynamicState = {};
+	dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamicState.pNext = nullptr;
+	dynamicState.flags = 0;
+	dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+	dynamicState.pDynamicStates = dynamicStates.data();
+
+	// The engine does not use render passes, so the attachment formats are given directly.
+	VkPipelineRenderingCreateInfoKHR renderingCreateInfo = {};
+	renderingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+	renderingCreateInfo.pNext = nullptr;
+	renderingCreateInfo.viewMask = 0;
+	renderingCreateInfo.colorAttachmentCount = static_cast<uint32_t>(description.m_ColorFormats.size());
+	renderingCreateInfo.pColorAttachmentFormats = description.m_ColorFormats.data();
+	renderingCreateInfo.depthAttachmentFormat = description.m_DepthFormat;
+	renderingCreateInfo.stencilAttachmentFormat = HasStencil(description.m_DepthFormat) ? description.m_DepthFormat : VK_FORMAT_UNDEFINED;
+
+	VkGraphicsPipelineCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	createInfo.pNext = &renderingCreateInfo;
+	createInfo.flags = 0;
+	createInfo.stageCount = fragmentModule == VK_NULL_HANDLE ? 1 : 2;
+	createInfo.pStages = stages.data();
+	createInfo.pVertexInputState = &vertexInputState;
+	createInfo.pInputAssemblyState = &inputAssemblyState;
+	createInfo.pTessellationState = nullptr;
+	createInfo.pViewportState = &viewportState;
+	createInfo.pRasterizationState = &rasterizationState;
+	createInfo.pMultisampleState = &multisampleState;
+	createInfo.pDepthStencilState = &depthStencilState;
+	createInfo.pColorBlendState = &colorBlendState;
+	createInfo.pDynamicState = &dynamicState;
+	createInfo.layout = pipeline.m_PipelineLayout;
+	createInfo.renderPass = VK_NULL_HANDLE;
+	createInfo.subpass = 0;
+	createInfo.basePipelineHandle = VK_NULL_HANDLE;
+	createInfo.basePipelineIndex = -1;
+
+	const auto result = deviceTable.vkCreateGraphicsPipelines(logicalDevice, m_Instance.getPipelineCache(), 1, &createInfo, nullptr, &pipeline.m_Pipeline);
+	deviceTable.vkDestroyShaderModule(logicalDevice, vertexModule, nullptr);
+	deviceTable.vkDestroyShaderModule(logicalDevice, fragmentModule, nullptr);
+
+	if (result != VK_SUCCESS)
+	{
+		GRAPHITE_LOG_ERROR("Failed to create the graphics pipeline of {}!", description.m_VertexShader);
+		return false;
+	}
+
+	return true;
+}
+
+void PipelineManager::worker(std::stop_token stopToken)
+{
+	OPTICK_THREAD("Pipeline Compiler");
+	const auto tag = AllocationTracker::Scope(AllocationTag::Pipelines);
+
+	while (true)
+	{
+		ManagedPipeline* pPipeline = nullptr;
+		{
+			auto lock = std::unique_lock(m_QueueMutex);
+			if (!m_QueueCondition.wait(lock, stopToken, [this] { return !m_RequestQueue.empty() || !m_PrewarmQueue.empty(); }))
+				return;
+
+			auto& queue = m_RequestQueue.empty() ? m_PrewarmQueue : m_RequestQueue;
+			pPipeline = queue.front();
+			queue.pop_front();
+		}
+
+		// Another worker got it from the other queue.
+		if (pPipeline->m_bIsClaimed.exchange(true, std::memory_order_acq_rel))
+			continue;
+
+		bool bIsCompiled = false;
+		{
+			OPTICK_EVENT("Compile Pipeline");
+			bIsCompiled = compile(*pPipeline);
+		}
+
+		{
+			const auto lock = std::scoped_lock(m_WaitMutex);
+			pPipeline->m_State.store(bIsCompiled ? PipelineState::Ready : PipelineState::Failed, std::memory_order_release);
+		}
+
+		m_PendingCount.fetch_sub(1, std::memory_order_relaxed);
+		m_WaitCondition.notify_all();
+	}
+}
@@ -0,0 +1,271 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "InstanceBoundObject.hpp"
+
+#include "Core/PoolAllocator.hpp"
+#include "Core/ResourcePool.hpp"
+
+#include <volk.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Pipeline type enum.
+ */
+enum class PipelineType : uint8_t
+{
+	Compute,
+	Graphics
+};
+
+/**
+ * Pipeline state enum.
+ * This specifies how far the compilation of a pipeline is.
+ */
+enum class PipelineState : uint8_t
+{
+	Pending,
+	Ready,
+	Failed
+};
+
+/**
+ * Pipeline description structure.
+ * This describes everything needed to create a pipeline, so it can be recorded and created again in a later session.
+ *
+ * Graphics pipelines are created for dynamic rendering with the given attachment formats, and the viewport and the scissor are dynamic.
+ */
+struct PipelineDescription final
+{
+	using SetBindings = std::vector<VkDescriptorSetLayoutBinding>;
+
+	PipelineType m_Type = PipelineType::Compute;
+
+	// The compiled SPIR-V shaders. Compute pipelines only use the compute shader, and graphics pipelines use the vertex and the fragment shaders.
+	std::string m_ComputeShader;
+	std::string m_VertexShader;
+	std::string m_FragmentShader;
+
+	// The bindings of each descriptor set. Immutable samplers are not supported.
+	std::vector<SetBindings> m_SetBindings;
+	uint32_t m_PushConstantSize = 0;
+
+	std::vector<VkVertexInputBindingDescription> m_VertexBindings;
+	std::vector<VkVertexInputAttributeDescription> m_VertexAttributes;
+	std::vector<VkFormat> m_ColorFormats;
+	VkFormat m_DepthFormat = VK_FORMAT_UNDEFINED;
+
+	VkPrimitiveTopology m_Topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	VkCullModeFlags m_CullMode = VK_CULL_MODE_BACK_BIT;
+	VkFrontFace m_FrontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	VkCompareOp m_DepthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+	bool m_bDepthTest = true;
+	bool m_bDepthWrite = true;
+	bool m_bBlend = false;
+};
+
+/**
+ * Managed pipeline structure.
+ * The layout is created when the pipeline is requested, and the pipeline itself on a worker. The pipeline is only valid once the state is ready.
+ */
+struct ManagedPipeline final : public PoolAllocated<ManagedPipeline>
+{
+	PipelineDescription m_Description;
+	std::vector<VkDescriptorSetLayout> m_DescriptorSetLayouts;
+	VkPipelineLayout m_PipelineLayout = VK_NULL_HANDLE;
+	VkPipeline m_Pipeline = VK_NULL_HANDLE;
+
+	ResourceHandle<ManagedPipeline> m_Fallback;
+	std::atomic<PipelineState> m_State = PipelineState::Pending;
+
+	// Set by the worker which compiles the pipeline. A pre-warmed pipeline which gets requested is in both queues, but only compiled once.
+	std::atomic_bool m_bIsClaimed = false;
+};
+
+using PipelineHandle = ResourceHandle<ManagedPipeline>;
+
+/**
+ * Pipeline manager class.
+ * This compiles the pipelines on background workers so creating them never blocks the frame. Requesting a pipeline returns a handle right away,
+ * and binding it before it's ready binds it's fallback instead, or nothing, in which case the caller skips the work. Identical descriptions share
+ * a single pipeline.
+ *
+ * The descriptions of the requested pipelines are recorded to a list file, and the pipelines of the previous sessions are compiled from it in the
+ * background when the manager is created, so they're usually ready before they're first needed. The requests always go before this pre-warming.
+ *
+ * Requesting and binding are not thread safe and should be done from the render thread.
+ */
+class PipelineManager final : public InstanceBoundObject
+{
+public:
+	/**
+	 * Explicit constructor.
+	 * This starts pre-warming the pipelines recorded in the list file.
+	 *
+	 * @param instance The instance reference. The device must be created.
+	 * @param listPath The file to load the recorded pipelines from and to store them to. Default is PipelineList.bin.
+	 * @param workerCount The number of compile workers. Default is 0, which uses half of the hardware threads.
+	 */
+	explicit PipelineManager(Instance& instance, std::filesystem::path listPath = "PipelineList.bin", uint32_t workerCount = 0);
+
+	/**
+	 * Destructor.
+	 * This stores the recorded pipelines to the list file. The pipelines still in the queue are not compiled.
+	 */
+	~PipelineManager() override;
+
+	/**
+	 * Request a pipeline.
+	 * If the same description was requested or pre-warmed before, the existing pipeline is returned.
+	 *
+	 * @param description The pipeline description.
+	 * @param fallback The pipeline to bind while this one is compiling. It must have a compatible layout. Default is none.
+	 * @return The pipeline handle.
+	 */
+	[[nodiscard]] PipelineHandle request(const PipelineDescription& description, PipelineHandle fallback = {});
+
+	/**
+	 * Get the pipeline which should be used for a handle right now.
+	 * This is the pipeline itself if it's ready, otherwise it's fallback if that is.
+	 *
+	 * @param handle The pipeline handle.
+	 * @return The pipeline pointer. This is null if neither is ready.
+	 */
+	[[nodiscard]] const ManagedPipeline* resolve(PipelineHandle handle) const;
+
+	/**
+	 * Bind a pipeline, or it's fallback if it's not ready.
+	 *
+	 * @param commandBuffer The command buffer to record to.
+	 * @param handle The pipeline handle.
+	 * @return False if nothing was bound, and the work using the pipeline should be skipped.
+	 */
+	bool bind(VkCommandBuffer commandBuffer, PipelineHandle handle) const;
+
+	/**
+	 * Get the state of a pipeline.
+	 *
+	 * @param handle The pipeline handle.
+	 * @return The state. Invalid handles are failed.
+	 */
+	[[nodiscard]] PipelineState getState(PipelineHandle handle) const;
+
+	/**
+	 * Wait till a pipeline is compiled.
+	 * Use this only where the pipeline is needed right away, like during loading.
+	 *
+	 * @param handle The pipeline handle.
+	 * @return True if the pipeline is ready.
+	 */
+	bool wait(PipelineHandle handle);
+
+	/**
+	 * Store the recorded pipelines to the list file.
+	 */
+	void saveList() const;
+
+public:
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, PipelineCount, static_cast<uint32_t>(m_Pipelines.size()));
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, PendingCount, m_PendingCount.load(std::memory_order_relaxed));
+
+private:
+	/**
+	 * Get the pipeline of a handle.
+	 *
+	 * @param handle The pipeline handle.
+	 * @return The pipeline pointer. This is null if the handle is invalid.
+	 */
+	[[nodiscard]] ManagedPipeline* get(PipelineHandle handle) const;
+
+	/**
+	 * Get the pipeline of a description, creating it if needed.
+	 *
+	 * @param key The serialized description.
+	 * @param description The pipeline description.
+	 * @param bIsPrewarm Whether the pipeline is only pre-warmed. Pre-warmed pipelines are compiled after the requested ones.
+	 * @return The pipeline handle. This is null if the layout could not be created.
+	 */
+	[[nodiscard]] PipelineHandle getOrCreate(std::string key, const PipelineDescription& description, bool bIsPrewarm);
+
+	/**
+	 * Move a pipeline to the request queue if no worker has picked it up yet.
+	 *
+	 * @param pipeline The pipeline.
+	 */
+	void prioritize(ManagedPipeline& pipeline);
+
+	/**
+	 * Load the recorded pipelines from the list file and queue them for pre-warming.
+	 */
+	void loadList();
+
+	/**
+	 * Create the descriptor set layouts and the pipeline layout of a pipeline.
+	 *
+	 * @param pipeline The pipeline.
+	 * @return True if the layout was created.
+	 */
+	bool createLayout(ManagedPipeline& pipeline);
+
+	/**
+	 * Compile a pipeline.
+	 * This is called from the workers.
+	 *
+	 * @param pipeline The pipeline.
+	 * @return True if the pipeline was created.
+	 */
+	bool compile(ManagedPipeline& pipeline) const;
+
+	/**
+	 * Compile a compute pipeline.
+	 *
+	 * @param pipeline The pipeline.
+	 * @return True if the pipeline was created.
+	 */
+	bool compileCompute(ManagedPipeline& pipeline) const;
+
+	/**
+	 * Compile a graphics pipeline.
+	 *
+	 * @param pipeline The pipeline.
+	 * @return True if the pipeline was created.
+	 */
+	bool compileGraphics(ManagedPipeline& pipeline) const;
+
+	/**
+	 * The compile worker function.
+	 *
+	 * @param stopToken The stop token.
+	 */
+	void worker(std::stop_token stopToken);
+
+private:
+	std::vector<std::unique_ptr<ManagedPipeline>> m_Pipelines;
+	std::unordered_map<std::string, PipelineHandle> m_PipelineMap;
+
+	std::filesystem::path m_ListPath;
+
+	std::deque<ManagedPipeline*> m_RequestQueue;
+	std::deque<ManagedPipeline*> m_PrewarmQueue;
+	std::mutex m_QueueMutex;
+	std::condition_variable_any m_QueueCondition;
+
+	std::mutex m_WaitMutex;
+	std::condition_variable m_WaitCondition;
+
+	std::atomic_uint32_t m_PendingCount = 0;
+
+	std::vector<std::jthread> m_Workers;
+};
@@ -0,0 +1,31 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "Platform.hpp"
+
+#include "Core/Logging.hpp"
+#include "Core/StartupTrace.hpp"
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_vulkan.h>
+
+#include <optick.h>
+
+Platform::Platform()
+{
+	OPTICK_EVENT();
+	GRAPHITE_STARTUP_PHASE("SDL initialization");
+
+	// Try and initialize SDL.
+	if (SDL_Init(SDL_INIT_VIDEO) != 0)
+		GRAPHITE_LOG_FATAL("Failed to initialize SDL! {}", SDL_GetError());
+
+	else
+		GRAPHITE_LOG_INFORMATION("Successfully initialized SDL.");
+}
+
+Platform::~Platform()
+{
+	// Unload the Vulkan library and quit SDL.
+	SDL_Vulkan_UnloadLibrary();
+	SDL_Quit();
+}
@@ -0,0 +1,26 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "Core/Common.hpp"
+
+/**
+ * Platform class.
+ * This initializes the platform layer (SDL) and shuts it down when destroyed. This must be constructed before the instance and the windows, and
+ * it's done explicitly instead of in a static initializer so the startup trace can measure it.
+ */
+class Platform final
+{
+public:
+	/**
+	 * Default constructor.
+	 */
+	Platform();
+
+	/**
+	 * Destructor.
+	 */
+	~Platform();
+
+	GRAPHITE_DISABLE_COPY_AND_MOVE(Platform);
+};
@@ -0,0 +1,108 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "ResourceStore.hpp"
+#include "Instance.hpp"
+
+#include "Core/Logging.hpp"
+
+ResourceStore::~ResourceStore()
+{
+	clear();
+}
+
+BufferHandle ResourceStore::createBuffer(uint64_t size, VkBufferUsageFlags usage)
+{
+	// Create the buffer first so the pool is not locked while allocating.
+	const auto data = Buffer::Allocate(m_Instance, size, usage);
+	const auto handle = m_Buffers.access([&data](ResourcePool<BufferData>& pool) { return pool.create(data); });
+
+	if (!handle)
+	{
+		GRAPHITE_LOG_ERROR("The buffer pool is full!");
+		m_Instance.getDeletionQueue().retire(data.m_Buffer, data.m_Allocation);
+	}
+
+	return handle;
+}
+
+ImageHandle ResourceStore::createImage(const ImageBuilder& builder, VkFormat format)
+{
+	// Create the image first so the pool is not locked while allocating.
+	const auto data = Image::Allocate(m_Instance, builder, format);
+	const auto handle = m_Images.access([&data](ResourcePool<ImageData>& pool) { return pool.create(data); });
+
+	if (!handle)
+	{
+		GRAPHITE_LOG_ERROR("The image pool is full!");
+		m_Instance.getDeletionQueue().retire(data.m_Image, data.m_Allocation);
+	}
+
+	return handle;
+}
+
+void ResourceStore::destroy(BufferHandle handle)
+{
+	m_Buffers.access([this, handle](ResourcePool<BufferData>& pool)
+		{
+			if (const auto pData = pool.get(handle))
+			{
+				m_Instance.getDeletionQueue().retire(pData->m_Buffer, pData->m_Allocation);
+				pool.destroy(handle);
+			}
+		}
+	);
+}
+
+void ResourceStore::destroy(ImageHandle handle)
+{
+	m_Images.access([this, handle](ResourcePool<ImageData>& pool)
+		{
+			if (const auto pData = pool.get(handle))
+			{
+				m_Instance.getDeletionQueue().retire(pData->m_Image, pData->m_Allocation);
+				pool.destroy(handle);
+			}
+		}
+	);
+}
+
+BufferData ResourceStore::getBuffer(BufferHandle handle)
+{
+	return m_Buffers.access([handle](const ResourcePool<BufferData>& pool)
+		{
+			const auto pData = pool.get(handle);
+			return pData ? *pData : BufferData();
+		}
+	);
+}
+
+ImageData ResourceStore::getImage(ImageHandle handle)
+{
+	return m_Images.access([handle](const ResourcePool<ImageData>& pool)
+		{
+			const auto pData = pool.get(handle);
+			return pData ? *pData : ImageData();
+		}
+	);
+}
+
+void ResourceStore::clear()
+{
+	m_Buffers.access([this](ResourcePool<BufferData>& pool)
+		{
+			for (const auto& data : pool)
+				m_Instance.getDeletionQueue().retire(data.m_Buffer, data.m_Allocation);
+
+			pool = ResourcePool<BufferData>();
+		}
+	);
+
+	m_Images.access([this](ResourcePool<ImageData>& pool)
+		{
+			for (const auto& data : pool)
+				m_Instance.getDeletionQueue().retire(data.m_Image, data.m_Allocation);
+
+			pool = ResourcePool<ImageData>();
+		}
+	);
+}
@@ -0,0 +1,102 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "Buffer.hpp"
+#include "Image.hpp"
+
+#include "Core/Guarded.hpp"
+#include "Core/ResourcePool.hpp"
+
+using BufferHandle = ResourceHandle<BufferData>;
+using ImageHandle = ResourceHandle<ImageData>;
+
+/**
+ * Resource store class.
+ * This stores the buffers and images of the engine in dense pools and refers to them using generational handles, so there is no per-resource
+ * heap allocation and the systems walking all the resources (like barrier generation) touch contiguous memory.
+ *
+ * Destroyed resources are retired to the instance's deletion queue, so a handle can be destroyed while the GPU is still using the resource.
+ */
+class ResourceStore final : public InstanceBoundObject
+{
+public:
+	/**
+	 * Explicit constructor.
+	 *
+	 * @param instance The instance reference.
+	 */
+	explicit ResourceStore(Instance& instance) : InstanceBoundObject(instance) {}
+
+	/**
+	 * Destructor.
+	 */
+	~ResourceStore() override;
+
+	/**
+	 * Create a new buffer.
+	 * This is thread safe.
+	 *
+	 * @param size The size of the buffer.
+	 * @param usage The buffer usage.
+	 * @return The buffer handle.
+	 */
+	[[nodiscard]] BufferHandle createBuffer(uint64_t size, VkBufferUsageFlags usage);
+
+	/**
+	 * Create a new image.
+	 * This is thread safe.
+	 *
+	 * @param builder The image builder structure.
+	 * @param format The image format to use.
+	 * @return The image handle.
+	 */
+	[[nodiscard]] ImageHandle createImage(const ImageBuilder& builder, VkFormat format);
+
+	/**
+	 * Destroy a buffer.
+	 * This is thread safe.
+	 *
+	 * @param handle The buffer handle.
+	 */
+	void destroy(BufferHandle handle);
+
+	/**
+	 * Destroy an image.
+	 * This is thread safe.
+	 *
+	 * @param handle The image handle.
+	 */
+	void destroy(ImageHandle handle);
+
+	/**
+	 * Get the data of a buffer.
+	 * This is thread safe.
+	 *
+	 * @param handle The buffer handle.
+	 * @return The buffer data. The handles are null if the buffer handle is invalid.
+	 */
+	[[nodiscard]] BufferData getBuffer(BufferHandle handle);
+
+	/**
+	 * Get the data of an image.
+	 * This is thread safe.
+	 *
+	 * @param handle The image handle.
+	 * @return The image data. The handles are null if the image handle is invalid.
+	 */
+	[[nodiscard]] ImageData getImage(ImageHandle handle);
+
+	/**
+	 * Destroy all the resources.
+	 */
+	void clear();
+
+public:
+	GRAPHITE_SETUP_GETTERS(Guarded<ResourcePool<BufferData>>, Buffers, m_Buffers);
+	GRAPHITE_SETUP_GETTERS(Guarded<ResourcePool<ImageData>>, Images, m_Images);
+
+private:
+	Guarded<ResourcePool<BufferData>> m_Buffers;
+	Guarded<ResourcePool<ImageData>> m_Images;
+};
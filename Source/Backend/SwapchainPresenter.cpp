@@ -0,0 +1,247 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "SwapchainPresenter.hpp"
+#include "VulkanMacros.hpp"
+
+#include <optick.h>
+
+#include <algorithm>
+
+namespace /* anonymous */
+{
+	/**
+	 * Create a binary semaphore.
+	 *
+	 * @param instance The instance reference.
+	 * @return The semaphore handle.
+	 */
+	[[nodiscard]] VkSemaphore CreateBinarySemaphore(Instance& instance)
+	{
+		VkSemaphoreCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		createInfo.pNext = nullptr;
+		createInfo.flags = 0;
+
+		VkSemaphore semaphore = VK_NULL_HANDLE;
+		instance.getLogicalDevice().access([&instance, &createInfo, &semaphore](VkDevice logicalDevice)
+			{
+				GRAPHITE_VK_ASSERT(instance.getDeviceTable().vkCreateSemaphore(logicalDevice, &createInfo, nullptr, &semaphore), "Failed to create the swapchain semaphore!");
+			}
+		);
+
+		return semaphore;
+	}
+
+	/**
+	 * Create an image barrier for a swapchain image.
+	 *
+	 * @param image The swapchain image.
+	 * @param srcStageMask The stages which must be done.
+	 * @param srcAccessMask The accesses which must be made available.
+	 * @param dstStageMask The stages which wait.
+	 * @param dstAccessMask The accesses which wait.
+	 * @param oldLayout The current layout.
+	 * @param newLayout The new layout.
+	 * @return The barrier.
+	 */
+	[[nodiscard]] VkImageMemoryBarrier2KHR CreateImageBarrier(
+		VkImage image,
+		VkPipelineStageFlags2KHR srcStageMask,
+		VkAccessFlags2KHR srcAccessMask,
+		VkPipelineStageFlags2KHR dstStageMask,
+		VkAccessFlags2KHR dstAccessMask,
+		VkImageLayout oldLayout,
+		VkImageLayout newLayout)
+	{
+		VkImageMemoryBarrier2KHR barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+		barrier.pNext = nullptr;
+		barrier.srcStageMask = srcStageMask;
+		barrier.srcAccessMask = srcAccessMask;
+		barrier.dstStageMask = dstStageMask;
+		barrier.dstAccessMask = dstAccessMask;
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = newLayout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange = VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+		return barrier;
+	}
+
+	/**
+	 * Record an image barrier.
+	 *
+	 * @param deviceTable The device table.
+	 * @param commandBuffer The command buffer to record to.
+	 * @param barrier The barrier.
+	 */
+	void RecordImageBarrier(const VolkDeviceTable& deviceTable, VkCommandBuffer commandBuffer, const VkImageMemoryBarrier2KHR& barrier)
+	{
+		VkDependencyInfoKHR dependencyInfo = {};
+		dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+		dependencyInfo.pNext = nullptr;
+		dependencyInfo.dependencyFlags = 0;
+		dependencyInfo.memoryBarrierCount = 0;
+		dependencyInfo.pMemoryBarriers = nullptr;
+		dependencyInfo.bufferMemoryBarrierCount = 0;
+		dependencyInfo.pBufferMemoryBarriers = nullptr;
+		dependencyInfo.imageMemoryBarrierCount = 1;
+		dependencyInfo.pImageMemoryBarriers = &barrier;
+
+		deviceTable.vkCmdPipelineBarrier2KHR(commandBuffer, &dependencyInfo);
+	}
+}
+
+SwapchainPresenter::SwapchainPresenter(Instance& instance, Window& window, CommandSubmissionQueue& submissionQueue, uint32_t framesInFlight /*= 2*/)
+	: InstanceBoundObject(instance)
+	, m_Slots(std::max(framesInFlight, 1u))
+	, m_Window(window)
+	, m_SubmissionQueue(submissionQueue)
+{
+	// The command buffers are recorded every frame, so they're reset one by one.
+	VkCommandPoolCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	createInfo.pNext = nullptr;
+	createInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	createInfo.queueFamilyIndex = m_Instance.getGraphicsQueue().getUnsafe().m_Family;
+
+	std::vector<VkCommandBuffer> commandBuffers(m_Slots.size());
+	m_Instance.getLogicalDevice().access([this, &createInfo, &commandBuffers](VkDevice logicalDevice)
+		{
+			const auto& deviceTable = m_Instance.getDeviceTable();
+			GRAPHITE_VK_ASSERT(deviceTable.vkCreateCommandPool(logicalDevice, &createInfo, nullptr, &m_CommandPool), "Failed to create the swapchain presenter command pool!");
+
+			VkCommandBufferAllocateInfo allocateInfo = {};
+			allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocateInfo.pNext = nullptr;
+			allocateInfo.commandPool = m_CommandPool;
+			allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocateInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+
+			GRAPHITE_VK_ASSERT(deviceTable.vkAllocateCommandBuffers(logicalDevice, &allocateInfo, commandBuffers.data()), "Failed to allocate the swapchain presenter command buffers!");
+		}
+	);
+
+	for (size_t i = 0; i < m_Slots.size(); i++)
+	{
+		m_Slots[i].m_CommandBuffer = commandBuffers[i];
+		m_Slots[i].m_AcquireSemaphore = CreateBinarySemaphore(m_Instance);
+	}
+
+	createPresentSemaphores();
+}
+
+SwapchainPresenter::~SwapchainPresenter()
+{
+	// Make sure the frames in flight are done with the semaphores and the command buffers.
+	m_SubmissionQueue.flush();
+	for (const auto& slot : m_Slots)
+		m_SubmissionQueue.wait(QueueType::Graphics, slot.m_TimelineValue);
+
+	// The last presents might still wait on the present semaphores, so they're released with the rest of the frame.
+	m_Instance.getDeletionQueue().retire([&deviceTable = m_Instance.getDeviceTable(), semaphores = std::move(m_PresentSemaphores)](VkDevice logicalDevice)
+		{
+			for (const auto semaphore : semaphores)
+				deviceTable.vkDestroySemaphore(logicalDevice, semaphore, nullptr);
+		}
+	);
+
+	m_Instance.getLogicalDevice().access([this](VkDevice logicalDevice)
+		{
+			for (const auto& slot : m_Slots)
+				m_Instance.getDeviceTable().vkDestroySemaphore(logicalDevice, slot.m_AcquireSemaphore, nullptr);
+
+			m_Instance.getDeviceTable().vkDestroyCommandPool(logicalDevice, m_CommandPool, nullptr);
+		}
+	);
+}
+
+bool SwapchainPresenter::enqueueFrame(uint32_t& imageIndex)
+{
+	OPTICK_EVENT();
+
+	// The window recreates the swapchain when it's updated, and the new one might have a different number of images.
+	if (m_Window.getSwapchain() != m_Swapchain)
+		createPresentSemaphores();
+
+	// The slot's acquire semaphore and command buffer can only be reused once it's previous frame is done.
+	auto& slot = m_Slots[m_NextSlot];
+	m_SubmissionQueue.wait(QueueType::Graphics, slot.m_TimelineValue);
+
+	if (!m_Window.acquireNextImage(slot.m_AcquireSemaphore, imageIndex))
+		return false;
+
+	GRAPHITE_VK_ASSERT(m_Instance.getDeviceTable().vkResetCommandBuffer(slot.m_CommandBuffer, 0), "Failed to reset the swapchain presenter command buffer!");
+	recordClear(slot.m_CommandBuffer, m_Window.getSwapchainImages()[imageIndex]);
+
+	// The image is only written by the clear, so that's the only stage which has to wait for the acquire.
+	VkSemaphoreSubmitInfoKHR waitInfo = {};
+	waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO_KHR;
+	waitInfo.pNext = nullptr;
+	waitInfo.semaphore = slot.m_AcquireSemaphore;
+	waitInfo.value = 0;
+	waitInfo.stageMask = VK_PIPELINE_STAGE_2_CLEAR_BIT_KHR;
+	waitInfo.deviceIndex = 0;
+
+	VkSemaphoreSubmitInfoKHR signalInfo = {};
+	signalInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO_KHR;
+	signalInfo.pNext = nullptr;
+	signalInfo.semaphore = m_PresentSemaphores[imageIndex];
+	signalInfo.value = 0;
+	signalInfo.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT_KHR;
+	signalInfo.deviceIndex = 0;
+
+	slot.m_TimelineValue = m_SubmissionQueue.enqueue(QueueType::Graphics, std::span<const VkCommandBuffer>(&slot.m_CommandBuffer, 1), {}, std::span(&waitInfo, 1), std::span(&signalInfo, 1));
+	m_NextSlot = (m_NextSlot + 1) % static_cast<uint32_t>(m_Slots.size());
+
+	return true;
+}
+
+void SwapchainPresenter::createPresentSemaphores()
+{
+	if (!m_PresentSemaphores.empty())
+	{
+		m_Instance.getDeletionQueue().retire([&deviceTable = m_Instance.getDeviceTable(), semaphores = std::move(m_PresentSemaphores)](VkDevice logicalDevice)
+			{
+				for (const auto semaphore : semaphores)
+					deviceTable.vkDestroySemaphore(logicalDevice, semaphore, nullptr);
+			}
+		);
+	}
+
+	m_Swapchain = m_Window.getSwapchain();
+	m_PresentSemaphores.resize(m_Window.getSwapchainImages().size());
+	for (auto& semaphore : m_PresentSemaphores)
+		semaphore = CreateBinarySemaphore(m_Instance);
+}
+
+void SwapchainPresenter::recordClear(VkCommandBuffer commandBuffer, VkImage image) const
+{
+	const auto& deviceTable = m_Instance.getDeviceTable();
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.pNext = nullptr;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	beginInfo.pInheritanceInfo = nullptr;
+
+	GRAPHITE_VK_ASSERT(deviceTable.vkBeginCommandBuffer(commandBuffer, &beginInfo), "Failed to begin the swapchain presenter command buffer!");
+
+	// The acquire semaphore is waited at the clear stage, so using it as the source stage orders the layout change after the wait.
+	RecordImageBarrier(deviceTable, commandBuffer, CreateImageBarrier(image,
+		VK_PIPELINE_STAGE_2_CLEAR_BIT_KHR, VK_ACCESS_2_NONE_KHR,
+		VK_PIPELINE_STAGE_2_CLEAR_BIT_KHR, VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR,
+		VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL));
+
+	const auto range = VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+	deviceTable.vkCmdClearColorImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &m_ClearColor, 1, &range);
+
+	RecordImageBarrier(deviceTable, commandBuffer, CreateImageBarrier(image,
+		VK_PIPELINE_STAGE_2_CLEAR_BIT_KHR, VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR,
+		VK_PIPELINE_STAGE_2_NONE_KHR, VK_ACCESS_2_NONE_KHR,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR));
+
+	GRAPHITE_VK_ASSERT(deviceTable.vkEndCommandBuffer(commandBuffer), "Failed to end the swapchain presenter command buffer!");
+}
@@ -0,0 +1,101 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "CommandSubmissionQueue.hpp"
+#include "Window.hpp"
+
+#include <vector>
+
+/**
+ * Swapchain presenter class.
+ * This acquires a swapchain image every frame and enqueues the work which makes it presentable, so the window is presented from the main loop.
+ * Nothing renders to the swapchain yet, so the image is cleared to the clear color.
+ *
+ * Each frame in flight has it's own acquire semaphore and command buffer, which are reused once the frame's timeline value is reached. The present
+ * semaphores are per swapchain image, since a present is only known to have waited on it's semaphore once the same image is acquired again.
+ */
+class SwapchainPresenter final : public InstanceBoundObject
+{
+	/**
+	 * Frame slot structure.
+	 * This contains the objects of a single frame in flight.
+	 */
+	struct FrameSlot final
+	{
+		VkCommandBuffer m_CommandBuffer = VK_NULL_HANDLE;
+		VkSemaphore m_AcquireSemaphore = VK_NULL_HANDLE;
+
+		uint64_t m_TimelineValue = 0;
+	};
+
+public:
+	/**
+	 * Explicit constructor.
+	 *
+	 * @param instance The instance reference.
+	 * @param window The window to present to.
+	 * @param submissionQueue The submission queue to enqueue the frame's work to.
+	 * @param framesInFlight The number of frames which can be in flight at once. Default is 2.
+	 */
+	explicit SwapchainPresenter(Instance& instance, Window& window, CommandSubmissionQueue& submissionQueue, uint32_t framesInFlight = 2);
+
+	/**
+	 * Destructor.
+	 * This waits till the frames in flight are done.
+	 */
+	~SwapchainPresenter() override;
+
+	/**
+	 * Acquire the next swapchain image and enqueue the work which makes it presentable.
+	 * This should be called before flushing the submission queue. The image must then be presented with the present semaphore after the flush.
+	 *
+	 * @param imageIndex The variable to store the acquired image index.
+	 * @return True if an image was acquired. The frame should not be presented otherwise.
+	 */
+	[[nodiscard]] bool enqueueFrame(uint32_t& imageIndex);
+
+	/**
+	 * Get the semaphore which is signaled once an image is ready to be presented.
+	 *
+	 * @param imageIndex The image index.
+	 * @return The semaphore handle.
+	 */
+	[[nodiscard]] VkSemaphore getPresentSemaphore(uint32_t imageIndex) const { return m_PresentSemaphores[imageIndex]; }
+
+	/**
+	 * Set the color the swapchain images are cleared to.
+	 *
+	 * @param color The color.
+	 */
+	void setClearColor(const VkClearColorValue& color) { m_ClearColor = color; }
+
+private:
+	/**
+	 * Create the present semaphores of the window's current swapchain.
+	 * The semaphores of the previous swapchain are retired, since it's last presents might still be waiting on them.
+	 */
+	void createPresentSemaphores();
+
+	/**
+	 * Record the work which clears a swapchain image and transitions it to the present layout.
+	 *
+	 * @param commandBuffer The command buffer to record to.
+	 * @param image The swapchain image.
+	 */
+	void recordClear(VkCommandBuffer commandBuffer, VkImage image) const;
+
+private:
+	std::vector<FrameSlot> m_Slots;
+	std::vector<VkSemaphore> m_PresentSemaphores;
+
+	Window& m_Window;
+	CommandSubmissionQueue& m_SubmissionQueue;
+
+	VkCommandPool m_CommandPool = VK_NULL_HANDLE;
+	VkSwapchainKHR m_Swapchain = VK_NULL_HANDLE;
+
+	VkClearColorValue m_ClearColor = {};
+
+	uint32_t m_NextSlot = 0;
+};
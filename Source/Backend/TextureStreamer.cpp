@@ -0,0 +1,611 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "TextureStreamer.hpp"
+#include "VulkanMacros.hpp"
+
+#include <optick.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace /* anonymous */
+{
+	/**
+	 * Get the extent of a mip.
+	 *
+	 * @param source The texture source.
+	 * @param mip The mip index.
+	 * @return The mip extent.
+	 */
+	[[nodiscard]] VkExtent3D GetMipExtent(const TextureSource& source, uint32_t mip)
+	{
+		return VkExtent3D{ std::max(source.m_Width >> mip, 1u), std::max(source.m_Height >> mip, 1u), 1 };
+	}
+
+	/**
+	 * Get the subresource range of all the mips of an image.
+	 *
+	 * @param image The image data.
+	 * @return The subresource range.
+	 */
+	[[nodiscard]] VkImageSubresourceRange GetSubresourceRange(const ImageData& image)
+	{
+		return VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, image.m_MipLevels, 0, 1 };
+	}
+
+	/**
+	 * Create an image memory barrier.
+	 *
+	 * @param image The image data.
+	 * @param oldLayout The old image layout.
+	 * @param newLayout The new image layout.
+	 * @param srcStageMask The source stage mask.
+	 * @param srcAccessMask The source access mask.
+	 * @param dstStageMask The destination stage mask.
+	 * @param dstAccessMask The destination access mask.
+	 * @return The barrier.
+	 */
+	[[nodiscard]] VkImageMemoryBarrier2KHR CreateImageBarrier(
+		const ImageData& image,
+		VkImageLayout oldLayout,
+		VkImageLayout newLayout,
+		VkPipelineStageFlags2KHR srcStageMask,
+		VkAccessFlags2KHR srcAccessMask,
+		VkPipelineStageFlags2KHR dstStageMask,
+		VkAccessFlags2KHR dstAccessMask)
+	{
+		VkImageMemoryBarrier2KHR barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+		barrier.pNext = nullptr;
+		barrier.srcStageMask = srcStageMask;
+		barrier.srcAccessMask = srcAccessMask;
+		barrier.dstStageMask = dstStageMask;
+		barrier.dstAccessMask = dstAccessMask;
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = newLayout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image.m_Image;
+		barrier.subresourceRange = GetSubresourceRange(image);
+
+		return barrier;
+	}
+}
+
+TextureStreamer::TextureStreamer(Instance& instance, CommandSubmissionQueue& submissionQueue, uint32_t maximumTextures /*= 16384*/)
+	: InstanceBoundObject(instance)
+	, m_pCoverage(std::make_unique<std::atomic_uint32_t[]>(maximumTextures))
+	, m_SubmissionQueue(submissionQueue)
+	, m_MaximumTextures(maximumTextures)
+{
+	m_Textures.reserve(maximumTextures);
+
+	// Create the command pool for the transfer queue.
+	VkCommandPoolCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	createInfo.pNext = nullptr;
+	createInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	createInfo.queueFamilyIndex = m_Instance.getTransferQueue().getUnsafe().m_Family;
+
+	m_Instance.getLogicalDevice().access([this, &createInfo](VkDevice logicalDevice)
+		{
+			GRAPHITE_VK_ASSERT(m_Instance.getDeviceTable().vkCreateCommandPool(logicalDevice, &createInfo, nullptr, &m_CommandPool), "Failed to create the texture streamer command pool!");
+		}
+	);
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	// Make sure the uploads in flight are done before destroying the command pool.
+	if (!m_UploadBatches.empty())
+	{
+		m_SubmissionQueue.flush();
+		m_SubmissionQueue.wait(QueueType::Transfer, m_UploadBatches.back().m_TimelineValue);
+	}
+
+	completeUploads();
+
+	for (const auto& texture : m_Textures)
+		retire(texture.m_Image, texture.m_View);
+
+	m_Instance.getLogicalDevice().access([this](VkDevice logicalDevice)
+		{
+			m_Instance.getDeviceTable().vkDestroyCommandPool(logicalDevice, m_CommandPool, nullptr);
+		}
+	);
+}
+
+TextureHandle TextureStreamer::registerTexture(TextureSource source)
+{
+	if (source.m_MipSizes.empty() || !source.m_LoadMip)
+	{
+		GRAPHITE_LOG_ERROR("Cannot register a texture without any mips or a loader!");
+		return TextureHandle();
+	}
+
+	StreamedTexture texture;
+	texture.m_MipCount = static_cast<uint32_t>(source.m_MipSizes.size());
+	texture.m_ResidentMip = texture.m_MipCount;
+	texture.m_PendingMip = texture.m_MipCount;
+
+	// The tail starts at the first mip which fits in the tail size.
+	while (texture.m_TailMip + 1 < texture.m_MipCount && std::max(source.m_Width >> texture.m_TailMip, source.m_Height >> texture.m_TailMip) > m_TailSize)
+		texture.m_TailMip++;
+
+	texture.m_DesiredMip = texture.m_TailMip;
+	texture.m_LastSeenFrame = m_FrameIndex;
+	texture.m_Source = std::move(source);
+
+	const auto handle = m_Textures.create(std::move(texture));
+	if (!handle || handle.getIndex() >= m_MaximumTextures)
+	{
+		GRAPHITE_LOG_ERROR("Cannot register more than {} textures!", m_MaximumTextures);
+		m_Textures.destroy(handle);
+		return TextureHandle();
+	}
+
+	m_pCoverage[handle.getIndex()].store(0, std::memory_order_relaxed);
+	return handle;
+}
+
+void TextureStreamer::unregisterTexture(TextureHandle handle)
+{
+	const auto pTexture = m_Textures.get(handle);
+	if (!pTexture)
+		return;
+
+	// If an upload is in flight, it's new image is retired when the upload completes.
+	m_ResidentSize -= GetMipRangeSize(*pTexture, pTexture->m_ResidentMip, pTexture->m_MipCount);
+	retire(pTexture->m_Image, pTexture->m_View);
+	m_Textures.destroy(handle);
+}
+
+void TextureStreamer::reportCoverage(TextureHandle handle, float pixels)
+{
+	const auto index = handle.getIndex();
+	if (index >= m_MaximumTextures)
+		return;
+
+	// Atomic max, since multiple culling threads might report the same texture.
+	auto& coverage = m_pCoverage[index];
+	const auto value = static_cast<uint32_t>(std::ceil(std::max(pixels, 0.0f)));
+	auto current = coverage.load(std::memory_order_relaxed);
+	while (current < value && !coverage.compare_exchange_weak(current, value, std::memory_order_relaxed));
+}
+
+void TextureStreamer::update(MemoryArena& frameArena)
+{
+	OPTICK_EVENT();
+
+	m_FrameIndex++;
+
+	completeUploads();
+	updateDesiredMips();
+	scheduleUploads(frameArena);
+}
+
+VkImageView TextureStreamer::getView(TextureHandle handle) const
+{
+	const auto pTexture = m_Textures.get(handle);
+	return pTexture ? pTexture->m_View : VK_NULL_HANDLE;
+}
+
+uint32_t TextureStreamer::getResidentMip(TextureHandle handle) const
+{
+	const auto pTexture = m_Textures.get(handle);
+	return pTexture ? pTexture->m_ResidentMip : 0;
+}
+
+void TextureStreamer::completeUploads()
+{
+	OPTICK_EVENT();
+
+	if (m_UploadBatches.empty())
+		return;
+
+	const auto completedValue = m_SubmissionQueue.getCompletedValue(QueueType::Transfer);
+	while (!m_UploadBatches.empty() && m_UploadBatches.front().m_TimelineValue <= completedValue)
+	{
+		auto& batch = m_UploadBatches.front();
+		for (const auto& upload : batch.m_Uploads)
+		{
+			const auto pTexture = m_Textures.get(upload.m_Texture);
+
+			// The texture was unregistered while uploading.
+			if (!pTexture)
+			{
+				retire(upload.m_Image, upload.m_View);
+				continue;
+			}
+
+			// Swap in the new image.
+			m_ResidentSize -= GetMipRangeSize(*pTexture, pTexture->m_ResidentMip, pTexture->m_MipCount);
+			m_ResidentSize += GetMipRangeSize(*pTexture, upload.m_TargetMip, pTexture->m_MipCount);
+
+			retire(pTexture->m_Image, pTexture->m_View);
+			pTexture->m_Image = upload.m_Image;
+			pTexture->m_View = upload.m_View;
+			pTexture->m_ResidentMip = upload.m_TargetMip;
+			pTexture->m_PendingMip = upload.m_TargetMip;
+		}
+
+		if (batch.m_StagingBuffer.m_Buffer != VK_NULL_HANDLE)
+			m_Instance.getDeletionQueue().retire(batch.m_StagingBuffer.m_Buffer, batch.m_StagingBuffer.m_Allocation);
+
+		m_FreeCommandBuffers.emplace_back(batch.m_CommandBuffer);
+		m_CompletedValue = batch.m_TimelineValue;
+		m_UploadBatches.pop_front();
+	}
+}
+
+void TextureStreamer::updateDesiredMips()
+{
+	OPTICK_EVENT();
+
+	for (uint32_t i = 0; i < m_Textures.getSize(); i++)
+	{
+		const auto handle = m_Textures.getHandle(i);
+		auto& texture = *m_Textures.get(handle);
+
+		const auto coverage = m_pCoverage[handle.getIndex()].exchange(0, std::memory_order_relaxed);
+		const auto size = static_cast<float>(std::max(texture.m_Source.m_Width, texture.m_Source.m_Height));
+
+		// The texture is visible, so every mip more detailed than the screen size is wasted.
+		if (coverage > 0)
+		{
+			const auto mip = std::floor(std::log2(size / static_cast<float>(coverage)));
+			texture.m_DesiredMip = std::min(static_cast<uint32_t>(std::max(mip, 0.0f)), texture.m_TailMip);
+			texture.m_Priority = static_cast<float>(coverage) / size;
+			texture.m_LastSeenFrame = m_FrameIndex;
+		}
+
+		// The texture was not seen for a while, so it's only kept while there is budget to spare.
+		else if (m_FrameIndex - texture.m_LastSeenFrame > m_EvictionDelay)
+		{
+			texture.m_DesiredMip = texture.m_TailMip;
+			texture.m_Priority = 0.0f;
+		}
+	}
+}
+
+void TextureStreamer::scheduleUploads(MemoryArena& frameArena)
+{
+	OPTICK_EVENT();
+
+	// Every texture can be a candidate, so reserving that many means the vectors never grow.
+	std::pmr::vector<UploadRequest> requests(&frameArena);
+	std::pmr::vector<std::pair<float, TextureHandle>> candidates(&frameArena);
+	requests.reserve(m_Textures.getSize());
+	candidates.reserve(m_Textures.getSize());
+
+	auto availableBudget = getAvailableBudget();
+	uint64_t stagingSize = 0;
+
+	// Evict the lowest priority textures while we are over the budget. The ones which need less detail go first, after that we start taking
+	// mips from textures which are still on screen.
+	if (availableBudget < 0)
+	{
+		for (uint32_t i = 0; i < m_Textures.getSize(); i++)
+		{
+			const auto handle = m_Textures.getHandle(i);
+			const auto& texture = *m_Textures.get(handle);
+
+			if (texture.m_PendingMip == texture.m_ResidentMip && texture.m_ResidentMip < texture.m_TailMip)
+				candidates.emplace_back(texture.m_DesiredMip > texture.m_ResidentMip ? -1.0f : texture.m_Priority, handle);
+		}
+
+		GRAPHITE_RANGES(sort, candidates, [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+		for (const auto& [priority, handle] : candidates)
+		{
+			if (availableBudget >= 0)
+				break;
+
+			auto& texture = *m_Textures.get(handle);
+			const auto targetMip = std::max(texture.m_DesiredMip, texture.m_ResidentMip + 1);
+
+			availableBudget += static_cast<int64_t>(GetMipRangeSize(texture, texture.m_ResidentMip, targetMip));
+			texture.m_PendingMip = targetMip;
+			requests.emplace_back(UploadRequest{ handle, targetMip, 0 });
+		}
+	}
+
+	// Stream in the highest priority textures first.
+	candidates.clear();
+	for (uint32_t i = 0; i < m_Textures.getSize(); i++)
+	{
+		const auto handle = m_Textures.getHandle(i);
+		const auto& texture = *m_Textures.get(handle);
+
+		if (texture.m_PendingMip == texture.m_ResidentMip && texture.m_DesiredMip < texture.m_ResidentMip)
+			candidates.emplace_back(texture.m_Priority, handle);
+	}
+
+	GRAPHITE_RANGES(sort, candidates, [](const auto& lhs, const auto& rhs) { return lhs.first > rhs.first; });
+
+	for (const auto& [priority, handle] : candidates)
+	{
+		auto& texture = *m_Textures.get(handle);
+		auto targetMip = texture.m_ResidentMip;
+		uint64_t size = 0;
+
+		// The tail is always loaded, even over the budget.
+		while (targetMip > texture.m_DesiredMip)
+		{
+			const auto mipSize = texture.m_Source.m_MipSizes[targetMip - 1];
+			const auto isTail = targetMip - 1 >= texture.m_TailMip;
+
+			if (!isTail && (stagingSize + size + mipSize > m_MaximumUploadSize || static_cast<int64_t>(size + mipSize) > availableBudget))
+				break;
+
+			size += mipSize;
+			targetMip--;
+		}
+
+		if (targetMip == texture.m_ResidentMip)
+			continue;
+
+		requests.emplace_back(UploadRequest{ handle, targetMip, stagingSize });
+		texture.m_PendingMip = targetMip;
+		availableBudget -= static_cast<int64_t>(size);
+		stagingSize += size;
+	}
+
+	if (!requests.empty())
+		recordUploads(requests, stagingSize);
+}
+
+void TextureStreamer::recordUploads(std::pmr::vector<UploadRequest>& requests, uint64_t stagingSize)
+{
+	OPTICK_EVENT();
+
+	// Load the new mips to the staging buffer. This is done before anything is recorded, so a request whose mips fail to load can be dropped and the
+	// texture keeps the mips it already has, instead of uploading garbage. The dropped request's part of the staging buffer is left unused.
+	BufferData stagingBuffer;
+	if (stagingSize > 0)
+	{
+		std::byte* pStagingMemory = nullptr;
+		stagingBuffer = Buffer::Allocate(m_Instance, stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+		m_Instance.getAllocator().access([&stagingBuffer, &pStagingMemory](VmaAllocator allocator)
+			{
+				GRAPHITE_VK_ASSERT(vmaMapMemory(allocator, stagingBuffer.m_Allocation, reinterpret_cast<void**>(&pStagingMemory)), "Failed to map the staging buffer!");
+			}
+		);
+
+		std::erase_if(requests, [this, pStagingMemory](const UploadRequest& request)
+			{
+				auto& texture = *m_Textures.get(request.m_Texture);
+				auto offset = request.m_StagingOffset;
+
+				for (auto mip = request.m_TargetMip; mip < texture.m_ResidentMip; mip++)
+				{
+					const auto mipSize = texture.m_Source.m_MipSizes[mip];
+					if (!texture.m_Source.m_LoadMip(mip, std::span<std::byte>(pStagingMemory + offset, mipSize)))
+					{
+						GRAPHITE_LOG_ERROR("Failed to load the mip {} of a streamed texture! The texture keeps it's resident mips.", mip);
+						texture.m_PendingMip = texture.m_ResidentMip;
+						return true;
+					}
+
+					offset += mipSize;
+				}
+
+				return false;
+			}
+		);
+
+		m_Instance.getAllocator().access([&stagingBuffer](VmaAllocator allocator)
+			{
+				GRAPHITE_VK_ASSERT(vmaFlushAllocation(allocator, stagingBuffer.m_Allocation, 0, VK_WHOLE_SIZE), "Failed to flush the staging buffer!");
+				vmaUnmapMemory(allocator, stagingBuffer.m_Allocation);
+			}
+		);
+	}
+
+	// Nothing is left to upload if every request failed.
+	if (requests.empty())
+	{
+		if (stagingBuffer.m_Buffer != VK_NULL_HANDLE)
+			m_Instance.getDeletionQueue().retire(stagingBuffer.m_Buffer, stagingBuffer.m_Allocation);
+
+		return;
+	}
+
+	auto& batch = m_UploadBatches.emplace_back();
+	batch.m_StagingBuffer = stagingBuffer;
+	batch.m_CommandBuffer = getCommandBuffer();
+
+	// Create the new images.
+	batch.m_Uploads.reserve(requests.size());
+	for (const auto& request : requests)
+	{
+		const auto& texture = *m_Textures.get(request.m_Texture);
+
+		const auto builder = ImageBuilder()
+			.setWidth(GetMipExtent(texture.m_Source, request.m_TargetMip).width)
+			.setHeight(GetMipExtent(texture.m_Source, request.m_TargetMip).height)
+			.setMipLevels(texture.m_MipCount - request.m_TargetMip)
+			.setUsage(VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT)
+			.setIsShared(true);
+
+		auto& upload = batch.m_Uploads.emplace_back();
+		upload.m_Texture = request.m_Texture;
+		upload.m_TargetMip = request.m_TargetMip;
+		upload.m_Image = Image::Allocate(m_Instance, builder, texture.m_Source.m_Format);
+
+		VkImageViewCreateInfo viewCreateInfo = {};
+		viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewCreateInfo.pNext = nullptr;
+		viewCreateInfo.flags = 0;
+		viewCreateInfo.image = upload.m_Image.m_Image;
+		viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewCreateInfo.format = upload.m_Image.m_Format;
+		viewCreateInfo.components = { VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY };
+		viewCreateInfo.subresourceRange = GetSubresourceRange(upload.m_Image);
+
+		m_Instance.getLogicalDevice().access([this, &viewCreateInfo, &upload](VkDevice logicalDevice)
+			{
+				GRAPHITE_VK_ASSERT(m_Instance.getDeviceTable().vkCreateImageView(logicalDevice, &viewCreateInfo, nullptr, &upload.m_View), "Failed to create the streamed texture view!");
+			}
+		);
+	}
+
+	// Record the commands.
+	const auto& deviceTable = m_Instance.getDeviceTable();
+	const auto commandBuffer = batch.m_CommandBuffer;
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.pNext = nullptr;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	beginInfo.pInheritanceInfo = nullptr;
+	GRAPHITE_VK_ASSERT(deviceTable.vkBeginCommandBuffer(commandBuffer, &beginInfo), "Failed to begin the texture upload command buffer!");
+
+	// Prepare the new images to be written, and make the previous uploads to the old images visible to the copies.
+	const auto scratch = ScratchScope();
+	auto barriers = scratch.makeVector<VkImageMemoryBarrier2KHR>();
+	barriers.reserve(batch.m_Uploads.size() * 2);
+	for (const auto& upload : batch.m_Uploads)
+	{
+		barriers.emplace_back(CreateImageBarrier(upload.m_Image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			VK_PIPELINE_STAGE_2_NONE_KHR, VK_ACCESS_2_NONE_KHR, VK_PIPELINE_STAGE_2_COPY_BIT_KHR, VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR));
+
+		const auto& texture = *m_Textures.get(upload.m_Texture);
+		if (texture.m_Image.m_Image != VK_NULL_HANDLE)
+		{
+			barriers.emplace_back(CreateImageBarrier(texture.m_Image, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+				VK_PIPELINE_STAGE_2_COPY_BIT_KHR, VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR, VK_PIPELINE_STAGE_2_COPY_BIT_KHR, VK_ACCESS_2_TRANSFER_READ_BIT_KHR));
+		}
+	}
+
+	VkDependencyInfoKHR dependencyInfo = {};
+	dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+	dependencyInfo.pNext = nullptr;
+	dependencyInfo.dependencyFlags = 0;
+	dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(barriers.size());
+	dependencyInfo.pImageMemoryBarriers = barriers.data();
+	deviceTable.vkCmdPipelineBarrier2KHR(commandBuffer, &dependencyInfo);
+
+	// Copy the mips.
+	for (uint32_t i = 0; i < requests.size(); i++)
+	{
+		const auto& request = requests[i];
+		const auto& upload = batch.m_Uploads[i];
+		const auto& texture = *m_Textures.get(request.m_Texture);
+
+		// The new mips come from the staging buffer.
+		auto offset = request.m_StagingOffset;
+		for (auto mip = request.m_TargetMip; mip < texture.m_ResidentMip; mip++)
+		{
+			VkBufferImageCopy copy = {};
+			copy.bufferOffset = offset;
+			copy.bufferRowLength = 0;
+			copy.bufferImageHeight = 0;
+			copy.imageSubresource = VkImageSubresourceLayers{ VK_IMAGE_ASPECT_COLOR_BIT, mip - request.m_TargetMip, 0, 1 };
+			copy.imageOffset = VkOffset3D{ 0, 0, 0 };
+			copy.imageExtent = GetMipExtent(texture.m_Source, mip);
+
+			deviceTable.vkCmdCopyBufferToImage(commandBuffer, batch.m_StagingBuffer.m_Buffer, upload.m_Image.m_Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy);
+			offset += texture.m_Source.m_MipSizes[mip];
+		}
+
+		// The mips which are already resident are copied from the old image.
+		for (auto mip = std::max(request.m_TargetMip, texture.m_ResidentMip); mip < texture.m_MipCount; mip++)
+		{
+			VkImageCopy copy = {};
+			copy.srcSubresource = VkImageSubresourceLayers{ VK_IMAGE_ASPECT_COLOR_BIT, mip - texture.m_ResidentMip, 0, 1 };
+			copy.srcOffset = VkOffset3D{ 0, 0, 0 };
+			copy.dstSubresource = VkImageSubresourceLayers{ VK_IMAGE_ASPECT_COLOR_BIT, mip - request.m_TargetMip, 0, 1 };
+			copy.dstOffset = VkOffset3D{ 0, 0, 0 };
+			copy.extent = GetMipExtent(texture.m_Source, mip);
+
+			deviceTable.vkCmdCopyImage(commandBuffer, texture.m_Image.m_Image, VK_IMAGE_LAYOUT_GENERAL, upload.m_Image.m_Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy);
+		}
+	}
+
+	// Move the new images to the general layout. The graphics queue gets visibility through the transfer timeline semaphore.
+	barriers.clear();
+	for (const auto& upload : batch.m_Uploads)
+	{
+		barriers.emplace_back(CreateImageBarrier(upload.m_Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL,
+			VK_PIPELINE_STAGE_2_COPY_BIT_KHR, VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR, VK_PIPELINE_STAGE_2_COPY_BIT_KHR, VK_ACCESS_2_TRANSFER_READ_BIT_KHR));
+	}
+
+	dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(barriers.size());
+	dependencyInfo.pImageMemoryBarriers = barriers.data();
+	deviceTable.vkCmdPipelineBarrier2KHR(commandBuffer, &dependencyInfo);
+
+	GRAPHITE_VK_ASSERT(deviceTable.vkEndCommandBuffer(commandBuffer), "Failed to end the texture upload command buffer!");
+
+	// Submit the uploads.
+	batch.m_TimelineValue = m_SubmissionQueue.enqueue(QueueType::Transfer, std::span<const VkCommandBuffer>(&batch.m_CommandBuffer, 1));
+}
+
+int64_t TextureStreamer::getAvailableBudget() const
+{
+	// Sum up the budgets of the device local heaps.
+	return m_Instance.getAllocator().access([this](VmaAllocator allocator)
+		{
+			const VkPhysicalDeviceMemoryProperties* pMemoryProperties = nullptr;
+			vmaGetMemoryProperties(allocator, &pMemoryProperties);
+
+			std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> budgets = {};
+			vmaGetHeapBudgets(allocator, budgets.data());
+
+			int64_t available = 0;
+			for (uint32_t i = 0; i < pMemoryProperties->memoryHeapCount; i++)
+			{
+				if (pMemoryProperties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+					available += static_cast<int64_t>(static_cast<double>(budgets[i].budget) * m_BudgetFraction) - static_cast<int64_t>(budgets[i].usage);
+			}
+
+			return available;
+		}
+	);
+}
+
+VkCommandBuffer TextureStreamer::getCommandBuffer()
+{
+	if (!m_FreeCommandBuffers.empty())
+	{
+		const auto commandBuffer = m_FreeCommandBuffers.back();
+		m_FreeCommandBuffers.pop_back();
+
+		GRAPHITE_VK_ASSERT(m_Instance.getDeviceTable().vkResetCommandBuffer(commandBuffer, 0), "Failed to reset the texture upload command buffer!");
+		return commandBuffer;
+	}
+
+	VkCommandBufferAllocateInfo allocateInfo = {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocateInfo.pNext = nullptr;
+	allocateInfo.commandPool = m_CommandPool;
+	allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocateInfo.commandBufferCount = 1;
+
+	VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+	m_Instance.getLogicalDevice().access([this, &allocateInfo, &commandBuffer](VkDevice logicalDevice)
+		{
+			GRAPHITE_VK_ASSERT(m_Instance.getDeviceTable().vkAllocateCommandBuffers(logicalDevice, &allocateInfo, &commandBuffer), "Failed to allocate the texture upload command buffer!");
+		}
+	);
+
+	return commandBuffer;
+}
+
+void TextureStreamer::retire(const ImageData& image, VkImageView view)
+{
+	if (view != VK_NULL_HANDLE)
+		m_Instance.getDeletionQueue().retire(view);
+
+	if (image.m_Image != VK_NULL_HANDLE)
+		m_Instance.getDeletionQueue().retire(image.m_Image, image.m_Allocation);
+}
+
+uint64_t TextureStreamer::GetMipRangeSize(const StreamedTexture& texture, uint32_t firstMip, uint32_t lastMip)
+{
+	uint64_t size = 0;
+	for (auto mip = firstMip; mip < lastMip && mip < texture.m_MipCount; mip++)
+		size += texture.m_Source.m_MipSizes[mip];
+
+	return size;
+}
@@ -0,0 +1,270 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "CommandSubmissionQueue.hpp"
+
+#include "Core/MemoryArena.hpp"
+
+#include <deque>
+#include <functional>
+#include <memory>
+
+/**
+ * Texture source structure.
+ * This describes a streamable 2D texture and how to load it's mips.
+ */
+struct TextureSource final
+{
+	uint32_t m_Width = 0;
+	uint32_t m_Height = 0;
+	VkFormat m_Format = VK_FORMAT_UNDEFINED;
+
+	// The size of each mip in bytes, starting from the most detailed one. The number of entries is the number of mips.
+	std::vector<uint64_t> m_MipSizes;
+
+	// Load a mip into the destination. The destination is exactly the size of the mip. This is called from the streamer's update thread.
+	std::function<bool(uint32_t, std::span<std::byte>)> m_LoadMip;
+};
+
+/**
+ * Streamed texture structure.
+ * This contains the streaming state of a single texture.
+ */
+struct StreamedTexture final
+{
+	TextureSource m_Source;
+
+	ImageData m_Image;
+	VkImageView m_View = VK_NULL_HANDLE;
+
+	uint32_t m_MipCount = 0;
+	uint32_t m_TailMip = 0;		// The most detailed mip of the tail, which is always resident.
+	uint32_t m_ResidentMip = 0;	// The most detailed resident mip. This is the mip count if nothing is resident.
+	uint32_t m_DesiredMip = 0;	// The most detailed mip the texture needs on screen.
+	uint32_t m_PendingMip = 0;	// The target of the upload in flight. This is the resident mip if there is none.
+
+	uint64_t m_LastSeenFrame = 0;
+	float m_Priority = 0.0f;
+};
+
+using TextureHandle = ResourceHandle<StreamedTexture>;
+
+/**
+ * Texture streamer class.
+ * This keeps only the mips the textures actually need in memory. The culling pass reports how large each texture is on screen, which tells the
+ * streamer which mip is needed. Missing mips are streamed in on the transfer queue, highest priority first, as long as the memory budget allows.
+ * When the budget is exceeded, mips of the lowest priority textures are evicted.
+ *
+ * Changing the resident mips recreates the image with the new mip range. The mips which are already resident are copied from the old image on
+ * the GPU and the old image is retired once the copy is done. Streamed images stay in the general layout so the transfer queue can read them
+ * while the graphics queue is still sampling them.
+ */
+class TextureStreamer final : public InstanceBoundObject
+{
+	/**
+	 * Pending upload structure.
+	 * This contains the new image of a texture while it's being uploaded.
+	 */
+	struct PendingUpload final
+	{
+		TextureHandle m_Texture;
+		ImageData m_Image;
+		VkImageView m_View = VK_NULL_HANDLE;
+		uint32_t m_TargetMip = 0;
+	};
+
+	/**
+	 * Upload batch structure.
+	 * This contains all the uploads recorded in a single frame.
+	 */
+	struct UploadBatch final
+	{
+		std::vector<PendingUpload> m_Uploads;
+		BufferData m_StagingBuffer;
+		VkCommandBuffer m_CommandBuffer = VK_NULL_HANDLE;
+		uint64_t m_TimelineValue = 0;
+	};
+
+	/**
+	 * Upload request structure.
+	 * This is used while scheduling the uploads of a frame.
+	 */
+	struct UploadRequest final
+	{
+		TextureHandle m_Texture;
+		uint32_t m_TargetMip = 0;
+		uint64_t m_StagingOffset = 0;
+	};
+
+public:
+	/**
+	 * Explicit constructor.
+	 *
+	 * @param instance The instance reference.
+	 * @param submissionQueue The submission queue to submit the uploads to.
+	 * @param maximumTextures The maximum number of textures which can be registered at once. Default is 16384.
+	 */
+	explicit TextureStreamer(Instance& instance, CommandSubmissionQueue& submissionQueue, uint32_t maximumTextures = 16384);
+
+	/**
+	 * Destructor.
+	 */
+	~TextureStreamer() override;
+
+	/**
+	 * Register a texture to be streamed.
+	 * Only the mip tail is loaded at first, and the rest is streamed in once the texture is seen.
+	 *
+	 * @param source The texture source.
+	 * @return The texture handle. This is null if the texture could not be registered.
+	 */
+	[[nodiscard]] TextureHandle registerTexture(TextureSource source);
+
+	/**
+	 * Unregister a texture.
+	 * The texture's image is destroyed once the GPU is done with it.
+	 *
+	 * @param handle The texture handle.
+	 */
+	void unregisterTexture(TextureHandle handle);
+
+	/**
+	 * Report the screen space size of a texture.
+	 * This should be called by the culling pass for every visible object, and the largest size of each frame is used. The size of an object is
+	 * computed by LODSelector::cullAndSelect() when it's culled. This is thread safe.
+	 *
+	 * @param handle The texture handle.
+	 * @param pixels The size of the texture's largest dimension on screen, in pixels.
+	 */
+	void reportCoverage(TextureHandle handle, float pixels);
+
+	/**
+	 * Update the streaming state and schedule the uploads of the frame.
+	 * This should be called once per frame, after culling and before flushing the submission queue.
+	 *
+	 * @param frameArena The arena to allocate the frame's scheduling data from. It must not be reset till this returns.
+	 */
+	void update(MemoryArena& frameArena);
+
+	/**
+	 * Get the image view of a texture.
+	 *
+	 * @param handle The texture handle.
+	 * @return The image view. This is null if the texture is invalid or nothing is resident yet.
+	 */
+	[[nodiscard]] VkImageView getView(TextureHandle handle) const;
+
+	/**
+	 * Get the most detailed resident mip of a texture.
+	 *
+	 * @param handle The texture handle.
+	 * @return The mip index.
+	 */
+	[[nodiscard]] uint32_t getResidentMip(TextureHandle handle) const;
+
+	/**
+	 * Get the wait the graphics submissions need so the latest uploads are visible to them.
+	 *
+	 * @return The submission wait.
+	 */
+	[[nodiscard]] SubmissionWait getUploadWait() const { return SubmissionWait{ QueueType::Transfer, m_CompletedValue, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT_KHR }; }
+
+	/**
+	 * Set the fraction of the device local memory budget the streamer is allowed to fill.
+	 *
+	 * @param fraction The budget fraction. Default is 0.8.
+	 */
+	void setBudgetFraction(float fraction) { m_BudgetFraction = fraction; }
+
+	/**
+	 * Set the maximum number of bytes which can be uploaded in a single frame.
+	 *
+	 * @param bytes The byte count. Default is 32 MiB.
+	 */
+	void setMaximumUploadSize(uint64_t bytes) { m_MaximumUploadSize = bytes; }
+
+public:
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, TextureCount, m_Textures.getSize());
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint64_t, ResidentSize, m_ResidentSize);
+
+private:
+	/**
+	 * Swap in the images of the uploads which are done.
+	 */
+	void completeUploads();
+
+	/**
+	 * Compute the desired mip of each texture from it's reported coverage.
+	 */
+	void updateDesiredMips();
+
+	/**
+	 * Decide which textures to stream in and out, and record their uploads.
+	 *
+	 * @param frameArena The arena to allocate the candidates and the requests from.
+	 */
+	void scheduleUploads(MemoryArena& frameArena);
+
+	/**
+	 * Record and enqueue the uploads of a frame.
+	 *
+	 * @param requests The upload requests. The requests whose mips fail to load are removed.
+	 * @param stagingSize The total size of the new mip data.
+	 */
+	void recordUploads(std::pmr::vector<UploadRequest>& requests, uint64_t stagingSize);
+
+	/**
+	 * Get the remaining device local memory budget.
+	 *
+	 * @return The remaining byte count. This is negative if the budget is exceeded.
+	 */
+	[[nodiscard]] int64_t getAvailableBudget() const;
+
+	/**
+	 * Get a command buffer to record the uploads to.
+	 *
+	 * @return The command buffer.
+	 */
+	[[nodiscard]] VkCommandBuffer getCommandBuffer();
+
+	/**
+	 * Retire the image and the view of a texture to the deletion queue.
+	 *
+	 * @param image The image data.
+	 * @param view The image view.
+	 */
+	void retire(const ImageData& image, VkImageView view);
+
+	/**
+	 * Get the size of a range of mips.
+	 *
+	 * @param texture The texture.
+	 * @param firstMip The first mip of the range.
+	 * @param lastMip The mip after the last mip of the range.
+	 * @return The size in bytes.
+	 */
+	[[nodiscard]] static uint64_t GetMipRangeSize(const StreamedTexture& texture, uint32_t firstMip, uint32_t lastMip);
+
+private:
+	ResourcePool<StreamedTexture> m_Textures;
+	std::unique_ptr<std::atomic_uint32_t[]> m_pCoverage;
+
+	std::deque<UploadBatch> m_UploadBatches;
+
+	std::vector<VkCommandBuffer> m_FreeCommandBuffers;
+	VkCommandPool m_CommandPool = VK_NULL_HANDLE;
+
+	CommandSubmissionQueue& m_SubmissionQueue;
+
+	uint64_t m_FrameIndex = 0;
+	uint64_t m_CompletedValue = 0;
+	uint64_t m_ResidentSize = 0;
+	uint64_t m_MaximumUploadSize = 32 * 1024 * 1024;
+
+	uint32_t m_MaximumTextures = 0;
+	uint32_t m_EvictionDelay = 120;
+	uint32_t m_TailSize = 64;
+
+	float m_BudgetFraction = 0.8f;
+};
@@ -5,90 +5,125 @@
 #include "VulkanMacros.hpp"
 
 #include "Core/Logging.hpp"
+#include "Core/MemoryArena.hpp"
+#include "Core/StartupTrace.hpp"
 
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_vulkan.h>
 
 #include <optick.h>
 
+#include <array>
+#include <algorithm>
+#include <limits>
+#include <span>
+
 namespace /* anonymous */
 {
 	/**
-	 * Static initializer structure.
-	 * This structure can be used to initialize something ONCE and destroy when closing the application.
+	 * Resolve the Vulkan present mode to use.
+	 * If the requested mode is not available, the next best mode is selected. FIFO is always available.
+	 *
+	 * @param presentModes The available present modes.
+	 * @param mode The requested present mode.
+	 * @return The Vulkan present mode.
 	 */
-	struct StaticInitializer final
+	[[nodiscard]] VkPresentModeKHR ResolvePresentMode(std::span<const VkPresentModeKHR> presentModes, PresentMode mode)
 	{
-		/**
-		 * Default constructor.
-		 */
-		StaticInitializer()
+		// FIFO is the fallback of every mode, so it's not listed as a candidate.
+		constexpr std::array<VkPresentModeKHR, 3> immediateCandidates = { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR };
+		constexpr std::array<VkPresentModeKHR, 1> fifoRelaxedCandidates = { VK_PRESENT_MODE_FIFO_RELAXED_KHR };
+		constexpr std::array<VkPresentModeKHR, 2> mailboxCandidates = { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR };
+
+		std::span<const VkPresentModeKHR> candidates;
+		switch (mode)
 		{
-			// Try and initialize SDL.
-			if (SDL_Init(SDL_INIT_VIDEO) != 0)
-				GRAPHITE_LOG_FATAL("Failed to initialize SDL! {}", SDL_GetError());
+		case PresentMode::Immediate:
+			candidates = immediateCandidates;
+			break;
 
-			else
-				GRAPHITE_LOG_INFORMATION("Successfully initialized SDL.");
+		case PresentMode::FIFORelaxed:
+			candidates = fifoRelaxedCandidates;
+			break;
+
+		case PresentMode::Mailbox:
+			candidates = mailboxCandidates;
+			break;
+
+		default:
+			return VK_PRESENT_MODE_FIFO_KHR;
 		}
 
-		/**
-		 * Destructor.
-		 */
-		~StaticInitializer()
+		for (const auto candidate : candidates)
 		{
-			// Unload the Vulkan library and quit SDL.
-			SDL_Vulkan_UnloadLibrary();
-			SDL_Quit();
+			if (GRAPHITE_RANGES(find, presentModes, candidate) != presentModes.end())
+				return candidate;
 		}
-	};
-}
 
-// Initialize SDL.
-static StaticInitializer g_Initializer;
+		return VK_PRESENT_MODE_FIFO_KHR;
+	}
+}
 
-Window::Window(Instance& instance, std::string_view title)
-	: InstanceBoundObject(instance)
+Window::Window(Instance& instance, std::string_view title, uint32_t width, uint32_t height, PresentMode presentMode)
+	: InstanceBoundObject(instance), m_Width(width), m_Height(height), m_PresentMode(presentMode)
 {
-	// Create the window.
-	m_pWindow = SDL_CreateWindow(title.data(), 1280, 720, SDL_WINDOW_VULKAN | SDL_WINDOW_FULLSCREEN);
-
-	// Check if the window was created properly.
-	if (!m_pWindow)
+	// Create the window and the surface. These only need the Vulkan instance, so they are created while the device is being created.
 	{
-		GRAPHITE_LOG_FATAL("Failed to create the window!");
-		return;
+		GRAPHITE_STARTUP_PHASE("Window creation");
+
+		// Create the window.
+		m_pWindow = SDL_CreateWindow(title.data(), static_cast<int>(width), static_cast<int>(height), SDL_WINDOW_VULKAN | SDL_WINDOW_RESIZABLE);
+
+		// Check if the window was created properly.
+		if (!m_pWindow)
+		{
+			GRAPHITE_LOG_FATAL("Failed to create the window!");
+			return;
+		}
+
+		// Set this class as user data.
+		SDL_SetWindowData(m_pWindow, "this", this);
+
+		// Create the window surface.
+		if (SDL_Vulkan_CreateSurface(m_pWindow, m_Instance.getInstance(), &m_Surface) == SDL_FALSE)
+		{
+			GRAPHITE_LOG_FATAL("Failed to create the Vulkan surface!");
+			return;
+		}
 	}
 
-	// Set this class as user data.
-	SDL_SetWindowData(m_pWindow, "this", this);
+	// Everything from here on needs the device.
+	m_Instance.waitForDevice();
 
-	// Create the window surface.
-	if (SDL_Vulkan_CreateSurface(m_pWindow, m_Instance.getInstance(), &m_Surface) == SDL_FALSE)
-		GRAPHITE_LOG_FATAL("Failed to create the Vulkan surface!");
+	// Check if we can use present IDs to pace the frames, and present fences to know when the swapchains are no longer used.
+	m_bSupportsPresentWait = m_Instance.isDeviceExtensionEnabled(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+	m_bSupportsPresentFence = m_Instance.isDeviceExtensionEnabled(VK_EXT_SWAPCHAIN_MAINTENANCE_1_EXTENSION_NAME);
 
-	// If we created the surface, setup the swapchain.
-	else
-		setupSwapchain();
+	// Setup the swapchain.
+	GRAPHITE_STARTUP_PHASE("Swapchain creation");
+	setupSwapchain();
 }
 
 Window::~Window()
 {
 	m_Instance.waitIdle();
 
+	// The swapchains must be destroyed before the surface, so the deletion queue is released right away. This is safe since the device is idle.
+	retireSwapchain();
+	releaseRetiredSwapchains(true);
+	m_Instance.getDeletionQueue().releaseAll();
+
 	m_Instance.getLogicalDevice().access([this](VkDevice logicalDevice)
 		{
-			for (const auto view : m_SwapchainImageViews)
-				m_Instance.getDeviceTable().vkDestroyImageView(logicalDevice, view, nullptr);
-
-			m_Instance.getDeviceTable().vkDestroySwapchainKHR(logicalDevice, m_Swapchain, nullptr);
+			for (const auto fence : m_FreeFences)
+				m_Instance.getDeviceTable().vkDestroyFence(logicalDevice, fence, nullptr);
 		}
 	);
 
 	vkDestroySurfaceKHR(m_Instance.getInstance(), m_Surface, nullptr);
+	SDL_DestroyWindow(m_pWindow);
 
-	m_SwapchainImageViews.clear();
-	m_Swapchain = VK_NULL_HANDLE;
+	m_FreeFences.clear();
 }
 
 void Window::update()
@@ -98,12 +133,236 @@ void Window::update()
 	SDL_Event events;
 	while (SDL_PollEvent(&events))
 	{
-		// Handle the events.
+		Event event = {};
+		event.m_Timestamp = events.common.timestamp;
+
+		switch (events.type)
+		{
+		case SDL_EVENT_QUIT:
+			event.m_Type = EventType::Quit;
+			break;
+
+		case SDL_EVENT_WINDOW_RESIZED:
+		case SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED:
+			m_bShouldRecreateSwapchain = true;
+
+			// Some platforms resize the window to zero and back without sending the minimize and restore events.
+			if (events.window.data1 > 0 && events.window.data2 > 0)
+				m_bIsMinimized = false;
+
+			event.m_Type = EventType::WindowResized;
+			event.m_Window.m_Width = static_cast<uint32_t>(events.window.data1);
+			event.m_Window.m_Height = static_cast<uint32_t>(events.window.data2);
+			break;
+
+		case SDL_EVENT_WINDOW_MINIMIZED:
+			m_bIsMinimized = true;
+
+			event.m_Type = EventType::WindowMinimized;
+			break;
+
+		case SDL_EVENT_WINDOW_RESTORED:
+		case SDL_EVENT_WINDOW_MAXIMIZED:
+			m_bIsMinimized = false;
+			m_bShouldRecreateSwapchain = true;
+
+			event.m_Type = EventType::WindowRestored;
+			break;
+
+		case SDL_EVENT_WINDOW_FOCUS_GAINED:
+			event.m_Type = EventType::WindowFocusGained;
+			break;
+
+		case SDL_EVENT_WINDOW_FOCUS_LOST:
+			event.m_Type = EventType::WindowFocusLost;
+			break;
+
+		case SDL_EVENT_KEY_DOWN:
+		case SDL_EVENT_KEY_UP:
+			event.m_Type = events.type == SDL_EVENT_KEY_DOWN ? EventType::KeyDown : EventType::KeyUp;
+			event.m_Key.m_ScanCode = static_cast<uint32_t>(events.key.keysym.scancode);
+			event.m_Key.m_KeyCode = static_cast<uint32_t>(events.key.keysym.sym);
+			event.m_Key.m_Modifiers = events.key.keysym.mod;
+			event.m_Key.m_bIsRepeat = events.key.repeat != 0;
+			break;
+
+		case SDL_EVENT_MOUSE_MOTION:
+			event.m_Type = EventType::MouseMotion;
+			event.m_MouseMotion.m_PositionX = events.motion.x;
+			event.m_MouseMotion.m_PositionY = events.motion.y;
+			event.m_MouseMotion.m_DeltaX = events.motion.xrel;
+			event.m_MouseMotion.m_DeltaY = events.motion.yrel;
+			break;
+
+		case SDL_EVENT_MOUSE_BUTTON_DOWN:
+		case SDL_EVENT_MOUSE_BUTTON_UP:
+			event.m_Type = events.type == SDL_EVENT_MOUSE_BUTTON_DOWN ? EventType::MouseButtonDown : EventType::MouseButtonUp;
+			event.m_MouseButton.m_PositionX = events.button.x;
+			event.m_MouseButton.m_PositionY = events.button.y;
+			event.m_MouseButton.m_Button = events.button.button;
+			event.m_MouseButton.m_Clicks = events.button.clicks;
+			break;
+
+		case SDL_EVENT_MOUSE_WHEEL:
+			event.m_Type = EventType::MouseWheel;
+			event.m_MouseWheel.m_DeltaX = events.wheel.x;
+			event.m_MouseWheel.m_DeltaY = events.wheel.y;
+			break;
+
+		default:
+			continue;
+		}
+
+		publishEvent(event);
+	}
+
+	// Recreate the swapchain if needed. We can't do it while minimized since the surface extent will be zero.
+	if (m_bShouldRecreateSwapchain && !m_bIsMinimized)
+		setupSwapchain();
+
+	releaseRetiredSwapchains(false);
+}
+
+void Window::addEventQueue(EventQueue* pQueue)
+{
+	m_pEventQueues.emplace_back(pQueue);
+}
+
+void Window::removeEventQueue(EventQueue* pQueue)
+{
+	std::erase(m_pEventQueues, pQueue);
+}
+
+bool Window::acquireNextImage(VkSemaphore signalSemaphore, uint32_t& imageIndex)
+{
+	OPTICK_EVENT();
+
+	if (m_bShouldRecreateSwapchain || m_bIsMinimized || m_Swapchain == VK_NULL_HANDLE)
+		return false;
+
+	const auto result = m_Instance.getLogicalDevice().access([this, signalSemaphore, &imageIndex](VkDevice logicalDevice)
+		{
+			return m_Instance.getDeviceTable().vkAcquireNextImageKHR(logicalDevice, m_Swapchain, std::numeric_limits<uint64_t>::max(), signalSemaphore, VK_NULL_HANDLE, &imageIndex);
+		}
+	);
+
+	// A suboptimal swapchain can still be presented to, so we recreate it after this frame.
+	if (result == VK_SUBOPTIMAL_KHR)
+	{
+		m_bShouldRecreateSwapchain = true;
 	}
+	else if (result != VK_SUCCESS)
+	{
+		if (result == VK_ERROR_OUT_OF_DATE_KHR)
+			m_bShouldRecreateSwapchain = true;
+
+		else
+			GRAPHITE_LOG_ERROR("Failed to acquire the next swapchain image!");
+
+		return false;
+	}
+
+	return true;
+}
+
+void Window::present(VkSemaphore waitSemaphore, uint32_t imageIndex)
+{
+	OPTICK_EVENT();
+
+	// Tag the present with an ID so the frame pacer can wait for it.
+	const uint64_t presentID = m_PresentID + 1;
+
+	VkPresentIdKHR presentIDInfo = {};
+	presentIDInfo.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+	presentIDInfo.pNext = nullptr;
+	presentIDInfo.swapchainCount = 1;
+	presentIDInfo.pPresentIds = &presentID;
+
+	// Tag the present with a fence so we know when the presentation engine is done with the swapchain.
+	const auto presentFence = m_bSupportsPresentFence ? getPresentFence() : VK_NULL_HANDLE;
+
+	VkSwapchainPresentFenceInfoEXT presentFenceInfo = {};
+	presentFenceInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_PRESENT_FENCE_INFO_EXT;
+	presentFenceInfo.pNext = nullptr;
+	presentFenceInfo.swapchainCount = 1;
+	presentFenceInfo.pFences = &presentFence;
+
+	// Only the structures of the enabled extensions can be chained.
+	const void* pNext = nullptr;
+	if (m_bSupportsPresentWait)
+		pNext = &presentIDInfo;
+
+	if (m_bSupportsPresentFence)
+	{
+		presentFenceInfo.pNext = pNext;
+		pNext = &presentFenceInfo;
+	}
+
+	VkPresentInfoKHR presentInfo = {};
+	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+	presentInfo.pNext = pNext;
+	presentInfo.waitSemaphoreCount = waitSemaphore != VK_NULL_HANDLE ? 1 : 0;
+	presentInfo.pWaitSemaphores = &waitSemaphore;
+	presentInfo.swapchainCount = 1;
+	presentInfo.pSwapchains = &m_Swapchain;
+	presentInfo.pImageIndices = &imageIndex;
+	presentInfo.pResults = nullptr;
+
+	const auto result = m_Instance.getGraphicsQueue().access([this, &presentInfo](const VulkanQueue& queue)
+		{
+			return m_Instance.getDeviceTable().vkQueuePresentKHR(queue.m_Queue, &presentInfo);
+		}
+	);
+
+	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+		m_bShouldRecreateSwapchain = true;
+
+	else if (result != VK_SUCCESS)
+		GRAPHITE_LOG_ERROR("Failed to present the swapchain image!");
+
+	// The ID is only used if the image was actually presented, otherwise there would be nothing to wait for.
+	if (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR)
+		m_PresentID = presentID;
+
+	// The fence is signaled even if the swapchain is out of date, since the present still waits on it's semaphore.
+	if (presentFence != VK_NULL_HANDLE)
+		m_PresentFences.emplace_back(presentFence);
+}
+
+bool Window::waitForPresent(uint64_t presentID, uint64_t timeout)
+{
+	OPTICK_EVENT();
+
+	if (!m_bSupportsPresentWait || presentID == 0 || m_Swapchain == VK_NULL_HANDLE)
+		return false;
+
+	// The IDs before the current swapchain's first present were presented to a retired swapchain, which can't be waited on.
+	if (presentID < m_FirstPresentID)
+		return false;
+
+	// We don't lock the logical device here since this call blocks and other threads would be starved till the present is done.
+	const auto result = m_Instance.getDeviceTable().vkWaitForPresentKHR(m_Instance.getLogicalDevice().getUnsafe(), m_Swapchain, presentID, timeout);
+	if (result == VK_ERROR_OUT_OF_DATE_KHR)
+		m_bShouldRecreateSwapchain = true;
+
+	return result == VK_SUCCESS;
+}
+
+void Window::setPresentMode(PresentMode mode)
+{
+	if (m_PresentMode == mode)
+		return;
+
+	m_PresentMode = mode;
+	m_bShouldRecreateSwapchain = true;
 }
 
 void Window::setupSwapchain()
 {
+	OPTICK_EVENT();
+
+	m_bShouldRecreateSwapchain = false;
+
 	// Get the surface capabilities.
 	const auto surfaceCapabilities = m_Instance.getPhysicalDevice().access([this](VkPhysicalDevice physicalDevice)
 		{
@@ -126,12 +385,39 @@ void Window::setupSwapchain()
 	else
 		surfaceComposite = VK_COMPOSITE_ALPHA_INHERIT_BIT_KHR;
 
-	m_FrameCount = std::clamp(surfaceCapabilities.minImageCount + 1, surfaceCapabilities.minImageCount, surfaceCapabilities.maxImageCount);
-	m_Width = surfaceCapabilities.currentExtent.width;
-	m_Height = surfaceCapabilities.currentExtent.height;
+	// A max image count of 0 means that there is no limit.
+	m_FrameCount = surfaceCapabilities.minImageCount + 1;
+	if (surfaceCapabilities.maxImageCount > 0)
+		m_FrameCount = std::min(m_FrameCount, surfaceCapabilities.maxImageCount);
+
+	// Resolve the extent. If the current extent is 0xFFFFFFFF, the surface size is determined by the swapchain so we use the window's size.
+	auto extent = surfaceCapabilities.currentExtent;
+	if (extent.width == std::numeric_limits<uint32_t>::max())
+	{
+		int width = 0, height = 0;
+		SDL_GetWindowSizeInPixels(m_pWindow, &width, &height);
+
+		extent.width = std::clamp(static_cast<uint32_t>(width), surfaceCapabilities.minImageExtent.width, surfaceCapabilities.maxImageExtent.width);
+		extent.height = std::clamp(static_cast<uint32_t>(height), surfaceCapabilities.minImageExtent.height, surfaceCapabilities.maxImageExtent.height);
+	}
+
+	// If the extent is zero, we can't create the swapchain right now. The extent is queried again on the next update instead of treating the window as
+	// minimized, since a window can be resized to zero without a minimize event, and then nothing would clear the flag.
+	if (extent.width == 0 || extent.height == 0)
+	{
+		m_bShouldRecreateSwapchain = true;
+		return;
+	}
+
+	m_Width = extent.width;
+	m_Height = extent.height;
+
+	// The queried modes and formats are only needed till the swapchain is created, so they go to the scratch arena.
+	const auto scratch = ScratchScope();
 
 	// Get the present modes.
-	const auto presentModes = m_Instance.getPhysicalDevice().access([this](VkPhysicalDevice physicalDevice) -> std::vector<VkPresentModeKHR>
+	auto presentModes = scratch.makeVector<VkPresentModeKHR>();
+	m_Instance.getPhysicalDevice().access([this, &presentModes](VkPhysicalDevice physicalDevice)
 		{
 			uint32_t presentModeCount = 0;
 			GRAPHITE_VK_ASSERT(vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, m_Surface, &presentModeCount, nullptr), "Failed to get the surface present mode count!");
@@ -139,29 +425,20 @@ void Window::setupSwapchain()
 			if (presentModeCount == 0)
 			{
 				GRAPHITE_LOG_FATAL("No suitable present formats found!");
-				return {};
+				return;
 			}
 
-			std::vector<VkPresentModeKHR> presentModes(presentModeCount);
+			presentModes.resize(presentModeCount);
 			GRAPHITE_VK_ASSERT(vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, m_Surface, &presentModeCount, presentModes.data()), "Failed to get the surface present modes!");
-
-			return presentModes;
 		}
 	);
 
-	// Check if we have the present mode we need.
-	VkPresentModeKHR presentMode = presentModes.front();
-	for (const auto availablePresentMode : presentModes)
-	{
-		if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
-		{
-			presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
-			break;
-		}
-	}
+	// Resolve the present mode we need.
+	const auto presentMode = ResolvePresentMode(presentModes, m_PresentMode);
 
 	// Get the surface formats.
-	const auto surfaceFormats = m_Instance.getPhysicalDevice().access([this](VkPhysicalDevice physicalDevice) -> std::vector<VkSurfaceFormatKHR>
+	auto surfaceFormats = scratch.makeVector<VkSurfaceFormatKHR>();
+	m_Instance.getPhysicalDevice().access([this, &surfaceFormats](VkPhysicalDevice physicalDevice)
 		{
 			uint32_t formatCount = 0;
 			GRAPHITE_VK_ASSERT(vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, m_Surface, &formatCount, nullptr), "Failed to get the surface format count!");
@@ -169,13 +446,11 @@ void Window::setupSwapchain()
 			if (formatCount == 0)
 			{
 				GRAPHITE_LOG_FATAL("No suitable surface formats found!");
-				return {};
+				return;
 			}
 
-			std::vector<VkSurfaceFormatKHR> surfaceFormats(formatCount);
+			surfaceFormats.resize(formatCount);
 			GRAPHITE_VK_ASSERT(vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, m_Surface, &formatCount, surfaceFormats.data()), "Failed to get the surface formats!");
-
-			return surfaceFormats;
 		}
 	);
 
@@ -201,7 +476,7 @@ void Window::setupSwapchain()
 	createInfo.minImageCount = m_FrameCount;
 	createInfo.imageFormat = m_SwapchainFormat;
 	createInfo.imageColorSpace = surfaceFormat.colorSpace;
-	createInfo.imageExtent = surfaceCapabilities.currentExtent;
+	createInfo.imageExtent = extent;
 	createInfo.imageArrayLayers = 1;
 	createInfo.imageUsage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
 	createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
@@ -211,7 +486,7 @@ void Window::setupSwapchain()
 	createInfo.compositeAlpha = surfaceComposite;
 	createInfo.presentMode = presentMode;
 	createInfo.clipped = VK_TRUE;
-	createInfo.oldSwapchain = VK_NULL_HANDLE;
+	createInfo.oldSwapchain = m_Swapchain;
 
 	// Resolve the queue families if the two queues are different.
 	const std::array<uint32_t, 2> queueFamilyindices = {
@@ -227,16 +502,26 @@ void Window::setupSwapchain()
 	}
 
 	// Create the swapchain.
-	m_Instance.getLogicalDevice().access([this, &createInfo](VkDevice logicalDevice)
+	VkSwapchainKHR newSwapchain = VK_NULL_HANDLE;
+	m_Instance.getLogicalDevice().access([this, &createInfo, &newSwapchain](VkDevice logicalDevice)
 		{
-			GRAPHITE_VK_ASSERT(m_Instance.getDeviceTable().vkCreateSwapchainKHR(logicalDevice, &createInfo, nullptr, &m_Swapchain), "Failed to create the swapchain!");
+			GRAPHITE_VK_ASSERT(m_Instance.getDeviceTable().vkCreateSwapchainKHR(logicalDevice, &createInfo, nullptr, &newSwapchain), "Failed to create the swapchain!");
 		}
 	);
 
-	// Get the swapchain images.
-	m_SwapchainImages.resize(m_FrameCount);
+	// Retire the old swapchain. Instead of waiting for the device to become idle, we keep it alive till the frames which might be using it are done.
+	retireSwapchain();
+	m_Swapchain = newSwapchain;
+
+	// The present IDs keep increasing across swapchains, so the frame pacer's history stays valid, but only the new ones can be waited on.
+	m_FirstPresentID = m_PresentID + 1;
+
+	// Get the swapchain images. The implementation is allowed to create more images than what we requested.
 	m_Instance.getLogicalDevice().access([this](VkDevice logicalDevice)
 		{
+			GRAPHITE_VK_ASSERT(m_Instance.getDeviceTable().vkGetSwapchainImagesKHR(logicalDevice, m_Swapchain, &m_FrameCount, nullptr), "Failed to get the swapchain image count!");
+
+			m_SwapchainImages.resize(m_FrameCount);
 			GRAPHITE_VK_ASSERT(m_Instance.getDeviceTable().vkGetSwapchainImagesKHR(logicalDevice, m_Swapchain, &m_FrameCount, m_SwapchainImages.data()), "Failed to get the swapchain images!");
 		}
 	);
@@ -275,3 +560,106 @@ void Window::setupImageViews()
 		);
 	}
 }
+
+void Window::publishEvent(const Event& event)
+{
+	for (const auto pQueue : m_pEventQueues)
+	{
+		if (!pQueue->tryPush(event))
+			GRAPHITE_LOG_WARNING("The event queue {} is full! Dropping the event.", fmt::ptr(pQueue));
+	}
+}
+
+VkFence Window::getPresentFence()
+{
+	return m_Instance.getLogicalDevice().access([this](VkDevice logicalDevice)
+		{
+			const auto& deviceTable = m_Instance.getDeviceTable();
+
+			// Reuse the fences of the presents which are done.
+			std::erase_if(m_PresentFences, [this, &deviceTable, logicalDevice](VkFence fence)
+				{
+					if (deviceTable.vkGetFenceStatus(logicalDevice, fence) != VK_SUCCESS)
+						return false;
+
+					GRAPHITE_VK_ASSERT(deviceTable.vkResetFences(logicalDevice, 1, &fence), "Failed to reset the present fence!");
+					m_FreeFences.emplace_back(fence);
+					return true;
+				}
+			);
+
+			if (!m_FreeFences.empty())
+			{
+				const auto fence = m_FreeFences.back();
+				m_FreeFences.pop_back();
+				return fence;
+			}
+
+			VkFenceCreateInfo createInfo = {};
+			createInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+			createInfo.pNext = nullptr;
+			createInfo.flags = 0;
+
+			VkFence fence = VK_NULL_HANDLE;
+			GRAPHITE_VK_ASSERT(deviceTable.vkCreateFence(logicalDevice, &createInfo, nullptr, &fence), "Failed to create the present fence!");
+			return fence;
+		}
+	);
+}
+
+void Window::retireSwapchain()
+{
+	if (m_Swapchain == VK_NULL_HANDLE)
+		return;
+
+	auto& retired = m_RetiredSwapchains.emplace_back();
+	retired.m_Swapchain = m_Swapchain;
+	retired.m_ImageViews = std::move(m_SwapchainImageViews);
+	retired.m_PresentFences = std::move(m_PresentFences);
+
+	m_SwapchainImageViews.clear();
+	m_PresentFences.clear();
+	m_Swapchain = VK_NULL_HANDLE;
+}
+
+void Window::releaseRetiredSwapchains(bool wait)
+{
+	if (m_RetiredSwapchains.empty())
+		return;
+
+	m_Instance.getLogicalDevice().access([this, wait](VkDevice logicalDevice)
+		{
+			const auto& deviceTable = m_Instance.getDeviceTable();
+			auto& deletionQueue = m_Instance.getDeletionQueue();
+
+			std::erase_if(m_RetiredSwapchains, [this, wait, logicalDevice, &deviceTable, &deletionQueue](RetiredSwapchain& retired)
+				{
+					// The presentation engine is done with the swapchain once all of it's present fences are signaled.
+					if (!retired.m_PresentFences.empty())
+					{
+						const auto timeout = wait ? std::numeric_limits<uint64_t>::max() : 0;
+						const auto result = deviceTable.vkWaitForFences(logicalDevice, static_cast<uint32_t>(retired.m_PresentFences.size()), retired.m_PresentFences.data(), VK_TRUE, timeout);
+						if (result != VK_SUCCESS)
+							return false;
+
+						GRAPHITE_VK_ASSERT(deviceTable.vkResetFences(logicalDevice, static_cast<uint32_t>(retired.m_PresentFences.size()), retired.m_PresentFences.data()), "Failed to reset the present fences!");
+						m_FreeFences.insert(m_FreeFences.end(), retired.m_PresentFences.begin(), retired.m_PresentFences.end());
+					}
+
+					// The last frame which rendered to the swapchain might still be running, so it's destroyed once the graphics timeline passes the
+					// frame's work. Without present fences, that's also all we know about the presentation engine.
+					for (const auto view : retired.m_ImageViews)
+						deletionQueue.retire(view);
+
+					deletionQueue.retire([&deviceTable, swapchain = retired.m_Swapchain](VkDevice device)
+						{
+							deviceTable.vkDestroySwapchainKHR(device, swapchain, nullptr);
+						}
+					);
+
+					return true;
+				}
+			);
+		}
+	);
+}
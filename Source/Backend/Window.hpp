@@ -4,11 +4,26 @@
 
 #include "InstanceBoundObject.hpp"
 
+#include "Core/Event.hpp"
+
 #include <string_view>
 #include <vector>
 
 struct SDL_Window;
 
+/**
+ * Present mode enum.
+ * This defines how the swapchain images are presented and lets the user trade latency against throughput.
+ * If the requested mode is not supported by the surface, the closest supported mode is used instead.
+ */
+enum class PresentMode : uint8_t
+{
+	Immediate,		// Lowest latency. Frames are presented right away and can tear.
+	FIFORelaxed,	// Vertical sync, but late frames are presented right away and can tear.
+	Mailbox,		// Vertical sync without blocking. The latest frame replaces the queued one.
+	FIFO			// Vertical sync. Always supported.
+};
+
 /**
  * Window class.
  * This class contains a single window instance used by the engine and contains the event system.
@@ -21,8 +36,11 @@ public:
 	 *
 	 * @param instance The instance reference.
 	 * @param title The title of the window.
+	 * @param width The initial width of the window.
+	 * @param height The initial height of the window.
+	 * @param presentMode The initial present mode. Default is mailbox.
 	 */
-	explicit Window(Instance& instance, std::string_view title);
+	explicit Window(Instance& instance, std::string_view title, uint32_t width = 1280, uint32_t height = 720, PresentMode presentMode = PresentMode::Mailbox);
 
 	/**
 	 * Destructor.
@@ -31,19 +49,82 @@ public:
 
 	/**
 	 * Update the window.
-	 * This will also poll for inputs.
+	 * This will also poll for inputs and push the converted events to all the registered event queues.
 	 */
 	void update();
 
+	/**
+	 * Register an event queue.
+	 * Every consumer system should own it's own queue so the events can be consumed from any thread without locking.
+	 *
+	 * @param pQueue The queue pointer. Make sure that the queue outlives the window or is removed before destroying it.
+	 */
+	void addEventQueue(EventQueue* pQueue);
+
+	/**
+	 * Remove a previously registered event queue.
+	 *
+	 * @param pQueue The queue pointer.
+	 */
+	void removeEventQueue(EventQueue* pQueue);
+
+	/**
+	 * Acquire the next swapchain image.
+	 * If the swapchain is out of date, it's marked for recreation and false is returned. The frame should be skipped in that case.
+	 *
+	 * @param signalSemaphore The semaphore to signal when the image is ready.
+	 * @param imageIndex The variable to store the acquired image index.
+	 * @return True if an image was acquired.
+	 */
+	[[nodiscard]] bool acquireNextImage(VkSemaphore signalSemaphore, uint32_t& imageIndex);
+
+	/**
+	 * Present a previously acquired swapchain image.
+	 * If the swapchain is out of date or suboptimal, it's marked for recreation.
+	 *
+	 * @param waitSemaphore The semaphore to wait on before presenting.
+	 * @param imageIndex The image index to present.
+	 */
+	void present(VkSemaphore waitSemaphore, uint32_t imageIndex);
+
+	/**
+	 * Wait till a present with the given ID (or a later one) is displayed.
+	 * This requires VK_KHR_present_wait. If it's not supported, or the ID was presented to a swapchain which was recreated since, this returns
+	 * false right away.
+	 *
+	 * @param presentID The present ID to wait for.
+	 * @param timeout The timeout in nanoseconds.
+	 * @return True if the present was displayed before the timeout.
+	 */
+	[[nodiscard]] bool waitForPresent(uint64_t presentID, uint64_t timeout);
+
+	/**
+	 * Set the present mode.
+	 * The swapchain is recreated in the next update.
+	 *
+	 * @param mode The present mode to use.
+	 */
+	void setPresentMode(PresentMode mode);
+
 public:
 	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, Width, m_Width);
 	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, Height, m_Height);
 	GRAPHITE_SETUP_SIMPLE_GETTER(VkSurfaceKHR, Surface, m_Surface);
 	GRAPHITE_SETUP_SIMPLE_GETTER(VkSwapchainKHR, Swapchain, m_Swapchain);
+	GRAPHITE_SETUP_SIMPLE_GETTER(VkFormat, SwapchainFormat, m_SwapchainFormat);
+	GRAPHITE_SETUP_SIMPLE_GETTER(PresentMode, PresentMode, m_PresentMode);
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, FrameCount, m_FrameCount);
+	GRAPHITE_SETUP_SIMPLE_GETTER(bool, IsMinimized, m_bIsMinimized);
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint64_t, PresentID, m_PresentID);
+	GRAPHITE_SETUP_SIMPLE_GETTER(bool, SupportsPresentWait, m_bSupportsPresentWait);
+
+	GRAPHITE_SETUP_GETTERS(std::vector<VkImage>, SwapchainImages, m_SwapchainImages);
+	GRAPHITE_SETUP_GETTERS(std::vector<VkImageView>, SwapchainImageViews, m_SwapchainImageViews);
 
 private:
 	/**
 	 * Setup the swapchain.
+	 * If a swapchain already exists, it's passed in as the old swapchain and retired.
 	 */
 	void setupSwapchain();
 
@@ -52,9 +133,52 @@ private:
 	 */
 	void setupImageViews();
 
+	/**
+	 * Publish an event to all the registered queues.
+	 *
+	 * @param event The event to publish.
+	 */
+	void publishEvent(const Event& event);
+
+	/**
+	 * Get a fence to signal when a present is done.
+	 * The fences of the finished presents are reused.
+	 *
+	 * @return The fence handle.
+	 */
+	[[nodiscard]] VkFence getPresentFence();
+
+	/**
+	 * Retire the current swapchain, along with it's image views and present fences.
+	 */
+	void retireSwapchain();
+
+	/**
+	 * Hand the retired swapchains which the presentation engine is done with to the instance's deletion queue.
+	 * Without present fences, there is no way to know that, so they're handed over right away.
+	 *
+	 * @param wait Whether to wait till the presentation engine is done with all of them.
+	 */
+	void releaseRetiredSwapchains(bool wait);
+
 private:
+	/**
+	 * Retired swapchain structure.
+	 * Swapchains are not destroyed right away when recreating since the previous frames and presents might still be using them.
+	 */
+	struct RetiredSwapchain final
+	{
+		std::vector<VkImageView> m_ImageViews;
+		std::vector<VkFence> m_PresentFences;
+		VkSwapchainKHR m_Swapchain = VK_NULL_HANDLE;
+	};
+
 	std::vector<VkImage> m_SwapchainImages;
 	std::vector<VkImageView> m_SwapchainImageViews;
+	std::vector<RetiredSwapchain> m_RetiredSwapchains;
+	std::vector<VkFence> m_PresentFences;
+	std::vector<VkFence> m_FreeFences;
+	std::vector<EventQueue*> m_pEventQueues;
 
 	SDL_Window* m_pWindow = nullptr;
 
@@ -63,8 +187,18 @@ private:
 
 	uint32_t m_FrameCount = 0;
 
+	uint64_t m_PresentID = 0;
+	uint64_t m_FirstPresentID = 0;
+
 	VkSurfaceKHR m_Surface = VK_NULL_HANDLE;
 	VkSwapchainKHR m_Swapchain = VK_NULL_HANDLE;
 
 	VkFormat m_SwapchainFormat = VK_FORMAT_UNDEFINED;
+
+	PresentMode m_PresentMode = PresentMode::Mailbox;
+
+	bool m_bShouldRecreateSwapchain = false;
+	bool m_bIsMinimized = false;
+	bool m_bSupportsPresentWait = false;
+	bool m_bSupportsPresentFence = false;
 };
\ No newline at end of file
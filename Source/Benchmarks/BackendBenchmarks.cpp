@@ -0,0 +1,468 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "Benchmark.hpp"
+
+#include "Backend/Platform.hpp"
+#include "Backend/Instance.hpp"
+#include "Backend/CommandSubmissionQueue.hpp"
+#include "Backend/Buffer.hpp"
+#include "Backend/Image.hpp"
+#include "Backend/IndirectDrawList.hpp"
+#include "Backend/DepthPyramid.hpp"
+#include "Backend/VulkanMacros.hpp"
+
+#include <cmath>
+#include <memory>
+#include <random>
+
+namespace /* anonymous */
+{
+	// Every benchmark which needs random data uses this seed, so the runs are reproducible.
+	constexpr uint32_t g_Seed = 0xbb67ae85;
+
+	// The resolution of the headless frames.
+	constexpr uint32_t g_FrameWidth = 1920;
+	constexpr uint32_t g_FrameHeight = 1080;
+
+	/**
+	 * Benchmark device class.
+	 * This contains the platform, the instance and the submission queue shared by all the Vulkan benchmarks. It's created the first time a
+	 * benchmark needs it, so the benchmarks which don't use Vulkan can run on machines without a device.
+	 *
+	 * To run the benchmarks headless on lavapipe, point the Vulkan loader to it with VK_DRIVER_FILES (or VK_ICD_FILENAMES with older loaders),
+	 * and use SDL's offscreen video driver with SDL_VIDEODRIVER=offscreen.
+	 */
+	class BenchmarkDevice final
+	{
+	public:
+		/**
+		 * Default constructor.
+		 */
+		BenchmarkDevice()
+		{
+			m_Instance.waitForDevice();
+			if (!isValid())
+				return;
+
+			VkPhysicalDeviceProperties properties = {};
+			vkGetPhysicalDeviceProperties(m_Instance.getPhysicalDevice().getUnsafe(), &properties);
+
+			BenchmarkRegistry::AddContext("device", properties.deviceName);
+			BenchmarkRegistry::AddContext("driver_version", std::to_string(properties.driverVersion));
+			BenchmarkRegistry::AddContext("vulkan_version", fmt::format("{}.{}.{}", VK_API_VERSION_MAJOR(properties.apiVersion), VK_API_VERSION_MINOR(properties.apiVersion), VK_API_VERSION_PATCH(properties.apiVersion)));
+
+			m_pSubmissionQueue = std::make_unique<CommandSubmissionQueue>(m_Instance);
+		}
+
+		/**
+		 * Destructor.
+		 */
+		~BenchmarkDevice()
+		{
+			m_pSubmissionQueue.reset();
+		}
+
+		GRAPHITE_DISABLE_COPY_AND_MOVE(BenchmarkDevice);
+
+		/**
+		 * Get the shared device.
+		 *
+		 * @return The device reference.
+		 */
+		[[nodiscard]] static BenchmarkDevice& Get()
+		{
+			static BenchmarkDevice device;
+			return device;
+		}
+
+		/**
+		 * Check if a Vulkan device was created.
+		 *
+		 * @return True if the device can be used.
+		 */
+		[[nodiscard]] bool isValid() const { return m_Instance.getLogicalDevice().getUnsafe() != VK_NULL_HANDLE; }
+
+	public:
+		GRAPHITE_SETUP_GETTERS(Instance, Instance, m_Instance);
+		GRAPHITE_SETUP_GETTERS(CommandSubmissionQueue, SubmissionQueue, *m_pSubmissionQueue);
+
+	private:
+		Platform m_Platform;
+		Instance m_Instance;
+
+		std::unique_ptr<CommandSubmissionQueue> m_pSubmissionQueue;
+	};
+
+	/**
+	 * Get the benchmark device, or skip the benchmark if there's none.
+	 *
+	 * @param state The benchmark state.
+	 * @return The device pointer. This is null if the benchmark is skipped.
+	 */
+	[[nodiscard]] BenchmarkDevice* GetDevice(BenchmarkState& state)
+	{
+		auto& device = BenchmarkDevice::Get();
+		if (device.isValid())
+			return &device;
+
+		state.skip("No Vulkan device is available.");
+		return nullptr;
+	}
+
+	/**
+	 * Create a column major view projection matrix of a camera orbiting the origin.
+	 *
+	 * @param angle The orbit angle in radians.
+	 * @param distance The orbit distance.
+	 * @return The matrix.
+	 */
+	[[nodiscard]] std::array<float, 16> CreateOrbitViewProjection(float angle, float distance)
+	{
+		constexpr float fieldOfView = 1.0f;
+		constexpr float aspectRatio = static_cast<float>(g_FrameWidth) / static_cast<float>(g_FrameHeight);
+		constexpr float nearPlane = 0.1f;
+		constexpr float farPlane = 1000.0f;
+
+		// The camera looks at the origin from the orbit, with the Y axis up.
+		const std::array<float, 3> eye = { std::sin(angle) * distance, 0.0f, std::cos(angle) * distance };
+		const std::array<float, 3> forward = { -eye[0] / distance, 0.0f, -eye[2] / distance };
+		const std::array<float, 3> right = { -forward[2], 0.0f, forward[0] };
+		const std::array<float, 3> up = { 0.0f, 1.0f, 0.0f };
+
+		// Vulkan style projection with the Y axis down and depth in [0, 1].
+		const auto focalLength = 1.0f / std::tan(fieldOfView * 0.5f);
+		const auto x = focalLength / aspectRatio;
+		const auto y = -focalLength;
+		const auto a = farPlane / (nearPlane - farPlane);
+		const auto b = nearPlane * farPlane / (nearPlane - farPlane);
+
+		// The view space is right handed, looking down -Z.
+		const auto dot = [](const std::array<float, 3>& lhs, const std::array<float, 3>& rhs) { return lhs[0] * rhs[0] + lhs[1] * rhs[1] + lhs[2] * rhs[2]; };
+		const std::array<float, 3> translation = { -dot(right, eye), -dot(up, eye), dot(forward, eye) };
+
+		std::array<float, 16> matrix = {};
+		for (uint32_t column = 0; column < 3; column++)
+		{
+			matrix[column * 4 + 0] = x * right[column];
+			matrix[column * 4 + 1] = y * up[column];
+			matrix[column * 4 + 2] = a * -forward[column];
+			matrix[column * 4 + 3] = forward[column];
+		}
+
+		matrix[12] = x * translation[0];
+		matrix[13] = y * translation[1];
+		matrix[14] = a * translation[2] + b;
+		matrix[15] = -translation[2];
+
+		return matrix;
+	}
+
+	/**
+	 * Headless frame class.
+	 * This records the GPU-driven part of a frame without a swapchain: the depth buffer is cleared, the instances are culled against the frustum,
+	 * the depth pyramid is built and the instances are culled against it.
+	 */
+	class HeadlessFrame final
+	{
+	public:
+		/**
+		 * Explicit constructor.
+		 *
+		 * @param device The benchmark device.
+		 * @param instanceCount The number of instances in the synthetic scene.
+		 */
+		explicit HeadlessFrame(BenchmarkDevice& device, uint32_t instanceCount)
+			: m_Device(device)
+			, m_DepthImage(device.getInstance(), ImageBuilder().setWidth(g_FrameWidth).setHeight(g_FrameHeight).setEnableMipMaps(false).setUsage(VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT), VK_FORMAT_D32_SFLOAT)
+			, m_DepthView(createDepthView())
+			, m_DrawList(device.getInstance(), instanceCount)
+			, m_Pyramid(device.getInstance(), m_DepthView, g_FrameWidth, g_FrameHeight)
+		{
+			auto& instance = device.getInstance();
+
+			// Scatter the instances in a cube around the origin.
+			std::mt19937 generator(g_Seed);
+			std::uniform_real_distribution<float> positions(-200.0f, 200.0f);
+			std::uniform_real_distribution<float> radii(0.5f, 4.0f);
+			std::uniform_int_distribution<uint32_t> meshes(0, 63);
+
+			std::vector<DrawInstance> instances(instanceCount);
+			for (auto& drawInstance : instances)
+			{
+				drawInstance.m_BoundingSphere = { positions(generator), positions(generator), positions(generator), radii(generator) };
+				drawInstance.m_IndexCount = 36;
+				drawInstance.m_FirstIndex = meshes(generator) * 36;
+			}
+
+			m_DrawList.setInstances(instances);
+			m_DrawList.setOcclusionCulling(true);
+
+			// Create the command pool and the command buffer.
+			VkCommandPoolCreateInfo createInfo = {};
+			createInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			createInfo.pNext = nullptr;
+			createInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+			createInfo.queueFamilyIndex = instance.getGraphicsQueue().getUnsafe().m_Family;
+
+			instance.getLogicalDevice().access([this, &instance, &createInfo](VkDevice logicalDevice)
+				{
+					GRAPHITE_VK_ASSERT(instance.getDeviceTable().vkCreateCommandPool(logicalDevice, &createInfo, nullptr, &m_CommandPool), "Failed to create the benchmark command pool!");
+
+					VkCommandBufferAllocateInfo allocateInfo = {};
+					allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+					allocateInfo.pNext = nullptr;
+					allocateInfo.commandPool = m_CommandPool;
+					allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+					allocateInfo.commandBufferCount = 1;
+
+					GRAPHITE_VK_ASSERT(instance.getDeviceTable().vkAllocateCommandBuffers(logicalDevice, &allocateInfo, &m_CommandBuffer), "Failed to allocate the benchmark command buffer!");
+				}
+			);
+		}
+
+		/**
+		 * Destructor.
+		 */
+		~HeadlessFrame()
+		{
+			auto& instance = m_Device.getInstance();
+			instance.waitIdle();
+
+			instance.getDeletionQueue().retire(m_DepthView);
+			instance.getLogicalDevice().access([&instance, commandPool = m_CommandPool](VkDevice logicalDevice)
+				{
+					instance.getDeviceTable().vkDestroyCommandPool(logicalDevice, commandPool, nullptr);
+				}
+			);
+		}
+
+		GRAPHITE_DISABLE_COPY_AND_MOVE(HeadlessFrame);
+
+		/**
+		 * Check if the frame can be rendered.
+		 * The culling and the depth pyramid shaders come from the engine build, and without them the frame would only submit empty work.
+		 *
+		 * @return True if all the passes can run.
+		 */
+		[[nodiscard]] bool isValid() const { return m_DrawList.isValid() && m_DrawList.getIsOcclusionCulling() && m_Pyramid.isValid(); }
+
+		/**
+		 * Render a frame and wait till the GPU is done with it.
+		 *
+		 * @param angle The camera orbit angle.
+		 */
+		void render(float angle)
+		{
+			auto& instance = m_Device.getInstance();
+			auto& submissionQueue = m_Device.getSubmissionQueue();
+			const auto& deviceTable = instance.getDeviceTable();
+
+			VkCommandBufferBeginInfo beginInfo = {};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.pNext = nullptr;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			beginInfo.pInheritanceInfo = nullptr;
+
+			GRAPHITE_VK_ASSERT(deviceTable.vkResetCommandBuffer(m_CommandBuffer, 0), "Failed to reset the benchmark command buffer!");
+			GRAPHITE_VK_ASSERT(deviceTable.vkBeginCommandBuffer(m_CommandBuffer, &beginInfo), "Failed to begin the benchmark command buffer!");
+
+			const auto viewProjection = CreateOrbitViewProjection(angle, 300.0f);
+
+			// The first phase would draw the instances which were visible in the last frame into the depth buffer.
+			recordDepthClear();
+			m_DrawList.cull(m_CommandBuffer, Frustum::FromViewProjection(viewProjection));
+
+			// The second phase tests everything against the depth of the first one.
+			m_Pyramid.build(m_CommandBuffer);
+			m_DrawList.cullOcclusion(m_CommandBuffer, viewProjection, m_Pyramid);
+
+			GRAPHITE_VK_ASSERT(deviceTable.vkEndCommandBuffer(m_CommandBuffer), "Failed to end the benchmark command buffer!");
+
+			const auto value = submissionQueue.enqueue(QueueType::Graphics, std::span<const VkCommandBuffer>(&m_CommandBuffer, 1));
+			submissionQueue.flush();
+			submissionQueue.wait(QueueType::Graphics, value);
+		}
+
+	private:
+		/**
+		 * Create the depth buffer's view.
+		 *
+		 * @return The image view.
+		 */
+		[[nodiscard]] VkImageView createDepthView()
+		{
+			VkImageViewCreateInfo createInfo = {};
+			createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			createInfo.pNext = nullptr;
+			createInfo.flags = 0;
+			createInfo.image = m_DepthImage.getImage();
+			createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			createInfo.format = m_DepthImage.getFormat();
+			createInfo.components = { VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY };
+			createInfo.subresourceRange = VkImageSubresourceRange{ VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1 };
+
+			auto& instance = m_Device.getInstance();
+
+			VkImageView view = VK_NULL_HANDLE;
+			instance.getLogicalDevice().access([&instance, &createInfo, &view](VkDevice logicalDevice)
+				{
+					GRAPHITE_VK_ASSERT(instance.getDeviceTable().vkCreateImageView(logicalDevice, &createInfo, nullptr, &view), "Failed to create the benchmark depth view!");
+				}
+			);
+
+			return view;
+		}
+
+		/**
+		 * Record the depth buffer clear, and leave it in the layout the depth pyramid reads it in.
+		 */
+		void recordDepthClear()
+		{
+			const auto& deviceTable = m_Device.getInstance().getDeviceTable();
+			const auto range = VkImageSubresourceRange{ VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1 };
+
+			VkImageMemoryBarrier2KHR barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+			barrier.pNext = nullptr;
+			barrier.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR;
+			barrier.srcAccessMask = VK_ACCESS_2_NONE_KHR;
+			barrier.dstStageMask = VK_PIPELINE_STAGE_2_CLEAR_BIT_KHR;
+			barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = m_DepthImage.getImage();
+			barrier.subresourceRange = range;
+
+			VkDependencyInfoKHR dependencyInfo = {};
+			dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+			dependencyInfo.pNext = nullptr;
+			dependencyInfo.dependencyFlags = 0;
+			dependencyInfo.imageMemoryBarrierCount = 1;
+			dependencyInfo.pImageMemoryBarriers = &barrier;
+
+			deviceTable.vkCmdPipelineBarrier2KHR(m_CommandBuffer, &dependencyInfo);
+
+			// Clear to the far plane.
+			const VkClearDepthStencilValue clearValue = { 1.0f, 0 };
+			deviceTable.vkCmdClearDepthStencilImage(m_CommandBuffer, m_DepthImage.getImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearValue, 1, &range);
+
+			barrier.srcStageMask = VK_PIPELINE_STAGE_2_CLEAR_BIT_KHR;
+			barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR;
+			barrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR;
+			barrier.dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT_KHR;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+			deviceTable.vkCmdPipelineBarrier2KHR(m_CommandBuffer, &dependencyInfo);
+		}
+
+	private:
+		BenchmarkDevice& m_Device;
+
+		Image m_DepthImage;
+		VkImageView m_DepthView = VK_NULL_HANDLE;
+
+		IndirectDrawList m_DrawList;
+		DepthPyramid m_Pyramid;
+
+		VkCommandPool m_CommandPool = VK_NULL_HANDLE;
+		VkCommandBuffer m_CommandBuffer = VK_NULL_HANDLE;
+	};
+}
+
+/**
+ * Buffer creation through VMA.
+ * The argument is the buffer size in bytes.
+ */
+GRAPHITE_BENCHMARK_ARGUMENTS(BufferCreation, 4096, 1 << 20, 64 << 20)
+{
+	auto pDevice = GetDevice(state);
+	if (!pDevice)
+		return;
+
+	auto& instance = pDevice->getInstance();
+	while (state.keepRunning())
+	{
+		const auto data = Buffer::Allocate(instance, state.getArgument(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+
+		state.pauseTiming();
+		instance.getDeletionQueue().retire(data.m_Buffer, data.m_Allocation);
+		instance.getDeletionQueue().releaseAll();
+		state.resumeTiming();
+	}
+}
+
+/**
+ * Image creation through VMA.
+ * The argument is the width and the height of the image, which has a full mip chain.
+ */
+GRAPHITE_BENCHMARK_ARGUMENTS(ImageCreation, 256, 1024, 4096)
+{
+	auto pDevice = GetDevice(state);
+	if (!pDevice)
+		return;
+
+	auto& instance = pDevice->getInstance();
+	const auto size = static_cast<uint32_t>(state.getArgument());
+	const auto builder = ImageBuilder().setWidth(size).setHeight(size);
+
+	while (state.keepRunning())
+	{
+		const auto data = Image::Allocate(instance, builder, VK_FORMAT_R8G8B8A8_UNORM);
+
+		state.pauseTiming();
+		instance.getDeletionQueue().retire(data.m_Image, data.m_Allocation);
+		instance.getDeletionQueue().releaseAll();
+		state.resumeTiming();
+	}
+}
+
+/**
+ * Image format resolution from a candidate list, where the first candidates are rarely supported.
+ */
+GRAPHITE_BENCHMARK(FormatResolution)
+{
+	auto pDevice = GetDevice(state);
+	if (!pDevice)
+		return;
+
+	auto& instance = pDevice->getInstance();
+	const auto builder = ImageBuilder().setWidth(1024).setHeight(1024);
+	const std::vector<VkFormat> candidates = {
+		VK_FORMAT_ASTC_4x4_SRGB_BLOCK,
+		VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK,
+		VK_FORMAT_BC7_SRGB_BLOCK,
+		VK_FORMAT_R8G8B8A8_SRGB
+	};
+
+	while (state.keepRunning())
+		DoNotOptimize(Image::ResolveFormat(instance, builder, candidates));
+}
+
+/**
+ * A headless GPU-driven frame of a synthetic scene, including the GPU time.
+ * The argument is the instance count of the scene.
+ */
+GRAPHITE_BENCHMARK_ARGUMENTS(HeadlessCullingFrame, 1024, 16384, 131072)
+{
+	auto pDevice = GetDevice(state);
+	if (!pDevice)
+		return;
+
+	HeadlessFrame frame(*pDevice, static_cast<uint32_t>(state.getArgument()));
+	if (!frame.isValid())
+	{
+		state.skip("The culling shaders are not available.");
+		return;
+	}
+
+	// The camera moves by the same amount every frame, so every run renders the same sequence of frames.
+	float angle = 0.0f;
+	while (state.keepRunning())
+	{
+		frame.render(angle);
+		angle += 0.01f;
+	}
+}
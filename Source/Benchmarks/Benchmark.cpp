@@ -0,0 +1,299 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "Benchmark.hpp"
+
+#include "Core/Logging.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace /* anonymous */
+{
+	// The largest iteration count of a repetition, so a benchmark which measures nothing does not run forever.
+	constexpr uint64_t g_MaximumIterations = 1'000'000'000;
+
+	/**
+	 * Format a number as a JSON value.
+	 * JSON has no infinity or NaN, so those are written as null.
+	 *
+	 * @param value The value.
+	 * @param precision The number of decimals. A negative precision writes the shortest exact representation.
+	 * @return The formatted value.
+	 */
+	[[nodiscard]] std::string FormatJSONNumber(double value, int32_t precision)
+	{
+		if (!std::isfinite(value))
+			return "null";
+
+		return precision < 0 ? fmt::format("{}", value) : fmt::format("{:.{}f}", value, precision);
+	}
+
+	/**
+	 * Escape a string so it can be written into a JSON string.
+	 *
+	 * @param string The string to escape.
+	 * @return The escaped string.
+	 */
+	[[nodiscard]] std::string EscapeJSON(std::string_view string)
+	{
+		std::string escaped;
+		escaped.reserve(string.size());
+
+		for (const auto character : string)
+		{
+			switch (character)
+			{
+			case '"':
+				escaped += "\\\"";
+				break;
+
+			case '\\':
+				escaped += "\\\\";
+				break;
+
+			case '\n':
+				escaped += "\\n";
+				break;
+
+			default:
+				if (static_cast<unsigned char>(character) < 0x20)
+					escaped += fmt::format("\\u{:04x}", static_cast<unsigned char>(character));
+
+				else
+					escaped += character;
+
+				break;
+			}
+		}
+
+		return escaped;
+	}
+
+	/**
+	 * Format a number of nanoseconds with a readable unit.
+	 *
+	 * @param nanoseconds The nanoseconds.
+	 * @return The formatted string.
+	 */
+	[[nodiscard]] std::string FormatTime(double nanoseconds)
+	{
+		if (nanoseconds >= 1e9)
+			return fmt::format("{:.3f} s", nanoseconds / 1e9);
+
+		if (nanoseconds >= 1e6)
+			return fmt::format("{:.3f} ms", nanoseconds / 1e6);
+
+		if (nanoseconds >= 1e3)
+			return fmt::format("{:.3f} us", nanoseconds / 1e3);
+
+		return fmt::format("{:.3f} ns", nanoseconds);
+	}
+}
+
+BenchmarkState::BenchmarkState(uint64_t iterations, uint64_t argument)
+	: m_Iterations(iterations)
+	, m_Remaining(iterations)
+	, m_Argument(argument)
+{
+}
+
+void BenchmarkState::skip(std::string_view reason)
+{
+	m_SkipReason = reason;
+	m_Remaining = 0;
+}
+
+void BenchmarkState::setCounter(std::string_view name, double value)
+{
+	const auto counter = GRAPHITE_RANGES(find_if, m_Counters, [name](const auto& entry) { return entry.first == name; });
+	if (counter != m_Counters.end())
+		counter->second = value;
+
+	else
+		m_Counters.emplace_back(name, value);
+}
+
+bool BenchmarkRegistry::Register(std::string_view name, std::function<void(BenchmarkState&)> function)
+{
+	GetEntries().emplace_back(std::string(name), std::move(function), 0);
+	return true;
+}
+
+bool BenchmarkRegistry::Register(std::string_view name, std::function<void(BenchmarkState&)> function, std::initializer_list<uint64_t> arguments)
+{
+	for (const auto argument : arguments)
+		GetEntries().emplace_back(fmt::format("{}/{}", name, argument), function, argument);
+
+	return true;
+}
+
+std::vector<BenchmarkResult> BenchmarkRegistry::Run(std::string_view filter, uint32_t repetitions, std::chrono::milliseconds minimumTime)
+{
+	std::vector<BenchmarkResult> results;
+	for (const auto& entry : GetEntries())
+	{
+		if (!filter.empty() && entry.m_Name.find(filter) == std::string::npos)
+			continue;
+
+		GRAPHITE_LOG_INFORMATION("Running {}...", entry.m_Name);
+		results.emplace_back(RunEntry(entry, std::max(repetitions, 1u), minimumTime));
+	}
+
+	return results;
+}
+
+void BenchmarkRegistry::AddContext(std::string_view name, std::string_view value)
+{
+	auto& context = GetContext();
+	const auto entry = GRAPHITE_RANGES(find_if, context, [name](const auto& entry) { return entry.first == name; });
+	if (entry != context.end())
+		entry->second = value;
+
+	else
+		context.emplace_back(name, value);
+}
+
+std::vector<std::pair<std::string, std::string>>& BenchmarkRegistry::GetContext()
+{
+	static std::vector<std::pair<std::string, std::string>> context;
+	return context;
+}
+
+std::vector<std::string> BenchmarkRegistry::GetNames()
+{
+	std::vector<std::string> names;
+	for (const auto& entry : GetEntries())
+		names.emplace_back(entry.m_Name);
+
+	return names;
+}
+
+void BenchmarkRegistry::WriteJSON(std::ostream& stream, const std::vector<BenchmarkResult>& results, const std::vector<std::pair<std::string, std::string>>& context)
+{
+	stream << "{\n  \"context\": {\n";
+	for (size_t i = 0; i < context.size(); i++)
+		stream << fmt::format("    \"{}\": \"{}\"{}\n", EscapeJSON(context[i].first), EscapeJSON(context[i].second), i + 1 < context.size() ? "," : "");
+
+	stream << "  },\n  \"benchmarks\": [\n";
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const auto& result = results[i];
+		stream << fmt::format("    {{ \"name\": \"{}\"", EscapeJSON(result.m_Name));
+
+		if (!result.m_SkipReason.empty())
+		{
+			stream << fmt::format(", \"skipped\": \"{}\"", EscapeJSON(result.m_SkipReason));
+		}
+		else
+		{
+			stream << fmt::format(
+				", \"iterations\": {}, \"repetitions\": {}, \"time_unit\": \"ns\", \"min\": {}, \"median\": {}, \"mean\": {}, \"stddev\": {}",
+				result.m_Iterations,
+				result.m_Repetitions,
+				FormatJSONNumber(result.m_Minimum, 3),
+				FormatJSONNumber(result.m_Median, 3),
+				FormatJSONNumber(result.m_Mean, 3),
+				FormatJSONNumber(result.m_Deviation, 3)
+			);
+
+			if (!result.m_Counters.empty())
+			{
+				stream << ", \"counters\": { ";
+				for (size_t c = 0; c < result.m_Counters.size(); c++)
+					stream << fmt::format("\"{}\": {}{}", EscapeJSON(result.m_Counters[c].first), FormatJSONNumber(result.m_Counters[c].second, -1), c + 1 < result.m_Counters.size() ? ", " : " ");
+
+				stream << "}";
+			}
+		}
+
+		stream << (i + 1 < results.size() ? " },\n" : " }\n");
+	}
+
+	stream << "  ]\n}\n";
+}
+
+void BenchmarkRegistry::WriteTable(std::ostream& stream, const std::vector<BenchmarkResult>& results)
+{
+	size_t nameWidth = 9;
+	for (const auto& result : results)
+		nameWidth = std::max(nameWidth, result.m_Name.size());
+
+	stream << fmt::format("{:<{}} {:>14} {:>14} {:>14} {:>12}\n", "Benchmark", nameWidth, "Median", "Minimum", "Deviation", "Iterations");
+	for (const auto& result : results)
+	{
+		if (!result.m_SkipReason.empty())
+		{
+			stream << fmt::format("{:<{}} skipped: {}\n", result.m_Name, nameWidth, result.m_SkipReason);
+			continue;
+		}
+
+		stream << fmt::format("{:<{}} {:>14} {:>14} {:>14} {:>12}", result.m_Name, nameWidth, FormatTime(result.m_Median), FormatTime(result.m_Minimum), FormatTime(result.m_Deviation), result.m_Iterations);
+		for (const auto& [name, value] : result.m_Counters)
+			stream << fmt::format(" {}={:.3f}", name, value);
+
+		stream << "\n";
+	}
+}
+
+std::vector<BenchmarkRegistry::Entry>& BenchmarkRegistry::GetEntries()
+{
+	static std::vector<Entry> entries;
+	return entries;
+}
+
+BenchmarkResult BenchmarkRegistry::RunEntry(const Entry& entry, uint32_t repetitions, std::chrono::nanoseconds minimumTime)
+{
+	BenchmarkResult result;
+	result.m_Name = entry.m_Name;
+
+	// Find the iteration count which takes the minimum time. This also warms up the caches and the allocators.
+	uint64_t iterations = 1;
+	while (true)
+	{
+		BenchmarkState state(iterations, entry.m_Argument);
+		entry.m_Function(state);
+
+		if (!state.getSkipReason().empty())
+		{
+			result.m_SkipReason = state.getSkipReason();
+			return result;
+		}
+
+		const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(state.getElapsed());
+		if (elapsed >= minimumTime || iterations >= g_MaximumIterations)
+			break;
+
+		// Aim a bit over the minimum time, but don't grow too fast from a noisy measurement.
+		const auto scale = elapsed.count() > 0 ? 1.4 * static_cast<double>(minimumTime.count()) / static_cast<double>(elapsed.count()) : 10.0;
+		iterations = std::min(static_cast<uint64_t>(static_cast<double>(iterations) * std::clamp(scale, 2.0, 10.0)), g_MaximumIterations);
+	}
+
+	// Run the repetitions.
+	std::vector<double> times;
+	times.reserve(repetitions);
+
+	for (uint32_t i = 0; i < repetitions; i++)
+	{
+		BenchmarkState state(iterations, entry.m_Argument);
+		entry.m_Function(state);
+
+		times.emplace_back(static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(state.getElapsed()).count()) / static_cast<double>(iterations));
+		result.m_Counters = state.getCounters();
+	}
+
+	std::sort(times.begin(), times.end());
+
+	const auto mean = std::accumulate(times.begin(), times.end(), 0.0) / static_cast<double>(times.size());
+	const auto variance = std::accumulate(times.begin(), times.end(), 0.0, [mean](double sum, double time) { return sum + (time - mean) * (time - mean); }) / static_cast<double>(times.size());
+	const auto middle = times.size() / 2;
+
+	result.m_Iterations = iterations;
+	result.m_Repetitions = repetitions;
+	result.m_Minimum = times.front();
+	result.m_Median = times.size() % 2 == 0 ? (times[middle - 1] + times[middle]) * 0.5 : times[middle];
+	result.m_Mean = mean;
+	result.m_Deviation = std::sqrt(variance);
+
+	return result;
+}
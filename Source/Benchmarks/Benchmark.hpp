@@ -0,0 +1,273 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "Core/Common.hpp"
+
+#include <chrono>
+#include <functional>
+#include <initializer_list>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using BenchmarkCounters = std::vector<std::pair<std::string, double>>;
+
+/**
+ * Benchmark state class.
+ * This is passed to a benchmark function, which runs it's measured code in a loop while keepRunning() returns true. The setup before the loop is
+ * not measured, and the work inside the loop which should not be measured can be excluded with pauseTiming() and resumeTiming().
+ */
+class BenchmarkState final
+{
+	using Clock = std::chrono::steady_clock;
+
+public:
+	/**
+	 * Explicit constructor.
+	 *
+	 * @param iterations The number of iterations to run.
+	 * @param argument The benchmark argument.
+	 */
+	explicit BenchmarkState(uint64_t iterations, uint64_t argument);
+
+	/**
+	 * Check if the loop should run another iteration.
+	 * The timer is started by the first call and stopped by the last one.
+	 *
+	 * @return True if another iteration should run.
+	 */
+	[[nodiscard]] bool keepRunning()
+	{
+		if (m_Remaining == m_Iterations)
+			m_Start = Clock::now();
+
+		if (m_Remaining > 0)
+		{
+			m_Remaining--;
+			return true;
+		}
+
+		m_Elapsed += Clock::now() - m_Start;
+		return false;
+	}
+
+	/**
+	 * Stop measuring the time.
+	 * The timing must be resumed before the next keepRunning() call.
+	 */
+	void pauseTiming() { m_Elapsed += Clock::now() - m_Start; }
+
+	/**
+	 * Start measuring the time again.
+	 */
+	void resumeTiming() { m_Start = Clock::now(); }
+
+	/**
+	 * Skip the benchmark.
+	 * This is used when the benchmark cannot run in the current environment, like when there's no Vulkan device.
+	 *
+	 * @param reason The reason to report.
+	 */
+	void skip(std::string_view reason);
+
+	/**
+	 * Set a counter, which is reported next to the timings.
+	 * If it's set in every repetition, the last value is reported.
+	 *
+	 * @param name The counter name.
+	 * @param value The counter value.
+	 */
+	void setCounter(std::string_view name, double value);
+
+public:
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint64_t, Iterations, m_Iterations);
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint64_t, Argument, m_Argument);
+	GRAPHITE_SETUP_SIMPLE_GETTER(Clock::duration, Elapsed, m_Elapsed);
+	GRAPHITE_SETUP_GETTERS(std::string, SkipReason, m_SkipReason);
+	GRAPHITE_SETUP_GETTERS(BenchmarkCounters, Counters, m_Counters);
+
+private:
+	BenchmarkCounters m_Counters;
+	std::string m_SkipReason;
+
+	Clock::time_point m_Start;
+	Clock::duration m_Elapsed = Clock::duration::zero();
+
+	uint64_t m_Iterations = 0;
+	uint64_t m_Remaining = 0;
+	uint64_t m_Argument = 0;
+};
+
+/**
+ * Benchmark result structure.
+ * This contains the statistics of the time per iteration over all the repetitions of a benchmark.
+ */
+struct BenchmarkResult final
+{
+	std::string m_Name;
+	std::string m_SkipReason;
+	BenchmarkCounters m_Counters;
+
+	uint64_t m_Iterations = 0;
+	uint32_t m_Repetitions = 0;
+
+	double m_Minimum = 0.0;		// Nanoseconds per iteration.
+	double m_Median = 0.0;		// Nanoseconds per iteration.
+	double m_Mean = 0.0;		// Nanoseconds per iteration.
+	double m_Deviation = 0.0;	// Nanoseconds per iteration.
+};
+
+/**
+ * Benchmark registry class.
+ * The benchmarks register themselves from static initializers using the GRAPHITE_BENCHMARK macros, so adding a benchmark only needs a new
+ * function in any of the benchmark sources.
+ *
+ * Each benchmark is calibrated first, so a repetition runs for at least the minimum time, and then repeated with the same iteration count. The
+ * median is the most stable number to compare between runs.
+ */
+class BenchmarkRegistry final
+{
+	/**
+	 * Entry structure.
+	 * This is a single registered benchmark.
+	 */
+	struct Entry final
+	{
+		std::string m_Name;
+		std::function<void(BenchmarkState&)> m_Function;
+		uint64_t m_Argument = 0;
+	};
+
+public:
+	/**
+	 * Register a benchmark.
+	 *
+	 * @param name The benchmark name.
+	 * @param function The benchmark function.
+	 * @return Always returns true so it can be used to initialize a static variable.
+	 */
+	static bool Register(std::string_view name, std::function<void(BenchmarkState&)> function);
+
+	/**
+	 * Register a benchmark with multiple arguments.
+	 * A benchmark is registered for each argument, named as name/argument.
+	 *
+	 * @param name The benchmark name.
+	 * @param function The benchmark function.
+	 * @param arguments The arguments.
+	 * @return Always returns true so it can be used to initialize a static variable.
+	 */
+	static bool Register(std::string_view name, std::function<void(BenchmarkState&)> function, std::initializer_list<uint64_t> arguments);
+
+	/**
+	 * Run the benchmarks.
+	 *
+	 * @param filter Only the benchmarks whose names contain this are run. Empty runs all of them.
+	 * @param repetitions The number of repetitions.
+	 * @param minimumTime The minimum time of a repetition.
+	 * @return The results.
+	 */
+	[[nodiscard]] static std::vector<BenchmarkResult> Run(std::string_view filter, uint32_t repetitions, std::chrono::milliseconds minimumTime);
+
+	/**
+	 * Add a context entry to the results.
+	 * This is for the environment details only the benchmarks know, like the name of the device they ran on. An existing entry is replaced.
+	 *
+	 * @param name The entry name.
+	 * @param value The entry value.
+	 */
+	static void AddContext(std::string_view name, std::string_view value);
+
+	/**
+	 * Get the context entries added by the benchmarks.
+	 *
+	 * @return The entries.
+	 */
+	[[nodiscard]] static std::vector<std::pair<std::string, std::string>>& GetContext();
+
+	/**
+	 * Get the names of the registered benchmarks.
+	 *
+	 * @return The names.
+	 */
+	[[nodiscard]] static std::vector<std::string> GetNames();
+
+	/**
+	 * Write the results as JSON.
+	 * The context contains the information needed to compare the results between machines and builds.
+	 *
+	 * @param stream The stream to write to.
+	 * @param results The results.
+	 * @param context The context entries.
+	 */
+	static void WriteJSON(std::ostream& stream, const std::vector<BenchmarkResult>& results, const std::vector<std::pair<std::string, std::string>>& context);
+
+	/**
+	 * Write the results as a table.
+	 *
+	 * @param stream The stream to write to.
+	 * @param results The results.
+	 */
+	static void WriteTable(std::ostream& stream, const std::vector<BenchmarkResult>& results);
+
+private:
+	/**
+	 * Get the registered benchmarks.
+	 * This is a function local static so the registration order of the static initializers does not matter.
+	 *
+	 * @return The entries.
+	 */
+	[[nodiscard]] static std::vector<Entry>& GetEntries();
+
+	/**
+	 * Run a single benchmark.
+	 *
+	 * @param entry The benchmark entry.
+	 * @param repetitions The number of repetitions.
+	 * @param minimumTime The minimum time of a repetition.
+	 * @return The result.
+	 */
+	[[nodiscard]] static BenchmarkResult RunEntry(const Entry& entry, uint32_t repetitions, std::chrono::nanoseconds minimumTime);
+};
+
+/**
+ * Prevent the compiler from optimizing out a value.
+ *
+ * @tparam Type The value type.
+ * @param value The value.
+ */
+template<class Type>
+inline void DoNotOptimize(const Type& value)
+{
+#if defined(_MSC_VER)
+	static const Type* volatile pSink = nullptr;
+	pSink = &value;
+
+#else
+	asm volatile("" : : "r,m"(value) : "memory");
+
+#endif
+}
+
+#define GRAPHITE_BENCHMARK_CONCATENATE_IMPL(lhs, rhs)	lhs##rhs
+#define GRAPHITE_BENCHMARK_CONCATENATE(lhs, rhs)		GRAPHITE_BENCHMARK_CONCATENATE_IMPL(lhs, rhs)
+
+/**
+ * Define a benchmark.
+ * The function body follows the macro, and takes a BenchmarkState& named state.
+ */
+#define GRAPHITE_BENCHMARK(name)																										\
+	static void name(BenchmarkState& state);																							\
+	[[maybe_unused]] static const bool GRAPHITE_BENCHMARK_CONCATENATE(_graphiteBenchmark, name) = ::BenchmarkRegistry::Register(#name, name);	\
+	static void name(BenchmarkState& state)
+
+/**
+ * Define a benchmark which runs once for each argument.
+ * The argument is read with state.getArgument().
+ */
+#define GRAPHITE_BENCHMARK_ARGUMENTS(name, ...)																								\
+	static void name(BenchmarkState& state);																									\
+	[[maybe_unused]] static const bool GRAPHITE_BENCHMARK_CONCATENATE(_graphiteBenchmark, name) = ::BenchmarkRegistry::Register(#name, name, { __VA_ARGS__ });	\
+	static void name(BenchmarkState& state)
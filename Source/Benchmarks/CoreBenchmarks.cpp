@@ -0,0 +1,542 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "Benchmark.hpp"
+
+#include "Core/BinaryLogging.hpp"
+#include "Core/Guarded.hpp"
+#include "Core/Logging.hpp"
+#include "Core/MathKernels.hpp"
+#include "Core/RadixSort.hpp"
+#include "Core/RenderQueue.hpp"
+
+#include <spdlog/sinks/null_sink.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <filesystem>
+#include <limits>
+#include <random>
+#include <thread>
+
+namespace /* anonymous */
+{
+	// Every benchmark which needs random data uses this seed, so the runs are reproducible.
+	constexpr uint32_t g_Seed = 0x6a09e667;
+
+	/**
+	 * Scoped logger class.
+	 * This replaces the default logger with one which formats the messages and drops them, so the benchmarks measure the cost of a log call
+	 * without the console.
+	 */
+	class ScopedNullLogger final
+	{
+	public:
+		/**
+		 * Default constructor.
+		 */
+		ScopedNullLogger()
+			: m_pPreviousLogger(spdlog::default_logger())
+		{
+			auto pLogger = std::make_shared<spdlog::logger>("Benchmark", std::make_shared<spdlog::sinks::null_sink_st>());
+			pLogger->set_level(spdlog::level::trace);
+			spdlog::set_default_logger(std::move(pLogger));
+		}
+
+		/**
+		 * Destructor.
+		 */
+		~ScopedNullLogger()
+		{
+			spdlog::set_default_logger(m_pPreviousLogger);
+		}
+
+		GRAPHITE_DISABLE_COPY_AND_MOVE(ScopedNullLogger);
+
+	private:
+		std::shared_ptr<spdlog::logger> m_pPreviousLogger;
+	};
+
+	// The number of elements the math kernel benchmarks process per iteration.
+	constexpr size_t g_MathElementCount = 4096;
+
+	// The largest error relative to glm the math kernels may have.
+	constexpr float g_MathTolerance = 1e-4f;
+
+	/**
+	 * Scoped math ISA class.
+	 * This makes the math kernels use an ISA and restores the previous one afterwards.
+	 */
+	class ScopedMathISA final
+	{
+	public:
+		/**
+		 * Explicit constructor.
+		 *
+		 * @param isa The ISA to use.
+		 */
+		explicit ScopedMathISA(MathISA isa)
+			: m_Previous(MathKernels::GetISA())
+			, m_bIsSupported(MathKernels::SetISA(isa))
+		{
+		}
+
+		/**
+		 * Destructor.
+		 */
+		~ScopedMathISA()
+		{
+			static_cast<void>(MathKernels::SetISA(m_Previous));
+		}
+
+		GRAPHITE_DISABLE_COPY_AND_MOVE(ScopedMathISA);
+
+	public:
+		GRAPHITE_SETUP_SIMPLE_GETTER(bool, IsSupported, m_bIsSupported);
+
+	private:
+		MathISA m_Previous;
+		bool m_bIsSupported = false;
+	};
+
+	/**
+	 * Fill a stream with random values.
+	 *
+	 * @tparam Components The number of components.
+	 * @param stream The stream to fill.
+	 * @param generator The random number generator.
+	 * @param minimum The smallest value.
+	 * @param maximum The largest value.
+	 */
+	template<size_t Components>
+	void FillRandom(SoAStream<float, Components> stream, std::mt19937& generator, float minimum, float maximum)
+	{
+		std::uniform_real_distribution<float> distribution(minimum, maximum);
+		for (size_t i = 0; i < Components; i++)
+			GRAPHITE_RANGES(generate, stream[i], [&distribution, &generator] { return distribution(generator); });
+	}
+
+	/**
+	 * Get a matrix of a stream as a glm matrix.
+	 *
+	 * @param stream The matrix stream.
+	 * @param index The matrix index.
+	 * @return The matrix.
+	 */
+	[[nodiscard]] glm::mat4 ToGLM(const ConstMatrixStream& stream, size_t index)
+	{
+		glm::mat4 matrix;
+		for (glm::length_t column = 0; column < 4; column++)
+		{
+			for (glm::length_t row = 0; row < 4; row++)
+				matrix[column][row] = stream[column * 4 + row][index];
+		}
+
+		return matrix;
+	}
+
+	/**
+	 * Get the error of a value relative to the glm result.
+	 *
+	 * @param value The kernel result.
+	 * @param reference The glm result.
+	 * @return The error.
+	 */
+	[[nodiscard]] float GetRelativeError(float value, float reference)
+	{
+		return std::abs(value - reference) / std::max(1.0f, std::abs(reference));
+	}
+
+	/**
+	 * Run a math kernel benchmark with the ISA of the benchmark argument.
+	 * The kernel is run once and checked against glm before it's measured, and the benchmark is skipped if it doesn't match, so a wrong kernel
+	 * never gets a timing.
+	 *
+	 * @tparam Kernel The kernel function type.
+	 * @tparam GetError The error function type.
+	 * @param state The benchmark state. The argument is the ISA.
+	 * @param kernel The function which runs the kernel once. It returns a pointer to the results, so the work is not optimized away.
+	 * @param getError The function which returns the largest error of the results relative to glm.
+	 * @param prepare The function which restores the inputs of a kernel which works in place. It's called before each run, and not measured.
+	 */
+	template<class Kernel, class GetError>
+	void RunMathKernel(BenchmarkState& state, Kernel&& kernel, GetError&& getError, const std::function<void()>& prepare = {})
+	{
+		const auto isa = ScopedMathISA(static_cast<MathISA>(state.getArgument()));
+		if (!isa.getIsSupported())
+		{
+			state.skip("The ISA is not supported by the CPU.");
+			return;
+		}
+
+		if (prepare)
+			prepare();
+
+		kernel();
+
+		const auto error = getError();
+		state.setCounter("max_error", error);
+		if (error > g_MathTolerance)
+		{
+			GRAPHITE_LOG_ERROR("The {} math kernels do not match glm! The largest error is {}.", GetMathISAName(MathKernels::GetISA()), error);
+			state.skip("The results do not match glm.");
+			return;
+		}
+
+		while (state.keepRunning())
+		{
+			if (prepare)
+			{
+				state.pauseTiming();
+				prepare();
+				state.resumeTiming();
+			}
+
+			DoNotOptimize(kernel());
+		}
+	}
+}
+
+/**
+ * Guarded access while other threads keep accessing the same variable.
+ * The argument is the total number of threads.
+ */
+GRAPHITE_BENCHMARK_ARGUMENTS(GuardedAccess, 1, 2, 4, 8)
+{
+	Guarded<uint64_t> counter(0);
+	std::atomic_bool bShouldRun = true;
+
+	std::vector<std::jthread> workers;
+	for (uint64_t i = 1; i < state.getArgument(); i++)
+	{
+		workers.emplace_back([&counter, &bShouldRun]
+			{
+				while (bShouldRun.load(std::memory_order_relaxed))
+					counter.access([](uint64_t& value) { value++; });
+			}
+		);
+	}
+
+	while (state.keepRunning())
+		counter.access([](uint64_t& value) { value++; });
+
+	bShouldRun = false;
+}
+
+/**
+ * A log call which is filtered out by the logger level.
+ */
+GRAPHITE_BENCHMARK(LogFiltered)
+{
+	ScopedNullLogger logger;
+	spdlog::set_level(spdlog::level::warn);
+
+	uint32_t value = 0;
+	while (state.keepRunning())
+	{
+		GRAPHITE_LOG_INFORMATION("Filtered message {} {}", value++, 3.14f);
+		DoNotOptimize(value);
+	}
+}
+
+/**
+ * A log call which is formatted and sent to a sink.
+ */
+GRAPHITE_BENCHMARK(LogFormatted)
+{
+	ScopedNullLogger logger;
+
+	uint32_t value = 0;
+	while (state.keepRunning())
+	{
+		GRAPHITE_LOG_INFORMATION("Formatted message {} {}", value++, 3.14f);
+		DoNotOptimize(value);
+	}
+}
+
+/**
+ * A binary log call, which only copies the arguments to the thread's buffer.
+ */
+GRAPHITE_BENCHMARK(LogBinary)
+{
+	const auto path = std::filesystem::temp_directory_path() / "GraphiteBenchmark.glog";
+
+	{
+		BinaryLogger logger(path.string());
+
+		uint32_t value = 0;
+		while (state.keepRunning())
+		{
+			GRAPHITE_BINARY_LOG_INFORMATION("Binary message {} {}", value++, 3.14f);
+			DoNotOptimize(value);
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::remove(path, error);
+}
+
+/**
+ * Radix sort of random 64-bit keys.
+ * The argument is the key count.
+ */
+GRAPHITE_BENCHMARK_ARGUMENTS(RadixSortKeys, 1024, 65536, 1048576)
+{
+	const auto count = static_cast<size_t>(state.getArgument());
+
+	std::mt19937_64 generator(g_Seed);
+	std::vector<uint64_t> source(count);
+	for (auto& key : source)
+		key = generator();
+
+	std::vector<uint64_t> keys(count);
+	std::vector<uint32_t> values(count);
+
+	RadixSorter sorter;
+	while (state.keepRunning())
+	{
+		state.pauseTiming();
+		keys = source;
+		state.resumeTiming();
+
+		sorter.sort(keys, values);
+		DoNotOptimize(keys.data());
+	}
+}
+
+/**
+ * Render queue submission, sort and batching of a synthetic scene.
+ * The argument is the item count.
+ */
+GRAPHITE_BENCHMARK_ARGUMENTS(RenderQueueSort, 1024, 65536)
+{
+	std::mt19937 generator(g_Seed);
+	std::uniform_int_distribution<uint32_t> pipelines(0, 15);
+	std::uniform_int_distribution<uint32_t> materials(0, 255);
+	std::uniform_int_distribution<uint32_t> meshes(0, 63);
+	std::uniform_real_distribution<float> depths(0.1f, 1000.0f);
+
+	std::vector<std::pair<RenderItem, float>> items(state.getArgument());
+	for (uint32_t i = 0; i < items.size(); i++)
+	{
+		const auto mesh = meshes(generator);
+
+		auto& [item, depth] = items[i];
+		item.m_PipelineID = pipelines(generator);
+		item.m_MaterialID = materials(generator);
+		item.m_IndexCount = 36;
+		item.m_FirstIndex = mesh * 36;
+		item.m_InstanceIndex = i;
+		depth = depths(generator);
+	}
+
+	RenderQueue queue;
+	while (state.keepRunning())
+	{
+		queue.clear();
+		for (const auto& [item, depth] : items)
+			queue.submit(0, item, depth);
+
+		queue.sort();
+		DoNotOptimize(queue.getBatches().data());
+	}
+
+	state.setCounter("batches", static_cast<double>(queue.getBatches().size()));
+}
+
+/**
+ * Multiply matrices, like composing the world matrices or the skinning palettes.
+ * The argument is the ISA: 0 is scalar, 1 is SSE4.1 and 2 is AVX2.
+ */
+GRAPHITE_BENCHMARK_ARGUMENTS(MathMultiplyMatrices, 0, 1, 2)
+{
+	std::mt19937 generator(g_Seed);
+	SoABuffer<16> lhs(g_MathElementCount);
+	SoABuffer<16> rhs(g_MathElementCount);
+	SoABuffer<16> result(g_MathElementCount);
+	FillRandom(lhs.getStream(), generator, -2.0f, 2.0f);
+	FillRandom(rhs.getStream(), generator, -2.0f, 2.0f);
+
+	const auto kernel = [&lhs, &rhs, &result]
+	{
+		MathKernels::MultiplyMatrices(lhs.getStream(), rhs.getStream(), result.getStream());
+		return result.getStream()[0].data();
+	};
+
+	const auto getError = [&lhs, &rhs, &result]
+	{
+		float error = 0.0f;
+		for (size_t i = 0; i < g_MathElementCount; i++)
+		{
+			const auto reference = ToGLM(lhs.getStream(), i) * ToGLM(rhs.getStream(), i);
+			for (glm::length_t e = 0; e < 16; e++)
+				error = std::max(error, GetRelativeError(result.getStream()[e][i], reference[e / 4][e % 4]));
+		}
+
+		return error;
+	};
+
+	RunMathKernel(state, kernel, getError);
+}
+
+/**
+ * Transform bounding boxes by their world matrices.
+ * The argument is the ISA: 0 is scalar, 1 is SSE4.1 and 2 is AVX2.
+ */
+GRAPHITE_BENCHMARK_ARGUMENTS(MathTransformAABBs, 0, 1, 2)
+{
+	std::mt19937 generator(g_Seed);
+	SoABuffer<16> matrices(g_MathElementCount);
+	SoABuffer<6> boxes(g_MathElementCount);
+	SoABuffer<6> result(g_MathElementCount);
+	FillRandom(matrices.getStream(), generator, -2.0f, 2.0f);
+	FillRandom(boxes.getStream(), generator, -10.0f, 10.0f);
+
+	// The kernel only handles affine matrices and boxes whose minimum is below their maximum.
+	for (size_t i = 0; i < g_MathElementCount; i++)
+	{
+		matrices.getStream()[3][i] = 0.0f;
+		matrices.getStream()[7][i] = 0.0f;
+		matrices.getStream()[11][i] = 0.0f;
+		matrices.getStream()[15][i] = 1.0f;
+
+		for (size_t axis = 0; axis < 3; axis++)
+		{
+			auto& minimum = boxes.getStream()[axis][i];
+			auto& maximum = boxes.getStream()[3 + axis][i];
+			if (minimum > maximum)
+				std::swap(minimum, maximum);
+		}
+	}
+
+	const auto kernel = [&matrices, &boxes, &result]
+	{
+		MathKernels::TransformAABBs(matrices.getStream(), boxes.getStream(), result.getStream());
+		return result.getStream()[0].data();
+	};
+
+	// The reference transforms all eight corners, which is what the kernel's center and extent method is equivalent to.
+	const auto getError = [&matrices, &boxes, &result]
+	{
+		float error = 0.0f;
+		for (size_t i = 0; i < g_MathElementCount; i++)
+		{
+			const auto matrix = ToGLM(matrices.getStream(), i);
+			const auto boxStream = boxes.getStream();
+
+			auto minimum = glm::vec3(std::numeric_limits<float>::max());
+			auto maximum = glm::vec3(std::numeric_limits<float>::lowest());
+			for (uint32_t corner = 0; corner < 8; corner++)
+			{
+				const auto point = glm::vec4(
+					boxStream[(corner & 1) != 0 ? 3 : 0][i],
+					boxStream[(corner & 2) != 0 ? 4 : 1][i],
+					boxStream[(corner & 4) != 0 ? 5 : 2][i],
+					1.0f);
+
+				const auto transformed = glm::vec3(matrix * point);
+				minimum = glm::min(minimum, transformed);
+				maximum = glm::max(maximum, transformed);
+			}
+
+			for (glm::length_t axis = 0; axis < 3; axis++)
+			{
+				error = std::max(error, GetRelativeError(result.getStream()[axis][i], minimum[axis]));
+				error = std::max(error, GetRelativeError(result.getStream()[3 + axis][i], maximum[axis]));
+			}
+		}
+
+		return error;
+	};
+
+	RunMathKernel(state, kernel, getError);
+}
+
+/**
+ * Normalize quaternions, like after blending the joint rotations of an animation.
+ * The argument is the ISA: 0 is scalar, 1 is SSE4.1 and 2 is AVX2.
+ */
+GRAPHITE_BENCHMARK_ARGUMENTS(MathNormalizeQuaternions, 0, 1, 2)
+{
+	std::mt19937 generator(g_Seed);
+	SoABuffer<4> source(g_MathElementCount);
+	SoABuffer<4> quaternions(g_MathElementCount);
+	FillRandom(source.getStream(), generator, -1.0f, 1.0f);
+
+	// Some of the quaternions are zero, which must become the identity.
+	for (size_t i = 0; i < g_MathElementCount; i += 97)
+	{
+		for (size_t component = 0; component < 4; component++)
+			source.getStream()[component][i] = 0.0f;
+	}
+
+	const auto kernel = [&quaternions]
+	{
+		MathKernels::NormalizeQuaternions(quaternions.getStream());
+		return quaternions.getStream()[0].data();
+	};
+
+	const auto getError = [&source, &quaternions]
+	{
+		float error = 0.0f;
+		for (size_t i = 0; i < g_MathElementCount; i++)
+		{
+			const auto input = source.getStream();
+			const auto reference = glm::normalize(glm::quat(input[3][i], input[0][i], input[1][i], input[2][i]));
+			error = std::max(error, GetRelativeError(quaternions.getStream()[0][i], reference.x));
+			error = std::max(error, GetRelativeError(quaternions.getStream()[1][i], reference.y));
+			error = std::max(error, GetRelativeError(quaternions.getStream()[2][i], reference.z));
+			error = std::max(error, GetRelativeError(quaternions.getStream()[3][i], reference.w));
+		}
+
+		return error;
+	};
+
+	// The kernel works in place, so the quaternions are restored before each run.
+	RunMathKernel(state, kernel, getError, [&source, &quaternions] { quaternions = source; });
+}
+
+/**
+ * Transform points to clip space by a view projection matrix.
+ * The argument is the ISA: 0 is scalar, 1 is SSE4.1 and 2 is AVX2.
+ */
+GRAPHITE_BENCHMARK_ARGUMENTS(MathTransformPoints, 0, 1, 2)
+{
+	std::mt19937 generator(g_Seed);
+	std::uniform_real_distribution<float> distribution(-2.0f, 2.0f);
+
+	std::array<float, 16> viewProjection = {};
+	GRAPHITE_RANGES(generate, viewProjection, [&distribution, &generator] { return distribution(generator); });
+
+	SoABuffer<3> points(g_MathElementCount);
+	SoABuffer<4> result(g_MathElementCount);
+	FillRandom(points.getStream(), generator, -100.0f, 100.0f);
+
+	glm::mat4 matrix;
+	for (glm::length_t e = 0; e < 16; e++)
+		matrix[e / 4][e % 4] = viewProjection[e];
+
+	const auto kernel = [&viewProjection, &points, &result]
+	{
+		MathKernels::TransformPoints(viewProjection, points.getStream(), result.getStream());
+		return result.getStream()[0].data();
+	};
+
+	const auto getError = [&matrix, &points, &result]
+	{
+		float error = 0.0f;
+		for (size_t i = 0; i < g_MathElementCount; i++)
+		{
+			const auto reference = matrix * glm::vec4(points.getStream()[0][i], points.getStream()[1][i], points.getStream()[2][i], 1.0f);
+			for (glm::length_t component = 0; component < 4; component++)
+				error = std::max(error, GetRelativeError(result.getStream()[component][i], reference[component]));
+		}
+
+		return error;
+	};
+
+	RunMathKernel(state, kernel, getError);
+}
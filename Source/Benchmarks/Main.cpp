@@ -0,0 +1,147 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "Benchmark.hpp"
+
+#include <spdlog/spdlog.h>
+#include <spdlog/fmt/chrono.h>
+
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+namespace /* anonymous */
+{
+	/**
+	 * Parse an unsigned integer argument.
+	 *
+	 * @param argument The argument.
+	 * @param fallback The value to use if the argument is not a number.
+	 * @return The value.
+	 */
+	[[nodiscard]] uint32_t ParseNumber(std::string_view argument, uint32_t fallback)
+	{
+		uint32_t value = 0;
+		const auto [pointer, error] = std::from_chars(argument.data(), argument.data() + argument.size(), value);
+		return error == std::errc() ? value : fallback;
+	}
+
+	/**
+	 * Get the name of the build configuration.
+	 *
+	 * @return The configuration name.
+	 */
+	[[nodiscard]] std::string_view GetConfigurationName()
+	{
+#if defined(GRAPHITE_PROFILE)
+		return "Profile";
+
+#elif defined(GRAPHITE_RELEASE)
+		return "Release";
+
+#elif defined(GRAPHITE_DEBUG)
+		return "Debug";
+
+#else
+		return "Unknown";
+
+#endif
+	}
+
+	/**
+	 * Get the name and the version of the compiler.
+	 *
+	 * @return The compiler name.
+	 */
+	[[nodiscard]] std::string GetCompilerName()
+	{
+#if defined(_MSC_VER)
+		return fmt::format("MSVC {}", _MSC_VER);
+
+#elif defined(__clang__)
+		return fmt::format("Clang {}.{}.{}", __clang_major__, __clang_minor__, __clang_patchlevel__);
+
+#elif defined(__GNUC__)
+		return fmt::format("GCC {}.{}.{}", __GNUC__, __GNUC_MINOR__, __GNUC_PATCHLEVEL__);
+
+#else
+		return "Unknown";
+
+#endif
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	// Parse the arguments.
+	std::string_view filter;
+	std::string_view outputPath;
+	uint32_t repetitions = 5;
+	uint32_t minimumTime = 100;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const auto argument = std::string_view(argv[i]);
+		if (argument == "--filter" && i + 1 < argc)
+			filter = argv[++i];
+
+		else if (argument == "--output" && i + 1 < argc)
+			outputPath = argv[++i];
+
+		else if (argument == "--repetitions" && i + 1 < argc)
+			repetitions = ParseNumber(argv[++i], repetitions);
+
+		else if (argument == "--min-time" && i + 1 < argc)
+			minimumTime = ParseNumber(argv[++i], minimumTime);
+
+		else if (argument == "--list")
+		{
+			for (const auto& name : BenchmarkRegistry::GetNames())
+				std::cout << name << std::endl;
+
+			return 0;
+		}
+
+		else
+		{
+			std::cerr << "Usage: GraphiteBenchmarks [--filter <substring>] [--output <json file>] [--repetitions <count>] [--min-time <milliseconds>] [--list]" << std::endl;
+			return 1;
+		}
+	}
+
+	// The engine logs would be mixed with the results, so only the warnings and the errors are printed.
+	spdlog::set_level(spdlog::level::warn);
+
+	const auto startTime = std::chrono::system_clock::now();
+	const auto results = BenchmarkRegistry::Run(filter, repetitions, std::chrono::milliseconds(minimumTime));
+
+	BenchmarkRegistry::WriteTable(std::cout, results);
+
+	if (!outputPath.empty())
+	{
+		auto output = std::ofstream(std::string(outputPath));
+		if (!output.is_open())
+		{
+			std::cerr << "Failed to open the output file " << outputPath << "!" << std::endl;
+			return 1;
+		}
+
+		std::vector<std::pair<std::string, std::string>> context = {
+			{ "date", fmt::format("{:%Y-%m-%dT%H:%M:%SZ}", fmt::gmtime(std::chrono::system_clock::to_time_t(startTime))) },
+			{ "configuration", std::string(GetConfigurationName()) },
+			{ "compiler", GetCompilerName() },
+			{ "hardware_concurrency", std::to_string(std::thread::hardware_concurrency()) },
+			{ "repetitions", std::to_string(repetitions) },
+			{ "min_time_ms", std::to_string(minimumTime) },
+			{ "filter", std::string(filter) }
+		};
+
+		const auto& benchmarkContext = BenchmarkRegistry::GetContext();
+		context.insert(context.end(), benchmarkContext.begin(), benchmarkContext.end());
+
+		BenchmarkRegistry::WriteJSON(output, results, context);
+	}
+
+	return 0;
+}
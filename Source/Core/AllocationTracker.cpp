@@ -0,0 +1,232 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "AllocationTracker.hpp"
+#include "FrameStatistics.hpp"
+#include "Logging.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+
+namespace /* anonymous */
+{
+	constexpr uint8_t g_TagCount = static_cast<uint8_t>(AllocationTag::Count);
+
+	thread_local uint64_t t_AllocationCount = 0;
+	thread_local AllocationTag t_Tag = AllocationTag::Unknown;
+
+#ifdef GRAPHITE_ALLOCATION_TRACKING
+	/**
+	 * Allocation header structure.
+	 * This is placed before every allocation. It's as large as the default new alignment so the allocation stays aligned.
+	 */
+	struct alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) AllocationHeader final
+	{
+		uint64_t m_Size = 0;
+		AllocationTag m_Tag = AllocationTag::Unknown;
+	};
+
+	/**
+	 * Tag counters structure.
+	 * Each tag is on it's own cache line, so threads working on different subsystems don't contend.
+	 */
+	struct alignas(64) TagCounters final
+	{
+		std::atomic_uint64_t m_AllocationCount = 0;
+		std::atomic_uint64_t m_AllocatedSize = 0;
+		std::atomic_uint64_t m_FreeCount = 0;
+		std::atomic_uint64_t m_FreedSize = 0;
+	};
+
+	std::array<TagCounters, g_TagCount> g_Counters;
+
+#endif
+
+	/**
+	 * Allocate memory from the general heap.
+	 * This calls the new handler till the allocation succeeds, like the default operator new.
+	 *
+	 * @param size The size in bytes.
+	 * @return The memory pointer.
+	 */
+	[[nodiscard]] void* AllocateHeap(std::size_t size)
+	{
+		while (true)
+		{
+			if (const auto pData = std::malloc(size == 0 ? 1 : size))
+				return pData;
+
+			const auto handler = std::get_new_handler();
+			if (handler == nullptr)
+				throw std::bad_alloc();
+
+			handler();
+		}
+	}
+}
+
+AllocationTag AllocationTracker::SetThreadTag(AllocationTag tag)
+{
+	const auto previous = t_Tag;
+	t_Tag = tag;
+	return previous;
+}
+
+uint64_t AllocationTracker::GetThreadAllocationCount()
+{
+	return t_AllocationCount;
+}
+
+AllocationSnapshot AllocationTracker::TakeSnapshot()
+{
+	AllocationSnapshot snapshot = {};
+
+#ifdef GRAPHITE_ALLOCATION_TRACKING
+	for (uint8_t i = 0; i < g_TagCount; i++)
+	{
+		snapshot[i].m_AllocationCount = g_Counters[i].m_AllocationCount.load(std::memory_order_relaxed);
+		snapshot[i].m_AllocatedSize = g_Counters[i].m_AllocatedSize.load(std::memory_order_relaxed);
+		snapshot[i].m_FreeCount = g_Counters[i].m_FreeCount.load(std::memory_order_relaxed);
+		snapshot[i].m_FreedSize = g_Counters[i].m_FreedSize.load(std::memory_order_relaxed);
+	}
+
+#endif
+
+	return snapshot;
+}
+
+AllocationReport AllocationTracker::ComputeReport(const AllocationSnapshot& previous, const AllocationSnapshot& current, uint64_t frameCount)
+{
+	AllocationReport report;
+	report.m_FrameCount = frameCount;
+
+	const auto frames = static_cast<float>(std::max<uint64_t>(frameCount, 1));
+	for (uint8_t i = 0; i < g_TagCount; i++)
+	{
+		auto& rate = report.m_Rates[i];
+
+		// The counters are loaded one by one, so a free can be seen before it's allocation.
+		rate.m_LiveSize = current[i].m_AllocatedSize > current[i].m_FreedSize ? current[i].m_AllocatedSize - current[i].m_FreedSize : 0;
+		rate.m_AllocationsPerFrame = static_cast<float>(current[i].m_AllocationCount - previous[i].m_AllocationCount) / frames;
+		rate.m_BytesPerFrame = static_cast<float>(current[i].m_AllocatedSize - previous[i].m_AllocatedSize) / frames;
+		rate.m_FreesPerFrame = static_cast<float>(current[i].m_FreeCount - previous[i].m_FreeCount) / frames;
+	}
+
+	return report;
+}
+
+void AllocationTracker::WriteJSON(std::ostream& stream, const AllocationReport& report)
+{
+	stream << fmt::format("{{\n  \"frame_count\": {},\n  \"tags\": {{\n", report.m_FrameCount);
+	for (uint8_t i = 0; i < g_TagCount; i++)
+	{
+		const auto& rate = report.m_Rates[i];
+		stream << fmt::format("    \"{}\": {{ \"live_bytes\": {}, \"allocations_per_frame\": {:.3f}, \"bytes_per_frame\": {:.3f}, \"frees_per_frame\": {:.3f} }}",
+			GetAllocationTagName(static_cast<AllocationTag>(i)), rate.m_LiveSize, rate.m_AllocationsPerFrame, rate.m_BytesPerFrame, rate.m_FreesPerFrame);
+
+		stream << (i + 1 < g_TagCount ? ",\n" : "\n");
+	}
+
+	stream << "  }\n}\n";
+}
+
+AllocationReporter::AllocationReporter(const FrameStatistics& statistics, std::filesystem::path path, std::chrono::milliseconds interval)
+	: m_Statistics(statistics)
+{
+	if constexpr (AllocationTracker::IsEnabled)
+		m_Worker = std::jthread([this, path = std::move(path), interval](std::stop_token stopToken) { worker(stopToken, path, interval); });
+}
+
+AllocationReporter::~AllocationReporter()
+{
+	if (!m_Worker.joinable())
+		return;
+
+	m_Worker.request_stop();
+	m_Worker.join();
+}
+
+void AllocationReporter::worker(std::stop_token stopToken, std::filesystem::path path, std::chrono::milliseconds interval)
+{
+	const auto tag = AllocationTracker::Scope(AllocationTag::Statistics);
+	auto lock = std::unique_lock(m_Mutex);
+
+	auto previous = AllocationTracker::TakeSnapshot();
+	auto previousFrame = m_Statistics.getFrameCount();
+
+	while (true)
+	{
+		// The stop token wakes the wait up, so stopping does not have to wait for the interval.
+		m_Condition.wait_for(lock, stopToken, interval, [] { return false; });
+		if (stopToken.stop_requested())
+			break;
+
+		const auto current = AllocationTracker::TakeSnapshot();
+		const auto frame = m_Statistics.getFrameCount();
+		if (frame == previousFrame)
+			continue;
+
+		const auto report = AllocationTracker::ComputeReport(previous, current, frame - previousFrame);
+		previous = current;
+		previousFrame = frame;
+
+		auto file = std::ofstream(path, std::ios::trunc);
+		if (!file.is_open())
+		{
+			GRAPHITE_LOG_ERROR("Failed to open the allocation report file {}! Stopping the reports.", path.string());
+			break;
+		}
+
+		AllocationTracker::WriteJSON(file, report);
+	}
+}
+
+// The global operator new and delete are replaced to count and track the heap allocations. The array and the non-throwing versions forward to these
+// by default. The aligned versions are not replaced, so they are not counted.
+void* operator new(std::size_t size)
+{
+	t_AllocationCount++;
+
+#ifdef GRAPHITE_ALLOCATION_TRACKING
+	const auto pHeader = static_cast<AllocationHeader*>(AllocateHeap(sizeof(AllocationHeader) + size));
+	pHeader->m_Size = size;
+	pHeader->m_Tag = t_Tag;
+
+	auto& counters = g_Counters[static_cast<uint8_t>(t_Tag)];
+	counters.m_AllocationCount.fetch_add(1, std::memory_order_relaxed);
+	counters.m_AllocatedSize.fetch_add(size, std::memory_order_relaxed);
+
+	return pHeader + 1;
+
+#else
+	return AllocateHeap(size);
+
+#endif
+}
+
+void operator delete(void* pData) noexcept
+{
+#ifdef GRAPHITE_ALLOCATION_TRACKING
+	if (pData == nullptr)
+		return;
+
+	// Frees are attributed to the tag which allocated the memory, so the live size of each tag stays correct.
+	const auto pHeader = static_cast<AllocationHeader*>(pData) - 1;
+	auto& counters = g_Counters[static_cast<uint8_t>(pHeader->m_Tag)];
+	counters.m_FreeCount.fetch_add(1, std::memory_order_relaxed);
+	counters.m_FreedSize.fetch_add(pHeader->m_Size, std::memory_order_relaxed);
+
+	std::free(pHeader);
+
+#else
+	std::free(pData);
+
+#endif
+}
+
+void operator delete(void* pData, [[maybe_unused]] std::size_t size) noexcept
+{
+	::operator delete(pData);
+}
@@ -0,0 +1,209 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "Common.hpp"
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <thread>
+
+class FrameStatistics;
+
+/**
+ * Allocation tag enum.
+ * This specifies the subsystem the heap allocations of a thread are attributed to.
+ */
+enum class AllocationTag : uint8_t
+{
+	Unknown,
+	Input,
+	Simulation,
+	Streaming,
+	Submission,
+	Pipelines,
+	Statistics,
+
+	Count
+};
+
+/**
+ * Get the name of an allocation tag.
+ *
+ * @param tag The tag.
+ * @return The name.
+ */
+[[nodiscard]] constexpr std::string_view GetAllocationTagName(AllocationTag tag)
+{
+	constexpr std::array<std::string_view, static_cast<uint8_t>(AllocationTag::Count)> names = { "unknown", "input", "simulation", "streaming", "submission", "pipelines", "statistics" };
+	return names[static_cast<uint8_t>(tag)];
+}
+
+/**
+ * Allocation counters structure.
+ * These only ever grow, so the difference between two snapshots is what happened in between.
+ */
+struct AllocationCounters final
+{
+	uint64_t m_AllocationCount = 0;
+	uint64_t m_AllocatedSize = 0;
+	uint64_t m_FreeCount = 0;
+	uint64_t m_FreedSize = 0;
+};
+
+using AllocationSnapshot = std::array<AllocationCounters, static_cast<uint8_t>(AllocationTag::Count)>;
+
+/**
+ * Allocation rate structure.
+ * This contains the heap activity of a single tag over a number of frames.
+ */
+struct AllocationRate final
+{
+	uint64_t m_LiveSize = 0;			// The bytes allocated with the tag which are not freed yet.
+	float m_AllocationsPerFrame = 0.0f;
+	float m_BytesPerFrame = 0.0f;
+	float m_FreesPerFrame = 0.0f;
+};
+
+/**
+ * Allocation report structure.
+ */
+struct AllocationReport final
+{
+	std::array<AllocationRate, static_cast<uint8_t>(AllocationTag::Count)> m_Rates = {};
+	uint64_t m_FrameCount = 0;			// The number of frames the rates are averaged over.
+};
+
+/**
+ * Allocation tracker class.
+ * The global operator new and delete are replaced to count the heap allocations of every thread, which is always done since it's only a thread
+ * local increment. When the GRAPHITE_ALLOCATION_TRACKING build flag is set, every allocation also gets a small header which records it's size and the
+ * tag of the thread which made it, and the bytes and the counts of each tag are tracked. This costs a few atomic operations per allocation, so it's
+ * meant for finding where the heap churn comes from, not for shipping.
+ */
+class AllocationTracker final
+{
+public:
+	/**
+	 * Scope class.
+	 * This attributes the allocations of the calling thread to a tag from it's construction till it's destruction. Scopes can be nested.
+	 */
+	class Scope final
+	{
+	public:
+		/**
+		 * Explicit constructor.
+		 *
+		 * @param tag The tag to use.
+		 */
+		explicit Scope(AllocationTag tag) : m_Previous(AllocationTracker::SetThreadTag(tag)) {}
+
+		/**
+		 * Destructor.
+		 */
+		~Scope() { AllocationTracker::SetThreadTag(m_Previous); }
+
+		GRAPHITE_DISABLE_COPY_AND_MOVE(Scope);
+
+	private:
+		AllocationTag m_Previous;
+	};
+
+public:
+#ifdef GRAPHITE_ALLOCATION_TRACKING
+	static constexpr bool IsEnabled = true;
+
+#else
+	static constexpr bool IsEnabled = false;
+
+#endif
+
+	/**
+	 * Set the tag of the calling thread.
+	 * Prefer the scope over calling this directly.
+	 *
+	 * @param tag The tag.
+	 * @return The previous tag.
+	 */
+	static AllocationTag SetThreadTag(AllocationTag tag);
+
+	/**
+	 * Get the number of heap allocations the calling thread has made.
+	 * This counts every call to the global operator new, so the difference between two calls is the number of allocations in between.
+	 *
+	 * @return The allocation count.
+	 */
+	[[nodiscard]] static uint64_t GetThreadAllocationCount();
+
+	/**
+	 * Get the counters of every tag.
+	 * This is thread safe. Everything is 0 if the tracking is not enabled.
+	 *
+	 * @return The snapshot.
+	 */
+	[[nodiscard]] static AllocationSnapshot TakeSnapshot();
+
+	/**
+	 * Compute the allocation rates between two snapshots.
+	 *
+	 * @param previous The older snapshot.
+	 * @param current The newer snapshot.
+	 * @param frameCount The number of frames between the two.
+	 * @return The report.
+	 */
+	[[nodiscard]] static AllocationReport ComputeReport(const AllocationSnapshot& previous, const AllocationSnapshot& current, uint64_t frameCount);
+
+	/**
+	 * Write a report as a JSON object.
+	 *
+	 * @param stream The stream to write to.
+	 * @param report The report.
+	 */
+	static void WriteJSON(std::ostream& stream, const AllocationReport& report);
+};
+
+/**
+ * Allocation reporter class.
+ * This writes the allocation rates per frame to a file periodically on a worker thread. Nothing is done if the tracking is not enabled.
+ */
+class AllocationReporter final
+{
+public:
+	/**
+	 * Explicit constructor.
+	 *
+	 * @param statistics The frame statistics to get the frame count from. This must outlive the reporter.
+	 * @param path The file to write the latest report to.
+	 * @param interval The time between the reports.
+	 */
+	explicit AllocationReporter(const FrameStatistics& statistics, std::filesystem::path path, std::chrono::milliseconds interval);
+
+	/**
+	 * Destructor.
+	 */
+	~AllocationReporter();
+
+	GRAPHITE_DISABLE_COPY_AND_MOVE(AllocationReporter);
+
+private:
+	/**
+	 * Write the reports till a stop is requested.
+	 *
+	 * @param stopToken The worker's stop token.
+	 * @param path The file path.
+	 * @param interval The time between the reports.
+	 */
+	void worker(std::stop_token stopToken, std::filesystem::path path, std::chrono::milliseconds interval);
+
+private:
+	const FrameStatistics& m_Statistics;
+
+	std::mutex m_Mutex;
+	std::condition_variable_any m_Condition;
+	std::jthread m_Worker;
+};
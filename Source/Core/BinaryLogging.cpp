@@ -0,0 +1,796 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "BinaryLogging.hpp"
+
+#include <chrono>
+#include <bit>
+#include <algorithm>
+#include <ostream>
+
+namespace /* anonymous */
+{
+	constexpr char g_Magic[4] = { 'G', 'B', 'L', 'G' };
+	constexpr uint32_t g_Version = 1;
+
+	/**
+	 * Align a size to 8 bytes.
+	 *
+	 * @param size The size to align.
+	 * @return The aligned size.
+	 */
+	[[nodiscard]] constexpr uint32_t AlignRecord(uint32_t size) { return (size + 7) & ~7u; }
+
+	/**
+	 * Thread buffer class.
+	 * This is a single producer, single consumer byte ring buffer. The owning thread writes the records and the writer thread consumes them.
+	 * Records never wrap around the end of the buffer; a padding record is inserted instead.
+	 */
+	class ThreadBuffer final
+	{
+	public:
+		/**
+		 * Explicit constructor.
+		 *
+		 * @param capacity The buffer capacity. Must be a power of two.
+		 * @param index The thread index.
+		 */
+		explicit ThreadBuffer(uint32_t capacity, uint32_t index)
+			: m_Storage(std::make_unique<uint64_t[]>(capacity / sizeof(uint64_t))), m_Capacity(capacity), m_ThreadIndex(index) {}
+
+		/**
+		 * Reserve a contiguous record.
+		 *
+		 * @param size The record size. This must be 8 byte aligned.
+		 * @return The record pointer. nullptr if there isn't enough space.
+		 */
+		[[nodiscard]] std::byte* reserve(uint32_t size)
+		{
+			if (size > m_Capacity / 2)
+				return nullptr;
+
+			uint64_t head = m_WriteHead;
+			const uint64_t tail = m_Tail.load(std::memory_order_acquire);
+
+			auto offset = static_cast<uint32_t>(head & (m_Capacity - 1));
+			const auto contiguous = m_Capacity - offset;
+
+			// Insert a padding record if the record does not fit at the end of the buffer.
+			if (size > contiguous)
+			{
+				if (head + contiguous + size - tail > m_Capacity)
+					return nullptr;
+
+				const BinaryLogRecordHeader padding = { contiguous, BinaryLogRecordKind::Padding };
+				std::memcpy(data() + offset, &padding, sizeof(BinaryLogRecordHeader));
+
+				head += contiguous;
+				offset = 0;
+			}
+			else if (head + size - tail > m_Capacity)
+			{
+				return nullptr;
+			}
+
+			m_WriteHead = head;
+			m_ReservedHead = head + size;
+			return data() + offset;
+		}
+
+		/**
+		 * Publish the last reserved record.
+		 */
+		void commit()
+		{
+			m_WriteHead = m_ReservedHead;
+			m_Head.store(m_WriteHead, std::memory_order_release);
+		}
+
+		/**
+		 * Consume all the committed records.
+		 *
+		 * @param file The file to write the records to.
+		 * @return True if the buffer is empty after consuming.
+		 */
+		bool consume(std::ofstream& file)
+		{
+			uint64_t tail = m_Tail.load(std::memory_order_relaxed);
+			const uint64_t head = m_Head.load(std::memory_order_acquire);
+
+			while (tail < head)
+			{
+				const auto pRecord = data() + (tail & (m_Capacity - 1));
+
+				BinaryLogRecordHeader header = {};
+				std::memcpy(&header, pRecord, sizeof(BinaryLogRecordHeader));
+
+				if (header.m_Kind != BinaryLogRecordKind::Padding)
+					file.write(reinterpret_cast<const char*>(pRecord), header.m_Size);
+
+				tail += header.m_Size;
+			}
+
+			m_Tail.store(tail, std::memory_order_release);
+			return tail == m_Head.load(std::memory_order_acquire);
+		}
+
+		/**
+		 * Get the thread index.
+		 *
+		 * @return The index.
+		 */
+		[[nodiscard]] uint32_t getThreadIndex() const { return m_ThreadIndex; }
+
+	private:
+		/**
+		 * Get the byte pointer of the storage.
+		 *
+		 * @return The byte pointer.
+		 */
+		[[nodiscard]] std::byte* data() { return reinterpret_cast<std::byte*>(m_Storage.get()); }
+
+	public:
+		std::atomic_bool m_bRetired = false;
+
+	private:
+		std::unique_ptr<uint64_t[]> m_Storage;
+		uint32_t m_Capacity = 0;
+		uint32_t m_ThreadIndex = 0;
+
+		uint64_t m_WriteHead = 0;
+		uint64_t m_ReservedHead = 0;
+
+		alignas(64) std::atomic_uint64_t m_Head = 0;
+		alignas(64) std::atomic_uint64_t m_Tail = 0;
+	};
+
+	/**
+	 * Global state structure.
+	 * This contains everything shared between the logging threads and the writer.
+	 */
+	struct GlobalState final
+	{
+		std::mutex m_Mutex;
+		std::vector<std::shared_ptr<ThreadBuffer>> m_Buffers;
+		std::vector<std::byte> m_PendingDefinitions;
+
+		std::atomic<BinaryLogger*> m_pLogger = nullptr;
+		std::atomic_uint64_t m_DroppedCount = 0;
+
+		uint32_t m_BufferSize = 0;
+		uint32_t m_NextThreadIndex = 0;
+	};
+
+	/**
+	 * Get the global state.
+	 *
+	 * @return The state reference.
+	 */
+	[[nodiscard]] GlobalState& GetGlobalState()
+	{
+		static GlobalState state;
+		return state;
+	}
+
+	/**
+	 * Thread buffer handle structure.
+	 * This marks the buffer as retired when the owning thread exits so the writer can release it after draining.
+	 */
+	struct ThreadBufferHandle final
+	{
+		~ThreadBufferHandle()
+		{
+			if (m_pBuffer)
+				m_pBuffer->m_bRetired = true;
+		}
+
+		std::shared_ptr<ThreadBuffer> m_pBuffer;
+	};
+
+	thread_local ThreadBufferHandle t_ThreadBuffer;
+
+	/**
+	 * Get the calling thread's buffer.
+	 * The buffer is created the first time a thread logs.
+	 *
+	 * @return The buffer pointer.
+	 */
+	[[nodiscard]] ThreadBuffer* GetThreadBuffer()
+	{
+		if (!t_ThreadBuffer.m_pBuffer)
+		{
+			auto& state = GetGlobalState();
+			const auto lock = std::scoped_lock(state.m_Mutex);
+
+			t_ThreadBuffer.m_pBuffer = std::make_shared<ThreadBuffer>(state.m_BufferSize, state.m_NextThreadIndex++);
+			state.m_Buffers.emplace_back(t_ThreadBuffer.m_pBuffer);
+		}
+
+		return t_ThreadBuffer.m_pBuffer.get();
+	}
+
+	/**
+	 * Read a value from a byte pointer.
+	 *
+	 * @tparam Type The value type.
+	 * @param pSource The source pointer. This is incremented by the size of the type.
+	 * @return The value.
+	 */
+	template<class Type>
+	[[nodiscard]] Type Read(const std::byte*& pSource)
+	{
+		Type value = {};
+		std::memcpy(&value, pSource, sizeof(Type));
+		pSource += sizeof(Type);
+		return value;
+	}
+
+	/**
+	 * Get the name of a log level.
+	 *
+	 * @param level The log level.
+	 * @return The level name.
+	 */
+	[[nodiscard]] std::string_view GetLevelName(BinaryLogLevel level)
+	{
+		switch (level)
+		{
+		case BinaryLogLevel::Fatal:
+			return "fatal";
+
+		case BinaryLogLevel::Error:
+			return "error";
+
+		case BinaryLogLevel::Warning:
+			return "warning";
+
+		case BinaryLogLevel::Information:
+			return "information";
+
+		default:
+			return "trace";
+		}
+	}
+
+	/**
+	 * Escape a string so it can be written into a JSON string.
+	 *
+	 * @param string The string to escape.
+	 * @return The escaped string.
+	 */
+	[[nodiscard]] std::string EscapeJSON(std::string_view string)
+	{
+		std::string escaped;
+		escaped.reserve(string.size());
+
+		for (const auto character : string)
+		{
+			switch (character)
+			{
+			case '"':
+				escaped += "\\\"";
+				break;
+
+			case '\\':
+				escaped += "\\\\";
+				break;
+
+			case '\n':
+				escaped += "\\n";
+				break;
+
+			case '\r':
+				escaped += "\\r";
+				break;
+
+			case '\t':
+				escaped += "\\t";
+				break;
+
+			default:
+				if (static_cast<unsigned char>(character) < 0x20)
+					escaped += fmt::format("\\u{:04x}", static_cast<unsigned char>(character));
+
+				else
+					escaped += character;
+
+				break;
+			}
+		}
+
+		return escaped;
+	}
+
+	/**
+	 * Format a fixed size argument value.
+	 *
+	 * @tparam Type The value type.
+	 * @param pArgument The value pointer. This is incremented past the value, or set to the end if the value does not fit.
+	 * @param pEnd The end of the payload.
+	 * @param pattern The format pattern.
+	 * @return The formatted value.
+	 */
+	template<class Type>
+	[[nodiscard]] std::string FormatValue(const std::byte*& pArgument, const std::byte* pEnd, const std::string& pattern)
+	{
+		if (static_cast<size_t>(pEnd - pArgument) < sizeof(Type))
+		{
+			pArgument = pEnd;
+			return "{?}";
+		}
+
+		return fmt::format(fmt::runtime(pattern), Read<Type>(pArgument));
+	}
+
+	/**
+	 * Format a single encoded argument.
+	 * The payload comes from the file, so an argument which does not fit in it stops the decoding of the rest.
+	 *
+	 * @param pArgument The argument pointer. This is incremented past the argument.
+	 * @param pEnd The end of the payload.
+	 * @param specification The format specification (including the leading ':' if present).
+	 * @return The formatted argument.
+	 */
+	[[nodiscard]] std::string FormatArgument(const std::byte*& pArgument, const std::byte* pEnd, std::string_view specification)
+	{
+		if (pArgument >= pEnd)
+			return "{?}";
+
+		const auto pattern = fmt::format("{{{}}}", specification);
+		const auto type = static_cast<BinaryLogArgumentType>(*pArgument++);
+
+		try
+		{
+			switch (type)
+			{
+			case BinaryLogArgumentType::Bool:
+				return FormatValue<bool>(pArgument, pEnd, pattern);
+
+			case BinaryLogArgumentType::Char:
+				return FormatValue<char>(pArgument, pEnd, pattern);
+
+			case BinaryLogArgumentType::Int8:
+				return FormatValue<int8_t>(pArgument, pEnd, pattern);
+
+			case BinaryLogArgumentType::Uint8:
+				return FormatValue<uint8_t>(pArgument, pEnd, pattern);
+
+			case BinaryLogArgumentType::Int16:
+				return FormatValue<int16_t>(pArgument, pEnd, pattern);
+
+			case BinaryLogArgumentType::Uint16:
+				return FormatValue<uint16_t>(pArgument, pEnd, pattern);
+
+			case BinaryLogArgumentType::Int32:
+				return FormatValue<int32_t>(pArgument, pEnd, pattern);
+
+			case BinaryLogArgumentType::Uint32:
+				return FormatValue<uint32_t>(pArgument, pEnd, pattern);
+
+			case BinaryLogArgumentType::Int64:
+				return FormatValue<int64_t>(pArgument, pEnd, pattern);
+
+			case BinaryLogArgumentType::Uint64:
+				return FormatValue<uint64_t>(pArgument, pEnd, pattern);
+
+			case BinaryLogArgumentType::Float:
+				return FormatValue<float>(pArgument, pEnd, pattern);
+
+			case BinaryLogArgumentType::Double:
+				return FormatValue<double>(pArgument, pEnd, pattern);
+
+			case BinaryLogArgumentType::Pointer:
+			{
+				if (static_cast<size_t>(pEnd - pArgument) < sizeof(uint64_t))
+					break;
+
+				return fmt::format(fmt::runtime(pattern), reinterpret_cast<const void*>(static_cast<uintptr_t>(Read<uint64_t>(pArgument))));
+			}
+
+			case BinaryLogArgumentType::String:
+			{
+				if (static_cast<size_t>(pEnd - pArgument) < sizeof(uint32_t))
+					break;
+
+				const auto length = Read<uint32_t>(pArgument);
+				if (static_cast<size_t>(pEnd - pArgument) < length)
+					break;
+
+				const auto string = std::string_view(reinterpret_cast<const char*>(pArgument), length);
+				pArgument += length;
+
+				return fmt::format(fmt::runtime(pattern), string);
+			}
+
+			default:
+				break;
+			}
+		}
+		catch (const fmt::format_error&)
+		{
+			return "{?}";
+		}
+
+		// The argument is unknown or truncated, so the rest of the payload cannot be trusted.
+		pArgument = pEnd;
+		return "{?}";
+	}
+}
+
+BinaryLogger::BinaryLogger(std::string_view path, uint32_t bufferSize)
+{
+	auto& state = GetGlobalState();
+
+	{
+		const auto lock = std::scoped_lock(state.m_Mutex);
+
+		// Check if we have another logger running. This is done before opening the file so the active logger's file is not truncated.
+		if (state.m_pLogger.load(std::memory_order_acquire) != nullptr)
+		{
+			GRAPHITE_LOG_ERROR("A binary logger is already active! The new logger will not record anything.");
+			return;
+		}
+
+		m_File.open(std::string(path), std::ios::binary | std::ios::out);
+		if (!m_File.is_open())
+		{
+			GRAPHITE_LOG_ERROR("Failed to open the binary log file {}! The logger will not record anything.", path);
+			return;
+		}
+
+		// Write the file header.
+		m_File.write(g_Magic, sizeof(g_Magic));
+		m_File.write(reinterpret_cast<const char*>(&g_Version), sizeof(g_Version));
+
+		// The buffer size must be set before the logger is visible, since the threads create their buffers as soon as they see it.
+		state.m_BufferSize = std::bit_ceil(std::max(bufferSize, 4096u));
+		state.m_pLogger.store(this, std::memory_order_release);
+	}
+
+	m_Writer = std::jthread([this](std::stop_token token) { writer(std::move(token)); });
+}
+
+BinaryLogger::~BinaryLogger()
+{
+	auto& state = GetGlobalState();
+	if (state.m_pLogger.load() != this)
+		return;
+
+	m_Writer.request_stop();
+	m_Condition.notify_all();
+
+	if (m_Writer.joinable())
+		m_Writer.join();
+
+	state.m_pLogger = nullptr;
+	drain();
+}
+
+bool BinaryLogger::RegisterSite(uint64_t formatID, BinaryLogLevel level, std::string_view format, std::string_view file, uint32_t line)
+{
+	const auto fileLength = static_cast<uint32_t>(file.size());
+	const auto formatLength = static_cast<uint32_t>(format.size());
+	const auto size = AlignRecord(sizeof(BinaryLogRecordHeader) + sizeof(uint64_t) + sizeof(uint32_t) * 4 + fileLength + formatLength);
+
+	std::vector<std::byte> record(size);
+	auto pDestination = record.data();
+	const auto write = [&pDestination](const void* pData, size_t length)
+	{
+		std::memcpy(pDestination, pData, length);
+		pDestination += length;
+	};
+
+	const BinaryLogRecordHeader header = { size, BinaryLogRecordKind::Definition };
+	const auto levelValue = static_cast<uint32_t>(level);
+
+	write(&header, sizeof(BinaryLogRecordHeader));
+	write(&formatID, sizeof(uint64_t));
+	write(&levelValue, sizeof(uint32_t));
+	write(&line, sizeof(uint32_t));
+	write(&fileLength, sizeof(uint32_t));
+	write(&formatLength, sizeof(uint32_t));
+	write(file.data(), fileLength);
+	write(format.data(), formatLength);
+
+	auto& state = GetGlobalState();
+	const auto lock = std::scoped_lock(state.m_Mutex);
+	state.m_PendingDefinitions.insert(state.m_PendingDefinitions.end(), record.begin(), record.end());
+
+	return true;
+}
+
+std::byte* BinaryLogger::Reserve(uint32_t payloadSize, uint64_t formatID)
+{
+	auto& state = GetGlobalState();
+	if (state.m_pLogger.load(std::memory_order_acquire) == nullptr)
+		return nullptr;
+
+	const auto pBuffer = GetThreadBuffer();
+	const auto size = AlignRecord(sizeof(BinaryLogRecordHeader) + sizeof(BinaryLogEventHeader) + payloadSize);
+
+	const auto pRecord = pBuffer->reserve(size);
+	if (pRecord == nullptr)
+	{
+		state.m_DroppedCount.fetch_add(1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	BinaryLogRecordHeader header = { size, BinaryLogRecordKind::Event };
+	std::memcpy(pRecord, &header, sizeof(BinaryLogRecordHeader));
+
+	BinaryLogEventHeader eventHeader = {};
+	eventHeader.m_FormatID = formatID;
+	eventHeader.m_Timestamp = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+	eventHeader.m_ThreadIndex = pBuffer->getThreadIndex();
+	eventHeader.m_PayloadSize = payloadSize;
+	std::memcpy(pRecord + sizeof(BinaryLogRecordHeader), &eventHeader, sizeof(BinaryLogEventHeader));
+
+	return pRecord + sizeof(BinaryLogRecordHeader) + sizeof(BinaryLogEventHeader);
+}
+
+void BinaryLogger::Commit()
+{
+	t_ThreadBuffer.m_pBuffer->commit();
+}
+
+uint64_t BinaryLogger::GetDroppedCount()
+{
+	return GetGlobalState().m_DroppedCount.load(std::memory_order_relaxed);
+}
+
+void BinaryLogger::writer(std::stop_token token)
+{
+	while (!token.stop_requested())
+	{
+		{
+			auto lock = std::unique_lock(m_Mutex);
+			m_Condition.wait_for(lock, token, std::chrono::milliseconds(2), [] { return false; });
+		}
+
+		drain();
+	}
+}
+
+void BinaryLogger::drain()
+{
+	auto& state = GetGlobalState();
+
+	std::vector<std::byte> definitions;
+	std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+
+	{
+		const auto lock = std::scoped_lock(state.m_Mutex);
+		definitions.swap(state.m_PendingDefinitions);
+		buffers = state.m_Buffers;
+	}
+
+	// The definitions are written first so the decoder can resolve the events in a single pass most of the time.
+	m_File.write(reinterpret_cast<const char*>(definitions.data()), definitions.size());
+
+	// Drain the thread buffers and remember the ones which can be released.
+	std::vector<ThreadBuffer*> releasable;
+	for (const auto& pBuffer : buffers)
+	{
+		const bool retired = pBuffer->m_bRetired.load(std::memory_order_acquire);
+		if (pBuffer->consume(m_File) && retired)
+			releasable.emplace_back(pBuffer.get());
+	}
+
+	if (!releasable.empty())
+	{
+		const auto lock = std::scoped_lock(state.m_Mutex);
+		std::erase_if(state.m_Buffers, [&releasable](const auto& pBuffer) { return std::find(releasable.begin(), releasable.end(), pBuffer.get()) != releasable.end(); });
+	}
+
+	m_File.flush();
+}
+
+BinaryLogDecoder::BinaryLogDecoder(std::string_view path)
+{
+	auto file = std::ifstream(std::string(path), std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+	{
+		GRAPHITE_LOG_ERROR("Failed to open the binary log file {}!", path);
+		return;
+	}
+
+	std::vector<std::byte> contents(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(contents.data()), contents.size());
+
+	// Validate the file header.
+	if (contents.size() < sizeof(g_Magic) + sizeof(g_Version) || std::memcmp(contents.data(), g_Magic, sizeof(g_Magic)) != 0)
+	{
+		GRAPHITE_LOG_ERROR("The file {} is not a binary log file!", path);
+		return;
+	}
+
+	const std::byte* pCurrent = contents.data() + sizeof(g_Magic);
+	const std::byte* pEnd = contents.data() + contents.size();
+	if (Read<uint32_t>(pCurrent) != g_Version)
+	{
+		GRAPHITE_LOG_ERROR("Unsupported binary log version in file {}!", path);
+		return;
+	}
+
+	// Read all the records.
+	while (pCurrent + sizeof(BinaryLogRecordHeader) <= pEnd)
+	{
+		const auto pRecord = pCurrent;
+		const auto header = Read<BinaryLogRecordHeader>(pCurrent);
+
+		if (header.m_Size < sizeof(BinaryLogRecordHeader) || header.m_Size > static_cast<uint64_t>(pEnd - pRecord))
+		{
+			GRAPHITE_LOG_WARNING("The binary log file {} is truncated.", path);
+			break;
+		}
+
+		// The lengths inside the record come from the file too, so they're checked against the record's end before they're used.
+		const auto pRecordEnd = pRecord + header.m_Size;
+		const auto remaining = [&pCurrent, pRecordEnd] { return static_cast<uint64_t>(pRecordEnd - pCurrent); };
+
+		if (header.m_Kind == BinaryLogRecordKind::Definition)
+		{
+			if (remaining() < sizeof(uint64_t) + sizeof(uint32_t) * 4)
+			{
+				GRAPHITE_LOG_WARNING("Skipping a corrupted definition record in the binary log file {}.", path);
+				pCurrent = pRecordEnd;
+				continue;
+			}
+
+			const auto formatID = Read<uint64_t>(pCurrent);
+
+			Site site;
+			site.m_Level = static_cast<BinaryLogLevel>(Read<uint32_t>(pCurrent));
+			site.m_Line = Read<uint32_t>(pCurrent);
+
+			const auto fileLength = Read<uint32_t>(pCurrent);
+			const auto formatLength = Read<uint32_t>(pCurrent);
+
+			if (remaining() < static_cast<uint64_t>(fileLength) + formatLength)
+			{
+				GRAPHITE_LOG_WARNING("Skipping a corrupted definition record in the binary log file {}.", path);
+				pCurrent = pRecordEnd;
+				continue;
+			}
+
+			site.m_File.assign(reinterpret_cast<const char*>(pCurrent), fileLength);
+			site.m_Format.assign(reinterpret_cast<const char*>(pCurrent + fileLength), formatLength);
+			m_Sites.emplace_back(formatID, std::move(site));
+		}
+		else if (header.m_Kind == BinaryLogRecordKind::Event)
+		{
+			if (remaining() < sizeof(BinaryLogEventHeader))
+			{
+				GRAPHITE_LOG_WARNING("Skipping a corrupted event record in the binary log file {}.", path);
+				pCurrent = pRecordEnd;
+				continue;
+			}
+
+			Event event;
+			event.m_Header = Read<BinaryLogEventHeader>(pCurrent);
+
+			if (remaining() < event.m_Header.m_PayloadSize)
+			{
+				GRAPHITE_LOG_WARNING("Skipping a corrupted event record in the binary log file {}.", path);
+				pCurrent = pRecordEnd;
+				continue;
+			}
+
+			event.m_Payload.assign(pCurrent, pCurrent + event.m_Header.m_PayloadSize);
+			m_Events.emplace_back(std::move(event));
+		}
+
+		pCurrent = pRecordEnd;
+	}
+
+	// Threads are drained one after the other, so sort the events to get a single timeline.
+	std::stable_sort(m_Events.begin(), m_Events.end(), [](const Event& lhs, const Event& rhs) { return lhs.m_Header.m_Timestamp < rhs.m_Header.m_Timestamp; });
+	std::sort(m_Sites.begin(), m_Sites.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+	m_bIsValid = true;
+}
+
+void BinaryLogDecoder::decode(std::ostream& output, BinaryLogOutputFormat format) const
+{
+	if (format == BinaryLogOutputFormat::JSON)
+		output << "[\n";
+
+	const Site unknownSite = { "<unknown format>", "<unknown>", 0, BinaryLogLevel::Trace };
+	const uint64_t firstTimestamp = m_Events.empty() ? 0 : m_Events.front().m_Header.m_Timestamp;
+
+	for (auto itr = m_Events.begin(); itr != m_Events.end(); ++itr)
+	{
+		const auto site = std::lower_bound(m_Sites.begin(), m_Sites.end(), itr->m_Header.m_FormatID, [](const auto& entry, uint64_t id) { return entry.first < id; });
+		const auto& resolvedSite = site != m_Sites.end() && site->first == itr->m_Header.m_FormatID ? site->second : unknownSite;
+
+		const auto message = formatEvent(resolvedSite, *itr);
+		const auto seconds = static_cast<double>(itr->m_Header.m_Timestamp - firstTimestamp) / 1e9;
+
+		if (format == BinaryLogOutputFormat::JSON)
+		{
+			output << fmt::format(
+				"  {{ \"timestamp\": {}, \"level\": \"{}\", \"thread\": {}, \"file\": \"{}\", \"line\": {}, \"message\": \"{}\" }}{}\n",
+				itr->m_Header.m_Timestamp,
+				GetLevelName(resolvedSite.m_Level),
+				itr->m_Header.m_ThreadIndex,
+				EscapeJSON(resolvedSite.m_File),
+				resolvedSite.m_Line,
+				EscapeJSON(message),
+				std::next(itr) == m_Events.end() ? "" : ","
+			);
+		}
+		else
+		{
+			output << fmt::format("[{:.6f}] [{}] [Thread {}] [\"{}\":{}] {}\n", seconds, GetLevelName(resolvedSite.m_Level), itr->m_Header.m_ThreadIndex, resolvedSite.m_File, resolvedSite.m_Line, message);
+		}
+	}
+
+	if (format == BinaryLogOutputFormat::JSON)
+		output << "]\n";
+}
+
+std::string BinaryLogDecoder::formatEvent(const Site& site, const Event& event) const
+{
+	std::string message;
+	message.reserve(site.m_Format.size() * 2);
+
+	// Decode the argument offsets first so positional arguments can be supported.
+	std::vector<const std::byte*> arguments;
+	const std::byte* pEnd = event.m_Payload.data() + event.m_Payload.size();
+	for (auto pArgument = event.m_Payload.data(); pArgument < pEnd;)
+	{
+		arguments.emplace_back(pArgument);
+		[[maybe_unused]] const auto skipped = FormatArgument(pArgument, pEnd, "");
+	}
+
+	// Substitute the replacement fields.
+	const std::string_view format = site.m_Format;
+	size_t nextArgument = 0;
+	for (size_t i = 0; i < format.size(); i++)
+	{
+		const auto character = format[i];
+		if ((character == '{' || character == '}') && i + 1 < format.size() && format[i + 1] == character)
+		{
+			message += character;
+			i++;
+			continue;
+		}
+
+		if (character != '{')
+		{
+			message += character;
+			continue;
+		}
+
+		const auto closing = format.find('}', i);
+		if (closing == std::string_view::npos)
+		{
+			message += format.substr(i);
+			break;
+		}
+
+		// Split the field into the argument index and the specification.
+		const auto field = format.substr(i + 1, closing - i - 1);
+		const auto colon = field.find(':');
+		const auto index = field.substr(0, colon);
+		const auto specification = colon == std::string_view::npos ? std::string_view() : field.substr(colon);
+
+		size_t argumentIndex = nextArgument++;
+		if (!index.empty())
+			argumentIndex = static_cast<size_t>(std::strtoul(std::string(index).c_str(), nullptr, 10));
+
+		if (argumentIndex < arguments.size())
+		{
+			auto pArgument = arguments[argumentIndex];
+			message += FormatArgument(pArgument, pEnd, specification);
+		}
+		else
+		{
+			message += "{?}";
+		}
+
+		i = closing;
+	}
+
+	return message;
+}
@@ -0,0 +1,458 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "Common.hpp"
+#include "Logging.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <fstream>
+#include <vector>
+#include <memory>
+
+/**
+ * Binary log level enum.
+ * This mirrors the levels used by the GRAPHITE_LOG_* macros.
+ */
+enum class BinaryLogLevel : uint8_t
+{
+	Fatal = 1,
+	Error = 2,
+	Warning = 3,
+	Information = 4,
+	Trace = 5
+};
+
+/**
+ * Binary log argument type enum.
+ * Every argument in a binary log record is prefixed with one of these tags.
+ */
+enum class BinaryLogArgumentType : uint8_t
+{
+	Bool,
+	Char,
+	Int8,
+	Uint8,
+	Int16,
+	Uint16,
+	Int32,
+	Uint32,
+	Int64,
+	Uint64,
+	Float,
+	Double,
+	Pointer,
+	String
+};
+
+/**
+ * Binary log record kind enum.
+ * This is stored in every record header, both in the per-thread buffers and in the output file.
+ */
+enum class BinaryLogRecordKind : uint32_t
+{
+	Padding,
+	Definition,
+	Event
+};
+
+/**
+ * Binary log record header structure.
+ * Every record is 8 byte aligned and starts with this header.
+ */
+struct BinaryLogRecordHeader final
+{
+	uint32_t m_Size = 0;
+	BinaryLogRecordKind m_Kind = BinaryLogRecordKind::Padding;
+};
+
+/**
+ * Binary log event header structure.
+ * This follows the record header of every event record and is followed by the encoded arguments.
+ */
+struct BinaryLogEventHeader final
+{
+	uint64_t m_FormatID = 0;
+	uint64_t m_Timestamp = 0;
+	uint32_t m_ThreadIndex = 0;
+	uint32_t m_PayloadSize = 0;
+};
+
+/**
+ * Hash a call site at compile time.
+ * The format string, file and line are combined using FNV-1a so every call site gets a unique, stable ID.
+ *
+ * @param format The format string.
+ * @param file The file name.
+ * @param line The line number.
+ * @return The format ID.
+ */
+[[nodiscard]] consteval uint64_t HashBinaryLogSite(std::string_view format, std::string_view file, uint32_t line)
+{
+	uint64_t hash = 14695981039346656037ull;
+	const auto combine = [&hash](uint8_t byte) { hash = (hash ^ byte) * 1099511628211ull; };
+
+	for (const auto character : format)
+		combine(static_cast<uint8_t>(character));
+
+	for (const auto character : file)
+		combine(static_cast<uint8_t>(character));
+
+	for (uint32_t i = 0; i < 4; i++)
+		combine(static_cast<uint8_t>(line >> (i * 8)));
+
+	return hash;
+}
+
+/**
+ * Binary log argument structure.
+ * This is used to resolve the argument type tag and the encoded size of a single argument.
+ *
+ * @tparam Type The argument type.
+ */
+template<class Type>
+struct BinaryLogArgument final
+{
+	using ValueType = std::remove_cvref_t<Type>;
+
+	static_assert(std::is_arithmetic_v<ValueType> || std::is_enum_v<ValueType> || std::is_pointer_v<ValueType>, "Unsupported binary log argument type!");
+
+	/**
+	 * Get the type tag of the argument.
+	 *
+	 * @return The type tag.
+	 */
+	[[nodiscard]] static consteval BinaryLogArgumentType GetType()
+	{
+		if constexpr (std::is_enum_v<ValueType>)
+			return BinaryLogArgument<std::underlying_type_t<ValueType>>::GetType();
+
+		else if constexpr (std::is_same_v<ValueType, bool>)
+			return BinaryLogArgumentType::Bool;
+
+		else if constexpr (std::is_same_v<ValueType, char>)
+			return BinaryLogArgumentType::Char;
+
+		else if constexpr (std::is_floating_point_v<ValueType>)
+			return sizeof(ValueType) == 4 ? BinaryLogArgumentType::Float : BinaryLogArgumentType::Double;
+
+		else if constexpr (std::is_pointer_v<ValueType>)
+			return BinaryLogArgumentType::Pointer;
+
+		else if constexpr (sizeof(ValueType) == 1)
+			return std::is_signed_v<ValueType> ? BinaryLogArgumentType::Int8 : BinaryLogArgumentType::Uint8;
+
+		else if constexpr (sizeof(ValueType) == 2)
+			return std::is_signed_v<ValueType> ? BinaryLogArgumentType::Int16 : BinaryLogArgumentType::Uint16;
+
+		else if constexpr (sizeof(ValueType) == 4)
+			return std::is_signed_v<ValueType> ? BinaryLogArgumentType::Int32 : BinaryLogArgumentType::Uint32;
+
+		else
+			return std::is_signed_v<ValueType> ? BinaryLogArgumentType::Int64 : BinaryLogArgumentType::Uint64;
+	}
+
+	/**
+	 * Get the encoded size of the argument.
+	 *
+	 * @return The size in bytes.
+	 */
+	[[nodiscard]] static constexpr uint32_t GetSize(const ValueType&) { return 1 + (std::is_pointer_v<ValueType> ? sizeof(uint64_t) : sizeof(ValueType)); }
+
+	/**
+	 * Encode the argument.
+	 *
+	 * @param pDestination The destination pointer. This is incremented by the encoded size.
+	 * @param value The value to encode.
+	 */
+	static void Encode(std::byte*& pDestination, const ValueType& value)
+	{
+		*pDestination++ = static_cast<std::byte>(GetType());
+
+		if constexpr (std::is_pointer_v<ValueType>)
+		{
+			const auto address = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value));
+			std::memcpy(pDestination, &address, sizeof(uint64_t));
+			pDestination += sizeof(uint64_t);
+		}
+		else
+		{
+			std::memcpy(pDestination, &value, sizeof(ValueType));
+			pDestination += sizeof(ValueType);
+		}
+	}
+};
+
+/**
+ * Binary log string argument structure.
+ * Strings are stored as a 32-bit length followed by the characters (without the null terminator).
+ */
+struct BinaryLogStringArgument
+{
+	[[nodiscard]] static uint32_t GetSize(std::string_view value) { return 1 + sizeof(uint32_t) + static_cast<uint32_t>(value.size()); }
+
+	static void Encode(std::byte*& pDestination, std::string_view value)
+	{
+		const auto length = static_cast<uint32_t>(value.size());
+
+		*pDestination++ = static_cast<std::byte>(BinaryLogArgumentType::String);
+		std::memcpy(pDestination, &length, sizeof(uint32_t));
+		pDestination += sizeof(uint32_t);
+		std::memcpy(pDestination, value.data(), length);
+		pDestination += length;
+	}
+};
+
+template<> struct BinaryLogArgument<const char*> final : BinaryLogStringArgument {};
+template<> struct BinaryLogArgument<char*> final : BinaryLogStringArgument {};
+template<> struct BinaryLogArgument<std::string_view> final : BinaryLogStringArgument {};
+template<> struct BinaryLogArgument<std::string> final : BinaryLogStringArgument {};
+
+/**
+ * Get the binary log argument traits of a type.
+ * Character arrays (string literals) decay to const char*.
+ *
+ * @tparam Type The argument type.
+ */
+template<class Type>
+using BinaryLogArgumentOf = BinaryLogArgument<std::conditional_t<std::is_array_v<std::remove_cvref_t<Type>>, const char*, std::remove_cvref_t<Type>>>;
+
+/**
+ * Binary logger class.
+ * This owns the background writer thread which drains the per-thread log buffers and writes the raw records to a file.
+ * No formatting is done at runtime. Use the BinaryLogDecoder (or the GraphiteLogDecoder tool) to turn the file into text or JSON.
+ *
+ * Only one binary logger can be active at a time. If no logger is active, binary log calls are dropped.
+ */
+class BinaryLogger final
+{
+public:
+	/**
+	 * Explicit constructor.
+	 *
+	 * @param path The output file path.
+	 * @param bufferSize The size of each per-thread buffer in bytes. This is rounded up to a power of two.
+	 */
+	explicit BinaryLogger(std::string_view path, uint32_t bufferSize = 1 << 20);
+
+	/**
+	 * Destructor.
+	 * This will drain all the pending records before returning.
+	 */
+	~BinaryLogger();
+
+	/**
+	 * Register a call site.
+	 * This is called once per call site and is thread safe.
+	 *
+	 * @param formatID The format ID.
+	 * @param level The log level.
+	 * @param format The format string.
+	 * @param file The file name.
+	 * @param line The line number.
+	 * @return Always returns true so it can be used to initialize a static variable.
+	 */
+	static bool RegisterSite(uint64_t formatID, BinaryLogLevel level, std::string_view format, std::string_view file, uint32_t line);
+
+	/**
+	 * Reserve a record in the calling thread's buffer.
+	 *
+	 * @param payloadSize The encoded argument size.
+	 * @param formatID The format ID of the record.
+	 * @return The payload pointer. This will be nullptr if the logger is not active or the buffer is full.
+	 */
+	[[nodiscard]] static std::byte* Reserve(uint32_t payloadSize, uint64_t formatID);
+
+	/**
+	 * Commit the last reserved record of the calling thread.
+	 */
+	static void Commit();
+
+	/**
+	 * Get the number of records dropped because a thread buffer was full.
+	 *
+	 * @return The dropped record count.
+	 */
+	[[nodiscard]] static uint64_t GetDroppedCount();
+
+	GRAPHITE_DISABLE_COPY_AND_MOVE(BinaryLogger);
+
+private:
+	/**
+	 * Background writer thread function.
+	 *
+	 * @param token The stop token.
+	 */
+	void writer(std::stop_token token);
+
+	/**
+	 * Drain all the registered definitions and thread buffers to the file.
+	 */
+	void drain();
+
+private:
+	std::ofstream m_File;
+	std::jthread m_Writer;
+
+	std::mutex m_Mutex;
+	std::condition_variable_any m_Condition;
+};
+
+/**
+ * Write a binary log record.
+ *
+ * @tparam Arguments The argument types.
+ * @param formatID The format ID.
+ * @param arguments The arguments to encode.
+ */
+template<class... Arguments>
+void BinaryLog(uint64_t formatID, const Arguments&... arguments)
+{
+	const uint32_t payloadSize = (0 + ... + BinaryLogArgumentOf<Arguments>::GetSize(arguments));
+
+	auto pPayload = BinaryLogger::Reserve(payloadSize, formatID);
+	if (pPayload == nullptr)
+		return;
+
+	(BinaryLogArgumentOf<Arguments>::Encode(pPayload, arguments), ...);
+	BinaryLogger::Commit();
+}
+
+/**
+ * Binary log output format enum.
+ */
+enum class BinaryLogOutputFormat : uint8_t
+{
+	Text,
+	JSON
+};
+
+/**
+ * Binary log decoder class.
+ * This reads a binary log file written by the BinaryLogger and formats the records offline.
+ */
+class BinaryLogDecoder final
+{
+	/**
+	 * Site structure.
+	 * This contains the information about a single registered call site.
+	 */
+	struct Site final
+	{
+		std::string m_Format;
+		std::string m_File;
+		uint32_t m_Line = 0;
+		BinaryLogLevel m_Level = BinaryLogLevel::Trace;
+	};
+
+	/**
+	 * Event structure.
+	 */
+	struct Event final
+	{
+		BinaryLogEventHeader m_Header;
+		std::vector<std::byte> m_Payload;
+	};
+
+public:
+	/**
+	 * Explicit constructor.
+	 *
+	 * @param path The binary log file path.
+	 */
+	explicit BinaryLogDecoder(std::string_view path);
+
+	/**
+	 * Decode the loaded records.
+	 *
+	 * @param output The output stream.
+	 * @param format The output format.
+	 */
+	void decode(std::ostream& output, BinaryLogOutputFormat format) const;
+
+	/**
+	 * Check if the file was loaded successfully.
+	 *
+	 * @return True if the file was valid.
+	 */
+	[[nodiscard]] bool isValid() const { return m_bIsValid; }
+
+private:
+	/**
+	 * Format a single event.
+	 *
+	 * @param site The event's call site.
+	 * @param event The event to format.
+	 * @return The formatted message.
+	 */
+	[[nodiscard]] std::string formatEvent(const Site& site, const Event& event) const;
+
+private:
+	std::vector<std::pair<uint64_t, Site>> m_Sites;
+	std::vector<Event> m_Events;
+
+	bool m_bIsValid = false;
+};
+
+/**
+ * Binary log macro.
+ * The call site is registered once and every call only copies the raw argument bytes into the calling thread's buffer.
+ * The format string must be a string literal and use the fmt syntax.
+ */
+#define GRAPHITE_BINARY_LOG(level, format, ...)																									\
+	do {																																		\
+		constexpr uint64_t _graphiteFormatID = ::HashBinaryLogSite(format, __FILE__, __LINE__);													\
+		[[maybe_unused]] static const bool _graphiteRegistered = ::BinaryLogger::RegisterSite(_graphiteFormatID, level, format, __FILE__, __LINE__);	\
+		::BinaryLog(_graphiteFormatID __VA_OPT__(,) __VA_ARGS__);																				\
+	} while (false)
+
+#ifdef GRAPHITE_LOG_LEVEL
+#	if GRAPHITE_LOG_LEVEL > 0
+#		define GRAPHITE_BINARY_LOG_FATAL(format, ...)				GRAPHITE_BINARY_LOG(::BinaryLogLevel::Fatal, format __VA_OPT__(,) __VA_ARGS__)
+
+#		if GRAPHITE_LOG_LEVEL > 1
+#			define GRAPHITE_BINARY_LOG_ERROR(format, ...)			GRAPHITE_BINARY_LOG(::BinaryLogLevel::Error, format __VA_OPT__(,) __VA_ARGS__)
+
+#			if GRAPHITE_LOG_LEVEL > 2
+#				define GRAPHITE_BINARY_LOG_WARNING(format, ...)		GRAPHITE_BINARY_LOG(::BinaryLogLevel::Warning, format __VA_OPT__(,) __VA_ARGS__)
+
+#				if GRAPHITE_LOG_LEVEL > 3
+#					define GRAPHITE_BINARY_LOG_INFORMATION(format, ...)	GRAPHITE_BINARY_LOG(::BinaryLogLevel::Information, format __VA_OPT__(,) __VA_ARGS__)
+
+#					if GRAPHITE_LOG_LEVEL > 4
+#						define GRAPHITE_BINARY_LOG_TRACE(format, ...)	GRAPHITE_BINARY_LOG(::BinaryLogLevel::Trace, format __VA_OPT__(,) __VA_ARGS__)
+
+#					endif
+#				endif
+#			endif
+#		endif
+#	endif
+#endif // GRAPHITE_LOG_LEVEL
+
+#ifndef GRAPHITE_BINARY_LOG_FATAL
+#	define GRAPHITE_BINARY_LOG_FATAL(...)							::NoOp()
+#endif
+
+#ifndef GRAPHITE_BINARY_LOG_ERROR
+#	define GRAPHITE_BINARY_LOG_ERROR(...)							::NoOp()
+#endif
+
+#ifndef GRAPHITE_BINARY_LOG_WARNING
+#	define GRAPHITE_BINARY_LOG_WARNING(...)							::NoOp()
+#endif
+
+#ifndef GRAPHITE_BINARY_LOG_INFORMATION
+#	define GRAPHITE_BINARY_LOG_INFORMATION(...)						::NoOp()
+#endif
+
+#ifndef GRAPHITE_BINARY_LOG_TRACE
+#	define GRAPHITE_BINARY_LOG_TRACE(...)							::NoOp()
+#endif
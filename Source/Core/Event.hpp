@@ -0,0 +1,108 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "LockFreeQueue.hpp"
+
+/**
+ * Event type enum.
+ * This is used to route the events to their subscribers.
+ */
+enum class EventType : uint8_t
+{
+	Quit,
+
+	WindowResized,
+	WindowMinimized,
+	WindowRestored,
+	WindowFocusGained,
+	WindowFocusLost,
+
+	KeyDown,
+	KeyUp,
+
+	MouseMotion,
+	MouseButtonDown,
+	MouseButtonUp,
+	MouseWheel,
+
+	Count
+};
+
+/**
+ * Window event structure.
+ */
+struct WindowEvent final
+{
+	uint32_t m_Width = 0;
+	uint32_t m_Height = 0;
+};
+
+/**
+ * Key event structure.
+ */
+struct KeyEvent final
+{
+	uint32_t m_ScanCode = 0;
+	uint32_t m_KeyCode = 0;
+	uint16_t m_Modifiers = 0;
+	bool m_bIsRepeat = false;
+};
+
+/**
+ * Mouse motion event structure.
+ */
+struct MouseMotionEvent final
+{
+	float m_PositionX = 0.0f;
+	float m_PositionY = 0.0f;
+	float m_DeltaX = 0.0f;
+	float m_DeltaY = 0.0f;
+};
+
+/**
+ * Mouse button event structure.
+ */
+struct MouseButtonEvent final
+{
+	float m_PositionX = 0.0f;
+	float m_PositionY = 0.0f;
+	uint8_t m_Button = 0;
+	uint8_t m_Clicks = 0;
+};
+
+/**
+ * Mouse wheel event structure.
+ */
+struct MouseWheelEvent final
+{
+	float m_DeltaX = 0.0f;
+	float m_DeltaY = 0.0f;
+};
+
+/**
+ * Event structure.
+ * This is a compact, trivially copyable representation of a single platform event. Only the member matching the type is valid.
+ */
+struct Event final
+{
+	uint64_t m_Timestamp = 0;
+	EventType m_Type = EventType::Quit;
+
+	union
+	{
+		WindowEvent m_Window = {};
+		KeyEvent m_Key;
+		MouseMotionEvent m_MouseMotion;
+		MouseButtonEvent m_MouseButton;
+		MouseWheelEvent m_MouseWheel;
+	};
+};
+
+static_assert(std::is_trivially_copyable_v<Event>, "Events must be trivially copyable!");
+
+/**
+ * Event queue type.
+ * Every consumer system owns one of these, and the window pushes the events to all of them.
+ */
+using EventQueue = LockFreeQueue<Event, 4096>;
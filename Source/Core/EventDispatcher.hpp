@@ -0,0 +1,102 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "Event.hpp"
+
+#include <array>
+#include <vector>
+
+/**
+ * Event dispatcher class.
+ * This drains an event queue and calls the subscribers of each event's type. Subscribers are stored as plain function pointers (with a user data
+ * pointer) per event type, so dispatching an event is a single indexed lookup and an indirect call without any virtual functions.
+ *
+ * A dispatcher is meant to be used by a single consumer thread. Subscribe before dispatching events.
+ */
+class EventDispatcher final
+{
+public:
+	using Callback = void(*)(void*, const Event&);
+
+	/**
+	 * Subscriber structure.
+	 */
+	struct Subscriber final
+	{
+		Callback m_Callback = nullptr;
+		void* m_pUserData = nullptr;
+	};
+
+public:
+	/**
+	 * Subscribe a callback to an event type.
+	 *
+	 * @param type The event type.
+	 * @param callback The callback function.
+	 * @param pUserData The user data passed to the callback.
+	 */
+	void subscribe(EventType type, Callback callback, void* pUserData = nullptr)
+	{
+		m_Subscribers[static_cast<uint8_t>(type)].emplace_back(Subscriber{ callback, pUserData });
+	}
+
+	/**
+	 * Subscribe a member function to an event type.
+	 *
+	 * @tparam Method The member function pointer.
+	 * @tparam Object The object type.
+	 * @param type The event type.
+	 * @param pObject The object pointer.
+	 */
+	template<auto Method, class Object>
+	void subscribe(EventType type, Object* pObject)
+	{
+		subscribe(type, [](void* pUserData, const Event& event) { (static_cast<Object*>(pUserData)->*Method)(event); }, pObject);
+	}
+
+	/**
+	 * Remove all the subscribers registered with the given user data.
+	 *
+	 * @param pUserData The user data pointer.
+	 */
+	void unsubscribe(void* pUserData)
+	{
+		for (auto& subscribers : m_Subscribers)
+			std::erase_if(subscribers, [pUserData](const Subscriber& subscriber) { return subscriber.m_pUserData == pUserData; });
+	}
+
+	/**
+	 * Dispatch a single event.
+	 *
+	 * @param event The event to dispatch.
+	 */
+	void dispatch(const Event& event) const
+	{
+		for (const auto& subscriber : m_Subscribers[static_cast<uint8_t>(event.m_Type)])
+			subscriber.m_Callback(subscriber.m_pUserData, event);
+	}
+
+	/**
+	 * Drain the queue and dispatch all the events.
+	 *
+	 * @param queue The queue to drain.
+	 * @return The number of dispatched events.
+	 */
+	uint64_t dispatch(EventQueue& queue) const
+	{
+		uint64_t count = 0;
+
+		Event event = {};
+		while (queue.tryPop(event))
+		{
+			dispatch(event);
+			count++;
+		}
+
+		return count;
+	}
+
+private:
+	std::array<std::vector<Subscriber>, static_cast<uint8_t>(EventType::Count)> m_Subscribers;
+};
@@ -0,0 +1,327 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "FrameStatistics.hpp"
+#include "Logging.hpp"
+#include "AllocationTracker.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+#include <vector>
+
+namespace /* anonymous */
+{
+	// The weight of the newest frame in the moving average used to detect hitches.
+	constexpr double g_AverageWeight = 0.05;
+
+	// The frames which are not checked for hitches, so the moving average can settle after startup.
+	constexpr uint64_t g_HitchWarmupFrames = 16;
+
+	/**
+	 * Convert a duration to milliseconds.
+	 *
+	 * @param duration The duration to convert.
+	 * @return The duration in milliseconds.
+	 */
+	template<class Duration>
+	[[nodiscard]] float ToMilliseconds(Duration duration)
+	{
+		return std::chrono::duration<float, std::milli>(duration).count();
+	}
+
+	/**
+	 * Compute the percentiles of a set of values.
+	 * The values are sorted in place, and the percentiles use the nearest rank.
+	 *
+	 * @param values The values.
+	 * @return The percentiles. Everything is 0 if there are no values.
+	 */
+	[[nodiscard]] FrameTimePercentiles ComputePercentiles(std::vector<float>& values)
+	{
+		FrameTimePercentiles percentiles;
+		if (values.empty())
+			return percentiles;
+
+		GRAPHITE_RANGES(sort, values, std::less<float>());
+
+		const auto rank = [&values](float percentile)
+		{
+			const auto index = static_cast<size_t>(std::ceil(percentile * static_cast<float>(values.size())));
+			return values[std::clamp<size_t>(index, 1, values.size()) - 1];
+		};
+
+		percentiles.m_Average = std::accumulate(values.begin(), values.end(), 0.0f) / static_cast<float>(values.size());
+		percentiles.m_P50 = rank(0.50f);
+		percentiles.m_P95 = rank(0.95f);
+		percentiles.m_P99 = rank(0.99f);
+		percentiles.m_Maximum = values.back();
+
+		return percentiles;
+	}
+
+	/**
+	 * Write percentiles as a JSON object.
+	 *
+	 * @param stream The stream to write to.
+	 * @param percentiles The percentiles.
+	 */
+	void WritePercentilesJSON(std::ostream& stream, const FrameTimePercentiles& percentiles)
+	{
+		stream << fmt::format("{{ \"average\": {:.3f}, \"p50\": {:.3f}, \"p95\": {:.3f}, \"p99\": {:.3f}, \"max\": {:.3f} }}",
+			percentiles.m_Average, percentiles.m_P50, percentiles.m_P95, percentiles.m_P99, percentiles.m_Maximum);
+	}
+
+	/**
+	 * Write percentiles as CSV columns.
+	 *
+	 * @param stream The stream to write to.
+	 * @param percentiles The percentiles.
+	 */
+	void WritePercentilesCSV(std::ostream& stream, const FrameTimePercentiles& percentiles)
+	{
+		stream << fmt::format(",{:.3f},{:.3f},{:.3f},{:.3f},{:.3f}", percentiles.m_Average, percentiles.m_P50, percentiles.m_P95, percentiles.m_P99, percentiles.m_Maximum);
+	}
+}
+
+FrameStatistics::FrameStatistics(float hitchFactor /*= 2.0f*/)
+	: m_HitchFactor(hitchFactor)
+{
+}
+
+FrameStatistics::~FrameStatistics()
+{
+	stopDumping();
+}
+
+uint64_t FrameStatistics::beginFrame()
+{
+	const auto now = Clock::now();
+	const auto heapAllocationCount = AllocationTracker::GetThreadAllocationCount();
+	if (m_bIsFrameActive)
+		endFrame(now - m_FrameStart, heapAllocationCount - m_FrameHeapAllocationCount);
+
+	m_FrameStart = now;
+	m_FrameHeapAllocationCount = heapAllocationCount;
+	m_ArenaSize = 0;
+	m_PhaseTimes = {};
+	m_bIsFrameActive = true;
+
+	return m_FrameCount.load(std::memory_order_relaxed);
+}
+
+void FrameStatistics::recordGPUTime(uint64_t frameIndex, std::chrono::nanoseconds duration)
+{
+	auto& slot = m_Slots[frameIndex % HistorySize];
+	const auto sequence = (frameIndex + 1) * 2;
+	if (slot.m_Sequence.load(std::memory_order_relaxed) != sequence)
+		return;
+
+	slot.m_Sequence.store(sequence - 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	slot.m_Values[GPUTimeIndex].store(ToMilliseconds(duration), std::memory_order_relaxed);
+	slot.m_Sequence.store(sequence, std::memory_order_release);
+}
+
+FrameStatisticsSummary FrameStatistics::computeSummary(uint32_t window /*= HistorySize*/) const
+{
+	FrameStatisticsSummary summary;
+	summary.m_TotalHitchCount = getTotalHitchCount();
+
+	const auto frameCount = getFrameCount();
+	const auto count = std::min<uint64_t>({ window, HistorySize, frameCount });
+	if (count == 0)
+		return summary;
+
+	std::vector<float> cpuTimes;
+	std::vector<float> gpuTimes;
+	std::array<std::vector<float>, PhaseCount> phaseTimes;
+
+	cpuTimes.reserve(count);
+	gpuTimes.reserve(count);
+	for (auto& times : phaseTimes)
+		times.reserve(count);
+
+	std::array<float, ValueCount> values = {};
+	for (auto frame = frameCount - count; frame < frameCount; frame++)
+	{
+		const auto& slot = m_Slots[frame % HistorySize];
+		const auto sequence = (frame + 1) * 2;
+		if (slot.m_Sequence.load(std::memory_order_acquire) != sequence)
+			continue;
+
+		for (uint8_t i = 0; i < ValueCount; i++)
+			values[i] = slot.m_Values[i].load(std::memory_order_relaxed);
+
+		// If the writer touched the slot while we were reading it, the values are torn, so the frame is dropped.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.m_Sequence.load(std::memory_order_relaxed) != sequence)
+			continue;
+
+		cpuTimes.emplace_back(values[CPUTimeIndex]);
+		if (values[GPUTimeIndex] >= 0.0f)
+			gpuTimes.emplace_back(values[GPUTimeIndex]);
+
+		if (values[HitchIndex] > 0.0f)
+			summary.m_HitchCount++;
+
+		if (values[HeapAllocationIndex] > 0.0f)
+		{
+			summary.m_HeapAllocationCount += static_cast<uint64_t>(values[HeapAllocationIndex]);
+			summary.m_AllocatingFrameCount++;
+		}
+
+		summary.m_PeakArenaSize = std::max(summary.m_PeakArenaSize, values[ArenaSizeIndex]);
+
+		for (uint8_t i = 0; i < PhaseCount; i++)
+			phaseTimes[i].emplace_back(values[PhaseIndex + i]);
+
+		summary.m_LastFrame = frame;
+	}
+
+	summary.m_FrameCount = static_cast<uint32_t>(cpuTimes.size());
+	summary.m_GPUFrameCount = static_cast<uint32_t>(gpuTimes.size());
+	summary.m_CPUTime = ComputePercentiles(cpuTimes);
+	summary.m_GPUTime = ComputePercentiles(gpuTimes);
+
+	for (uint8_t i = 0; i < PhaseCount; i++)
+		summary.m_PhaseTimes[i] = ComputePercentiles(phaseTimes[i]);
+
+	return summary;
+}
+
+void FrameStatistics::startDumping(std::filesystem::path path, std::chrono::milliseconds interval, uint32_t window /*= HistorySize*/)
+{
+	stopDumping();
+	m_DumpWorker = std::jthread([this, path = std::move(path), interval, window](std::stop_token stopToken) { dump(stopToken, path, interval, window); });
+}
+
+void FrameStatistics::stopDumping()
+{
+	if (!m_DumpWorker.joinable())
+		return;
+
+	m_DumpWorker.request_stop();
+	m_DumpWorker.join();
+}
+
+void FrameStatistics::WriteJSON(std::ostream& stream, const FrameStatisticsSummary& summary)
+{
+	stream << fmt::format("{{\n  \"last_frame\": {},\n  \"frame_count\": {},\n  \"gpu_frame_count\": {},\n  \"hitch_count\": {},\n  \"total_hitch_count\": {},\n",
+		summary.m_LastFrame, summary.m_FrameCount, summary.m_GPUFrameCount, summary.m_HitchCount, summary.m_TotalHitchCount);
+
+	stream << fmt::format("  \"heap_allocation_count\": {},\n  \"allocating_frame_count\": {},\n  \"peak_arena_kib\": {:.3f},\n",
+		summary.m_HeapAllocationCount, summary.m_AllocatingFrameCount, summary.m_PeakArenaSize);
+
+	stream << "  \"time_unit\": \"ms\",\n  \"cpu\": ";
+	WritePercentilesJSON(stream, summary.m_CPUTime);
+
+	stream << ",\n  \"gpu\": ";
+	WritePercentilesJSON(stream, summary.m_GPUTime);
+
+	stream << ",\n  \"phases\": {\n";
+	for (uint8_t i = 0; i < PhaseCount; i++)
+	{
+		stream << fmt::format("    \"{}\": ", GetFramePhaseName(static_cast<FramePhase>(i)));
+		WritePercentilesJSON(stream, summary.m_PhaseTimes[i]);
+		stream << (i + 1 < PhaseCount ? ",\n" : "\n");
+	}
+
+	stream << "  }\n}\n";
+}
+
+void FrameStatistics::WriteCSVHeader(std::ostream& stream)
+{
+	const auto writeColumns = [&stream](std::string_view name)
+	{
+		stream << fmt::format(",{0}_average,{0}_p50,{0}_p95,{0}_p99,{0}_max", name);
+	};
+
+	stream << "last_frame,frame_count,gpu_frame_count,hitch_count,total_hitch_count";
+	writeColumns("cpu");
+	writeColumns("gpu");
+
+	for (uint8_t i = 0; i < PhaseCount; i++)
+		writeColumns(GetFramePhaseName(static_cast<FramePhase>(i)));
+
+	stream << ",heap_allocation_count,allocating_frame_count,peak_arena_kib\n";
+}
+
+void FrameStatistics::WriteCSV(std::ostream& stream, const FrameStatisticsSummary& summary)
+{
+	stream << fmt::format("{},{},{},{},{}", summary.m_LastFrame, summary.m_FrameCount, summary.m_GPUFrameCount, summary.m_HitchCount, summary.m_TotalHitchCount);
+	WritePercentilesCSV(stream, summary.m_CPUTime);
+	WritePercentilesCSV(stream, summary.m_GPUTime);
+
+	for (const auto& percentiles : summary.m_PhaseTimes)
+		WritePercentilesCSV(stream, percentiles);
+
+	stream << fmt::format(",{},{},{:.3f}\n", summary.m_HeapAllocationCount, summary.m_AllocatingFrameCount, summary.m_PeakArenaSize);
+}
+
+void FrameStatistics::endFrame(Clock::duration frameTime, uint64_t heapAllocationCount)
+{
+	const auto frame = m_FrameCount.load(std::memory_order_relaxed);
+	const auto frameTimeMilliseconds = ToMilliseconds(frameTime);
+
+	// Compare against the average of the previous frames, so a hitch does not raise it's own threshold.
+	const auto bIsHitch = frame >= g_HitchWarmupFrames && frameTimeMilliseconds > m_HitchFactor * m_AverageFrameTime;
+	if (bIsHitch)
+		m_TotalHitchCount.fetch_add(1, std::memory_order_relaxed);
+
+	m_AverageFrameTime = frame == 0 ? frameTimeMilliseconds : m_AverageFrameTime + g_AverageWeight * (frameTimeMilliseconds - m_AverageFrameTime);
+
+	auto& slot = m_Slots[frame % HistorySize];
+	slot.m_Sequence.store(frame * 2 + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	slot.m_Values[CPUTimeIndex].store(frameTimeMilliseconds, std::memory_order_relaxed);
+	slot.m_Values[GPUTimeIndex].store(-1.0f, std::memory_order_relaxed);
+	slot.m_Values[HitchIndex].store(bIsHitch ? 1.0f : 0.0f, std::memory_order_relaxed);
+	slot.m_Values[HeapAllocationIndex].store(static_cast<float>(heapAllocationCount), std::memory_order_relaxed);
+	slot.m_Values[ArenaSizeIndex].store(static_cast<float>(m_ArenaSize) / 1024.0f, std::memory_order_relaxed);
+
+	for (uint8_t i = 0; i < PhaseCount; i++)
+		slot.m_Values[PhaseIndex + i].store(ToMilliseconds(m_PhaseTimes[i]), std::memory_order_relaxed);
+
+	slot.m_Sequence.store((frame + 1) * 2, std::memory_order_release);
+	m_FrameCount.store(frame + 1, std::memory_order_release);
+}
+
+void FrameStatistics::dump(std::stop_token stopToken, std::filesystem::path path, std::chrono::milliseconds interval, uint32_t window)
+{
+	const auto bIsCSV = path.extension() == ".csv";
+	auto lock = std::unique_lock(m_DumpMutex);
+
+	while (true)
+	{
+		// The stop token wakes the wait up, so stopping does not have to wait for the interval.
+		m_DumpCondition.wait_for(lock, stopToken, interval, [] { return false; });
+		if (stopToken.stop_requested())
+			break;
+
+		const auto summary = computeSummary(window);
+		if (summary.m_FrameCount == 0)
+			continue;
+
+		std::error_code error;
+		const auto bNeedsHeader = bIsCSV && (!std::filesystem::exists(path, error) || std::filesystem::file_size(path, error) == 0);
+
+		auto file = std::ofstream(path, bIsCSV ? std::ios::app : std::ios::trunc);
+		if (!file.is_open())
+		{
+			GRAPHITE_LOG_ERROR("Failed to open the frame statistics file {}! Stopping the dump.", path.string());
+			break;
+		}
+
+		if (bNeedsHeader)
+			WriteCSVHeader(file);
+
+		if (bIsCSV)
+			WriteCSV(file, summary);
+
+		else
+			WriteJSON(file, summary);
+	}
+}
@@ -0,0 +1,287 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "Common.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <thread>
+
+/**
+ * Frame phase enum.
+ * This specifies the parts of the main loop which are timed separately.
+ */
+enum class FramePhase : uint8_t
+{
+	Pacing,		// Waiting for the frame pacer.
+	Input,		// Polling the window and dispatching the events.
+	Simulation,	// Fetching the interpolated simulation state.
+	Streaming,	// Updating the texture streamer.
+	Submission,	// Flushing the command submission queue.
+
+	Count
+};
+
+/**
+ * Get the name of a frame phase.
+ *
+ * @param phase The phase.
+ * @return The name.
+ */
+[[nodiscard]] constexpr std::string_view GetFramePhaseName(FramePhase phase)
+{
+	constexpr std::array<std::string_view, static_cast<uint8_t>(FramePhase::Count)> names = { "pacing", "input", "simulation", "streaming", "submission" };
+	return names[static_cast<uint8_t>(phase)];
+}
+
+/**
+ * Frame time percentiles structure.
+ * This contains the distribution of a single measurement over the statistics window, in milliseconds.
+ */
+struct FrameTimePercentiles final
+{
+	float m_Average = 0.0f;
+	float m_P50 = 0.0f;
+	float m_P95 = 0.0f;
+	float m_P99 = 0.0f;
+	float m_Maximum = 0.0f;
+};
+
+/**
+ * Frame statistics summary structure.
+ * This contains the rolling statistics over the last frames.
+ */
+struct FrameStatisticsSummary final
+{
+	FrameTimePercentiles m_CPUTime;
+	FrameTimePercentiles m_GPUTime;
+	std::array<FrameTimePercentiles, static_cast<uint8_t>(FramePhase::Count)> m_PhaseTimes = {};
+
+	uint64_t m_LastFrame = 0;		// The index of the newest frame in the window.
+	uint64_t m_TotalHitchCount = 0;	// The number of hitches since the statistics were created.
+
+	uint32_t m_FrameCount = 0;		// The number of frames in the window.
+	uint32_t m_GPUFrameCount = 0;	// The number of frames in the window which have a GPU time.
+	uint32_t m_HitchCount = 0;		// The number of hitches in the window.
+
+	uint64_t m_HeapAllocationCount = 0;	// The number of general heap allocations the main loop made in the window.
+	uint32_t m_AllocatingFrameCount = 0;	// The number of frames in the window which allocated from the general heap.
+	float m_PeakArenaSize = 0.0f;			// The most frame arena memory a frame in the window used, in KiB.
+};
+
+/**
+ * Frame statistics class.
+ * This records the CPU time, the time of each phase and the GPU time of every frame in a ring buffer, and computes rolling percentiles and hitch
+ * counts from it.
+ *
+ * The frames are recorded by a single thread, the main loop. Every slot of the ring is protected by a sequence counter, so any other thread can
+ * compute the statistics without ever blocking the main loop; a reader which races with the writer simply drops the frames that were being
+ * overwritten. A frame is a hitch when it's CPU time is over the hitch factor times the moving average of the previous frames.
+ *
+ * The general heap allocations of each frame are counted on the thread which records the frames, so a steady state frame should show none.
+ */
+class FrameStatistics final
+{
+	static constexpr uint8_t PhaseCount = static_cast<uint8_t>(FramePhase::Count);
+
+	// The values of a slot: the CPU time, the GPU time, the hitch flag, the heap allocation count, the frame arena size and the phase times.
+	static constexpr uint8_t CPUTimeIndex = 0;
+	static constexpr uint8_t GPUTimeIndex = 1;
+	static constexpr uint8_t HitchIndex = 2;
+	static constexpr uint8_t HeapAllocationIndex = 3;
+	static constexpr uint8_t ArenaSizeIndex = 4;
+	static constexpr uint8_t PhaseIndex = 5;
+	static constexpr uint8_t ValueCount = PhaseIndex + PhaseCount;
+
+	/**
+	 * Slot structure.
+	 * The sequence is odd while the slot is being written, and 2 * (frame index + 1) once the frame is written.
+	 */
+	struct Slot final
+	{
+		std::atomic_uint64_t m_Sequence = 0;
+		std::array<std::atomic<float>, ValueCount> m_Values = {};
+	};
+
+public:
+	using Clock = std::chrono::steady_clock;
+
+	// The number of frames kept in the ring, which is also the largest statistics window.
+	static constexpr uint32_t HistorySize = 1024;
+
+	/**
+	 * Phase class.
+	 * This adds the time from it's construction till it's destruction to a phase of the current frame.
+	 */
+	class Phase final
+	{
+	public:
+		/**
+		 * Explicit constructor.
+		 *
+		 * @param statistics The statistics to record to.
+		 * @param phase The phase to time.
+		 */
+		explicit Phase(FrameStatistics& statistics, FramePhase phase) : m_Statistics(statistics), m_Start(Clock::now()), m_Phase(phase) {}
+
+		/**
+		 * Destructor.
+		 */
+		~Phase() { m_Statistics.addPhaseTime(m_Phase, Clock::now() - m_Start); }
+
+		GRAPHITE_DISABLE_COPY_AND_MOVE(Phase);
+
+	private:
+		FrameStatistics& m_Statistics;
+		Clock::time_point m_Start;
+		FramePhase m_Phase;
+	};
+
+public:
+	/**
+	 * Explicit constructor.
+	 *
+	 * @param hitchFactor The frame time over the moving average which makes a frame a hitch. Default is 2.
+	 */
+	explicit FrameStatistics(float hitchFactor = 2.0f);
+
+	/**
+	 * Destructor.
+	 * This stops the periodic dump.
+	 */
+	~FrameStatistics();
+
+	GRAPHITE_DISABLE_COPY_AND_MOVE(FrameStatistics);
+
+	/**
+	 * Begin a new frame.
+	 * The CPU frame time is measured from one call to the next.
+	 *
+	 * @return The index of the new frame.
+	 */
+	uint64_t beginFrame();
+
+	/**
+	 * Add time to a phase of the current frame.
+	 * Prefer the Phase class over calling this directly.
+	 *
+	 * @param phase The phase.
+	 * @param duration The time to add.
+	 */
+	void addPhaseTime(FramePhase phase, Clock::duration duration) { m_PhaseTimes[static_cast<uint8_t>(phase)] += duration; }
+
+	/**
+	 * Record the GPU time of a frame.
+	 * The GPU time is only known a few frames later, so this is ignored if the frame is no longer in the ring. This must be called by the thread
+	 * which records the frames.
+	 *
+	 * @param frameIndex The frame index returned by beginFrame().
+	 * @param duration The GPU time.
+	 */
+	void recordGPUTime(uint64_t frameIndex, std::chrono::nanoseconds duration);
+
+	/**
+	 * Record how much of the frame arena the current frame used.
+	 * Call this before the arena is reset.
+	 *
+	 * @param size The used size in bytes.
+	 */
+	void recordArenaSize(size_t size) { m_ArenaSize = std::max(m_ArenaSize, size); }
+
+	/**
+	 * Compute the statistics over the last frames.
+	 * This is thread safe.
+	 *
+	 * @param window The number of frames to include. This is clamped to the history size.
+	 * @return The summary.
+	 */
+	[[nodiscard]] FrameStatisticsSummary computeSummary(uint32_t window = HistorySize) const;
+
+	/**
+	 * Start dumping the statistics to a file periodically on a worker thread.
+	 * A file with the .csv extension gets a row appended on every dump, anything else is overwritten with the latest summary as JSON.
+	 *
+	 * @param path The file path.
+	 * @param interval The time between the dumps.
+	 * @param window The number of frames each dump includes. Default is the history size.
+	 */
+	void startDumping(std::filesystem::path path, std::chrono::milliseconds interval, uint32_t window = HistorySize);
+
+	/**
+	 * Stop the periodic dump.
+	 */
+	void stopDumping();
+
+	/**
+	 * Write a summary as a JSON object.
+	 *
+	 * @param stream The stream to write to.
+	 * @param summary The summary.
+	 */
+	static void WriteJSON(std::ostream& stream, const FrameStatisticsSummary& summary);
+
+	/**
+	 * Write the CSV header line which matches WriteCSV().
+	 *
+	 * @param stream The stream to write to.
+	 */
+	static void WriteCSVHeader(std::ostream& stream);
+
+	/**
+	 * Write a summary as a CSV line.
+	 *
+	 * @param stream The stream to write to.
+	 * @param summary The summary.
+	 */
+	static void WriteCSV(std::ostream& stream, const FrameStatisticsSummary& summary);
+
+public:
+	[[nodiscard]] uint64_t getFrameCount() const { return m_FrameCount.load(std::memory_order_acquire); }
+	[[nodiscard]] uint64_t getTotalHitchCount() const { return m_TotalHitchCount.load(std::memory_order_relaxed); }
+
+private:
+	/**
+	 * Write the finished frame to it's slot.
+	 *
+	 * @param frameTime The CPU time of the frame.
+	 * @param heapAllocationCount The number of heap allocations of the frame.
+	 */
+	void endFrame(Clock::duration frameTime, uint64_t heapAllocationCount);
+
+	/**
+	 * Dump the statistics periodically till a stop is requested.
+	 *
+	 * @param stopToken The worker's stop token.
+	 * @param path The file path.
+	 * @param interval The time between the dumps.
+	 * @param window The number of frames each dump includes.
+	 */
+	void dump(std::stop_token stopToken, std::filesystem::path path, std::chrono::milliseconds interval, uint32_t window);
+
+private:
+	std::array<Slot, HistorySize> m_Slots;
+
+	std::array<Clock::duration, PhaseCount> m_PhaseTimes = {};
+	Clock::time_point m_FrameStart;
+	uint64_t m_FrameHeapAllocationCount = 0;
+	size_t m_ArenaSize = 0;
+
+	std::mutex m_DumpMutex;
+	std::condition_variable_any m_DumpCondition;
+	std::jthread m_DumpWorker;
+
+	alignas(64) std::atomic_uint64_t m_FrameCount = 0;
+	std::atomic_uint64_t m_TotalHitchCount = 0;
+
+	double m_AverageFrameTime = 0.0;
+	float m_HitchFactor = 2.0f;
+	bool m_bIsFrameActive = false;
+};
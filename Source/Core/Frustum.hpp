@@ -0,0 +1,71 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+/**
+ * Frustum structure.
+ * This contains the six planes of a view frustum. Each plane is stored as the normal pointing into the frustum and the distance, so a point is
+ * inside a plane if dot(normal, point) + distance >= 0. The layout matches the culling shader's push constants.
+ */
+struct Frustum final
+{
+	std::array<std::array<float, 4>, 6> m_Planes = {};
+
+	/**
+	 * Extract the frustum planes from a view projection matrix.
+	 * The matrix is column major, and the clip space depth is in the range [0, 1] like in Vulkan.
+	 *
+	 * @param matrix The view projection matrix.
+	 * @return The frustum.
+	 */
+	[[nodiscard]] static Frustum FromViewProjection(const std::array<float, 16>& matrix)
+	{
+		// Get a row of the matrix.
+		const auto row = [&matrix](uint32_t index) { return std::array<float, 4>{ matrix[index], matrix[4 + index], matrix[8 + index], matrix[12 + index] }; };
+		const auto add = [](const std::array<float, 4>& lhs, const std::array<float, 4>& rhs) { return std::array<float, 4>{ lhs[0] + rhs[0], lhs[1] + rhs[1], lhs[2] + rhs[2], lhs[3] + rhs[3] }; };
+		const auto subtract = [](const std::array<float, 4>& lhs, const std::array<float, 4>& rhs) { return std::array<float, 4>{ lhs[0] - rhs[0], lhs[1] - rhs[1], lhs[2] - rhs[2], lhs[3] - rhs[3] }; };
+
+		Frustum frustum;
+		frustum.m_Planes[0] = add(row(3), row(0));		// Left.
+		frustum.m_Planes[1] = subtract(row(3), row(0));	// Right.
+		frustum.m_Planes[2] = add(row(3), row(1));		// Bottom.
+		frustum.m_Planes[3] = subtract(row(3), row(1));	// Top.
+		frustum.m_Planes[4] = row(2);					// Near.
+		frustum.m_Planes[5] = subtract(row(3), row(2));	// Far.
+
+		// Normalize the planes so the distances are in world units, which the sphere tests need.
+		for (auto& plane : frustum.m_Planes)
+		{
+			const auto length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+			if (length > 0.0f)
+			{
+				for (auto& component : plane)
+					component /= length;
+			}
+		}
+
+		return frustum;
+	}
+
+	/**
+	 * Check if a sphere is at least partially inside the frustum.
+	 *
+	 * @param center The sphere center.
+	 * @param radius The sphere radius.
+	 * @return True if the sphere is visible.
+	 */
+	[[nodiscard]] bool intersectsSphere(const std::array<float, 3>& center, float radius) const
+	{
+		for (const auto& plane : m_Planes)
+		{
+			if (plane[0] * center[0] + plane[1] * center[1] + plane[2] * center[2] + plane[3] < -radius)
+				return false;
+		}
+
+		return true;
+	}
+};
@@ -0,0 +1,83 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "LODSelector.hpp"
+
+#include <algorithm>
+
+namespace /* anonymous */
+{
+	// The distance used for objects around the camera, so their error doesn't become infinite.
+	constexpr float g_MinimumDistance = 1e-3f;
+}
+
+LODSelector::LODSelector(float errorThreshold /*= 1.0f*/, float hysteresis /*= 0.25f*/)
+	: m_ErrorThreshold(errorThreshold)
+	, m_Hysteresis(std::clamp(hysteresis, 0.0f, 1.0f))
+{
+}
+
+void LODSelector::setView(const std::array<float, 3>& cameraPosition, float verticalFieldOfView, uint32_t viewportHeight)
+{
+	m_CameraPosition = cameraPosition;
+
+	// The number of pixels a unit long object covers one unit away from the camera.
+	m_ProjectionScale = static_cast<float>(viewportHeight) / (2.0f * std::tan(verticalFieldOfView * 0.5f));
+}
+
+uint32_t LODSelector::select(uint32_t currentLOD, const std::array<float, 4>& boundingSphere, std::span<const MeshLOD> lods) const
+{
+	if (lods.empty())
+		return 0;
+
+	currentLOD = std::min(currentLOD, static_cast<uint32_t>(lods.size() - 1));
+
+	// Go finer right away, but only go coarser once the error is clearly below the threshold.
+	const auto lod = findCoarsest(boundingSphere, lods, m_ErrorThreshold);
+	if (lod <= currentLOD)
+		return lod;
+
+	return std::max(currentLOD, findCoarsest(boundingSphere, lods, m_ErrorThreshold * (1.0f - m_Hysteresis)));
+}
+
+bool LODSelector::cullAndSelect(const Frustum& frustum, const std::array<float, 4>& boundingSphere, std::span<const MeshLOD> lods, uint32_t& lod) const
+{
+	if (!frustum.intersectsSphere({ boundingSphere[0], boundingSphere[1], boundingSphere[2] }, boundingSphere[3]))
+		return false;
+
+	lod = select(lod, boundingSphere, lods);
+	return true;
+}
+
+bool LODSelector::cullAndSelect(const Frustum& frustum, const std::array<float, 4>& boundingSphere, std::span<const MeshLOD> lods, uint32_t& lod, float& screenSize) const
+{
+	if (!cullAndSelect(frustum, boundingSphere, lods, lod))
+		return false;
+
+	screenSize = projectSize(boundingSphere);
+	return true;
+}
+
+float LODSelector::projectError(const std::array<float, 4>& boundingSphere, float error) const
+{
+	const auto x = boundingSphere[0] - m_CameraPosition[0];
+	const auto y = boundingSphere[1] - m_CameraPosition[1];
+	const auto z = boundingSphere[2] - m_CameraPosition[2];
+	const auto distance = std::max(std::sqrt(x * x + y * y + z * z) - boundingSphere[3], g_MinimumDistance);
+
+	return error * m_ProjectionScale / distance;
+}
+
+uint32_t LODSelector::findCoarsest(const std::array<float, 4>& boundingSphere, std::span<const MeshLOD> lods, float threshold) const
+{
+	// The errors grow with the LOD index, so the first LOD over the threshold ends the search.
+	uint32_t lod = 0;
+	for (uint32_t i = 1; i < lods.size(); i++)
+	{
+		if (projectError(boundingSphere, lods[i].m_Error) > threshold)
+			break;
+
+		lod = i;
+	}
+
+	return lod;
+}
@@ -0,0 +1,111 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "Frustum.hpp"
+#include "MeshSimplifier.hpp"
+
+/**
+ * LOD selector class.
+ * This picks the coarsest LOD of a mesh whose error, projected to the screen, is below a threshold in pixels. The error of a LOD bounds how far
+ * it's vertices moved from the full detail mesh, and it's projected at the nearest point of the object's bounding sphere, so the selection is
+ * conservative.
+ *
+ * To avoid popping when an object sits on the boundary of two LODs, an object only switches to a coarser LOD once it's error is a margin below the
+ * threshold, while it switches to a finer LOD as soon as the current one goes over it. So the selection needs the LOD used in the last frame.
+ */
+class LODSelector final
+{
+public:
+	/**
+	 * Explicit constructor.
+	 *
+	 * @param errorThreshold The largest projected error, in pixels. Default is 1.
+	 * @param hysteresis The fraction of the threshold the error must go below to switch to a coarser LOD. Default is 0.25.
+	 */
+	explicit LODSelector(float errorThreshold = 1.0f, float hysteresis = 0.25f);
+
+	/**
+	 * Set the view the LODs are selected for.
+	 *
+	 * @param cameraPosition The world space camera position.
+	 * @param verticalFieldOfView The vertical field of view of the projection, in radians.
+	 * @param viewportHeight The viewport height in pixels.
+	 */
+	void setView(const std::array<float, 3>& cameraPosition, float verticalFieldOfView, uint32_t viewportHeight);
+
+	/**
+	 * Select the LOD of an object.
+	 *
+	 * @param currentLOD The LOD the object used in the last frame.
+	 * @param boundingSphere The world space bounding sphere center and radius.
+	 * @param lods The object's LODs, from the finest to the coarsest. The errors must be in world space units.
+	 * @return The LOD index.
+	 */
+	[[nodiscard]] uint32_t select(uint32_t currentLOD, const std::array<float, 4>& boundingSphere, std::span<const MeshLOD> lods) const;
+
+	/**
+	 * Cull an object and select it's LOD.
+	 * The LOD is only updated if the object is visible, so it's not reset while the object is outside the view.
+	 *
+	 * @param frustum The view frustum.
+	 * @param boundingSphere The world space bounding sphere center and radius.
+	 * @param lods The object's LODs, from the finest to the coarsest.
+	 * @param lod The LOD the object used in the last frame. This is set to the selected LOD.
+	 * @return True if the object is visible.
+	 */
+	bool cullAndSelect(const Frustum& frustum, const std::array<float, 4>& boundingSphere, std::span<const MeshLOD> lods, uint32_t& lod) const;
+
+	/**
+	 * Cull an object, select it's LOD and compute it's size on the screen.
+	 * The size is what TextureStreamer::reportCoverage() takes for the object's textures, and it's only computed if the object is visible.
+	 *
+	 * @param frustum The view frustum.
+	 * @param boundingSphere The world space bounding sphere center and radius.
+	 * @param lods The object's LODs, from the finest to the coarsest.
+	 * @param lod The LOD the object used in the last frame. This is set to the selected LOD.
+	 * @param screenSize The variable to store the object's size on the screen, in pixels.
+	 * @return True if the object is visible.
+	 */
+	bool cullAndSelect(const Frustum& frustum, const std::array<float, 4>& boundingSphere, std::span<const MeshLOD> lods, uint32_t& lod, float& screenSize) const;
+
+	/**
+	 * Compute the projected error of a LOD.
+	 *
+	 * @param boundingSphere The world space bounding sphere center and radius.
+	 * @param error The LOD error in world space units.
+	 * @return The error in pixels.
+	 */
+	[[nodiscard]] float projectError(const std::array<float, 4>& boundingSphere, float error) const;
+
+	/**
+	 * Compute the size of an object on the screen.
+	 * This is the diameter of the bounding sphere, projected at it's nearest point like the errors.
+	 *
+	 * @param boundingSphere The world space bounding sphere center and radius.
+	 * @return The size in pixels.
+	 */
+	[[nodiscard]] float projectSize(const std::array<float, 4>& boundingSphere) const { return projectError(boundingSphere, boundingSphere[3] * 2.0f); }
+
+public:
+	GRAPHITE_SETUP_SIMPLE_GETTER(float, ErrorThreshold, m_ErrorThreshold);
+	GRAPHITE_SETUP_SIMPLE_GETTER(float, Hysteresis, m_Hysteresis);
+
+private:
+	/**
+	 * Find the coarsest LOD below a threshold.
+	 *
+	 * @param boundingSphere The world space bounding sphere center and radius.
+	 * @param lods The LODs.
+	 * @param threshold The threshold in pixels.
+	 * @return The LOD index.
+	 */
+	[[nodiscard]] uint32_t findCoarsest(const std::array<float, 4>& boundingSphere, std::span<const MeshLOD> lods, float threshold) const;
+
+private:
+	std::array<float, 3> m_CameraPosition = {};
+
+	float m_ErrorThreshold = 1.0f;
+	float m_Hysteresis = 0.25f;
+	float m_ProjectionScale = 1.0f;
+};
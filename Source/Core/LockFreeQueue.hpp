@@ -0,0 +1,147 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+/**
+ * Lock free queue class.
+ * This is a bounded multi-producer, multi-consumer queue. Every slot has a sequence number which tells the producers and consumers whether the slot
+ * is ready to be written or read, so neither side ever takes a lock. This makes it usable as a MPSC or SPMC queue without any changes.
+ *
+ * @tparam Type The value type. This should be cheap to copy.
+ * @tparam Capacity The maximum number of values the queue can hold. Must be a power of two.
+ */
+template<class Type, uint64_t Capacity>
+class LockFreeQueue final
+{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "The capacity of the queue must be a power of two!");
+
+	/**
+	 * Cell structure.
+	 * This contains a single value and it's sequence number.
+	 */
+	struct Cell final
+	{
+		std::atomic_uint64_t m_Sequence = 0;
+		Type m_Value = {};
+	};
+
+public:
+	/**
+	 * Default constructor.
+	 */
+	LockFreeQueue() : m_pCells(std::make_unique<Cell[]>(Capacity))
+	{
+		for (uint64_t i = 0; i < Capacity; i++)
+			m_pCells[i].m_Sequence.store(i, std::memory_order_relaxed);
+	}
+
+	/**
+	 * Try and push a value to the queue.
+	 *
+	 * @param value The value to push.
+	 * @return False if the queue is full.
+	 */
+	[[nodiscard]] bool tryPush(const Type& value)
+	{
+		uint64_t position = m_EnqueuePosition.load(std::memory_order_relaxed);
+		while (true)
+		{
+			auto& cell = m_pCells[position & (Capacity - 1)];
+			const auto sequence = cell.m_Sequence.load(std::memory_order_acquire);
+			const auto difference = static_cast<int64_t>(sequence) - static_cast<int64_t>(position);
+
+			// The slot is free, try and claim it.
+			if (difference == 0)
+			{
+				if (m_EnqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					cell.m_Value = value;
+					cell.m_Sequence.store(position + 1, std::memory_order_release);
+					return true;
+				}
+			}
+
+			// The slot is still occupied by a value which was not consumed, so the queue is full.
+			else if (difference < 0)
+			{
+				return false;
+			}
+
+			// Another producer claimed the slot.
+			else
+			{
+				position = m_EnqueuePosition.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	/**
+	 * Try and pop a value from the queue.
+	 *
+	 * @param value The variable to store the popped value.
+	 * @return False if the queue is empty.
+	 */
+	[[nodiscard]] bool tryPop(Type& value)
+	{
+		uint64_t position = m_DequeuePosition.load(std::memory_order_relaxed);
+		while (true)
+		{
+			auto& cell = m_pCells[position & (Capacity - 1)];
+			const auto sequence = cell.m_Sequence.load(std::memory_order_acquire);
+			const auto difference = static_cast<int64_t>(sequence) - static_cast<int64_t>(position + 1);
+
+			// The slot contains a value, try and claim it.
+			if (difference == 0)
+			{
+				if (m_DequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					value = cell.m_Value;
+					cell.m_Sequence.store(position + Capacity, std::memory_order_release);
+					return true;
+				}
+			}
+
+			// The slot was not written yet, so the queue is empty.
+			else if (difference < 0)
+			{
+				return false;
+			}
+
+			// Another consumer claimed the slot.
+			else
+			{
+				position = m_DequeuePosition.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	/**
+	 * Get the approximate number of values in the queue.
+	 * This is only a hint since other threads might be pushing or popping at the same time.
+	 *
+	 * @return The value count.
+	 */
+	[[nodiscard]] uint64_t getApproximateSize() const
+	{
+		const auto enqueuePosition = m_EnqueuePosition.load(std::memory_order_relaxed);
+		const auto dequeuePosition = m_DequeuePosition.load(std::memory_order_relaxed);
+		return enqueuePosition > dequeuePosition ? enqueuePosition - dequeuePosition : 0;
+	}
+
+	/**
+	 * Get the capacity of the queue.
+	 *
+	 * @return The capacity.
+	 */
+	[[nodiscard]] static constexpr uint64_t GetCapacity() { return Capacity; }
+
+private:
+	std::unique_ptr<Cell[]> m_pCells;
+
+	alignas(64) std::atomic_uint64_t m_EnqueuePosition = 0;
+	alignas(64) std::atomic_uint64_t m_DequeuePosition = 0;
+};
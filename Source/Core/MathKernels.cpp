@@ -0,0 +1,609 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "MathKernels.hpp"
+
+#include <atomic>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#	define GRAPHITE_MATH_X86
+#	include <immintrin.h>
+
+#	if defined(_MSC_VER) && !defined(__clang__)
+#		include <intrin.h>
+
+// MSVC lets any function use the intrinsics, so nothing has to be marked.
+#		define GRAPHITE_MATH_TARGET(isa)
+
+#	else
+// GCC and Clang only allow the intrinsics in functions compiled for their ISA, so the vector kernels are marked instead of building the whole
+// engine for a newer CPU.
+#		define GRAPHITE_MATH_TARGET(isa)	__attribute__((target(isa)))
+
+#	endif
+#endif
+
+namespace /* anonymous */
+{
+	/**
+	 * Kernel table structure.
+	 * Every kernel processes the elements in the range [begin, end) of it's streams.
+	 */
+	struct KernelTable final
+	{
+		void (*m_MultiplyMatrices)(const ConstMatrixStream&, const ConstMatrixStream&, const MatrixStream&, size_t, size_t) = nullptr;
+		void (*m_TransformAABBs)(const ConstMatrixStream&, const ConstAABBStream&, const AABBStream&, size_t, size_t) = nullptr;
+		void (*m_NormalizeQuaternions)(const QuaternionStream&, size_t, size_t) = nullptr;
+		void (*m_TransformPoints)(const std::array<float, 16>&, const ConstPointStream&, const Vector4Stream&, size_t, size_t) = nullptr;
+	};
+
+	/**
+	 * Multiply matrices.
+	 *
+	 * @param lhs The left hand side matrices.
+	 * @param rhs The right hand side matrices.
+	 * @param result The result matrices.
+	 * @param begin The first element.
+	 * @param end The element after the last one.
+	 */
+	void MultiplyMatricesScalar(const ConstMatrixStream& lhs, const ConstMatrixStream& rhs, const MatrixStream& result, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			// Everything is loaded first, so the result can be one of the inputs.
+			std::array<float, 16> a = {};
+			std::array<float, 16> b = {};
+			for (size_t e = 0; e < 16; e++)
+			{
+				a[e] = lhs[e][i];
+				b[e] = rhs[e][i];
+			}
+
+			for (size_t column = 0; column < 4; column++)
+			{
+				for (size_t row = 0; row < 4; row++)
+					result[column * 4 + row][i] = a[row] * b[column * 4] + a[4 + row] * b[column * 4 + 1] + a[8 + row] * b[column * 4 + 2] + a[12 + row] * b[column * 4 + 3];
+			}
+		}
+	}
+
+	/**
+	 * Transform axis aligned bounding boxes.
+	 * The box is transformed as a center and an extent. The new extent is the old one transformed by the absolute of the matrix, which is the
+	 * extent of the box around the eight transformed corners.
+	 *
+	 * @param matrices The transform of each box.
+	 * @param boxes The boxes.
+	 * @param result The transformed boxes.
+	 * @param begin The first element.
+	 * @param end The element after the last one.
+	 */
+	void TransformAABBsScalar(const ConstMatrixStream& matrices, const ConstAABBStream& boxes, const AABBStream& result, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			std::array<float, 3> center = {};
+			std::array<float, 3> extent = {};
+			for (size_t axis = 0; axis < 3; axis++)
+			{
+				center[axis] = (boxes[axis][i] + boxes[3 + axis][i]) * 0.5f;
+				extent[axis] = (boxes[3 + axis][i] - boxes[axis][i]) * 0.5f;
+			}
+
+			for (size_t row = 0; row < 3; row++)
+			{
+				const auto newCenter = matrices[row][i] * center[0] + matrices[4 + row][i] * center[1] + matrices[8 + row][i] * center[2] + matrices[12 + row][i];
+				const auto newExtent = std::abs(matrices[row][i]) * extent[0] + std::abs(matrices[4 + row][i]) * extent[1] + std::abs(matrices[8 + row][i]) * extent[2];
+
+				result[row][i] = newCenter - newExtent;
+				result[3 + row][i] = newCenter + newExtent;
+			}
+		}
+	}
+
+	/**
+	 * Normalize quaternions.
+	 *
+	 * @param quaternions The quaternions.
+	 * @param begin The first element.
+	 * @param end The element after the last one.
+	 */
+	void NormalizeQuaternionsScalar(const QuaternionStream& quaternions, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			const auto x = quaternions[0][i];
+			const auto y = quaternions[1][i];
+			const auto z = quaternions[2][i];
+			const auto w = quaternions[3][i];
+
+			const auto length = std::sqrt(x * x + y * y + z * z + w * w);
+			if (length <= 0.0f)
+			{
+				quaternions[0][i] = 0.0f;
+				quaternions[1][i] = 0.0f;
+				quaternions[2][i] = 0.0f;
+				quaternions[3][i] = 1.0f;
+				continue;
+			}
+
+			const auto inverseLength = 1.0f / length;
+			quaternions[0][i] = x * inverseLength;
+			quaternions[1][i] = y * inverseLength;
+			quaternions[2][i] = z * inverseLength;
+			quaternions[3][i] = w * inverseLength;
+		}
+	}
+
+	/**
+	 * Transform points by a single matrix.
+	 *
+	 * @param matrix The matrix.
+	 * @param points The points.
+	 * @param result The transformed points.
+	 * @param begin The first element.
+	 * @param end The element after the last one.
+	 */
+	void TransformPointsScalar(const std::array<float, 16>& matrix, const ConstPointStream& points, const Vector4Stream& result, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			const auto x = points[0][i];
+			const auto y = points[1][i];
+			const auto z = points[2][i];
+
+			for (size_t row = 0; row < 4; row++)
+				result[row][i] = matrix[row] * x + matrix[4 + row] * y + matrix[8 + row] * z + matrix[12 + row];
+		}
+	}
+
+#ifdef GRAPHITE_MATH_X86
+	/**
+	 * Multiply matrices using SSE4.1.
+	 *
+	 * @param lhs The left hand side matrices.
+	 * @param rhs The right hand side matrices.
+	 * @param result The result matrices.
+	 * @param begin The first element.
+	 * @param end The element after the last one.
+	 */
+	GRAPHITE_MATH_TARGET("sse4.1") void MultiplyMatricesSSE41(const ConstMatrixStream& lhs, const ConstMatrixStream& rhs, const MatrixStream& result, size_t begin, size_t end)
+	{
+		auto i = begin;
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128 a[16];
+			__m128 b[16];
+			for (size_t e = 0; e < 16; e++)
+			{
+				a[e] = _mm_loadu_ps(lhs[e].data() + i);
+				b[e] = _mm_loadu_ps(rhs[e].data() + i);
+			}
+
+			for (size_t column = 0; column < 4; column++)
+			{
+				for (size_t row = 0; row < 4; row++)
+				{
+					auto value = _mm_mul_ps(a[row], b[column * 4]);
+					value = _mm_add_ps(value, _mm_mul_ps(a[4 + row], b[column * 4 + 1]));
+					value = _mm_add_ps(value, _mm_mul_ps(a[8 + row], b[column * 4 + 2]));
+					value = _mm_add_ps(value, _mm_mul_ps(a[12 + row], b[column * 4 + 3]));
+					_mm_storeu_ps(result[column * 4 + row].data() + i, value);
+				}
+			}
+		}
+
+		MultiplyMatricesScalar(lhs, rhs, result, i, end);
+	}
+
+	/**
+	 * Transform axis aligned bounding boxes using SSE4.1.
+	 *
+	 * @param matrices The transform of each box.
+	 * @param boxes The boxes.
+	 * @param result The transformed boxes.
+	 * @param begin The first element.
+	 * @param end The element after the last one.
+	 */
+	GRAPHITE_MATH_TARGET("sse4.1") void TransformAABBsSSE41(const ConstMatrixStream& matrices, const ConstAABBStream& boxes, const AABBStream& result, size_t begin, size_t end)
+	{
+		const auto half = _mm_set1_ps(0.5f);
+		const auto signMask = _mm_set1_ps(-0.0f);
+
+		auto i = begin;
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128 center[3];
+			__m128 extent[3];
+			for (size_t axis = 0; axis < 3; axis++)
+			{
+				const auto minimum = _mm_loadu_ps(boxes[axis].data() + i);
+				const auto maximum = _mm_loadu_ps(boxes[3 + axis].data() + i);
+				center[axis] = _mm_mul_ps(_mm_add_ps(minimum, maximum), half);
+				extent[axis] = _mm_mul_ps(_mm_sub_ps(maximum, minimum), half);
+			}
+
+			// Every output is computed before the stores, so the result can be the same stream as the boxes.
+			__m128 output[6];
+			for (size_t row = 0; row < 3; row++)
+			{
+				const auto m0 = _mm_loadu_ps(matrices[row].data() + i);
+				const auto m1 = _mm_loadu_ps(matrices[4 + row].data() + i);
+				const auto m2 = _mm_loadu_ps(matrices[8 + row].data() + i);
+				const auto m3 = _mm_loadu_ps(matrices[12 + row].data() + i);
+
+				auto newCenter = _mm_mul_ps(m0, center[0]);
+				newCenter = _mm_add_ps(newCenter, _mm_mul_ps(m1, center[1]));
+				newCenter = _mm_add_ps(newCenter, _mm_mul_ps(m2, center[2]));
+				newCenter = _mm_add_ps(newCenter, m3);
+
+				auto newExtent = _mm_mul_ps(_mm_andnot_ps(signMask, m0), extent[0]);
+				newExtent = _mm_add_ps(newExtent, _mm_mul_ps(_mm_andnot_ps(signMask, m1), extent[1]));
+				newExtent = _mm_add_ps(newExtent, _mm_mul_ps(_mm_andnot_ps(signMask, m2), extent[2]));
+
+				output[row] = _mm_sub_ps(newCenter, newExtent);
+				output[3 + row] = _mm_add_ps(newCenter, newExtent);
+			}
+
+			for (size_t component = 0; component < 6; component++)
+				_mm_storeu_ps(result[component].data() + i, output[component]);
+		}
+
+		TransformAABBsScalar(matrices, boxes, result, i, end);
+	}
+
+	/**
+	 * Normalize quaternions using SSE4.1.
+	 *
+	 * @param quaternions The quaternions.
+	 * @param begin The first element.
+	 * @param end The element after the last one.
+	 */
+	GRAPHITE_MATH_TARGET("sse4.1") void NormalizeQuaternionsSSE41(const QuaternionStream& quaternions, size_t begin, size_t end)
+	{
+		const auto zero = _mm_setzero_ps();
+		const auto one = _mm_set1_ps(1.0f);
+
+		auto i = begin;
+		for (; i + 4 <= end; i += 4)
+		{
+			const auto x = _mm_loadu_ps(quaternions[0].data() + i);
+			const auto y = _mm_loadu_ps(quaternions[1].data() + i);
+			const auto z = _mm_loadu_ps(quaternions[2].data() + i);
+			const auto w = _mm_loadu_ps(quaternions[3].data() + i);
+
+			auto lengthSquared = _mm_mul_ps(x, x);
+			lengthSquared = _mm_add_ps(lengthSquared, _mm_mul_ps(y, y));
+			lengthSquared = _mm_add_ps(lengthSquared, _mm_mul_ps(z, z));
+			lengthSquared = _mm_add_ps(lengthSquared, _mm_mul_ps(w, w));
+
+			// The exact square root and division are used instead of the reciprocal estimate, so the results match the scalar version. The
+			// lanes which are not greater than 0 are replaced by the identity, while NaNs go through like in the scalar version.
+			const auto length = _mm_sqrt_ps(lengthSquared);
+			const auto inverseLength = _mm_div_ps(one, length);
+			const auto isValid = _mm_cmpnle_ps(length, zero);
+
+			_mm_storeu_ps(quaternions[0].data() + i, _mm_blendv_ps(zero, _mm_mul_ps(x, inverseLength), isValid));
+			_mm_storeu_ps(quaternions[1].data() + i, _mm_blendv_ps(zero, _mm_mul_ps(y, inverseLength), isValid));
+			_mm_storeu_ps(quaternions[2].data() + i, _mm_blendv_ps(zero, _mm_mul_ps(z, inverseLength), isValid));
+			_mm_storeu_ps(quaternions[3].data() + i, _mm_blendv_ps(one, _mm_mul_ps(w, inverseLength), isValid));
+		}
+
+		NormalizeQuaternionsScalar(quaternions, i, end);
+	}
+
+	/**
+	 * Transform points by a single matrix using SSE4.1.
+	 *
+	 * @param matrix The matrix.
+	 * @param points The points.
+	 * @param result The transformed points.
+	 * @param begin The first element.
+	 * @param end The element after the last one.
+	 */
+	GRAPHITE_MATH_TARGET("sse4.1") void TransformPointsSSE41(const std::array<float, 16>& matrix, const ConstPointStream& points, const Vector4Stream& result, size_t begin, size_t end)
+	{
+		__m128 m[16];
+		for (size_t e = 0; e < 16; e++)
+			m[e] = _mm_set1_ps(matrix[e]);
+
+		auto i = begin;
+		for (; i + 4 <= end; i += 4)
+		{
+			const auto x = _mm_loadu_ps(points[0].data() + i);
+			const auto y = _mm_loadu_ps(points[1].data() + i);
+			const auto z = _mm_loadu_ps(points[2].data() + i);
+
+			for (size_t row = 0; row < 4; row++)
+			{
+				auto value = _mm_mul_ps(m[row], x);
+				value = _mm_add_ps(value, _mm_mul_ps(m[4 + row], y));
+				value = _mm_add_ps(value, _mm_mul_ps(m[8 + row], z));
+				value = _mm_add_ps(value, m[12 + row]);
+				_mm_storeu_ps(result[row].data() + i, value);
+			}
+		}
+
+		TransformPointsScalar(matrix, points, result, i, end);
+	}
+
+	/**
+	 * Multiply matrices using AVX2.
+	 *
+	 * @param lhs The left hand side matrices.
+	 * @param rhs The right hand side matrices.
+	 * @param result The result matrices.
+	 * @param begin The first element.
+	 * @param end The element after the last one.
+	 */
+	GRAPHITE_MATH_TARGET("avx2,fma") void MultiplyMatricesAVX2(const ConstMatrixStream& lhs, const ConstMatrixStream& rhs, const MatrixStream& result, size_t begin, size_t end)
+	{
+		auto i = begin;
+		for (; i + 8 <= end; i += 8)
+		{
+			__m256 a[16];
+			__m256 b[16];
+			for (size_t e = 0; e < 16; e++)
+			{
+				a[e] = _mm256_loadu_ps(lhs[e].data() + i);
+				b[e] = _mm256_loadu_ps(rhs[e].data() + i);
+			}
+
+			for (size_t column = 0; column < 4; column++)
+			{
+				for (size_t row = 0; row < 4; row++)
+				{
+					auto value = _mm256_mul_ps(a[row], b[column * 4]);
+					value = _mm256_fmadd_ps(a[4 + row], b[column * 4 + 1], value);
+					value = _mm256_fmadd_ps(a[8 + row], b[column * 4 + 2], value);
+					value = _mm256_fmadd_ps(a[12 + row], b[column * 4 + 3], value);
+					_mm256_storeu_ps(result[column * 4 + row].data() + i, value);
+				}
+			}
+		}
+
+		MultiplyMatricesSSE41(lhs, rhs, result, i, end);
+	}
+
+	/**
+	 * Transform axis aligned bounding boxes using AVX2.
+	 *
+	 * @param matrices The transform of each box.
+	 * @param boxes The boxes.
+	 * @param result The transformed boxes.
+	 * @param begin The first element.
+	 * @param end The element after the last one.
+	 */
+	GRAPHITE_MATH_TARGET("avx2,fma") void TransformAABBsAVX2(const ConstMatrixStream& matrices, const ConstAABBStream& boxes, const AABBStream& result, size_t begin, size_t end)
+	{
+		const auto half = _mm256_set1_ps(0.5f);
+		const auto signMask = _mm256_set1_ps(-0.0f);
+
+		auto i = begin;
+		for (; i + 8 <= end; i += 8)
+		{
+			__m256 center[3];
+			__m256 extent[3];
+			for (size_t axis = 0; axis < 3; axis++)
+			{
+				const auto minimum = _mm256_loadu_ps(boxes[axis].data() + i);
+				const auto maximum = _mm256_loadu_ps(boxes[3 + axis].data() + i);
+				center[axis] = _mm256_mul_ps(_mm256_add_ps(minimum, maximum), half);
+				extent[axis] = _mm256_mul_ps(_mm256_sub_ps(maximum, minimum), half);
+			}
+
+			__m256 output[6];
+			for (size_t row = 0; row < 3; row++)
+			{
+				const auto m0 = _mm256_loadu_ps(matrices[row].data() + i);
+				const auto m1 = _mm256_loadu_ps(matrices[4 + row].data() + i);
+				const auto m2 = _mm256_loadu_ps(matrices[8 + row].data() + i);
+				const auto m3 = _mm256_loadu_ps(matrices[12 + row].data() + i);
+
+				auto newCenter = _mm256_fmadd_ps(m0, center[0], m3);
+				newCenter = _mm256_fmadd_ps(m1, center[1], newCenter);
+				newCenter = _mm256_fmadd_ps(m2, center[2], newCenter);
+
+				auto newExtent = _mm256_mul_ps(_mm256_andnot_ps(signMask, m0), extent[0]);
+				newExtent = _mm256_fmadd_ps(_mm256_andnot_ps(signMask, m1), extent[1], newExtent);
+				newExtent = _mm256_fmadd_ps(_mm256_andnot_ps(signMask, m2), extent[2], newExtent);
+
+				output[row] = _mm256_sub_ps(newCenter, newExtent);
+				output[3 + row] = _mm256_add_ps(newCenter, newExtent);
+			}
+
+			for (size_t component = 0; component < 6; component++)
+				_mm256_storeu_ps(result[component].data() + i, output[component]);
+		}
+
+		TransformAABBsSSE41(matrices, boxes, result, i, end);
+	}
+
+	/**
+	 * Normalize quaternions using AVX2.
+	 *
+	 * @param quaternions The quaternions.
+	 * @param begin The first element.
+	 * @param end The element after the last one.
+	 */
+	GRAPHITE_MATH_TARGET("avx2,fma") void NormalizeQuaternionsAVX2(const QuaternionStream& quaternions, size_t begin, size_t end)
+	{
+		const auto zero = _mm256_setzero_ps();
+		const auto one = _mm256_set1_ps(1.0f);
+
+		auto i = begin;
+		for (; i + 8 <= end; i += 8)
+		{
+			const auto x = _mm256_loadu_ps(quaternions[0].data() + i);
+			const auto y = _mm256_loadu_ps(quaternions[1].data() + i);
+			const auto z = _mm256_loadu_ps(quaternions[2].data() + i);
+			const auto w = _mm256_loadu_ps(quaternions[3].data() + i);
+
+			auto lengthSquared = _mm256_mul_ps(x, x);
+			lengthSquared = _mm256_fmadd_ps(y, y, lengthSquared);
+			lengthSquared = _mm256_fmadd_ps(z, z, lengthSquared);
+			lengthSquared = _mm256_fmadd_ps(w, w, lengthSquared);
+
+			const auto length = _mm256_sqrt_ps(lengthSquared);
+			const auto inverseLength = _mm256_div_ps(one, length);
+			const auto isValid = _mm256_cmp_ps(length, zero, _CMP_NLE_UQ);
+
+			_mm256_storeu_ps(quaternions[0].data() + i, _mm256_blendv_ps(zero, _mm256_mul_ps(x, inverseLength), isValid));
+			_mm256_storeu_ps(quaternions[1].data() + i, _mm256_blendv_ps(zero, _mm256_mul_ps(y, inverseLength), isValid));
+			_mm256_storeu_ps(quaternions[2].data() + i, _mm256_blendv_ps(zero, _mm256_mul_ps(z, inverseLength), isValid));
+			_mm256_storeu_ps(quaternions[3].data() + i, _mm256_blendv_ps(one, _mm256_mul_ps(w, inverseLength), isValid));
+		}
+
+		NormalizeQuaternionsSSE41(quaternions, i, end);
+	}
+
+	/**
+	 * Transform points by a single matrix using AVX2.
+	 *
+	 * @param matrix The matrix.
+	 * @param points The points.
+	 * @param result The transformed points.
+	 * @param begin The first element.
+	 * @param end The element after the last one.
+	 */
+	GRAPHITE_MATH_TARGET("avx2,fma") void TransformPointsAVX2(const std::array<float, 16>& matrix, const ConstPointStream& points, const Vector4Stream& result, size_t begin, size_t end)
+	{
+		__m256 m[16];
+		for (size_t e = 0; e < 16; e++)
+			m[e] = _mm256_set1_ps(matrix[e]);
+
+		auto i = begin;
+		for (; i + 8 <= end; i += 8)
+		{
+			const auto x = _mm256_loadu_ps(points[0].data() + i);
+			const auto y = _mm256_loadu_ps(points[1].data() + i);
+			const auto z = _mm256_loadu_ps(points[2].data() + i);
+
+			for (size_t row = 0; row < 4; row++)
+			{
+				auto value = _mm256_fmadd_ps(m[row], x, m[12 + row]);
+				value = _mm256_fmadd_ps(m[4 + row], y, value);
+				value = _mm256_fmadd_ps(m[8 + row], z, value);
+				_mm256_storeu_ps(result[row].data() + i, value);
+			}
+		}
+
+		TransformPointsSSE41(matrix, points, result, i, end);
+	}
+
+	constexpr std::array<KernelTable, static_cast<uint8_t>(MathISA::Count)> g_KernelTables = {
+		KernelTable{ MultiplyMatricesScalar, TransformAABBsScalar, NormalizeQuaternionsScalar, TransformPointsScalar },
+		KernelTable{ MultiplyMatricesSSE41, TransformAABBsSSE41, NormalizeQuaternionsSSE41, TransformPointsSSE41 },
+		KernelTable{ MultiplyMatricesAVX2, TransformAABBsAVX2, NormalizeQuaternionsAVX2, TransformPointsAVX2 }
+	};
+
+#else
+	// Only the scalar kernels exist on the other architectures, and DetectISA() never selects the others.
+	constexpr std::array<KernelTable, static_cast<uint8_t>(MathISA::Count)> g_KernelTables = {
+		KernelTable{ MultiplyMatricesScalar, TransformAABBsScalar, NormalizeQuaternionsScalar, TransformPointsScalar },
+		KernelTable{ MultiplyMatricesScalar, TransformAABBsScalar, NormalizeQuaternionsScalar, TransformPointsScalar },
+		KernelTable{ MultiplyMatricesScalar, TransformAABBsScalar, NormalizeQuaternionsScalar, TransformPointsScalar }
+	};
+
+#endif
+
+	/**
+	 * Detect the best ISA the CPU supports.
+	 * AVX2 is only used together with FMA, which every CPU with AVX2 has in practice.
+	 *
+	 * @return The ISA.
+	 */
+	[[nodiscard]] MathISA DetectISA()
+	{
+#ifdef GRAPHITE_MATH_X86
+#	if defined(_MSC_VER) && !defined(__clang__)
+		std::array<int, 4> information = {};
+		__cpuid(information.data(), 0);
+		const auto highestLeaf = information[0];
+
+		__cpuid(information.data(), 1);
+		const bool bHasSSE41 = (information[2] & (1 << 19)) != 0;
+		const bool bHasFMA = (information[2] & (1 << 12)) != 0;
+
+		// The OS must save the AVX registers as well, which is checked through XGETBV.
+		const bool bHasAVXState = (information[2] & (1 << 27)) != 0 && (information[2] & (1 << 28)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+
+		bool bHasAVX2 = false;
+		if (highestLeaf >= 7)
+		{
+			__cpuidex(information.data(), 7, 0);
+			bHasAVX2 = (information[1] & (1 << 5)) != 0;
+		}
+
+		if (bHasAVXState && bHasAVX2 && bHasFMA)
+			return MathISA::AVX2;
+
+		if (bHasSSE41)
+			return MathISA::SSE41;
+
+#	else
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+			return MathISA::AVX2;
+
+		if (__builtin_cpu_supports("sse4.1"))
+			return MathISA::SSE41;
+
+#	endif
+#endif
+
+		return MathISA::Scalar;
+	}
+
+	/**
+	 * Get the active kernel table.
+	 * The first call detects the ISA.
+	 *
+	 * @return The table pointer reference.
+	 */
+	[[nodiscard]] std::atomic<const KernelTable*>& GetKernelTable()
+	{
+		static std::atomic<const KernelTable*> pTable = &g_KernelTables[static_cast<uint8_t>(MathKernels::GetSupportedISA())];
+		return pTable;
+	}
+}
+
+MathISA MathKernels::GetSupportedISA()
+{
+	static const auto isa = DetectISA();
+	return isa;
+}
+
+MathISA MathKernels::GetISA()
+{
+	return static_cast<MathISA>(GetKernelTable().load(std::memory_order_relaxed) - g_KernelTables.data());
+}
+
+bool MathKernels::SetISA(MathISA isa)
+{
+	if (isa >= MathISA::Count || isa > GetSupportedISA())
+		return false;
+
+	GetKernelTable().store(&g_KernelTables[static_cast<uint8_t>(isa)], std::memory_order_relaxed);
+	return true;
+}
+
+void MathKernels::MultiplyMatrices(ConstMatrixStream lhs, ConstMatrixStream rhs, MatrixStream result)
+{
+	GetKernelTable().load(std::memory_order_relaxed)->m_MultiplyMatrices(lhs, rhs, result, 0, result.size());
+}
+
+void MathKernels::TransformAABBs(ConstMatrixStream matrices, ConstAABBStream boxes, AABBStream result)
+{
+	GetKernelTable().load(std::memory_order_relaxed)->m_TransformAABBs(matrices, boxes, result, 0, result.size());
+}
+
+void MathKernels::NormalizeQuaternions(QuaternionStream quaternions)
+{
+	GetKernelTable().load(std::memory_order_relaxed)->m_NormalizeQuaternions(quaternions, 0, quaternions.size());
+}
+
+void MathKernels::TransformPoints(const std::array<float, 16>& matrix, ConstPointStream points, Vector4Stream result)
+{
+	GetKernelTable().load(std::memory_order_relaxed)->m_TransformPoints(matrix, points, result, 0, result.size());
+}
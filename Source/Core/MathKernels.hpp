@@ -0,0 +1,244 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "Common.hpp"
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+/**
+ * Math ISA enum.
+ * This specifies the instruction set the math kernels run with. A later entry is always a superset of the earlier ones.
+ */
+enum class MathISA : uint8_t
+{
+	Scalar,
+	SSE41,
+	AVX2,
+
+	Count
+};
+
+/**
+ * Get the name of a math ISA.
+ *
+ * @param isa The ISA.
+ * @return The name.
+ */
+[[nodiscard]] constexpr std::string_view GetMathISAName(MathISA isa)
+{
+	constexpr std::array<std::string_view, static_cast<uint8_t>(MathISA::Count)> names = { "scalar", "sse4.1", "avx2" };
+	return names[static_cast<uint8_t>(isa)];
+}
+
+/**
+ * Structure of arrays stream.
+ * This is a view of a number of elements where each component is stored in it's own array, so a kernel can load the same component of many
+ * elements at once. Every component span must have the same size.
+ *
+ * @tparam Type The component type. This is const for the input streams.
+ * @tparam Components The number of components of an element.
+ */
+template<class Type, size_t Components>
+struct SoAStream final
+{
+	std::array<std::span<Type>, Components> m_Components = {};
+
+	/**
+	 * Default constructor.
+	 */
+	SoAStream() = default;
+
+	/**
+	 * Explicit constructor.
+	 *
+	 * @param components The component spans.
+	 */
+	explicit SoAStream(const std::array<std::span<Type>, Components>& components) : m_Components(components) {}
+
+	/**
+	 * Constructor.
+	 * This lets a mutable stream be passed where a const one is expected.
+	 *
+	 * @tparam Other The other component type.
+	 * @param other The other stream.
+	 */
+	template<class Other>
+	SoAStream(const SoAStream<Other, Components>& other)
+	{
+		for (size_t i = 0; i < Components; i++)
+			m_Components[i] = other.m_Components[i];
+	}
+
+	/**
+	 * Get the number of elements.
+	 *
+	 * @return The element count.
+	 */
+	[[nodiscard]] size_t size() const { return m_Components[0].size(); }
+
+	/**
+	 * Get a component span.
+	 *
+	 * @param index The component index.
+	 * @return The span.
+	 */
+	[[nodiscard]] std::span<Type> operator[](size_t index) const { return m_Components[index]; }
+};
+
+// Matrices are 4x4 and column major, so the component 4 * column + row is an element of the matrix.
+using MatrixStream = SoAStream<float, 16>;
+using ConstMatrixStream = SoAStream<const float, 16>;
+
+// Bounding boxes are stored as the minimum x, y, z and the maximum x, y, z.
+using AABBStream = SoAStream<float, 6>;
+using ConstAABBStream = SoAStream<const float, 6>;
+
+// Quaternions are stored as x, y, z, w.
+using QuaternionStream = SoAStream<float, 4>;
+
+using PointStream = SoAStream<float, 3>;
+using ConstPointStream = SoAStream<const float, 3>;
+using Vector4Stream = SoAStream<float, 4>;
+
+/**
+ * Structure of arrays buffer.
+ * This owns the memory of a stream. The components are stored one after the other in a single allocation.
+ *
+ * @tparam Components The number of components of an element.
+ */
+template<size_t Components>
+class SoABuffer final
+{
+public:
+	/**
+	 * Explicit constructor.
+	 *
+	 * @param count The number of elements.
+	 */
+	explicit SoABuffer(size_t count = 0) { resize(count); }
+
+	/**
+	 * Resize the buffer.
+	 * The contents are not kept.
+	 *
+	 * @param count The number of elements.
+	 */
+	void resize(size_t count)
+	{
+		m_Data.assign(count * Components, 0.0f);
+		m_Count = count;
+	}
+
+	/**
+	 * Get the stream of the buffer.
+	 *
+	 * @return The stream.
+	 */
+	[[nodiscard]] SoAStream<float, Components> getStream()
+	{
+		SoAStream<float, Components> stream;
+		for (size_t i = 0; i < Components; i++)
+			stream.m_Components[i] = std::span(m_Data).subspan(i * m_Count, m_Count);
+
+		return stream;
+	}
+
+	/**
+	 * Get the const stream of the buffer.
+	 *
+	 * @return The stream.
+	 */
+	[[nodiscard]] SoAStream<const float, Components> getStream() const
+	{
+		SoAStream<const float, Components> stream;
+		for (size_t i = 0; i < Components; i++)
+			stream.m_Components[i] = std::span(m_Data).subspan(i * m_Count, m_Count);
+
+		return stream;
+	}
+
+public:
+	GRAPHITE_SETUP_SIMPLE_GETTER(size_t, Count, m_Count);
+
+private:
+	std::vector<float> m_Data;
+	size_t m_Count = 0;
+};
+
+/**
+ * Math kernels class.
+ * These run the same operation over many elements stored as structures of arrays, which is what the hot loops like the world matrix composition,
+ * the skinning palettes and the bounds updates need. Each kernel has a scalar, an SSE4.1 and an AVX2 version, and the best one the CPU supports is
+ * selected once, the first time a kernel is called. The scalar versions are the reference the others are checked against.
+ *
+ * The results of the vector versions can differ from the scalar ones in the last bits, since AVX2 uses fused multiply adds.
+ */
+class MathKernels final
+{
+public:
+	/**
+	 * Get the best ISA the CPU supports.
+	 *
+	 * @return The ISA.
+	 */
+	[[nodiscard]] static MathISA GetSupportedISA();
+
+	/**
+	 * Get the ISA the kernels currently run with.
+	 *
+	 * @return The ISA.
+	 */
+	[[nodiscard]] static MathISA GetISA();
+
+	/**
+	 * Set the ISA the kernels run with.
+	 * This is meant for validating and benchmarking the versions against each other. It's not synchronized with the kernel calls.
+	 *
+	 * @param isa The ISA to use.
+	 * @return False if the CPU does not support the ISA, in which case the current one is kept.
+	 */
+	static bool SetISA(MathISA isa);
+
+	/**
+	 * Multiply matrices.
+	 * The result of each element is lhs * rhs.
+	 *
+	 * @param lhs The left hand side matrices.
+	 * @param rhs The right hand side matrices. This must be the same size as lhs.
+	 * @param result The result matrices. This must be the same size as lhs, and it can be the same stream as either input.
+	 */
+	static void MultiplyMatrices(ConstMatrixStream lhs, ConstMatrixStream rhs, MatrixStream result);
+
+	/**
+	 * Transform axis aligned bounding boxes.
+	 * The result is the box which encloses the transformed box. The matrices must be affine.
+	 *
+	 * @param matrices The transform of each box.
+	 * @param boxes The boxes. This must be the same size as the matrices.
+	 * @param result The transformed boxes. This must be the same size as the matrices, and it can be the same stream as the boxes.
+	 */
+	static void TransformAABBs(ConstMatrixStream matrices, ConstAABBStream boxes, AABBStream result);
+
+	/**
+	 * Normalize quaternions in place.
+	 * Quaternions with a length of 0 are set to the identity.
+	 *
+	 * @param quaternions The quaternions.
+	 */
+	static void NormalizeQuaternions(QuaternionStream quaternions);
+
+	/**
+	 * Transform points by a single matrix.
+	 * The points are treated as having a w of 1, so with a view projection matrix the result is the clip space positions.
+	 *
+	 * @param matrix The matrix, column major.
+	 * @param points The points.
+	 * @param result The transformed points. This must be the same size as the points.
+	 */
+	static void TransformPoints(const std::array<float, 16>& matrix, ConstPointStream points, Vector4Stream result);
+};
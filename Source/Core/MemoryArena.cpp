@@ -0,0 +1,103 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "MemoryArena.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace /* anonymous */
+{
+	// The initial size of each thread's scratch arena. It grows on it's own if a thread needs more.
+	constexpr size_t g_ScratchCapacity = 64 * 1024;
+
+	// The alignment of the arena blocks, which is the largest alignment an allocation gets without padding.
+	constexpr size_t g_BlockAlignment = alignof(std::max_align_t);
+}
+
+MemoryArena::MemoryArena(size_t capacity, std::pmr::memory_resource* pUpstream /*= std::pmr::new_delete_resource()*/)
+	: m_pUpstream(pUpstream)
+	, m_Capacity(capacity)
+{
+	if (m_Capacity > 0)
+		m_pBlock = static_cast<std::byte*>(m_pUpstream->allocate(m_Capacity, g_BlockAlignment));
+}
+
+MemoryArena::~MemoryArena()
+{
+	reset();
+
+	if (m_pBlock != nullptr)
+		m_pUpstream->deallocate(m_pBlock, m_Capacity, g_BlockAlignment);
+}
+
+void MemoryArena::rewind(const Marker& marker)
+{
+	for (auto i = marker.m_OverflowCount; i < m_Overflows.size(); i++)
+	{
+		const auto& overflow = m_Overflows[i];
+		m_pUpstream->deallocate(overflow.m_pData, overflow.m_Size, overflow.m_Alignment);
+		m_OverflowSize -= overflow.m_Size;
+	}
+
+	m_Overflows.resize(std::min(marker.m_OverflowCount, m_Overflows.size()));
+
+	// The offset can be below the marker if the latest allocation before it was given back.
+	m_Offset = std::min(marker.m_Offset, m_Offset);
+
+	// Grow the block once everything is freed, so the next time the same allocations fit in it.
+	if (m_Offset > 0 || !m_Overflows.empty())
+		return;
+
+	if (m_PeakSinceReset > m_Capacity)
+	{
+		if (m_pBlock != nullptr)
+			m_pUpstream->deallocate(m_pBlock, m_Capacity, g_BlockAlignment);
+
+		m_Capacity = std::bit_ceil(m_PeakSinceReset);
+		m_pBlock = static_cast<std::byte*>(m_pUpstream->allocate(m_Capacity, g_BlockAlignment));
+	}
+
+	m_PeakSinceReset = 0;
+}
+
+void* MemoryArena::do_allocate(size_t size, size_t alignment)
+{
+	m_AllocationCount++;
+
+	// The block is only aligned to the block alignment, so the padding depends on the address and not just the offset.
+	void* pData = nullptr;
+	const auto address = m_pBlock != nullptr ? reinterpret_cast<uintptr_t>(m_pBlock + m_Offset) : 0;
+	const auto padding = static_cast<size_t>((alignment - (address & (alignment - 1))) & (alignment - 1));
+	if (m_pBlock != nullptr && padding <= m_Capacity - m_Offset && size <= m_Capacity - m_Offset - padding)
+	{
+		pData = m_pBlock + m_Offset + padding;
+		m_Offset += padding + size;
+	}
+	else
+	{
+		pData = m_pUpstream->allocate(size, alignment);
+		m_Overflows.emplace_back(Overflow{ pData, size, alignment });
+		m_OverflowSize += size;
+		m_TotalOverflowCount++;
+	}
+
+	// The overflows might need padding once they're in the block, so the alignment is counted as well.
+	const auto usedSize = m_Offset + m_OverflowSize + (m_Overflows.empty() ? 0 : alignment);
+	m_PeakSinceReset = std::max(m_PeakSinceReset, usedSize);
+	m_PeakSize = std::max(m_PeakSize, usedSize);
+
+	return pData;
+}
+
+void MemoryArena::do_deallocate(void* pData, size_t size, [[maybe_unused]] size_t alignment)
+{
+	const auto pBytes = static_cast<std::byte*>(pData);
+	if (m_pBlock != nullptr && pBytes >= m_pBlock && pBytes + size == m_pBlock + m_Offset)
+		m_Offset = static_cast<size_t>(pBytes - m_pBlock);
+}
+
+MemoryArena& GetScratchArena()
+{
+	thread_local MemoryArena t_ScratchArena(g_ScratchCapacity);
+	return t_ScratchArena;
+}
@@ -0,0 +1,181 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "Common.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+/**
+ * Memory arena class.
+ * This is a linear allocator which hands out memory from a single block by bumping an offset. Deallocating does nothing, except for the latest
+ * allocation which is given back, so a growing container does not waste the block. Everything is freed at once by rewinding to a marker or resetting.
+ *
+ * When the block is full the allocations go to the upstream resource and are counted as overflows. The next time the arena is reset the block is
+ * grown to fit everything, so an arena only allocates from the upstream till it has seen it's peak usage once.
+ *
+ * The arena is a memory resource, so the standard containers can use it through std::pmr. It's not thread safe.
+ */
+class MemoryArena final : public std::pmr::memory_resource
+{
+	/**
+	 * Overflow allocation structure.
+	 */
+	struct Overflow final
+	{
+		void* m_pData = nullptr;
+		size_t m_Size = 0;
+		size_t m_Alignment = 0;
+	};
+
+public:
+	/**
+	 * Marker structure.
+	 * This is a position of the arena which can be rewound to.
+	 */
+	struct Marker final
+	{
+		size_t m_Offset = 0;
+		size_t m_OverflowCount = 0;
+	};
+
+public:
+	/**
+	 * Explicit constructor.
+	 *
+	 * @param capacity The initial size of the block in bytes.
+	 * @param pUpstream The resource to allocate the block and the overflows from. Default is the new and delete resource.
+	 */
+	explicit MemoryArena(size_t capacity, std::pmr::memory_resource* pUpstream = std::pmr::new_delete_resource());
+
+	/**
+	 * Destructor.
+	 */
+	~MemoryArena() override;
+
+	GRAPHITE_DISABLE_COPY_AND_MOVE(MemoryArena);
+
+	/**
+	 * Get the current position of the arena.
+	 *
+	 * @return The marker.
+	 */
+	[[nodiscard]] Marker getMarker() const { return Marker{ m_Offset, m_Overflows.size() }; }
+
+	/**
+	 * Free everything allocated after a marker.
+	 * The markers must be rewound in the reverse order they were taken.
+	 *
+	 * @param marker The marker to rewind to.
+	 */
+	void rewind(const Marker& marker);
+
+	/**
+	 * Free everything.
+	 * This grows the block if the allocations since the last reset did not fit in it.
+	 */
+	void reset() { rewind(Marker()); }
+
+public:
+	GRAPHITE_SETUP_SIMPLE_GETTER(size_t, Capacity, m_Capacity);
+	GRAPHITE_SETUP_SIMPLE_GETTER(size_t, UsedSize, m_Offset + m_OverflowSize);
+	GRAPHITE_SETUP_SIMPLE_GETTER(size_t, PeakSize, m_PeakSize);
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint64_t, AllocationCount, m_AllocationCount);
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint64_t, OverflowCount, m_TotalOverflowCount);
+
+private:
+	/**
+	 * Allocate memory.
+	 *
+	 * @param size The size in bytes.
+	 * @param alignment The alignment.
+	 * @return The memory pointer.
+	 */
+	void* do_allocate(size_t size, size_t alignment) override;
+
+	/**
+	 * Deallocate memory.
+	 * Only the latest allocation is given back, everything else waits for the rewind.
+	 *
+	 * @param pData The memory pointer.
+	 * @param size The size in bytes.
+	 * @param alignment The alignment.
+	 */
+	void do_deallocate(void* pData, size_t size, size_t alignment) override;
+
+	/**
+	 * Check if memory from another resource can be deallocated by this one.
+	 *
+	 * @param other The other resource.
+	 * @return True if the other resource is this arena.
+	 */
+	[[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+private:
+	std::vector<Overflow> m_Overflows;
+
+	std::pmr::memory_resource* m_pUpstream = nullptr;
+	std::byte* m_pBlock = nullptr;
+
+	size_t m_Capacity = 0;
+	size_t m_Offset = 0;
+	size_t m_OverflowSize = 0;
+
+	// The most memory used since the last reset, including the overflows.
+	size_t m_PeakSinceReset = 0;
+	size_t m_PeakSize = 0;
+
+	// These are never rewound, so the difference between two points in time is the number of allocations in between.
+	uint64_t m_AllocationCount = 0;
+	uint64_t m_TotalOverflowCount = 0;
+};
+
+/**
+ * Get the scratch arena of the calling thread.
+ * Prefer the scratch scope over using this directly.
+ *
+ * @return The arena reference.
+ */
+[[nodiscard]] MemoryArena& GetScratchArena();
+
+/**
+ * Scratch scope class.
+ * This allocates short lived data from the calling thread's scratch arena, and frees everything allocated in it when it's destroyed. Scopes can be
+ * nested like a stack. Anything allocated from a scope must be destroyed before the scope itself, so declare the scope first.
+ */
+class ScratchScope final
+{
+public:
+	/**
+	 * Default constructor.
+	 */
+	ScratchScope() : m_Arena(GetScratchArena()), m_Marker(m_Arena.getMarker()) {}
+
+	/**
+	 * Destructor.
+	 */
+	~ScratchScope() { m_Arena.rewind(m_Marker); }
+
+	GRAPHITE_DISABLE_COPY_AND_MOVE(ScratchScope);
+
+	/**
+	 * Create a vector which allocates from the scope.
+	 *
+	 * @tparam Type The value type.
+	 * @param count The number of values. Default is 0.
+	 * @return The vector.
+	 */
+	template<class Type>
+	[[nodiscard]] std::pmr::vector<Type> makeVector(size_t count = 0) const { return std::pmr::vector<Type>(count, &m_Arena); }
+
+public:
+	[[nodiscard]] std::pmr::memory_resource* getResource() const { return &m_Arena; }
+
+private:
+	MemoryArena& m_Arena;
+	MemoryArena::Marker m_Marker;
+};
+
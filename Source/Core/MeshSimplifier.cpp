@@ -0,0 +1,465 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "MeshSimplifier.hpp"
+#include "Logging.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <unordered_map>
+
+namespace /* anonymous */
+{
+	constexpr char g_Magic[4] = { 'G', 'L', 'O', 'D' };
+	// Version 2 changed the LOD errors from the quadric error to the distance the vertices moved.
+	constexpr uint32_t g_Version = 2;
+
+	// The end of a vertex's list of merged vertices.
+	constexpr uint32_t g_InvalidVertex = std::numeric_limits<uint32_t>::max();
+
+	// Collapses which turn a triangle by more than about 75 degrees are rejected, as they fold the surface.
+	constexpr double g_MinimumNormalAlignment = 0.25;
+
+	/**
+	 * Subtract two positions.
+	 *
+	 * @param lhs The left hand side.
+	 * @param rhs The right hand side.
+	 * @return The difference.
+	 */
+	[[nodiscard]] std::array<double, 3> Subtract(const MeshSimplifier::Position& lhs, const MeshSimplifier::Position& rhs)
+	{
+		return { static_cast<double>(lhs[0]) - rhs[0], static_cast<double>(lhs[1]) - rhs[1], static_cast<double>(lhs[2]) - rhs[2] };
+	}
+
+	/**
+	 * Compute the cross product of two vectors.
+	 *
+	 * @param lhs The left hand side.
+	 * @param rhs The right hand side.
+	 * @return The cross product.
+	 */
+	[[nodiscard]] std::array<double, 3> Cross(const std::array<double, 3>& lhs, const std::array<double, 3>& rhs)
+	{
+		return { lhs[1] * rhs[2] - lhs[2] * rhs[1], lhs[2] * rhs[0] - lhs[0] * rhs[2], lhs[0] * rhs[1] - lhs[1] * rhs[0] };
+	}
+
+	/**
+	 * Compute the dot product of two vectors.
+	 *
+	 * @param lhs The left hand side.
+	 * @param rhs The right hand side.
+	 * @return The dot product.
+	 */
+	[[nodiscard]] double Dot(const std::array<double, 3>& lhs, const std::array<double, 3>& rhs)
+	{
+		return lhs[0] * rhs[0] + lhs[1] * rhs[1] + lhs[2] * rhs[2];
+	}
+
+	/**
+	 * Get the key of an edge, which is the same for both directions.
+	 *
+	 * @param first The first vertex.
+	 * @param second The second vertex.
+	 * @return The key.
+	 */
+	[[nodiscard]] uint64_t GetEdgeKey(uint32_t first, uint32_t second)
+	{
+		return (static_cast<uint64_t>(std::min(first, second)) << 32) | std::max(first, second);
+	}
+
+	/**
+	 * Check if a triangle has repeated vertices.
+	 *
+	 * @param triangle The triangle.
+	 * @return True if the triangle has no area.
+	 */
+	[[nodiscard]] bool IsDegenerate(const std::array<uint32_t, 3>& triangle)
+	{
+		return triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[2] == triangle[0];
+	}
+}
+
+bool MeshLODChain::save(const std::filesystem::path& path) const
+{
+	auto file = std::ofstream(path, std::ios::binary);
+	if (!file.is_open())
+	{
+		GRAPHITE_LOG_ERROR("Failed to open the LOD file {}!", path.string());
+		return false;
+	}
+
+	const auto lodCount = static_cast<uint32_t>(m_LODs.size());
+	const auto indexCount = static_cast<uint32_t>(m_Indices.size());
+
+	file.write(g_Magic, sizeof(g_Magic));
+	file.write(reinterpret_cast<const char*>(&g_Version), sizeof(g_Version));
+	file.write(reinterpret_cast<const char*>(&lodCount), sizeof(lodCount));
+	file.write(reinterpret_cast<const char*>(&indexCount), sizeof(indexCount));
+	file.write(reinterpret_cast<const char*>(m_LODs.data()), m_LODs.size() * sizeof(MeshLOD));
+	file.write(reinterpret_cast<const char*>(m_Indices.data()), m_Indices.size() * sizeof(uint32_t));
+
+	return file.good();
+}
+
+MeshLODChain MeshLODChain::Load(const std::filesystem::path& path, uint32_t vertexCount /*= std::numeric_limits<uint32_t>::max()*/)
+{
+	auto file = std::ifstream(path, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+	{
+		GRAPHITE_LOG_ERROR("Failed to open the LOD file {}!", path.string());
+		return MeshLODChain();
+	}
+
+	const auto fileSize = static_cast<uint64_t>(file.tellg());
+	file.seekg(0);
+
+	char magic[sizeof(g_Magic)] = {};
+	uint32_t version = 0;
+	file.read(magic, sizeof(magic));
+	file.read(reinterpret_cast<char*>(&version), sizeof(version));
+
+	if (!file.good() || std::memcmp(magic, g_Magic, sizeof(g_Magic)) != 0 || version != g_Version)
+	{
+		GRAPHITE_LOG_ERROR("The file {} is not a supported LOD file!", path.string());
+		return MeshLODChain();
+	}
+
+	uint32_t lodCount = 0;
+	uint32_t indexCount = 0;
+	file.read(reinterpret_cast<char*>(&lodCount), sizeof(lodCount));
+	file.read(reinterpret_cast<char*>(&indexCount), sizeof(indexCount));
+
+	// The counts are checked against the file size before anything is allocated with them.
+	const uint64_t expectedSize = sizeof(g_Magic) + sizeof(g_Version) + sizeof(uint32_t) * 2 + sizeof(MeshLOD) * static_cast<uint64_t>(lodCount) + sizeof(uint32_t) * static_cast<uint64_t>(indexCount);
+	if (!file.good() || expectedSize > fileSize)
+	{
+		GRAPHITE_LOG_ERROR("The LOD file {} is truncated!", path.string());
+		return MeshLODChain();
+	}
+
+	MeshLODChain chain;
+	chain.m_LODs.resize(lodCount);
+	chain.m_Indices.resize(indexCount);
+	file.read(reinterpret_cast<char*>(chain.m_LODs.data()), chain.m_LODs.size() * sizeof(MeshLOD));
+	file.read(reinterpret_cast<char*>(chain.m_Indices.data()), chain.m_Indices.size() * sizeof(uint32_t));
+
+	if (!file.good())
+	{
+		GRAPHITE_LOG_ERROR("The LOD file {} is truncated!", path.string());
+		return MeshLODChain();
+	}
+
+	// Every LOD must be a list of whole triangles inside the index buffer, and every index must refer to a vertex of the mesh.
+	const auto isValidLOD = [indexCount](const MeshLOD& lod) { return lod.m_IndexCount % 3 == 0 && lod.m_FirstIndex <= indexCount && lod.m_IndexCount <= indexCount - lod.m_FirstIndex; };
+	if (!GRAPHITE_RANGES(all_of, chain.m_LODs, isValidLOD) || !GRAPHITE_RANGES(all_of, chain.m_Indices, [vertexCount](uint32_t index) { return index < vertexCount; }))
+	{
+		GRAPHITE_LOG_ERROR("The LOD file {} is corrupted!", path.string());
+		return MeshLODChain();
+	}
+
+	return chain;
+}
+
+MeshSimplifier::MeshSimplifier(std::span<const Position> positions)
+	: m_Positions(positions)
+{
+}
+
+std::vector<uint32_t> MeshSimplifier::simplify(std::span<const uint32_t> indices, uint32_t targetIndexCount, float maximumError, float& resultError)
+{
+	const auto vertexCount = static_cast<uint32_t>(m_Positions.size());
+
+	// Copy the valid triangles.
+	m_Triangles.clear();
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		const std::array<uint32_t, 3> triangle = { indices[i], indices[i + 1], indices[i + 2] };
+		if (triangle[0] < vertexCount && triangle[1] < vertexCount && triangle[2] < vertexCount && !IsDegenerate(triangle))
+			m_Triangles.emplace_back(triangle);
+	}
+
+	setupVertices();
+
+	const auto targetTriangleCount = static_cast<size_t>(targetIndexCount / 3);
+	double resultDistance = 0.0;
+
+	// Each pass collapses as many edges as it can without two collapses touching the same triangle, so the adjacency stays valid for the pass.
+	m_Remap.resize(vertexCount);
+	while (m_Triangles.size() > targetTriangleCount)
+	{
+		buildAdjacency();
+
+		// Find the cheapest collapse of each edge.
+		m_Collapses.clear();
+		for (const auto& triangle : m_Triangles)
+		{
+			for (uint32_t i = 0; i < 3; i++)
+			{
+				const auto first = triangle[i];
+				const auto second = triangle[(i + 1) % 3];
+
+				// The shared edges are found in both of their triangles, so they are only taken from one.
+				if (first > second || (m_LockedVertices[first] && m_LockedVertices[second]))
+					continue;
+
+				Quadric quadric = m_Quadrics[first];
+				for (uint32_t c = 0; c < quadric.m_Coefficients.size(); c++)
+					quadric.m_Coefficients[c] += m_Quadrics[second].m_Coefficients[c];
+
+				quadric.m_Weight += m_Quadrics[second].m_Weight;
+
+				const auto toSecond = m_LockedVertices[first] ? std::numeric_limits<double>::max() : ComputeError(quadric, m_Positions[second]);
+				const auto toFirst = m_LockedVertices[second] ? std::numeric_limits<double>::max() : ComputeError(quadric, m_Positions[first]);
+
+				// The quadric error orders the collapses, but it's a mean, so the error limit is checked against how far the vertices would move.
+				const auto source = toSecond <= toFirst ? first : second;
+				const auto target = toSecond <= toFirst ? second : first;
+				const auto distance = computeMoveDistance(source, target);
+				if (distance > maximumError)
+					continue;
+
+				m_Collapses.emplace_back(source, target, static_cast<float>(std::min(toSecond, toFirst)), distance);
+			}
+		}
+
+		GRAPHITE_RANGES(sort, m_Collapses, [](const Collapse& lhs, const Collapse& rhs) { return lhs.m_Error < rhs.m_Error; });
+
+		// Do the collapses.
+		std::iota(m_Remap.begin(), m_Remap.end(), 0);
+		m_TouchedVertices.assign(vertexCount, 0);
+
+		auto triangleCount = m_Triangles.size();
+		uint32_t collapseCount = 0;
+
+		for (const auto& collapse : m_Collapses)
+		{
+			if (triangleCount <= targetTriangleCount)
+				break;
+
+			if (m_TouchedVertices[collapse.m_Source] || m_TouchedVertices[collapse.m_Target] || flipsTriangles(collapse))
+				continue;
+
+			// The triangles on the collapsed edge are removed, and none of the source vertex's neighbors can be used again in this pass.
+			for (auto t = m_TriangleOffsets[collapse.m_Source]; t < m_TriangleOffsets[collapse.m_Source + 1]; t++)
+			{
+				const auto& triangle = m_Triangles[m_VertexTriangles[t]];
+				if (triangle[0] == collapse.m_Target || triangle[1] == collapse.m_Target || triangle[2] == collapse.m_Target)
+					triangleCount--;
+
+				for (const auto vertex : triangle)
+					m_TouchedVertices[vertex] = 1;
+			}
+
+			auto& target = m_Quadrics[collapse.m_Target];
+			const auto& source = m_Quadrics[collapse.m_Source];
+			for (uint32_t c = 0; c < target.m_Coefficients.size(); c++)
+				target.m_Coefficients[c] += source.m_Coefficients[c];
+
+			target.m_Weight += source.m_Weight;
+
+			// The source's original vertices are at the target now.
+			m_MergedNext[m_MergedTail[collapse.m_Target]] = collapse.m_Source;
+			m_MergedTail[collapse.m_Target] = m_MergedTail[collapse.m_Source];
+			resultDistance = std::max(resultDistance, collapse.m_Distance);
+
+			m_Remap[collapse.m_Source] = collapse.m_Target;
+			collapseCount++;
+		}
+
+		if (collapseCount == 0)
+			break;
+
+		// Move the collapsed vertices and drop the triangles which lost their area.
+		for (auto& triangle : m_Triangles)
+		{
+			for (auto& vertex : triangle)
+				vertex = m_Remap[vertex];
+		}
+
+		std::erase_if(m_Triangles, IsDegenerate);
+	}
+
+	resultError = static_cast<float>(resultDistance);
+
+	std::vector<uint32_t> result;
+	result.reserve(m_Triangles.size() * 3);
+	for (const auto& triangle : m_Triangles)
+		result.insert(result.end(), triangle.begin(), triangle.end());
+
+	return result;
+}
+
+MeshLODChain MeshSimplifier::generateLODChain(std::span<const uint32_t> indices, uint32_t maximumLODs /*= 6*/, float reduction /*= 0.5f*/, float maximumError /*= std::numeric_limits<float>::max()*/)
+{
+	MeshLODChain chain;
+	chain.m_Indices.assign(indices.begin(), indices.end());
+	chain.m_LODs.emplace_back(0, static_cast<uint32_t>(indices.size()), 0.0f);
+
+	auto previousCount = static_cast<uint32_t>(indices.size());
+	while (chain.m_LODs.size() < maximumLODs)
+	{
+		const auto targetCount = static_cast<uint32_t>(static_cast<float>(previousCount) * reduction);
+
+		float error = 0.0f;
+		const auto lodIndices = simplify(indices, targetCount, maximumError, error);
+		const auto lodCount = static_cast<uint32_t>(lodIndices.size());
+
+		// Stop if the mesh could not be reduced, since the further ones would be the same.
+		if (lodCount == 0 || lodCount >= previousCount)
+			break;
+
+		MeshLOD lod;
+		lod.m_FirstIndex = static_cast<uint32_t>(chain.m_Indices.size());
+		lod.m_IndexCount = lodCount;
+		lod.m_Error = std::max(error, chain.m_LODs.back().m_Error);
+
+		chain.m_Indices.insert(chain.m_Indices.end(), lodIndices.begin(), lodIndices.end());
+		chain.m_LODs.emplace_back(lod);
+
+		// If the error limit was reached, there's nothing left to collapse.
+		if (lodCount > targetCount)
+			break;
+
+		previousCount = lodCount;
+	}
+
+	return chain;
+}
+
+void MeshSimplifier::setupVertices()
+{
+	m_Quadrics.assign(m_Positions.size(), Quadric());
+	m_MergedNext.assign(m_Positions.size(), g_InvalidVertex);
+	m_MergedTail.resize(m_Positions.size());
+	std::iota(m_MergedTail.begin(), m_MergedTail.end(), 0);
+	m_LockedVertices.assign(m_Positions.size(), 0);
+
+	std::unordered_map<uint64_t, uint32_t> edgeUses;
+	for (const auto& triangle : m_Triangles)
+	{
+		const auto& p0 = m_Positions[triangle[0]];
+		const auto normal = Cross(Subtract(m_Positions[triangle[1]], p0), Subtract(m_Positions[triangle[2]], p0));
+		const auto length = std::sqrt(Dot(normal, normal));
+
+		if (length > 0.0)
+		{
+			// The plane quadric, weighted by the triangle area.
+			const auto a = normal[0] / length;
+			const auto b = normal[1] / length;
+			const auto c = normal[2] / length;
+			const auto d = -(a * p0[0] + b * p0[1] + c * p0[2]);
+			const auto area = length * 0.5;
+
+			const std::array<double, 10> coefficients = { a * a, a * b, a * c, a * d, b * b, b * c, b * d, c * c, c * d, d * d };
+			for (const auto vertex : triangle)
+			{
+				auto& quadric = m_Quadrics[vertex];
+				for (uint32_t i = 0; i < coefficients.size(); i++)
+					quadric.m_Coefficients[i] += coefficients[i] * area;
+
+				quadric.m_Weight += area;
+			}
+		}
+
+		for (uint32_t i = 0; i < 3; i++)
+			edgeUses[GetEdgeKey(triangle[i], triangle[(i + 1) % 3])]++;
+	}
+
+	// Lock the vertices on the open and non-manifold edges.
+	for (const auto& [key, uses] : edgeUses)
+	{
+		if (uses != 2)
+		{
+			m_LockedVertices[static_cast<uint32_t>(key >> 32)] = 1;
+			m_LockedVertices[static_cast<uint32_t>(key)] = 1;
+		}
+	}
+}
+
+double MeshSimplifier::ComputeError(const Quadric& quadric, const Position& position)
+{
+	if (quadric.m_Weight <= 0.0)
+		return 0.0;
+
+	const auto& q = quadric.m_Coefficients;
+	const double x = position[0];
+	const double y = position[1];
+	const double z = position[2];
+
+	const auto error =
+		q[0] * x * x + 2.0 * q[1] * x * y + 2.0 * q[2] * x * z + 2.0 * q[3] * x +
+		q[4] * y * y + 2.0 * q[5] * y * z + 2.0 * q[6] * y +
+		q[7] * z * z + 2.0 * q[8] * z +
+		q[9];
+
+	return std::max(error / quadric.m_Weight, 0.0);
+}
+
+double MeshSimplifier::computeMoveDistance(uint32_t source, uint32_t target) const
+{
+	const auto& position = m_Positions[target];
+
+	double distanceSquared = 0.0;
+	for (auto vertex = source; vertex != g_InvalidVertex; vertex = m_MergedNext[vertex])
+	{
+		const auto offset = Subtract(m_Positions[vertex], position);
+		distanceSquared = std::max(distanceSquared, Dot(offset, offset));
+	}
+
+	return std::sqrt(distanceSquared);
+}
+
+void MeshSimplifier::buildAdjacency()
+{
+	m_TriangleOffsets.assign(m_Positions.size() + 1, 0);
+	for (const auto& triangle : m_Triangles)
+	{
+		for (const auto vertex : triangle)
+			m_TriangleOffsets[vertex + 1]++;
+	}
+
+	std::partial_sum(m_TriangleOffsets.begin(), m_TriangleOffsets.end(), m_TriangleOffsets.begin());
+
+	// Fill the lists, using the offsets as write cursors and shifting them back after.
+	m_VertexTriangles.resize(m_Triangles.size() * 3);
+	for (uint32_t i = 0; i < m_Triangles.size(); i++)
+	{
+		for (const auto vertex : m_Triangles[i])
+			m_VertexTriangles[m_TriangleOffsets[vertex]++] = i;
+	}
+
+	for (auto i = m_Positions.size(); i > 0; i--)
+		m_TriangleOffsets[i] = m_TriangleOffsets[i - 1];
+
+	m_TriangleOffsets[0] = 0;
+}
+
+bool MeshSimplifier::flipsTriangles(const Collapse& collapse) const
+{
+	for (auto t = m_TriangleOffsets[collapse.m_Source]; t < m_TriangleOffsets[collapse.m_Source + 1]; t++)
+	{
+		const auto& triangle = m_Triangles[m_VertexTriangles[t]];
+
+		// The triangles on the collapsed edge are removed, so they cannot flip.
+		if (triangle[0] == collapse.m_Target || triangle[1] == collapse.m_Target || triangle[2] == collapse.m_Target)
+			continue;
+
+		auto moved = triangle;
+		for (auto& vertex : moved)
+		{
+			if (vertex == collapse.m_Source)
+				vertex = collapse.m_Target;
+		}
+
+		const auto before = Cross(Subtract(m_Positions[triangle[1]], m_Positions[triangle[0]]), Subtract(m_Positions[triangle[2]], m_Positions[triangle[0]]));
+		const auto after = Cross(Subtract(m_Positions[moved[1]], m_Positions[moved[0]]), Subtract(m_Positions[moved[2]], m_Positions[moved[0]]));
+
+		if (Dot(before, after) <= g_MinimumNormalAlignment * std::sqrt(Dot(before, before) * Dot(after, after)))
+			return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,179 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "Common.hpp"
+
+#include <array>
+#include <filesystem>
+#include <limits>
+#include <span>
+#include <vector>
+
+/**
+ * Mesh LOD structure.
+ * This is a range of a mesh's LOD index buffer. All the LODs use the mesh's vertex buffer.
+ */
+struct MeshLOD final
+{
+	uint32_t m_FirstIndex = 0;
+	uint32_t m_IndexCount = 0;
+
+	float m_Error = 0.0f;	// The largest distance a vertex of the full detail mesh moved, in object space units. This bounds the deviation.
+};
+
+/**
+ * Mesh LOD chain structure.
+ * This contains the indices of every LOD, from the full detail mesh to the coarsest one.
+ */
+struct MeshLODChain final
+{
+	std::vector<uint32_t> m_Indices;
+	std::vector<MeshLOD> m_LODs;
+
+	/**
+	 * Save the chain to a file.
+	 * The chain is meant to be generated when the mesh is imported and stored next to it.
+	 *
+	 * @param path The file path.
+	 * @return True if the chain was saved.
+	 */
+	bool save(const std::filesystem::path& path) const;
+
+	/**
+	 * Load a chain from a file.
+	 * The LOD ranges are checked against the index count, and the indices against the vertex count.
+	 *
+	 * @param path The file path.
+	 * @param vertexCount The vertex count of the mesh the chain belongs to. Default is the maximum, which does not check the indices.
+	 * @return The chain. It's empty if the file could not be loaded, or if it's corrupted.
+	 */
+	[[nodiscard]] static MeshLODChain Load(const std::filesystem::path& path, uint32_t vertexCount = std::numeric_limits<uint32_t>::max());
+};
+
+/**
+ * Mesh simplifier class.
+ * This reduces the triangle count of a mesh by collapsing edges in the order of their quadric error, so the collapses which change the shape the
+ * least are done first. Each collapse moves a vertex onto one of it's neighbors, so the simplified meshes only need new indices and reuse the
+ * vertex buffer. The error of a simplified mesh is the largest distance any of it's original vertices moved, which unlike the quadric error is not
+ * an average.
+ *
+ * The vertices on open edges are never moved. This keeps the outline of open meshes, and the UV and normal seams, which split the vertices and
+ * so look like open edges to the simplifier.
+ */
+class MeshSimplifier final
+{
+	/**
+	 * Quadric structure.
+	 * This is the sum of the squared distances to a set of planes, weighted by the area of the triangle each plane came from.
+	 */
+	struct Quadric final
+	{
+		std::array<double, 10> m_Coefficients = {};
+		double m_Weight = 0.0;
+	};
+
+	/**
+	 * Collapse structure.
+	 * This is a candidate collapse of one vertex onto another.
+	 */
+	struct Collapse final
+	{
+		uint32_t m_Source = 0;
+		uint32_t m_Target = 0;
+
+		float m_Error = 0.0f;		// The quadric error, which orders the collapses.
+		double m_Distance = 0.0;	// The largest distance the collapse moves a vertex of the full detail mesh.
+	};
+
+public:
+	using Position = std::array<float, 3>;
+
+public:
+	/**
+	 * Explicit constructor.
+	 *
+	 * @param positions The vertex positions of the mesh. They must outlive the simplifier.
+	 */
+	explicit MeshSimplifier(std::span<const Position> positions);
+
+	/**
+	 * Simplify a mesh.
+	 *
+	 * @param indices The triangle list indices.
+	 * @param targetIndexCount The index count to reduce to. The result can have more if the error limit is reached first.
+	 * @param maximumError The largest distance a vertex of the mesh can move, in object space units.
+	 * @param resultError The largest distance a vertex of the mesh moved.
+	 * @return The simplified indices.
+	 */
+	[[nodiscard]] std::vector<uint32_t> simplify(std::span<const uint32_t> indices, uint32_t targetIndexCount, float maximumError, float& resultError);
+
+	/**
+	 * Generate a LOD chain.
+	 * Each LOD is simplified from the full detail mesh, so the errors are measured against it, until the maximum LOD count is reached or the mesh
+	 * cannot be reduced any more.
+	 *
+	 * @param indices The triangle list indices of the full detail mesh.
+	 * @param maximumLODs The maximum number of LODs, including the full detail mesh. Default is 6.
+	 * @param reduction The ratio of the index counts of consecutive LODs. Default is 0.5.
+	 * @param maximumError The largest error of the coarsest LOD, in object space units. Default is infinite.
+	 * @return The LOD chain.
+	 */
+	[[nodiscard]] MeshLODChain generateLODChain(std::span<const uint32_t> indices, uint32_t maximumLODs = 6, float reduction = 0.5f, float maximumError = std::numeric_limits<float>::max());
+
+private:
+	/**
+	 * Compute the quadric of each vertex, and lock the vertices on open edges.
+	 */
+	void setupVertices();
+
+	/**
+	 * Compute the error of moving a vertex to a position.
+	 *
+	 * @param quadric The vertex quadric.
+	 * @param position The position.
+	 * @return The mean squared distance to the quadric planes.
+	 */
+	[[nodiscard]] static double ComputeError(const Quadric& quadric, const Position& position);
+
+	/**
+	 * Compute how far a collapse moves the original vertices.
+	 * Each vertex keeps a list of the original vertices which were collapsed onto it, starting with itself, so the distance is exact.
+	 *
+	 * @param source The vertex to collapse.
+	 * @param target The vertex to collapse onto.
+	 * @return The largest distance any of the source's original vertices moves.
+	 */
+	[[nodiscard]] double computeMoveDistance(uint32_t source, uint32_t target) const;
+
+	/**
+	 * Build the list of triangles each vertex is used by.
+	 */
+	void buildAdjacency();
+
+	/**
+	 * Check if a collapse flips any of the source vertex's triangles.
+	 *
+	 * @param collapse The collapse.
+	 * @return True if any triangle flips.
+	 */
+	[[nodiscard]] bool flipsTriangles(const Collapse& collapse) const;
+
+private:
+	std::span<const Position> m_Positions;
+
+	std::vector<std::array<uint32_t, 3>> m_Triangles;
+	std::vector<Quadric> m_Quadrics;
+	std::vector<uint32_t> m_Remap;
+
+	std::vector<uint32_t> m_MergedNext;
+	std::vector<uint32_t> m_MergedTail;
+
+	std::vector<uint32_t> m_TriangleOffsets;
+	std::vector<uint32_t> m_VertexTriangles;
+
+	std::vector<Collapse> m_Collapses;
+
+	std::vector<uint8_t> m_LockedVertices;
+	std::vector<uint8_t> m_TouchedVertices;
+};
@@ -0,0 +1,402 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "PoolAllocator.hpp"
+
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace /* anonymous */
+{
+	constexpr size_t g_ClassCount = PoolAllocator::SizeClasses.size();
+
+	// The size of the chunks the blocks are carved from.
+	constexpr size_t g_ChunkSize = 64 * 1024;
+
+	// The number of blocks moved between a thread cache and the shared pool at once. A cache holds at most two batches of each class.
+	constexpr uint32_t g_BatchSize = 32;
+
+	/**
+	 * Create the table which maps a size in multiples of the alignment to it's size class.
+	 *
+	 * @return The table.
+	 */
+	[[nodiscard]] constexpr std::array<uint8_t, PoolAllocator::MaximumSize / PoolAllocator::Alignment + 1> CreateClassTable()
+	{
+		std::array<uint8_t, PoolAllocator::MaximumSize / PoolAllocator::Alignment + 1> table = {};
+
+		uint8_t sizeClass = 0;
+		for (size_t i = 0; i < table.size(); i++)
+		{
+			while (PoolAllocator::SizeClasses[sizeClass] < i * PoolAllocator::Alignment)
+				sizeClass++;
+
+			table[i] = sizeClass;
+		}
+
+		return table;
+	}
+
+	constexpr auto g_ClassTable = CreateClassTable();
+
+	/**
+	 * Get the size class of an allocation.
+	 *
+	 * @param size The size in bytes. This must not be larger than the maximum size.
+	 * @return The size class index.
+	 */
+	[[nodiscard]] uint8_t GetSizeClass(size_t size)
+	{
+		return g_ClassTable[(size + PoolAllocator::Alignment - 1) / PoolAllocator::Alignment];
+	}
+
+	/**
+	 * Free block structure.
+	 * The free blocks are linked through their own memory.
+	 */
+	struct FreeBlock final
+	{
+		FreeBlock* m_pNext = nullptr;
+	};
+
+	/**
+	 * Block list structure.
+	 */
+	struct BlockList final
+	{
+		FreeBlock* m_pHead = nullptr;
+		uint32_t m_Count = 0;
+	};
+
+	/**
+	 * Central pool class.
+	 * This holds the shared free lists and the chunks of every size class.
+	 */
+	class CentralPool final
+	{
+		/**
+		 * Size class pool structure.
+		 */
+		struct alignas(64) ClassPool final
+		{
+			std::mutex m_Mutex;
+			BlockList m_FreeBlocks;
+			std::vector<void*> m_Chunks;
+		};
+
+	public:
+		/**
+		 * Default constructor.
+		 */
+		CentralPool() = default;
+
+		/**
+		 * Destructor.
+		 * This frees all the chunks.
+		 */
+		~CentralPool()
+		{
+			for (auto& pool : m_Pools)
+			{
+				for (const auto pChunk : pool.m_Chunks)
+					::operator delete(pChunk);
+			}
+		}
+
+		GRAPHITE_DISABLE_COPY_AND_MOVE(CentralPool);
+
+		/**
+		 * Take a batch of free blocks.
+		 * A new chunk is allocated if there are no free blocks.
+		 *
+		 * @param sizeClass The size class index.
+		 * @return The blocks. This is never empty.
+		 */
+		[[nodiscard]] BlockList acquire(uint8_t sizeClass)
+		{
+			auto& pool = m_Pools[sizeClass];
+			const auto lock = std::scoped_lock(pool.m_Mutex);
+
+			if (pool.m_FreeBlocks.m_Count == 0)
+				carveChunk(pool, PoolAllocator::SizeClasses[sizeClass]);
+
+			// Detach up to a batch from the front of the list.
+			BlockList batch;
+			batch.m_pHead = pool.m_FreeBlocks.m_pHead;
+
+			auto pTail = batch.m_pHead;
+			batch.m_Count = 1;
+			while (batch.m_Count < g_BatchSize && pTail->m_pNext != nullptr)
+			{
+				pTail = pTail->m_pNext;
+				batch.m_Count++;
+			}
+
+			pool.m_FreeBlocks.m_pHead = pTail->m_pNext;
+			pool.m_FreeBlocks.m_Count -= batch.m_Count;
+			pTail->m_pNext = nullptr;
+
+			return batch;
+		}
+
+		/**
+		 * Give blocks back.
+		 *
+		 * @param sizeClass The size class index.
+		 * @param blocks The blocks.
+		 */
+		void release(uint8_t sizeClass, BlockList blocks)
+		{
+			if (blocks.m_Count == 0)
+				return;
+
+			auto pTail = blocks.m_pHead;
+			while (pTail->m_pNext != nullptr)
+				pTail = pTail->m_pNext;
+
+			auto& pool = m_Pools[sizeClass];
+			const auto lock = std::scoped_lock(pool.m_Mutex);
+
+			pTail->m_pNext = pool.m_FreeBlocks.m_pHead;
+			pool.m_FreeBlocks.m_pHead = blocks.m_pHead;
+			pool.m_FreeBlocks.m_Count += blocks.m_Count;
+		}
+
+		/**
+		 * Get the pool statistics.
+		 *
+		 * @return The statistics.
+		 */
+		[[nodiscard]] PoolStatistics getStatistics()
+		{
+			PoolStatistics statistics;
+			for (uint8_t i = 0; i < g_ClassCount; i++)
+			{
+				auto& pool = m_Pools[i];
+				const auto lock = std::scoped_lock(pool.m_Mutex);
+
+				statistics.m_ChunkCount += pool.m_Chunks.size();
+				statistics.m_ReservedSize += pool.m_Chunks.size() * g_ChunkSize;
+				statistics.m_CentralFreeSize += static_cast<uint64_t>(pool.m_FreeBlocks.m_Count) * PoolAllocator::SizeClasses[i];
+			}
+
+			return statistics;
+		}
+
+	private:
+		/**
+		 * Allocate a chunk and add all of it's blocks to the free list.
+		 *
+		 * @param pool The pool to add to. It's mutex must be locked.
+		 * @param blockSize The block size.
+		 */
+		static void carveChunk(ClassPool& pool, size_t blockSize)
+		{
+			const auto pChunk = static_cast<std::byte*>(::operator new(g_ChunkSize));
+			pool.m_Chunks.emplace_back(pChunk);
+
+			const auto blockCount = g_ChunkSize / blockSize;
+			for (size_t i = blockCount; i > 0; i--)
+			{
+				const auto pBlock = new (pChunk + (i - 1) * blockSize) FreeBlock();
+				pBlock->m_pNext = pool.m_FreeBlocks.m_pHead;
+				pool.m_FreeBlocks.m_pHead = pBlock;
+			}
+
+			pool.m_FreeBlocks.m_Count += static_cast<uint32_t>(blockCount);
+		}
+
+	private:
+		std::array<ClassPool, g_ClassCount> m_Pools;
+	};
+
+	/**
+	 * Get the central pool.
+	 *
+	 * @return The central pool reference.
+	 */
+	[[nodiscard]] CentralPool& GetCentralPool()
+	{
+		static CentralPool pool;
+		return pool;
+	}
+
+	/**
+	 * Thread cache structure.
+	 */
+	struct ThreadCache final
+	{
+		/**
+		 * Default constructor.
+		 * This makes sure the central pool is created first, so it outlives every cache.
+		 */
+		ThreadCache() { static_cast<void>(GetCentralPool()); }
+
+		/**
+		 * Destructor.
+		 */
+		~ThreadCache();
+
+		GRAPHITE_DISABLE_COPY_AND_MOVE(ThreadCache);
+
+		/**
+		 * Give all the cached blocks back to the central pool.
+		 */
+		void flush()
+		{
+			auto& centralPool = GetCentralPool();
+			for (uint8_t i = 0; i < g_ClassCount; i++)
+			{
+				centralPool.release(i, m_Lists[i]);
+				m_Lists[i] = BlockList();
+			}
+		}
+
+		std::array<BlockList, g_ClassCount> m_Lists = {};
+	};
+
+	// Objects can be freed after the calling thread's cache is destroyed, for example by other thread local destructors. Those go to the
+	// central pool directly.
+	thread_local bool t_bIsCacheDestroyed = false;
+	thread_local ThreadCache t_Cache;
+
+	ThreadCache::~ThreadCache()
+	{
+		flush();
+		t_bIsCacheDestroyed = true;
+	}
+
+	/**
+	 * Memory resource which allocates from the pools.
+	 */
+	class PoolResource final : public std::pmr::memory_resource
+	{
+		/**
+		 * Allocate memory.
+		 *
+		 * @param size The size in bytes.
+		 * @param alignment The alignment.
+		 * @return The memory pointer.
+		 */
+		void* do_allocate(size_t size, size_t alignment) override
+		{
+			if (alignment > PoolAllocator::Alignment)
+				return ::operator new(size, std::align_val_t(alignment));
+
+			return PoolAllocator::Allocate(size);
+		}
+
+		/**
+		 * Deallocate memory.
+		 *
+		 * @param pData The memory pointer.
+		 * @param size The size in bytes.
+		 * @param alignment The alignment.
+		 */
+		void do_deallocate(void* pData, size_t size, size_t alignment) override
+		{
+			if (alignment > PoolAllocator::Alignment)
+				::operator delete(pData, size, std::align_val_t(alignment));
+
+			else
+				PoolAllocator::Deallocate(pData, size);
+		}
+
+		/**
+		 * Check if memory from another resource can be deallocated by this one.
+		 *
+		 * @param other The other resource.
+		 * @return True if the other resource is also a pool resource.
+		 */
+		[[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return dynamic_cast<const PoolResource*>(&other) != nullptr; }
+	};
+}
+
+void* PoolAllocator::Allocate(size_t size)
+{
+	if (size > MaximumSize)
+		return ::operator new(size);
+
+	const auto sizeClass = GetSizeClass(size);
+	if (t_bIsCacheDestroyed)
+	{
+		// Take a whole batch and keep only the first block, so the rest is not lost.
+		auto batch = GetCentralPool().acquire(sizeClass);
+		const auto pBlock = batch.m_pHead;
+		batch.m_pHead = pBlock->m_pNext;
+		batch.m_Count--;
+
+		GetCentralPool().release(sizeClass, batch);
+		return pBlock;
+	}
+
+	auto& list = t_Cache.m_Lists[sizeClass];
+	if (list.m_Count == 0)
+		list = GetCentralPool().acquire(sizeClass);
+
+	const auto pBlock = list.m_pHead;
+	list.m_pHead = pBlock->m_pNext;
+	list.m_Count--;
+
+	return pBlock;
+}
+
+void PoolAllocator::Deallocate(void* pData, size_t size)
+{
+	if (pData == nullptr)
+		return;
+
+	if (size > MaximumSize)
+	{
+		::operator delete(pData, size);
+		return;
+	}
+
+	const auto sizeClass = GetSizeClass(size);
+	const auto pBlock = new (pData) FreeBlock();
+	if (t_bIsCacheDestroyed)
+	{
+		GetCentralPool().release(sizeClass, BlockList{ pBlock, 1 });
+		return;
+	}
+
+	auto& list = t_Cache.m_Lists[sizeClass];
+	pBlock->m_pNext = list.m_pHead;
+	list.m_pHead = pBlock;
+	list.m_Count++;
+
+	// Give a batch back once the cache is full, so a thread which only frees does not hoard the blocks.
+	if (list.m_Count < g_BatchSize * 2)
+		return;
+
+	BlockList batch;
+	batch.m_pHead = list.m_pHead;
+	batch.m_Count = g_BatchSize;
+
+	auto pTail = list.m_pHead;
+	for (uint32_t i = 1; i < g_BatchSize; i++)
+		pTail = pTail->m_pNext;
+
+	list.m_pHead = pTail->m_pNext;
+	list.m_Count -= g_BatchSize;
+	pTail->m_pNext = nullptr;
+
+	GetCentralPool().release(sizeClass, batch);
+}
+
+void PoolAllocator::FlushThreadCache()
+{
+	if (!t_bIsCacheDestroyed)
+		t_Cache.flush();
+}
+
+PoolStatistics PoolAllocator::GetStatistics()
+{
+	return GetCentralPool().getStatistics();
+}
+
+std::pmr::memory_resource* PoolAllocator::GetResource()
+{
+	static PoolResource resource;
+	return &resource;
+}
@@ -0,0 +1,109 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "Common.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+/**
+ * Pool statistics structure.
+ */
+struct PoolStatistics final
+{
+	uint64_t m_ReservedSize = 0;	// The bytes of all the chunks the pools have allocated.
+	uint64_t m_CentralFreeSize = 0;	// The bytes in the shared free lists. The rest is in use or cached by the threads.
+	uint64_t m_ChunkCount = 0;
+};
+
+/**
+ * Pool allocator class.
+ * This allocates small objects from fixed size blocks, one pool per size class. The blocks are carved from large chunks which are never given back,
+ * so a pool only touches the general heap while it's growing.
+ *
+ * Every thread has it's own cache of free blocks for each size class, so allocating and freeing does not lock anything most of the time. The
+ * caches exchange blocks with the shared pools in batches, which is the only place a lock is taken. Blocks can be freed from a different thread
+ * than the one which allocated them.
+ *
+ * Allocations larger than the largest size class go to the general heap.
+ */
+class PoolAllocator final
+{
+public:
+	// The block sizes. Every size is a multiple of the alignment, so every block is aligned.
+	static constexpr std::array<size_t, 10> SizeClasses = { 16, 32, 48, 64, 96, 128, 192, 256, 384, 512 };
+	static constexpr size_t MaximumSize = SizeClasses.back();
+	static constexpr size_t Alignment = 16;
+
+	/**
+	 * Allocate memory.
+	 *
+	 * @param size The size in bytes.
+	 * @return The memory pointer. This is aligned to the pool alignment.
+	 */
+	[[nodiscard]] static void* Allocate(size_t size);
+
+	/**
+	 * Deallocate memory.
+	 *
+	 * @param pData The memory pointer.
+	 * @param size The size the memory was allocated with.
+	 */
+	static void Deallocate(void* pData, size_t size);
+
+	/**
+	 * Return the calling thread's cached blocks to the shared pools.
+	 * This is done automatically when a thread exits.
+	 */
+	static void FlushThreadCache();
+
+	/**
+	 * Get the pool statistics.
+	 * This is thread safe.
+	 *
+	 * @return The statistics.
+	 */
+	[[nodiscard]] static PoolStatistics GetStatistics();
+
+	/**
+	 * Get a memory resource which allocates from the pools.
+	 * Allocations with a larger alignment than the pool alignment go to the general heap.
+	 *
+	 * @return The memory resource pointer.
+	 */
+	[[nodiscard]] static std::pmr::memory_resource* GetResource();
+};
+
+/**
+ * Pool allocated class.
+ * Inheriting from this makes new and delete of a type use the pool allocator.
+ *
+ * @tparam Type The type which inherits from this.
+ */
+template<class Type>
+class PoolAllocated
+{
+public:
+	/**
+	 * Allocate memory for an object.
+	 *
+	 * @param size The size in bytes.
+	 * @return The memory pointer.
+	 */
+	[[nodiscard]] static void* operator new(size_t size)
+	{
+		static_assert(alignof(Type) <= PoolAllocator::Alignment, "Over aligned types cannot be pool allocated!");
+		return PoolAllocator::Allocate(size);
+	}
+
+	/**
+	 * Deallocate the memory of an object.
+	 *
+	 * @param pData The memory pointer.
+	 * @param size The size in bytes.
+	 */
+	static void operator delete(void* pData, size_t size) { PoolAllocator::Deallocate(pData, size); }
+};
@@ -0,0 +1,121 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "RadixSort.hpp"
+#include "Logging.hpp"
+
+#include <algorithm>
+#include <barrier>
+#include <thread>
+
+RadixSorter::RadixSorter(uint32_t maximumThreads /*= 0*/)
+	: m_MaximumThreads(maximumThreads > 0 ? maximumThreads : std::max(std::thread::hardware_concurrency(), 1u))
+{
+}
+
+void RadixSorter::sort(std::span<uint64_t> keys, std::span<uint32_t> values)
+{
+	if (keys.size() != values.size())
+	{
+		GRAPHITE_LOG_ERROR("Cannot sort {} keys with {} values! The keys and the values must be the same size.", keys.size(), values.size());
+		return;
+	}
+
+	const auto count = static_cast<uint32_t>(keys.size());
+	if (count < 2)
+		return;
+
+	m_KeyScratch.resize(count);
+	m_ValueScratch.resize(count);
+
+	const auto threadCount = std::clamp(count / std::max(m_KeysPerThread, 1u), 1u, m_MaximumThreads);
+	const auto chunkSize = (count + threadCount - 1) / threadCount;
+	m_Histograms.resize(threadCount);
+
+	// The buffers are swapped after each pass, so the data ends up in either of them.
+	uint64_t* pSourceKeys = keys.data();
+	uint32_t* pSourceValues = values.data();
+	uint64_t* pDestinationKeys = m_KeyScratch.data();
+	uint32_t* pDestinationValues = m_ValueScratch.data();
+
+	bool bSkipPass = false;
+	bool bCounting = true;
+
+	// This is run by one thread once all the threads are done with a phase.
+	const auto completePhase = [&]() noexcept
+	{
+		if (bCounting)
+		{
+			// Turn the counts into the offsets each thread scatters it's digits to. If a single digit has all the keys, the pass changes nothing.
+			uint32_t offset = 0;
+			bSkipPass = false;
+			for (uint32_t digit = 0; digit < DigitCount; digit++)
+			{
+				uint32_t digitTotal = 0;
+				for (auto& histogram : m_Histograms)
+				{
+					const auto digitCount = histogram[digit];
+					histogram[digit] = offset;
+					offset += digitCount;
+					digitTotal += digitCount;
+				}
+
+				if (digitTotal == count)
+					bSkipPass = true;
+			}
+		}
+		else if (!bSkipPass)
+		{
+			std::swap(pSourceKeys, pDestinationKeys);
+			std::swap(pSourceValues, pDestinationValues);
+		}
+
+		bCounting = !bCounting;
+	};
+
+	auto synchronization = std::barrier(static_cast<std::ptrdiff_t>(threadCount), completePhase);
+
+	const auto worker = [&](uint32_t thread)
+	{
+		const auto begin = std::min(thread * chunkSize, count);
+		const auto end = std::min(begin + chunkSize, count);
+		auto& histogram = m_Histograms[thread];
+
+		for (uint32_t shift = 0; shift < 64; shift += DigitBits)
+		{
+			histogram.fill(0);
+			for (auto i = begin; i < end; i++)
+				histogram[(pSourceKeys[i] >> shift) & (DigitCount - 1)]++;
+
+			synchronization.arrive_and_wait();
+
+			if (!bSkipPass)
+			{
+				for (auto i = begin; i < end; i++)
+				{
+					const auto destination = histogram[(pSourceKeys[i] >> shift) & (DigitCount - 1)]++;
+					pDestinationKeys[destination] = pSourceKeys[i];
+					pDestinationValues[destination] = pSourceValues[i];
+				}
+			}
+
+			synchronization.arrive_and_wait();
+		}
+	};
+
+	// The calling thread takes the first chunk.
+	{
+		std::vector<std::jthread> threads;
+		threads.reserve(threadCount - 1);
+		for (uint32_t thread = 1; thread < threadCount; thread++)
+			threads.emplace_back(worker, thread);
+
+		worker(0);
+	}
+
+	// Copy the result back if it ended up in the scratch buffers.
+	if (pSourceKeys != keys.data())
+	{
+		std::copy_n(pSourceKeys, count, keys.data());
+		std::copy_n(pSourceValues, count, values.data());
+	}
+}
@@ -0,0 +1,55 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/**
+ * Radix sorter class.
+ * This sorts 64-bit keys with a 32-bit value each, using a least significant digit radix sort with 8-bit digits. The sort is stable and it's cost
+ * is linear in the number of keys. Digits which are the same for every key are skipped, so keys which only use their upper bits (like render
+ * keys with an empty depth) take fewer passes.
+ *
+ * Large inputs are split between multiple threads. Each thread counts the digits of it's own chunk, and the per thread counts are turned into
+ * offsets so every thread can scatter it's chunk without any synchronization. The scratch memory is kept between sorts.
+ */
+class RadixSorter final
+{
+	static constexpr uint32_t DigitBits = 8;
+	static constexpr uint32_t DigitCount = 1 << DigitBits;
+
+public:
+	/**
+	 * Explicit constructor.
+	 *
+	 * @param maximumThreads The maximum number of threads to sort with. 0 uses the hardware concurrency. Default is 0.
+	 */
+	explicit RadixSorter(uint32_t maximumThreads = 0);
+
+	/**
+	 * Sort keys and their values.
+	 *
+	 * @param keys The keys to sort.
+	 * @param values The values to reorder with the keys. This must be the same size as the keys.
+	 */
+	void sort(std::span<uint64_t> keys, std::span<uint32_t> values);
+
+	/**
+	 * Set the minimum number of keys each thread should get.
+	 * Inputs smaller than this are sorted on the calling thread, since starting the threads costs more than the sort itself.
+	 *
+	 * @param count The key count. Default is 32768.
+	 */
+	void setKeysPerThread(uint32_t count) { m_KeysPerThread = count; }
+
+private:
+	std::vector<uint64_t> m_KeyScratch;
+	std::vector<uint32_t> m_ValueScratch;
+	std::vector<std::array<uint32_t, DigitCount>> m_Histograms;
+
+	uint32_t m_MaximumThreads = 1;
+	uint32_t m_KeysPerThread = 32768;
+};
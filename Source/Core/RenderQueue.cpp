@@ -0,0 +1,109 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "RenderQueue.hpp"
+#include "Logging.hpp"
+
+#include <optick.h>
+
+#include <algorithm>
+#include <bit>
+#include <numeric>
+
+namespace /* anonymous */
+{
+	constexpr uint32_t g_DepthBits = 24;
+	constexpr uint32_t g_MaterialShift = g_DepthBits;
+	constexpr uint32_t g_PipelineShift = g_MaterialShift + 16;
+	constexpr uint32_t g_PassShift = g_PipelineShift + 16;
+
+	/**
+	 * Check if two render items can be drawn with a single instanced draw.
+	 *
+	 * @param batch The batch to merge into.
+	 * @param item The item to merge.
+	 * @return True if the item has the same state and geometry as the batch.
+	 */
+	[[nodiscard]] bool CanMerge(const RenderBatch& batch, const RenderItem& item)
+	{
+		return batch.m_PipelineID == item.m_PipelineID &&
+			batch.m_MaterialID == item.m_MaterialID &&
+			batch.m_IndexCount == item.m_IndexCount &&
+			batch.m_FirstIndex == item.m_FirstIndex &&
+			batch.m_VertexOffset == item.m_VertexOffset;
+	}
+}
+
+uint64_t RenderQueue::EncodeKey(uint8_t pass, uint32_t pipelineID, uint32_t materialID, float depth, DepthOrder order)
+{
+	// The bits of a positive float sort the same way as it's value. Dropping the sign and the lowest mantissa bits leaves 24 bits. The comparison
+	// also turns -0 and NaN into 0, which std::max would let through with the sign bit set, and the mask keeps the depth out of the other fields.
+	constexpr uint32_t depthMask = (1u << g_DepthBits) - 1;
+	const auto depthBits = (std::bit_cast<uint32_t>(depth > 0.0f ? depth : 0.0f) >> (32 - g_DepthBits - 1)) & depthMask;
+	const auto depthKey = order == DepthOrder::FrontToBack ? depthBits : depthMask - depthBits;
+
+	return static_cast<uint64_t>(pass) << g_PassShift |
+		static_cast<uint64_t>(pipelineID & (MaximumPipelines - 1)) << g_PipelineShift |
+		static_cast<uint64_t>(materialID & (MaximumMaterials - 1)) << g_MaterialShift |
+		static_cast<uint64_t>(depthKey);
+}
+
+void RenderQueue::submit(uint8_t pass, const RenderItem& item, float depth)
+{
+	GRAPHITE_ASSERT(item.m_PipelineID < MaximumPipelines && item.m_MaterialID < MaximumMaterials,
+		"The pipeline ID {} or the material ID {} does not fit in the render queue's sort key!", item.m_PipelineID, item.m_MaterialID);
+
+	m_Keys.emplace_back(EncodeKey(pass, item.m_PipelineID, item.m_MaterialID, depth, m_DepthOrders[pass]));
+	m_Items.emplace_back(item);
+}
+
+void RenderQueue::sort()
+{
+	OPTICK_EVENT();
+
+	m_Order.resize(m_Items.size());
+	std::iota(m_Order.begin(), m_Order.end(), 0);
+	m_Sorter.sort(m_Keys, m_Order);
+
+	// Merge the consecutive items with the same state into instanced draws.
+	m_Batches.clear();
+	m_InstanceIndices.clear();
+	m_InstanceIndices.reserve(m_Items.size());
+	m_PipelineChanges = 0;
+	m_MaterialChanges = 0;
+
+	for (uint32_t i = 0; i < m_Order.size(); i++)
+	{
+		const auto& item = m_Items[m_Order[i]];
+		const auto pass = static_cast<uint8_t>(m_Keys[i] >> g_PassShift);
+
+		if (m_Batches.empty() || m_Batches.back().m_Pass != pass || !CanMerge(m_Batches.back(), item))
+		{
+			if (m_Batches.empty() || m_Batches.back().m_PipelineID != item.m_PipelineID)
+				m_PipelineChanges++;
+
+			if (m_Batches.empty() || m_Batches.back().m_MaterialID != item.m_MaterialID)
+				m_MaterialChanges++;
+
+			auto& batch = m_Batches.emplace_back();
+			batch.m_PipelineID = item.m_PipelineID;
+			batch.m_MaterialID = item.m_MaterialID;
+			batch.m_IndexCount = item.m_IndexCount;
+			batch.m_FirstIndex = item.m_FirstIndex;
+			batch.m_VertexOffset = item.m_VertexOffset;
+			batch.m_FirstInstance = static_cast<uint32_t>(m_InstanceIndices.size());
+			batch.m_Pass = pass;
+		}
+
+		m_Batches.back().m_InstanceCount++;
+		m_InstanceIndices.emplace_back(item.m_InstanceIndex);
+	}
+}
+
+void RenderQueue::clear()
+{
+	m_Items.clear();
+	m_Keys.clear();
+	m_Order.clear();
+	m_Batches.clear();
+	m_InstanceIndices.clear();
+}
@@ -0,0 +1,136 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "Common.hpp"
+#include "RadixSort.hpp"
+
+/**
+ * Depth order enum.
+ * This defines how the draws of a pass are ordered by their depth.
+ */
+enum class DepthOrder : uint8_t
+{
+	FrontToBack,	// For opaque passes, so the early depth test rejects as much as possible.
+	BackToFront		// For transparent passes, so they blend correctly.
+};
+
+/**
+ * Render item structure.
+ * This contains the state and the geometry of a single draw.
+ */
+struct RenderItem final
+{
+	uint32_t m_PipelineID = 0;	// This must be less than RenderQueue::MaximumPipelines, since the sort key only has 16 bits for it.
+	uint32_t m_MaterialID = 0;	// This must be less than RenderQueue::MaximumMaterials, for the same reason.
+
+	uint32_t m_IndexCount = 0;
+	uint32_t m_FirstIndex = 0;
+	int32_t m_VertexOffset = 0;
+
+	uint32_t m_InstanceIndex = 0;	// The index of the item's per-instance data.
+};
+
+/**
+ * Render batch structure.
+ * This is a single instanced draw, made from consecutive items with the same state and geometry.
+ */
+struct RenderBatch final
+{
+	uint32_t m_PipelineID = 0;
+	uint32_t m_MaterialID = 0;
+
+	uint32_t m_IndexCount = 0;
+	uint32_t m_FirstIndex = 0;
+	int32_t m_VertexOffset = 0;
+
+	uint32_t m_FirstInstance = 0;	// The first entry of the batch in the instance indices.
+	uint32_t m_InstanceCount = 0;
+
+	uint8_t m_Pass = 0;
+};
+
+/**
+ * Render queue class.
+ * Each submitted draw is encoded as a 64-bit key with the pass in the highest bits, followed by the pipeline, the material and the depth. Sorting
+ * the keys groups the draws by pass and then by state, so the pipeline and the material change as few times as possible, and orders each group by
+ * depth. Consecutive draws with the same state and geometry are then merged into a single instanced draw.
+ *
+ * The queue is filled by a single thread.
+ */
+class RenderQueue final
+{
+public:
+	static constexpr uint32_t MaximumPipelines = 1 << 16;
+	static constexpr uint32_t MaximumMaterials = 1 << 16;
+
+public:
+	/**
+	 * Default constructor.
+	 */
+	RenderQueue() = default;
+
+	/**
+	 * Encode a sort key.
+	 *
+	 * @param pass The render pass.
+	 * @param pipelineID The pipeline ID. Only the lower 16 bits are used.
+	 * @param materialID The material ID. Only the lower 16 bits are used.
+	 * @param depth The view space depth. Negative values are clamped to 0.
+	 * @param order The depth order of the pass.
+	 * @return The sort key.
+	 */
+	[[nodiscard]] static uint64_t EncodeKey(uint8_t pass, uint32_t pipelineID, uint32_t materialID, float depth, DepthOrder order);
+
+	/**
+	 * Set the depth order of a pass.
+	 *
+	 * @param pass The render pass.
+	 * @param order The depth order. Default for all the passes is front to back.
+	 */
+	void setDepthOrder(uint8_t pass, DepthOrder order) { m_DepthOrders[pass] = order; }
+
+	/**
+	 * Submit a draw.
+	 *
+	 * @param pass The render pass to draw in.
+	 * @param item The render item. The pipeline and the material IDs must fit in the sort key, otherwise the items whose IDs only differ in
+	 * the upper bits would be sorted together, and split into separate batches.
+	 * @param depth The view space depth of the item.
+	 */
+	void submit(uint8_t pass, const RenderItem& item, float depth);
+
+	/**
+	 * Sort the submitted draws and merge them into batches.
+	 */
+	void sort();
+
+	/**
+	 * Clear the queue for the next frame.
+	 * The memory is kept so the queue does not allocate in the steady state.
+	 */
+	void clear();
+
+public:
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, ItemCount, static_cast<uint32_t>(m_Items.size()));
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, PipelineChanges, m_PipelineChanges);
+	GRAPHITE_SETUP_SIMPLE_GETTER(uint32_t, MaterialChanges, m_MaterialChanges);
+	GRAPHITE_SETUP_GETTERS(std::vector<RenderBatch>, Batches, m_Batches);
+	GRAPHITE_SETUP_GETTERS(std::vector<uint32_t>, InstanceIndices, m_InstanceIndices);
+	GRAPHITE_SETUP_GETTERS(RadixSorter, Sorter, m_Sorter);
+
+private:
+	RadixSorter m_Sorter;
+
+	std::vector<RenderItem> m_Items;
+	std::vector<uint64_t> m_Keys;
+	std::vector<uint32_t> m_Order;
+
+	std::vector<RenderBatch> m_Batches;
+	std::vector<uint32_t> m_InstanceIndices;
+
+	std::array<DepthOrder, 256> m_DepthOrders = {};
+
+	uint32_t m_PipelineChanges = 0;
+	uint32_t m_MaterialChanges = 0;
+};
@@ -0,0 +1,94 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "ResolutionController.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace /* anonymous */
+{
+	// The weight of a new frame time in the smoothed frame time.
+	constexpr float g_SmoothingFactor = 0.2f;
+
+	// The number of frames the smoothed frame time needs before it's trusted.
+	constexpr uint32_t g_WarmupFrames = 4;
+
+	// The fraction of the computed change applied when the scale grows.
+	constexpr float g_GrowthRate = 0.5f;
+
+	/**
+	 * Convert a duration to milliseconds.
+	 *
+	 * @param duration The duration.
+	 * @return The milliseconds.
+	 */
+	[[nodiscard]] float ToMilliseconds(std::chrono::nanoseconds duration)
+	{
+		return std::chrono::duration<float, std::milli>(duration).count();
+	}
+}
+
+ResolutionController::ResolutionController(const ResolutionControllerSettings& settings /*= ResolutionControllerSettings()*/)
+{
+	setSettings(settings);
+	m_Scale = m_Settings.m_MaximumScale;
+}
+
+bool ResolutionController::addFrameTime(std::chrono::nanoseconds frameTime)
+{
+	// Skip the frames which were already in flight when the scale changed.
+	if (m_SettleCount > 0)
+	{
+		m_SettleCount--;
+		return false;
+	}
+
+	const auto milliseconds = ToMilliseconds(frameTime);
+	m_SmoothedFrameTime = m_SampleCount == 0 ? milliseconds : m_SmoothedFrameTime + (milliseconds - m_SmoothedFrameTime) * g_SmoothingFactor;
+	m_SampleCount++;
+
+	if (m_SampleCount < g_WarmupFrames || m_SmoothedFrameTime <= 0.0f)
+		return false;
+
+	// Nothing to do while the frame time is close enough to the aim.
+	const auto aim = ToMilliseconds(m_Settings.m_TargetFrameTime) * m_Settings.m_Headroom;
+	const auto ratio = aim / m_SmoothedFrameTime;
+	if (std::abs(ratio - 1.0f) <= m_Settings.m_Tolerance)
+		return false;
+
+	auto scale = m_Scale * std::sqrt(ratio);
+	if (scale > m_Scale)
+		scale = m_Scale + (scale - m_Scale) * g_GrowthRate;
+
+	scale = std::clamp(scale, m_Settings.m_MinimumScale, m_Settings.m_MaximumScale);
+	if (scale == m_Scale)
+		return false;
+
+	// The frames rendered at the old scale say nothing about the new one.
+	m_Scale = scale;
+	m_SettleCount = m_Settings.m_SettleFrames;
+	m_SampleCount = 0;
+
+	return true;
+}
+
+void ResolutionController::setSettings(const ResolutionControllerSettings& settings)
+{
+	m_Settings = settings;
+	m_Settings.m_MinimumScale = std::clamp(m_Settings.m_MinimumScale, 0.01f, 1.0f);
+	m_Settings.m_MaximumScale = std::clamp(m_Settings.m_MaximumScale, m_Settings.m_MinimumScale, 1.0f);
+
+	m_Scale = std::clamp(m_Scale, m_Settings.m_MinimumScale, m_Settings.m_MaximumScale);
+}
+
+void ResolutionController::reset()
+{
+	m_SampleCount = 0;
+	m_SettleCount = 0;
+	m_SmoothedFrameTime = 0.0f;
+}
+
+uint32_t ResolutionController::scaleSize(uint32_t displaySize) const
+{
+	return std::max(static_cast<uint32_t>(std::ceil(static_cast<float>(displaySize) * m_Scale)), 1u);
+}
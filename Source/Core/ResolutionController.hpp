@@ -0,0 +1,92 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "Common.hpp"
+
+#include <chrono>
+#include <cstdint>
+
+/**
+ * Resolution controller settings structure.
+ */
+struct ResolutionControllerSettings final
+{
+	std::chrono::nanoseconds m_TargetFrameTime = std::chrono::microseconds(16667);
+
+	float m_MinimumScale = 0.5f;
+	float m_MaximumScale = 1.0f;
+
+	// The fraction of the target the controller aims for, which leaves room for spikes.
+	float m_Headroom = 0.9f;
+
+	// The frame time can be this fraction away from the aim before the scale is changed, so the scale does not chase the noise.
+	float m_Tolerance = 0.05f;
+
+	// The GPU times arrive a few frames late, so the scale is not changed again till the frames rendered with it are measured.
+	uint32_t m_SettleFrames = 8;
+};
+
+/**
+ * Resolution controller class.
+ * This adjusts the render scale from the measured GPU frame times, so the frame time stays below the target instead of dropping frames. The scale
+ * applies to both axes, and the GPU cost is assumed to scale with the pixel count, so the scale is changed by the square root of the ratio between
+ * the aim and the smoothed frame time.
+ *
+ * The scale drops right away when the frames are too slow, but only grows by a part of the headroom at a time, so it does not oscillate around the
+ * target.
+ */
+class ResolutionController final
+{
+public:
+	/**
+	 * Explicit constructor.
+	 *
+	 * @param settings The controller settings. Default is a 60 FPS target with a scale between 0.5 and 1.
+	 */
+	explicit ResolutionController(const ResolutionControllerSettings& settings = ResolutionControllerSettings());
+
+	/**
+	 * Add the GPU time of a frame.
+	 *
+	 * @param frameTime The GPU frame time.
+	 * @return True if the scale was changed.
+	 */
+	bool addFrameTime(std::chrono::nanoseconds frameTime);
+
+	/**
+	 * Set the settings.
+	 * The scale is clamped to the new range.
+	 *
+	 * @param settings The settings.
+	 */
+	void setSettings(const ResolutionControllerSettings& settings);
+
+	/**
+	 * Reset the smoothed frame time.
+	 * This should be called when the frame time is expected to jump, like after a resize, so the old times don't affect the new scale.
+	 */
+	void reset();
+
+	/**
+	 * Compute the size to render at.
+	 *
+	 * @param displaySize The display width or height.
+	 * @return The size at the current scale. This is never 0.
+	 */
+	[[nodiscard]] uint32_t scaleSize(uint32_t displaySize) const;
+
+public:
+	GRAPHITE_SETUP_SIMPLE_GETTER(float, Scale, m_Scale);
+	GRAPHITE_SETUP_SIMPLE_GETTER(float, SmoothedFrameTime, m_SmoothedFrameTime);
+	[[nodiscard]] const ResolutionControllerSettings& getSettings() const { return m_Settings; }
+
+private:
+	ResolutionControllerSettings m_Settings;
+
+	float m_Scale = 1.0f;
+	float m_SmoothedFrameTime = 0.0f;	// In milliseconds.
+
+	uint32_t m_SampleCount = 0;
+	uint32_t m_SettleCount = 0;
+};
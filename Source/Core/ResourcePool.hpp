@@ -0,0 +1,256 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <utility>
+
+/**
+ * Resource handle structure.
+ * This is a 32-bit handle with a 20-bit slot index and a 12-bit generation. The generation changes every time a slot is reused, so a handle of a
+ * destroyed resource never refers to the resource which took it's place. A value of 0 is never a valid handle.
+ *
+ * @tparam Type The resource type. This makes handles of different resource types incompatible.
+ */
+template<class Type>
+struct ResourceHandle final
+{
+	static constexpr uint32_t IndexBits = 20;
+	static constexpr uint32_t GenerationBits = 32 - IndexBits;
+	static constexpr uint32_t IndexMask = (1u << IndexBits) - 1;
+	static constexpr uint32_t GenerationMask = (1u << GenerationBits) - 1;
+
+	uint32_t m_Value = 0;
+
+	/**
+	 * Create a handle from a slot index and a generation.
+	 *
+	 * @param index The slot index.
+	 * @param generation The slot generation.
+	 * @return The handle.
+	 */
+	[[nodiscard]] static constexpr ResourceHandle Create(uint32_t index, uint32_t generation) { return ResourceHandle{ (generation << IndexBits) | index }; }
+
+	/**
+	 * Get the slot index.
+	 *
+	 * @return The index.
+	 */
+	[[nodiscard]] constexpr uint32_t getIndex() const { return m_Value & IndexMask; }
+
+	/**
+	 * Get the slot generation.
+	 *
+	 * @return The generation.
+	 */
+	[[nodiscard]] constexpr uint32_t getGeneration() const { return m_Value >> IndexBits; }
+
+	/**
+	 * Check if the handle was ever assigned.
+	 * This does not tell if the resource is still alive. Use the pool for that.
+	 *
+	 * @return True if the handle is not null.
+	 */
+	[[nodiscard]] constexpr explicit operator bool() const { return m_Value != 0; }
+
+	/**
+	 * Equal to operator.
+	 *
+	 * @param other The other handle.
+	 * @return True if both handles are the same.
+	 */
+	[[nodiscard]] constexpr bool operator==(const ResourceHandle& other) const = default;
+};
+
+/**
+ * Resource pool class.
+ * This stores resources densely in a single array and hands out generational handles to them. Handles are mapped to the dense array through a
+ * sparse table, so when a resource is destroyed, the last one is moved into it's place and the array never has holes. The handles stay the same,
+ * so iterating the pool (like when generating barriers) walks contiguous memory while the handles can be stored anywhere.
+ *
+ * The pool is not thread safe.
+ *
+ * @tparam Type The resource type. This must be movable.
+ */
+template<class Type>
+class ResourcePool final
+{
+public:
+	using Handle = ResourceHandle<Type>;
+
+	static constexpr uint32_t MaximumSize = Handle::IndexMask + 1;
+
+public:
+	/**
+	 * Default constructor.
+	 */
+	ResourcePool() = default;
+
+	/**
+	 * Create a new resource.
+	 *
+	 * @tparam Arguments The constructor argument types.
+	 * @param arguments The constructor arguments.
+	 * @return The resource handle. This is null if the pool is full.
+	 */
+	template<class... Arguments>
+	[[nodiscard]] Handle create(Arguments&&... arguments)
+	{
+		uint32_t index = 0;
+		if (!m_FreeIndices.empty())
+		{
+			index = m_FreeIndices.back();
+			m_FreeIndices.pop_back();
+		}
+		else if (m_Generations.size() < MaximumSize)
+		{
+			index = static_cast<uint32_t>(m_Generations.size());
+			m_Generations.emplace_back(1);
+			m_SparseToDense.emplace_back(0);
+		}
+		else
+		{
+			return Handle();
+		}
+
+		m_SparseToDense[index] = static_cast<uint32_t>(m_Resources.size());
+		m_Resources.emplace_back(std::forward<Arguments>(arguments)...);
+		m_DenseToSparse.emplace_back(index);
+
+		return Handle::Create(index, m_Generations[index]);
+	}
+
+	/**
+	 * Destroy a resource.
+	 * Invalid handles are ignored.
+	 *
+	 * @param handle The resource handle.
+	 * @return True if the resource was destroyed.
+	 */
+	bool destroy(Handle handle)
+	{
+		if (!isValid(handle))
+			return false;
+
+		// Move the last resource into the hole, so the array stays dense.
+		const auto index = handle.getIndex();
+		const auto denseIndex = m_SparseToDense[index];
+		const auto lastIndex = static_cast<uint32_t>(m_Resources.size() - 1);
+
+		if (denseIndex != lastIndex)
+		{
+			m_Resources[denseIndex] = std::move(m_Resources[lastIndex]);
+			m_DenseToSparse[denseIndex] = m_DenseToSparse[lastIndex];
+			m_SparseToDense[m_DenseToSparse[denseIndex]] = denseIndex;
+		}
+
+		m_Resources.pop_back();
+		m_DenseToSparse.pop_back();
+
+		// Bump the generation so the old handles become invalid. Generation 0 is skipped so no handle ends up being null.
+		auto& generation = m_Generations[index];
+		generation = (generation + 1) & Handle::GenerationMask;
+		if (generation == 0)
+			generation = 1;
+
+		m_FreeIndices.emplace_back(index);
+		return true;
+	}
+
+	/**
+	 * Check if a handle refers to a live resource.
+	 *
+	 * @param handle The resource handle.
+	 * @return True if the handle is valid.
+	 */
+	[[nodiscard]] bool isValid(Handle handle) const
+	{
+		const auto index = handle.getIndex();
+		return handle && index < m_Generations.size() && m_Generations[index] == handle.getGeneration();
+	}
+
+	/**
+	 * Get a resource.
+	 *
+	 * @param handle The resource handle.
+	 * @return The resource pointer. This is null if the handle is invalid.
+	 */
+	[[nodiscard]] Type* get(Handle handle) { return isValid(handle) ? &m_Resources[m_SparseToDense[handle.getIndex()]] : nullptr; }
+
+	/**
+	 * Get a resource.
+	 *
+	 * @param handle The resource handle.
+	 * @return The resource pointer. This is null if the handle is invalid.
+	 */
+	[[nodiscard]] const Type* get(Handle handle) const { return isValid(handle) ? &m_Resources[m_SparseToDense[handle.getIndex()]] : nullptr; }
+
+	/**
+	 * Get the handle of a resource from it's position in the dense array.
+	 *
+	 * @param denseIndex The index in the dense array.
+	 * @return The resource handle.
+	 */
+	[[nodiscard]] Handle getHandle(uint32_t denseIndex) const
+	{
+		const auto index = m_DenseToSparse[denseIndex];
+		return Handle::Create(index, m_Generations[index]);
+	}
+
+	/**
+	 * Get the number of live resources.
+	 *
+	 * @return The resource count.
+	 */
+	[[nodiscard]] uint32_t getSize() const { return static_cast<uint32_t>(m_Resources.size()); }
+
+	/**
+	 * Reserve memory for a number of resources.
+	 *
+	 * @param capacity The resource count to reserve for.
+	 */
+	void reserve(uint32_t capacity)
+	{
+		m_Resources.reserve(capacity);
+		m_DenseToSparse.reserve(capacity);
+		m_SparseToDense.reserve(capacity);
+		m_Generations.reserve(capacity);
+	}
+
+	/**
+	 * Get the beginning of the dense resource array.
+	 *
+	 * @return The iterator.
+	 */
+	[[nodiscard]] decltype(auto) begin() { return m_Resources.begin(); }
+
+	/**
+	 * Get the end of the dense resource array.
+	 *
+	 * @return The iterator.
+	 */
+	[[nodiscard]] decltype(auto) end() { return m_Resources.end(); }
+
+	/**
+	 * Get the beginning of the dense resource array.
+	 *
+	 * @return The iterator.
+	 */
+	[[nodiscard]] decltype(auto) begin() const { return m_Resources.begin(); }
+
+	/**
+	 * Get the end of the dense resource array.
+	 *
+	 * @return The iterator.
+	 */
+	[[nodiscard]] decltype(auto) end() const { return m_Resources.end(); }
+
+private:
+	std::vector<Type> m_Resources;
+	std::vector<uint32_t> m_DenseToSparse;
+
+	std::vector<uint32_t> m_SparseToDense;
+	std::vector<uint16_t> m_Generations;
+	std::vector<uint32_t> m_FreeIndices;
+};
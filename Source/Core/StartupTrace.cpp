@@ -0,0 +1,84 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "StartupTrace.hpp"
+#include "Logging.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace /* anonymous */
+{
+	/**
+	 * Startup phase structure.
+	 * This contains the information of a single recorded phase.
+	 */
+	struct StartupPhase final
+	{
+		std::string_view m_Name;
+		StartupTrace::Clock::time_point m_Start;
+		StartupTrace::Clock::time_point m_End;
+		std::thread::id m_Thread;
+	};
+
+	// Static objects are initialized before main, so this is as close to the process start as we can get portably.
+	const auto g_ProcessStart = StartupTrace::Clock::now();
+	const auto g_MainThread = std::this_thread::get_id();
+
+	std::mutex g_PhaseMutex;
+	std::vector<StartupPhase> g_Phases;
+	std::atomic_bool g_IsFirstFrameMarked = false;
+
+	/**
+	 * Convert a duration to milliseconds.
+	 *
+	 * @param duration The duration to convert.
+	 * @return The duration in milliseconds.
+	 */
+	[[nodiscard]] double ToMilliseconds(StartupTrace::Clock::duration duration)
+	{
+		return std::chrono::duration<double, std::milli>(duration).count();
+	}
+}
+
+void StartupTrace::Record(std::string_view name, Clock::time_point start, Clock::time_point end)
+{
+	const auto lock = std::scoped_lock(g_PhaseMutex);
+	g_Phases.emplace_back(StartupPhase{ name, start, end, std::this_thread::get_id() });
+}
+
+void StartupTrace::MarkFirstFrame(std::chrono::milliseconds budget)
+{
+	if (g_IsFirstFrameMarked.exchange(true, std::memory_order_relaxed))
+		return;
+
+	const auto firstFrame = Clock::now();
+	const auto lock = std::scoped_lock(g_PhaseMutex);
+
+	GRAPHITE_RANGES(sort, g_Phases, [](const StartupPhase& lhs, const StartupPhase& rhs) { return lhs.m_Start < rhs.m_Start; });
+
+	// Report the phases in the order they started. Phases which did not run on the main thread ran in parallel.
+	GRAPHITE_LOG_INFORMATION("Startup phases:");
+	for (const auto& phase : g_Phases)
+	{
+		GRAPHITE_LOG_INFORMATION("  {:<32} {:>9.3f} ms (started at {:>9.3f} ms){}",
+			phase.m_Name,
+			ToMilliseconds(phase.m_End - phase.m_Start),
+			ToMilliseconds(phase.m_Start - g_ProcessStart),
+			phase.m_Thread == g_MainThread ? "" : " [worker]");
+	}
+
+	const auto timeToFirstFrame = firstFrame - g_ProcessStart;
+	if (timeToFirstFrame > budget)
+		GRAPHITE_LOG_WARNING("Time to first frame was {:.3f} ms, which is over the budget of {} ms!", ToMilliseconds(timeToFirstFrame), budget.count());
+
+	else
+		GRAPHITE_LOG_INFORMATION("Time to first frame was {:.3f} ms ({} ms budget).", ToMilliseconds(timeToFirstFrame), budget.count());
+}
+
+std::chrono::nanoseconds StartupTrace::GetTimeSinceStart()
+{
+	return Clock::now() - g_ProcessStart;
+}
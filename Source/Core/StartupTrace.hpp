@@ -0,0 +1,75 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "Common.hpp"
+
+#include <chrono>
+#include <string_view>
+
+/**
+ * Startup trace class.
+ * This records how long each initialization phase took and on which thread, so the time to the first frame can be broken down and checked
+ * against a budget. Phases can overlap when they run on different threads.
+ */
+class StartupTrace final
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	/**
+	 * Phase class.
+	 * This records a single phase from it's construction till it's destruction.
+	 */
+	class Phase final
+	{
+	public:
+		/**
+		 * Explicit constructor.
+		 *
+		 * @param name The name of the phase. This must outlive the trace, so use string literals.
+		 */
+		explicit Phase(std::string_view name) : m_Name(name), m_Start(Clock::now()) {}
+
+		/**
+		 * Destructor.
+		 */
+		~Phase() { StartupTrace::Record(m_Name, m_Start, Clock::now()); }
+
+		GRAPHITE_DISABLE_COPY_AND_MOVE(Phase);
+
+	private:
+		std::string_view m_Name;
+		Clock::time_point m_Start;
+	};
+
+public:
+	/**
+	 * Record a phase.
+	 * This is thread safe.
+	 *
+	 * @param name The name of the phase. This must outlive the trace, so use string literals.
+	 * @param start The time the phase started.
+	 * @param end The time the phase ended.
+	 */
+	static void Record(std::string_view name, Clock::time_point start, Clock::time_point end);
+
+	/**
+	 * Mark the first frame as done and report the startup phases.
+	 * Only the first call does anything, so this can be called every frame.
+	 *
+	 * @param budget The time to first frame budget. A warning is logged if the startup took longer.
+	 */
+	static void MarkFirstFrame(std::chrono::milliseconds budget);
+
+	/**
+	 * Get the time since the process started.
+	 *
+	 * @return The elapsed time.
+	 */
+	[[nodiscard]] static std::chrono::nanoseconds GetTimeSinceStart();
+};
+
+#define GRAPHITE_STARTUP_PHASE_NAME_IMPL(line)	startupPhase##line
+#define GRAPHITE_STARTUP_PHASE_NAME(line)		GRAPHITE_STARTUP_PHASE_NAME_IMPL(line)
+#define GRAPHITE_STARTUP_PHASE(name)			const auto GRAPHITE_STARTUP_PHASE_NAME(__LINE__) = StartupTrace::Phase(name)
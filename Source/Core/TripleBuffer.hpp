@@ -0,0 +1,74 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include <atomic>
+#include <array>
+#include <cstdint>
+
+/**
+ * Triple buffer class.
+ * This hands values from a single writer thread to a single reader thread without locking. The writer always has a back buffer to write to and the
+ * reader always has a front buffer to read from, and the two are swapped through a shared middle buffer. Neither side ever waits for the other.
+ *
+ * @tparam Type The value type.
+ */
+template<class Type>
+class TripleBuffer final
+{
+	static constexpr uint8_t IndexMask = 0b011;
+	static constexpr uint8_t DirtyBit = 0b100;
+
+public:
+	/**
+	 * Default constructor.
+	 */
+	TripleBuffer() = default;
+
+	/**
+	 * Get the back buffer.
+	 * Only the writer thread should access this.
+	 *
+	 * @return The back buffer reference.
+	 */
+	[[nodiscard]] Type& getBack() { return m_Buffers[m_Back]; }
+
+	/**
+	 * Publish the back buffer to the reader.
+	 * The writer gets the previous middle buffer as the new back buffer, so it's contents are stale and should be fully overwritten.
+	 */
+	void publish()
+	{
+		m_Back = m_Middle.exchange(m_Back | DirtyBit, std::memory_order_acq_rel) & IndexMask;
+	}
+
+	/**
+	 * Fetch the latest published buffer if there is one.
+	 * Only the reader thread should call this.
+	 *
+	 * @return True if a new buffer was fetched.
+	 */
+	bool fetch()
+	{
+		if ((m_Middle.load(std::memory_order_relaxed) & DirtyBit) == 0)
+			return false;
+
+		m_Front = m_Middle.exchange(m_Front, std::memory_order_acq_rel) & IndexMask;
+		return true;
+	}
+
+	/**
+	 * Get the front buffer.
+	 * Only the reader thread should access this.
+	 *
+	 * @return The front buffer reference.
+	 */
+	[[nodiscard]] const Type& getFront() const { return m_Buffers[m_Front]; }
+
+private:
+	std::array<Type, 3> m_Buffers = {};
+
+	alignas(64) std::atomic_uint8_t m_Middle = 1;
+	alignas(64) uint8_t m_Back = 0;
+	alignas(64) uint8_t m_Front = 2;
+};
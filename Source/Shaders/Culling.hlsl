@@ -0,0 +1,201 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+// Draw instance structure. This must match DrawInstance in Backend/IndirectDrawList.hpp.
+struct DrawInstance
+{
+	float4 m_BoundingSphere;	// World space center and radius.
+	uint m_IndexCount;
+	uint m_FirstIndex;
+	int m_VertexOffset;
+	uint m_Padding;
+};
+
+// Indexed indirect draw command. This matches VkDrawIndexedIndirectCommand.
+struct DrawCommand
+{
+	uint m_IndexCount;
+	uint m_InstanceCount;
+	uint m_FirstIndex;
+	int m_VertexOffset;
+	uint m_FirstInstance;
+};
+
+// The constants of the frustum culling pass, which is also the first phase of the occlusion culling.
+struct FrustumConstants
+{
+	float4 m_Planes[6];
+	uint m_InstanceCount;
+	uint m_Compact;
+	uint m_OnlyVisible;	// Only draw the instances which were visible in the last frame.
+};
+
+// The constants of the second phase of the occlusion culling.
+struct OcclusionConstants
+{
+	float4x4 m_ViewProjection;
+	float2 m_PyramidSize;
+	uint m_InstanceCount;
+	uint m_Compact;
+};
+
+#ifdef GRAPHITE_OCCLUSION_CULLING
+[[vk::push_constant]] OcclusionConstants g_Constants;
+
+#else
+[[vk::push_constant]] FrustumConstants g_Constants;
+
+#endif
+
+[[vk::binding(0, 0)]] StructuredBuffer<DrawInstance> g_Instances;
+[[vk::binding(1, 0)]] RWStructuredBuffer<DrawCommand> g_Commands;
+[[vk::binding(2, 0)]] RWStructuredBuffer<uint> g_DrawCount;
+[[vk::binding(3, 0)]] RWStructuredBuffer<uint> g_Visibility;
+
+#ifdef GRAPHITE_OCCLUSION_CULLING
+[[vk::binding(0, 1)]] Texture2D<float> g_DepthPyramid;
+
+static const float FLT_MAX = 3.402823466e+38f;
+
+#endif
+
+void WriteCommand(uint index, DrawInstance instance, bool visible)
+{
+	// The first instance is the instance index, so the vertex shader can fetch it's data with the base instance.
+	DrawCommand command;
+	command.m_IndexCount = instance.m_IndexCount;
+	command.m_InstanceCount = 1;
+	command.m_FirstIndex = instance.m_FirstIndex;
+	command.m_VertexOffset = instance.m_VertexOffset;
+	command.m_FirstInstance = index;
+
+	if (g_Constants.m_Compact != 0)
+	{
+		// Append the visible instances to the end of the command buffer.
+		if (visible)
+		{
+			uint slot;
+			InterlockedAdd(g_DrawCount[0], 1, slot);
+			g_Commands[slot] = command;
+		}
+	}
+	else
+	{
+		// Without the draw count, every instance keeps it's slot and the culled ones draw nothing.
+		command.m_InstanceCount = visible ? 1 : 0;
+		g_Commands[index] = command;
+	}
+}
+
+#ifdef GRAPHITE_OCCLUSION_CULLING
+// Test the sphere's bounding box against the frustum and the depth pyramid. The frustum is tested in clip space, where a box is outside when all
+// of it's corners are outside the same plane, so the boxes behind the camera are rejected too. The box which passes is projected to the screen, and
+// it's nearest depth is compared with the farthest depth of the pyramid texels it covers.
+bool IsVisible(float4 sphere)
+{
+	float4 clips[8];
+	uint outside = 0x3f;
+	bool crossesNear = false;
+
+	[unroll]
+	for (uint i = 0; i < 8; i++)
+	{
+		const float3 corner = sphere.xyz + sphere.w * float3((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f);
+		const float4 clip = mul(g_Constants.m_ViewProjection, float4(corner, 1.0f));
+
+		// The planes are left, right, bottom, top, near and far, with the depth in [0, w].
+		uint planes = 0;
+		planes |= clip.x < -clip.w ? 0x01 : 0;
+		planes |= clip.x > clip.w ? 0x02 : 0;
+		planes |= clip.y < -clip.w ? 0x04 : 0;
+		planes |= clip.y > clip.w ? 0x08 : 0;
+		planes |= clip.z < 0.0f ? 0x10 : 0;
+		planes |= clip.z > clip.w ? 0x20 : 0;
+
+		outside &= planes;
+		crossesNear = crossesNear || clip.w <= 0.0f;
+		clips[i] = clip;
+	}
+
+	// Frustum test.
+	if (outside != 0)
+		return false;
+
+	// The box crosses the camera plane, so it can't be projected and can't be occluded.
+	if (crossesNear)
+		return true;
+
+	float3 minimum = float3(FLT_MAX, FLT_MAX, FLT_MAX);
+	float3 maximum = float3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+	[unroll]
+	for (uint j = 0; j < 8; j++)
+	{
+		const float3 ndc = clips[j].xyz / clips[j].w;
+		minimum = min(minimum, ndc);
+		maximum = max(maximum, ndc);
+	}
+
+	// Select the mip where the box covers at most 2x2 texels.
+	const float4 uv = saturate(float4(minimum.xy, maximum.xy) * 0.5f + 0.5f);
+	const float2 size = (uv.zw - uv.xy) * g_Constants.m_PyramidSize;
+	const float level = ceil(log2(max(max(size.x, size.y), 1.0f)));
+
+	uint width, height, levels;
+	g_DepthPyramid.GetDimensions(0, width, height, levels);
+
+	const uint mip = min((uint)level, levels - 1);
+	const uint2 mipSize = max(uint2(width, height) >> mip, uint2(1, 1));
+	const uint2 first = min(uint2(uv.xy * mipSize), mipSize - 1);
+	const uint2 last = min(uint2(uv.zw * mipSize), mipSize - 1);
+
+	float depth = 0.0f;
+	depth = max(depth, g_DepthPyramid.Load(int3(first.x, first.y, mip)));
+	depth = max(depth, g_DepthPyramid.Load(int3(last.x, first.y, mip)));
+	depth = max(depth, g_DepthPyramid.Load(int3(first.x, last.y, mip)));
+	depth = max(depth, g_DepthPyramid.Load(int3(last.x, last.y, mip)));
+
+	return minimum.z <= depth;
+}
+
+[numthreads(64, 1, 1)]
+void main(uint3 threadID : SV_DispatchThreadID)
+{
+	const uint index = threadID.x;
+	if (index >= g_Constants.m_InstanceCount)
+		return;
+
+	const DrawInstance instance = g_Instances[index];
+	const bool visible = IsVisible(instance.m_BoundingSphere);
+
+	// The instances which were visible in the last frame are already drawn by the first phase.
+	WriteCommand(index, instance, visible && g_Visibility[index] == 0);
+	g_Visibility[index] = visible ? 1 : 0;
+}
+
+#else
+bool IsVisible(float4 sphere)
+{
+	[unroll]
+	for (uint i = 0; i < 6; i++)
+	{
+		if (dot(g_Constants.m_Planes[i].xyz, sphere.xyz) + g_Constants.m_Planes[i].w < -sphere.w)
+			return false;
+	}
+
+	return true;
+}
+
+[numthreads(64, 1, 1)]
+void main(uint3 threadID : SV_DispatchThreadID)
+{
+	const uint index = threadID.x;
+	if (index >= g_Constants.m_InstanceCount)
+		return;
+
+	const DrawInstance instance = g_Instances[index];
+	const bool visible = (g_Constants.m_OnlyVisible == 0 || g_Visibility[index] != 0) && IsVisible(instance.m_BoundingSphere);
+
+	WriteCommand(index, instance, visible);
+}
+
+#endif
@@ -0,0 +1,34 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+struct ReductionConstants
+{
+	uint2 m_SourceSize;
+	uint2 m_DestinationSize;
+};
+
+[[vk::push_constant]] ReductionConstants g_Constants;
+
+[[vk::binding(0, 0)]] Texture2D<float> g_Source;
+[[vk::binding(1, 0)]] RWTexture2D<float> g_Destination;
+
+// Each texel stores the farthest depth of the source texels it covers. The sizes are not always halved exactly, so a texel can cover up to 3x3
+// source texels, and all of them are read so nothing is missed.
+[numthreads(8, 8, 1)]
+void main(uint3 threadID : SV_DispatchThreadID)
+{
+	const uint2 position = threadID.xy;
+	if (any(position >= g_Constants.m_DestinationSize))
+		return;
+
+	const uint2 first = (position * g_Constants.m_SourceSize) / g_Constants.m_DestinationSize;
+	const uint2 last = min(((position + 1) * g_Constants.m_SourceSize + g_Constants.m_DestinationSize - 1) / g_Constants.m_DestinationSize, g_Constants.m_SourceSize);
+
+	float depth = 0.0f;
+	for (uint y = first.y; y < last.y; y++)
+	{
+		for (uint x = first.x; x < last.x; x++)
+			depth = max(depth, g_Source.Load(int3(x, y, 0)));
+	}
+
+	g_Destination[position] = depth;
+}
@@ -0,0 +1,55 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+// The particle vertex and fragment shaders. GRAPHITE_PARTICLE_VERTEX or GRAPHITE_PARTICLE_FRAGMENT selects the stage.
+// Every particle is drawn as an instance of a camera facing quad, so the draw has 6 vertices and no vertex buffers.
+
+// Render particle structure. This must match Shaders/Particles.hlsl.
+struct RenderParticle
+{
+	float3 m_Position;
+	float m_Size;
+	float4 m_Color;
+};
+
+struct RenderConstants
+{
+	float4x4 m_ViewProjection;
+	float4 m_CameraRight;
+	float4 m_CameraUp;
+};
+
+struct VertexOutput
+{
+	float4 m_Position : SV_POSITION;
+	float4 m_Color : COLOR0;
+	float2 m_UV : TEXCOORD0;
+};
+
+#ifdef GRAPHITE_PARTICLE_VERTEX
+[[vk::push_constant]] RenderConstants g_Constants;
+[[vk::binding(0, 0)]] StructuredBuffer<RenderParticle> g_RenderParticles;
+
+static const float2 g_Corners[6] = { float2(-1, -1), float2(1, -1), float2(1, 1), float2(-1, -1), float2(1, 1), float2(-1, 1) };
+
+VertexOutput main(uint vertexID : SV_VertexID, uint instanceID : SV_InstanceID)
+{
+	const RenderParticle particle = g_RenderParticles[instanceID];
+	const float2 corner = g_Corners[vertexID];
+	const float3 position = particle.m_Position + (g_Constants.m_CameraRight.xyz * corner.x + g_Constants.m_CameraUp.xyz * corner.y) * particle.m_Size * 0.5f;
+
+	VertexOutput output;
+	output.m_Position = mul(g_Constants.m_ViewProjection, float4(position, 1.0f));
+	output.m_Color = particle.m_Color;
+	output.m_UV = corner;
+	return output;
+}
+
+#elif defined(GRAPHITE_PARTICLE_FRAGMENT)
+float4 main(VertexOutput input) : SV_TARGET
+{
+	// Fade the quad into a soft disc.
+	const float falloff = saturate(1.0f - dot(input.m_UV, input.m_UV));
+	return float4(input.m_Color.rgb, input.m_Color.a * falloff * falloff);
+}
+
+#endif
@@ -0,0 +1,380 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+// The particle passes are all in this file, and each is compiled with it's own define. They must match the passes in Backend/ParticleSystem.cpp.
+//
+// GRAPHITE_PARTICLE_INITIALIZE		Put every particle in the dead list.
+// GRAPHITE_PARTICLE_EMIT			Take particles from the dead list and append them to the current alive list.
+// GRAPHITE_PARTICLE_PREPARE		Write the simulation dispatch size and clear the next alive list.
+// GRAPHITE_PARTICLE_SIMULATE		Age and move the particles. The dead ones go back to the dead list and the rest are compacted into the next alive list.
+// GRAPHITE_PARTICLE_FINISH			Write the sort and write dispatch sizes and the draw command.
+// GRAPHITE_PARTICLE_SORT_LOCAL		Sort the blocks of the sort list which fit in the group shared memory.
+// GRAPHITE_PARTICLE_MERGE_GLOBAL	A bitonic merge step whose pairs are too far apart for the group shared memory.
+// GRAPHITE_PARTICLE_MERGE_LOCAL	The rest of the bitonic merge steps in the group shared memory.
+// GRAPHITE_PARTICLE_WRITE			Write the render data of the alive particles in the sorted order.
+
+// Particle structure. This is only used by the compute passes.
+struct Particle
+{
+	float3 m_Position;
+	float m_Age;
+	float3 m_Velocity;
+	float m_Lifetime;
+	uint m_StartColor;	// RGBA8.
+	uint m_EndColor;	// RGBA8.
+	float m_StartSize;
+	float m_EndSize;
+};
+
+// Render particle structure. This must match Shaders/ParticleRender.hlsl.
+struct RenderParticle
+{
+	float3 m_Position;
+	float m_Size;
+	float4 m_Color;
+};
+
+// Non-indexed indirect draw command. This matches VkDrawIndirectCommand.
+struct DrawCommand
+{
+	uint m_VertexCount;
+	uint m_InstanceCount;
+	uint m_FirstVertex;
+	uint m_FirstInstance;
+};
+
+// The emitter constants.
+struct EmitConstants
+{
+	float4 m_PositionRadius;
+	float4 m_VelocitySpread;
+	float4 m_StartColor;
+	float4 m_EndColor;
+	float2 m_Lifetime;	// Minimum and maximum.
+	float2 m_Size;		// Start and end.
+	uint m_EmitCount;
+	uint m_Seed;
+	uint m_AliveIndex;
+	uint m_MaximumParticles;
+};
+
+// The constants of the other passes, except the sorting.
+struct FrameConstants
+{
+	float4 m_CameraPosition;
+	float4 m_CameraForward;
+	float3 m_Gravity;
+	float m_Drag;
+	float m_DeltaTime;
+	uint m_AliveIndex;	// The alive list the particles are read from. The survivors are written to the other one.
+	uint m_MaximumParticles;
+	uint m_Padding;
+};
+
+// The constants of the bitonic merge steps.
+struct SortConstants
+{
+	uint m_BlockSize;	// The size of the sequences which are merged.
+	uint m_Distance;	// The distance between the compared elements.
+};
+
+#if defined(GRAPHITE_PARTICLE_EMIT)
+[[vk::push_constant]] EmitConstants g_Constants;
+
+#elif defined(GRAPHITE_PARTICLE_MERGE_GLOBAL) || defined(GRAPHITE_PARTICLE_MERGE_LOCAL)
+[[vk::push_constant]] SortConstants g_Constants;
+
+#else
+[[vk::push_constant]] FrameConstants g_Constants;
+
+#endif
+
+[[vk::binding(0, 0)]] RWStructuredBuffer<Particle> g_Particles;
+[[vk::binding(1, 0)]] RWStructuredBuffer<uint> g_DeadList;
+[[vk::binding(2, 0)]] RWStructuredBuffer<uint> g_AliveLists;		// Two lists of the maximum particle count, one after the other.
+[[vk::binding(3, 0)]] RWStructuredBuffer<uint2> g_SortList;		// The sort key and the particle index.
+[[vk::binding(4, 0)]] RWByteAddressBuffer g_State;
+[[vk::binding(5, 0)]] RWStructuredBuffer<RenderParticle> g_RenderParticles;
+[[vk::binding(6, 0)]] RWStructuredBuffer<DrawCommand> g_DrawCommand;
+
+// The layout of the state buffer. This must match the offsets in Backend/ParticleSystem.cpp.
+static const uint g_DeadCountOffset = 0;
+static const uint g_AliveCountOffset = 4;			// One count for each alive list.
+static const uint g_SortCountOffset = 12;
+static const uint g_SimulateArgumentsOffset = 16;
+static const uint g_SortArgumentsOffset = 32;
+static const uint g_MergeArgumentsOffset = 48;
+static const uint g_WriteArgumentsOffset = 64;
+
+// The number of elements a group sorts in the group shared memory. Each thread handles two of them.
+static const uint g_SortBlockSize = 1024;
+static const uint g_MergeGroupSize = 256;
+static const uint g_PaddingKey = 0xFFFFFFFF;
+
+// PCG hash, used as the random number generator.
+uint Hash(uint value)
+{
+	const uint state = value * 747796405u + 2891336453u;
+	const uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+	return (word >> 22u) ^ word;
+}
+
+// A random number in [0, 1). The seed is advanced.
+float Random(inout uint seed)
+{
+	seed = Hash(seed);
+	return float(seed >> 8) / 16777216.0f;
+}
+
+// A random point in the unit sphere.
+float3 RandomInSphere(inout uint seed)
+{
+	const float z = Random(seed) * 2.0f - 1.0f;
+	const float angle = Random(seed) * 6.28318530718f;
+	const float radius = sqrt(max(1.0f - z * z, 0.0f));
+	return float3(radius * cos(angle), radius * sin(angle), z) * pow(Random(seed), 1.0f / 3.0f);
+}
+
+uint PackColor(float4 color)
+{
+	const uint4 bytes = uint4(round(saturate(color) * 255.0f));
+	return bytes.r | (bytes.g << 8) | (bytes.b << 16) | (bytes.a << 24);
+}
+
+float4 UnpackColor(uint color)
+{
+	return float4(color & 0xFF, (color >> 8) & 0xFF, (color >> 16) & 0xFF, color >> 24) / 255.0f;
+}
+
+// Turn the view depth into a key which sorts the particles from back to front. Flipping the bits of a non negative float, and all the bits of a
+// negative one, gives an integer with the same order, and inverting that makes the farthest particle the smallest.
+uint GetSortKey(float depth)
+{
+	const uint bits = asuint(depth);
+	const uint ordered = (bits & 0x80000000) != 0 ? ~bits : bits | 0x80000000;
+	return min(~ordered, g_PaddingKey - 1);
+}
+
+// Compare two entries of a bitonic sequence and swap them if they're not in the given order.
+void CompareAndSwap(inout uint2 lhs, inout uint2 rhs, bool bAscending)
+{
+	if ((lhs.x > rhs.x) == bAscending)
+	{
+		const uint2 temporary = lhs;
+		lhs = rhs;
+		rhs = temporary;
+	}
+}
+
+#if defined(GRAPHITE_PARTICLE_INITIALIZE)
+[numthreads(64, 1, 1)]
+void main(uint3 threadID : SV_DispatchThreadID)
+{
+	const uint index = threadID.x;
+	if (index == 0)
+	{
+		g_State.Store(g_DeadCountOffset, g_Constants.m_MaximumParticles);
+		g_State.Store2(g_AliveCountOffset, uint2(0, 0));
+	}
+
+	if (index < g_Constants.m_MaximumParticles)
+		g_DeadList[index] = index;
+}
+
+#elif defined(GRAPHITE_PARTICLE_EMIT)
+[numthreads(64, 1, 1)]
+void main(uint3 threadID : SV_DispatchThreadID)
+{
+	if (threadID.x >= g_Constants.m_EmitCount)
+		return;
+
+	// Take a dead particle. If there are none left, the count goes below 0 for a moment and is put back, so the emission stops once the pool is empty.
+	uint previous;
+	g_State.InterlockedAdd(g_DeadCountOffset, uint(-1), previous);
+	if (int(previous) <= 0)
+	{
+		g_State.InterlockedAdd(g_DeadCountOffset, 1);
+		return;
+	}
+
+	const uint index = g_DeadList[previous - 1];
+	uint seed = Hash(g_Constants.m_Seed ^ Hash(threadID.x));
+
+	Particle particle;
+	particle.m_Position = g_Constants.m_PositionRadius.xyz + RandomInSphere(seed) * g_Constants.m_PositionRadius.w;
+	particle.m_Age = 0.0f;
+	particle.m_Velocity = g_Constants.m_VelocitySpread.xyz + RandomInSphere(seed) * g_Constants.m_VelocitySpread.w;
+	particle.m_Lifetime = lerp(g_Constants.m_Lifetime.x, g_Constants.m_Lifetime.y, Random(seed));
+	particle.m_StartColor = PackColor(g_Constants.m_StartColor);
+	particle.m_EndColor = PackColor(g_Constants.m_EndColor);
+	particle.m_StartSize = g_Constants.m_Size.x;
+	particle.m_EndSize = g_Constants.m_Size.y;
+	g_Particles[index] = particle;
+
+	uint slot;
+	g_State.InterlockedAdd(g_AliveCountOffset + g_Constants.m_AliveIndex * 4, 1, slot);
+	g_AliveLists[g_Constants.m_AliveIndex * g_Constants.m_MaximumParticles + slot] = index;
+}
+
+#elif defined(GRAPHITE_PARTICLE_PREPARE)
+[numthreads(1, 1, 1)]
+void main()
+{
+	const uint aliveCount = g_State.Load(g_AliveCountOffset + g_Constants.m_AliveIndex * 4);
+	g_State.Store3(g_SimulateArgumentsOffset, uint3((aliveCount + 63) / 64, 1, 1));
+	g_State.Store(g_AliveCountOffset + (1 - g_Constants.m_AliveIndex) * 4, 0);
+}
+
+#elif defined(GRAPHITE_PARTICLE_SIMULATE)
+[numthreads(64, 1, 1)]
+void main(uint3 threadID : SV_DispatchThreadID)
+{
+	const uint aliveCount = g_State.Load(g_AliveCountOffset + g_Constants.m_AliveIndex * 4);
+	if (threadID.x >= aliveCount)
+		return;
+
+	const uint index = g_AliveLists[g_Constants.m_AliveIndex * g_Constants.m_MaximumParticles + threadID.x];
+	Particle particle = g_Particles[index];
+
+	particle.m_Age += g_Constants.m_DeltaTime;
+	if (particle.m_Age >= particle.m_Lifetime)
+	{
+		uint deadSlot;
+		g_State.InterlockedAdd(g_DeadCountOffset, 1, deadSlot);
+		g_DeadList[deadSlot] = index;
+		return;
+	}
+
+	particle.m_Velocity += g_Constants.m_Gravity * g_Constants.m_DeltaTime;
+	particle.m_Velocity *= max(1.0f - g_Constants.m_Drag * g_Constants.m_DeltaTime, 0.0f);
+	particle.m_Position += particle.m_Velocity * g_Constants.m_DeltaTime;
+	g_Particles[index] = particle;
+
+	// Compact the survivors into the next list. The sort list gets the same order, so it's already filled if the sorting is disabled.
+	const uint nextIndex = 1 - g_Constants.m_AliveIndex;
+
+	uint slot;
+	g_State.InterlockedAdd(g_AliveCountOffset + nextIndex * 4, 1, slot);
+	g_AliveLists[nextIndex * g_Constants.m_MaximumParticles + slot] = index;
+
+	const float depth = dot(particle.m_Position - g_Constants.m_CameraPosition.xyz, g_Constants.m_CameraForward.xyz);
+	g_SortList[slot] = uint2(GetSortKey(depth), index);
+}
+
+#elif defined(GRAPHITE_PARTICLE_FINISH)
+[numthreads(1, 1, 1)]
+void main()
+{
+	const uint aliveCount = g_State.Load(g_AliveCountOffset + (1 - g_Constants.m_AliveIndex) * 4);
+
+	// The bitonic sort needs a power of two, and at least one whole block.
+	uint sortCount = g_SortBlockSize;
+	while (sortCount < aliveCount)
+		sortCount *= 2;
+
+	g_State.Store(g_SortCountOffset, sortCount);
+	g_State.Store3(g_SortArgumentsOffset, uint3(sortCount / g_SortBlockSize, 1, 1));
+	g_State.Store3(g_MergeArgumentsOffset, uint3(sortCount / 2 / g_MergeGroupSize, 1, 1));
+	g_State.Store3(g_WriteArgumentsOffset, uint3((aliveCount + 63) / 64, 1, 1));
+
+	// Every particle is an instance of a quad made of two triangles.
+	DrawCommand command;
+	command.m_VertexCount = 6;
+	command.m_InstanceCount = aliveCount;
+	command.m_FirstVertex = 0;
+	command.m_FirstInstance = 0;
+	g_DrawCommand[0] = command;
+}
+
+#elif defined(GRAPHITE_PARTICLE_SORT_LOCAL) || defined(GRAPHITE_PARTICLE_MERGE_LOCAL)
+groupshared uint2 g_Block[g_SortBlockSize];
+
+[numthreads(g_SortBlockSize / 2, 1, 1)]
+void main(uint3 groupID : SV_GroupID, uint3 localID : SV_GroupThreadID)
+{
+	const uint first = groupID.x * g_SortBlockSize;
+	const uint thread = localID.x;
+
+#ifdef GRAPHITE_PARTICLE_SORT_LOCAL
+	// The entries past the alive particles are filled with the padding, which sorts to the end.
+	const uint aliveCount = g_State.Load(g_AliveCountOffset + (1 - g_Constants.m_AliveIndex) * 4);
+	const uint sortCount = g_State.Load(g_SortCountOffset);
+	if (first >= sortCount)
+		return;
+
+	g_Block[thread] = first + thread < aliveCount ? g_SortList[first + thread] : uint2(g_PaddingKey, 0);
+	g_Block[thread + g_SortBlockSize / 2] = first + thread + g_SortBlockSize / 2 < aliveCount ? g_SortList[first + thread + g_SortBlockSize / 2] : uint2(g_PaddingKey, 0);
+	GroupMemoryBarrierWithGroupSync();
+
+	for (uint blockSize = 2; blockSize <= g_SortBlockSize; blockSize *= 2)
+	{
+		for (uint distance = blockSize / 2; distance > 0; distance /= 2)
+		{
+			const uint lhs = 2 * distance * (thread / distance) + thread % distance;
+			const bool bAscending = ((first + lhs) & blockSize) == 0;
+			CompareAndSwap(g_Block[lhs], g_Block[lhs + distance], bAscending);
+			GroupMemoryBarrierWithGroupSync();
+		}
+	}
+
+#else
+	const uint sortCount = g_State.Load(g_SortCountOffset);
+	if (first >= sortCount)
+		return;
+
+	g_Block[thread] = g_SortList[first + thread];
+	g_Block[thread + g_SortBlockSize / 2] = g_SortList[first + thread + g_SortBlockSize / 2];
+	GroupMemoryBarrierWithGroupSync();
+
+	for (uint distance = g_SortBlockSize / 2; distance > 0; distance /= 2)
+	{
+		const uint lhs = 2 * distance * (thread / distance) + thread % distance;
+		const bool bAscending = ((first + lhs) & g_Constants.m_BlockSize) == 0;
+		CompareAndSwap(g_Block[lhs], g_Block[lhs + distance], bAscending);
+		GroupMemoryBarrierWithGroupSync();
+	}
+
+#endif
+
+	g_SortList[first + thread] = g_Block[thread];
+	g_SortList[first + thread + g_SortBlockSize / 2] = g_Block[thread + g_SortBlockSize / 2];
+}
+
+#elif defined(GRAPHITE_PARTICLE_MERGE_GLOBAL)
+[numthreads(g_MergeGroupSize, 1, 1)]
+void main(uint3 threadID : SV_DispatchThreadID)
+{
+	// The steps are recorded for the largest sort count, so the ones of larger blocks than this frame's sort count do nothing.
+	const uint sortCount = g_State.Load(g_SortCountOffset);
+	const uint distance = g_Constants.m_Distance;
+	const uint lhs = 2 * distance * (threadID.x / distance) + threadID.x % distance;
+	const uint rhs = lhs + distance;
+	if (rhs >= sortCount)
+		return;
+
+	uint2 lhsEntry = g_SortList[lhs];
+	uint2 rhsEntry = g_SortList[rhs];
+	CompareAndSwap(lhsEntry, rhsEntry, (lhs & g_Constants.m_BlockSize) == 0);
+
+	g_SortList[lhs] = lhsEntry;
+	g_SortList[rhs] = rhsEntry;
+}
+
+#elif defined(GRAPHITE_PARTICLE_WRITE)
+[numthreads(64, 1, 1)]
+void main(uint3 threadID : SV_DispatchThreadID)
+{
+	const uint aliveCount = g_State.Load(g_AliveCountOffset + (1 - g_Constants.m_AliveIndex) * 4);
+	if (threadID.x >= aliveCount)
+		return;
+
+	const Particle particle = g_Particles[g_SortList[threadID.x].y];
+	const float progress = saturate(particle.m_Age / particle.m_Lifetime);
+
+	RenderParticle renderParticle;
+	renderParticle.m_Position = particle.m_Position;
+	renderParticle.m_Size = lerp(particle.m_StartSize, particle.m_EndSize, progress);
+	renderParticle.m_Color = lerp(UnpackColor(particle.m_StartColor), UnpackColor(particle.m_EndColor), progress);
+	g_RenderParticles[threadID.x] = renderParticle;
+}
+
+#endif
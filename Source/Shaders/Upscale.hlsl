@@ -0,0 +1,62 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+struct UpscaleConstants
+{
+	float2 m_SourceScale;	// The source texels per output texel.
+	uint2 m_SourceSize;		// The rendered part of the source, which can be smaller than the source image.
+	uint2 m_OutputSize;
+	float m_Sharpness;
+	uint m_Padding;
+};
+
+[[vk::push_constant]] UpscaleConstants g_Constants;
+
+[[vk::binding(0, 0)]] Texture2D<float4> g_Source;
+[[vk::binding(1, 0)]] [[vk::image_format("rgba16f")]] RWTexture2D<float4> g_Output;
+
+// Load a source texel, clamped to the rendered area so the unused part of the source is never read.
+float4 LoadSource(int2 position)
+{
+	return g_Source.Load(int3(clamp(position, int2(0, 0), int2(g_Constants.m_SourceSize) - 1), 0));
+}
+
+// The color is filtered bilinearly, and then sharpened against the four neighbours of the nearest source texel. The sharpening is limited by the
+// local contrast like AMD's contrast adaptive sharpening, so edges which already have a high contrast don't ring, and flat areas are not boosted.
+[numthreads(8, 8, 1)]
+void main(uint3 threadID : SV_DispatchThreadID)
+{
+	const uint2 position = threadID.xy;
+	if (any(position >= g_Constants.m_OutputSize))
+		return;
+
+	const float2 sourcePosition = (float2(position) + 0.5f) * g_Constants.m_SourceScale - 0.5f;
+	const int2 base = int2(floor(sourcePosition));
+	const float2 weight = sourcePosition - float2(base);
+
+	const float4 color = lerp(
+		lerp(LoadSource(base), LoadSource(base + int2(1, 0)), weight.x),
+		lerp(LoadSource(base + int2(0, 1)), LoadSource(base + int2(1, 1)), weight.x),
+		weight.y);
+
+	if (g_Constants.m_Sharpness <= 0.0f)
+	{
+		g_Output[position] = color;
+		return;
+	}
+
+	const int2 nearest = int2(round(sourcePosition));
+	const float3 north = LoadSource(nearest + int2(0, -1)).rgb;
+	const float3 south = LoadSource(nearest + int2(0, 1)).rgb;
+	const float3 west = LoadSource(nearest + int2(-1, 0)).rgb;
+	const float3 east = LoadSource(nearest + int2(1, 0)).rgb;
+
+	const float3 minimum = min(color.rgb, min(min(north, south), min(west, east)));
+	const float3 maximum = max(color.rgb, max(max(north, south), max(west, east)));
+
+	// The amplitude is 1 where the neighbourhood has room to be sharpened in both directions, and 0 where it spans the whole range.
+	const float3 amplitude = sqrt(saturate(min(minimum, 1.0f - maximum) / max(maximum, 1e-5f)));
+	const float3 lobe = -amplitude * lerp(0.125f, 0.2f, saturate(g_Constants.m_Sharpness));
+
+	const float3 sharpened = (color.rgb + (north + south + west + east) * lobe) / (1.0f + 4.0f * lobe);
+	g_Output[position] = float4(max(sharpened, 0.0f), color.a);
+}
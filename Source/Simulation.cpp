@@ -0,0 +1,190 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "Simulation.hpp"
+
+#include "Core/AllocationTracker.hpp"
+
+#include <SDL3/SDL_scancode.h>
+
+#include <optick.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace /* anonymous */
+{
+	constexpr float g_CameraSpeed = 5.0f;
+	constexpr float g_CameraSensitivity = 0.0025f;
+
+	// The maximum time the simulation is allowed to catch up in one go. This prevents the spiral of death after a long stall.
+	constexpr auto g_MaximumCatchUp = std::chrono::milliseconds(250);
+
+	/**
+	 * Linearly interpolate between two values.
+	 *
+	 * @param from The value to interpolate from.
+	 * @param to The value to interpolate to.
+	 * @param alpha The interpolation factor.
+	 * @return The interpolated value.
+	 */
+	[[nodiscard]] constexpr float Lerp(float from, float to, float alpha) { return from + (to - from) * alpha; }
+}
+
+Simulation::Simulation(std::chrono::nanoseconds timestep)
+	: m_Timestep(timestep)
+{
+	m_EventDispatcher.subscribe<&Simulation::onKey>(EventType::KeyDown, this);
+	m_EventDispatcher.subscribe<&Simulation::onKey>(EventType::KeyUp, this);
+	m_EventDispatcher.subscribe<&Simulation::onMouseMotion>(EventType::MouseMotion, this);
+
+	m_Worker = std::jthread([this](std::stop_token token) { worker(std::move(token)); });
+}
+
+Simulation::~Simulation()
+{
+	m_Worker.request_stop();
+
+	if (m_Worker.joinable())
+		m_Worker.join();
+}
+
+SimulationState Simulation::getInterpolatedState(std::chrono::steady_clock::time_point time)
+{
+	m_Snapshots.fetch();
+
+	// The renderer is one step behind the simulation, so the time since the last step tells us how far to go from the previous to the current state.
+	const auto& snapshot = m_Snapshots.getFront();
+	const auto elapsed = std::chrono::duration<float>(time - snapshot.m_Timestamp) / std::chrono::duration<float>(m_Timestep);
+
+	return Interpolate(snapshot.m_Previous, snapshot.m_Current, std::clamp(elapsed, 0.0f, 1.0f));
+}
+
+SimulationState Simulation::Interpolate(const SimulationState& previous, const SimulationState& current, float alpha)
+{
+	SimulationState state = current;
+	for (size_t i = 0; i < state.m_Camera.m_Position.size(); i++)
+		state.m_Camera.m_Position[i] = Lerp(previous.m_Camera.m_Position[i], current.m_Camera.m_Position[i], alpha);
+
+	state.m_Camera.m_Yaw = Lerp(previous.m_Camera.m_Yaw, current.m_Camera.m_Yaw, alpha);
+	state.m_Camera.m_Pitch = Lerp(previous.m_Camera.m_Pitch, current.m_Camera.m_Pitch, alpha);
+	state.m_Time = previous.m_Time + (current.m_Time - previous.m_Time) * alpha;
+
+	return state;
+}
+
+void Simulation::worker(std::stop_token token)
+{
+	OPTICK_THREAD("Simulation");
+	const auto tag = AllocationTracker::Scope(AllocationTag::Simulation);
+
+	SimulationState previous;
+	SimulationState current;
+
+	auto lastTime = std::chrono::steady_clock::now();
+	auto accumulator = std::chrono::nanoseconds(0);
+
+	while (!token.stop_requested())
+	{
+		const auto currentTime = std::chrono::steady_clock::now();
+		accumulator += std::min(std::chrono::duration_cast<std::chrono::nanoseconds>(currentTime - lastTime), std::chrono::nanoseconds(g_MaximumCatchUp));
+		lastTime = currentTime;
+
+		// Run the fixed steps we owe.
+		bool stepped = false;
+		while (accumulator >= m_Timestep)
+		{
+			OPTICK_EVENT("Simulation Step");
+
+			m_EventDispatcher.dispatch(m_EventQueue);
+
+			previous = current;
+			step(current);
+
+			accumulator -= m_Timestep;
+			stepped = true;
+		}
+
+		// Publish the latest two steps.
+		if (stepped)
+		{
+			auto& snapshot = m_Snapshots.getBack();
+			snapshot.m_Previous = previous;
+			snapshot.m_Current = current;
+			snapshot.m_Timestamp = currentTime - accumulator;
+
+			m_Snapshots.publish();
+		}
+
+		// Sleep till the next step is due.
+		std::this_thread::sleep_until(currentTime + (m_Timestep - accumulator));
+	}
+}
+
+void Simulation::step(SimulationState& state)
+{
+	const auto deltaTime = std::chrono::duration<float>(m_Timestep).count();
+	auto& camera = state.m_Camera;
+
+	camera.m_Yaw += m_YawDelta;
+	camera.m_Pitch = std::clamp(camera.m_Pitch + m_PitchDelta, -1.55f, 1.55f);
+
+	m_YawDelta = 0.0f;
+	m_PitchDelta = 0.0f;
+
+	// Move the camera relative to where it's looking.
+	const float sinYaw = std::sin(camera.m_Yaw);
+	const float cosYaw = std::cos(camera.m_Yaw);
+
+	camera.m_Velocity[0] = (m_MoveDirection[0] * cosYaw - m_MoveDirection[2] * sinYaw) * g_CameraSpeed;
+	camera.m_Velocity[1] = m_MoveDirection[1] * g_CameraSpeed;
+	camera.m_Velocity[2] = (m_MoveDirection[0] * sinYaw + m_MoveDirection[2] * cosYaw) * g_CameraSpeed;
+
+	for (size_t i = 0; i < camera.m_Position.size(); i++)
+		camera.m_Position[i] += camera.m_Velocity[i] * deltaTime;
+
+	state.m_Step++;
+	state.m_Time += deltaTime;
+}
+
+void Simulation::onKey(const Event& event)
+{
+	if (event.m_Key.m_bIsRepeat)
+		return;
+
+	const float value = event.m_Type == EventType::KeyDown ? 1.0f : -1.0f;
+	switch (event.m_Key.m_ScanCode)
+	{
+	case SDL_SCANCODE_W:
+		m_MoveDirection[2] += value;
+		break;
+
+	case SDL_SCANCODE_S:
+		m_MoveDirection[2] -= value;
+		break;
+
+	case SDL_SCANCODE_D:
+		m_MoveDirection[0] += value;
+		break;
+
+	case SDL_SCANCODE_A:
+		m_MoveDirection[0] -= value;
+		break;
+
+	case SDL_SCANCODE_E:
+		m_MoveDirection[1] += value;
+		break;
+
+	case SDL_SCANCODE_Q:
+		m_MoveDirection[1] -= value;
+		break;
+
+	default:
+		break;
+	}
+}
+
+void Simulation::onMouseMotion(const Event& event)
+{
+	m_YawDelta += event.m_MouseMotion.m_DeltaX * g_CameraSensitivity;
+	m_PitchDelta += event.m_MouseMotion.m_DeltaY * g_CameraSensitivity;
+}
@@ -0,0 +1,138 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "Core/Common.hpp"
+#include "Core/EventDispatcher.hpp"
+#include "Core/TripleBuffer.hpp"
+
+#include <array>
+#include <chrono>
+#include <thread>
+
+/**
+ * Camera state structure.
+ */
+struct CameraState final
+{
+	std::array<float, 3> m_Position = { 0.0f, 0.0f, 0.0f };
+	std::array<float, 3> m_Velocity = { 0.0f, 0.0f, 0.0f };
+
+	float m_Yaw = 0.0f;
+	float m_Pitch = 0.0f;
+};
+
+/**
+ * Simulation state structure.
+ * This contains everything the simulation produces and the renderer consumes. It's copied into the snapshots so keep it flat.
+ */
+struct SimulationState final
+{
+	CameraState m_Camera;
+
+	uint64_t m_Step = 0;
+	double m_Time = 0.0;
+};
+
+/**
+ * Simulation snapshot structure.
+ * This contains the two latest simulation steps so the renderer can interpolate between them.
+ */
+struct SimulationSnapshot final
+{
+	SimulationState m_Previous;
+	SimulationState m_Current;
+
+	std::chrono::steady_clock::time_point m_Timestamp;
+};
+
+/**
+ * Simulation class.
+ * This runs the simulation at a fixed timestep on it's own thread and hands the results to the render thread using a triple buffer. The render rate
+ * does not affect the simulation, and the simulation cost does not add to the frame time.
+ */
+class Simulation final
+{
+public:
+	/**
+	 * Explicit constructor.
+	 * This will start the simulation thread.
+	 *
+	 * @param timestep The fixed timestep. Default is 1/60 seconds.
+	 */
+	explicit Simulation(std::chrono::nanoseconds timestep = std::chrono::nanoseconds(16666667));
+
+	/**
+	 * Destructor.
+	 * This will stop and join the simulation thread.
+	 */
+	~Simulation();
+
+	/**
+	 * Get the interpolated simulation state for rendering.
+	 * This should only be called from the render thread.
+	 *
+	 * @param time The time to render.
+	 * @return The interpolated state.
+	 */
+	[[nodiscard]] SimulationState getInterpolatedState(std::chrono::steady_clock::time_point time);
+
+	/**
+	 * Interpolate between two simulation states.
+	 *
+	 * @param previous The previous state.
+	 * @param current The current state.
+	 * @param alpha The interpolation factor, from 0 (previous) to 1 (current).
+	 * @return The interpolated state.
+	 */
+	[[nodiscard]] static SimulationState Interpolate(const SimulationState& previous, const SimulationState& current, float alpha);
+
+	GRAPHITE_DISABLE_COPY_AND_MOVE(Simulation);
+
+public:
+	GRAPHITE_SETUP_GETTERS(EventQueue, EventQueue, m_EventQueue);
+	GRAPHITE_SETUP_SIMPLE_GETTER(std::chrono::nanoseconds, Timestep, m_Timestep);
+
+private:
+	/**
+	 * Simulation thread function.
+	 *
+	 * @param token The stop token.
+	 */
+	void worker(std::stop_token token);
+
+	/**
+	 * Advance the simulation by a single step.
+	 *
+	 * @param state The state to advance.
+	 */
+	void step(SimulationState& state);
+
+	/**
+	 * Handle the key events.
+	 *
+	 * @param event The event.
+	 */
+	void onKey(const Event& event);
+
+	/**
+	 * Handle the mouse motion events.
+	 *
+	 * @param event The event.
+	 */
+	void onMouseMotion(const Event& event);
+
+private:
+	TripleBuffer<SimulationSnapshot> m_Snapshots;
+
+	EventQueue m_EventQueue;
+	EventDispatcher m_EventDispatcher;
+
+	std::array<float, 3> m_MoveDirection = { 0.0f, 0.0f, 0.0f };
+	float m_YawDelta = 0.0f;
+	float m_PitchDelta = 0.0f;
+
+	std::chrono::nanoseconds m_Timestep;
+
+	std::jthread m_Worker;
+};
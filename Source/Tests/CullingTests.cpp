@@ -0,0 +1,538 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "Test.hpp"
+
+#include "Backend/Platform.hpp"
+#include "Backend/Instance.hpp"
+#include "Backend/CommandSubmissionQueue.hpp"
+#include "Backend/Buffer.hpp"
+#include "Backend/Image.hpp"
+#include "Backend/IndirectDrawList.hpp"
+#include "Backend/DepthPyramid.hpp"
+#include "Backend/VulkanMacros.hpp"
+
+#include <cstring>
+#include <memory>
+
+namespace /* anonymous */
+{
+	// The resolution of the depth buffer the occlusion is tested against.
+	constexpr uint32_t g_DepthWidth = 64;
+	constexpr uint32_t g_DepthHeight = 64;
+
+	/**
+	 * Test device class.
+	 * This contains the platform, the instance and the submission queue shared by all the Vulkan tests. It's created the first time a test needs
+	 * it, so the tests which don't use Vulkan can run on machines without a device.
+	 *
+	 * To run the tests headless on lavapipe, point the Vulkan loader to it with VK_DRIVER_FILES (or VK_ICD_FILENAMES with older loaders), and use
+	 * SDL's offscreen video driver with SDL_VIDEODRIVER=offscreen.
+	 */
+	class TestDevice final
+	{
+	public:
+		/**
+		 * Default constructor.
+		 */
+		TestDevice()
+		{
+			m_Instance.waitForDevice();
+			if (isValid())
+				m_pSubmissionQueue = std::make_unique<CommandSubmissionQueue>(m_Instance);
+		}
+
+		/**
+		 * Destructor.
+		 */
+		~TestDevice()
+		{
+			m_pSubmissionQueue.reset();
+		}
+
+		GRAPHITE_DISABLE_COPY_AND_MOVE(TestDevice);
+
+		/**
+		 * Get the shared device.
+		 *
+		 * @return The device reference.
+		 */
+		[[nodiscard]] static TestDevice& Get()
+		{
+			static TestDevice device;
+			return device;
+		}
+
+		/**
+		 * Check if a Vulkan device was created.
+		 *
+		 * @return True if the device can be used.
+		 */
+		[[nodiscard]] bool isValid() const { return m_Instance.getLogicalDevice().getUnsafe() != VK_NULL_HANDLE; }
+
+	public:
+		GRAPHITE_SETUP_GETTERS(Instance, Instance, m_Instance);
+		GRAPHITE_SETUP_GETTERS(CommandSubmissionQueue, SubmissionQueue, *m_pSubmissionQueue);
+
+	private:
+		Platform m_Platform;
+		Instance m_Instance;
+
+		std::unique_ptr<CommandSubmissionQueue> m_pSubmissionQueue;
+	};
+
+	/**
+	 * Create the column major view projection matrix of a camera at the origin looking down -Z.
+	 * The projection is Vulkan style, with a 90 degree field of view, the Y axis down and the depth in [0, 1] between 1 and 100.
+	 *
+	 * @return The matrix.
+	 */
+	[[nodiscard]] std::array<float, 16> CreateViewProjection()
+	{
+		constexpr float nearPlane = 1.0f;
+		constexpr float farPlane = 100.0f;
+
+		std::array<float, 16> matrix = {};
+		matrix[0] = 1.0f;
+		matrix[5] = -1.0f;
+		matrix[10] = farPlane / (nearPlane - farPlane);
+		matrix[11] = -1.0f;
+		matrix[14] = nearPlane * farPlane / (nearPlane - farPlane);
+
+		return matrix;
+	}
+
+	/**
+	 * Cull result structure.
+	 * This contains what a frame's culling decided for each instance, 1 if the instance is visible or drawn and 0 otherwise.
+	 */
+	struct CullResult final
+	{
+		std::vector<uint32_t> m_Visibility;			// The visibility the occlusion phase stored for the next frame.
+		std::vector<uint32_t> m_FrustumDraws;		// The instances IndirectDrawList::draw() draws.
+		std::vector<uint32_t> m_OcclusionDraws;		// The instances IndirectDrawList::drawOcclusion() draws.
+	};
+
+	/**
+	 * Occlusion culling scene class.
+	 * This contains a depth buffer, it's pyramid and a draw list, and runs both culling phases on a set of instances. Nothing is drawn, so the
+	 * depth buffer is cleared to the depth of an occluder which covers the whole screen instead, or to the far plane when there is no occluder.
+	 */
+	class OcclusionScene final
+	{
+	public:
+		/**
+		 * Explicit constructor.
+		 *
+		 * @param device The test device.
+		 * @param instances The instances to cull.
+		 */
+		explicit OcclusionScene(TestDevice& device, std::span<const DrawInstance> instances)
+			: m_Device(device)
+			, m_DepthImage(device.getInstance(), ImageBuilder().setWidth(g_DepthWidth).setHeight(g_DepthHeight).setEnableMipMaps(false).setUsage(VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT), VK_FORMAT_D32_SFLOAT)
+			, m_DepthView(createDepthView())
+			, m_DrawList(device.getInstance(), static_cast<uint32_t>(instances.size()))
+			, m_Pyramid(device.getInstance(), m_DepthView, g_DepthWidth, g_DepthHeight)
+			, m_ReadbackBuffer(Buffer::Allocate(device.getInstance(), GetReadbackSize(instances.size()), VK_BUFFER_USAGE_TRANSFER_DST_BIT))
+			, m_InstanceCount(static_cast<uint32_t>(instances.size()))
+		{
+			auto& instance = device.getInstance();
+
+			m_DrawList.setInstances(instances);
+			m_DrawList.setOcclusionCulling(true);
+
+			// Create the command pool and the command buffer.
+			VkCommandPoolCreateInfo createInfo = {};
+			createInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			createInfo.pNext = nullptr;
+			createInfo.flags = 0;
+			createInfo.queueFamilyIndex = instance.getGraphicsQueue().getUnsafe().m_Family;
+
+			instance.getLogicalDevice().access([this, &instance, &createInfo](VkDevice logicalDevice)
+				{
+					GRAPHITE_VK_ASSERT(instance.getDeviceTable().vkCreateCommandPool(logicalDevice, &createInfo, nullptr, &m_CommandPool), "Failed to create the test command pool!");
+
+					VkCommandBufferAllocateInfo allocateInfo = {};
+					allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+					allocateInfo.pNext = nullptr;
+					allocateInfo.commandPool = m_CommandPool;
+					allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+					allocateInfo.commandBufferCount = 1;
+
+					GRAPHITE_VK_ASSERT(instance.getDeviceTable().vkAllocateCommandBuffers(logicalDevice, &allocateInfo, &m_CommandBuffer), "Failed to allocate the test command buffer!");
+				}
+			);
+		}
+
+		/**
+		 * Destructor.
+		 */
+		~OcclusionScene()
+		{
+			auto& instance = m_Device.getInstance();
+			instance.waitIdle();
+
+			instance.getDeletionQueue().retire(m_DepthView);
+			instance.getDeletionQueue().retire(m_ReadbackBuffer.m_Buffer, m_ReadbackBuffer.m_Allocation);
+			instance.getLogicalDevice().access([&instance, commandPool = m_CommandPool](VkDevice logicalDevice)
+				{
+					instance.getDeviceTable().vkDestroyCommandPool(logicalDevice, commandPool, nullptr);
+				}
+			);
+		}
+
+		GRAPHITE_DISABLE_COPY_AND_MOVE(OcclusionScene);
+
+		/**
+		 * Check if the culling can run.
+		 * The culling and the depth pyramid shaders come from the engine build.
+		 *
+		 * @return True if both phases can run.
+		 */
+		[[nodiscard]] bool isValid() const { return m_DrawList.isValid() && m_DrawList.getIsOcclusionCulling() && m_Pyramid.isValid(); }
+
+		/**
+		 * Run a frame's culling phases and read back what they decided.
+		 * The visibility is kept between the calls, so the first phase of a call only takes the instances the previous call found visible.
+		 *
+		 * @param viewProjection The column major view projection matrix.
+		 * @param depth The depth to clear the depth buffer to. Default is the far plane.
+		 * @return The result of each instance.
+		 */
+		[[nodiscard]] CullResult cull(const std::array<float, 16>& viewProjection, float depth = 1.0f)
+		{
+			auto& instance = m_Device.getInstance();
+			auto& submissionQueue = m_Device.getSubmissionQueue();
+			const auto& deviceTable = instance.getDeviceTable();
+
+			VkCommandBufferBeginInfo beginInfo = {};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.pNext = nullptr;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			beginInfo.pInheritanceInfo = nullptr;
+
+			GRAPHITE_VK_ASSERT(deviceTable.vkBeginCommandBuffer(m_CommandBuffer, &beginInfo), "Failed to begin the test command buffer!");
+
+			recordDepthClear(depth);
+			m_DrawList.cull(m_CommandBuffer, Frustum::FromViewProjection(viewProjection));
+			m_Pyramid.build(m_CommandBuffer);
+			m_DrawList.cullOcclusion(m_CommandBuffer, viewProjection, m_Pyramid);
+
+			ComputePipeline::RecordMemoryBarrier(deviceTable, m_CommandBuffer,
+				VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR,
+				VK_PIPELINE_STAGE_2_COPY_BIT_KHR, VK_ACCESS_2_TRANSFER_READ_BIT_KHR);
+
+			// The readback buffer holds the visibility, and then the draw count and the commands of each phase.
+			const auto visibilitySize = m_InstanceCount * sizeof(uint32_t);
+			const auto commandsSize = m_InstanceCount * sizeof(VkDrawIndexedIndirectCommand);
+			const auto frustumOffset = visibilitySize;
+			const auto occlusionOffset = frustumOffset + sizeof(uint32_t) + commandsSize;
+
+			recordCopy(m_DrawList.getVisibilityBuffer(), 0, visibilitySize);
+			recordCopy(m_DrawList.getFrustumCountBuffer(), frustumOffset, sizeof(uint32_t));
+			recordCopy(m_DrawList.getFrustumDrawBuffer(), frustumOffset + sizeof(uint32_t), commandsSize);
+			recordCopy(m_DrawList.getOcclusionCountBuffer(), occlusionOffset, sizeof(uint32_t));
+			recordCopy(m_DrawList.getOcclusionDrawBuffer(), occlusionOffset + sizeof(uint32_t), commandsSize);
+
+			ComputePipeline::RecordMemoryBarrier(deviceTable, m_CommandBuffer,
+				VK_PIPELINE_STAGE_2_COPY_BIT_KHR, VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR,
+				VK_PIPELINE_STAGE_2_HOST_BIT_KHR, VK_ACCESS_2_HOST_READ_BIT_KHR);
+
+			GRAPHITE_VK_ASSERT(deviceTable.vkEndCommandBuffer(m_CommandBuffer), "Failed to end the test command buffer!");
+
+			const auto value = submissionQueue.enqueue(QueueType::Graphics, std::span<const VkCommandBuffer>(&m_CommandBuffer, 1));
+			submissionQueue.flush();
+			submissionQueue.wait(QueueType::Graphics, value);
+
+			std::vector<std::byte> readback(m_ReadbackBuffer.m_Size);
+			instance.getAllocator().access([this, &readback](VmaAllocator allocator)
+				{
+					void* pReadbackMemory = nullptr;
+					GRAPHITE_VK_ASSERT(vmaMapMemory(allocator, m_ReadbackBuffer.m_Allocation, &pReadbackMemory), "Failed to map the readback buffer!");
+					GRAPHITE_VK_ASSERT(vmaInvalidateAllocation(allocator, m_ReadbackBuffer.m_Allocation, 0, VK_WHOLE_SIZE), "Failed to invalidate the readback buffer!");
+
+					std::memcpy(readback.data(), pReadbackMemory, readback.size());
+					vmaUnmapMemory(allocator, m_ReadbackBuffer.m_Allocation);
+				}
+			);
+
+			CullResult result;
+			result.m_Visibility.resize(m_InstanceCount);
+			std::memcpy(result.m_Visibility.data(), readback.data(), visibilitySize);
+
+			result.m_FrustumDraws = getDrawnInstances(readback.data() + frustumOffset);
+			result.m_OcclusionDraws = getDrawnInstances(readback.data() + occlusionOffset);
+
+			return result;
+		}
+
+	private:
+		/**
+		 * Get the size of the readback buffer.
+		 *
+		 * @param instanceCount The number of instances.
+		 * @return The size in bytes.
+		 */
+		[[nodiscard]] static VkDeviceSize GetReadbackSize(size_t instanceCount)
+		{
+			return instanceCount * sizeof(uint32_t) + 2 * (sizeof(uint32_t) + instanceCount * sizeof(VkDrawIndexedIndirectCommand));
+		}
+
+		/**
+		 * Record a copy from a draw list buffer to the readback buffer.
+		 *
+		 * @param buffer The buffer to copy from.
+		 * @param offset The offset in the readback buffer.
+		 * @param size The number of bytes to copy.
+		 */
+		void recordCopy(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size)
+		{
+			VkBufferCopy copy = {};
+			copy.srcOffset = 0;
+			copy.dstOffset = offset;
+			copy.size = size;
+			m_Device.getInstance().getDeviceTable().vkCmdCopyBuffer(m_CommandBuffer, buffer, m_ReadbackBuffer.m_Buffer, 1, &copy);
+		}
+
+		/**
+		 * Get the instances a phase's draw commands draw.
+		 * When compacting, the commands of the drawn instances are packed in front and the count says how many there are. Otherwise each instance
+		 * keeps it's slot and the culled ones draw zero instances.
+		 *
+		 * @param pData The phase's draw count, followed by it's commands.
+		 * @return 1 for each instance which is drawn, and 0 for the rest.
+		 */
+		[[nodiscard]] std::vector<uint32_t> getDrawnInstances(const std::byte* pData) const
+		{
+			uint32_t count = 0;
+			std::memcpy(&count, pData, sizeof(uint32_t));
+
+			std::vector<VkDrawIndexedIndirectCommand> commands(m_InstanceCount);
+			std::memcpy(commands.data(), pData + sizeof(uint32_t), commands.size() * sizeof(VkDrawIndexedIndirectCommand));
+
+			std::vector<uint32_t> drawn(m_InstanceCount);
+			if (m_DrawList.getIsCompacting())
+			{
+				for (uint32_t i = 0; i < count && i < m_InstanceCount; i++)
+				{
+					if (commands[i].firstInstance < m_InstanceCount)
+						drawn[commands[i].firstInstance] = commands[i].instanceCount;
+				}
+			}
+			else
+			{
+				for (uint32_t i = 0; i < m_InstanceCount; i++)
+					drawn[i] = commands[i].instanceCount;
+			}
+
+			return drawn;
+		}
+
+		/**
+		 * Create the depth buffer's view.
+		 *
+		 * @return The image view.
+		 */
+		[[nodiscard]] VkImageView createDepthView()
+		{
+			VkImageViewCreateInfo createInfo = {};
+			createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			createInfo.pNext = nullptr;
+			createInfo.flags = 0;
+			createInfo.image = m_DepthImage.getImage();
+			createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			createInfo.format = m_DepthImage.getFormat();
+			createInfo.components = { VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY };
+			createInfo.subresourceRange = VkImageSubresourceRange{ VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1 };
+
+			auto& instance = m_Device.getInstance();
+
+			VkImageView view = VK_NULL_HANDLE;
+			instance.getLogicalDevice().access([&instance, &createInfo, &view](VkDevice logicalDevice)
+				{
+					GRAPHITE_VK_ASSERT(instance.getDeviceTable().vkCreateImageView(logicalDevice, &createInfo, nullptr, &view), "Failed to create the test depth view!");
+				}
+			);
+
+			return view;
+		}
+
+		/**
+		 * Record the depth buffer clear, and leave it in the layout the depth pyramid reads it in.
+		 *
+		 * @param depth The depth to clear to.
+		 */
+		void recordDepthClear(float depth)
+		{
+			const auto& deviceTable = m_Device.getInstance().getDeviceTable();
+			const auto range = VkImageSubresourceRange{ VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1 };
+
+			VkImageMemoryBarrier2KHR barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+			barrier.pNext = nullptr;
+			barrier.srcStageMask = VK_PIPELINE_STAGE_2_NONE_KHR;
+			barrier.srcAccessMask = VK_ACCESS_2_NONE_KHR;
+			barrier.dstStageMask = VK_PIPELINE_STAGE_2_CLEAR_BIT_KHR;
+			barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = m_DepthImage.getImage();
+			barrier.subresourceRange = range;
+
+			VkDependencyInfoKHR dependencyInfo = {};
+			dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+			dependencyInfo.pNext = nullptr;
+			dependencyInfo.dependencyFlags = 0;
+			dependencyInfo.imageMemoryBarrierCount = 1;
+			dependencyInfo.pImageMemoryBarriers = &barrier;
+
+			deviceTable.vkCmdPipelineBarrier2KHR(m_CommandBuffer, &dependencyInfo);
+
+			const VkClearDepthStencilValue clearValue = { depth, 0 };
+			deviceTable.vkCmdClearDepthStencilImage(m_CommandBuffer, m_DepthImage.getImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearValue, 1, &range);
+
+			barrier.srcStageMask = VK_PIPELINE_STAGE_2_CLEAR_BIT_KHR;
+			barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR;
+			barrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR;
+			barrier.dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT_KHR;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+			deviceTable.vkCmdPipelineBarrier2KHR(m_CommandBuffer, &dependencyInfo);
+		}
+
+	private:
+		TestDevice& m_Device;
+
+		Image m_DepthImage;
+		VkImageView m_DepthView = VK_NULL_HANDLE;
+
+		IndirectDrawList m_DrawList;
+		DepthPyramid m_Pyramid;
+
+		BufferData m_ReadbackBuffer;
+		uint32_t m_InstanceCount = 0;
+
+		VkCommandPool m_CommandPool = VK_NULL_HANDLE;
+		VkCommandBuffer m_CommandBuffer = VK_NULL_HANDLE;
+	};
+
+	/**
+	 * Create a draw instance.
+	 *
+	 * @param x The center's X coordinate.
+	 * @param y The center's Y coordinate.
+	 * @param z The center's Z coordinate.
+	 * @param radius The bounding sphere's radius.
+	 * @return The instance.
+	 */
+	[[nodiscard]] DrawInstance CreateInstance(float x, float y, float z, float radius)
+	{
+		DrawInstance instance;
+		instance.m_BoundingSphere = { x, y, z, radius };
+		instance.m_IndexCount = 36;
+		return instance;
+	}
+}
+
+/**
+ * The occlusion phase must reject the instances which are entirely outside any of the frustum planes, even when the depth buffer occludes nothing.
+ */
+GRAPHITE_TEST(OcclusionCullingRejectsOutsideFrustum)
+{
+	auto& device = TestDevice::Get();
+	if (!device.isValid())
+	{
+		context.skip("No Vulkan device is available.");
+		return;
+	}
+
+	const std::array<DrawInstance, 8> instances = {
+		CreateInstance(0.0f, 0.0f, -10.0f, 1.0f),	// Inside.
+		CreateInstance(-30.0f, 0.0f, -10.0f, 1.0f),	// Left of the left plane.
+		CreateInstance(30.0f, 0.0f, -10.0f, 1.0f),	// Right of the right plane.
+		CreateInstance(0.0f, -30.0f, -10.0f, 1.0f),	// Below the bottom plane.
+		CreateInstance(0.0f, 30.0f, -10.0f, 1.0f),	// Above the top plane.
+		CreateInstance(0.0f, 0.0f, -0.3f, 0.2f),	// In front of the near plane.
+		CreateInstance(0.0f, 0.0f, -200.0f, 1.0f),	// Behind the far plane.
+		CreateInstance(0.0f, 0.0f, 10.0f, 1.0f)		// Behind the camera.
+	};
+
+	OcclusionScene scene(device, instances);
+	if (!scene.isValid())
+	{
+		context.skip("The culling shaders are not available.");
+		return;
+	}
+
+	const auto visibility = scene.cull(CreateViewProjection()).m_Visibility;
+	if (!GRAPHITE_CHECK(visibility.size() == instances.size()))
+		return;
+
+	GRAPHITE_CHECK(visibility[0] == 1);
+	GRAPHITE_CHECK(visibility[1] == 0);
+	GRAPHITE_CHECK(visibility[2] == 0);
+	GRAPHITE_CHECK(visibility[3] == 0);
+	GRAPHITE_CHECK(visibility[4] == 0);
+	GRAPHITE_CHECK(visibility[5] == 0);
+	GRAPHITE_CHECK(visibility[6] == 0);
+	GRAPHITE_CHECK(visibility[7] == 0);
+}
+
+/**
+ * An instance behind an occluder must be rejected by the occlusion phase. Once the occluder is gone, the instance must be drawn by the second phase
+ * in the same frame, since the first phase only draws the instances which were visible in the last frame.
+ */
+GRAPHITE_TEST(OcclusionCullingRejectsOccludedInstances)
+{
+	auto& device = TestDevice::Get();
+	if (!device.isValid())
+	{
+		context.skip("No Vulkan device is available.");
+		return;
+	}
+
+	const std::array<DrawInstance, 3> instances = {
+		CreateInstance(0.0f, 0.0f, -50.0f, 1.0f),	// Behind the occluder.
+		CreateInstance(0.0f, 0.0f, -2.0f, 0.5f),	// In front of the occluder.
+		CreateInstance(80.0f, 0.0f, -50.0f, 1.0f)	// Right of the right plane.
+	};
+
+	OcclusionScene scene(device, instances);
+	if (!scene.isValid())
+	{
+		context.skip("The culling shaders are not available.");
+		return;
+	}
+
+	// The depth of a wall 5 units in front of the camera, which covers the whole screen. See CreateViewProjection().
+	constexpr float nearPlane = 1.0f;
+	constexpr float farPlane = 100.0f;
+	constexpr float occluderDistance = 5.0f;
+	constexpr float occluderDepth = farPlane / (farPlane - nearPlane) * (1.0f - nearPlane / occluderDistance);
+
+	const auto viewProjection = CreateViewProjection();
+
+	// The first frame has no visibility yet, so everything visible is drawn by the second phase.
+	const auto occluded = scene.cull(viewProjection, occluderDepth);
+	if (!GRAPHITE_CHECK(occluded.m_Visibility.size() == instances.size()))
+		return;
+
+	GRAPHITE_CHECK(occluded.m_Visibility[0] == 0);
+	GRAPHITE_CHECK(occluded.m_Visibility[1] == 1);
+	GRAPHITE_CHECK(occluded.m_Visibility[2] == 0);
+	GRAPHITE_CHECK(occluded.m_FrustumDraws == std::vector<uint32_t>({ 0, 0, 0 }));
+	GRAPHITE_CHECK(occluded.m_OcclusionDraws == std::vector<uint32_t>({ 0, 1, 0 }));
+
+	// Without the occluder, the first phase draws the instance which was visible, and the second phase the one which was occluded.
+	const auto disoccluded = scene.cull(viewProjection);
+	if (!GRAPHITE_CHECK(disoccluded.m_Visibility.size() == instances.size()))
+		return;
+
+	GRAPHITE_CHECK(disoccluded.m_Visibility[0] == 1);
+	GRAPHITE_CHECK(disoccluded.m_Visibility[1] == 1);
+	GRAPHITE_CHECK(disoccluded.m_Visibility[2] == 0);
+	GRAPHITE_CHECK(disoccluded.m_FrustumDraws == std::vector<uint32_t>({ 0, 1, 0 }));
+	GRAPHITE_CHECK(disoccluded.m_OcclusionDraws == std::vector<uint32_t>({ 1, 0, 0 }));
+}
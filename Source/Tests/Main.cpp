@@ -0,0 +1,39 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "Test.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <iostream>
+
+int main(int argc, char* argv[])
+{
+	// Parse the arguments.
+	std::string_view filter;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const auto argument = std::string_view(argv[i]);
+		if (argument == "--filter" && i + 1 < argc)
+			filter = argv[++i];
+
+		else if (argument == "--list")
+		{
+			for (const auto& name : TestRegistry::GetNames())
+				std::cout << name << std::endl;
+
+			return 0;
+		}
+
+		else
+		{
+			std::cerr << "Usage: GraphiteTests [--filter <substring>] [--list]" << std::endl;
+			return 1;
+		}
+	}
+
+	// The engine logs would be mixed with the results, so only the warnings and the errors are printed.
+	spdlog::set_level(spdlog::level::warn);
+
+	return TestRegistry::Run(std::cout, filter) == 0 ? 0 : 1;
+}
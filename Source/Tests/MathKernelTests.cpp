@@ -0,0 +1,288 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "Test.hpp"
+
+#include "Core/MathKernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace /* anonymous */
+{
+	// The seed of the random inputs, so a failure can be reproduced.
+	constexpr uint32_t g_Seed = 0x3c6ef372;
+
+	// The element counts the kernels are checked with. These cover every tail length of the 4 and 8 wide versions, and a few full blocks before it.
+	constexpr std::array<size_t, 22> g_ElementCounts = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 31, 33, 63, 1001 };
+
+	// The number of elements after the end of each stream, which the kernels must not write to.
+	constexpr size_t g_GuardCount = 8;
+
+	// The value the guard elements are filled with.
+	constexpr float g_GuardValue = -12345.0f;
+
+	// The largest error relative to the scalar results, which is the same the benchmarks allow against glm. The vector versions can differ in the
+	// last bits, since AVX2 uses fused multiply adds, and the point transforms sum products of a few hundred.
+	constexpr float g_Tolerance = 1e-4f;
+
+	/**
+	 * Guarded buffer class.
+	 * This owns a stream with guard elements after the end of each component, so the writes past the end can be detected.
+	 *
+	 * @tparam Components The number of components of an element.
+	 */
+	template<size_t Components>
+	class GuardedBuffer final
+	{
+	public:
+		/**
+		 * Explicit constructor.
+		 *
+		 * @param count The number of elements.
+		 */
+		explicit GuardedBuffer(size_t count)
+			: m_Buffer(count + g_GuardCount)
+			, m_Count(count)
+		{
+			for (size_t i = 0; i < Components; i++)
+				GRAPHITE_RANGES(fill, m_Buffer.getStream()[i].subspan(count), g_GuardValue);
+		}
+
+		/**
+		 * Fill the elements with random values.
+		 *
+		 * @param generator The random number generator.
+		 * @param minimum The smallest value.
+		 * @param maximum The largest value.
+		 */
+		void fillRandom(std::mt19937& generator, float minimum, float maximum)
+		{
+			std::uniform_real_distribution<float> distribution(minimum, maximum);
+			for (size_t i = 0; i < Components; i++)
+				GRAPHITE_RANGES(generate, getStream()[i], [&distribution, &generator] { return distribution(generator); });
+		}
+
+		/**
+		 * Get the stream of the elements, without the guards.
+		 *
+		 * @return The stream.
+		 */
+		[[nodiscard]] SoAStream<float, Components> getStream()
+		{
+			auto stream = m_Buffer.getStream();
+			for (auto& component : stream.m_Components)
+				component = component.first(m_Count);
+
+			return stream;
+		}
+
+		/**
+		 * Check if the guard elements are untouched.
+		 *
+		 * @return True if nothing was written past the end.
+		 */
+		[[nodiscard]] bool isGuardIntact()
+		{
+			for (size_t i = 0; i < Components; i++)
+			{
+				if (!GRAPHITE_RANGES(all_of, m_Buffer.getStream()[i].subspan(m_Count), [](float value) { return value == g_GuardValue; }))
+					return false;
+			}
+
+			return true;
+		}
+
+	private:
+		SoABuffer<Components> m_Buffer;
+		size_t m_Count = 0;
+	};
+
+	/**
+	 * Get the largest error of a stream relative to the scalar results.
+	 *
+	 * @param values The results of the kernel.
+	 * @param references The scalar results.
+	 * @return The error.
+	 */
+	template<size_t Components>
+	[[nodiscard]] float GetLargestError(SoAStream<float, Components> values, SoAStream<float, Components> references)
+	{
+		float error = 0.0f;
+		for (size_t component = 0; component < Components; component++)
+		{
+			for (size_t i = 0; i < values.size(); i++)
+				error = std::max(error, std::abs(values[component][i] - references[component][i]) / std::max(1.0f, std::abs(references[component][i])));
+		}
+
+		return error;
+	}
+
+	/**
+	 * Run a check with every ISA the CPU supports above scalar.
+	 * The previous ISA is restored afterwards. The test is skipped if the CPU only supports scalar.
+	 *
+	 * @param context The test context.
+	 * @param function The function to run with the ISA.
+	 */
+	template<class Function>
+	void ForEachVectorISA(TestContext& context, Function&& function)
+	{
+		const auto previous = MathKernels::GetISA();
+		const auto supported = MathKernels::GetSupportedISA();
+		if (supported == MathISA::Scalar)
+		{
+			context.skip("The CPU only supports the scalar kernels.");
+			return;
+		}
+
+		for (auto isa = static_cast<uint8_t>(MathISA::Scalar) + 1; isa <= static_cast<uint8_t>(supported); isa++)
+			function(static_cast<MathISA>(isa));
+
+		static_cast<void>(MathKernels::SetISA(previous));
+	}
+}
+
+/**
+ * The vector versions of the matrix multiplication must match the scalar one for every tail length.
+ */
+GRAPHITE_TEST(MathMultiplyMatricesMatchesScalar)
+{
+	ForEachVectorISA(context, [&context](MathISA isa)
+		{
+			for (const auto count : g_ElementCounts)
+			{
+				std::mt19937 generator(g_Seed);
+				GuardedBuffer<16> lhs(count);
+				GuardedBuffer<16> rhs(count);
+				GuardedBuffer<16> reference(count);
+				GuardedBuffer<16> result(count);
+				lhs.fillRandom(generator, -2.0f, 2.0f);
+				rhs.fillRandom(generator, -2.0f, 2.0f);
+
+				static_cast<void>(MathKernels::SetISA(MathISA::Scalar));
+				MathKernels::MultiplyMatrices(lhs.getStream(), rhs.getStream(), reference.getStream());
+
+				static_cast<void>(MathKernels::SetISA(isa));
+				MathKernels::MultiplyMatrices(lhs.getStream(), rhs.getStream(), result.getStream());
+
+				GRAPHITE_CHECK(GetLargestError(result.getStream(), reference.getStream()) <= g_Tolerance);
+				GRAPHITE_CHECK(result.isGuardIntact());
+			}
+		}
+	);
+}
+
+/**
+ * The vector versions of the bounding box transform must match the scalar one for every tail length.
+ */
+GRAPHITE_TEST(MathTransformAABBsMatchesScalar)
+{
+	ForEachVectorISA(context, [&context](MathISA isa)
+		{
+			for (const auto count : g_ElementCounts)
+			{
+				std::mt19937 generator(g_Seed);
+				GuardedBuffer<16> matrices(count);
+				GuardedBuffer<6> boxes(count);
+				GuardedBuffer<6> reference(count);
+				GuardedBuffer<6> result(count);
+				matrices.fillRandom(generator, -2.0f, 2.0f);
+				boxes.fillRandom(generator, -10.0f, 10.0f);
+
+				// The kernel only handles affine matrices and boxes whose minimum is below their maximum.
+				for (size_t i = 0; i < count; i++)
+				{
+					matrices.getStream()[3][i] = 0.0f;
+					matrices.getStream()[7][i] = 0.0f;
+					matrices.getStream()[11][i] = 0.0f;
+					matrices.getStream()[15][i] = 1.0f;
+
+					for (size_t axis = 0; axis < 3; axis++)
+					{
+						auto& minimum = boxes.getStream()[axis][i];
+						auto& maximum = boxes.getStream()[3 + axis][i];
+						if (minimum > maximum)
+							std::swap(minimum, maximum);
+					}
+				}
+
+				static_cast<void>(MathKernels::SetISA(MathISA::Scalar));
+				MathKernels::TransformAABBs(matrices.getStream(), boxes.getStream(), reference.getStream());
+
+				static_cast<void>(MathKernels::SetISA(isa));
+				MathKernels::TransformAABBs(matrices.getStream(), boxes.getStream(), result.getStream());
+
+				GRAPHITE_CHECK(GetLargestError(result.getStream(), reference.getStream()) <= g_Tolerance);
+				GRAPHITE_CHECK(result.isGuardIntact());
+			}
+		}
+	);
+}
+
+/**
+ * The vector versions of the quaternion normalization must match the scalar one for every tail length, including the zero quaternions.
+ */
+GRAPHITE_TEST(MathNormalizeQuaternionsMatchesScalar)
+{
+	ForEachVectorISA(context, [&context](MathISA isa)
+		{
+			for (const auto count : g_ElementCounts)
+			{
+				std::mt19937 generator(g_Seed);
+				GuardedBuffer<4> reference(count);
+				reference.fillRandom(generator, -1.0f, 1.0f);
+
+				for (size_t i = 0; i < count; i += 5)
+				{
+					for (size_t component = 0; component < 4; component++)
+						reference.getStream()[component][i] = 0.0f;
+				}
+
+				auto result = reference;
+
+				static_cast<void>(MathKernels::SetISA(MathISA::Scalar));
+				MathKernels::NormalizeQuaternions(reference.getStream());
+
+				static_cast<void>(MathKernels::SetISA(isa));
+				MathKernels::NormalizeQuaternions(result.getStream());
+
+				GRAPHITE_CHECK(GetLargestError(result.getStream(), reference.getStream()) <= g_Tolerance);
+				GRAPHITE_CHECK(result.isGuardIntact());
+			}
+		}
+	);
+}
+
+/**
+ * The vector versions of the point transform must match the scalar one for every tail length.
+ */
+GRAPHITE_TEST(MathTransformPointsMatchesScalar)
+{
+	ForEachVectorISA(context, [&context](MathISA isa)
+		{
+			for (const auto count : g_ElementCounts)
+			{
+				std::mt19937 generator(g_Seed);
+				std::uniform_real_distribution<float> distribution(-2.0f, 2.0f);
+
+				std::array<float, 16> matrix = {};
+				GRAPHITE_RANGES(generate, matrix, [&distribution, &generator] { return distribution(generator); });
+
+				GuardedBuffer<3> points(count);
+				GuardedBuffer<4> reference(count);
+				GuardedBuffer<4> result(count);
+				points.fillRandom(generator, -100.0f, 100.0f);
+
+				static_cast<void>(MathKernels::SetISA(MathISA::Scalar));
+				MathKernels::TransformPoints(matrix, points.getStream(), reference.getStream());
+
+				static_cast<void>(MathKernels::SetISA(isa));
+				MathKernels::TransformPoints(matrix, points.getStream(), result.getStream());
+
+				GRAPHITE_CHECK(GetLargestError(result.getStream(), reference.getStream()) <= g_Tolerance);
+				GRAPHITE_CHECK(result.isGuardIntact());
+			}
+		}
+	);
+}
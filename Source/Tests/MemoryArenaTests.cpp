@@ -0,0 +1,65 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "Test.hpp"
+
+#include "Core/MemoryArena.hpp"
+
+namespace /* anonymous */
+{
+	/**
+	 * Check if a pointer is aligned.
+	 *
+	 * @param pData The pointer.
+	 * @param alignment The alignment.
+	 * @return True if the pointer is a multiple of the alignment.
+	 */
+	[[nodiscard]] bool IsAligned(const void* pData, size_t alignment)
+	{
+		return reinterpret_cast<uintptr_t>(pData) % alignment == 0;
+	}
+}
+
+/**
+ * The allocations above the block's alignment must be aligned by their address, after an odd sized allocation moved the offset.
+ */
+GRAPHITE_TEST(MemoryArenaOverAlignment)
+{
+	MemoryArena arena(4096);
+
+	for (const size_t alignment : { 32, 64, 128, 256, 1024 })
+	{
+		const auto marker = arena.getMarker();
+
+		[[maybe_unused]] const auto pPadding = arena.allocate(1, 1);
+		const auto pData = arena.allocate(16, alignment);
+		GRAPHITE_CHECK(IsAligned(pData, alignment));
+
+		arena.rewind(marker);
+	}
+
+	GRAPHITE_CHECK(arena.getOverflowCount() == 0);
+}
+
+/**
+ * An allocation whose padding does not fit in the rest of the block must come from the upstream, still aligned.
+ */
+GRAPHITE_TEST(MemoryArenaOverAlignedOverflow)
+{
+	MemoryArena arena(64);
+
+	[[maybe_unused]] const auto pFill = arena.allocate(60, 1);
+	const auto pData = arena.allocate(4, 256);
+
+	GRAPHITE_CHECK(IsAligned(pData, 256));
+	GRAPHITE_CHECK(arena.getOverflowCount() == 1);
+
+	// The block grows on the reset, and the same allocations fit in it after that.
+	arena.reset();
+	GRAPHITE_CHECK(arena.getCapacity() > 64);
+
+	[[maybe_unused]] const auto pRefill = arena.allocate(60, 1);
+	GRAPHITE_CHECK(IsAligned(arena.allocate(4, 256), 256));
+	GRAPHITE_CHECK(arena.getOverflowCount() == 1);
+
+	arena.reset();
+}
@@ -0,0 +1,214 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "Test.hpp"
+
+#include "Core/PoolAllocator.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <random>
+#include <thread>
+
+namespace /* anonymous */
+{
+	// The tests which check the statistics use the largest size class. It's blocks fill the chunks exactly, and nothing else in the tests uses it.
+	constexpr size_t g_StatisticsSize = PoolAllocator::MaximumSize;
+
+	// The most blocks of a size class a thread cache holds, which is two batches.
+	constexpr uint32_t g_CacheCapacity = 64;
+
+	// Many more than a thread cache holds, so the caches exchange blocks with the shared pools.
+	constexpr uint32_t g_BlockCount = 1000;
+
+	/**
+	 * Get the bytes the pools have handed out, which are either in use or cached by a thread.
+	 *
+	 * @return The size in bytes.
+	 */
+	[[nodiscard]] uint64_t GetOutstandingSize()
+	{
+		const auto statistics = PoolAllocator::GetStatistics();
+		return statistics.m_ReservedSize - statistics.m_CentralFreeSize;
+	}
+
+	/**
+	 * Fill a block with a pattern.
+	 *
+	 * @param pData The block pointer.
+	 * @param size The block size.
+	 * @param value The pattern value.
+	 */
+	void FillBlock(void* pData, size_t size, uint8_t value)
+	{
+		std::memset(pData, value, size);
+	}
+
+	/**
+	 * Check if a block still has it's pattern.
+	 *
+	 * @param pData The block pointer.
+	 * @param size The block size.
+	 * @param value The pattern value.
+	 * @return True if every byte is the pattern value.
+	 */
+	[[nodiscard]] bool HasPattern(const void* pData, size_t size, uint8_t value)
+	{
+		const auto pBytes = static_cast<const uint8_t*>(pData);
+		return std::all_of(pBytes, pBytes + size, [value](uint8_t byte) { return byte == value; });
+	}
+
+	/**
+	 * Late free structure.
+	 * This frees it's blocks from a thread local destructor, which runs after the thread's cache is destroyed if it was created first.
+	 */
+	struct LateFree final
+	{
+		/**
+		 * Destructor.
+		 */
+		~LateFree()
+		{
+			for (const auto pBlock : m_Blocks)
+				PoolAllocator::Deallocate(pBlock, g_StatisticsSize);
+
+			// Allocating after the cache is gone must work too, and must not lose the rest of the batch it takes.
+			const auto pBlock = PoolAllocator::Allocate(g_StatisticsSize);
+			m_pResult->store(pBlock != nullptr);
+			PoolAllocator::Deallocate(pBlock, g_StatisticsSize);
+		}
+
+		std::vector<void*> m_Blocks;
+		std::atomic_bool* m_pResult = nullptr;
+	};
+}
+
+/**
+ * Threads allocating and freeing blocks of every size class at the same time must never get the same block, and must not overwrite each other's.
+ */
+GRAPHITE_TEST(PoolAllocatorConcurrentThreads)
+{
+	constexpr uint32_t threadCount = 8;
+	constexpr uint32_t liveCount = 96;
+
+	std::atomic_uint32_t corruptions = 0;
+	std::vector<std::jthread> threads;
+	for (uint32_t t = 0; t < threadCount; t++)
+	{
+		threads.emplace_back([t, &corruptions]
+			{
+				std::mt19937 generator(t);
+				std::uniform_int_distribution<size_t> sizes(1, PoolAllocator::MaximumSize);
+				std::vector<std::pair<void*, size_t>> blocks;
+
+				const auto value = static_cast<uint8_t>(t + 1);
+				for (uint32_t i = 0; i < g_BlockCount * 4; i++)
+				{
+					if (blocks.size() == liveCount)
+					{
+						// Free a random block, so the caches see frees of every class in between the allocations.
+						const auto index = generator() % blocks.size();
+						const auto [pData, size] = blocks[index];
+						if (!HasPattern(pData, size, value))
+							corruptions++;
+
+						PoolAllocator::Deallocate(pData, size);
+						blocks[index] = blocks.back();
+						blocks.pop_back();
+					}
+
+					const auto size = sizes(generator);
+					const auto pData = PoolAllocator::Allocate(size);
+					FillBlock(pData, size, value);
+					blocks.emplace_back(pData, size);
+				}
+
+				for (const auto [pData, size] : blocks)
+				{
+					if (!HasPattern(pData, size, value))
+						corruptions++;
+
+					PoolAllocator::Deallocate(pData, size);
+				}
+			}
+		);
+	}
+
+	threads.clear();
+	GRAPHITE_CHECK(corruptions == 0);
+}
+
+/**
+ * Blocks allocated on one thread and freed on another must be reusable, and must end up back in the shared pool once the caches are flushed.
+ */
+GRAPHITE_TEST(PoolAllocatorRemoteFree)
+{
+	PoolAllocator::FlushThreadCache();
+	const auto outstandingSize = GetOutstandingSize();
+
+	// The blocks are allocated on a thread which exits before they're freed, so it's cache is flushed when it's destroyed.
+	std::vector<void*> blocks(g_BlockCount);
+	std::jthread([&blocks]
+		{
+			for (uint32_t i = 0; i < g_BlockCount; i++)
+			{
+				blocks[i] = PoolAllocator::Allocate(g_StatisticsSize);
+				FillBlock(blocks[i], g_StatisticsSize, static_cast<uint8_t>(i));
+			}
+		}
+	).join();
+
+	GRAPHITE_CHECK(GetOutstandingSize() == outstandingSize + g_BlockCount * g_StatisticsSize);
+
+	// Freeing them here fills this thread's cache, which has to give the batches back as it goes.
+	bool bIsIntact = true;
+	for (uint32_t i = 0; i < g_BlockCount; i++)
+	{
+		bIsIntact &= HasPattern(blocks[i], g_StatisticsSize, static_cast<uint8_t>(i));
+		PoolAllocator::Deallocate(blocks[i], g_StatisticsSize);
+	}
+
+	GRAPHITE_CHECK(bIsIntact);
+	GRAPHITE_CHECK(GetOutstandingSize() < outstandingSize + g_CacheCapacity * g_StatisticsSize);
+
+	// Flushing gives everything back.
+	PoolAllocator::FlushThreadCache();
+	GRAPHITE_CHECK(GetOutstandingSize() == outstandingSize);
+
+	// The freed blocks are reused instead of carving new chunks.
+	const auto chunkCount = PoolAllocator::GetStatistics().m_ChunkCount;
+	for (auto& pBlock : blocks)
+		pBlock = PoolAllocator::Allocate(g_StatisticsSize);
+
+	GRAPHITE_CHECK(PoolAllocator::GetStatistics().m_ChunkCount == chunkCount);
+
+	for (const auto pBlock : blocks)
+		PoolAllocator::Deallocate(pBlock, g_StatisticsSize);
+
+	PoolAllocator::FlushThreadCache();
+	GRAPHITE_CHECK(GetOutstandingSize() == outstandingSize);
+}
+
+/**
+ * Blocks freed and allocated from a thread local destructor, after the thread's cache is destroyed, must go to the shared pool and not be lost.
+ */
+GRAPHITE_TEST(PoolAllocatorFreeAfterCacheDestroyed)
+{
+	PoolAllocator::FlushThreadCache();
+	const auto outstandingSize = GetOutstandingSize();
+
+	std::atomic_bool bAllocated = false;
+	std::jthread([&bAllocated]
+		{
+			// This is constructed before the first allocation creates the cache, so it's destroyed after it.
+			thread_local LateFree lateFree;
+			lateFree.m_pResult = &bAllocated;
+
+			for (uint32_t i = 0; i < g_BlockCount; i++)
+				lateFree.m_Blocks.emplace_back(PoolAllocator::Allocate(g_StatisticsSize));
+		}
+	).join();
+
+	GRAPHITE_CHECK(bAllocated);
+	GRAPHITE_CHECK(GetOutstandingSize() == outstandingSize);
+}
@@ -0,0 +1,74 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "Test.hpp"
+
+#include <spdlog/fmt/fmt.h>
+
+bool TestContext::check(bool condition, std::string_view expression, std::string_view file, uint32_t line)
+{
+	if (!condition)
+		m_Failures.emplace_back(fmt::format("{}:{}: {}", file, line, expression));
+
+	return condition;
+}
+
+bool TestRegistry::Register(std::string_view name, std::function<void(TestContext&)> function)
+{
+	GetEntries().emplace_back(std::string(name), std::move(function));
+	return true;
+}
+
+uint32_t TestRegistry::Run(std::ostream& stream, std::string_view filter)
+{
+	uint32_t passed = 0;
+	uint32_t failed = 0;
+	uint32_t skipped = 0;
+
+	for (const auto& entry : GetEntries())
+	{
+		if (!filter.empty() && entry.m_Name.find(filter) == std::string::npos)
+			continue;
+
+		TestContext context;
+		entry.m_Function(context);
+
+		if (!context.getFailures().empty())
+		{
+			stream << "[FAIL] " << entry.m_Name << "\n";
+			for (const auto& failure : context.getFailures())
+				stream << "       " << failure << "\n";
+
+			failed++;
+		}
+
+		else if (!context.getSkipReason().empty())
+		{
+			stream << "[SKIP] " << entry.m_Name << ": " << context.getSkipReason() << "\n";
+			skipped++;
+		}
+
+		else
+		{
+			stream << "[PASS] " << entry.m_Name << "\n";
+			passed++;
+		}
+	}
+
+	stream << fmt::format("{} passed, {} failed, {} skipped.", passed, failed, skipped) << std::endl;
+	return failed;
+}
+
+std::vector<std::string> TestRegistry::GetNames()
+{
+	std::vector<std::string> names;
+	for (const auto& entry : GetEntries())
+		names.emplace_back(entry.m_Name);
+
+	return names;
+}
+
+std::vector<TestRegistry::Entry>& TestRegistry::GetEntries()
+{
+	static std::vector<Entry> entries;
+	return entries;
+}
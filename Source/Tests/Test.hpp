@@ -0,0 +1,118 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#pragma once
+
+#include "Core/Common.hpp"
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Test context class.
+ * This is passed to a test function, which reports it's failed checks to it. A test keeps running after a failed check, so a single run reports all
+ * of them.
+ */
+class TestContext final
+{
+public:
+	/**
+	 * Check a condition, and record a failure if it's false.
+	 *
+	 * @param condition The condition.
+	 * @param expression The expression of the condition, which is reported on failure.
+	 * @param file The source file of the check.
+	 * @param line The source line of the check.
+	 * @return The condition.
+	 */
+	bool check(bool condition, std::string_view expression, std::string_view file, uint32_t line);
+
+	/**
+	 * Skip the test.
+	 * This is used when the test cannot run in the current environment, like when there's no Vulkan device. The test function should return after
+	 * calling this.
+	 *
+	 * @param reason The reason to report.
+	 */
+	void skip(std::string_view reason) { m_SkipReason = reason; }
+
+public:
+	GRAPHITE_SETUP_GETTERS(std::vector<std::string>, Failures, m_Failures);
+	GRAPHITE_SETUP_GETTERS(std::string, SkipReason, m_SkipReason);
+
+private:
+	std::vector<std::string> m_Failures;
+	std::string m_SkipReason;
+};
+
+/**
+ * Test registry class.
+ * The tests register themselves from static initializers using the GRAPHITE_TEST macro, so adding a test only needs a new function in any of the
+ * test sources.
+ */
+class TestRegistry final
+{
+	/**
+	 * Entry structure.
+	 * This is a single registered test.
+	 */
+	struct Entry final
+	{
+		std::string m_Name;
+		std::function<void(TestContext&)> m_Function;
+	};
+
+public:
+	/**
+	 * Register a test.
+	 *
+	 * @param name The test name.
+	 * @param function The test function.
+	 * @return Always returns true so it can be used to initialize a static variable.
+	 */
+	static bool Register(std::string_view name, std::function<void(TestContext&)> function);
+
+	/**
+	 * Run the tests, and write the result of each of them.
+	 *
+	 * @param stream The stream to write to.
+	 * @param filter Only the tests whose names contain this are run. Empty runs all of them.
+	 * @return The number of failed tests.
+	 */
+	[[nodiscard]] static uint32_t Run(std::ostream& stream, std::string_view filter);
+
+	/**
+	 * Get the names of the registered tests.
+	 *
+	 * @return The names.
+	 */
+	[[nodiscard]] static std::vector<std::string> GetNames();
+
+private:
+	/**
+	 * Get the registered tests.
+	 *
+	 * @return The entries.
+	 */
+	[[nodiscard]] static std::vector<Entry>& GetEntries();
+};
+
+#define GRAPHITE_TEST_CONCATENATE_IMPL(lhs, rhs)	lhs##rhs
+#define GRAPHITE_TEST_CONCATENATE(lhs, rhs)		GRAPHITE_TEST_CONCATENATE_IMPL(lhs, rhs)
+
+/**
+ * Define a test.
+ * The function body follows the macro, and takes a TestContext& named context.
+ */
+#define GRAPHITE_TEST(name)																								\
+	static void name(TestContext& context);																				\
+	[[maybe_unused]] static const bool GRAPHITE_TEST_CONCATENATE(_graphiteTest, name) = ::TestRegistry::Register(#name, name);	\
+	static void name(TestContext& context)
+
+/**
+ * Check a condition in a test.
+ * A failed check is reported with it's expression and location, and the test continues.
+ */
+#define GRAPHITE_CHECK(condition)	context.check(static_cast<bool>(condition), #condition, __FILE__, __LINE__)
@@ -0,0 +1,45 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "Core/BinaryLogging.hpp"
+
+#include <iostream>
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		std::cerr << "Usage: GraphiteLogDecoder <binary log file> [--json] [--output <file>]" << std::endl;
+		return 1;
+	}
+
+	// Parse the arguments.
+	auto format = BinaryLogOutputFormat::Text;
+	std::string_view outputPath;
+	for (int i = 2; i < argc; i++)
+	{
+		const auto argument = std::string_view(argv[i]);
+		if (argument == "--json")
+			format = BinaryLogOutputFormat::JSON;
+
+		else if (argument == "--output" && i + 1 < argc)
+			outputPath = argv[++i];
+	}
+
+	// Load the file.
+	const auto decoder = BinaryLogDecoder(argv[1]);
+	if (!decoder.isValid())
+		return 1;
+
+	// Decode it to the requested output.
+	if (outputPath.empty())
+	{
+		decoder.decode(std::cout, format);
+	}
+	else
+	{
+		auto output = std::ofstream(std::string(outputPath));
+		decoder.decode(output, format);
+	}
+
+	return 0;
+}
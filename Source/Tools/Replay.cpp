@@ -0,0 +1,64 @@
+// Copyright (c) 2023 Dhiraj Wishal
+
+#include "Backend/Platform.hpp"
+#include "Backend/Instance.hpp"
+#include "Backend/CaptureReplayer.hpp"
+
+#include "Core/FrameStatistics.hpp"
+
+#include <fstream>
+#include <iostream>
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		std::cerr << "Usage: GraphiteReplay <capture file> [--output <file>]" << std::endl;
+		return 1;
+	}
+
+	// Parse the arguments.
+	std::string_view outputPath;
+	for (int i = 2; i < argc; i++)
+	{
+		const auto argument = std::string_view(argv[i]);
+		if (argument == "--output" && i + 1 < argc)
+			outputPath = argv[++i];
+	}
+
+	// Create the device. The replay does not need a window.
+	auto platform = Platform();
+	auto instance = Instance();
+	instance.waitForDevice();
+
+	if (instance.getLogicalDevice().getUnsafe() == VK_NULL_HANDLE)
+	{
+		std::cerr << "No Vulkan device is available." << std::endl;
+		return 1;
+	}
+
+	auto statistics = FrameStatistics();
+	auto replayer = CaptureReplayer(instance, argv[1]);
+	if (!replayer.isValid())
+		return 1;
+
+	const auto bIsComplete = replayer.replay(statistics);
+
+	// Write the frame times of the whole capture.
+	const auto summary = statistics.computeSummary(FrameStatistics::HistorySize);
+	if (outputPath.empty())
+	{
+		FrameStatistics::WriteJSON(std::cout, summary);
+	}
+	else
+	{
+		auto output = std::ofstream(std::string(outputPath));
+		FrameStatistics::WriteJSON(output, summary);
+	}
+
+	std::cerr << "Replayed " << replayer.getRecordCount() << " records, skipped " << replayer.getSkippedCount() << "." << std::endl;
+	if (statistics.getFrameCount() > FrameStatistics::HistorySize)
+		std::cerr << "Only the last " << FrameStatistics::HistorySize << " frames are in the summary." << std::endl;
+
+	return bIsComplete ? 0 : 1;
+}